@@ -100,6 +100,7 @@ GetConsoleKeyboardLayoutNameW(
 #define CONSOLE_REGISTRY_DEFAULTFOREGROUND             L"DefaultForeground"
 #define CONSOLE_REGISTRY_DEFAULTBACKGROUND             L"DefaultBackground"
 #define CONSOLE_REGISTRY_TERMINALSCROLLING             L"TerminalScrolling"
+#define CONSOLE_REGISTRY_PERSISTHISTORY                L"PersistHistory"
 // end V2 console settings
 
     /*
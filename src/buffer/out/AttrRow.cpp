@@ -3,19 +3,24 @@
 
 #include "precomp.h"
 #include "AttrRow.hpp"
+#include "Row.hpp"
 
  // Routine Description:
  // - constructor
  // Arguments:
  // - cchRowWidth - the length of the default text attribute
  // - attr - the default text attribute
+ // - attributes - the table of the text buffer this row belongs to
  // Return Value:
  // - constructed object
  // Note: will throw exception if unable to allocate memory for text attribute storage
-ATTR_ROW::ATTR_ROW(const UINT cchRowWidth, const TextAttribute attr)
+ATTR_ROW::ATTR_ROW(const UINT cchRowWidth, const TextAttribute attr, TextAttributeTable& attributes) :
+    _cchRowWidth{ cchRowWidth },
+    _attributes{ &attributes },
+    _pParent{ nullptr }
 {
-    _list.push_back(TextAttributeRun(cchRowWidth, attr));
-    _cchRowWidth = cchRowWidth;
+    _attributes->Reserve(1);
+    _list.push_back({ gsl::narrow<uint16_t>(cchRowWidth), _attributes->Intern(attr) });
 }
 
 // Routine Description:
@@ -24,8 +29,11 @@ ATTR_ROW::ATTR_ROW(const UINT cchRowWidth, const TextAttribute attr)
 // - attr - The default text attributes to use on text in this row.
 void ATTR_ROW::Reset(const TextAttribute attr)
 {
+    _attributes->Reserve(1);
+    const _Run run{ gsl::narrow_cast<uint16_t>(_cchRowWidth), _attributes->Intern(attr) };
     _list.clear();
-    _list.push_back(TextAttributeRun(_cchRowWidth, attr));
+    _list.push_back(run);
+    _MarkChanged();
 }
 
 // Routine Description:
@@ -40,45 +48,27 @@ void ATTR_ROW::Reset(const TextAttribute attr)
 void ATTR_ROW::Resize(const size_t newWidth)
 {
     THROW_HR_IF(E_INVALIDARG, 0 == newWidth);
+    THROW_HR_IF(E_INVALIDARG, newWidth > std::numeric_limits<uint16_t>::max());
+    _MarkChanged();
 
-    // Easy case. If the new row is longer, increase the length of the last run by how much new space there is.
+    // Easy case. If the new row is longer, the last run just ends further right.
     if (newWidth > _cchRowWidth)
     {
-        // Get the attribute that covers the final column of old width.
-        const auto runPos = FindAttrIndex(_cchRowWidth - 1, nullptr);
-        auto& run = _list[runPos];
-
-        // Extend its length by the additional columns we're adding.
-        run.SetLength(run.GetLength() + newWidth - _cchRowWidth);
-
-        // Store that the new total width we represent is the new width.
-        _cchRowWidth = newWidth;
+        _list.back().end = gsl::narrow_cast<uint16_t>(newWidth);
     }
-    // harder case: new row is shorter.
+    // Otherwise the run covering the new last column becomes the last one.
     else
     {
-        // Get the attribute that covers the final column of the new width
-        size_t CountOfAttr = 0;
-        const auto runPos = FindAttrIndex(newWidth - 1, &CountOfAttr);
-        auto& run = _list[runPos];
-
-        // CountOfAttr was given to us as "how many columns left from this point forward are covered by the returned run"
-        // So if the original run was B5 covering a 5 size OldWidth and we have a NewWidth of 3
-        // then when we called FindAttrIndex, it returned the B5 as the pIndexedRun and a 2 for how many more segments it covers
-        // after and including the 3rd column.
-        // B5-2 = B3, which is what we desire to cover the new 3 size buffer.
-        run.SetLength(run.GetLength() - CountOfAttr + 1);
-
-        // Store that the new total width we represent is the new width.
-        _cchRowWidth = newWidth;
-
-        // Erase segments after the one we just updated.
-        _list.erase(_list.cbegin() + runPos + 1, _list.cend());
+        const auto runPos = FindAttrIndex(newWidth - 1, nullptr);
+        _list[runPos].end = gsl::narrow_cast<uint16_t>(newWidth);
 
-        // NOTE: Under some circumstances here, we have leftover run segments in memory or blank run segments
-        // in memory. We're not going to waste time redimensioning the array in the heap. We're just noting that the useful
-        // portions of it have changed.
+        // NOTE: We're not going to waste time redimensioning the array in the heap.
+        // The capacity left over is reused by the next inserts.
+        _list.erase(_list.cbegin() + runPos + 1, _list.cend());
     }
+
+    // Store that the new total width we represent is the new width.
+    _cchRowWidth = newWidth;
 }
 
 // Routine Description:
@@ -108,7 +98,7 @@ TextAttribute ATTR_ROW::GetAttrByColumn(const size_t column,
 {
     THROW_HR_IF(E_INVALIDARG, column >= _cchRowWidth);
     const auto runPos = FindAttrIndex(column, pApplies);
-    return _list[runPos].GetAttributes();
+    return _attributes->Get(_list[runPos].id);
 }
 
 // Routine Description:
@@ -121,55 +111,29 @@ size_t ATTR_ROW::GetNumberOfRuns() const noexcept
 }
 
 // Routine Description:
-// - This routine finds the nth attribute in this ATTR_ROW.
+// - This routine finds the nth attribute in this ATTR_ROW. Runs store the
+//   column they end at, so this is a binary search.
 // Arguments:
 // - index - which attribute to find
 // - applies - on output, contains corrected length of indexed attr.
 //             for example, if the attribute string was { 5, BLUE } and the requested
 //             index was 3, CountOfAttr would be 2.
 // Return Value:
-// - const reference to attribute run object
+// - the position of the run covering the index
 size_t ATTR_ROW::FindAttrIndex(const size_t index, size_t* const pApplies) const
 {
     FAIL_FAST_IF(!(index < _cchRowWidth)); // The requested index cannot be longer than the total length described by this set of Attrs.
 
-    size_t cTotalLength = 0;
-
-    FAIL_FAST_IF(!(_list.size() > 0)); // There should be a non-zero and positive number of items in the array.
-
-    // Scan through the internal array from position 0 adding up the lengths that each attribute applies to
-    auto runPos = _list.cbegin();
-    do
-    {
-        cTotalLength += runPos->GetLength();
-
-        if (cTotalLength > index)
-        {
-            // If we've just passed up the requested index with the length we added, break early
-            break;
-        }
-
-        runPos++;
-    } while (runPos < _list.cend());
-
-    // we should have broken before falling out the while case.
-    // if we didn't break, then this ATTR_ROW wasn't filled with enough attributes for the entire row of characters
-    FAIL_FAST_IF(runPos >= _list.cend());
+    const auto runPos = std::upper_bound(_list.cbegin(), _list.cend(), index, [](const size_t column, const _Run& run) {
+        return column < run.end;
+    });
 
-    // The remaining iterator position is the position of the attribute that is applicable at the position requested (index)
-    // Calculate its remaining applicability if requested
-
-    // The length on which the found attribute applies is the total length seen so far minus the index we were searching for.
-    FAIL_FAST_IF(!(cTotalLength > index)); // The length of all attributes we counted up so far should be longer than the index requested or we'll underflow.
+    // if we didn't find one, then this ATTR_ROW wasn't filled with enough attributes for the entire row of characters
+    FAIL_FAST_IF(runPos == _list.cend());
 
     if (nullptr != pApplies)
     {
-        const auto attrApplies = cTotalLength - index;
-        FAIL_FAST_IF(!(attrApplies > 0)); // An attribute applies for >0 characters
-        // MSFT: 17130145 - will restore this and add a better assert to catch the real issue.
-        //FAIL_FAST_IF(!(attrApplies <= _cchRowWidth)); // An attribute applies for a maximum of the total length available to us
-
-        *pApplies = attrApplies;
+        *pApplies = runPos->end - index;
     }
 
     return runPos - _list.cbegin();
@@ -190,341 +154,144 @@ bool ATTR_ROW::SetAttrToEnd(const UINT iStart, const TextAttribute attr)
     return SUCCEEDED(InsertAttrRuns({ &run, 1 }, iStart, _cchRowWidth - 1, _cchRowWidth));
 }
 
-// Routine Description:
-// - Replaces all runs in the row with the given wToBeReplacedAttr with the new
-//      attribute wReplaceWith. This method is used for replacing specifically
-//      legacy attributes.
-// Arguments:
-// - wToBeReplacedAttr - the legacy attribute to replace in this row.
-// - wReplaceWith - the new value for the matching runs' attributes.
-// Return Value:
-// <none>
-void ATTR_ROW::ReplaceLegacyAttrs(_In_ WORD wToBeReplacedAttr, _In_ WORD wReplaceWith) noexcept
-{
-    TextAttribute ToBeReplaced;
-    ToBeReplaced.SetFromLegacy(wToBeReplacedAttr);
-
-    TextAttribute ReplaceWith;
-    ReplaceWith.SetFromLegacy(wReplaceWith);
-
-    ReplaceAttrs(ToBeReplaced, ReplaceWith);
-}
-
-
-// Method Description:
-// - Replaces all runs in the row with the given toBeReplacedAttr with the new
-//      attribute replaceWith.
-// Arguments:
-// - toBeReplacedAttr - the attribute to replace in this row.
-// - replaceWith - the new value for the matching runs' attributes.
-// Return Value:
-// - <none>
-void ATTR_ROW::ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAttribute& replaceWith) noexcept
-{
-    for (auto& run : _list)
-    {
-        if (run.GetAttributes() == toBeReplacedAttr)
-        {
-            run.SetAttributes(replaceWith);
-        }
-    }
-}
-
-
 // Routine Description:
 // - Takes a array of attribute runs, and inserts them into this row from startIndex to endIndex.
 // - For example, if the current row was was [{4, BLUE}], the merge string
 //   was [{ 2, RED }], with (StartIndex, EndIndex) = (1, 2),
 //   then the row would modified to be = [{ 1, BLUE}, {2, RED}, {1, BLUE}].
 // Arguments:
-// - rgInsertAttrs - The array of attrRuns to merge into this row.
-// - cInsertAttrs - The number of elements in rgInsertAttrs
+// - newAttrs - The array of attrRuns to merge into this row. Their lengths
+//              have to add up to the number of columns from iStart to iEnd.
 // - iStart - The index in the row to place the array of runs.
 // - iEnd - the final index of the merge runs
-// - BufferWidth - the width of the row.
+// - cBufferWidth - the width of the row.
 // Return Value:
-// - STATUS_NO_MEMORY if there wasn't enough memory to insert the runs
-//   otherwise STATUS_SUCCESS if we were successful.
+// - S_OK if we were successful, E_INVALIDARG if the runs don't fit the
+//   given columns, or the failure from interning or allocating.
 [[nodiscard]]
 HRESULT ATTR_ROW::InsertAttrRuns(const std::basic_string_view<TextAttributeRun> newAttrs,
                                  const size_t iStart,
                                  const size_t iEnd,
                                  const size_t cBufferWidth)
 {
-    // Definitions:
-    // Existing Run = The run length encoded color array we're already storing in memory before this was called.
-    // Insert Run = The run length encoded color array that someone is asking us to inject into our stored memory run.
-    // New Run = The run length encoded color array that we have to allocate and rebuild to store internally
-    //           which will replace Existing Run at the end of this function.
-    // Example:
-    // cBufferWidth = 10.
-    // Existing Run: R3 -> G5 -> B2
-    // Insert Run: Y1 -> N1 at iStart = 5 and iEnd = 6
-    //            (rgInsertAttrs is a 2 length array with Y1->N1 in it and cInsertAttrs = 2)
-    // Final Run: R3 -> G2 -> Y1 -> N1 -> G1 -> B2
-
-    // We'll need to know what the last valid column is for some calculations versus iEnd
-    // because iEnd is specified to us as an inclusive index value.
-    // Do the -1 math here now so we don't have to have -1s scattered all over this function.
-    const size_t iLastBufferCol = cBufferWidth - 1;
-
-    // If the insertion size is 1, do some pre-processing to
-    // see if we can get this done quickly.
-    if (newAttrs.size() == 1)
+    RETURN_HR_IF(E_INVALIDARG, newAttrs.empty() || iStart > iEnd || iEnd >= std::min(cBufferWidth, _cchRowWidth));
+    _MarkChanged();
+
+    try
     {
-        // Get the new color attribute we're trying to apply
-        const TextAttribute NewAttr = newAttrs.at(0).GetAttributes();
+        _attributes->Reserve(newAttrs.size());
 
-        // If the existing run was only 1 element...
-        // ...and the new color is the same as the old, we don't have to do anything and can exit quick.
-        if (_list.size() == 1 && _list.at(0).GetAttributes() == NewAttr)
+        // Single runs are by far the most common, so don't allocate for them.
+        if (newAttrs.size() == 1)
         {
+            RETURN_HR_IF(E_INVALIDARG, newAttrs.front().GetLength() != iEnd - iStart + 1);
+            const _Run run{ gsl::narrow_cast<uint16_t>(iEnd + 1), _attributes->Intern(newAttrs.front().GetAttributes()) };
+            _SpliceRuns({ &run, 1 }, iStart, iEnd);
             return S_OK;
         }
-        // .. otherwise if we internally have a list of 2 and we're about to insert a single color
-        // it's probable that we're just walking left-to-right through the row and changing each
-        // cell one at a time.
-        // e.g.
-        // AAAAABBBBBBB
-        // AAAAAABBBBBB
-        // AAAAAAABBBBB
-        // Check for that circumstance by seeing if we're inserting a single run of the
-        // left side color right at the boundary and just adjust the counts in the existing
-        // two elements in our internal list.
-        else if (_list.size() == 2 && newAttrs.at(0).GetLength() == 1)
+
+        std::vector<_Run> runs;
+        runs.reserve(newAttrs.size());
+        size_t end = iStart;
+        for (const auto& newAttr : newAttrs)
         {
-            auto left = _list.begin();
-            if (iStart == left->GetLength() && NewAttr == left->GetAttributes())
-            {
-                auto right = left + 1;
-                left->IncrementLength();
-                right->DecrementLength();
-
-                // If we just reduced the right half to zero, just erase it out of the list.
-                if (right->GetLength() == 0)
-                {
-                    _list.erase(right);
-                }
-                return S_OK;
-            }
+            end += newAttr.GetLength();
+            RETURN_HR_IF(E_INVALIDARG, end > iEnd + 1);
+            runs.push_back({ gsl::narrow_cast<uint16_t>(end), _attributes->Intern(newAttr.GetAttributes()) });
         }
-    }
-
-    // If we're about to cover the entire existing run with a new one, we can also make an optimization.
-    if (iStart == 0 && iEnd == iLastBufferCol)
-    {
-        // Just dump what we're given over what we have and call it a day.
-        _list.assign(newAttrs.cbegin(), newAttrs.cend());
+        RETURN_HR_IF(E_INVALIDARG, end != iEnd + 1);
 
+        _SpliceRuns(runs, iStart, iEnd);
         return S_OK;
     }
+    CATCH_RETURN();
+}
 
-    // In the worst case scenario, we will need a new run that is the length of
-    // The existing run in memory + The new run in memory + 1.
-    // This worst case occurs when we inject a new item in the middle of an existing run like so
-    // Existing R3->B5->G2, Insertion Y2 starting at 5 (in the middle of the B5)
-    // becomes R3->B2->Y2->B1->G2.
-    // The original run was 3 long. The insertion run was 1 long. We need 1 more for the
-    // fact that an existing piece of the run was split in half (to hold the latter half).
-    const size_t cNewRun = _list.size() + newAttrs.size() + 1;
-    std::vector<TextAttributeRun> newRun;
-    newRun.resize(cNewRun);
-
-    // We will start analyzing from the beginning of our existing run.
-    // Use some pointers to keep track of where we are in walking through our runs.
-
-    // Get the existing run that we'll be updating/manipulating.
-    const auto existingRun = _list.begin();
-    auto pExistingRunPos = existingRun;
-    const auto pExistingRunEnd = existingRun + _list.size();
-    auto pInsertRunPos = newAttrs.begin();
-    size_t cInsertRunRemaining = newAttrs.size();
-    auto pNewRunPos = newRun.begin();
-    size_t iExistingRunCoverage = 0;
-
-    // Copy the existing run into the new buffer up to the "start index" where the new run will be injected.
-    // If the new run starts at 0, we have nothing to copy from the beginning.
-    if (iStart != 0)
+// Routine Description:
+// - Replaces the runs covering the columns from iStart to iEnd with the given
+//   ones, in place. Only the runs at the edges of the range are looked at;
+//   the ones outside of it keep their end columns and aren't touched at all.
+// - Runs with the same id next to each other are merged, so the result is
+//   as short as it can be. A run that's merged away is always the left one,
+//   since the right one's end already covers both.
+// - For example, with existing runs R3 -> G5 -> B2 and an insertion of Y2 at
+//   columns 5 and 6, G5 is cut into a prefix G2 in front of the insertion and
+//   a suffix G1 behind it: R3 -> G2 -> Y2 -> G1 -> B2.
+// Arguments:
+// - newRuns - The interned runs to insert. Their ends are columns in this
+//             row, and the last one ends at iEnd + 1.
+// - iStart - The first column to replace.
+// - iEnd - The last column to replace.
+void ATTR_ROW::_SpliceRuns(const gsl::span<const _Run> newRuns,
+                           const size_t iStart,
+                           const size_t iEnd)
+{
+    // The first and the last run that the insertion (partially) covers.
+    const auto first = FindAttrIndex(iStart, nullptr);
+    const auto last = FindAttrIndex(iEnd, nullptr);
+
+    // Whatever is left of the first run in front of the insertion survives
+    // as a prefix, and whatever is left of the last run behind it stays as
+    // it is. The last run already ends in the right place.
+    const size_t firstStart = first > 0 ? _list[first - 1].end : 0;
+    const auto firstId = _list[first].id;
+    bool keepPrefix = firstStart < iStart;
+    const bool keepLast = _list[last].end > iEnd + 1;
+
+    // Merge the insertion into whatever ends up on its left...
+    auto eraseBegin = first;
+    if (keepPrefix)
     {
-        // While we're less than the desired insertion position...
-        while (iExistingRunCoverage < iStart)
-        {
-            // Add up how much length we can cover by copying an item from the existing run.
-            iExistingRunCoverage += pExistingRunPos->GetLength();
-
-            // Copy it to the new run buffer and advance both pointers.
-            *pNewRunPos++ = *pExistingRunPos++;
-        }
-
-        // When we get to this point, we've copied full segments from the original existing run
-        // into our new run buffer. We will have 1 or more full segments of color attributes and
-        // we MIGHT have to cut the last copied segment's length back depending on where the inserted
-        // attributes will fall in the final/new run.
-        // Some examples:
-        // - Starting with the original string R3 -> G5 -> B2
-        // - 1. If the insertion is Y5 at start index 3
-        //      We are trying to get a result/final/new run of R3 -> Y5 -> B2.
-        //      We just copied R3 to the new destination buffer and we cang skip down and start inserting the new attrs.
-        // - 2. If the insertion is Y3 at start index 5
-        //      We are trying to get a result/final/new run of R3 -> G2 -> Y3 -> B2.
-        //      We just copied R3 -> G5 to the new destination buffer with the code above.
-        //      But the insertion is going to cut out some of the length of the G5.
-        //      We need to fix this up below so it says G2 instead to leave room for the Y3 to fit in
-        //      the new/final run.
-
-        // Copying above advanced the pointer to an empty cell beyond what we copied.
-        // Back up one cell so we can manipulate the final item we copied from the existing run to the new run.
-        pNewRunPos--;
-
-        // Fetch out the length so we can fix it up based on the below conditions.
-        size_t length = pNewRunPos->GetLength();
-
-        // If we've covered more cells already than the start of the attributes to be inserted...
-        if (iExistingRunCoverage > iStart)
-        {
-            // ..then subtract some of the length of the final cell we copied.
-            // We want to take remove the difference in distance between the cells we've covered in the new
-            // run and the insertion point.
-            // (This turns G5 into G2 from Example 2 just above)
-            length -= (iExistingRunCoverage - iStart);
-        }
-
-        // Now we're still on that "last cell copied" into the new run.
-        // If the color of that existing copied cell matches the color of the first segment
-        // of the run we're about to insert, we can just increment the length to extend the coverage.
-        if (pNewRunPos->GetAttributes() == pInsertRunPos->GetAttributes())
-        {
-            length += pInsertRunPos->GetLength();
-
-            // Since the color matched, we have already "used up" part of the insert run
-            // and can skip it in our big "memcopy" step below that will copy the bulk of the insert run.
-            cInsertRunRemaining--;
-            pInsertRunPos++;
-        }
-
-        // We're done manipulating the length. Store it back.
-        pNewRunPos->SetLength(length);
-
-        // Now that we're done adjusting the last copied item, advance the pointer into a fresh/blank
-        // part of the new run array.
-        pNewRunPos++;
+        keepPrefix = firstId != newRuns[0].id;
+    }
+    else if (first > 0 && _list[first - 1].id == newRuns[0].id)
+    {
+        --eraseBegin;
     }
 
-    // Bulk copy the majority (or all, depending on circumstance) of the insert run into the final run buffer.
-    std::copy_n(pInsertRunPos, cInsertRunRemaining, pNewRunPos);
-
-    // Advance the new run pointer into the position just after everything we copied.
-    pNewRunPos += cInsertRunRemaining;
-
-    // We're technically done with the insert run now and have 0 remaining, but won't bother updating its pointers
-    // and counts any further because we won't use them.
+    // ...and into whatever ends up on its right.
+    const auto rightId = keepLast ? _list[last].id : (last + 1 < _list.size() ? _list[last + 1].id : std::optional<TextAttributeTable::Id>{});
+    const auto keepRun = [&](const size_t i) {
+        const auto nextId = i + 1 < newRuns.size() ? newRuns[i + 1].id : rightId;
+        return nextId != newRuns[i].id;
+    };
 
-    // Now we need to move our pointer for the original existing run forward and update our counts
-    // on how many cells we could have copied from the source before finishing off the new run.
-    while (iExistingRunCoverage <= iEnd)
+    size_t count = (keepPrefix ? 1 : 0) + (keepLast ? 1 : 0);
+    for (size_t i = 0; i < newRuns.size(); ++i)
     {
-        FAIL_FAST_IF(!(pExistingRunPos != pExistingRunEnd));
-        iExistingRunCoverage += pExistingRunPos->GetLength();
-        pExistingRunPos++;
+        count += keepRun(i) ? 1 : 0;
     }
 
-    // If we still have original existing run cells remaining, copy them into the final new run.
-    if (pExistingRunPos != pExistingRunEnd || iExistingRunCoverage != (iEnd + 1))
+    // Open up or close the gap between the runs to the left and right of
+    // the replaced ones, then fill it in.
+    const auto lastRun = _list[last];
+    const auto eraseEnd = last + 1;
+    const auto replaced = eraseEnd - eraseBegin;
+    if (count > replaced)
     {
-        // Back up one cell so we can inspect the most recent item copied into the new run for optimizations.
-        pNewRunPos--;
-
-        // We advanced the existing run pointer and its count to on or past the end of what the insertion run filled in.
-        // If this ended up being past the end of what the insertion run covers, we have to account for the cells after
-        // the insertion run but before the next piece of the original existing run.
-        // The example in this case is if we had...
-        // Existing Run = R3 -> G5 -> B2 -> X5
-        // Insert Run = Y2 @ iStart = 7 and iEnd = 8
-        // ... then at this point in time, our states would look like...
-        // New Run so far = R3 -> G4 -> Y2
-        // Existing Run Pointer is at X5
-        // Existing run coverage count at 3 + 5 + 2 = 10.
-        // However, in order to get the final desired New Run
-        //   (which is R3 -> G4 -> Y2 -> B1 -> X5)
-        //   we would need to grab a piece of that B2 we already skipped past.
-        // iExistingRunCoverage = 10. iEnd = 8. iEnd+1 = 9. 10 > 9. So we skipped something.
-        if (iExistingRunCoverage > (iEnd + 1))
-        {
-            // Back up the existing run pointer so we can grab the piece we skipped.
-            pExistingRunPos--;
-
-            // If the color matches what's already in our run, just increment the count value.
-            // This case is slightly off from the example above. This case is for if the B2 above was actually Y2.
-            // That Y2 from the existing run is the same color as the Y2 we just filled a few columns left in the final run
-            // so we can just adjust the final run's column count instead of adding another segment here.
-            if (pNewRunPos->GetAttributes() == pExistingRunPos->GetAttributes())
-            {
-                size_t length = pNewRunPos->GetLength();
-                length += (iExistingRunCoverage - (iEnd + 1));
-                pNewRunPos->SetLength(length);
-            }
-            else
-            {
-                // If the color didn't match, then we just need to copy the piece we skipped and adjust
-                // its length for the discrepency in columns not yet covered by the final/new run.
-
-                // Move forward to a blank spot in the new run
-                pNewRunPos++;
-
-                // Copy the existing run's color information to the new run
-                pNewRunPos->SetAttributes(pExistingRunPos->GetAttributes());
-
-                // Adjust the length of that copied color to cover only the reduced number of columns needed
-                // now that some have been replaced by the insert run.
-                pNewRunPos->SetLength(iExistingRunCoverage - (iEnd + 1));
-            }
-
-            // Now that we're done recovering a piece of the existing run we skipped, move the pointer forward again.
-            pExistingRunPos++;
-        }
-
-        // OK. In this case, we didn't skip anything. The end of the insert run fell right at a boundary
-        // in columns that was in the original existing run.
-        // However, the next piece of the original existing run might happen to have the same color attribute
-        // as the final piece of what we just copied.
-        // As an example...
-        // Existing Run = R3 -> G5 -> B2.
-        // Insert Run = B5 @ iStart = 3 and iEnd = 7
-        // New Run so far = R3 -> B5
-        // New Run desired when done = R3 -> B7
-        // Existing run pointer is on B2.
-        // We want to merge the 2 from the B2 into the B5 so we get B7.
-        else if (pNewRunPos->GetAttributes() == pExistingRunPos->GetAttributes())
-        {
-            // Add the value from the existing run into the current new run position.
-            size_t length = pNewRunPos->GetLength();
-            length += pExistingRunPos->GetLength();
-            pNewRunPos->SetLength(length);
-
-            // Advance the existing run position since we consumed its value and merged it in.
-            pExistingRunPos++;
-        }
-
-        // OK. We're done inspecting the most recently copied cell for optimizations.
-        pNewRunPos++;
+        _list.insert(_list.cbegin() + eraseEnd, count - replaced, _Run{});
+    }
+    else if (count < replaced)
+    {
+        _list.erase(_list.cbegin() + eraseBegin + count, _list.cbegin() + eraseEnd);
+    }
 
-        // Now bulk copy any segments left in the original existing run
-        if (pExistingRunPos < pExistingRunEnd)
+    auto pos = _list.begin() + eraseBegin;
+    if (keepPrefix)
+    {
+        *pos++ = { gsl::narrow_cast<uint16_t>(iStart), firstId };
+    }
+    for (size_t i = 0; i < newRuns.size(); ++i)
+    {
+        if (keepRun(i))
         {
-            std::copy_n(pExistingRunPos, (pExistingRunEnd - pExistingRunPos), pNewRunPos);
-
-            // Fix up the end pointer so we know where we are for counting how much of the new run's memory space we used.
-            pNewRunPos += (pExistingRunEnd - pExistingRunPos);
+            *pos++ = newRuns[i];
         }
     }
-
-    // OK, phew. We're done. Now we just need to free the existing run, store the new run in its place,
-    // and update the count for the correct length of the new run now that we've filled it up.
-
-    newRun.erase(pNewRunPos, newRun.end());
-    _list.swap(newRun);
-
-    return S_OK;
+    if (keepLast)
+    {
+        *pos++ = lastRun;
+    }
 }
 
 // Routine Description:
@@ -555,6 +322,40 @@ std::vector<TextAttributeRun> ATTR_ROW::PackAttrs(const std::vector<TextAttribut
     return runs;
 }
 
+// Routine Description:
+// - Marks the ids of the attributes this row uses, so the table can reclaim
+//   the rest.
+// Arguments:
+// - live - one bit per id in the table, set for every id still in use
+void ATTR_ROW::MarkLiveAttributes(std::vector<bool>& live) const
+{
+    for (const auto& run : _list)
+    {
+        live[run.id] = true;
+    }
+}
+
+// Routine Description:
+// - Updates the pointer to the row this belongs to (which might change if the
+//   rows are shuffled around). Changes to the attributes count as changes to it.
+// Arguments:
+// - pParent - Pointer to the parent row
+void ATTR_ROW::UpdateParent(ROW* const pParent) noexcept
+{
+    _pParent = pParent;
+}
+
+// Routine Description:
+// - Records a change to the attributes on the row they belong to, if any.
+//   See ROW::GetGeneration.
+void ATTR_ROW::_MarkChanged() noexcept
+{
+    if (_pParent)
+    {
+        _pParent->_MarkChanged();
+    }
+}
+
 ATTR_ROW::const_iterator ATTR_ROW::begin() const noexcept
 {
     return AttrRowIterator(this);
@@ -21,14 +21,17 @@ Revision History:
 #pragma once
 
 #include "TextAttributeRun.hpp"
+#include "TextAttributeTable.hpp"
 #include "AttrRowIterator.hpp"
 
+class ROW;
+
 class ATTR_ROW final
 {
 public:
     using const_iterator = typename AttrRowIterator;
 
-    ATTR_ROW(const UINT cchRowWidth, const TextAttribute attr);
+    ATTR_ROW(const UINT cchRowWidth, const TextAttribute attr, TextAttributeTable& attributes);
 
     void Reset(const TextAttribute attr);
 
@@ -42,8 +45,6 @@ public:
                          size_t* const pApplies) const;
 
     bool SetAttrToEnd(const UINT iStart, const TextAttribute attr);
-    void ReplaceLegacyAttrs(const WORD wToBeReplacedAttr, const WORD wReplaceWith) noexcept;
-    void ReplaceAttrs(const TextAttribute& toBeReplacedAttr, const TextAttribute& replaceWith) noexcept;
 
     void Resize(const size_t newWidth);
 
@@ -55,6 +56,10 @@ public:
 
     static std::vector<TextAttributeRun> PackAttrs(const std::vector<TextAttribute>& attrs);
 
+    void MarkLiveAttributes(std::vector<bool>& live) const;
+
+    void UpdateParent(ROW* const pParent) noexcept;
+
     const_iterator begin() const noexcept;
     const_iterator end() const noexcept;
 
@@ -65,9 +70,28 @@ public:
     friend class AttrRowIterator;
 
 private:
-
-    std::vector<TextAttributeRun> _list;
+    // A TextAttributeRun as it's stored: the attribute lives in the buffer's
+    // table and the run only keeps its id. Instead of its length, the run
+    // keeps the column it ends at (exclusive), so finding the run covering a
+    // column is a binary search and editing some runs never has to touch the
+    // ones after them. Rows are never wider than a SHORT.
+    struct _Run
+    {
+        uint16_t end;
+        TextAttributeTable::Id id;
+    };
+    static_assert(sizeof(_Run) == 8, "A run should only take 8B. Row memory is dominated by these.");
+
+    void _SpliceRuns(const gsl::span<const _Run> newRuns,
+                     const size_t iStart,
+                     const size_t iEnd);
+
+    std::vector<_Run> _list;
     size_t _cchRowWidth;
+    TextAttributeTable* _attributes; // non ownership pointer
+    ROW* _pParent; // non ownership pointer. Rows on their own have none.
+
+    void _MarkChanged() noexcept;
 
 #ifdef UNIT_TESTING
     friend class AttrRowTests;
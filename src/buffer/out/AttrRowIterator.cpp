@@ -15,21 +15,21 @@ AttrRowIterator AttrRowIterator::CreateEndIterator(const ATTR_ROW* const attrRow
 
 AttrRowIterator::AttrRowIterator(const ATTR_ROW* const attrRow) :
     _pAttrRow{ attrRow },
-    _run{ attrRow->_list.cbegin() },
-    _currentAttributeIndex{ 0 }
+    _run{ 0 },
+    _column{ 0 }
 {
 }
 
 AttrRowIterator::operator bool() const noexcept
 {
-    return _run < _pAttrRow->_list.cend();
+    return _run < _pAttrRow->_list.size();
 }
 
 bool AttrRowIterator::operator==(const AttrRowIterator& it) const
 {
     return (_pAttrRow == it._pAttrRow &&
             _run == it._run &&
-            _currentAttributeIndex == it._currentAttributeIndex);
+            _column == it._column);
 }
 
 bool AttrRowIterator::operator!=(const AttrRowIterator& it) const
@@ -84,33 +84,44 @@ AttrRowIterator AttrRowIterator::operator--(int)
 
 const TextAttribute* AttrRowIterator::operator->() const
 {
-    return &_run->GetAttributes();
+    return &_pAttrRow->_attributes->Get(GetAttrId());
 }
 
 const TextAttribute& AttrRowIterator::operator*() const
 {
-    return _run->GetAttributes();
+    return _pAttrRow->_attributes->Get(GetAttrId());
 }
 
 // Routine Description:
-// - increments the index the iterator points to
+// - returns the id the current attribute has in the buffer's attribute table.
+//   Two cells of the same buffer with the same id have the same attribute.
+TextAttributeTable::Id AttrRowIterator::GetAttrId() const
+{
+    return _pAttrRow->_list.at(_run).id;
+}
+
+// Routine Description:
+// - increments the index the iterator points to. Stepping to the next run is
+//   O(1); jumping over several runs is a binary search.
 // Arguments:
 // - count - the amount to increment by
 void AttrRowIterator::_increment(size_t count)
 {
-    while (count > 0)
+    const auto& list = _pAttrRow->_list;
+    _column += count;
+    if (_column >= _pAttrRow->_cchRowWidth)
+    {
+        _setToEnd();
+    }
+    else if (_column >= list.at(_run).end)
     {
-        const size_t runLength = _run->GetLength();
-        if (count + _currentAttributeIndex < runLength)
+        if (_column < list.at(_run + 1).end)
         {
-            _currentAttributeIndex += count;
-            return;
+            ++_run;
         }
         else
         {
-            count -= runLength - _currentAttributeIndex;
-            ++_run;
-            _currentAttributeIndex = 0;
+            _run = _pAttrRow->FindAttrIndex(_column, nullptr);
         }
     }
 }
@@ -121,19 +132,20 @@ void AttrRowIterator::_increment(size_t count)
 // - count - the amount to decrement by
 void AttrRowIterator::_decrement(size_t count)
 {
-    while (count > 0)
+    const auto& list = _pAttrRow->_list;
+    _column -= count;
+    if (_run == 0 || _column >= list.at(_run - 1).end)
     {
-        if (count <= _currentAttributeIndex)
-        {
-            _currentAttributeIndex -= count;
-            return;
-        }
-        else
-        {
-            count -= _currentAttributeIndex;
-            --_run;
-            _currentAttributeIndex = _run->GetLength() - 1;
-        }
+        return;
+    }
+
+    if (_run == 1 || _column >= list.at(_run - 2).end)
+    {
+        --_run;
+    }
+    else
+    {
+        _run = _pAttrRow->FindAttrIndex(_column, nullptr);
     }
 }
 
@@ -141,6 +153,6 @@ void AttrRowIterator::_decrement(size_t count)
 // - sets fields on the iterator to describe the end() state of the ATTR_ROW
 void AttrRowIterator::_setToEnd()
 {
-    _run = _pAttrRow->_list.cend();
-    _currentAttributeIndex = 0;
+    _run = _pAttrRow->_list.size();
+    _column = _pAttrRow->_cchRowWidth;
 }
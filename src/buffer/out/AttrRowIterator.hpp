@@ -17,7 +17,7 @@ Author(s):
 #pragma once
 
 #include "TextAttribute.hpp"
-#include "TextAttributeRun.hpp"
+#include "TextAttributeTable.hpp"
 
 class ATTR_ROW;
 
@@ -51,11 +51,13 @@ public:
     const TextAttribute* operator->() const;
     const TextAttribute& operator*() const;
 
+    TextAttributeTable::Id GetAttrId() const;
+
 private:
-    std::vector<TextAttributeRun>::const_iterator _run;
+    size_t _run; // index of the current run within the ATTR_ROW
     const ATTR_ROW* _pAttrRow;
-    size_t _currentAttributeIndex; // index of TextAttribute within the current TextAttributeRun
-    
+    size_t _column; // column within the ATTR_ROW
+
     void _increment(size_t count);
     void _decrement(size_t count);
     void _setToEnd();
@@ -32,6 +32,7 @@ CharRow::CharRow(size_t rowWidth, ROW* const pParent) :
 void CharRow::SetWrapForced(const bool wrapForced) noexcept
 {
     _wrapForced = wrapForced;
+    _MarkChanged();
 }
 
 // Routine Description:
@@ -54,6 +55,7 @@ bool CharRow::WasWrapForced() const noexcept
 void CharRow::SetDoubleBytePadded(const bool doubleBytePadded) noexcept
 {
     _doubleBytePadded = doubleBytePadded;
+    _MarkChanged();
 }
 
 // Routine Description:
@@ -93,6 +95,7 @@ void CharRow::Reset()
 
     _wrapForced = false;
     _doubleBytePadded = false;
+    _MarkChanged();
 }
 
 // Routine Description:
@@ -104,6 +107,7 @@ void CharRow::Reset()
 [[nodiscard]]
 HRESULT CharRow::Resize(const size_t newSize) noexcept
 {
+    _MarkChanged();
     try
     {
         const value_type insertVals;
@@ -114,8 +118,12 @@ HRESULT CharRow::Resize(const size_t newSize) noexcept
     return S_OK;
 }
 
+// Routine Description:
+// - gets an iterator for changing the cells of the row, which counts as a
+//   change to it. Reading them goes through cbegin.
 typename CharRow::iterator CharRow::begin() noexcept
 {
+    _MarkChanged();
     return _data.begin();
 }
 
@@ -169,6 +177,7 @@ size_t CharRow::MeasureRight() const noexcept
 void CharRow::ClearCell(const size_t column)
 {
     _data.at(column).Reset();
+    _MarkChanged();
 }
 
 // Routine Description:
@@ -202,7 +211,8 @@ const DbcsAttribute& CharRow::DbcsAttrAt(const size_t column) const
 }
 
 // Routine Description:
-// - gets the attribute at the specified column
+// - gets the attribute at the specified column for changing it, which counts
+//   as a change to the row
 // Arguments:
 // - column - the column to get the attribute for
 // Return Value:
@@ -210,6 +220,7 @@ const DbcsAttribute& CharRow::DbcsAttrAt(const size_t column) const
 // Note: will throw exception if column is out of bounds
 DbcsAttribute& CharRow::DbcsAttrAt(const size_t column)
 {
+    _MarkChanged();
     return const_cast<DbcsAttribute&>(static_cast<const CharRow* const>(this)->DbcsAttrAt(column));
 }
 
@@ -223,6 +234,7 @@ DbcsAttribute& CharRow::DbcsAttrAt(const size_t column)
 void CharRow::ClearGlyph(const size_t column)
 {
     _data.at(column).EraseChars();
+    _MarkChanged();
 }
 
 // Routine Description:
@@ -322,3 +334,10 @@ void CharRow::UpdateParent(ROW* const pParent) noexcept
 {
     _pParent = FAIL_FAST_IF_NULL(pParent);
 }
+
+// Routine Description:
+// - Records a change to the characters on the row they belong to. See ROW::GetGeneration.
+void CharRow::_MarkChanged() noexcept
+{
+    _pParent->_MarkChanged();
+}
@@ -100,6 +100,8 @@ protected:
 
     // ROW that this CharRow belongs to
     ROW* _pParent;
+
+    void _MarkChanged() noexcept;
 };
 
 constexpr bool operator==(const CharRow& a, const CharRow& b) noexcept
@@ -25,6 +25,7 @@ void CharRowCellReference::operator=(const std::wstring_view chars)
         storage.StoreGlyph(key, { chars.cbegin(), chars.cend() });
         _cellData().DbcsAttr().SetGlyphStored(true);
     }
+    _parent._MarkChanged();
 }
 
 // Routine Description:
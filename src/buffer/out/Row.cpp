@@ -6,6 +6,9 @@
 #include "CharRow.hpp"
 #include "textBuffer.hpp"
 #include "../types/inc/convert.hpp"
+#include "../types/inc/Metrics.hpp"
+
+using namespace Microsoft::Console::Types;
 
 // Routine Description:
 // - constructor
@@ -20,9 +23,11 @@ ROW::ROW(const SHORT rowId, const short rowWidth, const TextAttribute fillAttrib
     _id{ rowId },
     _rowWidth{ gsl::narrow<size_t>(rowWidth) },
     _charRow{ gsl::narrow<size_t>(rowWidth), this },
-    _attrRow{ gsl::narrow<UINT>(rowWidth), fillAttribute },
-    _pParent{ pParent }
+    _attrRow{ gsl::narrow<UINT>(rowWidth), fillAttribute, pParent->GetAttributeTable() },
+    _pParent{ pParent },
+    _generation{ pParent->_NextGeneration() }
 {
+    _attrRow.UpdateParent(this);
 }
 
 size_t ROW::size() const noexcept
@@ -60,6 +65,53 @@ void ROW::SetId(const SHORT id) noexcept
     _id = id;
 }
 
+// Routine Description:
+// - gets the generation of the parent buffer that this row last changed in.
+//   A row whose generation is greater than one seen before has changed since.
+//   Everything that changes the row's characters or attributes, directly or
+//   through GetCharRow and GetAttrRow, records it. The generation stays with
+//   the row when it moves up as the buffer scrolls.
+// - Recoloring attributes and reflowing the buffer change many rows at once,
+//   and are only recorded by the buffer. See TextBuffer::GetRowsChangedSince.
+// Return Value:
+// - the generation of the row's last change
+uint64_t ROW::GetGeneration() const noexcept
+{
+    return _generation;
+}
+
+// Routine Description:
+// - hashes what the row shows: its text, where its colors change and to what,
+//   and whether it wrapped. Rows that look the same hash the same, so this
+//   tells apart a row that changed from one that was rewritten as it was.
+// - The hash isn't kept up to date as the row changes; it's computed when
+//   asked for. Callers that want to reuse it should keep it along with the
+//   generation it was computed at.
+// Return Value:
+// - the hash of the row's contents
+size_t ROW::GetHash() const
+{
+    // Mixes values in the way boost::hash_combine does.
+    const auto combine = [](const size_t seed, const size_t value) noexcept {
+        return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+    };
+
+    size_t hash = std::hash<std::wstring>{}(_charRow.GetText());
+    hash = combine(hash, _charRow.WasWrapForced());
+
+    const std::hash<TextAttribute> hashAttr;
+    for (size_t column = 0; column < _rowWidth;)
+    {
+        size_t applies = 0;
+        const auto attr = _attrRow.GetAttrByColumn(column, &applies);
+        hash = combine(hash, column);
+        hash = combine(hash, hashAttr(attr));
+        column += std::max<size_t>(applies, 1);
+    }
+
+    return hash;
+}
+
 // Routine Description:
 // - Sets all properties of the ROW to default values
 // Arguments:
@@ -68,6 +120,7 @@ void ROW::SetId(const SHORT id) noexcept
 // - <none>
 bool ROW::Reset(const TextAttribute Attr)
 {
+    _MarkChanged();
     _charRow.Reset();
     try
     {
@@ -90,6 +143,7 @@ bool ROW::Reset(const TextAttribute Attr)
 [[nodiscard]]
 HRESULT ROW::Resize(const size_t width)
 {
+    _MarkChanged();
     RETURN_IF_FAILED(_charRow.Resize(width));
     try
     {
@@ -111,6 +165,7 @@ HRESULT ROW::Resize(const size_t width)
 void ROW::ClearColumn(const size_t column)
 {
     THROW_HR_IF(E_INVALIDARG, column >= _charRow.size());
+    _MarkChanged();
     _charRow.ClearCell(column);
 }
 
@@ -156,6 +211,7 @@ OutputCellIterator ROW::WriteCells(OutputCellIterator it, const size_t index, co
 {
     THROW_HR_IF(E_INVALIDARG, index >= _charRow.size());
     THROW_HR_IF(E_INVALIDARG, limitRight.value_or(0) >= _charRow.size()); 
+    _MarkChanged();
     size_t currentIndex = index;
 
     // If we're given a right-side column limit, use it. Otherwise, the write limit is the final column index available in the char row.
@@ -218,5 +274,142 @@ OutputCellIterator ROW::WriteCells(OutputCellIterator it, const size_t index, co
         ++currentIndex;
     }
 
+    Metrics::Add(Metrics::Counter::CellsWritten, currentIndex - index);
     return it;
 }
+
+// Routine Description:
+// - writes a run of text in a single color to the row. Every character in the
+//   text must take exactly one cell on its own (no surrogates, nothing full
+//   width), so it can be stored without going through an OutputCellIterator.
+// Arguments:
+// - text - the characters to write
+// - index - column in row to start writing at
+// - attr - the color for every written cell
+// - setWrap - set the wrap flag if the write fills the last column of the row.
+// Return Value:
+// - the number of cells written. Text past the end of the row is dropped.
+size_t ROW::WriteNarrowText(const std::wstring_view text, const size_t index, const TextAttribute& attr, const bool setWrap)
+{
+    THROW_HR_IF(E_INVALIDARG, index >= _charRow.size());
+
+    const auto count = std::min(text.size(), _charRow.size() - index);
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    _MarkChanged();
+
+    const TextAttributeRun attrRun{ count, attr };
+    LOG_IF_FAILED(_attrRow.InsertAttrRuns({ &attrRun, 1 },
+                                          index,
+                                          index + count - 1,
+                                          _charRow.size()));
+
+    std::transform(text.cbegin(),
+                   text.cbegin() + count,
+                   _charRow.begin() + index,
+                   [](const wchar_t wch) { return CharRowCell{ wch, DbcsAttribute{} }; });
+
+    if (setWrap && index + count == _charRow.size())
+    {
+        _charRow.SetWrapForced(true);
+    }
+
+    Metrics::Add(Metrics::Counter::CellsWritten, count);
+    return count;
+}
+
+// Routine Description:
+// - writes legacy CHAR_INFO cells to the row. This stores the same thing
+//   WriteCells does for an OutputCellIterator over the cells, but copies them
+//   straight into the row and sets the colors one run at a time.
+// Arguments:
+// - cells - the cells to write. Leading/trailing byte flags are honored.
+// - index - column in row to start writing at
+// - setWrap - set the wrap flag if we fill the last column of the row.
+// - written - on output, the number of columns written to
+// Return Value:
+// - the number of cells consumed. A leading byte that would land in the last
+//   column is padded out instead and left unconsumed, as with WriteCells.
+size_t ROW::WriteCharInfos(const std::basic_string_view<CHAR_INFO> cells, const size_t index, const bool setWrap, size_t& written)
+{
+    THROW_HR_IF(E_INVALIDARG, index >= _charRow.size());
+    _MarkChanged();
+
+    const auto width = _charRow.size();
+    std::vector<TextAttributeRun> runs;
+    WORD runLegacyAttr = 0;
+
+    size_t consumed = 0;
+    size_t column = index;
+    for (; consumed < cells.size() && column < width; ++column)
+    {
+        const auto& charInfo = cells[consumed];
+
+        // Every column gets the color of the cell being written to it, even if it ends up padded.
+        if (!runs.empty() && charInfo.Attributes == runLegacyAttr)
+        {
+            runs.back().SetLength(runs.back().GetLength() + 1);
+        }
+        else
+        {
+            TextAttribute attr;
+            attr.SetFromLegacy(charInfo.Attributes);
+            runs.emplace_back(1, attr);
+            runLegacyAttr = charInfo.Attributes;
+        }
+
+        DbcsAttribute dbcsAttr;
+        if (WI_IsFlagSet(charInfo.Attributes, COMMON_LVB_LEADING_BYTE))
+        {
+            dbcsAttr.SetLeading();
+        }
+        else if (WI_IsFlagSet(charInfo.Attributes, COMMON_LVB_TRAILING_BYTE))
+        {
+            dbcsAttr.SetTrailing();
+        }
+
+        // A trailing byte in the first column and a leading byte in the last one
+        // are padded out. Only the first one gets another try in the next column.
+        if (column == 0 && dbcsAttr.IsTrailing())
+        {
+            _charRow.ClearCell(column);
+        }
+        else if (column == width - 1 && dbcsAttr.IsLeading())
+        {
+            _charRow.ClearCell(column);
+            _charRow.SetDoubleBytePadded(true);
+        }
+        else
+        {
+            *(_charRow.begin() + column) = CharRowCell{ charInfo.Char.UnicodeChar, dbcsAttr };
+            ++consumed;
+        }
+
+        if (setWrap && column == width - 1)
+        {
+            _charRow.SetWrapForced(true);
+        }
+    }
+
+    written = column - index;
+    Metrics::Add(Metrics::Counter::CellsWritten, written);
+    if (written > 0)
+    {
+        LOG_IF_FAILED(_attrRow.InsertAttrRuns({ runs.data(), runs.size() },
+                                              index,
+                                              column - 1,
+                                              width));
+    }
+
+    return consumed;
+}
+
+// Routine Description:
+// - records that the row just changed by giving it the next generation of its buffer.
+void ROW::_MarkChanged() noexcept
+{
+    _generation = _pParent->_NextGeneration();
+}
@@ -45,6 +45,9 @@ public:
     SHORT GetId() const noexcept;
     void SetId(const SHORT id) noexcept;
 
+    uint64_t GetGeneration() const noexcept;
+    size_t GetHash() const;
+
     bool Reset(const TextAttribute Attr);
     [[nodiscard]]
     HRESULT Resize(const size_t width);
@@ -59,6 +62,8 @@ public:
     const UnicodeStorage& GetUnicodeStorage() const;
 
     OutputCellIterator WriteCells(OutputCellIterator it, const size_t index, const bool setWrap, std::optional<size_t> limitRight = std::nullopt);
+    size_t WriteNarrowText(const std::wstring_view text, const size_t index, const TextAttribute& attr, const bool setWrap);
+    size_t WriteCharInfos(const std::basic_string_view<CHAR_INFO> cells, const size_t index, const bool setWrap, size_t& written);
 
     friend bool operator==(const ROW& a, const ROW& b) noexcept;
 
@@ -66,12 +71,23 @@ public:
     friend class RowTests;
 #endif
 
+    // CharRow and ATTR_ROW record changes made through GetCharRow and
+    // GetAttrRow, and TextBuffer records rows moving to other offsets.
+    friend class CharRow;
+    friend class ATTR_ROW;
+    friend class TextBuffer;
+
 private:
     CharRow _charRow;
     ATTR_ROW _attrRow;
     SHORT _id;
     size_t _rowWidth;
     TextBuffer* _pParent; // non ownership pointer
+
+    // the parent's generation when this row last changed. See TextBuffer::GetGeneration.
+    uint64_t _generation;
+
+    void _MarkChanged() noexcept;
 };
 
 inline bool operator==(const ROW& a, const ROW& b) noexcept
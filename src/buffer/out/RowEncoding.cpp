@@ -0,0 +1,353 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "RowEncoding.hpp"
+
+static_assert(sizeof(wchar_t) == 2, "Encoded rows store text as UTF-16.");
+
+namespace
+{
+    template<typename T>
+    void Append(std::vector<BYTE>& out, const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const auto bytes = reinterpret_cast<const BYTE*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    // Reads values one after another out of an encoding, and fails if it
+    // ends before they do. Values are copied out, so nothing has to be aligned.
+    class Reader final
+    {
+    public:
+        Reader(const gsl::span<const BYTE> data) noexcept :
+            _data{ data },
+            _position{ 0 }
+        {
+        }
+
+        template<typename T>
+        T Read()
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            T value;
+            memcpy(&value, Take(sizeof(T)), sizeof(T));
+            return value;
+        }
+
+        const BYTE* Take(const size_t bytes)
+        {
+            THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), bytes > gsl::narrow_cast<size_t>(_data.size()) - _position);
+            const auto taken = _data.data() + _position;
+            _position += bytes;
+            return taken;
+        }
+
+    private:
+        const gsl::span<const BYTE> _data;
+        size_t _position;
+    };
+}
+
+// Routine Description:
+// - Returns the index of the given attribute, adding it if it's new.
+uint32_t RowEncoding::AttributeDictionary::Add(const TextAttribute& attr)
+{
+    const auto found = _indices.find(attr);
+    if (found != _indices.end())
+    {
+        return found->second;
+    }
+
+    const auto index = gsl::narrow<uint32_t>(_attrs.size());
+    _attrs.push_back(attr);
+    _indices.emplace(attr, index);
+    return index;
+}
+
+// Routine Description:
+// - Returns the attribute with the given index.
+// Return Value:
+// - the attribute. Throws if there is no such index.
+const TextAttribute& RowEncoding::AttributeDictionary::Get(const uint32_t index) const
+{
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), index >= _attrs.size());
+    return _attrs[index];
+}
+
+size_t RowEncoding::AttributeDictionary::Size() const noexcept
+{
+    return _attrs.size();
+}
+
+// Routine Description:
+// - Appends every attribute, in index order, s_packedSize bytes each.
+void RowEncoding::AttributeDictionary::Pack(std::vector<BYTE>& out) const
+{
+    const auto start = out.size();
+    out.resize(start + _attrs.size() * s_packedSize);
+    for (size_t i = 0; i < _attrs.size(); ++i)
+    {
+        _PackAttribute(_attrs[i], out.data() + start + i * s_packedSize);
+    }
+}
+
+// Routine Description:
+// - Replaces the dictionary with the attributes Pack wrote.
+void RowEncoding::AttributeDictionary::Unpack(const gsl::span<const BYTE> packed)
+{
+    const auto size = gsl::narrow_cast<size_t>(packed.size());
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), size % s_packedSize != 0);
+
+    _attrs.clear();
+    _indices.clear();
+    _attrs.reserve(size / s_packedSize);
+    for (size_t offset = 0; offset < size; offset += s_packedSize)
+    {
+        _attrs.push_back(_UnpackAttribute(packed.data() + offset));
+        _indices.emplace(_attrs.back(), gsl::narrow_cast<uint32_t>(_attrs.size() - 1));
+    }
+}
+
+// Routine Description:
+// - Appends the encoding of a row.
+// Arguments:
+// - row - the row to encode
+// - attrs - the dictionary the row's attributes are added to
+// - out - receives the encoding
+void RowEncoding::Encode(const ROW& row, AttributeDictionary& attrs, std::vector<BYTE>& out)
+{
+    const auto& charRow = row.GetCharRow();
+    const auto width = charRow.size();
+    const auto cells = charRow.cbegin();
+
+    // Blank cells at the end of the row aren't stored.
+    const CharRowCell blank;
+    size_t count = width;
+    while (count > 0 && cells[count - 1] == blank && !cells[count - 1].DbcsAttr().IsGlyphStored())
+    {
+        --count;
+    }
+
+    const auto& attrRow = row.GetAttrRow();
+    std::vector<std::pair<uint16_t, uint32_t>> runs;
+    for (size_t column = 0; column < width;)
+    {
+        size_t applies = 0;
+        const auto attr = attrRow.GetAttrByColumn(column, &applies);
+        column += applies;
+        runs.emplace_back(gsl::narrow_cast<uint16_t>(column), attrs.Add(attr));
+    }
+
+    _Header header{};
+    header.width = gsl::narrow<uint16_t>(width);
+    header.cells = gsl::narrow<uint16_t>(count);
+    header.runs = gsl::narrow<uint16_t>(runs.size());
+    WI_SetFlagIf(header.flags, s_wrapForced, charRow.WasWrapForced());
+    WI_SetFlagIf(header.flags, s_doubleBytePadded, charRow.WasDoubleBytePadded());
+    for (size_t column = 0; column < count; ++column)
+    {
+        const auto& dbcsAttr = cells[column].DbcsAttr();
+        WI_SetFlagIf(header.flags, s_hasDbcs, !dbcsAttr.IsSingle());
+        if (dbcsAttr.IsGlyphStored())
+        {
+            ++header.glyphs;
+        }
+    }
+
+    out.reserve(out.size() + sizeof(header) + count * 3 + runs.size() * 6);
+    Append(out, header);
+
+    for (size_t column = 0; column < count; ++column)
+    {
+        Append(out, cells[column].Char());
+    }
+
+    if (WI_IsFlagSet(header.flags, s_hasDbcs))
+    {
+        for (size_t column = 0; column < count; ++column)
+        {
+            const auto& dbcsAttr = cells[column].DbcsAttr();
+            Append(out, dbcsAttr.IsLeading() ? s_leading : dbcsAttr.IsTrailing() ? s_trailing : s_single);
+        }
+    }
+
+    for (const auto& [end, index] : runs)
+    {
+        Append(out, end);
+        Append(out, index);
+    }
+
+    for (size_t column = 0; column < count && header.glyphs > 0; ++column)
+    {
+        if (cells[column].DbcsAttr().IsGlyphStored())
+        {
+            const std::wstring_view glyph = charRow.GlyphAt(column);
+            Append(out, gsl::narrow_cast<uint16_t>(column));
+            Append(out, gsl::narrow<uint16_t>(glyph.size()));
+            const auto bytes = reinterpret_cast<const BYTE*>(glyph.data());
+            out.insert(out.end(), bytes, bytes + glyph.size() * sizeof(wchar_t));
+        }
+    }
+}
+
+// Routine Description:
+// - Replaces the contents of a row with an encoded one.
+// Arguments:
+// - encoded - the encoding of the row, as Encode wrote it
+// - attrs - the dictionary the encoding's attributes were added to
+// - row - the row to write to. It keeps its width.
+void RowEncoding::Decode(const gsl::span<const BYTE> encoded, const AttributeDictionary& attrs, ROW& row)
+{
+    Reader in{ encoded };
+    const auto header = in.Read<_Header>();
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), header.cells > header.width || header.runs == 0);
+
+    const auto width = row.size();
+    const auto count = std::min<size_t>(header.cells, width);
+
+    auto& charRow = row.GetCharRow();
+    charRow.Reset();
+    charRow.SetWrapForced(WI_IsFlagSet(header.flags, s_wrapForced));
+    charRow.SetDoubleBytePadded(WI_IsFlagSet(header.flags, s_doubleBytePadded));
+
+    const auto text = in.Take(header.cells * sizeof(wchar_t));
+    const auto dbcs = WI_IsFlagSet(header.flags, s_hasDbcs) ? in.Take(header.cells) : nullptr;
+    const auto cells = charRow.begin();
+    for (size_t column = 0; column < count; ++column)
+    {
+        wchar_t wch;
+        memcpy(&wch, text + column * sizeof(wchar_t), sizeof(wch));
+
+        DbcsAttribute dbcsAttr;
+        if (dbcs && dbcs[column] == s_leading)
+        {
+            dbcsAttr.SetLeading();
+        }
+        else if (dbcs && dbcs[column] == s_trailing)
+        {
+            dbcsAttr.SetTrailing();
+        }
+
+        cells[column] = CharRowCell{ wch, dbcsAttr };
+    }
+
+    // Runs past the end of the row are cut off, and the last one is
+    // stretched if the row is wider than the encoded one.
+    std::vector<TextAttributeRun> runs;
+    runs.reserve(header.runs);
+    size_t start = 0;
+    for (size_t i = 0; i < header.runs; ++i)
+    {
+        const size_t end = in.Read<uint16_t>();
+        const auto& attr = attrs.Get(in.Read<uint32_t>());
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), end <= start || end > header.width);
+        if (start < width)
+        {
+            runs.emplace_back(std::min(end, width) - start, attr);
+        }
+        start = end;
+    }
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), start != header.width);
+    if (header.width < width)
+    {
+        runs.back().SetLength(runs.back().GetLength() + width - header.width);
+    }
+    THROW_IF_FAILED(row.GetAttrRow().InsertAttrRuns({ runs.data(), runs.size() }, 0, width - 1, width));
+
+    for (size_t i = 0; i < header.glyphs; ++i)
+    {
+        const size_t column = in.Read<uint16_t>();
+        const size_t length = in.Read<uint16_t>();
+        const auto chars = reinterpret_cast<const wchar_t*>(in.Take(length * sizeof(wchar_t)));
+        THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_INVALID_DATA), length == 0);
+        if (column < count)
+        {
+            // Copied out first, because the encoding isn't necessarily aligned for wchar_t.
+            std::wstring glyph(length, L'\0');
+            memcpy(glyph.data(), chars, length * sizeof(wchar_t));
+            charRow.GlyphAt(column) = glyph;
+        }
+    }
+}
+
+// Routine Description:
+// - Appends a copy of an encoded row whose attributes refer to another
+//   dictionary. Only the indices of its runs change, so rows can move from
+//   one file to another without being decoded.
+// Arguments:
+// - encoded - the encoding of the row, as Encode wrote it
+// - from - the dictionary the encoding's attributes were added to
+// - to - the dictionary the copy's attributes are added to
+// - out - receives the copy
+void RowEncoding::Translate(const gsl::span<const BYTE> encoded, const AttributeDictionary& from, AttributeDictionary& to, std::vector<BYTE>& out)
+{
+    Reader in{ encoded };
+    const auto header = in.Read<_Header>();
+    in.Take(header.cells * sizeof(wchar_t));
+    if (WI_IsFlagSet(header.flags, s_hasDbcs))
+    {
+        in.Take(header.cells);
+    }
+
+    // A row that isn't valid leaves nothing behind.
+    const auto start = out.size();
+    auto truncate = wil::scope_exit([&]() noexcept { out.resize(start); });
+    out.insert(out.end(), encoded.begin(), encoded.end());
+
+    const auto runs = gsl::narrow_cast<size_t>(in.Take(0) - encoded.data());
+    for (size_t i = 0; i < header.runs; ++i)
+    {
+        in.Read<uint16_t>();
+        const auto index = to.Add(from.Get(in.Read<uint32_t>()));
+        const auto offset = runs + i * (sizeof(uint16_t) + sizeof(uint32_t)) + sizeof(uint16_t);
+        memcpy(out.data() + start + offset, &index, sizeof(index));
+    }
+    truncate.release();
+}
+
+// Routine Description:
+// - Returns the width of the row an encoding was made from.
+size_t RowEncoding::DecodeWidth(const gsl::span<const BYTE> encoded)
+{
+    return Reader{ encoded }.Read<_Header>().width;
+}
+
+// Routine Description:
+// - Writes an attribute as s_packedSize bytes: its legacy meta flags, its
+//   boldness, then its foreground and background colors as a type and three
+//   bytes each. This doesn't depend on how TextAttribute is laid out.
+void RowEncoding::_PackAttribute(const TextAttribute& attr, BYTE* const packed) noexcept
+{
+    const auto packColor = [](const TextColor& color, BYTE* const out) noexcept {
+        out[0] = static_cast<BYTE>(color._meta);
+        out[1] = color._red;
+        out[2] = color._green;
+        out[3] = color._blue;
+    };
+
+    packed[0] = LOBYTE(attr._wAttrLegacy);
+    packed[1] = HIBYTE(attr._wAttrLegacy);
+    packed[2] = attr._isBold ? 1 : 0;
+    packColor(attr._foreground, packed + 3);
+    packColor(attr._background, packed + 7);
+    packed[11] = 0;
+}
+
+TextAttribute RowEncoding::_UnpackAttribute(const BYTE* const packed) noexcept
+{
+    const auto unpackColor = [](TextColor& color, const BYTE* const in) noexcept {
+        color._meta = static_cast<ColorType>(in[0] & 0x3);
+        color._red = in[1];
+        color._green = in[2];
+        color._blue = in[3];
+    };
+
+    TextAttribute attr;
+    attr._wAttrLegacy = MAKEWORD(packed[0], packed[1]);
+    attr._isBold = packed[2] != 0;
+    unpackColor(attr._foreground, packed + 3);
+    unpackColor(attr._background, packed + 7);
+    return attr;
+}
@@ -0,0 +1,73 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- RowEncoding.hpp
+
+Abstract:
+- A compact binary encoding of one ROW, for keeping rows outside of a text
+  buffer: its cells up to the last one that isn't blank, its wrap flags, its
+  attribute runs, and the glyphs it keeps in the buffer's UnicodeStorage.
+- Attributes aren't stored in the encoding itself. Runs refer to them by
+  their index in an AttributeDictionary that's kept alongside the rows.
+- Encoded rows carry their width, and can be decoded into a row of any width.
+  Cells that don't fit are dropped, and cells past the encoded ones are blank.
+--*/
+
+#pragma once
+
+#include "Row.hpp"
+
+class RowEncoding final
+{
+public:
+    // Every distinct attribute the encoded rows use, each under one index.
+    class AttributeDictionary final
+    {
+    public:
+        uint32_t Add(const TextAttribute& attr);
+        const TextAttribute& Get(const uint32_t index) const;
+        size_t Size() const noexcept;
+
+        static constexpr size_t s_packedSize = 12;
+
+        void Pack(std::vector<BYTE>& out) const;
+        void Unpack(const gsl::span<const BYTE> packed);
+
+    private:
+        std::vector<TextAttribute> _attrs;
+        std::unordered_map<TextAttribute, uint32_t> _indices;
+    };
+
+    static void Encode(const ROW& row, AttributeDictionary& attrs, std::vector<BYTE>& out);
+    static void Decode(const gsl::span<const BYTE> encoded, const AttributeDictionary& attrs, ROW& row);
+    static void Translate(const gsl::span<const BYTE> encoded, const AttributeDictionary& from, AttributeDictionary& to, std::vector<BYTE>& out);
+
+    static size_t DecodeWidth(const gsl::span<const BYTE> encoded);
+
+private:
+    // Laid out at the start of every encoded row, followed by the text of its
+    // cells, their DbcsAttributes (only if any cell isn't a single), the
+    // runs, and the stored glyphs.
+    struct _Header
+    {
+        uint16_t width;
+        uint16_t cells;
+        uint16_t runs;
+        uint16_t glyphs;
+        uint8_t flags;
+        uint8_t reserved;
+    };
+
+    static constexpr uint8_t s_wrapForced = 0x1;
+    static constexpr uint8_t s_doubleBytePadded = 0x2;
+    static constexpr uint8_t s_hasDbcs = 0x4;
+
+    static constexpr uint8_t s_single = 0;
+    static constexpr uint8_t s_leading = 1;
+    static constexpr uint8_t s_trailing = 2;
+
+    static void _PackAttribute(const TextAttribute& attr, BYTE* const packed) noexcept;
+    static TextAttribute _UnpackAttribute(const BYTE* const packed) noexcept;
+};
@@ -148,6 +148,16 @@ public:
         return _foreground.IsRgb() || _background.IsRgb();
     }
 
+    constexpr TextColor GetForeground() const noexcept
+    {
+        return _foreground;
+    }
+
+    constexpr TextColor GetBackground() const noexcept
+    {
+        return _background;
+    }
+
 private:
     COLORREF _GetRgbForeground(std::basic_string_view<COLORREF> colorTable,
                                COLORREF defaultColor) const;
@@ -161,6 +171,9 @@ private:
     TextColor _background;
     bool _isBold;
 
+    friend struct std::hash<TextAttribute>;
+    friend class RowEncoding;
+
 #ifdef UNIT_TESTING
     friend class TextBufferTests;
     friend class TextAttributeTests;
@@ -208,6 +221,30 @@ constexpr bool operator!=(const WORD& legacyAttr, const TextAttribute& attr) noe
     return !(attr == legacyAttr);
 }
 
+namespace std
+{
+    template<>
+    struct hash<TextAttribute>
+    {
+        // Routine Description:
+        // - hashes an attribute by folding both colors, the meta flags and
+        //   the boldness into one 64-bit value and mixing that.
+        // Arguments:
+        // - attr - the attribute to hash
+        // Return Value:
+        // - the hashed attribute
+        size_t operator()(const TextAttribute& attr) const noexcept
+        {
+            const hash<TextColor> hashColor;
+            const uint64_t packed = (static_cast<uint64_t>(hashColor(attr._foreground)) << 32) ^
+                                    (static_cast<uint64_t>(hashColor(attr._background))) ^
+                                    (static_cast<uint64_t>(attr._wAttrLegacy) << 26) ^
+                                    (attr._isBold ? 1ull << 63 : 0);
+            return hash<uint64_t>{}(packed);
+        }
+    };
+}
+
 #ifdef UNIT_TESTING
 
 #define LOG_ATTR(attr) (Log::Comment(NoThrowString().Format(\
@@ -0,0 +1,170 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "TextAttributeTable.hpp"
+
+#pragma hdrstop
+
+// Routine Description:
+// - Sets the callback used to find out which ids are still in use when the
+//   table grows to its threshold.
+// Arguments:
+// - markLive - sets the bit of every id the owner still references. The vector
+//              is already sized to cover every id.
+void TextAttributeTable::SetCollector(MarkLiveCallback markLive)
+{
+    _markLive = std::move(markLive);
+}
+
+// Routine Description:
+// - Prepares for the next `count` calls to Intern, reclaiming the ids nobody
+//   uses anymore if interning them would grow the table past its threshold.
+//   Ids handed out before this call are only safe if they're in a row.
+// - If that doesn't free at least half of the threshold, the threshold
+//   doubles, so the next collection is as far off as this one was.
+// Arguments:
+// - count - the number of attributes about to be interned
+void TextAttributeTable::Reserve(const size_t count)
+{
+    if (_free.size() >= count || _entries.size() + count <= _collectAt)
+    {
+        return;
+    }
+
+    Collect();
+    while (Size() + count > _collectAt / 2)
+    {
+        _collectAt *= 2;
+    }
+}
+
+// Routine Description:
+// - Returns the id of the given attribute, adding it to the table first if
+//   it isn't there yet.
+// Arguments:
+// - attr - the attribute to look up
+// Return Value:
+// - the id of the attribute. Call Reserve first, so that the ids nobody uses
+//   are reclaimed before the table grows.
+TextAttributeTable::Id TextAttributeTable::Intern(const TextAttribute& attr)
+{
+    // Output tends to come in long stretches of one attribute.
+    if (_last.has_value() && _entries[_last.value()] == attr)
+    {
+        return _last.value();
+    }
+
+    Id id;
+    const auto found = _ids.find(attr);
+    if (found != _ids.end())
+    {
+        id = found->second;
+    }
+    else
+    {
+        if (!_free.empty())
+        {
+            id = _free.back();
+            _free.pop_back();
+            _entries[id] = attr;
+        }
+        else
+        {
+            id = gsl::narrow<Id>(_entries.size());
+            _entries.push_back(attr);
+        }
+        _ids.emplace(attr, id);
+    }
+
+    _last = id;
+    return id;
+}
+
+// Routine Description:
+// - Returns the number of ids currently handed out.
+size_t TextAttributeTable::Size() const noexcept
+{
+    return _entries.size() - _free.size();
+}
+
+// Routine Description:
+// - Returns the number of ids the table hands out before it collects again.
+size_t TextAttributeTable::CollectsAt() const noexcept
+{
+    return _collectAt;
+}
+
+// Routine Description:
+// - Reclaims every id the owner doesn't use anymore.
+void TextAttributeTable::Collect()
+{
+    std::vector<bool> live(_entries.size());
+    if (_markLive)
+    {
+        _markLive(live);
+    }
+
+    _free.clear();
+    for (size_t i = _entries.size(); i > 0; --i)
+    {
+        const auto id = gsl::narrow_cast<Id>(i - 1);
+        if (live[id])
+        {
+            continue;
+        }
+
+        // Free entries keep their old value, which may since have been
+        // interned again under another id. Only unmap it if it's ours.
+        const auto found = _ids.find(_entries[id]);
+        if (found != _ids.end() && found->second == id)
+        {
+            _ids.erase(found);
+        }
+        _free.push_back(id);
+    }
+
+    _last.reset();
+}
+
+// Routine Description:
+// - Changes every occurrence of one attribute into another. Rows aren't
+//   touched at all; they see the new attribute through the ids they hold.
+// Arguments:
+// - from - the attribute to replace
+// - to - the attribute to replace it with
+void TextAttributeTable::Replace(const TextAttribute& from, const TextAttribute& to)
+{
+    if (from == to)
+    {
+        return;
+    }
+
+    std::optional<Id> mapped;
+    const auto found = _ids.find(from);
+    if (found != _ids.end())
+    {
+        mapped = found->second;
+        _ids.erase(found);
+    }
+
+    // An earlier Replace may have left more than one id holding `from`.
+    // Rewriting free entries too is harmless; nothing maps to them.
+    for (auto& entry : _entries)
+    {
+        if (entry == from)
+        {
+            entry = to;
+        }
+    }
+
+    // If `to` was already interned, its id stays the canonical one and the
+    // replaced ids become aliases of it.
+    if (mapped.has_value())
+    {
+        _ids.emplace(to, mapped.value());
+    }
+
+    _last.reset();
+}
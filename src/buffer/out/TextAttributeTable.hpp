@@ -0,0 +1,67 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- TextAttributeTable.hpp
+
+Abstract:
+- Interns the text attributes of a text buffer, so that each distinct attribute
+  is stored once and rows only have to hold an id for every run.
+- Ids of the same table compare equal if and only if their attributes do, with
+  one exception: after Replace, several ids can hold the same attribute. That
+  only costs a run boundary that a full compare would have merged.
+- Ids are never freed one at a time. When the table grows to a threshold, the
+  owner is asked to mark the ids its rows still use, and everything else is
+  reclaimed. That can only happen in Reserve, which callers use before
+  interning a batch so that no id they're still holding on to can be
+  reclaimed underneath them.
+- If a collection frees less than half of the table, the threshold doubles,
+  so a buffer full of distinct attributes (a true-color image, say) grows the
+  table instead of being walked again on every write. Two attributes never
+  share an id because the table ran out.
+--*/
+
+#pragma once
+
+#include "TextAttribute.hpp"
+
+class TextAttributeTable final
+{
+public:
+    using Id = uint32_t;
+    using MarkLiveCallback = std::function<void(std::vector<bool>& live)>;
+
+    // how many ids the table hands out before it first collects
+    static constexpr size_t s_initialCollectAt = 64 * 1024;
+
+    void SetCollector(MarkLiveCallback markLive);
+
+    void Reserve(const size_t count);
+    Id Intern(const TextAttribute& attr);
+
+    // Routine Description:
+    // - Returns the attribute stored under the given id.
+    // Arguments:
+    // - id - an id handed out by Intern and still referenced by a row
+    // Return Value:
+    // - the attribute. The reference is stable until the id is reclaimed.
+    const TextAttribute& Get(const Id id) const noexcept
+    {
+        return _entries[id];
+    }
+
+    size_t Size() const noexcept;
+    size_t CollectsAt() const noexcept;
+
+    void Collect();
+    void Replace(const TextAttribute& from, const TextAttribute& to);
+
+private:
+    std::deque<TextAttribute> _entries;
+    std::vector<Id> _free;
+    std::unordered_map<TextAttribute, Id> _ids;
+    std::optional<Id> _last;
+    size_t _collectAt = s_initialCollectAt;
+    MarkLiveCallback _markLive;
+};
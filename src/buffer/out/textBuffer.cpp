@@ -5,8 +5,12 @@
 
 #include "textBuffer.hpp"
 #include "CharRow.hpp"
+#include "textBufferReflow.hpp"
+#include "textBufferSnapshot.hpp"
+#include "textBufferSpill.hpp"
 
 #include "../types/inc/convert.hpp"
+#include "../types/inc/Metrics.hpp"
 
 #pragma hdrstop
 
@@ -29,10 +33,31 @@ TextBuffer::TextBuffer(const COORD screenBufferSize,
     _firstRow{ 0 },
     _currentAttributes{ defaultAttributes },
     _cursor{ cursorSize, *this },
+    _attributeTable{},
+    _generation{ 0 },
+    _allRowsChangedGeneration{ 0 },
+    _scrolledRowCount{ 0 },
     _storage{},
+    _reflow{ nullptr },
     _unicodeStorage{},
-    _renderTarget{ renderTarget }
+    _renderTarget{ renderTarget },
+    _scrollbackWriter{ nullptr },
+    _spill{},
+    _spillBase{}
 {
+    // When the attribute table grows to its threshold, it reclaims the ids no
+    // row refers to anymore.
+    _attributeTable.SetCollector([this](std::vector<bool>& live) {
+        for (const auto& row : _storage)
+        {
+            row.GetAttrRow().MarkLiveAttributes(live);
+        }
+        if (_reflow)
+        {
+            _reflow->MarkLiveAttributes(live);
+        }
+    });
+
     // initialize ROWs
     for (size_t i = 0; i < static_cast<size_t>(screenBufferSize.Y); ++i)
     {
@@ -40,6 +65,9 @@ TextBuffer::TextBuffer(const COORD screenBufferSize,
     }
 }
 
+// The spill is incomplete in the header.
+TextBuffer::~TextBuffer() = default;
+
 // Routine Description:
 // - Copies properties from another text buffer into this one.
 // - This is primarily to copy properties that would otherwise not be specified during CreateInstance
@@ -63,6 +91,68 @@ UINT TextBuffer::TotalRowCount() const
     return static_cast<UINT>(_storage.size());
 }
 
+// Routine Description:
+// - Gets the buffer's current generation. It goes up with every change to a
+//   row, and every row remembers the generation it last changed in (see
+//   ROW::GetGeneration), so anything that looked at the buffer can later ask
+//   what changed since with GetRowsChangedSince.
+// Return Value:
+// - The current generation
+uint64_t TextBuffer::GetGeneration() const noexcept
+{
+    return _generation;
+}
+
+// Routine Description:
+// - Finds the rows that changed after the given generation.
+// - Scrolling the buffer doesn't change its rows: they keep their generation
+//   as they move up, and only the row that comes in at the bottom counts as
+//   changed. Whoever looked at the buffer at the generation can tell how far
+//   rows moved since from GetScrolledRowCount. Rows that move to other offsets
+//   within the buffer (see ScrollRows) count as changed.
+// - Recoloring an attribute may change any row, and a reflow moves all the
+//   text, so after those, every row counts as changed.
+// Arguments:
+// - generation - a value GetGeneration returned before
+// Return Value:
+// - The offsets of the changed rows, top to bottom
+std::vector<size_t> TextBuffer::GetRowsChangedSince(const uint64_t generation) const
+{
+    std::vector<size_t> changed;
+    const size_t totalRows = TotalRowCount();
+    const auto all = GetAllRowsChangedGeneration() > generation;
+    for (size_t offset = 0; offset < totalRows; ++offset)
+    {
+        if (all || GetRowByOffset(offset).GetGeneration() > generation)
+        {
+            changed.push_back(offset);
+        }
+    }
+    return changed;
+}
+
+// Routine Description:
+// - Gets the last generation in which every row changed at once, by a recolor
+//   or a reflow. Whoever copied rows of the buffer at an earlier generation
+//   has to copy all of them again, whatever generation they have.
+// Return Value:
+// - The generation, or 0 if every row never changed at once
+uint64_t TextBuffer::GetAllRowsChangedGeneration() const noexcept
+{
+    return _allRowsChangedGeneration;
+}
+
+// Routine Description:
+// - Gets the number of rows that ever left the top of the buffer, by circling
+//   or by a resize cutting them off. Between two calls, the row at an offset
+//   moved up by the difference, to the offset that much smaller.
+// Return Value:
+// - The number of rows
+uint64_t TextBuffer::GetScrolledRowCount() const noexcept
+{
+    return _scrolledRowCount;
+}
+
 // Routine Description:
 // - Retrieves a row from the buffer by its offset from the first row of the text buffer (what corresponds to
 // the top row of the screen buffer)
@@ -91,6 +181,33 @@ ROW& TextBuffer::GetRowByOffset(const size_t index)
     return const_cast<ROW&>(static_cast<const TextBuffer*>(this)->GetRowByOffset(index));
 }
 
+// Routine Description:
+// - Retrieves a row for reading by its offset from the first row of the text
+//   buffer, like GetRowByOffset, or one of the spilled rows above it: offset
+//   -1 is the spilled row right above the spill base (see SetSpillBase), -2
+//   the one above that, and so on.
+// - Spilled rows are read back from their file. The row is pinned in the
+//   spill's cache for as long as the pointer is held, so the pointer can be
+//   held while other threads read rows. Rows of the buffer aren't pinned;
+//   they're only good until the buffer changes, as always.
+// Arguments:
+// - index - Number of rows down from the first row of the buffer. Negative for spilled rows.
+// Return Value:
+// - The row. Throws if there is no such row.
+std::shared_ptr<const ROW> TextBuffer::PinRowByOffset(const SHORT index) const
+{
+    if (index >= 0)
+    {
+        // Nothing owns the row but the buffer.
+        return { std::shared_ptr<const ROW>{}, &GetRowByOffset(index) };
+    }
+
+    const size_t above = -static_cast<ptrdiff_t>(index);
+    const auto base = GetSpillBase();
+    THROW_HR_IF(E_INVALIDARG, above > base);
+    return _spill->PinRow(base - above);
+}
+
 // Routine Description:
 // - Retrieves read-only text iterator at the given buffer location
 // Arguments:
@@ -183,10 +300,11 @@ bool TextBuffer::_AssertValidDoubleByteSequence(const DbcsAttribute dbcsAttribut
     // To figure out if the sequence is valid, we have to look at the character that comes before the current one
     const COORD coordPrevPosition = _GetPreviousFromCursor();
     ROW& prevRow = GetRowByOffset(coordPrevPosition.Y);
+    const CharRow& prevCharRow = prevRow.GetCharRow();
     DbcsAttribute prevDbcsAttr;
     try
     {
-        prevDbcsAttr = prevRow.GetCharRow().DbcsAttrAt(coordPrevPosition.X);
+        prevDbcsAttr = prevCharRow.DbcsAttrAt(coordPrevPosition.X);
     }
     catch (...)
     {
@@ -372,6 +490,65 @@ OutputCellIterator TextBuffer::WriteLine(const OutputCellIterator givenIt,
     return newIt;
 }
 
+// Routine Description:
+// - Writes one line of text in a single color to the output buffer. This is
+//   WriteLine for text where every character is known to take one cell.
+// Arguments:
+// - text - The characters to write. See ROW::WriteNarrowText.
+// - attr - Color data for every written cell
+// - target - Coordinate targeted within output buffer
+// - setWrap - Whether we should try to set the wrap flag if we write up to the end of the line
+// Return Value:
+// - The number of cells written. Text that doesn't fit in the line isn't written.
+size_t TextBuffer::WriteNarrowLine(const std::wstring_view text,
+                                   const TextAttribute& attr,
+                                   const COORD target,
+                                   const bool setWrap)
+{
+    // If we're not in bounds, exit early.
+    if (!GetSize().IsInBounds(target))
+    {
+        return 0;
+    }
+
+    ROW& row = GetRowByOffset(target.Y);
+    const auto written = row.WriteNarrowText(text, target.X, attr, setWrap);
+
+    const Viewport paint = Viewport::FromDimensions(target, { gsl::narrow<SHORT>(written), 1 });
+    _NotifyPaint(paint);
+
+    return written;
+}
+
+// Routine Description:
+// - Writes one line of legacy cells to the output buffer. This is WriteLine
+//   for an OutputCellIterator over CHAR_INFOs, without the iterator.
+// Arguments:
+// - cells - The cells to write. See ROW::WriteCharInfos.
+// - target - Coordinate targeted within output buffer
+// - setWrap - Whether we should try to set the wrap flag if we write up to the end of the line
+// Return Value:
+// - The number of cells consumed. Use to find what's left to write on the next line.
+size_t TextBuffer::WriteCharInfoLine(const std::basic_string_view<CHAR_INFO> cells,
+                                     const COORD target,
+                                     const bool setWrap)
+{
+    // If we're not in bounds, exit early.
+    if (!GetSize().IsInBounds(target))
+    {
+        return 0;
+    }
+
+    ROW& row = GetRowByOffset(target.Y);
+    size_t written = 0;
+    const auto consumed = row.WriteCharInfos(cells, target.X, setWrap, written);
+
+    const Viewport paint = Viewport::FromDimensions(target, { gsl::narrow<SHORT>(written), 1 });
+    _NotifyPaint(paint);
+
+    return consumed;
+}
+
 //Routine Description:
 // - Inserts one codepoint into the buffer at the current cursor position and advances the cursor as appropriate.
 //Arguments:
@@ -539,6 +716,9 @@ bool TextBuffer::IncrementCircularBuffer()
     // to the logical position 0 in the window (cursor coordinates and all other coordinates).
     _renderTarget.TriggerCircling();
 
+    // Save the old "first row" before it's gone, if anyone wants it.
+    _SaveScrolledOutRow(_storage.at(_firstRow));
+
     // First, clean out the old "first row" as it will become the "last row" of the buffer after the circle is performed.
     bool fSuccess = _storage.at(_firstRow).Reset(_currentAttributes);
     if (fSuccess)
@@ -552,10 +732,129 @@ bool TextBuffer::IncrementCircularBuffer()
         {
             _firstRow = 0;
         }
+
+        ++_scrolledRowCount;
+        Metrics::Add(Metrics::Counter::RowsScrolled);
     }
     return fSuccess;
 }
 
+// Routine Description:
+// - Hands a row that's leaving the top of the buffer to the scrollback writer
+//   and the spill, if there are any. Every way a row can leave the top goes through here:
+//   scrolling, a resize that cuts rows off the top, and a reflow that pushes
+//   them out.
+// - Rows that can't be saved are logged and dropped, the same as without a writer.
+// Arguments:
+// - row - the row, oldest first. Its contents aren't needed after this returns.
+void TextBuffer::_SaveScrolledOutRow(const ROW& row) noexcept
+{
+    if (_scrollbackWriter)
+    {
+        try
+        {
+            _scrollbackWriter->AppendRow(row);
+        }
+        CATCH_LOG();
+    }
+
+    if (_spill)
+    {
+        try
+        {
+            _spill->Append(row);
+        }
+        CATCH_LOG();
+    }
+}
+
+// Routine Description:
+// - Sets where rows go when they scroll out of the top of the buffer, so that
+//   a snapshot of the buffer keeps them. See TextBufferSnapshotWriter.
+// Arguments:
+// - writer - the writer, or nullptr to stop. It must outlive the buffer or be unset first.
+void TextBuffer::SetScrollbackWriter(TextBufferSnapshotWriter* const writer) noexcept
+{
+    _scrollbackWriter = writer;
+}
+
+// Routine Description:
+// - Starts keeping the rows that scroll out of the top of the buffer in a
+//   file, where they can be read back with ReadSpilledRow. See TextBufferSpill.
+// - The rows are at the offsets above row 0, where cell iterators walk up
+//   into them; see PinRowByOffset. It's up to the host to scroll there.
+// Arguments:
+// - path - the file to keep them in. It's replaced, and deleted with the buffer.
+void TextBuffer::SpillTo(const std::wstring_view path)
+{
+    _spill = std::make_unique<TextBufferSpill>(*this, path);
+}
+
+bool TextBuffer::IsSpilling() const noexcept
+{
+    return static_cast<bool>(_spill);
+}
+
+// Routine Description:
+// - Adds a row to the spill as if it had scrolled out of the top of the
+//   buffer, without decoding it. See TextBufferSnapshot::Restore.
+// Arguments:
+// - encoded - the row, in RowEncoding
+// - attrs - the dictionary the encoding's attributes were added to
+void TextBuffer::SpillEncodedRow(const gsl::span<const BYTE> encoded, const RowEncoding::AttributeDictionary& attrs)
+{
+    THROW_HR_IF(E_NOT_VALID_STATE, !_spill);
+    _spill->AppendEncoded(encoded, attrs);
+}
+
+// Routine Description:
+// - Gets the number of rows that scrolled out of the top of the buffer since
+//   SpillTo. They're above row 0, oldest first.
+size_t TextBuffer::GetSpilledRowCount() const noexcept
+{
+    return _spill ? _spill->RowCount() : 0;
+}
+
+// Routine Description:
+// - Reads back a row that scrolled out of the top of the buffer. Rows that
+//   were read recently are kept decoded, so reading the rows above the
+//   viewport one after another, like scrolling up does, mostly doesn't touch
+//   the file.
+// - Reading rows pages them in, but the spill has a lock of its own for
+//   that, so threads that only read the buffer can read rows at once.
+// Arguments:
+// - index - the row to read; 0 is the oldest row, and
+//   GetSpilledRowCount() - 1 the one right above row 0
+// - read - called with the row, cut or padded to the width of the buffer.
+//   The row can't be kept past the call. Its cells can be walked with
+//   ROW::AsCellIter.
+void TextBuffer::ReadSpilledRow(const size_t index, const std::function<void(const ROW& row)>& read) const
+{
+    THROW_HR_IF(E_INVALIDARG, !_spill);
+    _spill->ReadRow(index, read);
+}
+
+// Routine Description:
+// - Sets which spilled rows are at the offsets above row 0. Offsets are
+//   SHORTs, so only so many spilled rows are above row 0 at once; a host that
+//   shows rows further up moves the base up to them.
+// Arguments:
+// - base - the spilled row right below the one at offset -1, so that the row
+//   at offset -1 is the one before it. If there's none, the rows that
+//   spilled last are right above row 0, so base is GetSpilledRowCount().
+void TextBuffer::SetSpillBase(const std::optional<size_t> base) noexcept
+{
+    _spillBase = base;
+}
+
+// Routine Description:
+// - Gets the spilled row right below the one at offset -1. See SetSpillBase.
+size_t TextBuffer::GetSpillBase() const noexcept
+{
+    const auto count = GetSpilledRowCount();
+    return std::min(_spillBase.value_or(count), count);
+}
+
 //Routine Description:
 // - Retrieves the position of the last non-space character on the final line of the text buffer.
 //Arguments:
@@ -632,6 +931,16 @@ const Viewport TextBuffer::GetSize() const
     return Viewport::FromDimensions({ 0, 0 }, { gsl::narrow<SHORT>(_storage.at(0).size()), gsl::narrow<SHORT>(_storage.size()) });
 }
 
+// Routine Description:
+// - Gets the size of the buffer together with the spilled rows at the
+//   offsets above row 0, as many as there are offsets for. See PinRowByOffset.
+const Viewport TextBuffer::GetSizeWithSpill() const
+{
+    const auto size = GetSize();
+    const auto above = gsl::narrow_cast<SHORT>(std::min<size_t>(GetSpillBase(), SHRT_MAX));
+    return Viewport::FromInclusive({ 0, -above, size.RightInclusive(), size.BottomInclusive() });
+}
+
 void TextBuffer::_SetFirstRowIndex(const SHORT FirstRowIndex)
 {
     _firstRow = FirstRowIndex;
@@ -736,6 +1045,14 @@ void TextBuffer::ScrollRows(const SHORT firstRow, const SHORT size, const SHORT
     // Renumber the IDs now that we've rearranged where the rows sit within the buffer.
     // Refreshing should also delegate to the UnicodeStorage to re-key all the stored unicode sequences (where applicable).
     _RefreshRowIDs(std::nullopt);
+
+    // The rows that moved now show something else at their offsets.
+    const auto moved = std::minmax({ firstRow, firstRow + size, firstRow + delta, firstRow + size + delta });
+    for (auto i = moved.first; i < moved.second; ++i)
+    {
+        _storage.at(static_cast<size_t>(i))._MarkChanged();
+    }
+    Metrics::Add(Metrics::Counter::RowsScrolled, std::abs(delta));
 }
 
 Cursor& TextBuffer::GetCursor()
@@ -759,6 +1076,19 @@ void TextBuffer::SetCurrentAttributes(const TextAttribute currentAttributes) noe
     _currentAttributes = currentAttributes;
 }
 
+// Routine Description:
+// - Recolors every cell in the buffer that has one attribute with another.
+//   Rows only hold ids into the attribute table, so this only walks the table,
+//   no matter how much text there is.
+// Arguments:
+// - from - the attribute to replace
+// - to - the attribute to replace it with
+void TextBuffer::ReplaceAttributes(const TextAttribute& from, const TextAttribute& to)
+{
+    _attributeTable.Replace(from, to);
+    _MarkAllRowsChanged();
+}
+
 // Routine Description:
 // - Resets the text contents of this buffer with the default character
 //   and the default current color attributes
@@ -797,6 +1127,12 @@ NTSTATUS TextBuffer::ResizeTraditional(const COORD newSize) noexcept
     // rotate rows until the top row is at index 0
     try
     {
+        // The rows above the new top row are about to be cut off.
+        for (SHORT y = 0; y < TopRow; ++y)
+        {
+            _SaveScrolledOutRow(GetRowByOffset(y));
+        }
+
         const ROW& newTopRow = _storage[TopRowIndex];
         while (&newTopRow != &_storage.front())
         {
@@ -822,10 +1158,49 @@ NTSTATUS TextBuffer::ResizeTraditional(const COORD newSize) noexcept
         // Also take advantage of the row ID refresh loop to resize the rows in the X dimension
         // and cleanup the UnicodeStorage characters that might fall outside the resized buffer.
         _RefreshRowIDs(newSize.X);
+        _scrolledRowCount += TopRow;
+    }
+    CATCH_RETURN();
 
+    return S_OK;
+}
+
+// Routine Description:
+// - Resizes the buffer and rewraps its text for the new width. Rows that were
+//   wrapped by the right edge (see CharRow::WasWrapForced) are joined back into
+//   one line before being split again, so wrapped lines stay whole.
+// - The cursor stays on the same character it was on before.
+// - Rows that spilled out of the top are rewrapped too. See TextBufferSpill::Reflow.
+// Arguments:
+// - newSize - new size of the buffer.
+// Return Value:
+// - S_OK if successful. E_INVALIDARG for an unusable size. On any failure the
+//   buffer is left as it was.
+[[nodiscard]]
+HRESULT TextBuffer::ResizeWithReflow(const COORD newSize) noexcept
+{
+    RETURN_HR_IF(E_INVALIDARG, newSize.X <= 0 || newSize.Y <= 0);
+
+    try
+    {
+        TextBufferReflow reflow{ *this, newSize };
+        auto moved = wil::scope_exit([&]() noexcept { _MarkAllRowsChanged(); });
+        reflow.Run();
     }
     CATCH_RETURN();
 
+    // The spilled rows are reflowed after the buffer's, so the rows that the
+    // buffer's reflow pushed out are already at the new width. If they can't
+    // be, they're read back cut off or padded instead.
+    if (_spill)
+    {
+        try
+        {
+            _spill->Reflow();
+        }
+        CATCH_LOG();
+    }
+
     return S_OK;
 }
 
@@ -839,6 +1214,16 @@ UnicodeStorage& TextBuffer::GetUnicodeStorage()
     return _unicodeStorage;
 }
 
+const TextAttributeTable& TextBuffer::GetAttributeTable() const noexcept
+{
+    return _attributeTable;
+}
+
+TextAttributeTable& TextBuffer::GetAttributeTable() noexcept
+{
+    return _attributeTable;
+}
+
 // Routine Description:
 // - Method to help refresh all the Row IDs after manipulating the row
 //   by shuffling pointers around.
@@ -860,8 +1245,9 @@ void TextBuffer::_RefreshRowIDs(std::optional<SHORT> newRowWidth)
         // Update the IDs
         it.SetId(i++);
 
-        // Also update the char row parent pointers as they can get shuffled up in the rotates.
+        // Also update the char and attr row parent pointers as they can get shuffled up in the rotates.
         it.GetCharRow().UpdateParent(&it);
+        it.GetAttrRow().UpdateParent(&it);
 
         // Resize the rows in the X dimension if we have a new width
         if (newRowWidth.has_value())
@@ -880,6 +1266,16 @@ void TextBuffer::_NotifyPaint(const Viewport& viewport) const
     _renderTarget.TriggerRedraw(viewport);
 }
 
+uint64_t TextBuffer::_NextGeneration() noexcept
+{
+    return ++_generation;
+}
+
+void TextBuffer::_MarkAllRowsChanged() noexcept
+{
+    _allRowsChangedGeneration = _NextGeneration();
+}
+
 // Routine Description:
 // - Retrieves the first row from the underlying buffer.
 // Arguments:
@@ -922,112 +1318,3 @@ Microsoft::Console::Render::IRenderTarget& TextBuffer::GetRenderTarget()
 {
     return _renderTarget;
 }
-
-// Routine Description:
-// - Retrieves the text data from the selected region and presents it in a clipboard-ready format (given little post-processing).
-// Arguments:
-// - lineSelection - true if entire line is being selected. False otherwise (box selection)
-// - trimTrailingWhitespace - setting flag removes trailing whitespace at the end of each row in selection
-// - selectionRects - the selection regions from which the data will be extracted from the buffer
-// - GetForegroundColor - function used to map TextAttribute to RGB COLORREF for foreground color
-// - GetBackgroundColor - function used to map TextAttribute to RGB COLORREF for foreground color
-// Return Value:
-// - The text, background color, and foreground color data of the selected region of the text buffer.
-const TextBuffer::TextAndColor TextBuffer::GetTextForClipboard(const bool lineSelection,
-                                                               const bool trimTrailingWhitespace,
-                                                               const std::vector<SMALL_RECT>& selectionRects,
-                                                               std::function<COLORREF(TextAttribute&)> GetForegroundColor,
-                                                               std::function<COLORREF(TextAttribute&)> GetBackgroundColor) const
-{
-    TextAndColor data;
-
-    // preallocate our vectors to reduce reallocs
-    size_t const rows = selectionRects.size();
-    data.text.reserve(rows);
-    data.FgAttr.reserve(rows);
-    data.BkAttr.reserve(rows);
-
-    // for each row in the selection
-    for (UINT i = 0; i < rows; i++)
-    {
-        const UINT iRow = selectionRects.at(i).Top;
-
-        const Viewport highlight = Viewport::FromInclusive(selectionRects.at(i));
-
-        // retrieve the data from the screen buffer
-        auto it = GetCellDataAt(highlight.Origin(), highlight);
-
-        // allocate a string buffer
-        std::wstring selectionText;
-        std::vector<COLORREF> selectionFgAttr;
-        std::vector<COLORREF> selectionBkAttr;
-
-        // preallocate to avoid reallocs
-        selectionText.reserve(highlight.Width() + 2); // + 2 for \r\n if we munged it
-        selectionFgAttr.reserve(highlight.Width() + 2);
-        selectionBkAttr.reserve(highlight.Width() + 2);
-
-        // copy char data into the string buffer, skipping trailing bytes
-        while (it)
-        {
-            const auto& cell = *it;
-            auto cellData = cell.TextAttr();
-            COLORREF const CellFgAttr = GetForegroundColor(cellData);
-            COLORREF const CellBkAttr = GetBackgroundColor(cellData);
-
-            if (!cell.DbcsAttr().IsTrailing())
-            {
-                selectionText.append(cell.Chars());
-                for (const wchar_t wch : cell.Chars())
-                {
-                    selectionFgAttr.push_back(CellFgAttr);
-                    selectionBkAttr.push_back(CellBkAttr);
-                }
-            }
-            it++;
-        }
-
-        // trim trailing spaces if SHIFT key not held
-        if (trimTrailingWhitespace)
-        {
-            const ROW& Row = GetRowByOffset(iRow);
-
-            // FOR LINE SELECTION ONLY: if the row was wrapped, don't remove the spaces at the end.
-            if (!lineSelection || !Row.GetCharRow().WasWrapForced())
-            {
-                while (!selectionText.empty() && selectionText.back() == UNICODE_SPACE)
-                {
-                    selectionText.pop_back();
-                    selectionFgAttr.pop_back();
-                    selectionBkAttr.pop_back();
-                }
-            }
-
-            // apply CR/LF to the end of the final string, unless we're the last line.
-            // a.k.a if we're earlier than the bottom, then apply CR/LF.
-            if (i < selectionRects.size() - 1)
-            {
-                // FOR LINE SELECTION ONLY: if the row was wrapped, do not apply CR/LF.
-                // a.k.a. if the row was NOT wrapped, then we can assume a CR/LF is proper
-                // always apply \r\n for box selection
-                if (!lineSelection || !GetRowByOffset(iRow).GetCharRow().WasWrapForced())
-                {
-                    COLORREF const Blackness = RGB(0x00, 0x00, 0x00);      // cant see CR/LF so just use black FG & BK
-
-                    selectionText.push_back(UNICODE_CARRIAGERETURN);
-                    selectionText.push_back(UNICODE_LINEFEED);
-                    selectionFgAttr.push_back(Blackness);
-                    selectionFgAttr.push_back(Blackness);
-                    selectionBkAttr.push_back(Blackness);
-                    selectionBkAttr.push_back(Blackness);
-                }
-            }
-        }
-
-        data.text.emplace_back(selectionText);
-        data.FgAttr.emplace_back(selectionFgAttr);
-        data.BkAttr.emplace_back(selectionBkAttr);
-    }
-
-    return data;
-}
@@ -51,7 +51,9 @@ filling in the last row, and updating the screen.
 
 #include "cursor.h"
 #include "Row.hpp"
+#include "RowEncoding.hpp"
 #include "TextAttribute.hpp"
+#include "TextAttributeTable.hpp"
 #include "UnicodeStorage.hpp"
 #include "../types/inc/Viewport.hpp"
 
@@ -60,6 +62,10 @@ filling in the last row, and updating the screen.
 
 #include "../renderer/inc/IRenderTarget.hpp"
 
+class TextBufferReflow;
+class TextBufferSnapshotWriter;
+class TextBufferSpill;
+
 class TextBuffer final
 {
 public:
@@ -69,7 +75,7 @@ public:
                Microsoft::Console::Render::IRenderTarget& renderTarget);
     TextBuffer(const TextBuffer& a) = delete;
 
-    ~TextBuffer() = default;
+    ~TextBuffer();
 
     // Used for duplicating properties to another text buffer
     void CopyProperties(const TextBuffer& OtherBuffer);
@@ -77,6 +83,7 @@ public:
     // row manipulation
     const ROW& GetRowByOffset(const size_t index) const;
     ROW& GetRowByOffset(const size_t index);
+    std::shared_ptr<const ROW> PinRowByOffset(const SHORT index) const;
 
     TextBufferCellIterator GetCellDataAt(const COORD at) const;
     TextBufferCellIterator GetCellLineDataAt(const COORD at) const;
@@ -96,6 +103,15 @@ public:
                                  const bool setWrap = false,
                                  const std::optional<size_t> limitRight = std::nullopt);
 
+    size_t WriteNarrowLine(const std::wstring_view text,
+                           const TextAttribute& attr,
+                           const COORD target,
+                           const bool setWrap = false);
+
+    size_t WriteCharInfoLine(const std::basic_string_view<CHAR_INFO> cells,
+                             const COORD target,
+                             const bool setWrap = false);
+
     bool InsertCharacter(const wchar_t wch, const DbcsAttribute dbcsAttribute, const TextAttribute attr);
     bool InsertCharacter(const std::wstring_view chars, const DbcsAttribute dbcsAttribute, const TextAttribute attr);
     bool IncrementCursor();
@@ -104,6 +120,16 @@ public:
     // Scroll needs access to this to quickly rotate around the buffer.
     bool IncrementCircularBuffer();
 
+    void SetScrollbackWriter(TextBufferSnapshotWriter* const writer) noexcept;
+
+    void SpillTo(const std::wstring_view path);
+    bool IsSpilling() const noexcept;
+    void SpillEncodedRow(const gsl::span<const BYTE> encoded, const RowEncoding::AttributeDictionary& attrs);
+    size_t GetSpilledRowCount() const noexcept;
+    void ReadSpilledRow(const size_t index, const std::function<void(const ROW& row)>& read) const;
+    void SetSpillBase(const std::optional<size_t> base) noexcept;
+    size_t GetSpillBase() const noexcept;
+
     COORD GetLastNonSpaceCharacter() const;
 
     Cursor& GetCursor();
@@ -112,43 +138,58 @@ public:
     const SHORT GetFirstRowIndex() const;
 
     const Microsoft::Console::Types::Viewport GetSize() const;
+    const Microsoft::Console::Types::Viewport GetSizeWithSpill() const;
 
     void ScrollRows(const SHORT firstRow, const SHORT size, const SHORT delta);
 
     UINT TotalRowCount() const;
 
+    uint64_t GetGeneration() const noexcept;
+    std::vector<size_t> GetRowsChangedSince(const uint64_t generation) const;
+    uint64_t GetAllRowsChangedGeneration() const noexcept;
+    uint64_t GetScrolledRowCount() const noexcept;
+
     [[nodiscard]]
     TextAttribute GetCurrentAttributes() const noexcept;
 
     void SetCurrentAttributes(const TextAttribute currentAttributes) noexcept;
 
+    void ReplaceAttributes(const TextAttribute& from, const TextAttribute& to);
+
     void Reset();
 
     [[nodiscard]]
     HRESULT ResizeTraditional(const COORD newSize) noexcept;
 
+    [[nodiscard]]
+    HRESULT ResizeWithReflow(const COORD newSize) noexcept;
+
     const UnicodeStorage& GetUnicodeStorage() const;
     UnicodeStorage& GetUnicodeStorage();
 
+    const TextAttributeTable& GetAttributeTable() const noexcept;
+    TextAttributeTable& GetAttributeTable() noexcept;
+
     Microsoft::Console::Render::IRenderTarget& GetRenderTarget();
 
-    class TextAndColor
-    {
-    public:
-        std::vector<std::wstring> text;
-        std::vector<std::vector<COLORREF>> FgAttr;
-        std::vector<std::vector<COLORREF>> BkAttr;
-    };
+private:
 
-    const TextAndColor GetTextForClipboard(const bool lineSelection,
-                                           const bool trimTrailingWhitespace,
-                                           const std::vector<SMALL_RECT>& selectionRects,
-                                           std::function<COLORREF(TextAttribute&)> GetForegroundColor,
-                                           std::function<COLORREF(TextAttribute&)> GetBackgroundColor) const;
+    // every distinct attribute in the buffer. Rows refer to it, so it has to
+    // be constructed before and destroyed after them.
+    TextAttributeTable _attributeTable;
 
-private:
+    // counts changes to the buffer. Rows take the next value when they
+    // change, so they have to be constructed after it.
+    uint64_t _generation;
+    // the generation at which every row last changed at once, like when
+    // the buffer reflows
+    uint64_t _allRowsChangedGeneration;
+    // how many rows have left the top of the buffer
+    uint64_t _scrolledRowCount;
 
     std::deque<ROW> _storage;
+    // the reflow in progress, if any. It holds rows outside of _storage.
+    const TextBufferReflow* _reflow;
     Cursor _cursor;
 
     SHORT _firstRow; // indexes top row (not necessarily 0)
@@ -162,8 +203,17 @@ private:
 
     Microsoft::Console::Render::IRenderTarget& _renderTarget;
 
+    // if set, gets every row that scrolls out of the top of the buffer
+    TextBufferSnapshotWriter* _scrollbackWriter;
+    // if set, keeps the rows that scroll out of the top of the buffer on disk
+    std::unique_ptr<TextBufferSpill> _spill;
+    // the spilled row right below the one at offset -1, if a host set it
+    std::optional<size_t> _spillBase;
+
     void _SetFirstRowIndex(const SHORT FirstRowIndex);
 
+    void _SaveScrolledOutRow(const ROW& row) noexcept;
+
     COORD _GetPreviousFromCursor() const;
 
     void _SetWrapOnCurrentRow();
@@ -171,6 +221,9 @@ private:
 
     void _NotifyPaint(const Microsoft::Console::Types::Viewport& viewport) const;
 
+    uint64_t _NextGeneration() noexcept;
+    void _MarkAllRowsChanged() noexcept;
+
     // Assist with maintaining proper buffer state for Double Byte character sequences
     bool _PrepareForDoubleByteSequence(const DbcsAttribute dbcsAttribute);
     bool _AssertValidDoubleByteSequence(const DbcsAttribute dbcsAttribute);
@@ -178,6 +231,9 @@ private:
     ROW& _GetFirstRow();
     ROW& _GetPrevRowNoWrap(const ROW& row);
 
+    friend class ROW;
+    friend class TextBufferReflow;
+
 #ifdef UNIT_TESTING
     friend class TextBufferTests;
     friend class UiaTextRangeTests;
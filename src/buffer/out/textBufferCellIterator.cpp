@@ -29,7 +29,8 @@ TextBufferCellIterator::TextBufferCellIterator(const TextBuffer& buffer, COORD p
 // Arguments:
 // - buffer - Pointer to screen buffer to seek through
 // - pos - Starting position to retrieve text data from (within screen buffer bounds)
-// - limits - Viewport limits to restrict the iterator within the buffer bounds (smaller than the buffer itself)
+// - limits - Viewport limits to restrict the iterator within the buffer bounds (smaller than the buffer itself).
+//   They can reach up into the spilled rows above the buffer; see TextBuffer::GetSizeWithSpill.
 TextBufferCellIterator::TextBufferCellIterator(const TextBuffer& buffer, COORD pos, const Viewport limits) :
     _buffer(buffer),
     _pos(pos),
@@ -37,10 +38,10 @@ TextBufferCellIterator::TextBufferCellIterator(const TextBuffer& buffer, COORD p
     _bounds(limits),
     _exceeded(false),
     _view({}, {}, {}, TextAttributeBehavior::Stored),
-    _attrIter(s_GetRow(buffer, pos)->GetAttrRow().cbegin())
+    _attrIter(_pRow->GetAttrRow().cbegin())
 {
     // Throw if the bounds rectangle is not limited to the inside of the given buffer.
-    THROW_HR_IF(E_INVALIDARG, !buffer.GetSize().IsInBounds(limits));
+    THROW_HR_IF(E_INVALIDARG, !buffer.GetSizeWithSpill().IsInBounds(limits));
 
     // Throw if the coordinate is not limited to the inside of the given buffer.
     THROW_HR_IF(E_INVALIDARG, !limits.IsInBounds(pos));
@@ -228,10 +229,10 @@ void TextBufferCellIterator::_SetPos(const COORD newPos)
 // - buffer - Screen information pointer to pull text buffer data from
 // - pos - Position inside screen buffer bounds to retrieve row
 // Return Value:
-// - Pointer to the underlying CharRow structure
-const ROW* TextBufferCellIterator::s_GetRow(const TextBuffer& buffer, const COORD pos)
+// - Pointer to the underlying CharRow structure. Spilled rows are pinned by it.
+std::shared_ptr<const ROW> TextBufferCellIterator::s_GetRow(const TextBuffer& buffer, const COORD pos)
 {
-    return &buffer.GetRowByOffset(pos.Y);
+    return buffer.PinRowByOffset(pos.Y);
 }
 
 // Routine Description:
@@ -265,3 +266,16 @@ const OutputCellView* TextBufferCellIterator::operator->() const noexcept
 {
     return &_view;
 }
+
+// Routine Description:
+// - Gets the id of the current cell's attribute in the buffer's attribute table.
+//   Comparing ids is cheaper than comparing attributes when looking for where
+//   a run of one color ends.
+// Arguments:
+// - <none> - Uses current position
+// Return Value:
+// - The id of the attribute of the current cell.
+TextAttributeTable::Id TextBufferCellIterator::GetAttrId() const
+{
+    return _attrIter.GetAttrId();
+}
@@ -49,15 +49,18 @@ public:
     const OutputCellView& operator*() const noexcept;
     const OutputCellView* operator->() const noexcept;
 
+    TextAttributeTable::Id GetAttrId() const;
+
 protected:
 
     void _SetPos(const COORD newPos);
     void _GenerateView();
-    static const ROW* s_GetRow(const TextBuffer& buffer, const COORD pos);
+    static std::shared_ptr<const ROW> s_GetRow(const TextBuffer& buffer, const COORD pos);
 
     OutputCellView _view;
 
-    const ROW* _pRow;
+    // pins the row if it's a spilled one
+    std::shared_ptr<const ROW> _pRow;
     AttrRowIterator _attrIter;
     const TextBuffer& _buffer;
     const Microsoft::Console::Types::Viewport _bounds;
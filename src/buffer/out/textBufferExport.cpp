@@ -0,0 +1,474 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "textBufferExport.hpp"
+#include "CharRow.hpp"
+
+namespace
+{
+    // Looks up the colors of a run, reusing the last answer for as long as the
+    // attributes repeat. They usually do for long stretches of a selection.
+    class ColorCache final
+    {
+    public:
+        ColorCache(const TextBufferExport::ColorFn& getForegroundColor,
+                   const TextBufferExport::ColorFn& getBackgroundColor) noexcept :
+            _getForegroundColor(getForegroundColor),
+            _getBackgroundColor(getBackgroundColor),
+            _colors{ 0, 0 }
+        {
+        }
+
+        std::pair<COLORREF, COLORREF> Resolve(const TextAttribute& attr)
+        {
+            if (!_attr.has_value() || _attr.value() != attr)
+            {
+                TextAttribute lookup = attr;
+                _colors = { _getForegroundColor(lookup), _getBackgroundColor(lookup) };
+                _attr = attr;
+            }
+            return _colors;
+        }
+
+    private:
+        const TextBufferExport::ColorFn& _getForegroundColor;
+        const TextBufferExport::ColorFn& _getBackgroundColor;
+        std::optional<TextAttribute> _attr;
+        std::pair<COLORREF, COLORREF> _colors;
+    };
+}
+
+// Routine Description:
+// - Prepares to export the given selection of a buffer.
+// Arguments:
+// - buffer - the buffer holding the selected text
+// - selectionRects - one rectangle per selected row, top to bottom
+// - lineSelection - true if entire lines are selected. False for a box selection.
+// - trimTrailingWhitespace - drop the spaces at the end of each row and end each
+//   row with CR/LF. The rows of a line selection that wrapped are left whole.
+TextBufferExport::TextBufferExport(const TextBuffer& buffer,
+                                   std::vector<SMALL_RECT> selectionRects,
+                                   const bool lineSelection,
+                                   const bool trimTrailingWhitespace) :
+    _buffer(buffer),
+    _selectionRects(std::move(selectionRects)),
+    _lineSelection(lineSelection),
+    _trimTrailingWhitespace(trimTrailingWhitespace)
+{
+}
+
+// Routine Description:
+// - Writes the selection as plain text.
+// Return Value:
+// - The selected text, with rows separated by CR/LF where they end a line.
+std::wstring TextBufferExport::Text() const
+{
+    std::wstring text;
+    text.reserve(_EstimateCells());
+
+    const auto appendRun = [&](const TextAttribute& /*attr*/, const std::wstring_view run) {
+        text.append(run);
+    };
+    const auto appendLineBreak = [&]() {
+        text.append(L"\r\n");
+    };
+    _ForEachRun(appendRun, appendLineBreak);
+
+    return text;
+}
+
+// Routine Description:
+// - Writes the selection as a CF_HTML document, with a span for each change
+//   of color.
+// Arguments:
+// - getForegroundColor - maps attributes to the color of the text
+// - getBackgroundColor - maps attributes to the color behind the text
+// - fontHeightPoints - the size of the font the text is drawn with
+// - fontFaceName - the name of that font, or empty to leave it to the reader
+// Return Value:
+// - The UTF-8 CF_HTML data, or an empty string if nothing is selected.
+std::string TextBufferExport::Html(const ColorFn& getForegroundColor,
+                                   const ColorFn& getBackgroundColor,
+                                   const int fontHeightPoints,
+                                   const std::wstring_view fontFaceName) const
+{
+    std::string html;
+    if (_selectionRects.empty())
+    {
+        return html;
+    }
+
+    // CF_HTML starts with a header of byte offsets into the data that follows.
+    // It's always this long once the offsets are filled in, so leave room for
+    // it now and fill it in at the end.
+    constexpr size_t cbHeader = 157;
+
+    // Most cells take a byte or two of UTF-8. Leave some room for markup too.
+    html.reserve(cbHeader + 512 + _EstimateCells() * 2);
+    html.append(cbHeader, 'H');
+    html.append("<!DOCTYPE><HTML><HEAD><TITLE>Windows Console Host</TITLE></HEAD><BODY>");
+    const size_t fragmentStart = html.size();
+    html.append("<!--StartFragment -->");
+
+    ColorCache colors{ getForegroundColor, getBackgroundColor };
+
+    // The whole selection sits on the background of its first cell.
+    const auto& first = _selectionRects.front();
+    const auto firstAttr = _buffer.PinRowByOffset(first.Top)->GetAttrRow().GetAttrByColumn(first.Left);
+    html.append(R"X(<DIV STYLE="background-color:)X");
+    _AppendHexColor(html, colors.Resolve(firstAttr).second);
+    html.append(R"X(;white-space:pre;">)X");
+
+    html.append(R"X(<SPAN STYLE="font-family: )X");
+    if (!fontFaceName.empty())
+    {
+        html.push_back('\'');
+        _AppendUtf8(html, fontFaceName, true);
+        html.append("', ");
+    }
+    html.append(R"X(monospace">)X");
+
+    html.append(R"X(<SPAN STYLE="font-size: )X");
+    html.append(std::to_string(fontHeightPoints));
+    html.append(R"X(pt">)X");
+
+    bool spanOpen = false;
+    std::pair<COLORREF, COLORREF> spanColors{ 0, 0 };
+    const auto appendRun = [&](const TextAttribute& attr, const std::wstring_view run) {
+        const auto runColors = colors.Resolve(attr);
+        if (!spanOpen || runColors != spanColors)
+        {
+            if (spanOpen)
+            {
+                html.append("</SPAN>");
+            }
+            html.append(R"X(<SPAN STYLE="color:)X");
+            _AppendHexColor(html, runColors.first);
+            html.append(";background-color:");
+            _AppendHexColor(html, runColors.second);
+            html.append(R"X(">)X");
+
+            spanOpen = true;
+            spanColors = runColors;
+        }
+        _AppendUtf8(html, run, true);
+    };
+    const auto appendLineBreak = [&]() {
+        html.append("\r\n");
+    };
+    _ForEachRun(appendRun, appendLineBreak);
+
+    if (spanOpen)
+    {
+        html.append("</SPAN>");
+    }
+
+    // Close the font size span, the font face span and the background.
+    html.append("</SPAN></SPAN></DIV>");
+    html.append("<!--EndFragment -->");
+    const size_t fragmentEnd = html.size();
+    html.append("</BODY></HTML>");
+    const size_t htmlEnd = html.size();
+
+    char header[cbHeader + 1];
+    sprintf_s(header,
+              ARRAYSIZE(header),
+              "Version:0.9\r\n"
+              "StartHTML:%010zu\r\n"
+              "EndHTML:%010zu\r\n"
+              "StartFragment:%010zu\r\n"
+              "EndFragment:%010zu\r\n"
+              "StartSelection:%010zu\r\n"
+              "EndSelection:%010zu\r\n",
+              cbHeader,
+              htmlEnd,
+              fragmentStart,
+              fragmentEnd,
+              fragmentStart,
+              fragmentEnd);
+    html.replace(0, cbHeader, header, cbHeader);
+
+    return html;
+}
+
+// Routine Description:
+// - Writes the selection as an RTF document, with a color change for each
+//   change of color.
+// Arguments:
+// - getForegroundColor - maps attributes to the color of the text
+// - getBackgroundColor - maps attributes to the color behind the text
+// - fontHeightPoints - the size of the font the text is drawn with
+// - fontFaceName - the name of that font, or empty for a generic monospace font
+// Return Value:
+// - The RTF data, or an empty string if nothing is selected.
+std::string TextBufferExport::Rtf(const ColorFn& getForegroundColor,
+                                  const ColorFn& getBackgroundColor,
+                                  const int fontHeightPoints,
+                                  const std::wstring_view fontFaceName) const
+{
+    std::string rtf;
+    if (_selectionRects.empty())
+    {
+        return rtf;
+    }
+
+    ColorCache colors{ getForegroundColor, getBackgroundColor };
+
+    // The color table goes in the header, but it isn't known until every run
+    // has been seen. Write the body first and put the header in front of it.
+    std::vector<COLORREF> colorTable;
+    std::unordered_map<COLORREF, size_t> colorIndices;
+    const auto indexOf = [&](const COLORREF color) {
+        // Index 0 is the reader's default color, so the table starts at 1.
+        const auto emplaced = colorIndices.emplace(color, colorTable.size() + 1);
+        if (emplaced.second)
+        {
+            colorTable.push_back(color);
+        }
+        return std::to_string(emplaced.first->second);
+    };
+
+    rtf.reserve(512 + _EstimateCells() * 2);
+    rtf.append("\\f0\\fs");
+    rtf.append(std::to_string(fontHeightPoints * 2));
+    rtf.push_back(' ');
+
+    bool colored = false;
+    std::pair<COLORREF, COLORREF> currentColors{ 0, 0 };
+    const auto appendRun = [&](const TextAttribute& attr, const std::wstring_view run) {
+        const auto runColors = colors.Resolve(attr);
+        if (!colored || runColors != currentColors)
+        {
+            const auto foreground = indexOf(runColors.first);
+            const auto background = indexOf(runColors.second);
+            rtf.append("\\cf");
+            rtf.append(foreground);
+            rtf.append("\\chshdng0\\chcbpat");
+            rtf.append(background);
+            rtf.append("\\cb");
+            rtf.append(background);
+            rtf.push_back(' ');
+
+            colored = true;
+            currentColors = runColors;
+        }
+        _AppendRtfText(rtf, run);
+    };
+    const auto appendLineBreak = [&]() {
+        rtf.append("\\line ");
+    };
+    _ForEachRun(appendRun, appendLineBreak);
+
+    rtf.push_back('}');
+
+    std::string header;
+    header.reserve(128 + colorTable.size() * 32);
+    header.append("{\\rtf1\\ansi\\ansicpg1252\\deff0{\\fonttbl{\\f0\\fmodern\\fprq1\\fcharset0 ");
+    _AppendRtfText(header, fontFaceName.empty() ? L"Courier New" : fontFaceName);
+    header.append(";}}{\\colortbl ;");
+    for (const auto color : colorTable)
+    {
+        header.append("\\red");
+        header.append(std::to_string(GetRValue(color)));
+        header.append("\\green");
+        header.append(std::to_string(GetGValue(color)));
+        header.append("\\blue");
+        header.append(std::to_string(GetBValue(color)));
+        header.push_back(';');
+    }
+    header.push_back('}');
+
+    rtf.insert(0, header);
+
+    return rtf;
+}
+
+// Routine Description:
+// - Walks the selection one attribute run at a time.
+// - Trailing spaces are left out when trimming. The second half of a wide
+//   glyph is skipped, as its text is the same as the first half's.
+// Arguments:
+// - onRun - called with the attributes and text of each non-empty run
+// - onLineBreak - called between two rows where a line ends
+template<typename RunFn, typename LineBreakFn>
+void TextBufferExport::_ForEachRun(RunFn onRun, LineBreakFn onLineBreak) const
+{
+    std::wstring run;
+
+    for (size_t i = 0; i < _selectionRects.size(); ++i)
+    {
+        const auto& rect = _selectionRects.at(i);
+        // The selection can reach up into the spilled rows.
+        const auto pinned = _buffer.PinRowByOffset(rect.Top);
+        const ROW& row = *pinned;
+        const CharRow& charRow = row.GetCharRow();
+        const ATTR_ROW& attrRow = row.GetAttrRow();
+
+        // In a line selection, a row that wrapped runs on into the next one.
+        // Its trailing spaces are part of the text and it gets no line break.
+        const bool endsLine = !_lineSelection || !charRow.WasWrapForced();
+
+        const size_t left = rect.Left;
+        size_t right = std::min(static_cast<size_t>(rect.Right) + 1, charRow.size());
+        if (_trimTrailingWhitespace && endsLine)
+        {
+            while (right > left && std::wstring_view{ charRow.GlyphAt(right - 1) } == L" ")
+            {
+                --right;
+            }
+        }
+
+        size_t column = left;
+        while (column < right)
+        {
+            size_t applies = 0;
+            const auto attr = attrRow.GetAttrByColumn(column, &applies);
+            const size_t runEnd = std::min(right, column + applies);
+
+            run.clear();
+            for (; column < runEnd; ++column)
+            {
+                if (!charRow.DbcsAttrAt(column).IsTrailing())
+                {
+                    const std::wstring_view glyph = charRow.GlyphAt(column);
+                    run.append(glyph);
+                }
+            }
+
+            if (!run.empty())
+            {
+                onRun(attr, std::wstring_view{ run });
+            }
+        }
+
+        if (_trimTrailingWhitespace && endsLine && i + 1 < _selectionRects.size())
+        {
+            onLineBreak();
+        }
+    }
+}
+
+// Routine Description:
+// - Counts the cells in the selection, plus a line break per row. Used to size
+//   the output up front.
+size_t TextBufferExport::_EstimateCells() const noexcept
+{
+    size_t cells = 0;
+    for (const auto& rect : _selectionRects)
+    {
+        cells += static_cast<size_t>(std::max(0, rect.Right - rect.Left + 1)) + 2;
+    }
+    return cells;
+}
+
+// Routine Description:
+// - Appends UTF-16 text as UTF-8, optionally escaping the characters that
+//   would otherwise be read as HTML markup.
+// Arguments:
+// - out - the string to append to
+// - text - the text to append. An unpaired surrogate becomes U+FFFD.
+// - escapeHtml - whether to escape &, < and >
+void TextBufferExport::_AppendUtf8(std::string& out, const std::wstring_view text, const bool escapeHtml)
+{
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        const wchar_t wch = text[i];
+        if (wch < 0x80)
+        {
+            if (escapeHtml && wch == L'&')
+            {
+                out.append("&amp;");
+            }
+            else if (escapeHtml && wch == L'<')
+            {
+                out.append("&lt;");
+            }
+            else if (escapeHtml && wch == L'>')
+            {
+                out.append("&gt;");
+            }
+            else
+            {
+                out.push_back(static_cast<char>(wch));
+            }
+            continue;
+        }
+
+        char32_t codepoint = wch;
+        if (wch >= 0xD800 && wch <= 0xDBFF && i + 1 < text.size() && text[i + 1] >= 0xDC00 && text[i + 1] <= 0xDFFF)
+        {
+            codepoint = 0x10000 + ((wch - 0xD800) << 10) + (text[i + 1] - 0xDC00);
+            ++i;
+        }
+        else if (wch >= 0xD800 && wch <= 0xDFFF)
+        {
+            codepoint = 0xFFFD;
+        }
+
+        if (codepoint < 0x800)
+        {
+            out.push_back(static_cast<char>(0xC0 | (codepoint >> 6)));
+        }
+        else if (codepoint < 0x10000)
+        {
+            out.push_back(static_cast<char>(0xE0 | (codepoint >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        }
+        else
+        {
+            out.push_back(static_cast<char>(0xF0 | (codepoint >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F)));
+        }
+        out.push_back(static_cast<char>(0x80 | (codepoint & 0x3F)));
+    }
+}
+
+// Routine Description:
+// - Appends text to an RTF document. RTF's special characters are escaped and
+//   anything outside of printable ASCII is written as a \u control word.
+// Arguments:
+// - out - the string to append to
+// - text - the text to append
+void TextBufferExport::_AppendRtfText(std::string& out, const std::wstring_view text)
+{
+    for (const wchar_t wch : text)
+    {
+        if (wch == L'\\' || wch == L'{' || wch == L'}')
+        {
+            out.push_back('\\');
+            out.push_back(static_cast<char>(wch));
+        }
+        else if (wch == L'\t')
+        {
+            out.append("\\tab ");
+        }
+        else if (wch >= 0x20 && wch < 0x80)
+        {
+            out.push_back(static_cast<char>(wch));
+        }
+        else
+        {
+            // \u takes a signed 16-bit value, followed by a fallback character
+            // for readers that don't understand it.
+            out.append("\\u");
+            out.append(std::to_string(static_cast<short>(wch)));
+            out.push_back('?');
+        }
+    }
+}
+
+// Routine Description:
+// - Appends a color as an HTML hex triplet, such as #ff8000.
+void TextBufferExport::_AppendHexColor(std::string& out, const COLORREF color)
+{
+    static constexpr char digits[] = "0123456789abcdef";
+    out.push_back('#');
+    for (const BYTE channel : { GetRValue(color), GetGValue(color), GetBValue(color) })
+    {
+        out.push_back(digits[channel >> 4]);
+        out.push_back(digits[channel & 0xF]);
+    }
+}
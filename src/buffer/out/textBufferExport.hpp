@@ -0,0 +1,62 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- textBufferExport.hpp
+
+Abstract:
+- Turns a selection of a text buffer into clipboard formats: plain text,
+  CF_HTML and RTF.
+- Each format is written in a single pass straight into the string that is
+  returned. Nothing is kept per cell: the selection is walked one attribute
+  run at a time, and the colors of a run are only looked up when its
+  attributes differ from the run before it.
+- The buffer must not change while an export is being written. The caller is
+  expected to hold the console lock.
+--*/
+
+#pragma once
+
+#include "textBuffer.hpp"
+
+#include <functional>
+
+class TextBufferExport final
+{
+public:
+    // Maps the attributes of a run to the RGB color it's drawn with.
+    using ColorFn = std::function<COLORREF(TextAttribute&)>;
+
+    TextBufferExport(const TextBuffer& buffer,
+                     std::vector<SMALL_RECT> selectionRects,
+                     const bool lineSelection,
+                     const bool trimTrailingWhitespace);
+
+    std::wstring Text() const;
+
+    std::string Html(const ColorFn& getForegroundColor,
+                     const ColorFn& getBackgroundColor,
+                     const int fontHeightPoints,
+                     const std::wstring_view fontFaceName) const;
+
+    std::string Rtf(const ColorFn& getForegroundColor,
+                    const ColorFn& getBackgroundColor,
+                    const int fontHeightPoints,
+                    const std::wstring_view fontFaceName) const;
+
+private:
+    const TextBuffer& _buffer;
+    const std::vector<SMALL_RECT> _selectionRects;
+    const bool _lineSelection;
+    const bool _trimTrailingWhitespace;
+
+    template<typename RunFn, typename LineBreakFn>
+    void _ForEachRun(RunFn onRun, LineBreakFn onLineBreak) const;
+
+    size_t _EstimateCells() const noexcept;
+
+    static void _AppendUtf8(std::string& out, const std::wstring_view text, const bool escapeHtml);
+    static void _AppendRtfText(std::string& out, const std::wstring_view text);
+    static void _AppendHexColor(std::string& out, const COLORREF color);
+};
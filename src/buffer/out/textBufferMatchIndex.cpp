@@ -0,0 +1,286 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "textBufferMatchIndex.hpp"
+
+// Routine Description:
+// - Creates an empty index. Nothing is searched until a query is set.
+// Arguments:
+// - buffer - the text to index matches in
+// - caseInsensitive - whether or not to ignore case when comparing
+TextBufferMatchIndex::TextBufferMatchIndex(const TextBuffer& buffer, const bool caseInsensitive) :
+    _buffer(buffer),
+    _caseInsensitive(caseInsensitive),
+    _anyDirty(false),
+    _count(0)
+{
+}
+
+// Routine Description:
+// - Changes what the index is looking for and brings it up to date.
+// - If the new query is the old one with more characters on the end, only the
+//   old matches are checked. Otherwise the whole buffer is searched again.
+// Arguments:
+// - query - the text to find. An empty query matches nothing.
+void TextBufferMatchIndex::SetQuery(const std::wstring_view query)
+{
+    if (query == _query)
+    {
+        return;
+    }
+
+    // A lone high surrogate at the end of the old query becomes part of a
+    // different glyph once its low surrogate is typed, so that doesn't count
+    // as simply extending it.
+    const auto narrows = _searcher.has_value() &&
+                         _IsSizedForBuffer() &&
+                         query.size() > _query.size() &&
+                         query.substr(0, _query.size()) == _query &&
+                         !IS_HIGH_SURROGATE(_query.back());
+
+    _query = query;
+    if (_query.empty())
+    {
+        _searcher.reset();
+        _rows.clear();
+        _dirtyRows.clear();
+        _anyDirty = false;
+        _count = 0;
+        return;
+    }
+
+    _searcher.emplace(_buffer, _query, _caseInsensitive);
+    if (narrows)
+    {
+        _Narrow();
+        Refresh();
+    }
+    else
+    {
+        _Rebuild();
+    }
+}
+
+// Routine Description:
+// - Notes that the text of some rows has changed. They're searched again by
+//   the next call to Refresh.
+// Arguments:
+// - firstRow - the first changed row, counted from the top of the buffer
+// - lastRow - the last changed row, inclusive
+void TextBufferMatchIndex::InvalidateRows(const size_t firstRow, const size_t lastRow)
+{
+    if (!_IsSizedForBuffer())
+    {
+        // Refresh is going to start from scratch anyway.
+        _anyDirty = true;
+        return;
+    }
+
+    const auto height = _rows.size();
+    for (auto row = firstRow; row <= lastRow && row < height; ++row)
+    {
+        _dirtyRows[_StorageIndex(row)] = true;
+        _anyDirty = true;
+    }
+}
+
+// Routine Description:
+// - Searches the rows that were invalidated since the last refresh. A match
+//   may run from one row into the next, so the rows just above a changed row
+//   are searched again too.
+void TextBufferMatchIndex::Refresh()
+{
+    if (!_anyDirty)
+    {
+        return;
+    }
+
+    if (!_searcher.has_value())
+    {
+        std::fill(_dirtyRows.begin(), _dirtyRows.end(), false);
+        _anyDirty = false;
+        return;
+    }
+
+    if (!_IsSizedForBuffer())
+    {
+        _Rebuild();
+        return;
+    }
+
+    const size_t width = _buffer.GetSize().Width();
+    const auto spillRows = (_searcher->NeedleCells() - 1 + width - 1) / width;
+    const auto height = _rows.size();
+
+    std::vector<bool> rescan(height, false);
+    for (size_t row = 0; row < height; ++row)
+    {
+        if (_dirtyRows[_StorageIndex(row)])
+        {
+            for (auto above = row - std::min(row, spillRows); above <= row; ++above)
+            {
+                rescan[above] = true;
+            }
+        }
+    }
+
+    std::vector<COORD> starts;
+    for (size_t row = 0; row < height;)
+    {
+        if (!rescan[row])
+        {
+            ++row;
+            continue;
+        }
+
+        auto end = row;
+        while (end < height && rescan[end])
+        {
+            auto& matches = _rows[_StorageIndex(end)];
+            _count -= matches.size();
+            matches.clear();
+            ++end;
+        }
+
+        starts.clear();
+        _searcher->FindAllInRows(row, end - row, starts);
+        _StoreMatches(starts);
+        row = end;
+    }
+
+    std::fill(_dirtyRows.begin(), _dirtyRows.end(), false);
+    _anyDirty = false;
+}
+
+// Routine Description:
+// - The total number of matches in the buffer.
+size_t TextBufferMatchIndex::Count() const noexcept
+{
+    return _count;
+}
+
+// Routine Description:
+// - The number of cells each match covers.
+size_t TextBufferMatchIndex::NeedleCells() const noexcept
+{
+    return _searcher.has_value() ? _searcher->NeedleCells() : 0;
+}
+
+// Routine Description:
+// - Gets the columns at which matches start in the given row.
+// Arguments:
+// - row - the row, counted from the top of the buffer
+// Return Value:
+// - The start columns, left to right.
+const std::vector<SHORT>& TextBufferMatchIndex::MatchesInRow(const size_t row) const
+{
+    static const std::vector<SHORT> s_none;
+    if (!_IsSizedForBuffer() || row >= _rows.size())
+    {
+        return s_none;
+    }
+    return _rows[_StorageIndex(row)];
+}
+
+// Routine Description:
+// - Gets the extent of every match, in buffer order.
+// Return Value:
+// - The first and last cell of each match.
+std::vector<std::pair<COORD, COORD>> TextBufferMatchIndex::GetMatches() const
+{
+    std::vector<std::pair<COORD, COORD>> matches;
+    if (!_IsSizedForBuffer())
+    {
+        return matches;
+    }
+
+    matches.reserve(_count);
+    const size_t width = _buffer.GetSize().Width();
+    const auto cells = NeedleCells();
+    for (size_t row = 0; row < _rows.size(); ++row)
+    {
+        for (const auto column : _rows[_StorageIndex(row)])
+        {
+            const auto last = row * width + column + cells - 1;
+            matches.emplace_back(COORD{ column, static_cast<SHORT>(row) },
+                                 COORD{ static_cast<SHORT>(last % width), static_cast<SHORT>(last / width) });
+        }
+    }
+    return matches;
+}
+
+// Routine Description:
+// - Converts a row's offset from the top of the buffer into its position in
+//   the buffer's circular storage, which stays put as the buffer scrolls.
+size_t TextBufferMatchIndex::_StorageIndex(const size_t row) const noexcept
+{
+    return (_buffer.GetFirstRowIndex() + row) % _rows.size();
+}
+
+// Routine Description:
+// - Whether the index still has one entry per row of the buffer. It won't
+//   after the buffer is resized.
+bool TextBufferMatchIndex::_IsSizedForBuffer() const noexcept
+{
+    return !_rows.empty() && _rows.size() == static_cast<size_t>(_buffer.GetSize().Height());
+}
+
+// Routine Description:
+// - Collects the start of every match in the index, in buffer order.
+std::vector<COORD> TextBufferMatchIndex::_GatherMatches() const
+{
+    std::vector<COORD> starts;
+    starts.reserve(_count);
+    for (size_t row = 0; row < _rows.size(); ++row)
+    {
+        for (const auto column : _rows[_StorageIndex(row)])
+        {
+            starts.push_back({ column, static_cast<SHORT>(row) });
+        }
+    }
+    return starts;
+}
+
+// Routine Description:
+// - Files matches under the rows they start in. The rows must have been
+//   emptied first.
+void TextBufferMatchIndex::_StoreMatches(const std::vector<COORD>& starts)
+{
+    for (const auto start : starts)
+    {
+        _rows[_StorageIndex(start.Y)].push_back(start.X);
+    }
+    _count += starts.size();
+}
+
+// Routine Description:
+// - Throws everything away and searches the whole buffer.
+void TextBufferMatchIndex::_Rebuild()
+{
+    const size_t height = _buffer.GetSize().Height();
+    _rows.assign(height, {});
+    _dirtyRows.assign(height, false);
+    _anyDirty = false;
+    _count = 0;
+
+    std::vector<COORD> starts;
+    _searcher->FindAllInRows(0, height, starts);
+    _StoreMatches(starts);
+}
+
+// Routine Description:
+// - Keeps only the existing matches that still match the (longer) query.
+void TextBufferMatchIndex::_Narrow()
+{
+    auto starts = _GatherMatches();
+    _searcher->KeepMatches(starts);
+
+    for (auto& row : _rows)
+    {
+        row.clear();
+    }
+    _count = 0;
+    _StoreMatches(starts);
+}
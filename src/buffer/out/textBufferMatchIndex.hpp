@@ -0,0 +1,58 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- textBufferMatchIndex.hpp
+
+Abstract:
+- Keeps track of every match of a query in a text buffer, row by row, so that
+  all of them can be highlighted while the query is being typed.
+- The index is kept up to date incrementally:
+  - When the query grows by a character, only the existing matches are
+    checked again. Nothing else can have become a match.
+  - When output changes some rows, the owner invalidates them and only those
+    rows (and the rows above whose matches could run into them) are searched
+    again on the next Refresh.
+- Matches are filed under the row they start in, keyed by the row's position
+  in the buffer's circular storage, so scrolling the buffer doesn't move them.
+--*/
+
+#pragma once
+
+#include "textBufferSearch.hpp"
+
+class TextBufferMatchIndex final
+{
+public:
+    TextBufferMatchIndex(const TextBuffer& buffer, const bool caseInsensitive);
+
+    void SetQuery(const std::wstring_view query);
+    void InvalidateRows(const size_t firstRow, const size_t lastRow);
+    void Refresh();
+
+    size_t Count() const noexcept;
+    size_t NeedleCells() const noexcept;
+    const std::vector<SHORT>& MatchesInRow(const size_t row) const;
+    std::vector<std::pair<COORD, COORD>> GetMatches() const;
+
+private:
+    const TextBuffer& _buffer;
+    const bool _caseInsensitive;
+    std::wstring _query;
+    std::optional<TextBufferSearch> _searcher;
+
+    // The start columns of the matches beginning in each row, indexed by storage position.
+    std::vector<std::vector<SHORT>> _rows;
+    std::vector<bool> _dirtyRows;
+    bool _anyDirty;
+    size_t _count;
+
+    size_t _StorageIndex(const size_t row) const noexcept;
+    bool _IsSizedForBuffer() const noexcept;
+
+    std::vector<COORD> _GatherMatches() const;
+    void _StoreMatches(const std::vector<COORD>& starts);
+    void _Rebuild();
+    void _Narrow();
+};
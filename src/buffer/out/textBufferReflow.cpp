@@ -0,0 +1,617 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "textBufferReflow.hpp"
+
+// Routine Description:
+// - Prepares to reflow a buffer. Nothing is changed until Run is called.
+// Arguments:
+// - buffer - the buffer to reflow. Its rows are taken over while Run executes.
+// - newSize - the new width and height of the buffer
+TextBufferReflow::TextBufferReflow(TextBuffer& buffer, const COORD newSize) :
+    _buffer(buffer),
+    _newSize(newSize),
+    _fillAttributes(buffer.GetCurrentAttributes()),
+    _oldFirstRow(0),
+    _oldHeight(0),
+    _oldWidth(0),
+    _lineHeld(false)
+{
+    THROW_HR_IF(E_INVALIDARG, newSize.X <= 0 || newSize.Y <= 0);
+}
+
+// Routine Description:
+// - Rewraps every line of the buffer for the new size and moves the cursor
+//   onto the same character it was on before.
+// - The rows of each line are reused for the new rows once it's copied out.
+//   If this fails, they're put back together, so the buffer is left the way
+//   it was.
+void TextBufferReflow::Run()
+{
+    const size_t newHeight = _newSize.Y;
+    const auto cursor = _buffer.GetCursor().GetPosition();
+    const size_t endRow = std::max(_buffer.GetLastNonSpaceCharacter().Y, cursor.Y) + 1;
+
+    _undoRows.reserve(_buffer._storage.size());
+
+    _oldRows.swap(_buffer._storage);
+    _oldFirstRow = _buffer._firstRow;
+    _oldHeight = _oldRows.size();
+    _oldWidth = _oldRows.front().size();
+    std::swap(_oldGlyphs, _buffer._unicodeStorage);
+
+    // Line the old rows up top row first, so the ones at the bottom can be
+    // taken off the end as they're reused. They keep their ids, which their
+    // glyphs are stored under.
+    std::rotate(_oldRows.begin(), _oldRows.begin() + _oldFirstRow, _oldRows.end());
+    for (auto& row : _oldRows)
+    {
+        _UpdateParents(row);
+    }
+
+    // Interning attributes for the new rows can make the buffer reclaim the
+    // ones no row uses. Until the reflow is done, the rows are here.
+    _buffer._reflow = this;
+    auto done = wil::scope_exit([&]() noexcept { _buffer._reflow = nullptr; });
+
+    size_t contentRows = 0;
+    std::optional<size_t> cursorRow;
+    SHORT cursorColumn = 0;
+    try
+    {
+        // The rows below the text and the cursor are blank. They're the
+        // first to be reused.
+        if (endRow < _oldRows.size())
+        {
+            _SpareOldRows(endRow, 0, true);
+        }
+
+        for (auto lineEnd = _oldRows.size(); lineEnd > 0 && contentRows < newHeight;)
+        {
+            auto lineStart = lineEnd - 1;
+            while (lineStart > 0 && _OldRow(lineStart - 1).GetCharRow().WasWrapForced())
+            {
+                --lineStart;
+            }
+
+            _lineHeld = false;
+            _CopyOutLine(lineStart, lineEnd, cursor);
+            _SplitLine();
+
+            // Only as many rows of this line as still fit in the buffer are
+            // kept. The old rows with cells that don't fit stay until they're
+            // saved; the rest are reused for the new rows, which are pushed
+            // onto the top of the layout bottom first.
+            const auto keep = std::min(_spans.size(), newHeight - contentRows);
+            const auto firstKept = _spans.size() - keep;
+            const auto dropped = _DroppedRows(lineStart, firstKept);
+            _SpareOldRows(dropped, dropped < lineEnd ? _line.rowStarts[dropped - lineStart] : _line.cells.size(), false);
+            for (auto span = _spans.size(); span > firstKept; --span)
+            {
+                _FillRow(_PushRow(), _spans[span - 1], span != _spans.size());
+            }
+            _undoLines.back().newRows = keep;
+
+            if (_line.cursor.has_value())
+            {
+                const auto offset = _line.cursor.value();
+                auto span = firstKept;
+                while (span + 1 < _spans.size() && offset >= _spans[span].end)
+                {
+                    ++span;
+                }
+
+                // If the cursor's row fell off the top of the buffer, it stays on the top row.
+                const auto column = offset >= _spans[span].begin ? offset - _spans[span].begin : 0;
+                cursorRow = contentRows + (_spans.size() - 1 - span);
+                cursorColumn = static_cast<SHORT>(std::min<size_t>(column, _newSize.X - 1));
+            }
+
+            contentRows += keep;
+            lineEnd = lineStart;
+        }
+
+        // Fill out the buffer with blank rows below the text.
+        while (_newRows.size() < newHeight)
+        {
+            _PushRow();
+        }
+
+        // The text was built up from the bottom of the storage, so the buffer
+        // starts wherever the text does and the blank rows follow on circularly.
+        _buffer._storage.swap(_newRows);
+        _buffer._firstRow = static_cast<SHORT>((newHeight - contentRows) % newHeight);
+    }
+    catch (...)
+    {
+        _Undo();
+        throw;
+    }
+
+    _buffer.GetCursor().SetPosition({ cursorColumn, static_cast<SHORT>(contentRows - 1 - cursorRow.value_or(contentRows - 1)) });
+
+    // What's left of the old rows fell off the top.
+    _SaveDroppedRows(_oldRows.size());
+    _oldRows.clear();
+    _spareRows.clear();
+}
+
+// Routine Description:
+// - Marks the attributes used by the rows the reflow holds, old and new, so
+//   the buffer doesn't reclaim them while they're out of its storage. The
+//   attributes of the spare rows don't matter anymore; they're reset before
+//   they're used again.
+// Arguments:
+// - live - the flags of the attribute table's ids
+void TextBufferReflow::MarkLiveAttributes(std::vector<bool>& live) const
+{
+    for (const auto& row : _oldRows)
+    {
+        row.GetAttrRow().MarkLiveAttributes(live);
+    }
+    for (const auto& row : _newRows)
+    {
+        row.GetAttrRow().MarkLiveAttributes(live);
+    }
+}
+
+// Routine Description:
+// - Gets a row of the buffer as it was before the reflow.
+// Arguments:
+// - row - the offset of the row from the top of the old buffer
+ROW& TextBufferReflow::_OldRow(const size_t row)
+{
+    return _oldRows[row];
+}
+
+// Routine Description:
+// - Copies a logical line out of the old rows.
+// - Rows that wrapped contribute every cell but the padding left by a wide
+//   glyph that didn't fit. The last row contributes the cells up to its last
+//   character, or up to the cursor if that's further along.
+// Arguments:
+// - firstRow - the first row of the line
+// - endRow - one past its last row
+// - cursor - where the cursor was in the old buffer
+void TextBufferReflow::_CopyOutLine(const size_t firstRow, const size_t endRow, const COORD cursor)
+{
+    _line.cells.clear();
+    _line.glyphs.clear();
+    _line.attrs.clear();
+    _line.attrStarts.clear();
+    _line.rowStarts.clear();
+    _line.cursor.reset();
+
+    for (auto y = firstRow; y < endRow; ++y)
+    {
+        const auto& row = _OldRow(y);
+        const auto& charRow = row.GetCharRow();
+        const auto right = _LineCells(charRow);
+
+        const auto lineOffset = _line.cells.size();
+        _line.rowStarts.push_back(lineOffset);
+        _line.cells.insert(_line.cells.end(), charRow.cbegin(), charRow.cbegin() + right);
+        for (size_t column = 0; column < right; ++column)
+        {
+            if (_line.cells[lineOffset + column].DbcsAttr().IsGlyphStored())
+            {
+                _line.glyphs.emplace_back(lineOffset + column, _oldGlyphs.GetText(charRow.GetStorageKey(column)));
+            }
+        }
+
+        _AppendAttrs(row.GetAttrRow(), right);
+
+        if (static_cast<size_t>(cursor.Y) == y)
+        {
+            _line.cursor = lineOffset + cursor.X;
+        }
+    }
+
+    // Keep the blanks between the text and the cursor so it lands in the same spot.
+    if (_line.cursor.has_value() && _line.cursor.value() > _line.cells.size())
+    {
+        const auto blanks = _line.cursor.value() - _line.cells.size();
+        _line.cells.resize(_line.cursor.value());
+        _AppendAttr(_fillAttributes, blanks);
+    }
+}
+
+// Routine Description:
+// - Copies a line back out of the top rows of the new layout, to put its old
+//   rows back together. The last row is copied whole; the old rows only take
+//   as many cells as they had.
+// Arguments:
+// - count - how many rows the line was laid out in
+void TextBufferReflow::_CopyOutNewRows(const size_t count)
+{
+    _line.cells.clear();
+    _line.glyphs.clear();
+    _line.attrs.clear();
+    _line.attrStarts.clear();
+    _line.rowStarts.clear();
+    _line.cursor.reset();
+
+    for (size_t y = 0; y < count; ++y)
+    {
+        const auto& row = _newRows[y];
+        const auto& charRow = row.GetCharRow();
+        const auto right = charRow.WasWrapForced() ? _LineCells(charRow) : charRow.size();
+
+        _line.rowStarts.push_back(_line.cells.size());
+        _line.cells.insert(_line.cells.end(), charRow.cbegin(), charRow.cbegin() + right);
+        _AppendAttrs(row.GetAttrRow(), right);
+    }
+}
+
+// Routine Description:
+// - Counts the cells a row adds to its line: every cell but the padding left
+//   by a wide glyph that didn't fit if it wrapped, or up to its last character
+//   if it didn't.
+size_t TextBufferReflow::_LineCells(const CharRow& charRow) noexcept
+{
+    return charRow.WasWrapForced() ?
+               charRow.size() - (charRow.WasDoubleBytePadded() ? 1 : 0) :
+               charRow.MeasureRight();
+}
+
+// Routine Description:
+// - Adds the attributes of a row's first cells to the end of the line.
+// Arguments:
+// - attrRow - the attributes of the row
+// - right - how many of its cells are in the line
+void TextBufferReflow::_AppendAttrs(const ATTR_ROW& attrRow, const size_t right)
+{
+    for (size_t column = 0; column < right;)
+    {
+        size_t applies = 0;
+        const auto attr = attrRow.GetAttrByColumn(column, &applies);
+        const auto length = std::min(applies, right - column);
+        _AppendAttr(attr, length);
+        column += length;
+    }
+}
+
+// Routine Description:
+// - Adds cells with the given attributes to the end of the line, extending
+//   the last run if it has the same attributes.
+void TextBufferReflow::_AppendAttr(const TextAttribute attr, const size_t length)
+{
+    if (!_line.attrs.empty() && _line.attrs.back().GetAttributes() == attr)
+    {
+        _line.attrs.back().SetLength(_line.attrs.back().GetLength() + length);
+        return;
+    }
+
+    const auto start = _line.attrStarts.empty() ? 0 : _line.attrStarts.back() + _line.attrs.back().GetLength();
+    _line.attrs.emplace_back(length, attr);
+    _line.attrStarts.push_back(start);
+}
+
+// Routine Description:
+// - Works out which cells of the line go in which row at the new width. A
+//   wide glyph that would start in the last column is moved to the next row
+//   and its spot is left as padding.
+void TextBufferReflow::_SplitLine()
+{
+    const size_t width = _newSize.X;
+    const auto count = _line.cells.size();
+
+    _spans.clear();
+    size_t begin = 0;
+    size_t column = 0;
+    for (size_t cell = 0; cell < count; ++cell, ++column)
+    {
+        if (column == width)
+        {
+            _spans.push_back({ begin, cell, false });
+            begin = cell;
+            column = 0;
+        }
+        else if (column == width - 1 && column > 0 && _line.cells[cell].DbcsAttr().IsLeading())
+        {
+            _spans.push_back({ begin, cell, true });
+            begin = cell;
+            column = 0;
+        }
+    }
+    _spans.push_back({ begin, count, false });
+
+    // A cursor just past a full last row sits at the start of the next one,
+    // the same as if the text had just been written there.
+    if (column == width && count > 0 && _line.cursor == count)
+    {
+        _spans.push_back({ count, count, false });
+    }
+}
+
+// Routine Description:
+// - Counts the old rows that fall off the top of the new buffer, as of the
+//   line just laid out: the ones above it, and if only part of it was kept,
+//   its rows with cells that weren't. A row that was split between the two is
+//   counted, so its text is saved twice rather than lost.
+// Arguments:
+// - lineStart - the first old row of the line
+// - firstKept - the first of the line's new rows that was kept
+// Return Value:
+// - How many old rows, from the top, fell off.
+size_t TextBufferReflow::_DroppedRows(const size_t lineStart, const size_t firstKept) const
+{
+    if (firstKept == 0)
+    {
+        return lineStart;
+    }
+
+    // the old row that holds the last cell that didn't fit
+    const auto next = std::upper_bound(_line.rowStarts.cbegin(), _line.rowStarts.cend(), _spans[firstKept].begin - 1);
+    return lineStart + static_cast<size_t>(next - _line.rowStarts.cbegin());
+}
+
+// Routine Description:
+// - Saves the old rows that fell off the top like the buffer saves rows that
+//   scroll out of it. They still refer to the old glyphs, so those are put
+//   back in the buffer while the rows are saved.
+// Arguments:
+// - count - how many old rows, from the top, fell off
+void TextBufferReflow::_SaveDroppedRows(const size_t count) noexcept
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    try
+    {
+        std::swap(_oldGlyphs, _buffer._unicodeStorage);
+        for (size_t y = 0; y < count; ++y)
+        {
+            _buffer._SaveScrolledOutRow(_OldRow(y));
+        }
+        std::swap(_oldGlyphs, _buffer._unicodeStorage);
+    }
+    CATCH_LOG();
+}
+
+// Routine Description:
+// - Lets go of the old rows at the bottom, whose cells are copied out, so
+//   they can be reused for new rows. First it records what it takes to put
+//   them back together, in case the reflow fails.
+// Arguments:
+// - firstRow - the first of the rows, which go to the bottom of the old ones
+// - lineOffset - where the first of them starts in the cells of _line
+// - blank - whether the rows are below the text, and aren't in _line
+void TextBufferReflow::_SpareOldRows(const size_t firstRow, const size_t lineOffset, const bool blank)
+{
+    for (auto y = firstRow; y < _oldRows.size(); ++y)
+    {
+        const auto& row = _OldRow(y);
+        const auto& charRow = row.GetCharRow();
+        _OldRowShape shape{ row.GetId(), blank ? 0 : _LineCells(charRow), charRow.WasWrapForced(), charRow.WasDoubleBytePadded(), _undoRuns.size(), 0 };
+
+        // The blanks after the line's cells aren't in it, but their attributes may be set.
+        for (auto column = shape.right; column < _oldWidth; ++shape.runCount)
+        {
+            size_t applies = 0;
+            const auto attr = row.GetAttrRow().GetAttrByColumn(column, &applies);
+            const auto length = std::min(applies, _oldWidth - column);
+            _undoRuns.emplace_back(length, attr);
+            column += length;
+        }
+        _undoRows.push_back(shape);
+    }
+    _undoLines.push_back({ firstRow, _oldRows.size(), lineOffset, 0 });
+    _lineHeld = !blank;
+
+    while (_oldRows.size() > firstRow)
+    {
+        _spareRows.push_back(std::move(_oldRows.back()));
+        _oldRows.pop_back();
+    }
+}
+
+// Routine Description:
+// - Adds a blank row of the new width above the rows laid out so far. A spare
+//   old row is reused for it if there is one.
+// Return Value:
+// - The new row.
+ROW& TextBufferReflow::_PushRow()
+{
+    const auto id = static_cast<SHORT>(_newSize.Y - 1 - _newRows.size());
+    if (_spareRows.empty())
+    {
+        _newRows.emplace_front(id, _newSize.X, _fillAttributes, &_buffer);
+        return _newRows.front();
+    }
+
+    _newRows.push_front(std::move(_spareRows.back()));
+    _spareRows.pop_back();
+
+    auto& row = _newRows.front();
+    row.SetId(id);
+    _UpdateParents(row);
+    THROW_IF_FAILED(row.Resize(_newSize.X));
+    THROW_HR_IF(E_OUTOFMEMORY, !row.Reset(_fillAttributes));
+    return row;
+}
+
+// Routine Description:
+// - Writes part of the line into a blank row.
+// Arguments:
+// - row - the row to write to
+// - span - the cells of the line that belong in the row
+// - wrapped - whether the line continues on the next row
+void TextBufferReflow::_FillRow(ROW& row, const _Span& span, const bool wrapped)
+{
+    auto& charRow = row.GetCharRow();
+    charRow.SetWrapForced(wrapped);
+    charRow.SetDoubleBytePadded(span.doubleBytePadded);
+    if (span.begin == span.end)
+    {
+        return;
+    }
+
+    std::copy(_line.cells.cbegin() + span.begin, _line.cells.cbegin() + span.end, charRow.begin());
+
+    // Glyphs that don't fit in a cell go to the buffer's storage under their new position.
+    const auto firstGlyph = std::lower_bound(_line.glyphs.cbegin(),
+                                             _line.glyphs.cend(),
+                                             span.begin,
+                                             [](const auto& glyph, const size_t cell) { return glyph.first < cell; });
+    for (auto glyph = firstGlyph; glyph != _line.glyphs.cend() && glyph->first < span.end; ++glyph)
+    {
+        charRow.GlyphAt(glyph->first - span.begin) = std::wstring_view{ glyph->second.data(), glyph->second.size() };
+    }
+
+    const auto runs = _LineRuns(span.begin, span.end);
+    THROW_IF_FAILED(row.GetAttrRow().InsertAttrRuns({ runs.data(), runs.size() }, 0, span.end - span.begin - 1, _newSize.X));
+}
+
+// Routine Description:
+// - Cuts the runs of the line's attributes that cover some of its cells down
+//   to size.
+// Arguments:
+// - begin - the first of the cells
+// - end - one past the last of them
+// Return Value:
+// - The runs of the cells, in order.
+std::vector<TextAttributeRun> TextBufferReflow::_LineRuns(const size_t begin, const size_t end) const
+{
+    std::vector<TextAttributeRun> runs;
+    if (begin == end)
+    {
+        return runs;
+    }
+
+    const auto firstRun = std::upper_bound(_line.attrStarts.cbegin(), _line.attrStarts.cend(), begin) - 1;
+    for (auto run = static_cast<size_t>(firstRun - _line.attrStarts.cbegin()); run < _line.attrs.size() && _line.attrStarts[run] < end; ++run)
+    {
+        const auto start = std::max(_line.attrStarts[run], begin);
+        const auto stop = std::min(_line.attrStarts[run] + _line.attrs[run].GetLength(), end);
+        runs.emplace_back(stop - start, _line.attrs[run].GetAttributes());
+    }
+    return runs;
+}
+
+// Routine Description:
+// - Puts the old rows back the way they were, after the reflow failed partway.
+//   The lines laid out so far are copied back out of their new rows one at a
+//   time, from the top, and their old rows are rebuilt out of the rows they
+//   were laid out in. The old rows that weren't reused yet are as they were,
+//   and their glyphs never left the old storage.
+// - Rebuilding a row can only fail if there's no memory to widen it back to
+//   the old width. There's no buffer to go back to then, so it fails fast.
+void TextBufferReflow::_Undo() noexcept
+{
+    try
+    {
+        size_t undoRows = 0;
+        size_t laidOut = 0;
+        for (const auto& line : _undoLines)
+        {
+            undoRows += line.endRow - line.firstRow;
+            laidOut += line.newRows;
+        }
+
+        // The last line is still in _line, unless another was being copied
+        // out when the reflow failed. Its new rows aren't needed then, and
+        // neither are the rows of a line that wasn't laid out all the way.
+        if (_lineHeld)
+        {
+            laidOut -= _undoLines.back().newRows;
+        }
+        while (_newRows.size() > laidOut)
+        {
+            _spareRows.push_back(std::move(_newRows.front()));
+            _newRows.pop_front();
+        }
+
+        for (auto line = _undoLines.crbegin(); line != _undoLines.crend(); ++line)
+        {
+            if (line != _undoLines.crbegin() || !_lineHeld)
+            {
+                _CopyOutNewRows(line->newRows);
+                for (size_t y = 0; y < line->newRows; ++y)
+                {
+                    _spareRows.push_back(std::move(_newRows.front()));
+                    _newRows.pop_front();
+                }
+            }
+
+            undoRows -= line->endRow - line->firstRow;
+            auto offset = line->lineOffset;
+            for (auto y = line->firstRow; y < line->endRow; ++y)
+            {
+                const auto& shape = _undoRows[undoRows + y - line->firstRow];
+                // Rows that were still being let go of are still there.
+                if (y >= _oldRows.size())
+                {
+                    _RestoreRow(shape, offset);
+                }
+                offset += shape.right;
+            }
+        }
+
+        _newRows.clear();
+        _spareRows.clear();
+        FAIL_FAST_IF(_oldRows.size() != _oldHeight);
+
+        std::rotate(_oldRows.begin(), _oldRows.begin() + (_oldHeight - _oldFirstRow) % _oldHeight, _oldRows.end());
+        for (auto& row : _oldRows)
+        {
+            _UpdateParents(row);
+        }
+
+        _buffer._storage.swap(_oldRows);
+        _buffer._firstRow = static_cast<SHORT>(_oldFirstRow);
+        std::swap(_oldGlyphs, _buffer._unicodeStorage);
+    }
+    catch (...)
+    {
+        FAIL_FAST_CAUGHT_EXCEPTION();
+    }
+}
+
+// Routine Description:
+// - Rebuilds the next old row, below the ones that are there, out of a spare
+//   row and the cells of its line in _line.
+// Arguments:
+// - shape - what the row held
+// - offset - where its cells start in _line
+void TextBufferReflow::_RestoreRow(const _OldRowShape& shape, const size_t offset)
+{
+    if (_spareRows.empty())
+    {
+        _oldRows.emplace_back(shape.id, static_cast<short>(_oldWidth), _fillAttributes, &_buffer);
+    }
+    else
+    {
+        _oldRows.push_back(std::move(_spareRows.back()));
+        _spareRows.pop_back();
+    }
+
+    auto& row = _oldRows.back();
+    row.SetId(shape.id);
+    _UpdateParents(row);
+    THROW_IF_FAILED(row.Resize(_oldWidth));
+
+    auto& charRow = row.GetCharRow();
+    const auto cells = _line.cells.cbegin() + offset;
+    std::copy(cells, cells + shape.right, charRow.begin());
+    std::fill(charRow.begin() + shape.right, charRow.end(), CharRow::value_type{});
+    charRow.SetWrapForced(shape.wrapForced);
+    charRow.SetDoubleBytePadded(shape.doubleBytePadded);
+
+    auto runs = _LineRuns(offset, offset + shape.right);
+    const auto trailing = _undoRuns.cbegin() + shape.firstRun;
+    runs.insert(runs.end(), trailing, trailing + shape.runCount);
+    THROW_IF_FAILED(row.GetAttrRow().InsertAttrRuns({ runs.data(), runs.size() }, 0, _oldWidth - 1, _oldWidth));
+}
+
+// Routine Description:
+// - Points the cells and attributes of a row that moved at it again.
+void TextBufferReflow::_UpdateParents(ROW& row) noexcept
+{
+    row.GetCharRow().UpdateParent(&row);
+    row.GetAttrRow().UpdateParent(&row);
+}
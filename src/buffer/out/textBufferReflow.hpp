@@ -0,0 +1,126 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- textBufferReflow.hpp
+
+Abstract:
+- Rewraps the text of a buffer for a new width, in place.
+- Lines are rebuilt one logical line at a time (a row plus the rows it wrapped
+  onto), from the cursor upward. Only one line is copied out at a time, and
+  its cells are moved into the new rows in whole runs rather than one
+  character at a time.
+- Working from the bottom means the rows around the cursor are laid out
+  first. Once the new buffer is full, the rest of the scrollback would fall
+  off the top anyway, so it is dropped without being laid out.
+- The old rows of a line are reused for the new rows once the line is copied
+  out, so the reflow doesn't hold a second copy of the buffer: besides the rows
+  themselves, it holds one line and a few words per row to undo with. A
+  narrower width can need more rows than the lines had; those are new until
+  the old rows that fall off the top can be let go of, once the reflow can't
+  fail anymore.
+- A reflow that fails puts the old rows back together from the new ones, so
+  the buffer is left as it was. Once it succeeds, the old rows that fell off
+  the top are saved the same way rows that scroll out are.
+--*/
+
+#pragma once
+
+#include "textBuffer.hpp"
+
+class TextBufferReflow final
+{
+public:
+    TextBufferReflow(TextBuffer& buffer, const COORD newSize);
+
+    void Run();
+
+    void MarkLiveAttributes(std::vector<bool>& live) const;
+
+private:
+    // The cells of one logical line, copied out of its rows.
+    struct _Line
+    {
+        std::vector<CharRowCell> cells;
+        std::vector<std::pair<size_t, std::vector<wchar_t>>> glyphs;
+        std::vector<TextAttributeRun> attrs;
+        std::vector<size_t> attrStarts;
+        // where each of the line's rows starts in its cells
+        std::vector<size_t> rowStarts;
+        std::optional<size_t> cursor;
+    };
+
+    // The cells of a line that land in one row of the new layout.
+    struct _Span
+    {
+        size_t begin;
+        size_t end;
+        bool doubleBytePadded;
+    };
+
+    // What it takes to put an old row back together from the cells of its
+    // line: how many of them it had, and the attributes of the blanks after.
+    // Its id is the one its glyphs are stored under.
+    struct _OldRowShape
+    {
+        SHORT id;
+        size_t right;
+        bool wrapForced;
+        bool doubleBytePadded;
+        size_t firstRun;
+        size_t runCount;
+    };
+
+    // The old rows that were reused for a line, and the new rows it took.
+    struct _UndoLine
+    {
+        size_t firstRow;
+        size_t endRow;
+        // where the first of the rows starts in the line's cells
+        size_t lineOffset;
+        size_t newRows;
+    };
+
+    TextBuffer& _buffer;
+    const COORD _newSize;
+    const TextAttribute _fillAttributes;
+
+    // The old rows that haven't been reused, with the top row first.
+    std::deque<ROW> _oldRows;
+    size_t _oldFirstRow;
+    size_t _oldHeight;
+    size_t _oldWidth;
+    UnicodeStorage _oldGlyphs;
+
+    std::deque<ROW> _newRows;
+    // Old rows whose cells are copied out, to be reused for new ones.
+    std::deque<ROW> _spareRows;
+
+    _Line _line;
+    std::vector<_Span> _spans;
+
+    std::vector<_UndoLine> _undoLines;
+    std::vector<_OldRowShape> _undoRows;
+    std::vector<TextAttributeRun> _undoRuns;
+    // Whether _line holds the line of the last _undoLines.
+    bool _lineHeld;
+
+    ROW& _OldRow(const size_t row);
+    void _CopyOutLine(const size_t firstRow, const size_t endRow, const COORD cursor);
+    void _CopyOutNewRows(const size_t count);
+    void _AppendAttrs(const ATTR_ROW& attrRow, const size_t right);
+    void _AppendAttr(const TextAttribute attr, const size_t length);
+    void _SplitLine();
+    size_t _DroppedRows(const size_t lineStart, const size_t firstKept) const;
+    void _SaveDroppedRows(const size_t count) noexcept;
+    void _SpareOldRows(const size_t firstRow, const size_t lineOffset, const bool blank);
+    ROW& _PushRow();
+    void _FillRow(ROW& row, const _Span& span, const bool wrapped);
+    std::vector<TextAttributeRun> _LineRuns(const size_t begin, const size_t end) const;
+    void _Undo() noexcept;
+    void _RestoreRow(const _OldRowShape& shape, const size_t offset);
+
+    static size_t _LineCells(const CharRow& charRow) noexcept;
+    static void _UpdateParents(ROW& row) noexcept;
+};
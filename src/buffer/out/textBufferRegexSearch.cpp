@@ -0,0 +1,258 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "textBufferRegexSearch.hpp"
+#include "CharRow.hpp"
+
+#include <condition_variable>
+
+// Routine Description:
+// - Prepares a search for pattern in the given buffer.
+// Arguments:
+// - buffer - the text to search through
+// - pattern - an ECMAScript regular expression. ^ and $ match at the start
+//   and end of each logical line.
+// - caseInsensitive - whether or not to ignore case when matching
+// Return Value:
+// - <none>. Throws std::regex_error if the pattern is malformed.
+TextBufferRegexSearch::TextBufferRegexSearch(const TextBuffer& buffer,
+                                             const std::wstring_view pattern,
+                                             const bool caseInsensitive) :
+    _buffer(buffer),
+    _regex(pattern.data(),
+           pattern.size(),
+           caseInsensitive ? std::regex_constants::ECMAScript | std::regex_constants::optimize | std::regex_constants::icase :
+                             std::regex_constants::ECMAScript | std::regex_constants::optimize)
+{
+}
+
+// Routine Description:
+// - Finds every match in the buffer and hands them to onMatch in buffer order.
+// - onMatch is always called on the calling thread. Matches in the first
+//   chunk are delivered while the later chunks are still being searched.
+// Arguments:
+// - onMatch - receives the first and last cell of each match. Returns false
+//   to stop the search early.
+// - workers - how many threads to search with. 0 uses one per processor,
+//   1 searches on the calling thread alone.
+void TextBufferRegexSearch::FindAll(const MatchFn& onMatch, const size_t workers) const
+{
+    const auto chunks = _SplitIntoChunks();
+    const auto processors = std::max<size_t>(1, std::thread::hardware_concurrency());
+    const auto threads = std::min(chunks.size(), workers != 0 ? workers : processors);
+
+    if (threads <= 1)
+    {
+        std::vector<std::pair<COORD, COORD>> matches;
+        for (const auto& chunk : chunks)
+        {
+            matches.clear();
+            _SearchChunk(chunk.first, chunk.second, matches);
+            for (const auto& match : matches)
+            {
+                if (!onMatch(match.first, match.second))
+                {
+                    return;
+                }
+            }
+        }
+        return;
+    }
+
+    std::vector<std::vector<std::pair<COORD, COORD>>> results(chunks.size());
+    std::vector<bool> done(chunks.size(), false);
+    std::exception_ptr failure;
+    std::mutex mutex;
+    std::condition_variable chunkDone;
+    std::atomic<size_t> nextChunk{ 0 };
+    std::atomic<bool> stop{ false };
+
+    const auto work = [&]() {
+        for (auto chunk = nextChunk++; chunk < chunks.size() && !stop; chunk = nextChunk++)
+        {
+            std::vector<std::pair<COORD, COORD>> matches;
+            try
+            {
+                _SearchChunk(chunks[chunk].first, chunks[chunk].second, matches);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock{ mutex };
+                if (!failure)
+                {
+                    failure = std::current_exception();
+                }
+                stop = true;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock{ mutex };
+                results[chunk] = std::move(matches);
+                done[chunk] = !stop;
+            }
+            chunkDone.notify_all();
+        }
+    };
+
+    std::vector<std::thread> pool;
+    auto joinPool = wil::scope_exit([&]() {
+        stop = true;
+        for (auto& thread : pool)
+        {
+            thread.join();
+        }
+    });
+
+    pool.reserve(threads);
+    for (size_t i = 0; i < threads; ++i)
+    {
+        pool.emplace_back(work);
+    }
+
+    for (size_t chunk = 0; chunk < chunks.size(); ++chunk)
+    {
+        std::vector<std::pair<COORD, COORD>> matches;
+        {
+            std::unique_lock<std::mutex> lock{ mutex };
+            chunkDone.wait(lock, [&]() { return done[chunk] || failure; });
+            if (failure)
+            {
+                break;
+            }
+            matches.swap(results[chunk]);
+        }
+
+        for (const auto& match : matches)
+        {
+            if (!onMatch(match.first, match.second))
+            {
+                return;
+            }
+        }
+    }
+
+    joinPool.reset();
+    if (failure)
+    {
+        std::rethrow_exception(failure);
+    }
+}
+
+// Routine Description:
+// - Splits the rows of the buffer into chunks of about s_chunkRows rows. A
+//   chunk is stretched when needed so that it ends with the last row of a
+//   logical line.
+// Return Value:
+// - The first row and one past the last row of each chunk, top to bottom.
+std::vector<std::pair<size_t, size_t>> TextBufferRegexSearch::_SplitIntoChunks() const
+{
+    const size_t height = _buffer.GetSize().Height();
+
+    std::vector<std::pair<size_t, size_t>> chunks;
+    for (size_t first = 0; first < height;)
+    {
+        auto end = std::min(first + s_chunkRows, height);
+        while (end < height && _buffer.GetRowByOffset(end - 1).GetCharRow().WasWrapForced())
+        {
+            ++end;
+        }
+        chunks.emplace_back(first, end);
+        first = end;
+    }
+    return chunks;
+}
+
+// Routine Description:
+// - Lays out the text of a logical line. Each glyph appears once even if it
+//   is wide, and the padding at the end of its last row is left off so that
+//   $ matches right after the last glyph.
+// Arguments:
+// - firstRow - the row the logical line starts on
+// - lastRow - the row it ends on. Every row before it wrapped onto the next.
+// - line - receives the text and the cells each character came from
+void TextBufferRegexSearch::_LayOutLine(const size_t firstRow, const size_t lastRow, _LogicalLine& line) const
+{
+    line.text.clear();
+    line.cells.clear();
+
+    size_t glyphStart = 0;
+    for (auto row = firstRow; row <= lastRow; ++row)
+    {
+        const auto& charRow = _buffer.GetRowByOffset(row).GetCharRow();
+        size_t column = 0;
+        for (auto it = charRow.cbegin(); it != charRow.cend(); ++it, ++column)
+        {
+            const COORD cell{ static_cast<SHORT>(column), static_cast<SHORT>(row) };
+            const auto& attr = it->DbcsAttr();
+            if (attr.IsTrailing())
+            {
+                // The leading half already put the glyph in the text. It covers this cell too.
+                for (auto i = glyphStart; i < line.cells.size(); ++i)
+                {
+                    line.cells[i].second = cell;
+                }
+                continue;
+            }
+
+            glyphStart = line.text.size();
+            if (attr.IsGlyphStored())
+            {
+                const std::wstring_view glyph = charRow.GlyphAt(column);
+                line.text.append(glyph.data(), glyph.size());
+            }
+            else
+            {
+                line.text.push_back(it->Char());
+            }
+            line.cells.resize(line.text.size(), { cell, cell });
+        }
+    }
+
+    while (!line.text.empty() && line.text.back() == UNICODE_SPACE && line.cells.back().first.Y == static_cast<SHORT>(lastRow))
+    {
+        line.text.pop_back();
+        line.cells.pop_back();
+    }
+}
+
+// Routine Description:
+// - Finds every match in a chunk of rows. The chunk must start and end on
+//   logical line boundaries.
+// Arguments:
+// - firstRow - the first row of the chunk
+// - endRow - one past the last row of the chunk
+// - matches - the first and last cell of each match are appended to this
+void TextBufferRegexSearch::_SearchChunk(const size_t firstRow,
+                                         const size_t endRow,
+                                         std::vector<std::pair<COORD, COORD>>& matches) const
+{
+    _LogicalLine line;
+    for (auto row = firstRow; row < endRow;)
+    {
+        auto lastRow = row;
+        while (lastRow + 1 < endRow && _buffer.GetRowByOffset(lastRow).GetCharRow().WasWrapForced())
+        {
+            ++lastRow;
+        }
+
+        _LayOutLine(row, lastRow, line);
+
+        const auto begin = line.text.data();
+        const auto end = begin + line.text.size();
+        for (std::wcregex_iterator it{ begin, end, _regex }, last; it != last; ++it)
+        {
+            const auto length = static_cast<size_t>(it->length());
+            if (length == 0)
+            {
+                continue;
+            }
+
+            const auto offset = static_cast<size_t>(it->position());
+            matches.emplace_back(line.cells[offset].first, line.cells[offset + length - 1].second);
+        }
+
+        row = lastRow + 1;
+    }
+}
@@ -0,0 +1,59 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- textBufferRegexSearch.hpp
+
+Abstract:
+- Finds every match of a regular expression in a text buffer, using several
+  threads at once.
+- The buffer is searched one logical line at a time. A logical line is a row
+  plus the rows it wrapped onto, so a match can run across a wrapped row
+  boundary but never across a real line break.
+- The rows are split into chunks, each made up of whole logical lines. Worker
+  threads take chunks as they become free. The matches are passed back to the
+  caller in buffer order as soon as every chunk before them is done.
+- The buffer must not change while a search is running. The caller is
+  expected to hold the console lock for the duration of FindAll.
+--*/
+
+#pragma once
+
+#include "textBuffer.hpp"
+
+#include <functional>
+#include <regex>
+
+class TextBufferRegexSearch final
+{
+public:
+    // Receives the first and last cell of a match. Returns false to stop the search.
+    using MatchFn = std::function<bool(const COORD start, const COORD end)>;
+
+    TextBufferRegexSearch(const TextBuffer& buffer,
+                          const std::wstring_view pattern,
+                          const bool caseInsensitive);
+
+    void FindAll(const MatchFn& onMatch, const size_t workers = 0) const;
+
+    static constexpr size_t s_chunkRows = 256;
+
+private:
+    // The text of one logical line. cells maps each character of text back
+    // to the first and last cell of the glyph it belongs to.
+    struct _LogicalLine
+    {
+        std::wstring text;
+        std::vector<std::pair<COORD, COORD>> cells;
+    };
+
+    const TextBuffer& _buffer;
+    const std::wregex _regex;
+
+    std::vector<std::pair<size_t, size_t>> _SplitIntoChunks() const;
+    void _LayOutLine(const size_t firstRow, const size_t lastRow, _LogicalLine& line) const;
+    void _SearchChunk(const size_t firstRow,
+                      const size_t endRow,
+                      std::vector<std::pair<COORD, COORD>>& matches) const;
+};
@@ -0,0 +1,362 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "textBufferSearch.hpp"
+#include "CharRow.hpp"
+
+#include "../../types/inc/Utf16Parser.hpp"
+#include "../../types/inc/GlyphWidth.hpp"
+
+// Routine Description:
+// - Prepares a search for needle in the given buffer.
+// - The needle is split into cells the way the buffer would store it (a wide
+//   glyph takes two), folded if necessary and given its skip table up front.
+// Arguments:
+// - buffer - the text to search through (the "haystack")
+// - needle - the literal text to find
+// - caseInsensitive - whether or not to ignore case when comparing
+TextBufferSearch::TextBufferSearch(const TextBuffer& buffer,
+                                   const std::wstring_view needle,
+                                   const bool caseInsensitive) :
+    _buffer(buffer),
+    _caseInsensitive(caseInsensitive)
+{
+    for (const auto& glyph : Utf16Parser::Parse(needle))
+    {
+        const auto copies = IsGlyphFullWidth(std::wstring_view{ glyph.data(), glyph.size() }) ? 2 : 1;
+        for (auto i = 0; i < copies; ++i)
+        {
+            _needleCellStarts.push_back(_needle.size());
+            for (const auto wch : glyph)
+            {
+                _needle.push_back(_caseInsensitive ? s_FoldCase(wch) : wch);
+            }
+        }
+    }
+    _needleCellStarts.push_back(_needle.size());
+
+    // Horspool's bad character rule. Characters are bucketed by their low
+    // byte; sharing a bucket only ever makes a shift smaller, never wrong.
+    const auto length = _needle.size();
+    _skip.fill(length);
+    for (size_t i = 0; i + 1 < length; ++i)
+    {
+        _skip[_needle[i] & 0xFF] = length - 1 - i;
+    }
+}
+
+// Routine Description:
+// - The number of buffer cells a match occupies.
+size_t TextBufferSearch::NeedleCells() const noexcept
+{
+    return _needleCellStarts.size() - 1;
+}
+
+// Routine Description:
+// - Finds the first match starting at one of the count cells beginning at
+//   from and moving forward, wrapping from the end of the buffer to the top.
+// Arguments:
+// - from - the first position a match may start at
+// - count - how many starting positions to try
+// Return Value:
+// - The first and last cell of the match, if there was one.
+std::optional<std::pair<COORD, COORD>> TextBufferSearch::FindForward(const COORD from, const size_t count) const
+{
+    const auto total = _BufferCells();
+    if (count == 0 || total == 0)
+    {
+        return std::nullopt;
+    }
+
+    const size_t first = from.Y * static_cast<size_t>(_buffer.GetSize().Width()) + from.X;
+    return _Find(first, first + std::min(count, total) - 1, true);
+}
+
+// Routine Description:
+// - Finds the closest match starting at one of the count cells ending at from
+//   and moving backward, wrapping from the top of the buffer to the end.
+// Arguments:
+// - from - the first position a match may start at
+// - count - how many starting positions to try
+// Return Value:
+// - The first and last cell of the match, if there was one.
+std::optional<std::pair<COORD, COORD>> TextBufferSearch::FindBackward(const COORD from, const size_t count) const
+{
+    const auto total = _BufferCells();
+    if (count == 0 || total == 0)
+    {
+        return std::nullopt;
+    }
+
+    // Shift up by one buffer so that positions before the top don't go negative.
+    const size_t last = from.Y * static_cast<size_t>(_buffer.GetSize().Width()) + from.X + total;
+    return _Find(last - std::min(count, total) + 1, last, false);
+}
+
+// Routine Description:
+// - Finds every match that starts in the given rows. Unlike FindForward and
+//   FindBackward, a match isn't allowed to wrap from the bottom of the buffer
+//   around to the top.
+// Arguments:
+// - firstRow - the first row to search
+// - rowCount - the number of rows to search
+// - starts - the first cell of every match is appended to this, in buffer order
+void TextBufferSearch::FindAllInRows(const size_t firstRow, const size_t rowCount, std::vector<COORD>& starts) const
+{
+    const auto cells = NeedleCells();
+    const size_t width = _buffer.GetSize().Width();
+    const size_t height = _buffer.GetSize().Height();
+    if (cells == 0 || width == 0)
+    {
+        return;
+    }
+
+    const auto spillRows = (cells - 1 + width - 1) / width;
+    const auto endRow = std::min(firstRow + rowCount, height);
+
+    _LinearText linear;
+    for (auto row = firstRow; row < endRow; row += s_chunkRows)
+    {
+        const auto rows = std::min(s_chunkRows, endRow - row);
+        _Linearize(row, std::min(rows + spillRows, height - row), linear);
+        _ForEachMatchInChunk(linear, 0, rows * width - 1, [&](const size_t cell) {
+            starts.push_back({ static_cast<SHORT>(cell % width), static_cast<SHORT>(row + cell / width) });
+            return true;
+        });
+    }
+}
+
+// Routine Description:
+// - Removes every position that isn't (or is no longer) the start of a match.
+// - This is what makes narrowing a search cheap: when a character is added to
+//   the end of the needle, the matches of the longer needle are a subset of
+//   the matches of the shorter one, so only those need to be checked.
+// - Like FindAllInRows, matches don't wrap around the bottom of the buffer.
+// Arguments:
+// - starts - candidate positions, in buffer order. Updated in place.
+void TextBufferSearch::KeepMatches(std::vector<COORD>& starts) const
+{
+    const auto cells = NeedleCells();
+    const size_t width = _buffer.GetSize().Width();
+    const size_t height = _buffer.GetSize().Height();
+    if (cells == 0 || width == 0)
+    {
+        starts.clear();
+        return;
+    }
+
+    const auto spillRows = (cells - 1 + width - 1) / width;
+
+    _LinearText linear;
+    std::optional<SHORT> linearRow;
+    const auto newEnd = std::remove_if(starts.begin(), starts.end(), [&](const COORD start) {
+        // Candidates come in row order, so each row is only laid out once.
+        if (linearRow != start.Y)
+        {
+            linearRow = start.Y;
+            _Linearize(start.Y, std::min(1 + spillRows, height - start.Y), linear);
+        }
+
+        const auto offset = linear.cellStarts[start.X];
+        size_t cell;
+        return offset + _needle.size() > linear.text.size() ||
+               wmemcmp(linear.text.data() + offset, _needle.data(), _needle.size()) != 0 ||
+               !_IsCellAlignedMatch(linear, offset, cell);
+    });
+    starts.erase(newEnd, starts.end());
+}
+
+// Routine Description:
+// - Folds a character for a case insensitive comparison, the same way towlower would.
+wchar_t TextBufferSearch::s_FoldCase(const wchar_t wch) noexcept
+{
+    // Most text is ASCII, which doesn't need a trip through the CRT.
+    if (wch < 0x80)
+    {
+        return (wch >= L'A' && wch <= L'Z') ? static_cast<wchar_t>(wch + (L'a' - L'A')) : wch;
+    }
+    return ::towlower(wch);
+}
+
+size_t TextBufferSearch::_BufferCells() const noexcept
+{
+    const auto size = _buffer.GetSize();
+    return static_cast<size_t>(size.Width()) * size.Height();
+}
+
+// Routine Description:
+// - Converts a cell index, which may be past the end of the buffer by up to
+//   one buffer's worth, into a position in the buffer.
+COORD TextBufferSearch::_ToCoord(const size_t cell) const noexcept
+{
+    const size_t width = _buffer.GetSize().Width();
+    const auto wrapped = cell % _BufferCells();
+    return { static_cast<SHORT>(wrapped % width), static_cast<SHORT>(wrapped / width) };
+}
+
+// Routine Description:
+// - Lays the text of rowCount rows out end to end. Rows past the bottom of the
+//   buffer wrap around to the top.
+// Arguments:
+// - firstRow - the first row to lay out
+// - rowCount - the number of rows to lay out
+// - linear - receives the text and where each cell of it starts
+void TextBufferSearch::_Linearize(const size_t firstRow, const size_t rowCount, _LinearText& linear) const
+{
+    const size_t height = _buffer.GetSize().Height();
+
+    linear.text.clear();
+    linear.cellStarts.clear();
+
+    for (size_t row = firstRow; row < firstRow + rowCount; ++row)
+    {
+        const auto& charRow = _buffer.GetRowByOffset(row % height).GetCharRow();
+        size_t column = 0;
+        for (auto it = charRow.cbegin(); it != charRow.cend(); ++it, ++column)
+        {
+            linear.cellStarts.push_back(linear.text.size());
+            if (it->DbcsAttr().IsGlyphStored())
+            {
+                const std::wstring_view glyph = charRow.GlyphAt(column);
+                for (const auto wch : glyph)
+                {
+                    linear.text.push_back(_caseInsensitive ? s_FoldCase(wch) : wch);
+                }
+            }
+            else
+            {
+                linear.text.push_back(_caseInsensitive ? s_FoldCase(it->Char()) : it->Char());
+            }
+        }
+    }
+    linear.cellStarts.push_back(linear.text.size());
+}
+
+// Routine Description:
+// - Checks that a textual match at offset also lines up with the cells of the
+//   buffer, i.e. that it starts on a cell and each glyph of the needle covers
+//   exactly one cell.
+// Arguments:
+// - linear - the text the match was found in
+// - offset - where the text matched
+// - cell - receives the cell the match starts at
+// Return Value:
+// - true if the match at offset lines up with the buffer's cells.
+bool TextBufferSearch::_IsCellAlignedMatch(const _LinearText& linear, const size_t offset, size_t& cell) const
+{
+    const auto& starts = linear.cellStarts;
+    const auto it = std::lower_bound(starts.cbegin(), starts.cend(), offset);
+    if (it == starts.cend() || *it != offset)
+    {
+        return false;
+    }
+
+    cell = it - starts.cbegin();
+    const auto cells = NeedleCells();
+    if (cell + cells >= starts.size())
+    {
+        return false;
+    }
+
+    for (size_t i = 1; i <= cells; ++i)
+    {
+        if (starts[cell + i] != offset + _needleCellStarts[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Routine Description:
+// - Runs the skip search over laid out text, looking for matches that start in
+//   the cells firstCell through lastCell.
+// Arguments:
+// - linear - the text to search
+// - firstCell - the first cell a match may start at
+// - lastCell - the last cell a match may start at
+// - onMatch - called with the first cell of each match, in order. Returns
+//   false to stop the search.
+template<typename Fn>
+void TextBufferSearch::_ForEachMatchInChunk(const _LinearText& linear,
+                                            const size_t firstCell,
+                                            const size_t lastCell,
+                                            Fn&& onMatch) const
+{
+    const auto& text = linear.text;
+    const auto length = _needle.size();
+    const auto lastOffset = linear.cellStarts[lastCell];
+    const auto tailChar = _needle[length - 1];
+
+    for (size_t offset = linear.cellStarts[firstCell]; offset <= lastOffset && offset + length <= text.size();)
+    {
+        const auto tail = text[offset + length - 1];
+        size_t cell;
+        if (tail == tailChar &&
+            wmemcmp(text.data() + offset, _needle.data(), length - 1) == 0 &&
+            _IsCellAlignedMatch(linear, offset, cell))
+        {
+            if (!onMatch(cell))
+            {
+                break;
+            }
+        }
+        offset += _skip[tail & 0xFF];
+    }
+}
+
+// Routine Description:
+// - Finds a match that starts within the given range of cells. Cells are
+//   counted from the top of the buffer and may run past its end by up to one
+//   buffer, in which case they wrap around to the top.
+// - The range is laid out a chunk of rows at a time (plus the rows a match
+//   could spill into), in the direction of the search, so a match near the
+//   starting point doesn't require laying out the whole buffer.
+// Arguments:
+// - first - the first cell a match may start at
+// - last - the last cell a match may start at
+// - forward - true for the first match in the range, false for the last
+// Return Value:
+// - The first and last cell of the match, if there was one.
+std::optional<std::pair<COORD, COORD>> TextBufferSearch::_Find(const size_t first, const size_t last, const bool forward) const
+{
+    const auto cells = NeedleCells();
+    if (cells == 0 || cells > _BufferCells())
+    {
+        return std::nullopt;
+    }
+
+    const size_t width = _buffer.GetSize().Width();
+    const auto spillRows = (cells - 1 + width - 1) / width;
+    const auto firstRow = first / width;
+    const auto lastRow = last / width;
+    const auto chunks = (lastRow - firstRow) / s_chunkRows + 1;
+
+    _LinearText linear;
+    linear.text.reserve((s_chunkRows + spillRows) * width);
+    linear.cellStarts.reserve((s_chunkRows + spillRows) * width + 1);
+
+    for (size_t i = 0; i < chunks; ++i)
+    {
+        const auto row = firstRow + (forward ? i : chunks - 1 - i) * s_chunkRows;
+        const auto rows = std::min(s_chunkRows, lastRow - row + 1);
+        _Linearize(row, rows + spillRows, linear);
+
+        const auto base = row * width;
+        const auto firstCell = std::max(first, base) - base;
+        const auto lastCell = std::min(last, base + rows * width - 1) - base;
+        std::optional<size_t> found;
+        _ForEachMatchInChunk(linear, firstCell, lastCell, [&](const size_t cell) {
+            found = cell;
+            return !forward;
+        });
+        if (found)
+        {
+            const auto start = base + *found;
+            return std::pair{ _ToCoord(start), _ToCoord(start + cells - 1) };
+        }
+    }
+    return std::nullopt;
+}
@@ -0,0 +1,70 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- textBufferSearch.hpp
+
+Abstract:
+- Finds a literal string in the cells of a text buffer.
+- The buffer is treated the way Search always has: as one circular run of
+  cells, row after row, where a match may continue from the end of one row
+  into the next. A wide glyph occupies two cells and the search term is split
+  into cells in the same way.
+- Rows are laid out end to end as flat (optionally case folded) text once, and
+  the term is located in that text with a Boyer-Moore-Horspool skip search.
+  Only candidate matches are mapped back to buffer cells.
+--*/
+
+#pragma once
+
+#include "textBuffer.hpp"
+
+#include <array>
+
+class TextBufferSearch final
+{
+public:
+    TextBufferSearch(const TextBuffer& buffer,
+                     const std::wstring_view needle,
+                     const bool caseInsensitive);
+
+    size_t NeedleCells() const noexcept;
+
+    std::optional<std::pair<COORD, COORD>> FindForward(const COORD from, const size_t count) const;
+    std::optional<std::pair<COORD, COORD>> FindBackward(const COORD from, const size_t count) const;
+
+    void FindAllInRows(const size_t firstRow, const size_t rowCount, std::vector<COORD>& starts) const;
+    void KeepMatches(std::vector<COORD>& starts) const;
+
+    static wchar_t s_FoldCase(const wchar_t wch) noexcept;
+
+private:
+    // The text of a range of rows laid end to end. cellStarts holds the
+    // offset into text at which each cell begins, plus one past the end.
+    struct _LinearText
+    {
+        std::wstring text;
+        std::vector<size_t> cellStarts;
+    };
+
+    static constexpr size_t s_chunkRows = 64;
+
+    const TextBuffer& _buffer;
+    const bool _caseInsensitive;
+    std::wstring _needle;
+    std::vector<size_t> _needleCellStarts;
+    std::array<size_t, 256> _skip;
+
+    size_t _BufferCells() const noexcept;
+    COORD _ToCoord(const size_t cell) const noexcept;
+
+    void _Linearize(const size_t firstRow, const size_t rowCount, _LinearText& linear) const;
+    bool _IsCellAlignedMatch(const _LinearText& linear, const size_t offset, size_t& cell) const;
+    template<typename Fn>
+    void _ForEachMatchInChunk(const _LinearText& linear,
+                              const size_t firstCell,
+                              const size_t lastCell,
+                              Fn&& onMatch) const;
+    std::optional<std::pair<COORD, COORD>> _Find(const size_t first, const size_t last, const bool forward) const;
+};
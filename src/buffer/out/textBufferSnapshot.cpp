@@ -0,0 +1,513 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "textBufferSnapshot.hpp"
+#include "textBuffer.hpp"
+
+namespace
+{
+    constexpr uint32_t s_magic = 0x4e534254; // "TBSN"
+    constexpr uint32_t s_version = 2;
+
+    struct FileHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        // Where the footer of the last complete commit is. Until the first
+        // one is complete, 0. Only ever changed once everything it points
+        // to is on disk.
+        uint64_t footerOffset;
+    };
+
+    // Each commit appends one after the rows, index and attributes it wrote.
+    struct FileFooter
+    {
+        uint64_t indexOffset;
+        uint64_t rowCount;
+        uint64_t attributesOffset;
+        uint64_t attributeCount;
+        uint64_t cursorRow;
+        int16_t cursorColumn;
+        uint16_t reserved;
+        uint32_t magic;
+    };
+    static_assert(sizeof(FileFooter) == 48, "The footer shouldn't have padding.");
+
+    // An entry of the index: where a row is in the file.
+    struct IndexEntry
+    {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    // Rows are copied from one file to another this much at a time.
+    constexpr size_t s_copyChunkSize = 1024 * 1024;
+
+    const HRESULT s_corrupt = HRESULT_FROM_WIN32(ERROR_FILE_CORRUPT);
+
+    template<typename T>
+    void Append(std::vector<BYTE>& out, const T& value)
+    {
+        const auto bytes = reinterpret_cast<const BYTE*>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    void SeekTo(const HANDLE file, const uint64_t offset)
+    {
+        LARGE_INTEGER position;
+        position.QuadPart = gsl::narrow<LONGLONG>(offset);
+        THROW_IF_WIN32_BOOL_FALSE(SetFilePointerEx(file, position, nullptr, FILE_BEGIN));
+    }
+
+    void WriteAt(const HANDLE file, const uint64_t offset, const gsl::span<const BYTE> data)
+    {
+        SeekTo(file, offset);
+
+        auto remaining = gsl::narrow_cast<size_t>(data.size());
+        auto next = data.data();
+        while (remaining > 0)
+        {
+            DWORD written = 0;
+            const auto chunk = gsl::narrow_cast<DWORD>(std::min<size_t>(remaining, MAXDWORD));
+            THROW_IF_WIN32_BOOL_FALSE(WriteFile(file, next, chunk, &written, nullptr));
+            remaining -= written;
+            next += written;
+        }
+    }
+
+    void ReadAt(const HANDLE file, const uint64_t offset, const gsl::span<BYTE> data)
+    {
+        SeekTo(file, offset);
+
+        auto remaining = gsl::narrow_cast<size_t>(data.size());
+        auto next = data.data();
+        while (remaining > 0)
+        {
+            DWORD read = 0;
+            const auto chunk = gsl::narrow_cast<DWORD>(std::min<size_t>(remaining, MAXDWORD));
+            THROW_IF_WIN32_BOOL_FALSE(ReadFile(file, next, chunk, &read, nullptr));
+            THROW_HR_IF(s_corrupt, read == 0);
+            remaining -= read;
+            next += read;
+        }
+    }
+
+    HANDLE OpenForWriting(const std::wstring& path, const DWORD disposition) noexcept
+    {
+        return CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, disposition, FILE_ATTRIBUTE_NORMAL, nullptr);
+    }
+}
+
+// Routine Description:
+// - Prepares to write a snapshot file. Nothing is written until the first
+//   commit, which replaces any file that's there with a complete snapshot.
+// Arguments:
+// - path - the file to write
+// - rewriteAfter - how many bytes of rows that later commits replaced the
+//   file can hold before a commit writes a new one. It's rewritten sooner if
+//   they take more than the rows that scrolled out of the buffer.
+TextBufferSnapshotWriter::TextBufferSnapshotWriter(const std::wstring_view path, const uint64_t rewriteAfter) :
+    _path{ path },
+    _rewriteAfter{ rewriteAfter },
+    _attrs{},
+    _rows{},
+    _rowBytes{ 0 },
+    _pending{},
+    _pendingRows{},
+    _fileEnd{ sizeof(FileHeader) }
+{
+    static_assert(sizeof(_Extent) == sizeof(IndexEntry), "The index is written straight from the extents.");
+}
+
+// Routine Description:
+// - Carries on a snapshot file that a buffer was restored from. Commits
+//   append to it, and the rows that were older than the ones restored into
+//   the buffer are kept where they are, as rows that scrolled out.
+// - The file stays open for writing. A commit that would rewrite it appends
+//   instead for as long as the snapshot is open.
+// Arguments:
+// - path - the file the snapshot was opened from
+// - restored - the snapshot
+// - scrolledOut - how many of its rows are older than the ones in the
+//   buffer, as Restore returned
+// - rewriteAfter - see the other constructor
+TextBufferSnapshotWriter::TextBufferSnapshotWriter(const std::wstring_view path,
+                                                   const TextBufferSnapshot& restored,
+                                                   const size_t scrolledOut,
+                                                   const uint64_t rewriteAfter) :
+    TextBufferSnapshotWriter(path, rewriteAfter)
+{
+    THROW_HR_IF(E_INVALIDARG, scrolledOut > restored.RowCount());
+
+    _attrs = restored._attrs;
+    _rows.reserve(scrolledOut);
+    for (size_t i = 0; i < scrolledOut; ++i)
+    {
+        const auto row = restored._Row(i);
+        _rows.push_back({ gsl::narrow_cast<uint64_t>(row.data() - restored._view.get()), gsl::narrow_cast<uint64_t>(row.size()) });
+        _rowBytes += row.size();
+    }
+
+    // Anything past the last complete commit is left over from one that
+    // never finished, and is written over.
+    _fileEnd = restored._end;
+    _file.reset(OpenForWriting(_path, OPEN_EXISTING));
+    THROW_LAST_ERROR_IF(!_file);
+}
+
+// Routine Description:
+// - Adds a row that's about to scroll out of the buffer. It's encoded right
+//   away, and written with the next commit.
+// Arguments:
+// - row - the row. Its contents aren't needed after this returns.
+void TextBufferSnapshotWriter::AppendRow(const ROW& row)
+{
+    // A row that fails to encode leaves nothing behind, so the index never
+    // points past the rows that are there.
+    const auto start = _pending.size();
+    auto truncate = wil::scope_exit([&]() noexcept { _pending.resize(start); });
+
+    RowEncoding::Encode(row, _attrs, _pending);
+    _pendingRows.push_back({ start, _pending.size() - start });
+    truncate.release();
+}
+
+// Routine Description:
+// - Brings the file up to date with the rows that scrolled out since the last
+//   commit and the rows of the buffer down to the last one in use. If this
+//   throws, the file still holds the last commit, and the next one tries again.
+// Arguments:
+// - buffer - the buffer whose rows scrolled out through AppendRow
+void TextBufferSnapshotWriter::Commit(const TextBuffer& buffer)
+{
+    if (!_file)
+    {
+        _Rewrite(buffer);
+        return;
+    }
+
+    const auto replaced = _fileEnd - sizeof(FileHeader) - _rowBytes;
+    if (replaced > std::max(_rowBytes, _rewriteAfter))
+    {
+        try
+        {
+            _Rewrite(buffer);
+            return;
+        }
+        CATCH_LOG();
+    }
+
+    _Append(buffer);
+}
+
+// Routine Description:
+// - Commits by appending to the file.
+void TextBufferSnapshotWriter::_Append(const TextBuffer& buffer)
+{
+    const auto committed = _rows.size();
+    auto rollback = wil::scope_exit([&]() noexcept { _rows.resize(committed); });
+
+    const auto tail = _EncodeTail(buffer, _fileEnd, _rows);
+    _WriteCommit(_file.get(), _fileEnd, tail);
+
+    // The buffer's rows are only in the index until the next commit.
+    _rows.resize(committed + _pendingRows.size());
+    rollback.release();
+
+    _rowBytes += _pending.size();
+    _fileEnd += _pending.size() + tail.size();
+    _pending.clear();
+    _pendingRows.clear();
+}
+
+// Routine Description:
+// - Commits by writing a new file with only the rows that are still needed,
+//   and moving it over the old one.
+void TextBufferSnapshotWriter::_Rewrite(const TextBuffer& buffer)
+{
+    const auto tempPath = _path + L".tmp";
+    wil::unique_hfile temp{ OpenForWriting(tempPath, CREATE_ALWAYS) };
+    THROW_LAST_ERROR_IF(!temp);
+    auto removeTemp = wil::scope_exit([&]() noexcept {
+        temp.reset();
+        DeleteFileW(tempPath.c_str());
+    });
+
+    std::vector<BYTE> header;
+    Append(header, FileHeader{ s_magic, s_version, 0 });
+    WriteAt(temp.get(), 0, header);
+
+    // Copy the rows that scrolled out before, a run of rows that are next to
+    // each other in the old file at a time.
+    std::vector<_Extent> rows;
+    rows.reserve(_rows.size() + _pendingRows.size());
+    std::vector<BYTE> chunk;
+    uint64_t offset = sizeof(FileHeader);
+    for (size_t i = 0; i < _rows.size();)
+    {
+        const auto start = _rows[i].offset;
+        auto end = start;
+        for (; i < _rows.size() && _rows[i].offset == end; ++i)
+        {
+            rows.push_back({ offset + (end - start), _rows[i].size });
+            end += _rows[i].size;
+        }
+
+        for (auto from = start; from < end;)
+        {
+            chunk.resize(gsl::narrow_cast<size_t>(std::min<uint64_t>(end - from, s_copyChunkSize)));
+            ReadAt(_file.get(), from, chunk);
+            WriteAt(temp.get(), offset, chunk);
+            from += chunk.size();
+            offset += chunk.size();
+        }
+    }
+
+    const auto rowBytes = offset - sizeof(FileHeader);
+    const auto tail = _EncodeTail(buffer, offset, rows);
+    _WriteCommit(temp.get(), offset, tail);
+    temp.reset();
+
+    // The old file has to be closed to move the new one over it. If that
+    // fails, it's opened again, and the next commit appends to it.
+    const auto hadFile = static_cast<bool>(_file);
+    _file.reset();
+    if (!MoveFileExW(tempPath.c_str(), _path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+    {
+        const auto error = GetLastError();
+        if (hadFile)
+        {
+            _file.reset(OpenForWriting(_path, OPEN_EXISTING));
+        }
+        THROW_WIN32(error);
+    }
+    removeTemp.release();
+
+    rows.resize(_rows.size() + _pendingRows.size());
+    _rows = std::move(rows);
+    _rowBytes = rowBytes + _pending.size();
+    _fileEnd = offset + _pending.size() + tail.size();
+    _pending.clear();
+    _pendingRows.clear();
+
+    _file.reset(OpenForWriting(_path, OPEN_EXISTING));
+    THROW_LAST_ERROR_IF(!_file);
+}
+
+// Routine Description:
+// - Encodes what a commit writes after the rows that scrolled out since the
+//   last one: the rows of the buffer, the index, the attributes and the footer.
+// Arguments:
+// - buffer - the buffer to save the rows of
+// - offset - where in the file the rows that scrolled out since the last
+//   commit go. The rest follows them.
+// - rows - the rows the file already has. Receives the rest.
+// Return Value:
+// - What to write after the rows that scrolled out since the last commit.
+std::vector<BYTE> TextBufferSnapshotWriter::_EncodeTail(const TextBuffer& buffer, const uint64_t offset, std::vector<_Extent>& rows)
+{
+    for (const auto& row : _pendingRows)
+    {
+        rows.push_back({ offset + row.offset, row.size });
+    }
+    const auto scrollbackRows = rows.size();
+    const auto tailOffset = offset + _pending.size();
+
+    const auto cursor = buffer.GetCursor().GetPosition();
+    const auto lastRow = std::max(cursor.Y, buffer.GetLastNonSpaceCharacter().Y);
+
+    std::vector<BYTE> tail;
+    for (SHORT y = 0; y <= lastRow; ++y)
+    {
+        const auto start = tail.size();
+        RowEncoding::Encode(buffer.GetRowByOffset(y), _attrs, tail);
+        rows.push_back({ tailOffset + start, tail.size() - start });
+    }
+
+    FileFooter footer{};
+    footer.indexOffset = tailOffset + tail.size();
+    footer.rowCount = rows.size();
+    const auto index = reinterpret_cast<const BYTE*>(rows.data());
+    tail.insert(tail.end(), index, index + rows.size() * sizeof(_Extent));
+
+    footer.attributesOffset = tailOffset + tail.size();
+    footer.attributeCount = _attrs.Size();
+    _attrs.Pack(tail);
+
+    footer.cursorRow = scrollbackRows + cursor.Y;
+    footer.cursorColumn = cursor.X;
+    footer.magic = s_magic;
+    Append(tail, footer);
+
+    return tail;
+}
+
+// Routine Description:
+// - Writes a commit to a file: the rows that scrolled out since the last one
+//   and the tail at the given offset, and once they're on disk, the header's
+//   pointer to the new footer. Until that last write, the file reads as it did
+//   before.
+void TextBufferSnapshotWriter::_WriteCommit(const HANDLE file, const uint64_t offset, const std::vector<BYTE>& tail) const
+{
+    WriteAt(file, offset, _pending);
+    WriteAt(file, offset + _pending.size(), tail);
+    THROW_IF_WIN32_BOOL_FALSE(FlushFileBuffers(file));
+
+    const uint64_t footerOffset = offset + _pending.size() + tail.size() - sizeof(FileFooter);
+    std::vector<BYTE> pointer;
+    Append(pointer, footerOffset);
+    WriteAt(file, offsetof(FileHeader, footerOffset), pointer);
+    THROW_IF_WIN32_BOOL_FALSE(FlushFileBuffers(file));
+}
+
+// Routine Description:
+// - Opens a snapshot file and maps it into memory. Only the footer of the last
+//   complete commit and the attributes are read; rows are read when they're
+//   asked for.
+// Arguments:
+// - path - the file to read
+// Return Value:
+// - Throws HRESULT_FROM_WIN32(ERROR_FILE_CORRUPT) if the file isn't a complete snapshot.
+TextBufferSnapshot::TextBufferSnapshot(const std::wstring_view path) :
+    _size{ 0 },
+    _end{ 0 },
+    _attrs{},
+    _indexOffset{ 0 },
+    _rowCount{ 0 },
+    _cursorRow{ 0 },
+    _cursorColumn{ 0 }
+{
+    // A writer can carry on the file while it's open. It only ever appends
+    // and flips the header's pointer, which was read already.
+    _file.reset(CreateFileW(std::wstring{ path }.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr));
+    THROW_LAST_ERROR_IF(!_file);
+
+    LARGE_INTEGER size;
+    THROW_IF_WIN32_BOOL_FALSE(GetFileSizeEx(_file.get(), &size));
+    THROW_HR_IF(s_corrupt, size.QuadPart < static_cast<LONGLONG>(sizeof(FileHeader) + sizeof(FileFooter)));
+    _size = gsl::narrow<size_t>(size.QuadPart);
+
+    _mapping.reset(CreateFileMappingW(_file.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+    THROW_LAST_ERROR_IF(!_mapping);
+    _view.reset(static_cast<BYTE*>(MapViewOfFile(_mapping.get(), FILE_MAP_READ, 0, 0, 0)));
+    THROW_LAST_ERROR_IF(!_view);
+
+    FileHeader header;
+    memcpy(&header, _view.get(), sizeof(header));
+    THROW_HR_IF(s_corrupt, header.magic != s_magic || header.version != s_version);
+    THROW_HR_IF(s_corrupt, header.footerOffset < sizeof(FileHeader) || header.footerOffset > _size - sizeof(FileFooter));
+
+    FileFooter footer;
+    memcpy(&footer, _view.get() + header.footerOffset, sizeof(footer));
+    THROW_HR_IF(s_corrupt, footer.magic != s_magic);
+
+    // The index and the attributes have to fit between the header and the
+    // footer, in order. Rows are checked as they're read.
+    const uint64_t dataEnd = header.footerOffset;
+    THROW_HR_IF(s_corrupt, footer.indexOffset < sizeof(FileHeader) || footer.indexOffset > dataEnd);
+    THROW_HR_IF(s_corrupt, footer.rowCount > (dataEnd - footer.indexOffset) / sizeof(IndexEntry));
+    THROW_HR_IF(s_corrupt, footer.attributesOffset != footer.indexOffset + footer.rowCount * sizeof(IndexEntry));
+    THROW_HR_IF(s_corrupt, footer.attributeCount != (dataEnd - footer.attributesOffset) / RowEncoding::AttributeDictionary::s_packedSize);
+    THROW_HR_IF(s_corrupt, footer.rowCount == 0 || footer.cursorRow >= footer.rowCount);
+
+    _attrs.Unpack({ _view.get() + footer.attributesOffset, gsl::narrow<ptrdiff_t>(dataEnd - footer.attributesOffset) });
+    _indexOffset = gsl::narrow<size_t>(footer.indexOffset);
+    _rowCount = gsl::narrow<size_t>(footer.rowCount);
+    _cursorRow = gsl::narrow<size_t>(footer.cursorRow);
+    _cursorColumn = footer.cursorColumn;
+    _end = gsl::narrow<size_t>(header.footerOffset + sizeof(FileFooter));
+}
+
+size_t TextBufferSnapshot::RowCount() const noexcept
+{
+    return _rowCount;
+}
+
+// Routine Description:
+// - Returns the index of the row the cursor was on.
+size_t TextBufferSnapshot::CursorRow() const noexcept
+{
+    return _cursorRow;
+}
+
+SHORT TextBufferSnapshot::CursorColumn() const noexcept
+{
+    return _cursorColumn;
+}
+
+// Routine Description:
+// - Returns the width of the buffer a row was saved from.
+size_t TextBufferSnapshot::RowWidth(const size_t index) const
+{
+    return RowEncoding::DecodeWidth(_Row(index));
+}
+
+// Routine Description:
+// - Reads a row out of the file.
+// Arguments:
+// - index - the row to read, counting from the oldest one
+// - row - receives the row. It keeps its width; see RowEncoding.
+void TextBufferSnapshot::ReadRow(const size_t index, ROW& row) const
+{
+    RowEncoding::Decode(_Row(index), _attrs, row);
+}
+
+// Routine Description:
+// - Fills a buffer with the newest rows of the snapshot that fit in it and
+//   puts its cursor where it was saved. If the cursor was further up than
+//   that, the rows below it that don't fit are left out instead.
+// - If the buffer spills, the older rows go to its spill as they are in the
+//   file, so only the rows in the buffer are decoded now, however many there
+//   are; the others are decoded as they're scrolled to.
+// Arguments:
+// - buffer - the buffer to fill. It keeps its size.
+// Return Value:
+// - How many rows of the snapshot are older than the ones in the buffer.
+size_t TextBufferSnapshot::Restore(TextBuffer& buffer) const
+{
+    const size_t height = buffer.TotalRowCount();
+    auto first = _rowCount > height ? _rowCount - height : 0;
+    first = std::min(first, _cursorRow);
+
+    if (buffer.IsSpilling())
+    {
+        for (size_t i = 0; i < first; ++i)
+        {
+            buffer.SpillEncodedRow(_Row(i), _attrs);
+        }
+    }
+
+    for (size_t y = 0; y < height; ++y)
+    {
+        auto& row = buffer.GetRowByOffset(y);
+        if (first + y < _rowCount)
+        {
+            ReadRow(first + y, row);
+        }
+        else
+        {
+            THROW_HR_IF(E_OUTOFMEMORY, !row.Reset(buffer.GetCurrentAttributes()));
+        }
+    }
+
+    const auto width = buffer.GetSize().Width();
+    buffer.GetCursor().SetPosition({ std::clamp<SHORT>(_cursorColumn, 0, width - 1), gsl::narrow<SHORT>(_cursorRow - first) });
+    return first;
+}
+
+// Routine Description:
+// - Finds the encoding of a row in the file.
+gsl::span<const BYTE> TextBufferSnapshot::_Row(const size_t index) const
+{
+    THROW_HR_IF(E_INVALIDARG, index >= _rowCount);
+
+    IndexEntry entry;
+    memcpy(&entry, _view.get() + _indexOffset + index * sizeof(entry), sizeof(entry));
+
+    // Every row was written before the index that points to it.
+    THROW_HR_IF(s_corrupt, entry.offset < sizeof(FileHeader) || entry.offset > _indexOffset);
+    THROW_HR_IF(s_corrupt, entry.size == 0 || entry.size > _indexOffset - entry.offset);
+
+    return { _view.get() + entry.offset, gsl::narrow<ptrdiff_t>(entry.size) };
+}
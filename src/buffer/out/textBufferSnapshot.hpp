@@ -0,0 +1,113 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- textBufferSnapshot.hpp
+
+Abstract:
+- Saves the contents of a text buffer to a file, and restores them from it,
+  so that scrollback survives the host restarting.
+- The file holds every row in RowEncoding, from the oldest one that scrolled
+  out of the buffer to the last one in use, an index of where each row is,
+  the attributes the rows refer to, and a footer with the cursor. Rows that
+  scroll out of the buffer can be handed to the writer as they go, and they
+  are only written once, however often the rest of the file is committed.
+- A commit never overwrites what the last one wrote. It appends its rows, the
+  index, the attributes and the footer to the end of the file, flushes them
+  to disk, and only then points the header at the new footer. A host that
+  dies in the middle leaves the previous commit readable. Once the file is
+  mostly rows of the buffer that later commits replaced, a commit writes a
+  new file next to it instead, and moves it over the old one.
+- Restoring maps the file into memory and only decodes the rows that are
+  read. Filling a buffer decodes the rows that fit in it. Older ones are
+  copied to the buffer's spill still encoded, if it has one, and are
+  decoded there once they're scrolled to; see TextBufferSpill.
+- A writer can carry on the file it was restored from, so the rows of the
+  earlier sessions are kept without being written again.
+--*/
+
+#pragma once
+
+#include "RowEncoding.hpp"
+
+class TextBuffer;
+class TextBufferSnapshot;
+
+class TextBufferSnapshotWriter final
+{
+public:
+    static constexpr uint64_t s_defaultRewriteAfter = 16 * 1024 * 1024;
+
+    TextBufferSnapshotWriter(const std::wstring_view path, const uint64_t rewriteAfter = s_defaultRewriteAfter);
+    TextBufferSnapshotWriter(const std::wstring_view path,
+                             const TextBufferSnapshot& restored,
+                             const size_t scrolledOut,
+                             const uint64_t rewriteAfter = s_defaultRewriteAfter);
+
+    void AppendRow(const ROW& row);
+    void Commit(const TextBuffer& buffer);
+
+private:
+    // where a row is in the file, or in _pending
+    struct _Extent
+    {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    const std::wstring _path;
+    // how many bytes of replaced rows the file can hold before it's rewritten
+    const uint64_t _rewriteAfter;
+    // empty until the first commit creates the file
+    wil::unique_hfile _file;
+    RowEncoding::AttributeDictionary _attrs;
+
+    // the rows that scrolled out of the buffer before the last commit
+    std::vector<_Extent> _rows;
+    // how many bytes of the file they take
+    uint64_t _rowBytes;
+    // rows that scrolled out of the buffer since the last commit, encoded
+    std::vector<BYTE> _pending;
+    std::vector<_Extent> _pendingRows;
+    // where the next commit appends
+    uint64_t _fileEnd;
+
+    void _Append(const TextBuffer& buffer);
+    void _Rewrite(const TextBuffer& buffer);
+    std::vector<BYTE> _EncodeTail(const TextBuffer& buffer, const uint64_t offset, std::vector<_Extent>& rows);
+    void _WriteCommit(const HANDLE file, const uint64_t offset, const std::vector<BYTE>& tail) const;
+};
+
+class TextBufferSnapshot final
+{
+public:
+    TextBufferSnapshot(const std::wstring_view path);
+
+    size_t RowCount() const noexcept;
+    size_t CursorRow() const noexcept;
+    SHORT CursorColumn() const noexcept;
+
+    size_t RowWidth(const size_t index) const;
+    void ReadRow(const size_t index, ROW& row) const;
+
+    size_t Restore(TextBuffer& buffer) const;
+
+private:
+    wil::unique_hfile _file;
+    wil::unique_handle _mapping;
+    wil::unique_mapview_ptr<BYTE> _view;
+    size_t _size;
+    // where the last complete commit ends
+    size_t _end;
+
+    RowEncoding::AttributeDictionary _attrs;
+    size_t _indexOffset;
+    size_t _rowCount;
+    size_t _cursorRow;
+    SHORT _cursorColumn;
+
+    gsl::span<const BYTE> _Row(const size_t index) const;
+
+    friend class TextBufferSnapshotWriter;
+};
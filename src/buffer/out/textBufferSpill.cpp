@@ -0,0 +1,360 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "textBufferSpill.hpp"
+#include "textBuffer.hpp"
+
+// Routine Description:
+// - Creates the file rows spill to. It's deleted when the spill is destroyed.
+// Arguments:
+// - buffer - the buffer whose rows spill here. Rows are read back at its width.
+// - path - the file to create, replacing any file that's there. Reflowing
+//   the rows writes them to a second file next to it, with ".reflow" added
+//   to the name.
+// - segmentSize - how much of the file is mapped at once. It has to be a
+//   multiple of 64K, the granularity views of a file can start at, and no
+//   more than 4GB, so offsets in it fit in 32 bits.
+TextBufferSpill::TextBufferSpill(TextBuffer& buffer, const std::wstring_view path, const size_t segmentSize) :
+    _buffer{ buffer },
+    _path{ path },
+    _segmentSize{ segmentSize },
+    _rowCount{ 0 },
+    _reflows{ 0 },
+    _width{ 0 },
+    _mixedWidths{ false },
+    _attrs{},
+    _encoded{},
+    _recent{},
+    _cached{},
+    _freeSlots{},
+    _pins{}
+{
+    THROW_HR_IF(E_INVALIDARG, segmentSize == 0 || segmentSize % (64 * 1024) != 0 || segmentSize > UINT32_MAX);
+
+    _file = _CreateFile(_FilePath(_reflows));
+}
+
+// The cache is a TextBuffer, which is incomplete in the header.
+TextBufferSpill::~TextBufferSpill() = default;
+
+// Routine Description:
+// - Adds a row to the end of the spill.
+// Arguments:
+// - row - the row. Its contents aren't needed after this returns.
+void TextBufferSpill::Append(const ROW& row)
+{
+    std::lock_guard<std::mutex> lock{ _lock };
+
+    _encoded.clear();
+    RowEncoding::Encode(row, _attrs, _encoded);
+    _AppendRow(row.size());
+}
+
+// Routine Description:
+// - Adds a row that's already encoded to the end of the spill, without
+//   decoding it. This is how rows restored from a snapshot get here: they're
+//   only decoded once they're read.
+// Arguments:
+// - encoded - the encoding of the row
+// - attrs - the dictionary the encoding's attributes were added to
+void TextBufferSpill::AppendEncoded(const gsl::span<const BYTE> encoded, const RowEncoding::AttributeDictionary& attrs)
+{
+    std::lock_guard<std::mutex> lock{ _lock };
+
+    _encoded.clear();
+    RowEncoding::Translate(encoded, attrs, _attrs, _encoded);
+    _AppendRow(RowEncoding::DecodeWidth(encoded));
+}
+
+size_t TextBufferSpill::RowCount() const noexcept
+{
+    return _rowCount.load(std::memory_order_acquire);
+}
+
+// Routine Description:
+// - Reads a row back, decoding it unless it's one of the rows read recently.
+//   Any number of threads can read at once; they take turns.
+// Arguments:
+// - index - the row to read, counting from the first one that spilled
+// - read - called with the row, at the width of the buffer. The row can't be
+//   kept past the call, since another read can put a different row in its
+//   place, and the call can't read another row itself.
+void TextBufferSpill::ReadRow(const size_t index, const ReadFn& read)
+{
+    std::lock_guard<std::mutex> lock{ _lock };
+    read(_GetRow(index));
+}
+
+// Routine Description:
+// - Reads a row back like ReadRow, and keeps it in the cache for as long as
+//   it's held, so it can be read without taking the lock.
+// - Only as many rows as the cache holds can be pinned at once. Iterators pin
+//   one row each, so that's plenty.
+// Arguments:
+// - index - the row to read, counting from the first one that spilled
+// Return Value:
+// - The row, at the width of the buffer. It stays the same even if the width
+//   changes or the rows are reflowed while it's held, but it can't be held
+//   past the buffer.
+std::shared_ptr<const ROW> TextBufferSpill::PinRow(const size_t index)
+{
+    std::lock_guard<std::mutex> lock{ _lock };
+
+    const auto& row = _GetRow(index);
+    const auto slot = _recent.front().second;
+    ++_pins.at(slot);
+
+    // If the cache is made again before the pin is let go of, the pin keeps
+    // the old one alive, and there's nothing to count down.
+    return { &row, [this, cache = _cache, slot](const ROW*) noexcept {
+                std::lock_guard<std::mutex> lock{ _lock };
+                if (_cache == cache)
+                {
+                    --_pins[slot];
+                }
+            } };
+}
+
+// Routine Description:
+// - Rewraps the spilled rows for the width of the buffer, the way
+//   TextBufferReflow rewraps the buffer's own: the rows of a line that
+//   wrapped are joined and split again at the new width.
+// - The rows are written out to a new file, one line at a time, so this
+//   takes time in proportion to the spilled rows, but memory only for one
+//   line. The old file is kept until the new one is complete, so if this
+//   fails, the rows are left as they were and read back cut off or padded.
+// - A line that runs on from the last spilled row into the buffer is split
+//   where the buffer starts, as it is when the line scrolls out.
+void TextBufferSpill::Reflow()
+{
+    std::lock_guard<std::mutex> lock{ _lock };
+
+    const auto width = gsl::narrow_cast<size_t>(_buffer.GetSize().Width());
+    const auto count = _file.offsets.size();
+    if (count == 0 || (!_mixedWidths && _width == width))
+    {
+        return;
+    }
+
+    auto file = _CreateFile(_FilePath(_reflows + 1));
+
+    // Rows are decoded at the width they were written at, so none of their
+    // cells are cut off, and written at the new one.
+    const auto fill = _buffer.GetCurrentAttributes();
+    std::unique_ptr<TextBuffer> source;
+    TextBuffer target{ COORD{ gsl::narrow<SHORT>(width), 1 }, fill, 0, _buffer.GetRenderTarget() };
+    auto& targetRow = target.GetRowByOffset(0);
+    std::vector<OutputCell> line;
+
+    for (size_t index = 0; index < count; ++index)
+    {
+        const auto encoded = _Encoded(_file, index);
+        const auto rowWidth = RowEncoding::DecodeWidth(encoded);
+        if (!source || static_cast<size_t>(source->GetSize().Width()) != rowWidth)
+        {
+            source = std::make_unique<TextBuffer>(COORD{ gsl::narrow<SHORT>(rowWidth), 1 }, fill, 0, _buffer.GetRenderTarget());
+        }
+        auto& row = source->GetRowByOffset(0);
+        RowEncoding::Decode(encoded, _attrs, row);
+
+        // The same cells of each row make up the line as in TextBufferReflow::_CopyOutLine.
+        const auto& charRow = row.GetCharRow();
+        const bool wrapped = charRow.WasWrapForced();
+        const auto right = wrapped ? charRow.size() - (charRow.WasDoubleBytePadded() ? 1 : 0) : charRow.MeasureRight();
+        for (auto it = row.AsCellIter(0, right); it; ++it)
+        {
+            line.emplace_back(*it);
+        }
+
+        if (wrapped && index + 1 < count)
+        {
+            continue;
+        }
+
+        OutputCellIterator cells{ std::basic_string_view<OutputCell>{ line.data(), line.size() } };
+        do
+        {
+            targetRow.Reset(fill);
+            cells = targetRow.WriteCells(cells, 0, false, std::nullopt);
+            targetRow.GetCharRow().SetWrapForced(cells || wrapped);
+
+            _encoded.clear();
+            RowEncoding::Encode(targetRow, _attrs, _encoded);
+            _Append(file, _encoded);
+        } while (cells);
+
+        line.clear();
+    }
+
+    // The old file is deleted as it's closed. Rows in the cache are laid out
+    // the old way, so it starts over; rows that are pinned keep theirs.
+    _file = std::move(file);
+    ++_reflows;
+    _width = width;
+    _mixedWidths = false;
+    _ResetCache();
+    _rowCount.store(_file.offsets.size(), std::memory_order_release);
+}
+
+// Routine Description:
+// - Gets a row into the cache. The lock must be held.
+// Arguments:
+// - index - the row to read, counting from the first one that spilled
+// Return Value:
+// - The row, at the width of the buffer. It's good until enough other rows
+//   are read to push it out of the cache, or the buffer's width changes.
+//   It's the most recently read row in the cache.
+const ROW& TextBufferSpill::_GetRow(const size_t index)
+{
+    THROW_HR_IF(E_INVALIDARG, index >= _file.offsets.size());
+
+    if (!_cache || _cache->GetSize().Width() != _buffer.GetSize().Width())
+    {
+        _ResetCache();
+    }
+
+    const auto found = _cached.find(index);
+    if (found != _cached.end())
+    {
+        _recent.splice(_recent.begin(), _recent, found->second);
+        return _cache->GetRowByOffset(found->second->second);
+    }
+
+    if (_freeSlots.empty())
+    {
+        // Make room by dropping the least recently read row that isn't pinned.
+        const auto unpinned = std::find_if(_recent.rbegin(), _recent.rend(), [&](const auto& cached) {
+            return _pins[cached.second] == 0;
+        });
+        THROW_HR_IF(E_NOT_SUFFICIENT_BUFFER, unpinned == _recent.rend());
+
+        const auto evicted = std::prev(unpinned.base());
+        _cached.erase(evicted->first);
+        _freeSlots.push_back(evicted->second);
+        _recent.erase(evicted);
+    }
+
+    // The slot is only taken once the row is in it, so a row that fails to
+    // decode doesn't lose it.
+    const auto slot = _freeSlots.back();
+    auto& row = _cache->GetRowByOffset(slot);
+    RowEncoding::Decode(_Encoded(_file, index), _attrs, row);
+    _freeSlots.pop_back();
+
+    _recent.emplace_front(index, slot);
+    _cached.emplace(index, _recent.begin());
+    return row;
+}
+
+// Routine Description:
+// - Adds the row in _encoded to the end of the file. The lock must be held.
+// Arguments:
+// - width - the width of the row
+void TextBufferSpill::_AppendRow(const size_t width)
+{
+    _Append(_file, _encoded);
+
+    if (_file.offsets.size() == 1)
+    {
+        _width = width;
+    }
+    _mixedWidths = _mixedWidths || width != _width;
+    _rowCount.store(_file.offsets.size(), std::memory_order_release);
+}
+
+// Routine Description:
+// - Gets the name of the file the rows are in after they were reflowed the
+//   given number of times.
+std::wstring TextBufferSpill::_FilePath(const size_t reflows) const
+{
+    return reflows % 2 == 0 ? _path : _path + L".reflow";
+}
+
+// Routine Description:
+// - Creates an empty file for rows. It's deleted when it's closed.
+// Arguments:
+// - path - the file to create, replacing any file that's there
+TextBufferSpill::_File TextBufferSpill::_CreateFile(const std::wstring& path) const
+{
+    _File file{};
+    file.handle.reset(CreateFileW(path.c_str(),
+                                  GENERIC_READ | GENERIC_WRITE,
+                                  0,
+                                  nullptr,
+                                  CREATE_ALWAYS,
+                                  FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE,
+                                  nullptr));
+    THROW_LAST_ERROR_IF(!file.handle);
+    return file;
+}
+
+// Routine Description:
+// - Makes a file one segment longer and maps the new segment.
+void TextBufferSpill::_AddSegment(_File& file) const
+{
+    const uint64_t offset = static_cast<uint64_t>(file.segments.size()) * _segmentSize;
+    const uint64_t size = offset + _segmentSize;
+
+    // Mapping a file past its end grows it. Views keep their mapping open, so
+    // the mapping can be closed as soon as the segment is mapped.
+    wil::unique_handle mapping{ CreateFileMappingW(file.handle.get(), nullptr, PAGE_READWRITE, HIDWORD(size), LODWORD(size), nullptr) };
+    THROW_LAST_ERROR_IF(!mapping);
+
+    _Segment segment{};
+    segment.view.reset(static_cast<BYTE*>(MapViewOfFile(mapping.get(), FILE_MAP_WRITE, HIDWORD(offset), LODWORD(offset), _segmentSize)));
+    THROW_LAST_ERROR_IF(!segment.view);
+    segment.firstRow = file.offsets.size();
+    segment.used = 0;
+    file.segments.push_back(std::move(segment));
+}
+
+// Routine Description:
+// - Adds an encoded row to the end of a file, starting a new segment if it
+//   doesn't fit in the last one.
+void TextBufferSpill::_Append(_File& file, const std::vector<BYTE>& encoded) const
+{
+    THROW_HR_IF(E_INVALIDARG, encoded.size() > _segmentSize);
+
+    if (file.segments.empty() || file.segments.back().used + encoded.size() > _segmentSize)
+    {
+        _AddSegment(file);
+    }
+
+    auto& segment = file.segments.back();
+    memcpy(segment.view.get() + segment.used, encoded.data(), encoded.size());
+    file.offsets.push_back(gsl::narrow_cast<uint32_t>(segment.used));
+    segment.used += encoded.size();
+}
+
+// Routine Description:
+// - Finds the encoding of a row in a file.
+gsl::span<const BYTE> TextBufferSpill::_Encoded(const _File& file, const size_t index) const
+{
+    // Find the last segment that starts at or before the row.
+    const auto segment = std::prev(std::upper_bound(file.segments.cbegin(), file.segments.cend(), index, [](const size_t row, const _Segment& s) {
+        return row < s.firstRow;
+    }));
+    const auto next = std::next(segment);
+    const bool lastInSegment = index + 1 == file.offsets.size() || (next != file.segments.cend() && index + 1 == next->firstRow);
+
+    const size_t start = file.offsets[index];
+    const size_t end = lastInSegment ? segment->used : file.offsets[index + 1];
+    return { segment->view.get() + start, gsl::narrow<ptrdiff_t>(end - start) };
+}
+
+void TextBufferSpill::_ResetCache()
+{
+    _cache = std::make_shared<TextBuffer>(COORD{ _buffer.GetSize().Width(), s_cachedRows },
+                                          _buffer.GetCurrentAttributes(),
+                                          0,
+                                          _buffer.GetRenderTarget());
+    _recent.clear();
+    _cached.clear();
+    _freeSlots.clear();
+    for (SHORT slot = s_cachedRows - 1; slot >= 0; --slot)
+    {
+        _freeSlots.push_back(slot);
+    }
+    _pins.assign(s_cachedRows, 0);
+}
@@ -0,0 +1,118 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- textBufferSpill.hpp
+
+Abstract:
+- Keeps rows that scrolled out of the top of a text buffer on disk instead of
+  dropping them, so scrollback can grow without bound while the memory it
+  takes doesn't.
+- Rows are appended in RowEncoding to a temporary file that's mapped into
+  memory one fixed-size segment at a time. A row never crosses a segment, so
+  the only thing kept in memory for each row is where it starts in its
+  segment. Rows restored from a snapshot are appended as they're encoded
+  there, so they're only decoded if they're read.
+- Rows are read back by decoding them into the rows of a small text buffer
+  of their own, which holds the most recently read ones. That buffer also
+  keeps the glyphs and attributes of the decoded rows apart from the ones of
+  the buffer the rows came from.
+- Reading a row changes which rows are cached, so reads take a lock of their
+  own. Threads that only hold a shared lock on the buffer, like renderers,
+  can read rows at the same time. A row is handed out either for as long as
+  the lock is held, or pinned, which keeps it in the cache until the pin is
+  let go of.
+- The buffer addresses spilled rows as the rows above its row 0, so its cell
+  iterators walk up into them. See TextBuffer::PinRowByOffset.
+- Reflowing the buffer reflows the spilled rows too, by writing them out to
+  a new file at the new width.
+--*/
+
+#pragma once
+
+#include "RowEncoding.hpp"
+
+class TextBuffer;
+
+class TextBufferSpill final
+{
+public:
+    static constexpr size_t s_defaultSegmentSize = 64 * 1024 * 1024;
+    static constexpr SHORT s_cachedRows = 64;
+
+    using ReadFn = std::function<void(const ROW& row)>;
+
+    TextBufferSpill(TextBuffer& buffer, const std::wstring_view path, const size_t segmentSize = s_defaultSegmentSize);
+    ~TextBufferSpill();
+
+    void Append(const ROW& row);
+    void AppendEncoded(const gsl::span<const BYTE> encoded, const RowEncoding::AttributeDictionary& attrs);
+
+    size_t RowCount() const noexcept;
+    void ReadRow(const size_t index, const ReadFn& read);
+    std::shared_ptr<const ROW> PinRow(const size_t index);
+
+    void Reflow();
+
+private:
+    struct _Segment
+    {
+        wil::unique_mapview_ptr<BYTE> view;
+        // the index of the first row in the segment
+        size_t firstRow;
+        // how many bytes of the segment are in use
+        size_t used;
+    };
+
+    // A file of encoded rows, and where they are in it.
+    struct _File
+    {
+        wil::unique_hfile handle;
+        std::vector<_Segment> segments;
+        // where each row starts in its segment
+        std::vector<uint32_t> offsets;
+    };
+
+    TextBuffer& _buffer;
+    const std::wstring _path;
+    const size_t _segmentSize;
+
+    // guards everything below but the row count, which readers check without it
+    std::mutex _lock;
+    std::atomic<size_t> _rowCount;
+
+    _File _file;
+    // how many times the rows were reflowed. The file's name alternates with
+    // it, so the new file can be written next to the old one.
+    size_t _reflows;
+    // the width of the rows, unless they don't all have the same one
+    size_t _width;
+    bool _mixedWidths;
+    RowEncoding::AttributeDictionary _attrs;
+    std::vector<BYTE> _encoded;
+
+    // the rows that were read most recently. Its rows are the slots of the
+    // cache; it's made again with the width of the buffer if that changes.
+    // Pinned rows keep the one they're in alive.
+    std::shared_ptr<TextBuffer> _cache;
+    // the rows in the cache and their slots, most recently read first
+    std::list<std::pair<size_t, SHORT>> _recent;
+    std::unordered_map<size_t, std::list<std::pair<size_t, SHORT>>::iterator> _cached;
+    std::vector<SHORT> _freeSlots;
+    // how many pins there are on the row in each slot. Pinned rows stay in the cache.
+    std::vector<size_t> _pins;
+
+    std::wstring _FilePath(const size_t reflows) const;
+    _File _CreateFile(const std::wstring& path) const;
+    void _AddSegment(_File& file) const;
+    void _Append(_File& file, const std::vector<BYTE>& encoded) const;
+    void _AppendRow(const size_t width);
+    const ROW& _GetRow(const size_t index);
+    gsl::span<const BYTE> _Encoded(const _File& file, const size_t index) const;
+    void _ResetCache();
+
+#ifdef UNIT_TESTING
+    friend class TextBufferTests;
+#endif
+};
@@ -21,6 +21,7 @@ static const std::wstring FOREGROUND_KEY{ L"foreground" };
 static const std::wstring BACKGROUND_KEY{ L"background" };
 static const std::wstring COLORTABLE_KEY{ L"colorTable" };
 static const std::wstring HISTORYSIZE_KEY{ L"historySize" };
+static const std::wstring SCROLLBACKFILE_KEY{ L"scrollbackFile" };
 static const std::wstring SNAPONINPUT_KEY{ L"snapOnInput" };
 static const std::wstring CURSORCOLOR_KEY{ L"cursorColor" };
 static const std::wstring CURSORSHAPE_KEY{ L"cursorShape" };
@@ -57,6 +58,7 @@ Profile::Profile() :
     _defaultBackground{  },
     _colorTable{},
     _historySize{ DEFAULT_HISTORY_SIZE },
+    _scrollbackFile{},
     _snapOnInput{ true },
     _cursorColor{ DEFAULT_CURSOR_COLOR },
     _cursorShape{ CursorStyle::Bar },
@@ -107,6 +109,24 @@ const ColorScheme* _FindScheme(const std::vector<ColorScheme>& schemes,
     return nullptr;
 }
 
+// Function Description:
+// - Expands the environment variables in a path, like %LOCALAPPDATA%.
+// Arguments:
+// - path: the path to expand
+// Return Value:
+// - the expanded path
+std::wstring _ExpandPath(const std::wstring& path)
+{
+    const DWORD numChars = ExpandEnvironmentStrings(path.c_str(), nullptr, 0);
+    THROW_LAST_ERROR_IF(0 == numChars);
+    std::wstring expanded(numChars, L'\0');
+    THROW_LAST_ERROR_IF(0 == ExpandEnvironmentStrings(path.c_str(), expanded.data(), numChars));
+
+    // Drop the null terminator.
+    expanded.pop_back();
+    return expanded;
+}
+
 // Method Description:
 // - Create a TerminalSettings from this object. Apply our settings, as well as
 //      any colors from our colorscheme, if we have one.
@@ -124,6 +144,10 @@ TerminalSettings Profile::CreateTerminalSettings(const std::vector<ColorScheme>&
         terminalSettings.SetColorTableEntry(i, _colorTable[i]);
     }
     terminalSettings.HistorySize(_historySize);
+    if (_scrollbackFile)
+    {
+        terminalSettings.ScrollbackFile(winrt::to_hstring(_ExpandPath(_scrollbackFile.value()).c_str()));
+    }
     terminalSettings.SnapOnInput(_snapOnInput);
     terminalSettings.CursorColor(_cursorColor);
     terminalSettings.CursorHeight(_cursorHeight);
@@ -239,6 +263,10 @@ JsonObject Profile::ToJson() const
 
     }
     jsonObject.Insert(HISTORYSIZE_KEY, historySize);
+    if (_scrollbackFile)
+    {
+        jsonObject.Insert(SCROLLBACKFILE_KEY, JsonValue::CreateStringValue(_scrollbackFile.value()));
+    }
     jsonObject.Insert(SNAPONINPUT_KEY, snapOnInput);
     jsonObject.Insert(CURSORCOLOR_KEY, cursorColor);
 
@@ -339,6 +367,10 @@ Profile Profile::FromJson(winrt::Windows::Data::Json::JsonObject json)
         // TODO:MSFT:20642297 - Use a sentinel value (-1) for "Infinite scrollback"
         result._historySize = static_cast<int32_t>(json.GetNamedNumber(HISTORYSIZE_KEY));
     }
+    if (json.HasKey(SCROLLBACKFILE_KEY))
+    {
+        result._scrollbackFile = json.GetNamedString(SCROLLBACKFILE_KEY);
+    }
     if (json.HasKey(SNAPONINPUT_KEY))
     {
         result._snapOnInput = json.GetNamedBoolean(SNAPONINPUT_KEY);
@@ -68,6 +68,8 @@ private:
     std::optional<uint32_t> _defaultBackground;
     std::array<uint32_t, COLOR_TABLE_SIZE> _colorTable;
     int32_t _historySize;
+    // where the scrollback is saved between sessions, if anywhere
+    std::optional<std::wstring> _scrollbackFile;
     bool _snapOnInput;
     uint32_t _cursorColor;
     uint32_t _cursorHeight;
@@ -12,6 +12,7 @@
 #endif
 
 #include <conpty-universal.h>
+#include "../../types/inc/Utf8OutputPipeline.hpp"
 
 namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 {
@@ -139,37 +140,34 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 
     DWORD ConhostConnection::_OutputThread()
     {
-        const size_t bufferSize = 4096;
-        BYTE buffer[bufferSize];
-        DWORD dwRead;
-        while (true)
-        {
-            dwRead = 0;
-            bool fSuccess = false;
-
-            fSuccess = !!ReadFile(_outPipe, buffer, bufferSize, &dwRead, nullptr);
-            if (!fSuccess)
-            {
-                if (_closing)
-                {
-                    // This is okay, break out to kill the thread
-                    return 0;
-                }
-                else
-                {
-                    _disconnectHandlers();
-                    return (DWORD)-1;
-                }
-
+        // Read in large chunks and decode incrementally, so that multi-byte
+        // UTF-8 sequences split across two reads survive intact and a burst
+        // of output costs one hstring per read rather than one per few hundred bytes.
+        // The output is decoded and handed to the terminal on a thread of the
+        // pipeline's own, so that this one can keep the pipe drained while the
+        // terminal is busy parsing. Otherwise the client blocks on a full pipe.
+        ::Microsoft::Console::Types::ParallelUtf8OutputPipeline pipeline{
+            [this](char* const buffer, const size_t capacity, size_t& read) {
+                DWORD dwRead = 0;
+                const bool fSuccess = !!ReadFile(_outPipe, buffer, static_cast<DWORD>(capacity), &dwRead, nullptr);
+                read = dwRead;
+                return fSuccess;
+            },
+            [this](const std::wstring_view text) {
+                // Pass the output to our registered event handlers
+                _outputHandlers(winrt::hstring{ text });
             }
-            if (dwRead == 0) continue;
-            // Convert buffer to hstring
-            char* pchStr = (char*)(buffer);
-            std::string str{pchStr, dwRead};
-            auto hstr = winrt::to_hstring(str);
-
-            // Pass the output to our registered event handlers
-            _outputHandlers(hstr);
+        };
+
+        pipeline.Run();
+
+        if (_closing)
+        {
+            // This is okay, break out to kill the thread
+            return 0;
         }
+
+        _disconnectHandlers();
+        return (DWORD)-1;
     }
 }
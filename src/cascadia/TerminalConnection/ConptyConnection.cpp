@@ -5,6 +5,7 @@
 #include "ConptyConnection.h"
 
 #include <Windows.h>
+#include "../../types/inc/Utf8OutputPipeline.hpp"
 
 namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 {
@@ -230,29 +231,23 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 
     DWORD ConptyConnection::_OutputThread()
     {
-        BYTE buffer[256];
-        DWORD dwRead;
-        while (true)
-        {
-            dwRead = 0;
-            bool fSuccess = false;
-
-            fSuccess = !!ReadFile(_outPipe, buffer, ARRAYSIZE(buffer), &dwRead, nullptr);
-
-            THROW_LAST_ERROR_IF(!fSuccess);
-
-            // Convert buffer to hstring
-            char* pchStr = (char*)(buffer);
-            std::string str{pchStr, dwRead};
-            auto hstr = winrt::to_hstring(str);
+        // Parse on a thread of the pipeline's own, so that this one can keep
+        // the pipe drained while the terminal is busy with the last read.
+        ::Microsoft::Console::Types::ParallelUtf8OutputPipeline pipeline{
+            [this](char* const buffer, const size_t capacity, size_t& read) {
+                DWORD dwRead = 0;
+                const bool fSuccess = !!ReadFile(_outPipe, buffer, static_cast<DWORD>(capacity), &dwRead, nullptr);
+                read = dwRead;
+                return fSuccess;
+            },
+            [this](const std::wstring_view text) {
+                // Pass the output to our registered event handlers
+                _outputHandlers(winrt::hstring{ text });
+            }
+        };
 
-            // Pass the output to our registered event handlers
-            _outputHandlers(hstr);
+        pipeline.Run();
 
-            // if (this->_active)
-            // {
-            //     _pfnReadCallback(buffer, dwRead);
-            // }
-        }
+        THROW_LAST_ERROR();
     }
 }
@@ -5,10 +5,18 @@
 #include "EchoConnection.h"
 #include <sstream>
 
+#include "../../types/inc/Utf8OutputPipeline.hpp"
+
 namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 {
-    EchoConnection::EchoConnection()
+    EchoConnection::EchoConnection() :
+        _closing{ false }
+    {
+    }
+
+    EchoConnection::~EchoConnection()
     {
+        Close();
     }
 
     winrt::event_token EchoConnection::TerminalOutput(TerminalConnection::TerminalOutputEventArgs const& handler)
@@ -32,14 +40,63 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
         token;
      }
 
+    // Method Description:
+    // - Starts echoing. Input is encoded as UTF-8 and sent back through the
+    //   same output pipeline a pseudoconsole's pipe goes through, so the whole
+    //   path from a connection to the terminal can be driven without a client.
     void EchoConnection::Start()
     {
+        _outputThread = std::thread([this]() {
+            ::Microsoft::Console::Types::ParallelUtf8OutputPipeline pipeline{
+                [this](char* const buffer, const size_t capacity, size_t& read) {
+                    return _ReadInput(buffer, capacity, read);
+                },
+                [this](const std::wstring_view text) {
+                    _EchoOutput(text);
+                }
+            };
+            pipeline.Run();
+        });
     }
 
     void EchoConnection::WriteInput(hstring const& data)
+    {
+        const std::string bytes = winrt::to_string(data);
+        {
+            std::lock_guard<std::mutex> lock{ _inputLock };
+            _input.append(bytes);
+        }
+        _inputAvailable.notify_one();
+    }
+
+    // Method Description:
+    // - Stands in for reading the output pipe: waits for input to echo and
+    //   hands out as much of it as fits.
+    // Arguments:
+    // - buffer: receives the bytes
+    // - capacity: the size of buffer
+    // - read: receives the number of bytes written to buffer
+    // Return Value:
+    // - false once the connection is closed and everything has been echoed.
+    bool EchoConnection::_ReadInput(char* const buffer, const size_t capacity, size_t& read)
+    {
+        std::unique_lock<std::mutex> lock{ _inputLock };
+        _inputAvailable.wait(lock, [this]() { return _closing || !_input.empty(); });
+        if (_input.empty())
+        {
+            return false;
+        }
+
+        read = std::min(capacity, _input.size());
+        std::copy_n(_input.data(), read, buffer);
+        _input.erase(0, read);
+        return true;
+    }
+
+    void EchoConnection::_EchoOutput(const std::wstring_view text)
     {
         std::wstringstream prettyPrint;
-        for (wchar_t wch : data)
+        for (wchar_t wch : text)
         {
             if (wch < 0x20)
             {
@@ -67,6 +124,15 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 
     void EchoConnection::Close()
     {
-        throw hresult_not_implemented();
+        {
+            std::lock_guard<std::mutex> lock{ _inputLock };
+            _closing = true;
+        }
+        _inputAvailable.notify_one();
+
+        if (_outputThread.joinable())
+        {
+            _outputThread.join();
+        }
     }
 }
@@ -5,11 +5,16 @@
 
 #include "EchoConnection.g.h"
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
 namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 {
     struct EchoConnection : EchoConnectionT<EchoConnection>
     {
         EchoConnection();
+        ~EchoConnection();
 
         winrt::event_token TerminalOutput(TerminalConnection::TerminalOutputEventArgs const& handler);
         void TerminalOutput(winrt::event_token const& token) noexcept;
@@ -22,6 +27,18 @@ namespace winrt::Microsoft::Terminal::TerminalConnection::implementation
 
     private:
         winrt::event<TerminalConnection::TerminalOutputEventArgs> _outputHandlers;
+
+        // Input waiting to be echoed, as the UTF-8 a client would have written
+        // to a pseudoconsole's output pipe.
+        std::mutex _inputLock;
+        std::condition_variable _inputAvailable;
+        std::string _input;
+        bool _closing;
+
+        std::thread _outputThread;
+
+        bool _ReadInput(char* const buffer, const size_t capacity, size_t& read);
+        void _EchoOutput(const std::wstring_view text);
     };
 }
 
@@ -238,6 +238,9 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
             _connection.Close();
         }
 
+        // Nothing more gets written, so this saves all of it.
+        _terminal->SaveScrollback();
+
         _renderer->TriggerTeardown();
 
         _swapChainPanel = nullptr;
@@ -265,7 +268,7 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         auto chain = _renderEngine->GetSwapChain();
         _swapChainPanel.Dispatcher().RunAsync(CoreDispatcherPriority::High, [=]()
         {
-            auto lock = _terminal->LockForWriting();
+            auto frameLock = _renderData->LockForFrame();
             auto nativePanel = _swapChainPanel.as<ISwapChainPanelNative>();
             nativePanel->SetSwapChain(chain.Get());
         });
@@ -282,14 +285,18 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         const auto windowHeight = _swapChainPanel.ActualHeight();
 
         _terminal = new ::Microsoft::Terminal::Core::Terminal();
+        _renderData = std::make_unique<::Microsoft::Terminal::Core::SnapshotRenderData>(*_terminal);
 
         // First create the render thread.
         auto renderThread = std::make_unique<::Microsoft::Console::Render::RenderThread>();
         // Stash a local pointer to the render thread, so we can enable it after
         //       we hand off ownership to the renderer.
         auto* const localPointerToThread = renderThread.get();
-        _renderer = std::make_unique<::Microsoft::Console::Render::Renderer>(_terminal, nullptr, 0, std::move(renderThread));
-        ::Microsoft::Console::Render::IRenderTarget& renderTarget = *_renderer;
+        // The renderer paints the terminal's snapshots, and the terminal's
+        //      buffer only wakes it up; the snapshots tell it what changed.
+        _renderer = std::make_unique<::Microsoft::Console::Render::Renderer>(_renderData.get(), nullptr, 0, std::move(renderThread));
+        _renderData->Connect(*_renderer, *localPointerToThread);
+        ::Microsoft::Console::Render::IRenderTarget& renderTarget = *_renderData;
 
         // Set up the DX Engine
         auto dxEngine = std::make_unique<::Microsoft::Console::Render::DxEngine>();
@@ -342,10 +349,9 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         auto chain = _renderEngine->GetSwapChain();
         _swapChainPanel.Dispatcher().RunAsync(CoreDispatcherPriority::High, [this, chain]()
         {
-            _terminal->LockConsole();
+            auto frameLock = _renderData->LockForFrame();
             auto nativePanel = _swapChainPanel.as<ISwapChainPanelNative>();
             nativePanel->SetSwapChain(chain.Get());
-            _terminal->UnlockConsole();
         });
 
         // Set up the height of the ScrollViewer and the grid we're using to fake our scrolling height
@@ -546,8 +552,6 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
 
                 // handle ALT key
                 _terminal->SetBoxSelection(altEnabled);
-
-                _renderer->TriggerSelection();
             }
             else if (point.Properties().IsRightButtonPressed())
             {
@@ -605,7 +609,6 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
 
                 // save location (for rendering) + render
                 _terminal->SetEndSelectionPosition(terminalPosition);
-                _renderer->TriggerSelection();
             }
         }
         else if (ptr.PointerDeviceType() == Windows::Devices::Input::PointerDeviceType::Touch && _touchAnchor)
@@ -813,6 +816,7 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
     void TermControl::_UpdateFont()
     {
         auto lock = _terminal->LockForWriting();
+        auto frameLock = _renderData->LockForFrame();
 
         const int newDpi = static_cast<int>(static_cast<double>(USER_DEFAULT_SCREEN_DPI) * _swapChainPanel.CompositionScaleX());
 
@@ -849,6 +853,7 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         const auto dpi = (int)(scale * USER_DEFAULT_SCREEN_DPI);
 
         // TODO: MSFT: 21169071 - Shouldn't this all happen through _renderer and trigger the invalidate automatically on DPI change?
+        auto frameLock = _renderData->LockForFrame();
         THROW_IF_FAILED(_renderEngine->UpdateDpi(dpi));
         _renderer->TriggerRedrawAll();
     }
@@ -865,6 +870,7 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         size.cy = static_cast<long>(newHeight);
 
         // Tell the dx engine that our window is now the new size.
+        auto frameLock = _renderData->LockForFrame();
         THROW_IF_FAILED(_renderEngine->SetWindowSize(size));
 
         // Invalidate everything
@@ -874,6 +880,7 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         const auto viewInPixels = Viewport::FromDimensions({ 0, 0 },
                                                            { static_cast<short>(size.cx), static_cast<short>(size.cy) });
         const auto vp = _renderEngine->GetViewportInCharacters(viewInPixels);
+        frameLock.unlock();
 
         // If this function succeeds with S_FALSE, then the terminal didn't
         //      actually change size. No need to notify the connection of this
@@ -960,7 +967,6 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
         const auto copiedData = _terminal->RetrieveSelectedTextFromBuffer(trimTrailingWhitespace);
 
         _terminal->ClearSelection();
-        _renderer->TriggerSelection();
 
         // send data up for clipboard
         _clipboardCopyHandlers(copiedData);
@@ -10,6 +10,7 @@
 #include "../../renderer/base/Renderer.hpp"
 #include "../../renderer/dx/DxRenderer.hpp"
 #include "../../cascadia/TerminalCore/Terminal.hpp"
+#include "../../cascadia/TerminalCore/SnapshotRenderData.hpp"
 #include "../../cascadia/inc/cppwinrt_utils.h"
 
 namespace winrt::Microsoft::Terminal::TerminalControl::implementation
@@ -70,6 +71,9 @@ namespace winrt::Microsoft::Terminal::TerminalControl::implementation
 
         ::Microsoft::Terminal::Core::Terminal* _terminal;
 
+        // The renderer paints from the terminal's snapshots through this, so
+        // it has to outlive the renderer.
+        std::unique_ptr<::Microsoft::Terminal::Core::SnapshotRenderData> _renderData;
         std::unique_ptr<::Microsoft::Console::Render::Renderer> _renderer;
         std::unique_ptr<::Microsoft::Console::Render::DxEngine> _renderEngine;
 
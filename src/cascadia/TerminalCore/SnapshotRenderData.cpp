@@ -0,0 +1,345 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "pch.h"
+#include "SnapshotRenderData.hpp"
+
+using namespace Microsoft::Terminal::Core;
+using namespace Microsoft::Console::Types;
+using namespace Microsoft::Console::Render;
+
+SnapshotRenderData::SnapshotRenderData(Terminal& terminal) :
+    _terminal{ terminal },
+    _renderer{ nullptr },
+    _renderThread{ nullptr },
+    _frame{ terminal.GetSnapshot() },
+    _emptyRenderTarget{},
+    _emptyScreen{ { 1, 1 }, TextAttribute{}, 0, _emptyRenderTarget }
+{
+}
+
+// Method Description:
+// - Hooks up the renderer that paints from this, which is made after it.
+//   Until then, the buffer's invalidations are dropped.
+// Arguments:
+// - renderer: the renderer, to invalidate what changed between two frames
+// - renderThread: its thread, to wake up when the terminal changed
+void SnapshotRenderData::Connect(IRenderTarget& renderer, IRenderThread& renderThread) noexcept
+{
+    std::lock_guard<std::mutex> lock{ _frameLock };
+    _renderer = &renderer;
+    _renderThread = &renderThread;
+}
+
+// Method Description:
+// - Keeps the renderer from starting a frame, for changing its engines. The
+//   terminal's lock doesn't do that anymore, since the renderer doesn't take it.
+//   A caller that also holds the terminal's write lock has to take that first.
+// Return Value:
+// - a unique_lock that lets frames be painted again when it's destructed.
+[[nodiscard]]
+std::unique_lock<std::mutex> SnapshotRenderData::LockForFrame()
+{
+    return std::unique_lock<std::mutex>{ _frameLock };
+}
+
+Viewport SnapshotRenderData::GetViewport() noexcept
+{
+    return Viewport::FromDimensions({ 0, 0 }, _frame->viewport.Dimensions());
+}
+
+const TextBuffer& SnapshotRenderData::GetTextBuffer() noexcept
+{
+    return _frame->screen ? *_frame->screen : _emptyScreen;
+}
+
+const FontInfo& SnapshotRenderData::GetFontInfo() noexcept
+{
+    return _terminal.GetFontInfo();
+}
+
+const TextAttribute SnapshotRenderData::GetDefaultBrushColors() noexcept
+{
+    return TextAttribute{};
+}
+
+const COLORREF SnapshotRenderData::GetForegroundColor(const TextAttribute& attr) const noexcept
+{
+    const auto& colorTable = _frame->colorTable;
+    return 0xff000000 | attr.CalculateRgbForeground({ &colorTable[0], colorTable.size() }, _frame->defaultForeground, _frame->defaultBackground);
+}
+
+const COLORREF SnapshotRenderData::GetBackgroundColor(const TextAttribute& attr) const noexcept
+{
+    const auto& colorTable = _frame->colorTable;
+    const auto bgColor = attr.CalculateRgbBackground({ &colorTable[0], colorTable.size() }, _frame->defaultForeground, _frame->defaultBackground);
+    // We only care about alpha for the default BG (which enables acrylic)
+    // If the bg isn't the default bg color, then make it fully opaque.
+    if (!attr.BackgroundIsDefault())
+    {
+        return 0xff000000 | bgColor;
+    }
+    return bgColor;
+}
+
+COORD SnapshotRenderData::GetCursorPosition() const noexcept
+{
+    return _ToScreen(*_frame, _frame->cursorPosition);
+}
+
+bool SnapshotRenderData::IsCursorVisible() const noexcept
+{
+    return _frame->cursorVisible;
+}
+
+bool SnapshotRenderData::IsCursorOn() const noexcept
+{
+    return _frame->cursorOn;
+}
+
+ULONG SnapshotRenderData::GetCursorHeight() const noexcept
+{
+    return _frame->cursorHeight;
+}
+
+ULONG SnapshotRenderData::GetCursorPixelWidth() const noexcept
+{
+    return 1;
+}
+
+CursorType SnapshotRenderData::GetCursorStyle() const noexcept
+{
+    return _frame->cursorStyle;
+}
+
+COLORREF SnapshotRenderData::GetCursorColor() const noexcept
+{
+    return _frame->cursorColor;
+}
+
+bool SnapshotRenderData::IsCursorDoubleWidth() const noexcept
+{
+    return false;
+}
+
+const std::vector<RenderOverlay> SnapshotRenderData::GetOverlays() const noexcept
+{
+    return {};
+}
+
+const bool SnapshotRenderData::IsGridLineDrawingAllowed() noexcept
+{
+    return true;
+}
+
+std::vector<Viewport> SnapshotRenderData::GetSelectionRects() noexcept
+{
+    std::vector<Viewport> result;
+
+    try
+    {
+        for (const auto& lineRect : _frame->selection)
+        {
+            const auto top = _ToScreen(*_frame, { lineRect.Left, lineRect.Top });
+            const auto bottom = _ToScreen(*_frame, { lineRect.Right, lineRect.Bottom });
+            result.emplace_back(Viewport::FromInclusive({ top.X, top.Y, bottom.X, bottom.Y }));
+        }
+    }
+    CATCH_LOG();
+
+    return result;
+}
+
+const std::wstring SnapshotRenderData::GetConsoleTitle() const noexcept
+{
+    return _frame->title;
+}
+
+// Method Description:
+// - Starts a frame: takes the latest snapshot to paint, and invalidates what
+//   changed since the one painted last. It doesn't lock the terminal, so it
+//   doesn't wait for output that's being written; that output is painted in
+//   the next frame.
+//   Callers should make sure to also call SnapshotRenderData::UnlockConsole
+//   once they're done painting.
+void SnapshotRenderData::LockConsole() noexcept
+{
+    _frameLock.lock();
+    _terminal.NotifyFrameStart();
+
+    const auto previous = std::move(_frame);
+    _frame = _terminal.GetSnapshot();
+
+    if (_renderer)
+    {
+        try
+        {
+            _Invalidate(*previous, *_frame);
+        }
+        CATCH_LOG();
+    }
+}
+
+// Method Description:
+// - Ends a frame started with SnapshotRenderData::LockConsole. The snapshot
+//   stays around until the next frame, to compare it with.
+void SnapshotRenderData::UnlockConsole() noexcept
+{
+    _frameLock.unlock();
+}
+
+// Method Description:
+// - Invalidates what's different on the screen of the snapshot that's about to
+//   be painted from the screen of the one painted before. The renderer calls
+//   back into this for the viewport, which is the new one's by then.
+//   Called on the render thread, in between frames.
+// Arguments:
+// - previous: the snapshot painted last
+// - current: the snapshot about to be painted
+void SnapshotRenderData::_Invalidate(const TerminalSnapshot& previous, const TerminalSnapshot& current)
+{
+    if (&previous == &current)
+    {
+        return;
+    }
+
+    const auto height = current.viewport.Height();
+    const auto scrolled = current.firstRow - previous.firstRow;
+
+    if (previous.viewport.Dimensions() != current.viewport.Dimensions() ||
+        current.allRowsChangedGeneration > previous.bufferGeneration ||
+        previous.colorTable != current.colorTable ||
+        previous.defaultForeground != current.defaultForeground ||
+        previous.defaultBackground != current.defaultBackground)
+    {
+        _renderer->TriggerRedrawAll();
+    }
+    else
+    {
+        if (scrolled != 0 && std::abs(scrolled) < height)
+        {
+            // The engines move what they painted up or down, and invalidate
+            // the rows that come in.
+            const COORD delta{ 0, gsl::narrow_cast<SHORT>(-scrolled) };
+            _renderer->TriggerScroll(&delta);
+        }
+
+        // A row that was on the screen before, and still has the same
+        // generation, is still the same row; see TerminalSnapshot::rowGenerations.
+        for (SHORT y = 0; y < height; ++y)
+        {
+            const auto before = y + scrolled;
+            if (before < 0 || before >= height || previous.rowGenerations.at(gsl::narrow_cast<size_t>(before)) != current.rowGenerations.at(y))
+            {
+                _renderer->TriggerRedraw(Viewport::FromDimensions({ 0, y }, current.viewport.Width(), 1));
+            }
+        }
+
+        if (scrolled != 0 ||
+            previous.cursorPosition != current.cursorPosition ||
+            previous.cursorVisible != current.cursorVisible ||
+            previous.cursorOn != current.cursorOn ||
+            previous.cursorHeight != current.cursorHeight ||
+            previous.cursorStyle != current.cursorStyle ||
+            previous.cursorColor != current.cursorColor)
+        {
+            // Where the cursor was painted, where scrolling moved that to,
+            // and where it is now.
+            auto painted = _ToScreen(previous, previous.cursorPosition);
+            _renderer->TriggerRedrawCursor(&painted);
+            if (std::abs(scrolled) < height)
+            {
+                painted.Y -= gsl::narrow_cast<SHORT>(scrolled);
+                _renderer->TriggerRedrawCursor(&painted);
+            }
+            auto cursor = _ToScreen(current, current.cursorPosition);
+            _renderer->TriggerRedrawCursor(&cursor);
+        }
+    }
+
+    // The renderer remembers the selection it painted, and invalidates that too.
+    if (scrolled != 0 || !std::equal(previous.selection.begin(), previous.selection.end(), current.selection.begin(), current.selection.end(), [](const SMALL_RECT& a, const SMALL_RECT& b) {
+            return a.Left == b.Left && a.Top == b.Top && a.Right == b.Right && a.Bottom == b.Bottom;
+        }))
+    {
+        _renderer->TriggerSelection();
+    }
+
+    if (previous.title != current.title)
+    {
+        _renderer->TriggerTitleChange();
+    }
+}
+
+// Method Description:
+// - Wakes the render thread up to paint the latest snapshot, if anything
+//   paints from this yet.
+void SnapshotRenderData::_Wake()
+{
+    if (_renderThread)
+    {
+        _renderThread->NotifyPaint();
+    }
+}
+
+// Converts a position in the buffer to one on the snapshot's screen.
+COORD SnapshotRenderData::_ToScreen(const TerminalSnapshot& snapshot, const COORD position) noexcept
+{
+    return { position.X, gsl::narrow_cast<SHORT>(position.Y - snapshot.viewport.Top()) };
+}
+
+void SnapshotRenderData::TriggerRedraw(const Viewport& /*region*/)
+{
+    _Wake();
+}
+
+void SnapshotRenderData::TriggerRedraw(const COORD* const /*pcoord*/)
+{
+    _Wake();
+}
+
+void SnapshotRenderData::TriggerRedrawCursor(const COORD* const /*pcoord*/)
+{
+    _Wake();
+}
+
+// The buffer asks for this whenever it scrolls, and after a flood of output it
+// fast-forwarded through. Either way, the rows that changed have new
+// generations, and only those are painted again.
+void SnapshotRenderData::TriggerRedrawAll()
+{
+    _Wake();
+}
+
+void SnapshotRenderData::TriggerTeardown()
+{
+    if (_renderer)
+    {
+        _renderer->TriggerTeardown();
+    }
+}
+
+void SnapshotRenderData::TriggerSelection()
+{
+    _Wake();
+}
+
+void SnapshotRenderData::TriggerScroll()
+{
+    _Wake();
+}
+
+void SnapshotRenderData::TriggerScroll(const COORD* const /*pcoordDelta*/)
+{
+    _Wake();
+}
+
+void SnapshotRenderData::TriggerCircling()
+{
+    _Wake();
+}
+
+void SnapshotRenderData::TriggerTitleChange()
+{
+    _Wake();
+}
@@ -0,0 +1,106 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- SnapshotRenderData.hpp
+
+Abstract:
+- Lets a renderer paint a Terminal from its snapshots (see TerminalSnapshot)
+  instead of from its buffer, so a frame never waits for output to be
+  written, and output never waits for a frame to be painted.
+- The renderer sees the screen of the snapshot it's painting: a buffer just
+  the size of the viewport, with the viewport at its origin. At the start of
+  every frame, the latest snapshot is compared with the one painted before,
+  and only what changed in between is invalidated: the rows that aren't the
+  same rows anymore, the cursor, the selection and the title. When the screen
+  scrolled, the engines move what they painted along with it.
+- It's also the render target of the terminal's buffer. The buffer
+  invalidates regions in its own coordinates, which the renderer doesn't use
+  anymore, and everything it asks to have painted again is in the snapshots,
+  so its invalidations only wake the render thread up to look at the latest
+  one.
+--*/
+
+#pragma once
+
+#include "Terminal.hpp"
+#include "../../renderer/inc/DummyRenderTarget.hpp"
+#include "../../renderer/inc/IRenderThread.hpp"
+
+namespace Microsoft::Terminal::Core
+{
+    class SnapshotRenderData;
+}
+
+class Microsoft::Terminal::Core::SnapshotRenderData final :
+    public Microsoft::Console::Render::IRenderData,
+    public Microsoft::Console::Render::IRenderTarget
+{
+public:
+    SnapshotRenderData(Terminal& terminal);
+    virtual ~SnapshotRenderData() {};
+
+    void Connect(Microsoft::Console::Render::IRenderTarget& renderer,
+                 Microsoft::Console::Render::IRenderThread& renderThread) noexcept;
+
+    [[nodiscard]]
+    std::unique_lock<std::mutex> LockForFrame();
+
+    #pragma region IRenderData
+    Microsoft::Console::Types::Viewport GetViewport() noexcept override;
+    const TextBuffer& GetTextBuffer() noexcept override;
+    const FontInfo& GetFontInfo() noexcept override;
+    const TextAttribute GetDefaultBrushColors() noexcept override;
+    const COLORREF GetForegroundColor(const TextAttribute& attr) const noexcept override;
+    const COLORREF GetBackgroundColor(const TextAttribute& attr) const noexcept override;
+    COORD GetCursorPosition() const noexcept override;
+    bool IsCursorVisible() const noexcept override;
+    bool IsCursorOn() const noexcept override;
+    ULONG GetCursorHeight() const noexcept override;
+    ULONG GetCursorPixelWidth() const noexcept override;
+    CursorType GetCursorStyle() const noexcept override;
+    COLORREF GetCursorColor() const noexcept override;
+    bool IsCursorDoubleWidth() const noexcept override;
+    const std::vector<Microsoft::Console::Render::RenderOverlay> GetOverlays() const noexcept override;
+    const bool IsGridLineDrawingAllowed() noexcept override;
+    std::vector<Microsoft::Console::Types::Viewport> GetSelectionRects() noexcept override;
+    const std::wstring GetConsoleTitle() const noexcept override;
+    void LockConsole() noexcept override;
+    void UnlockConsole() noexcept override;
+    #pragma endregion
+
+    #pragma region IRenderTarget
+    void TriggerRedraw(const Microsoft::Console::Types::Viewport& region) override;
+    void TriggerRedraw(const COORD* const pcoord) override;
+    void TriggerRedrawCursor(const COORD* const pcoord) override;
+    void TriggerRedrawAll() override;
+    void TriggerTeardown() override;
+    void TriggerSelection() override;
+    void TriggerScroll() override;
+    void TriggerScroll(const COORD* const pcoordDelta) override;
+    void TriggerCircling() override;
+    void TriggerTitleChange() override;
+    #pragma endregion
+
+private:
+    Terminal& _terminal;
+
+    Microsoft::Console::Render::IRenderTarget* _renderer;
+    Microsoft::Console::Render::IRenderThread* _renderThread;
+
+    // Held by the renderer from LockConsole to UnlockConsole, and by whoever
+    // changes its engines in between frames; see LockForFrame.
+    std::mutex _frameLock;
+    // The snapshot the renderer is painting, or painted last.
+    std::shared_ptr<const TerminalSnapshot> _frame;
+
+    // What the renderer is given before the terminal publishes its first screen.
+    DummyRenderTarget _emptyRenderTarget;
+    TextBuffer _emptyScreen;
+
+    void _Wake();
+    void _Invalidate(const TerminalSnapshot& previous, const TerminalSnapshot& current);
+
+    static COORD _ToScreen(const TerminalSnapshot& snapshot, const COORD position) noexcept;
+};
@@ -5,10 +5,12 @@
 #include "Terminal.hpp"
 #include "../../terminal/parser/OutputStateMachineEngine.hpp"
 #include "TerminalDispatch.hpp"
+#include "../../buffer/out/textBufferExport.hpp"
 #include "../../inc/unicode.hpp"
 #include "../../inc/DefaultSettings.h"
 #include "../../inc/argb.h"
 #include "../../types/inc/utils.hpp"
+#include "../../renderer/inc/DummyRenderTarget.hpp"
 
 #include "winrt/Microsoft.Terminal.Settings.h"
 
@@ -45,7 +47,15 @@ Terminal::Terminal() :
     _boxSelection{ false },
     _selectionActive{ false },
     _selectionAnchor{ 0, 0 },
-    _endSelectionPosition { 0, 0 }
+    _endSelectionPosition { 0, 0 },
+    _snapshot{ std::make_shared<const TerminalSnapshot>() },
+    _snapshotGeneration{ 0 },
+    _fastForwardEnabled{ true },
+    _rowsScrolledSinceFrame{ 0 },
+    _fastForwarding{ false },
+    _fastForwardScrolled{ false },
+    _scrollbackWriter{},
+    _lastScrollbackCommit{}
 {
     _stateMachine = std::make_unique<StateMachine>(new OutputStateMachineEngine(new TerminalDispatch(*this)));
 
@@ -69,6 +79,7 @@ void Terminal::Create(COORD viewportSize, SHORT scrollbackLines, IRenderTarget&
     TextAttribute attr{};
     UINT cursorSize = 12;
     _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, renderTarget);
+    _PublishSnapshot();
 }
 
 // Method Description:
@@ -80,12 +91,125 @@ void Terminal::CreateFromSettings(winrt::Microsoft::Terminal::Settings::ICoreSet
             Microsoft::Console::Render::IRenderTarget& renderTarget)
 {
     const COORD viewportSize{ static_cast<short>(settings.InitialCols()), static_cast<short>(settings.InitialRows()) };
-    // TODO:MSFT:20642297 - Support infinite scrollback here, if HistorySize is -1
-    Create(viewportSize, static_cast<short>(settings.HistorySize()), renderTarget);
+    const auto historySize = settings.HistorySize();
+    if (historySize < 0)
+    {
+        // Infinite scrollback: the buffer keeps the usual amount of history,
+        // and the rows that scroll out of it go to a file.
+        Create(viewportSize, DEFAULT_HISTORY_SIZE, renderTarget);
+        EnableInfiniteScrollback();
+    }
+    else
+    {
+        Create(viewportSize, static_cast<short>(historySize), renderTarget);
+    }
+
+    const auto scrollbackFile = settings.ScrollbackFile();
+    if (!scrollbackFile.empty())
+    {
+        RestoreScrollback(scrollbackFile);
+    }
 
     UpdateSettings(settings);
 }
 
+// Method Description:
+// - Keeps the rows that scroll out of the top of the buffer in a temporary
+//   file instead of dropping them, so the scrollback has no limit. They're
+//   shown above the buffer's rows, and the scroll position counts them.
+// - If the file can't be made, the scrollback is only the buffer's.
+void Terminal::EnableInfiniteScrollback() noexcept
+{
+    try
+    {
+        std::array<wchar_t, MAX_PATH + 1> directory{};
+        THROW_LAST_ERROR_IF(GetTempPathW(gsl::narrow<DWORD>(directory.size()), directory.data()) == 0);
+        std::array<wchar_t, MAX_PATH + 1> path{};
+        THROW_LAST_ERROR_IF(GetTempFileNameW(directory.data(), L"wt", 0, path.data()) == 0);
+        auto removeFile = wil::scope_exit([&]() noexcept { DeleteFileW(path.data()); });
+
+        auto lock = LockForWriting();
+        _buffer->SpillTo(path.data());
+        removeFile.release();
+    }
+    CATCH_LOG();
+}
+
+// Method Description:
+// - Fills the buffer with the scrollback saved in a file by an earlier
+//   session, and keeps saving it there from now on. Only the rows that fit
+//   in the buffer are read now. With infinite scrollback, the older ones are
+//   handed to the spill as they are in the file, and read once they're
+//   scrolled to; otherwise they stay in the file without being shown.
+// - If there's no file, or it can't be read, the buffer starts out empty,
+//   and the file is replaced the first time the scrollback is saved.
+// Arguments:
+// - path: the file to restore from and save to
+void Terminal::RestoreScrollback(const std::wstring_view path) noexcept
+{
+    try
+    {
+        auto lock = LockForWriting();
+
+        std::unique_ptr<TextBufferSnapshotWriter> writer;
+        try
+        {
+            // The writer carries on the file, so the rows that are only in
+            // the file don't have to be written again.
+            const TextBufferSnapshot snapshot{ path };
+            const auto scrolledOut = snapshot.Restore(*_buffer);
+            writer = std::make_unique<TextBufferSnapshotWriter>(path, snapshot, scrolledOut);
+        }
+        catch (...)
+        {
+            const auto hr = wil::ResultFromCaughtException();
+            if (hr != HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND) && hr != HRESULT_FROM_WIN32(ERROR_PATH_NOT_FOUND))
+            {
+                LOG_HR(hr);
+            }
+            writer = std::make_unique<TextBufferSnapshotWriter>(path);
+        }
+
+        _scrollbackWriter = std::move(writer);
+        _buffer->SetScrollbackWriter(_scrollbackWriter.get());
+        _lastScrollbackCommit = std::chrono::steady_clock::now();
+
+        // Show the restored rows the way they were: the cursor on the last
+        // row of the viewport, or further up if they don't fill it.
+        const auto viewportSize = _mutableViewport.Dimensions();
+        const auto cursorY = _buffer->GetCursor().GetPosition().Y;
+        const auto top = std::clamp(cursorY - viewportSize.Y + 1, 0, _buffer->GetSize().Height() - viewportSize.Y);
+        _mutableViewport = Viewport::FromDimensions({ 0, gsl::narrow<short>(top) }, viewportSize);
+        _scrollOffset = 0;
+
+        _buffer->GetRenderTarget().TriggerRedrawAll();
+        _NotifyScrollEvent();
+        _PublishSnapshot();
+    }
+    CATCH_LOG();
+}
+
+// Method Description:
+// - Saves the scrollback to the file RestoreScrollback was given, if any.
+//   The rows that scrolled out since the last save are written, along with
+//   the ones in the buffer. If that fails, the file keeps the last save, and
+//   the next one tries again.
+//   The caller has to hold the write lock.
+void Terminal::SaveScrollback() noexcept
+{
+    if (!_scrollbackWriter)
+    {
+        return;
+    }
+
+    _lastScrollbackCommit = std::chrono::steady_clock::now();
+    try
+    {
+        _scrollbackWriter->Commit(*_buffer);
+    }
+    CATCH_LOG();
+}
+
 // Method Description:
 // - Update our internal properties to match the new values in the provided
 //   CoreSettings object.
@@ -93,6 +217,8 @@ void Terminal::CreateFromSettings(winrt::Microsoft::Terminal::Settings::ICoreSet
 // - settings: an ICoreSettings with new settings values for us to use.
 void Terminal::UpdateSettings(winrt::Microsoft::Terminal::Settings::ICoreSettings settings)
 {
+    auto lock = LockForWriting();
+
     _defaultFg = settings.DefaultForeground();
     _defaultBg = settings.DefaultBackground();
 
@@ -128,6 +254,9 @@ void Terminal::UpdateSettings(winrt::Microsoft::Terminal::Settings::ICoreSetting
 
     _snapOnInput = settings.SnapOnInput();
 
+    // The colors and the cursor are painted from the snapshot.
+    _PublishSnapshot();
+
     // TODO:MSFT:21327402 - if HistorySize has changed, resize the buffer so we
     // have a smaller scrollback. We should do this carefully - if the new buffer
     // size is smaller than where the mutable viewport currently is, we'll want
@@ -137,6 +266,9 @@ void Terminal::UpdateSettings(winrt::Microsoft::Terminal::Settings::ICoreSetting
 
 // Method Description:
 // - Resize the terminal as the result of some user interaction.
+// - The buffer is reflowed to the new width, so lines that wrapped at the old
+//   width rewrap at the new one. The viewport is moved to keep the cursor the
+//   same distance from its top as before, as far as the new size allows.
 // Arguments:
 // - viewportSize: the new size of the viewport, in chars
 // Return Value:
@@ -152,34 +284,224 @@ HRESULT Terminal::UserResize(const COORD viewportSize) noexcept
         return S_FALSE;
     }
 
-    const auto oldTop = _mutableViewport.Top();
+    const auto& cursor = _buffer->GetCursor();
+    const int cursorHeightInView = cursor.GetPosition().Y - _mutableViewport.Top();
 
     const short newBufferHeight = viewportSize.Y + _scrollbackLines;
     COORD bufferSize{ viewportSize.X, newBufferHeight };
-    RETURN_IF_FAILED(_buffer->ResizeTraditional(bufferSize));
+    RETURN_IF_FAILED(_buffer->ResizeWithReflow(bufferSize));
 
-    auto proposedTop = oldTop;
-    const auto newView = Viewport::FromDimensions({ 0, proposedTop }, viewportSize);
-    const auto proposedBottom = newView.BottomExclusive();
-    // If the new bottom would be below the bottom of the buffer, then slide the
-    // top up so that we'll still fit within the buffer.
-    if (proposedBottom > bufferSize.Y)
-    {
-        proposedTop -= (proposedBottom - bufferSize.Y);
-    }
+    // Keep the cursor inside the new viewport, and the viewport inside the buffer.
+    const int cursorY = cursor.GetPosition().Y;
+    int proposedTop = cursorY - std::clamp(cursorHeightInView, 0, viewportSize.Y - 1);
+    proposedTop = std::clamp(proposedTop, 0, bufferSize.Y - viewportSize.Y);
 
-    _mutableViewport = Viewport::FromDimensions({ 0, proposedTop }, viewportSize);
+    _mutableViewport = Viewport::FromDimensions({ 0, gsl::narrow<short>(proposedTop) }, viewportSize);
     _scrollOffset = 0;
     _NotifyScrollEvent();
+    _PublishSnapshot();
 
     return S_OK;
 }
 
+// Method Description:
+// - Processes output from the connection. The write lock is taken for one
+//   chunk of it at a time, so that the renderer and the UI get a chance to
+//   read the buffer in the middle of a large burst of output. A snapshot of
+//   the viewport and cursor is published after every chunk.
+// Arguments:
+// - stringView: the output to process
 void Terminal::Write(std::wstring_view stringView)
 {
-    auto lock = LockForWriting();
+    while (!stringView.empty())
+    {
+        auto chunk = stringView.substr(0, s_writeChunkSize);
+
+        // Keep surrogate pairs together; _WriteBuffer needs to see both halves at once.
+        if (chunk.size() < stringView.size() && IS_HIGH_SURROGATE(chunk.back()))
+        {
+            chunk.remove_suffix(1);
+        }
+
+        {
+            auto lock = LockForWriting();
+            _stateMachine->ProcessString(chunk.data(), chunk.size());
+            _EndFastForward();
+            _PublishSnapshot();
+
+            if (_scrollbackWriter && std::chrono::steady_clock::now() - _lastScrollbackCommit >= s_scrollbackCommitInterval)
+            {
+                SaveScrollback();
+            }
+        }
+
+        stringView.remove_prefix(chunk.size());
+    }
+}
+
+// Method Description:
+// - Returns the latest snapshot of the viewport and cursor. This doesn't take
+//   the terminal lock, so it never waits for a write in progress; the snapshot
+//   reflects the output up to the last chunk that was fully processed.
+// Return Value:
+// - the snapshot. It stays valid and unchanged for as long as it's held.
+std::shared_ptr<const TerminalSnapshot> Terminal::GetSnapshot() const noexcept
+{
+    return std::atomic_load(&_snapshot);
+}
+
+// Method Description:
+// - Publishes a new snapshot of what the terminal shows for GetSnapshot to
+//   hand out. Readers still holding the previous one keep it until they're
+//   done; it's freed when the last of them lets go of it.
+//   The caller has to hold the write lock.
+void Terminal::_PublishSnapshot()
+{
+    _SyncSpillBase();
+
+    auto snapshot = std::make_shared<TerminalSnapshot>();
+    snapshot->generation = ++_snapshotGeneration;
+    snapshot->viewport = _GetVisibleViewport();
+    snapshot->scrollPosition = _VisibleStartIndex();
+    snapshot->bufferHeight = GetBufferHeight();
+
+    // Rows that spilled were scrolled out, but rows restored into the spill
+    // weren't, so this can start out negative.
+    snapshot->firstRow = gsl::narrow_cast<int64_t>(_buffer->GetScrolledRowCount()) - _SpilledRowCount() + _VisibleStartIndex();
+    const auto& screen = _FillScreen(snapshot->viewport, snapshot->firstRow);
+    snapshot->screen = screen.buffer;
+    snapshot->rowGenerations = screen.rowGenerations;
+    snapshot->allRowsChangedGeneration = _buffer->GetAllRowsChangedGeneration();
+    snapshot->bufferGeneration = _buffer->GetGeneration();
+
+    const auto& cursor = _buffer->GetCursor();
+    snapshot->cursorPosition = cursor.GetPosition();
+    snapshot->cursorVisible = IsCursorVisible();
+    snapshot->cursorOn = cursor.IsOn();
+    snapshot->cursorHeight = cursor.GetSize();
+    snapshot->cursorStyle = cursor.GetType();
+    snapshot->cursorColor = cursor.GetColor();
+
+    snapshot->selection = _GetSelectionRects();
+    snapshot->colorTable = _colorTable;
+    snapshot->defaultForeground = _defaultFg;
+    snapshot->defaultBackground = _defaultBg;
+    snapshot->title = _title;
+
+    std::atomic_store(&_snapshot, std::shared_ptr<const TerminalSnapshot>{ std::move(snapshot) });
+}
+
+// Method Description:
+// - Fills a screen for a new snapshot with the visible rows. A screen that no
+//   snapshot holds anymore is reused: the rows it has that are still visible
+//   are moved up the way the viewport scrolled, and only the rows it doesn't
+//   have are copied. While output scrolls the viewport, that's the rows that
+//   came in at the bottom and the one the cursor is on.
+//   The caller has to hold the write lock.
+// Arguments:
+// - viewport: the visible region, in buffer coordinates
+// - firstRow: the index of its first row among every row ever written (see TerminalSnapshot::firstRow)
+// Return Value:
+// - the screen, holding the visible rows
+Terminal::_Screen& Terminal::_FillScreen(const Viewport& viewport, const int64_t firstRow)
+{
+    // Screens can outlive the terminal in the snapshots that hold them, and
+    // nothing renders them directly.
+    static DummyRenderTarget screenRenderTarget;
+    // A row the screen holds isn't a copy of any buffer row, like one that came
+    // in at the bottom as the screen scrolled.
+    static constexpr auto noRow = std::numeric_limits<uint64_t>::max();
+
+    auto screen = std::find_if(_screens.begin(), _screens.end(), [](const _Screen& s) { return s.buffer.use_count() == 1; });
+    if (screen == _screens.end())
+    {
+        if (_screens.size() >= s_maxScreens)
+        {
+            _screens.erase(_screens.begin());
+        }
+        screen = _screens.insert(_screens.end(), _Screen{});
+    }
+
+    const auto dimensions = viewport.Dimensions();
+    if (!screen->buffer || screen->buffer->GetSize().Dimensions() != dimensions)
+    {
+        screen->buffer = std::make_shared<TextBuffer>(dimensions, TextAttribute{}, 0, screenRenderTarget);
+        screen->rowGenerations.assign(dimensions.Y, noRow);
+        screen->firstRow = std::nullopt;
+    }
+
+    const auto height = gsl::narrow_cast<int64_t>(dimensions.Y);
+    const auto scrolled = firstRow - screen->firstRow.value_or(firstRow);
+    if (!screen->firstRow.has_value() ||
+        _buffer->GetAllRowsChangedGeneration() > screen->bufferGeneration ||
+        scrolled < 0 ||
+        scrolled >= height)
+    {
+        std::fill(screen->rowGenerations.begin(), screen->rowGenerations.end(), noRow);
+    }
+    else if (scrolled > 0)
+    {
+        // Circling the screen's buffer moves its rows up without copying them.
+        for (int64_t i = 0; i < scrolled; ++i)
+        {
+            screen->buffer->IncrementCircularBuffer();
+        }
+        std::rotate(screen->rowGenerations.begin(), screen->rowGenerations.begin() + gsl::narrow_cast<ptrdiff_t>(scrolled), screen->rowGenerations.end());
+        std::fill(screen->rowGenerations.end() - gsl::narrow_cast<ptrdiff_t>(scrolled), screen->rowGenerations.end(), noRow);
+    }
+
+    for (SHORT y = 0; y < dimensions.Y; ++y)
+    {
+        // A row keeps its generation when it moves up the buffer, so the same
+        // generation as the same row held before means the same text. Spilled
+        // rows only ever change with the rest, so they're all at 0.
+        const SHORT offset = viewport.Top() + y;
+        auto& target = screen->buffer->GetRowByOffset(y);
+        try
+        {
+            const auto source = _buffer->PinRowByOffset(offset);
+            const auto generation = offset >= 0 ? source->GetGeneration() : 0;
+            if (screen->rowGenerations.at(y) != generation)
+            {
+                _CopyRowToScreen(*source, target);
+                screen->rowGenerations.at(y) = generation;
+            }
+        }
+        catch (...)
+        {
+            // A spilled row that can't be read is shown blank.
+            LOG_CAUGHT_EXCEPTION();
+            target.Reset(TextAttribute{});
+            screen->rowGenerations.at(y) = noRow;
+        }
+    }
+
+    screen->firstRow = firstRow;
+    screen->bufferGeneration = _buffer->GetGeneration();
+    return *screen;
+}
+
+// Method Description:
+// - Copies a row of the buffer into a row of a screen. Each buffer keeps the
+//   attributes of its own rows, so it's copied cell by cell, like the spill
+//   copies rows between buffers.
+// Arguments:
+// - source: the row of the buffer
+// - target: the row of the screen, just as wide
+void Terminal::_CopyRowToScreen(const ROW& source, ROW& target)
+{
+    _screenCells.clear();
+    for (auto it = source.AsCellIter(0); it; ++it)
+    {
+        _screenCells.emplace_back(*it);
+    }
+
+    target.Reset(TextAttribute{});
+    target.WriteCells(OutputCellIterator{ std::basic_string_view<OutputCell>{ _screenCells.data(), _screenCells.size() } }, 0, false);
 
-    _stateMachine->ProcessString(stringView.data(), stringView.size());
+    const auto& charRow = source.GetCharRow();
+    target.GetCharRow().SetWrapForced(charRow.WasWrapForced());
+    target.GetCharRow().SetDoubleBytePadded(charRow.WasDoubleBytePadded());
 }
 
 // Method Description:
@@ -207,6 +529,7 @@ bool Terminal::SendKeyEvent(const WORD vkey,
         auto lock = LockForWriting();
         _scrollOffset = 0;
         _NotifyScrollEvent();
+        _PublishSnapshot();
     }
 
     DWORD modifiers = 0
@@ -283,19 +606,49 @@ int Terminal::_ViewStartIndex() const noexcept
     return _mutableViewport.Top();
 }
 
-// _VisibleStartIndex is the first visible line of the buffer
+// _SpilledRowCount is the number of rows that scrolled out of the top of
+// the buffer into the file kept for infinite scrollback, if there is one
+int Terminal::_SpilledRowCount() const noexcept
+{
+    return gsl::narrow_cast<int>(_buffer->GetSpilledRowCount());
+}
+
+// _VisibleStartIndex is the first visible line, counting the spilled rows
+// above the buffer. It's also the position of the scroll bar.
 int Terminal::_VisibleStartIndex() const noexcept
 {
-    return std::max(0, _ViewStartIndex() - _scrollOffset);
+    return std::max(0, _SpilledRowCount() + _ViewStartIndex() - _scrollOffset);
 }
 
+// The visible region in buffer coordinates. Spilled rows are at the offsets
+// above row 0, counting up from the spill base; see _SyncSpillBase.
 Viewport Terminal::_GetVisibleViewport() const noexcept
 {
-    const COORD origin{ 0, gsl::narrow<short>(_VisibleStartIndex()) };
+    const auto top = _VisibleStartIndex() - gsl::narrow_cast<int>(_buffer->GetSpillBase());
+    const COORD origin{ 0, gsl::narrow<short>(top) };
     return Viewport::FromDimensions(origin,
                                     _mutableViewport.Dimensions());
 }
 
+// Method Description:
+// - Moves the spill base (see TextBuffer::SetSpillBase) to the bottom of the
+//   visible region while that's up among the spilled rows, so the region
+//   starts at most a screen above row 0 however far up it is. Otherwise, the
+//   rows that spilled last stay right above row 0.
+//   The caller has to hold the write lock.
+void Terminal::_SyncSpillBase() noexcept
+{
+    const auto visibleEnd = _VisibleStartIndex() + _mutableViewport.Height();
+    if (visibleEnd < _SpilledRowCount())
+    {
+        _buffer->SetSpillBase(gsl::narrow_cast<size_t>(visibleEnd));
+    }
+    else
+    {
+        _buffer->SetSpillBase(std::nullopt);
+    }
+}
+
 // Writes a string of text to the buffer, then moves the cursor (and viewport)
 //      in accordance with the written text.
 // This method is our proverbial `WriteCharsLegacy`, and great care should be made to
@@ -336,6 +689,33 @@ void Terminal::_WriteBuffer(const std::wstring_view& stringView)
                 proposedCursorPosition.X--;
             }
         }
+        else if (cursorPosBefore.X >= bufferSize.Width())
+        {
+            // The last character filled the row. Wrap onto the next one before
+            // printing this one, and mark the row as wrapped so that a resize
+            // can reflow it. The character is printed on the next pass.
+            _buffer->GetRowByOffset(cursorPosBefore.Y).GetCharRow().SetWrapForced(true);
+            proposedCursorPosition.X = 0;
+            proposedCursorPosition.Y++;
+            i--;
+        }
+        else if (const auto run = ::Microsoft::Console::Utils::MeasurePrintableAsciiRun(stringView.substr(i, bufferSize.Width() - cursorPosBefore.X)))
+        {
+            // Plain text goes into the row as it is, as much of it as fits.
+            // While fast-forwarding, the renderer isn't told about it; the
+            // whole screen is redrawn once the burst is over.
+            const auto text = stringView.substr(i, run);
+            if (_ShouldFastForward())
+            {
+                _buffer->GetRowByOffset(cursorPosBefore.Y).WriteNarrowText(text, cursorPosBefore.X, _buffer->GetCurrentAttributes(), false);
+            }
+            else
+            {
+                _buffer->WriteNarrowLine(text, _buffer->GetCurrentAttributes(), cursorPosBefore, false);
+            }
+            i += run - 1;
+            proposedCursorPosition.X += gsl::narrow<SHORT>(run);
+        }
         else
         {
             // TODO: MSFT 21006766
@@ -366,6 +746,7 @@ void Terminal::_WriteBuffer(const std::wstring_view& stringView)
                 _buffer->IncrementCircularBuffer();
                 proposedCursorPosition.Y--;
             }
+            _rowsScrolledSinceFrame.fetch_add(newRows, std::memory_order_relaxed);
             notifyScroll = true;
         }
 
@@ -381,6 +762,7 @@ void Terminal::_WriteBuffer(const std::wstring_view& stringView)
             const auto newViewTop = std::max(0, cursorPosAfter.Y - (_mutableViewport.Height() - 1));
             if (newViewTop != _mutableViewport.Top())
             {
+                _rowsScrolledSinceFrame.fetch_add(newViewTop - _mutableViewport.Top(), std::memory_order_relaxed);
                 _mutableViewport = Viewport::FromDimensions({0, gsl::narrow<short>(newViewTop)}, _mutableViewport.Dimensions());
                 notifyScroll = true;
             }
@@ -388,36 +770,114 @@ void Terminal::_WriteBuffer(const std::wstring_view& stringView)
 
         if (notifyScroll)
         {
-            _buffer->GetRenderTarget().TriggerRedrawAll();
-            _NotifyScrollEvent();
+            if (_ShouldFastForward())
+            {
+                _fastForwardScrolled = true;
+            }
+            else
+            {
+                _buffer->GetRenderTarget().TriggerRedrawAll();
+                _NotifyScrollEvent();
+            }
         }
     }
 }
 
+// Method Description:
+// - Turns fast-forwarding through floods of output on or off. It's on by default.
+void Terminal::SetFastForwardEnabled(const bool enabled) noexcept
+{
+    _fastForwardEnabled = enabled;
+}
+
+// Method Description:
+// - Tells the terminal that the renderer started a frame, which is what ends
+//   a flood of output as far as fast-forwarding is concerned. It doesn't
+//   take the lock.
+void Terminal::NotifyFrameStart() noexcept
+{
+    _rowsScrolledSinceFrame.store(0, std::memory_order_relaxed);
+}
+
+// Method Description:
+// - Checks whether output has scrolled so far since the renderer last drew a
+//   frame that what's being written now will likely scroll out of view before
+//   the next one. If so, starts fast-forwarding: cursor redraws are put off,
+//   and _WriteBuffer stops notifying the renderer about rows and scrolling
+//   until _EndFastForward.
+// Return Value:
+// - true while fast-forwarding.
+bool Terminal::_ShouldFastForward() noexcept
+{
+    if (!_fastForwarding &&
+        _fastForwardEnabled &&
+        _rowsScrolledSinceFrame.load(std::memory_order_relaxed) > s_fastForwardScreens * _mutableViewport.Height())
+    {
+        _fastForwarding = true;
+        _buffer->GetCursor().StartDeferDrawing();
+    }
+    return _fastForwarding;
+}
+
+// Method Description:
+// - Catches the renderer up after fast-forwarding: the cursor is redrawn once,
+//   and if the output scrolled, the whole screen is redrawn and the scroll
+//   position is reported once. Called after every chunk of output, so the
+//   screen never lags behind by more than one.
+void Terminal::_EndFastForward()
+{
+    if (!_fastForwarding)
+    {
+        return;
+    }
+
+    _fastForwarding = false;
+    _buffer->GetCursor().EndDeferDrawing();
+
+    if (_fastForwardScrolled)
+    {
+        _fastForwardScrolled = false;
+        _buffer->GetRenderTarget().TriggerRedrawAll();
+        _NotifyScrollEvent();
+    }
+}
+
+// Method Description:
+// - Scrolls the visible region to the given row.
+// Arguments:
+// - viewTop: the new first visible row, counting the spilled rows above the
+//   buffer, like the position reported to the scroll position callback.
 void Terminal::UserScrollViewport(const int viewTop)
 {
+    auto lock = LockForWriting();
+
     const auto clampedNewTop = std::max(0, viewTop);
-    const auto realTop = _ViewStartIndex();
+    const auto realTop = _SpilledRowCount() + _ViewStartIndex();
     const auto newDelta = realTop - clampedNewTop;
     // if viewTop > realTop, we want the offset to be 0.
 
     _scrollOffset = std::max(0, newDelta);
+    _PublishSnapshot();
     _buffer->GetRenderTarget().TriggerRedrawAll();
 }
 
+// Method Description:
+// - Returns the first visible row, counting the spilled rows above the
+//   buffer. The UI asks for this while output may be streaming in, so it
+//   comes from the latest snapshot instead of waiting for the lock.
 int Terminal::GetScrollOffset()
 {
-    return _VisibleStartIndex();
+    return GetSnapshot()->scrollPosition;
 }
 
 void Terminal::_NotifyScrollEvent()
 {
     if (_pfnScrollPositionChanged)
     {
-        const auto visible = _GetVisibleViewport();
-        const auto top = visible.Top();
-        const auto height = visible.Height();
-        const auto bottom = this->GetBufferHeight();
+        // Spilled rows count as part of the buffer, above it.
+        const auto top = _VisibleStartIndex();
+        const auto height = _mutableViewport.Height();
+        const auto bottom = _SpilledRowCount() + this->GetBufferHeight();
         _pfnScrollPositionChanged(top, height, bottom);
     }
 }
@@ -452,17 +912,22 @@ const bool Terminal::IsSelectionActive() const noexcept
 // - position: the (x,y) coordinate on the visible viewport
 void Terminal::SetSelectionAnchor(const COORD position)
 {
+    auto lock = LockForWriting();
+
     _selectionAnchor = position;
 
-    // include _scrollOffset here to ensure this maps to the right spot of the original viewport
-    THROW_IF_FAILED(ShortSub(_selectionAnchor.Y, gsl::narrow<SHORT>(_scrollOffset), &_selectionAnchor.Y));
+    // include how far the view is scrolled back here to ensure this maps to the right spot of the original viewport
+    const auto scrolledBack = gsl::narrow<SHORT>(_GetVisibleViewport().Top() - _ViewStartIndex());
+    THROW_IF_FAILED(ShortAdd(_selectionAnchor.Y, scrolledBack, &_selectionAnchor.Y));
 
     // copy value of ViewStartIndex to support scrolling
     // and update on new buffer output (used in _GetSelectionRects())
     _selectionAnchor_YOffset = gsl::narrow<SHORT>(_ViewStartIndex());
 
     _selectionActive = true;
-    SetEndSelectionPosition(position);
+    _SetEndSelectionPosition(position);
+    _PublishSnapshot();
+    _buffer->GetRenderTarget().TriggerSelection();
 }
 
 // Method Description:
@@ -470,11 +935,25 @@ void Terminal::SetSelectionAnchor(const COORD position)
 // Arguments:
 // - position: the (x,y) coordinate on the visible viewport
 void Terminal::SetEndSelectionPosition(const COORD position)
+{
+    auto lock = LockForWriting();
+    _SetEndSelectionPosition(position);
+    _PublishSnapshot();
+    _buffer->GetRenderTarget().TriggerSelection();
+}
+
+// Method Description:
+// - Records the position of the end of a selection, for SetSelectionAnchor and
+//   SetEndSelectionPosition. The caller has to hold the write lock.
+// Arguments:
+// - position: the (x,y) coordinate on the visible viewport
+void Terminal::_SetEndSelectionPosition(const COORD position)
 {
     _endSelectionPosition = position;
 
-    // include _scrollOffset here to ensure this maps to the right spot of the original viewport
-    THROW_IF_FAILED(ShortSub(_endSelectionPosition.Y, gsl::narrow<SHORT>(_scrollOffset), &_endSelectionPosition.Y));
+    // include how far the view is scrolled back here to ensure this maps to the right spot of the original viewport
+    const auto scrolledBack = gsl::narrow<SHORT>(_GetVisibleViewport().Top() - _ViewStartIndex());
+    THROW_IF_FAILED(ShortAdd(_endSelectionPosition.Y, scrolledBack, &_endSelectionPosition.Y));
 
     // copy value of ViewStartIndex to support scrolling
     // and update on new buffer output (used in _GetSelectionRects())
@@ -548,18 +1027,32 @@ std::vector<SMALL_RECT> Terminal::_GetSelectionRects() const
 // - isEnabled: new value for _boxSelection
 void Terminal::SetBoxSelection(const bool isEnabled) noexcept
 {
-    _boxSelection = isEnabled;
+    try
+    {
+        auto lock = LockForWriting();
+        _boxSelection = isEnabled;
+        _PublishSnapshot();
+        _buffer->GetRenderTarget().TriggerSelection();
+    }
+    CATCH_LOG();
 }
 
 // Method Description:
 // - clear selection data and disable rendering it
 void Terminal::ClearSelection() noexcept
 {
-    _selectionActive = false;
-    _selectionAnchor = {0, 0};
-    _endSelectionPosition = {0, 0};
-    _selectionAnchor_YOffset = 0;
-    _endSelectionPosition_YOffset = 0;
+    try
+    {
+        auto lock = LockForWriting();
+        _selectionActive = false;
+        _selectionAnchor = {0, 0};
+        _endSelectionPosition = {0, 0};
+        _selectionAnchor_YOffset = 0;
+        _endSelectionPosition_YOffset = 0;
+        _PublishSnapshot();
+        _buffer->GetRenderTarget().TriggerSelection();
+    }
+    CATCH_LOG();
 }
 
 // Method Description:
@@ -571,20 +1064,10 @@ void Terminal::ClearSelection() noexcept
 // - wstring text from buffer. If extended to multiple lines, each line is separated by \r\n
 const std::wstring Terminal::RetrieveSelectedTextFromBuffer(bool trimTrailingWhitespace) const
 {
-    std::function<COLORREF(TextAttribute&)> GetForegroundColor = std::bind(&Terminal::GetForegroundColor, this, std::placeholders::_1);
-    std::function<COLORREF(TextAttribute&)> GetBackgroundColor = std::bind(&Terminal::GetBackgroundColor, this, std::placeholders::_1);
-
-    auto data = _buffer->GetTextForClipboard(!_boxSelection,
-                                             trimTrailingWhitespace,
-                                             _GetSelectionRects(),
-                                             GetForegroundColor,
-                                             GetBackgroundColor);
-
-    std::wstring result;
-    for (const auto& text : data.text)
-    {
-        result += text;
-    }
+    const TextBufferExport selection{ *_buffer,
+                                      _GetSelectionRects(),
+                                      !_boxSelection,
+                                      trimTrailingWhitespace };
 
-    return result;
+    return selection.Text();
 }
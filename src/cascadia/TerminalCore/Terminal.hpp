@@ -3,9 +3,11 @@
 
 #pragma once
 
+#include <chrono>
 #include <conattrs.hpp>
 
 #include "../../buffer/out/textBuffer.hpp"
+#include "../../buffer/out/textBufferSnapshot.hpp"
 #include "../../renderer/inc/IRenderData.hpp"
 #include "../../terminal/parser/StateMachine.hpp"
 #include "../../terminal/input/terminalInput.hpp"
@@ -13,6 +15,7 @@
 #include "../../types/inc/Viewport.hpp"
 #include "../../cascadia/terminalcore/ITerminalApi.hpp"
 #include "../../cascadia/terminalcore/ITerminalInput.hpp"
+#include "../../cascadia/terminalcore/TerminalSnapshot.hpp"
 
 // You have to forward decl the ICoreSettings here, instead of including the header.
 // If you include the header, there will be compilation errors with other
@@ -45,9 +48,18 @@ public:
 
     void UpdateSettings(winrt::Microsoft::Terminal::Settings::ICoreSettings settings);
 
+    void EnableInfiniteScrollback() noexcept;
+    void RestoreScrollback(const std::wstring_view path) noexcept;
+    void SaveScrollback() noexcept;
+
     // Write goes through the parser
     void Write(std::wstring_view stringView);
 
+    std::shared_ptr<const TerminalSnapshot> GetSnapshot() const noexcept;
+
+    void SetFastForwardEnabled(const bool enabled) noexcept;
+    void NotifyFrameStart() noexcept;
+
     [[nodiscard]]
     std::shared_lock<std::shared_mutex> LockForReading();
     [[nodiscard]]
@@ -59,13 +71,8 @@ public:
     // These methods are defined in TerminalApi.cpp
     bool PrintString(std::wstring_view stringView) override;
     bool ExecuteChar(wchar_t wch) override;
-    bool SetTextToDefaults(bool foreground, bool background) override;
-    bool SetTextForegroundIndex(BYTE colorIndex) override;
-    bool SetTextBackgroundIndex(BYTE colorIndex) override;
-    bool SetTextRgbColor(COLORREF color, bool foreground) override;
-    bool BoldText(bool boldOn) override;
-    bool UnderlineText(bool underlineOn) override;
-    bool ReverseText(bool reversed) override;
+    TextAttribute GetTextAttributes() const override;
+    bool SetTextAttributes(const TextAttribute& attrs) override;
     bool SetCursorPosition(short x, short y) override;
     COORD GetCursorPosition() override;
     bool EraseCharacters(const unsigned int numChars) override;
@@ -149,6 +156,50 @@ public:
 
     std::shared_mutex _readWriteLock;
 
+    // Write holds the write lock for at most this many characters at a time.
+    static constexpr size_t s_writeChunkSize = 4096;
+
+    // Fast-forward: once output scrolls more than this many screens between
+    // two frames, rows are written without telling the renderer about each
+    // of them, and the whole screen is redrawn once instead.
+    static constexpr size_t s_fastForwardScreens = 3;
+    bool _fastForwardEnabled;
+    // Reset by the renderer at the start of every frame.
+    std::atomic<size_t> _rowsScrolledSinceFrame;
+    bool _fastForwarding;
+    bool _fastForwardScrolled;
+
+    // Only ever accessed through std::atomic_load and std::atomic_store.
+    std::shared_ptr<const TerminalSnapshot> _snapshot;
+    uint64_t _snapshotGeneration;
+
+    // The buffers snapshots copy the visible rows into. A new snapshot gets
+    // one that no snapshot holds anymore, and only the rows it doesn't have
+    // yet are copied into it.
+    struct _Screen
+    {
+        std::shared_ptr<TextBuffer> buffer;
+        // The generation of the buffer row each row is a copy of.
+        std::vector<uint64_t> rowGenerations;
+        // The snapshot's firstRow and bufferGeneration when it was last filled,
+        // if it ever was.
+        std::optional<int64_t> firstRow;
+        uint64_t bufferGeneration;
+    };
+    // More than that are only needed while readers hold on to old snapshots,
+    // and then the oldest is left to them.
+    static constexpr size_t s_maxScreens = 3;
+    std::vector<_Screen> _screens;
+    std::vector<OutputCell> _screenCells;
+
+    // Saves the scrollback, if it's kept between sessions. The buffer hands
+    // it rows as they scroll out, so it's declared first to outlive it.
+    std::unique_ptr<TextBufferSnapshotWriter> _scrollbackWriter;
+    // Write commits the scrollback at most this often, so that not much of it
+    // is lost if the terminal doesn't get to save it on the way out.
+    static constexpr std::chrono::seconds s_scrollbackCommitInterval{ 5 };
+    std::chrono::steady_clock::time_point _lastScrollbackCommit;
+
     // TODO: These members are not shared by an alt-buffer. They should be
     //      encapsulated, such that a Terminal can have both a main and alt buffer.
     std::unique_ptr<TextBuffer> _buffer;
@@ -157,6 +208,7 @@ public:
 
     // _scrollOffset is the number of lines above the viewport that are currently visible
     // If _scrollOffset is 0, then the visible region of the buffer is the viewport.
+    // With infinite scrollback, it can reach up past the top of the buffer into the spilled rows.
     int _scrollOffset;
     // TODO this might not be the value we want to store.
     // We might want to store the height in the scrollback that's currenty visible.
@@ -172,7 +224,9 @@ public:
     //      Either way, we sohould make this behavior controlled by a setting.
 
     int _ViewStartIndex() const noexcept;
+    int _SpilledRowCount() const noexcept;
     int _VisibleStartIndex() const noexcept;
+    void _SyncSpillBase() noexcept;
 
     Microsoft::Console::Types::Viewport _GetMutableViewport() const noexcept;
     Microsoft::Console::Types::Viewport _GetVisibleViewport() const noexcept;
@@ -181,8 +235,17 @@ public:
 
     void _WriteBuffer(const std::wstring_view& stringView);
 
+    bool _ShouldFastForward() noexcept;
+    void _EndFastForward();
+
     void _NotifyScrollEvent();
 
+    void _PublishSnapshot();
+    _Screen& _FillScreen(const Microsoft::Console::Types::Viewport& viewport, const int64_t firstRow);
+    void _CopyRowToScreen(const ROW& source, ROW& target);
+
+    void _SetEndSelectionPosition(const COORD position);
+
     std::vector<SMALL_RECT> _GetSelectionRects() const;
 };
 
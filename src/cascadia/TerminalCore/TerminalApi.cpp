@@ -22,80 +22,13 @@ bool Terminal::ExecuteChar(wchar_t wch)
     return true;
 }
 
-bool Terminal::SetTextToDefaults(bool foreground, bool background)
+TextAttribute Terminal::GetTextAttributes() const
 {
-    TextAttribute attrs = _buffer->GetCurrentAttributes();
-    if (foreground)
-    {
-        attrs.SetDefaultForeground();
-    }
-    if (background)
-    {
-        attrs.SetDefaultBackground();
-    }
-    _buffer->SetCurrentAttributes(attrs);
-    return true;
-}
-
-bool Terminal::SetTextForegroundIndex(BYTE colorIndex)
-{
-    TextAttribute attrs = _buffer->GetCurrentAttributes();
-    attrs.SetIndexedAttributes({ colorIndex }, {});
-    _buffer->SetCurrentAttributes(attrs);
-    return true;
-}
-
-bool Terminal::SetTextBackgroundIndex(BYTE colorIndex)
-{
-    TextAttribute attrs = _buffer->GetCurrentAttributes();
-    attrs.SetIndexedAttributes({}, { colorIndex });
-    _buffer->SetCurrentAttributes(attrs);
-    return true;
+    return _buffer->GetCurrentAttributes();
 }
 
-bool Terminal::SetTextRgbColor(COLORREF color, bool foreground)
+bool Terminal::SetTextAttributes(const TextAttribute& attrs)
 {
-    TextAttribute attrs = _buffer->GetCurrentAttributes();
-    attrs.SetColor(color, foreground);
-    _buffer->SetCurrentAttributes(attrs);
-    return true;
-}
-
-bool Terminal::BoldText(bool boldOn)
-{
-    TextAttribute attrs = _buffer->GetCurrentAttributes();
-    if (boldOn)
-    {
-        attrs.Embolden();
-    }
-    else
-    {
-        attrs.Debolden();
-    }
-    _buffer->SetCurrentAttributes(attrs);
-    return true;
-}
-
-bool Terminal::UnderlineText(bool underlineOn)
-{
-    TextAttribute attrs = _buffer->GetCurrentAttributes();
-    WORD metaAttrs = attrs.GetMetaAttributes();
-
-    WI_UpdateFlag(metaAttrs, COMMON_LVB_UNDERSCORE, underlineOn);
-
-    attrs.SetMetaAttributes(metaAttrs);
-    _buffer->SetCurrentAttributes(attrs);
-    return true;
-}
-
-bool Terminal::ReverseText(bool reversed)
-{
-    TextAttribute attrs = _buffer->GetCurrentAttributes();
-    WORD metaAttrs = attrs.GetMetaAttributes();
-
-    WI_UpdateFlag(metaAttrs, COMMON_LVB_REVERSE_VIDEO, reversed);
-
-    attrs.SetMetaAttributes(metaAttrs);
     _buffer->SetCurrentAttributes(attrs);
     return true;
 }
@@ -0,0 +1,72 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- TerminalSnapshot.hpp
+
+Abstract:
+- An immutable copy of what the terminal shows: where the viewport and the
+  cursor are, the rows of the viewport, the selection, the colors and the
+  title. It's published after every chunk of output.
+- Readers take a reference to the latest one without locking the terminal,
+  and keep it alive for as long as they hold on to it, so neither the UI's
+  scrollbar nor the renderer is ever blocked by a long write (see
+  SnapshotRenderData). Reading the rest of the buffer, like the scrollback
+  above the viewport, still takes the lock.
+--*/
+
+#pragma once
+
+#include <conattrs.hpp>
+#include "../../buffer/out/textBuffer.hpp"
+#include "../../types/inc/Viewport.hpp"
+
+namespace Microsoft::Terminal::Core
+{
+    struct TerminalSnapshot final
+    {
+        // Increases by one with every snapshot a terminal publishes.
+        uint64_t generation = 0;
+
+        // The visible region of the buffer, in buffer coordinates.
+        Microsoft::Console::Types::Viewport viewport = Microsoft::Console::Types::Viewport::Empty();
+        // The first visible row, counting the rows that spilled out of the
+        // top of the buffer. It's the position of the scroll bar.
+        int scrollPosition = 0;
+        // The number of rows from the top of the buffer to the bottom of the viewport.
+        short bufferHeight = 0;
+
+        // The visible rows, copied out of the buffer: row y of the screen is
+        // row viewport.Top() + y of the buffer. Nothing writes to it while
+        // a snapshot holds it.
+        std::shared_ptr<const TextBuffer> screen;
+        // The generation of the buffer row each row of the screen is a copy
+        // of (see ROW::GetGeneration), or 0 for rows read from the spill.
+        std::vector<uint64_t> rowGenerations;
+        // The first visible row, counting every row that ever scrolled out of
+        // the top of the buffer. Between two snapshots, the screen scrolled
+        // by the difference.
+        int64_t firstRow = 0;
+        // The buffer's TextBuffer::GetAllRowsChangedGeneration. If it's past
+        // another snapshot's bufferGeneration, no row is the same in both.
+        uint64_t allRowsChangedGeneration = 0;
+        uint64_t bufferGeneration = 0;
+
+        COORD cursorPosition = { 0, 0 };
+        bool cursorVisible = false;
+        bool cursorOn = false;
+        ULONG cursorHeight = 0;
+        CursorType cursorStyle = CursorType::Legacy;
+        COLORREF cursorColor = 0;
+
+        // The selected region, line by line, in buffer coordinates.
+        std::vector<SMALL_RECT> selection;
+
+        std::array<COLORREF, XTERM_COLOR_TABLE_SIZE> colorTable = {};
+        COLORREF defaultForeground = 0;
+        COLORREF defaultBackground = 0;
+
+        std::wstring title;
+    };
+}
@@ -128,9 +128,13 @@ const std::wstring Terminal::GetConsoleTitle() const noexcept
 //      operation.
 //   Callers should make sure to also call Terminal::UnlockConsole once
 //      they're done with any querying they need to do.
+// - A renderer that paints from the buffer calls this at the start of every
+//      frame; see NotifyFrameStart. One that paints from the snapshots uses
+//      SnapshotRenderData instead.
 void Terminal::LockConsole()  noexcept
 {
     _readWriteLock.lock_shared();
+    NotifyFrameStart();
 }
 
 // Method Description:
@@ -12,6 +12,7 @@ namespace winrt::Microsoft::Terminal::Settings::implementation
         _defaultBackground{ DEFAULT_BACKGROUND_WITH_ALPHA },
         _colorTable{},
         _historySize{ DEFAULT_HISTORY_SIZE },
+        _scrollbackFile{},
         _initialRows{ 30 },
         _initialCols{ 80 },
         _snapOnInput{ true },
@@ -71,6 +72,16 @@ namespace winrt::Microsoft::Terminal::Settings::implementation
         _historySize = value;
     }
 
+    hstring TerminalSettings::ScrollbackFile()
+    {
+        return _scrollbackFile;
+    }
+
+    void TerminalSettings::ScrollbackFile(hstring const& value)
+    {
+        _scrollbackFile = value;
+    }
+
     int32_t TerminalSettings::InitialRows()
     {
         return _initialRows;
@@ -33,6 +33,8 @@ namespace winrt::Microsoft::Terminal::Settings::implementation
         void SetColorTableEntry(int32_t index, uint32_t value);
         int32_t HistorySize();
         void HistorySize(int32_t value);
+        hstring ScrollbackFile();
+        void ScrollbackFile(hstring const& value);
         int32_t InitialRows();
         void InitialRows(int32_t value);
         int32_t InitialCols();
@@ -81,6 +83,7 @@ namespace winrt::Microsoft::Terminal::Settings::implementation
         uint32_t _defaultBackground;
         std::array<uint32_t, COLOR_TABLE_SIZE> _colorTable;
         int32_t _historySize;
+        hstring _scrollbackFile;
         int32_t _initialRows;
         int32_t _initialCols;
         bool _snapOnInput;
@@ -0,0 +1,187 @@
+/*
+* Copyright (c) Microsoft Corporation.
+* Licensed under the MIT license.
+*
+* Class Name: FastForwardTest
+*/
+#include "precomp.h"
+#include <WexTestClass.h>
+
+#include "../cascadia/TerminalCore/Terminal.hpp"
+#include "../renderer/inc/DummyRenderTarget.hpp"
+#include "consoletaeftemplates.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+using namespace Microsoft::Terminal::Core;
+using namespace Microsoft::Console::Render;
+using namespace Microsoft::Console::Types;
+
+namespace TerminalCoreUnitTests
+{
+    class CountingRenderTarget final : public IRenderTarget
+    {
+    public:
+        size_t regions = 0;
+        size_t all = 0;
+
+        void TriggerRedraw(const Viewport& /*region*/) override { ++regions; }
+        void TriggerRedraw(const COORD* const /*pcoord*/) override { ++regions; }
+        void TriggerRedrawCursor(const COORD* const /*pcoord*/) override {}
+        void TriggerRedrawAll() override { ++all; }
+        void TriggerTeardown() override {}
+        void TriggerSelection() override {}
+        void TriggerScroll() override {}
+        void TriggerScroll(const COORD* const /*pcoordDelta*/) override {}
+        void TriggerCircling() override {}
+        void TriggerTitleChange() override {}
+    };
+
+    class FastForwardTest
+    {
+        TEST_CLASS(FastForwardTest);
+
+        // Stands in for the renderer starting a frame.
+        static void _Frame(Terminal& term)
+        {
+            term.LockConsole();
+            term.UnlockConsole();
+        }
+
+        TEST_METHOD(FastForwardMatchesNormalOutput)
+        {
+            std::wstring output;
+            for (int i = 0; i < 300; ++i)
+            {
+                output += L"line " + std::to_wstring(i) + L" \x1b[3" + std::to_wstring(i % 8) + L"m";
+                output += std::wstring(i % 130, static_cast<wchar_t>(L'a' + i % 26));
+                output += i % 7 == 0 ? L"\x3042\xD83D\xDE00\x1b[m\r\n" : L"\x1b[m\r\n";
+            }
+
+            DummyRenderTarget emptyRT;
+            Terminal normal = Terminal();
+            normal.Create({ 80, 25 }, 1000, emptyRT);
+            normal.SetFastForwardEnabled(false);
+            normal.Write(output);
+
+            Terminal fast = Terminal();
+            fast.Create({ 80, 25 }, 1000, emptyRT);
+            fast.Write(output);
+
+            VERIFY_ARE_EQUAL(normal.GetViewport().ToInclusive(), fast.GetViewport().ToInclusive());
+            VERIFY_ARE_EQUAL(normal.GetTextBuffer().GetCursor().GetPosition(), fast.GetTextBuffer().GetCursor().GetPosition());
+
+            const auto& expected = normal.GetTextBuffer();
+            const auto& actual = fast.GetTextBuffer();
+            for (short y = 0; y < expected.GetSize().Height(); ++y)
+            {
+                const auto& expectedRow = expected.GetRowByOffset(y);
+                const auto& actualRow = actual.GetRowByOffset(y);
+                VERIFY_ARE_EQUAL(expectedRow.GetText(), actualRow.GetText(), NoThrowString().Format(L"row %d", y));
+                VERIFY_ARE_EQUAL(expectedRow.GetCharRow().WasWrapForced(), actualRow.GetCharRow().WasWrapForced());
+
+                const std::vector<TextAttribute> expectedAttrs{ expectedRow.GetAttrRow().begin(), expectedRow.GetAttrRow().end() };
+                const std::vector<TextAttribute> actualAttrs{ actualRow.GetAttrRow().begin(), actualRow.GetAttrRow().end() };
+                VERIFY_IS_TRUE(expectedAttrs == actualAttrs, NoThrowString().Format(L"row %d", y));
+            }
+        }
+
+        TEST_METHOD(FastForwardRedrawsOnce)
+        {
+            std::wstring output;
+            for (int i = 0; i < 1000; ++i)
+            {
+                output += L"y\r\n";
+            }
+
+            CountingRenderTarget renderTarget;
+            Terminal term = Terminal();
+            term.Create({ 80, 25 }, 1000, renderTarget);
+
+            size_t scrollEvents = 0;
+            term.SetScrollPositionChangedCallback([&](const int, const int, const int) { ++scrollEvents; });
+
+            term.Write(output);
+
+            Log::Comment(L"Only the rows written before the flood was detected, about four screens' worth, were painted one by one.");
+            VERIFY_IS_LESS_THAN(renderTarget.regions, 5 * 25u);
+            VERIFY_IS_LESS_THAN(renderTarget.all, 5 * 25u);
+            VERIFY_IS_LESS_THAN(scrollEvents, 5 * 25u);
+            const auto& lastRow = term.GetTextBuffer().GetRowByOffset(term.GetViewport().Top() + 23);
+            VERIFY_ARE_EQUAL(std::wstring{ L"y" }, lastRow.GetText().substr(0, 1));
+
+            Log::Comment(L"After a frame, output is painted as it comes again.");
+            _Frame(term);
+            const auto regionsBefore = renderTarget.regions;
+            term.Write(L"yy\r\nyy\r\n");
+            VERIFY_ARE_EQUAL(regionsBefore + 2, renderTarget.regions);
+        }
+
+        BEGIN_TEST_METHOD(FloodThroughputPerf)
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD()
+    };
+
+    // Feeds `yes` and `seq` sized floods through the terminal while another
+    // thread starts a frame 60 times a second, with and without fast-forward.
+    void FastForwardTest::FloodThroughputPerf()
+    {
+        std::wstring yes;
+        yes.reserve(3 * 2000000);
+        for (int i = 0; i < 2000000; ++i)
+        {
+            yes += L"y\r\n";
+        }
+
+        std::wstring seq;
+        for (int i = 1; i <= 1000000; ++i)
+        {
+            seq += std::to_wstring(i) + L"\r\n";
+        }
+
+        for (const auto& [name, input] : { std::pair{ L"yes", &yes }, std::pair{ L"seq", &seq } })
+        {
+            for (const bool enabled : { false, true })
+            {
+                DummyRenderTarget emptyRT;
+                Terminal term = Terminal();
+                term.Create({ 120, 30 }, 9001, emptyRT);
+                term.SetFastForwardEnabled(enabled);
+
+                std::atomic<bool> writing{ true };
+                std::thread renderer([&]() {
+                    while (writing)
+                    {
+                        _Frame(term);
+                        std::this_thread::sleep_for(std::chrono::milliseconds(16));
+                    }
+                });
+
+                // Hand the output over the way a connection would, a pipe's worth at a time.
+                const std::wstring_view view{ *input };
+                const auto start = std::chrono::steady_clock::now();
+                for (size_t offset = 0; offset < view.size(); offset += 64 * 1024)
+                {
+                    term.Write(view.substr(offset, 64 * 1024));
+                }
+                const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+                writing = false;
+                renderer.join();
+
+                Log::Comment(NoThrowString().Format(L"%s, fast-forward %s: %zu chars in %lld us (%.1f MB/s)",
+                                                    name,
+                                                    enabled ? L"on" : L"off",
+                                                    view.size(),
+                                                    elapsed.count(),
+                                                    static_cast<double>(view.size()) / std::max<long long>(elapsed.count(), 1)));
+            }
+        }
+    }
+}
@@ -0,0 +1,134 @@
+/*
+* Copyright (c) Microsoft Corporation.
+* Licensed under the MIT license.
+*
+* Class Name: ResizeTest
+*/
+#include "precomp.h"
+#include <WexTestClass.h>
+
+#include "../cascadia/TerminalCore/Terminal.hpp"
+#include "../renderer/inc/DummyRenderTarget.hpp"
+#include "consoletaeftemplates.hpp"
+
+#include <chrono>
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+using namespace Microsoft::Terminal::Core;
+using namespace Microsoft::Console::Render;
+
+namespace TerminalCoreUnitTests
+{
+    class ResizeTest
+    {
+        TEST_CLASS(ResizeTest);
+
+        static std::wstring _RowText(Terminal& term, const size_t row)
+        {
+            auto text = term.GetTextBuffer().GetRowByOffset(row).GetText();
+            text.erase(text.find_last_not_of(L' ') + 1);
+            return text;
+        }
+
+        TEST_METHOD(ResizeReflowsWrappedLines)
+        {
+            Terminal term = Terminal();
+            DummyRenderTarget emptyRT;
+            term.Create({ 20, 5 }, 10, emptyRT);
+
+            // 25 characters don't fit in 20 columns, so the last 5 wrap onto the next row.
+            term.Write(L"0123456789012345678901234");
+            VERIFY_IS_TRUE(term.GetTextBuffer().GetRowByOffset(0).GetCharRow().WasWrapForced());
+            VERIFY_ARE_EQUAL(std::wstring{ L"01234567890123456789" }, _RowText(term, 0));
+            VERIFY_ARE_EQUAL(std::wstring{ L"01234" }, _RowText(term, 1));
+            VERIFY_ARE_EQUAL(COORD({ 5, 1 }), term.GetTextBuffer().GetCursor().GetPosition());
+
+            Log::Comment(L"Wider: the line is whole again.");
+            VERIFY_SUCCEEDED(term.UserResize({ 30, 5 }));
+            VERIFY_IS_FALSE(term.GetTextBuffer().GetRowByOffset(0).GetCharRow().WasWrapForced());
+            VERIFY_ARE_EQUAL(std::wstring{ L"0123456789012345678901234" }, _RowText(term, 0));
+            VERIFY_ARE_EQUAL(std::wstring{}, _RowText(term, 1));
+            VERIFY_ARE_EQUAL(COORD({ 25, 0 }), term.GetTextBuffer().GetCursor().GetPosition());
+
+            Log::Comment(L"Narrower: it wraps again at the new width.");
+            VERIFY_SUCCEEDED(term.UserResize({ 10, 5 }));
+            VERIFY_ARE_EQUAL(std::wstring{ L"0123456789" }, _RowText(term, 0));
+            VERIFY_ARE_EQUAL(std::wstring{ L"0123456789" }, _RowText(term, 1));
+            VERIFY_ARE_EQUAL(std::wstring{ L"01234" }, _RowText(term, 2));
+            VERIFY_ARE_EQUAL(COORD({ 5, 2 }), term.GetTextBuffer().GetCursor().GetPosition());
+        }
+
+        TEST_METHOD(ResizeKeepsCursorInView)
+        {
+            Terminal term = Terminal();
+            DummyRenderTarget emptyRT;
+            term.Create({ 20, 5 }, 10, emptyRT);
+
+            // Eight full-width lines push the viewport down by four rows.
+            for (int i = 0; i < 8; ++i)
+            {
+                term.Write(L"abcdefghijklmnopqrstuvwxyz\r\n");
+            }
+
+            const auto cursorBefore = term.GetTextBuffer().GetCursor().GetPosition();
+            const auto viewBefore = term.GetViewport();
+            VERIFY_IS_TRUE(viewBefore.IsInBounds(cursorBefore));
+
+            VERIFY_SUCCEEDED(term.UserResize({ 30, 5 }));
+
+            const auto cursorAfter = term.GetTextBuffer().GetCursor().GetPosition();
+            const auto viewAfter = term.GetViewport();
+            VERIFY_IS_TRUE(viewAfter.IsInBounds(cursorAfter));
+            VERIFY_ARE_EQUAL(cursorBefore.Y - viewBefore.Top(), cursorAfter.Y - viewAfter.Top());
+            VERIFY_ARE_EQUAL(std::wstring{ L"abcdefghijklmnopqrstuvwxyz" }, _RowText(term, 0));
+        }
+
+        TEST_METHOD(DragResizePerf)
+        {
+            BEGIN_TEST_METHOD_PROPERTIES()
+                TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+            END_TEST_METHOD_PROPERTIES()
+
+            Terminal term = Terminal();
+            DummyRenderTarget emptyRT;
+            term.Create({ 120, 30 }, 10000, emptyRT);
+
+            // 10k lines, every other one long enough to wrap.
+            const std::wstring shortLine = L"The quick brown fox jumps over the lazy dog.\r\n";
+            const std::wstring longLine = std::wstring(200, L'x') + L"\r\n";
+            for (int i = 0; i < 10000; ++i)
+            {
+                term.Write(i % 2 == 0 ? shortLine : longLine);
+            }
+
+            // Drag the window edge in and back out a column at a time.
+            std::vector<short> widths;
+            for (short width = 119; width >= 80; --width)
+            {
+                widths.push_back(width);
+            }
+            for (short width = 81; width <= 120; ++width)
+            {
+                widths.push_back(width);
+            }
+
+            std::chrono::microseconds slowest{ 0 };
+            const auto before = std::chrono::steady_clock::now();
+            for (const auto width : widths)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                VERIFY_SUCCEEDED(term.UserResize({ width, 30 }));
+                slowest = std::max(slowest, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start));
+            }
+            const auto total = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before);
+
+            Log::Comment(NoThrowString().Format(L"%zu resizes: %lld us average, %lld us slowest",
+                                                widths.size(),
+                                                total.count() / static_cast<long long>(widths.size()),
+                                                slowest.count()));
+        }
+    };
+}
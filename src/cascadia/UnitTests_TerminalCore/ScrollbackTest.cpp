@@ -0,0 +1,201 @@
+/*
+* Copyright (c) Microsoft Corporation.
+* Licensed under the MIT license.
+*
+* Class Name: ScrollbackTest
+*/
+#include "precomp.h"
+#include <WexTestClass.h>
+
+#include "../cascadia/TerminalCore/Terminal.hpp"
+#include "../renderer/inc/DummyRenderTarget.hpp"
+#include "consoletaeftemplates.hpp"
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+using namespace Microsoft::Terminal::Core;
+using namespace Microsoft::Console::Render;
+
+namespace TerminalCoreUnitTests
+{
+    class ScrollbackTest
+    {
+        TEST_CLASS(ScrollbackTest);
+
+        static std::wstring _RowText(Terminal& term, const short row)
+        {
+            auto text = term.GetTextBuffer().PinRowByOffset(row)->GetText();
+            text.erase(text.find_last_not_of(L' ') + 1);
+            return text;
+        }
+
+        static void _WriteLines(Terminal& term, const int count)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                term.Write(std::to_wstring(i) + L"\r\n");
+            }
+        }
+
+        TEST_METHOD(InfiniteScrollbackKeepsEveryRow)
+        {
+            Terminal term = Terminal();
+            DummyRenderTarget emptyRT;
+            term.Create({ 20, 5 }, 10, emptyRT);
+            term.EnableInfiniteScrollback();
+
+            // Every line i ends up on row i, counting the spilled rows.
+            _WriteLines(term, 100);
+            const auto spilled = term.GetTextBuffer().GetSpilledRowCount();
+            VERIFY_ARE_EQUAL(100u - 15u + 1u, spilled);
+
+            int top = -1;
+            int height = 0;
+            int bottom = 0;
+            term.SetScrollPositionChangedCallback([&](const int t, const int h, const int b) {
+                top = t;
+                height = h;
+                bottom = b;
+            });
+            term.Write(L"100\r\n");
+            VERIFY_ARE_EQUAL(97, top);
+            VERIFY_ARE_EQUAL(5, height);
+            VERIFY_ARE_EQUAL(102, bottom);
+
+            Log::Comment(L"Scrolling to the top shows the first line, which spilled out of the buffer.");
+            term.UserScrollViewport(0);
+            auto snapshot = term.GetSnapshot();
+            VERIFY_ARE_EQUAL(0, term.GetScrollOffset());
+            VERIFY_IS_LESS_THAN(snapshot->viewport.Top(), 0);
+            VERIFY_ARE_EQUAL(std::wstring{ L"0" }, _RowText(term, snapshot->viewport.Top()));
+            VERIFY_ARE_EQUAL(std::wstring{ L"4" }, _RowText(term, snapshot->viewport.BottomInclusive()));
+
+            Log::Comment(L"The renderer walks the spilled rows like any others.");
+            size_t cells = 0;
+            for (auto it = term.GetTextBuffer().GetCellDataAt(snapshot->viewport.Origin(), snapshot->viewport); it; ++it)
+            {
+                ++cells;
+            }
+            VERIFY_ARE_EQUAL(100u, cells);
+
+            Log::Comment(L"A view that straddles the top of the buffer shows spilled rows and buffer rows.");
+            term.UserScrollViewport(84);
+            snapshot = term.GetSnapshot();
+            VERIFY_ARE_EQUAL(84, term.GetScrollOffset());
+            VERIFY_ARE_EQUAL(std::wstring{ L"84" }, _RowText(term, snapshot->viewport.Top()));
+            VERIFY_ARE_EQUAL(std::wstring{ L"88" }, _RowText(term, snapshot->viewport.BottomInclusive()));
+            VERIFY_IS_LESS_THAN(snapshot->viewport.Top(), 0);
+            VERIFY_IS_GREATER_THAN(snapshot->viewport.BottomInclusive(), 0);
+        }
+
+        TEST_METHOD(InfiniteScrollbackReachesPastShortOffsets)
+        {
+            Terminal term = Terminal();
+            DummyRenderTarget emptyRT;
+            term.Create({ 20, 5 }, 10, emptyRT);
+            term.EnableInfiniteScrollback();
+
+            _WriteLines(term, 40000);
+            VERIFY_IS_GREATER_THAN(term.GetTextBuffer().GetSpilledRowCount(), static_cast<size_t>(SHRT_MAX));
+
+            Log::Comment(L"However far up the view is, it's at most a screen above the buffer's rows.");
+            for (const auto position : { 0, 1234, 20000, 39980 })
+            {
+                term.UserScrollViewport(position);
+                const auto snapshot = term.GetSnapshot();
+                VERIFY_ARE_EQUAL(position, term.GetScrollOffset());
+                VERIFY_IS_GREATER_THAN_OR_EQUAL(snapshot->viewport.Top(), -5);
+                VERIFY_ARE_EQUAL(std::to_wstring(position), _RowText(term, snapshot->viewport.Top()));
+            }
+
+            Log::Comment(L"Rows selected up there can be copied.");
+            term.UserScrollViewport(0);
+            term.SetSelectionAnchor({ 0, 0 });
+            term.SetEndSelectionPosition({ 1, 1 });
+            VERIFY_ARE_EQUAL(std::wstring{ L"0\r\n1" }, term.RetrieveSelectedTextFromBuffer(true));
+        }
+
+        TEST_METHOD(InfiniteScrollbackReflowsSpilledRows)
+        {
+            Terminal term = Terminal();
+            DummyRenderTarget emptyRT;
+            term.Create({ 20, 5 }, 10, emptyRT);
+            term.EnableInfiniteScrollback();
+
+            // 25 characters wrap onto a second row at 20 columns.
+            term.Write(L"0123456789012345678901234\r\n");
+            _WriteLines(term, 20);
+            const auto spilled = gsl::narrow<short>(term.GetTextBuffer().GetSpilledRowCount());
+            VERIFY_ARE_EQUAL(8, spilled);
+            VERIFY_ARE_EQUAL(std::wstring{ L"01234567890123456789" }, _RowText(term, static_cast<short>(-spilled)));
+
+            Log::Comment(L"Wider: the spilled line is whole again.");
+            VERIFY_SUCCEEDED(term.UserResize({ 30, 5 }));
+            term.UserScrollViewport(0);
+            const auto snapshot = term.GetSnapshot();
+            VERIFY_ARE_EQUAL(std::wstring{ L"0123456789012345678901234" }, _RowText(term, snapshot->viewport.Top()));
+            VERIFY_ARE_EQUAL(std::wstring{ L"0" }, _RowText(term, static_cast<short>(snapshot->viewport.Top() + 1)));
+        }
+
+        TEST_METHOD(ScrollbackIsSavedAndRestored)
+        {
+            const auto path = (std::filesystem::temp_directory_path() / L"ScrollbackIsSavedAndRestored.snapshot").wstring();
+            std::filesystem::remove(path);
+            auto cleanup = wil::scope_exit([&]() { std::filesystem::remove(path); });
+
+            {
+                Terminal term = Terminal();
+                DummyRenderTarget emptyRT;
+                term.Create({ 20, 5 }, 10, emptyRT);
+                term.EnableInfiniteScrollback();
+                term.RestoreScrollback(path);
+
+                _WriteLines(term, 100);
+                auto lock = term.LockForWriting();
+                term.SaveScrollback();
+            }
+
+            Log::Comment(L"The next session shows the rows that fit in its buffer and spills the rest.");
+            {
+                Terminal term = Terminal();
+                DummyRenderTarget emptyRT;
+                term.Create({ 20, 5 }, 10, emptyRT);
+                term.EnableInfiniteScrollback();
+                term.RestoreScrollback(path);
+                VERIFY_ARE_EQUAL(86u, term.GetTextBuffer().GetSpilledRowCount());
+
+                auto snapshot = term.GetSnapshot();
+                VERIFY_ARE_EQUAL(96, term.GetScrollOffset());
+                VERIFY_ARE_EQUAL(std::wstring{ L"96" }, _RowText(term, snapshot->viewport.Top()));
+                VERIFY_ARE_EQUAL(COORD({ 0, 14 }), snapshot->cursorPosition);
+
+                term.UserScrollViewport(0);
+                snapshot = term.GetSnapshot();
+                VERIFY_ARE_EQUAL(std::wstring{ L"0" }, _RowText(term, snapshot->viewport.Top()));
+
+                term.Write(L"100\r\n");
+                auto lock = term.LockForWriting();
+                term.SaveScrollback();
+            }
+
+            Log::Comment(L"The file keeps the rows of both sessions.");
+            {
+                Terminal term = Terminal();
+                DummyRenderTarget emptyRT;
+                term.Create({ 20, 5 }, 10, emptyRT);
+                term.EnableInfiniteScrollback();
+                term.RestoreScrollback(path);
+                VERIFY_ARE_EQUAL(87u, term.GetTextBuffer().GetSpilledRowCount());
+
+                for (const auto position : { 0, 50, 97 })
+                {
+                    term.UserScrollViewport(position);
+                    const auto snapshot = term.GetSnapshot();
+                    VERIFY_ARE_EQUAL(std::to_wstring(position), _RowText(term, snapshot->viewport.Top()));
+                }
+            }
+        }
+    };
+}
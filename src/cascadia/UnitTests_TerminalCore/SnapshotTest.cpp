@@ -0,0 +1,398 @@
+/*
+* Copyright (c) Microsoft Corporation.
+* Licensed under the MIT license.
+*
+* Class Name: SnapshotTest
+*/
+#include "precomp.h"
+#include <WexTestClass.h>
+
+#include "../cascadia/TerminalCore/Terminal.hpp"
+#include "../cascadia/TerminalCore/SnapshotRenderData.hpp"
+#include "../renderer/inc/DummyRenderTarget.hpp"
+#include "consoletaeftemplates.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+
+using namespace Microsoft::Terminal::Core;
+using namespace Microsoft::Console::Render;
+using namespace Microsoft::Console::Types;
+
+namespace TerminalCoreUnitTests
+{
+    // Stands in for the renderer, and records which rows it's asked to paint.
+    class RecordingRenderTarget final : public IRenderTarget
+    {
+    public:
+        std::vector<SHORT> rows;
+        std::vector<SHORT> scrolls;
+        size_t all = 0;
+
+        void TriggerRedraw(const Viewport& region) override { rows.push_back(region.Top()); }
+        void TriggerRedraw(const COORD* const pcoord) override { rows.push_back(pcoord->Y); }
+        void TriggerRedrawCursor(const COORD* const /*pcoord*/) override {}
+        void TriggerRedrawAll() override { ++all; }
+        void TriggerTeardown() override {}
+        void TriggerSelection() override {}
+        void TriggerScroll() override {}
+        void TriggerScroll(const COORD* const pcoordDelta) override { scrolls.push_back(pcoordDelta->Y); }
+        void TriggerCircling() override {}
+        void TriggerTitleChange() override {}
+
+        void Clear()
+        {
+            rows.clear();
+            scrolls.clear();
+            all = 0;
+        }
+    };
+
+    class DummyRenderThread final : public IRenderThread
+    {
+    public:
+        void NotifyPaint() override {}
+        void EnablePainting() override {}
+        void WaitForPaintCompletionAndDisable(const DWORD /*dwTimeoutMs*/) override {}
+    };
+
+    class SnapshotTest
+    {
+        TEST_CLASS(SnapshotTest);
+
+        // Stands in for the renderer painting a frame.
+        static void _Frame(SnapshotRenderData& renderData)
+        {
+            renderData.LockConsole();
+            renderData.UnlockConsole();
+        }
+
+        // 1000 colored lines, for a writer thread to flood a terminal with.
+        static std::wstring _OutputBurst()
+        {
+            std::wstring burst;
+            for (int i = 0; i < 1000; ++i)
+            {
+                burst += L"\x1b[3" + std::to_wstring(i % 8) + L"m" + std::wstring(100, static_cast<wchar_t>(L'a' + i % 26)) + L"\r\n";
+            }
+            return burst;
+        }
+
+        static std::wstring _ScreenRowText(SnapshotRenderData& renderData, const short row)
+        {
+            auto text = renderData.GetTextBuffer().GetRowByOffset(row).GetText();
+            text.erase(text.find_last_not_of(L' ') + 1);
+            return text;
+        }
+
+        static std::wstring _RowText(Terminal& term, const short row)
+        {
+            auto text = term.GetTextBuffer().GetRowByOffset(row).GetText();
+            text.erase(text.find_last_not_of(L' ') + 1);
+            return text;
+        }
+
+        TEST_METHOD(SnapshotFollowsOutput)
+        {
+            Terminal term = Terminal();
+            DummyRenderTarget emptyRT;
+            term.Create({ 20, 5 }, 10, emptyRT);
+
+            const auto first = term.GetSnapshot();
+            VERIFY_ARE_EQUAL(5, first->viewport.Height());
+            VERIFY_ARE_EQUAL(COORD({ 0, 0 }), first->cursorPosition);
+
+            term.Write(L"hello\r\nworld");
+
+            const auto second = term.GetSnapshot();
+            VERIFY_IS_GREATER_THAN(second->generation, first->generation);
+            VERIFY_ARE_EQUAL(COORD({ 5, 1 }), second->cursorPosition);
+
+            Log::Comment(L"A snapshot that's still held doesn't change underneath its reader.");
+            VERIFY_ARE_EQUAL(COORD({ 0, 0 }), first->cursorPosition);
+        }
+
+        TEST_METHOD(SnapshotFollowsScrolling)
+        {
+            Terminal term = Terminal();
+            DummyRenderTarget emptyRT;
+            term.Create({ 20, 5 }, 10, emptyRT);
+
+            for (int i = 0; i < 9; ++i)
+            {
+                term.Write(std::to_wstring(i) + L"\r\n");
+            }
+
+            auto snapshot = term.GetSnapshot();
+            VERIFY_ARE_EQUAL(5, snapshot->viewport.Top());
+            VERIFY_ARE_EQUAL(10, snapshot->bufferHeight);
+            VERIFY_ARE_EQUAL(std::wstring{ L"5" }, _RowText(term, snapshot->viewport.Top()));
+
+            term.UserScrollViewport(2);
+            snapshot = term.GetSnapshot();
+            VERIFY_ARE_EQUAL(2, snapshot->viewport.Top());
+            VERIFY_ARE_EQUAL(2, term.GetScrollOffset());
+            VERIFY_ARE_EQUAL(std::wstring{ L"2" }, _RowText(term, snapshot->viewport.Top()));
+        }
+
+        TEST_METHOD(WriteKeepsSurrogatePairsAcrossChunks)
+        {
+            Terminal term = Terminal();
+            DummyRenderTarget emptyRT;
+            term.Create({ 80, 5 }, 0, emptyRT);
+
+            // Put a surrogate pair right across the boundary of the first chunk
+            // of output that Write processes under the lock.
+            std::wstring output(4095, L'\r');
+            output += L"\xD83D\xDE00";
+            term.Write(output);
+
+            VERIFY_ARE_EQUAL(std::wstring{ L"\xD83D\xDE00" }, _RowText(term, 0));
+        }
+
+        TEST_METHOD(RendererPaintsTheScreenOfTheSnapshot)
+        {
+            Terminal term = Terminal();
+            SnapshotRenderData renderData{ term };
+            term.Create({ 20, 5 }, 10, renderData);
+
+            for (int i = 0; i < 9; ++i)
+            {
+                term.Write(std::to_wstring(i) + L"\r\n");
+            }
+            term.Write(L"\x1b[31mred");
+
+            renderData.LockConsole();
+            VERIFY_ARE_EQUAL(Viewport::FromDimensions({ 0, 0 }, { 20, 5 }).ToInclusive(), renderData.GetViewport().ToInclusive());
+            for (short y = 0; y < 4; ++y)
+            {
+                VERIFY_ARE_EQUAL(std::to_wstring(y + 5), _ScreenRowText(renderData, y));
+            }
+            VERIFY_ARE_EQUAL(std::wstring{ L"red" }, _ScreenRowText(renderData, 4));
+            VERIFY_ARE_EQUAL(COORD({ 3, 4 }), renderData.GetCursorPosition());
+
+            Log::Comment(L"The screen keeps the colors of the text it copied.");
+            const auto red = renderData.GetForegroundColor(renderData.GetTextBuffer().GetRowByOffset(4).GetAttrRow().GetAttrByColumn(0));
+            VERIFY_ARE_EQUAL(term.GetForegroundColor(term.GetTextBuffer().GetRowByOffset(9).GetAttrRow().GetAttrByColumn(0)), red);
+            renderData.UnlockConsole();
+
+            Log::Comment(L"Scrolled back, the screen shows the rows up there.");
+            term.UserScrollViewport(2);
+            renderData.LockConsole();
+            VERIFY_ARE_EQUAL(std::wstring{ L"2" }, _ScreenRowText(renderData, 0));
+            VERIFY_ARE_EQUAL(COORD({ 3, 7 }), renderData.GetCursorPosition());
+            renderData.UnlockConsole();
+        }
+
+        TEST_METHOD(FramesInvalidateOnlyWhatChanged)
+        {
+            Terminal term = Terminal();
+            SnapshotRenderData renderData{ term };
+            RecordingRenderTarget renderer;
+            DummyRenderThread renderThread;
+            renderData.Connect(renderer, renderThread);
+            term.Create({ 20, 5 }, 10, renderData);
+
+            _Frame(renderData);
+            VERIFY_ARE_EQUAL(1u, renderer.all);
+
+            term.Write(L"a\r\nb\r\nc");
+            renderer.Clear();
+            _Frame(renderData);
+            VERIFY_ARE_EQUAL((std::vector<SHORT>{ 0, 1, 2 }), renderer.rows);
+
+            Log::Comment(L"Only the row that was written to is painted again.");
+            term.Write(L"d");
+            renderer.Clear();
+            _Frame(renderData);
+            VERIFY_ARE_EQUAL((std::vector<SHORT>{ 2 }), renderer.rows);
+            VERIFY_ARE_EQUAL(0u, renderer.all);
+
+            Log::Comment(L"Without output, nothing is painted again.");
+            renderer.Clear();
+            _Frame(renderData);
+            VERIFY_ARE_EQUAL(0u, renderer.rows.size());
+
+            Log::Comment(L"Scrolling moves what was painted, and paints the row that came in.");
+            term.Write(L"\r\n\r\n\r\n");
+            renderer.Clear();
+            _Frame(renderData);
+            VERIFY_ARE_EQUAL((std::vector<SHORT>{ -1 }), renderer.scrolls);
+            VERIFY_ARE_EQUAL((std::vector<SHORT>{ 4 }), renderer.rows);
+            VERIFY_ARE_EQUAL(0u, renderer.all);
+
+            Log::Comment(L"So does scrolling back.");
+            term.UserScrollViewport(0);
+            renderer.Clear();
+            _Frame(renderData);
+            VERIFY_ARE_EQUAL((std::vector<SHORT>{ 1 }), renderer.scrolls);
+            VERIFY_ARE_EQUAL((std::vector<SHORT>{ 0 }), renderer.rows);
+        }
+
+        TEST_METHOD(FramesDontWaitForWrites)
+        {
+            Terminal term = Terminal();
+            SnapshotRenderData renderData{ term };
+            term.Create({ 20, 5 }, 10, renderData);
+            term.Write(L"hello");
+
+            // Hold the lock the way a long write would.
+            auto lock = term.LockForWriting();
+            auto frame = std::async(std::launch::async, [&]() {
+                renderData.LockConsole();
+                const auto text = _ScreenRowText(renderData, 0);
+                renderData.UnlockConsole();
+                return text;
+            });
+            const auto status = frame.wait_for(std::chrono::seconds(5));
+            lock.unlock();
+
+            VERIFY_ARE_EQUAL(std::future_status::ready, status);
+            VERIFY_ARE_EQUAL(std::wstring{ L"hello" }, frame.get());
+        }
+
+        BEGIN_TEST_METHOD(ScrollQueryDuringOutputPerf)
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD()
+
+        BEGIN_TEST_METHOD(FrameLatencyDuringOutputPerf)
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD()
+    };
+
+    // A writer thread streams output into the terminal the way a connection
+    // would, while this thread asks where the viewport is the way the UI's
+    // scrollbar would. It asks once through the snapshot and once under the
+    // lock, which is how it had to ask before.
+    void SnapshotTest::ScrollQueryDuringOutputPerf()
+    {
+        const auto burst = _OutputBurst();
+
+        for (const bool fromSnapshot : { true, false })
+        {
+            Terminal term = Terminal();
+            DummyRenderTarget emptyRT;
+            term.Create({ 120, 30 }, 9000, emptyRT);
+
+            std::atomic<bool> writing{ true };
+            std::chrono::microseconds writeTime{ 0 };
+            std::thread writer([&]() {
+                const auto start = std::chrono::steady_clock::now();
+                for (int i = 0; i < 20; ++i)
+                {
+                    term.Write(burst);
+                }
+                writeTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+                writing = false;
+            });
+
+            size_t queries = 0;
+            long long topSum = 0;
+            std::chrono::microseconds queryTime{ 0 };
+            std::chrono::microseconds slowest{ 0 };
+            while (writing)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                if (fromSnapshot)
+                {
+                    topSum += term.GetScrollOffset();
+                }
+                else
+                {
+                    term.LockConsole();
+                    topSum += term.GetViewport().Top();
+                    term.UnlockConsole();
+                }
+                const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+                queryTime += elapsed;
+                slowest = std::max(slowest, elapsed);
+                ++queries;
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(4));
+            }
+            writer.join();
+
+            const auto written = 20 * burst.size();
+            Log::Comment(NoThrowString().Format(L"%s: %zu chars in %lld us (%lld chars/ms), %zu queries: %lld us average, %lld us slowest (top sum %lld)",
+                                                fromSnapshot ? L"snapshot" : L"locked",
+                                                written,
+                                                writeTime.count(),
+                                                static_cast<long long>(written) * 1000 / std::max<long long>(writeTime.count(), 1),
+                                                queries,
+                                                queryTime.count() / static_cast<long long>(std::max<size_t>(queries, 1)),
+                                                slowest.count(),
+                                                topSum));
+        }
+    }
+
+    // A writer thread floods the terminal with output the way a connection
+    // would, while this thread paints frames the way the render thread would:
+    // it starts a frame, walks every cell on the screen and ends the frame. It
+    // paints once from the snapshots, and once from the buffer under the lock,
+    // which is how the renderer had to paint before. A frame's latency is the
+    // time from starting it to ending it.
+    void SnapshotTest::FrameLatencyDuringOutputPerf()
+    {
+        const auto burst = _OutputBurst();
+
+        for (const bool fromSnapshot : { true, false })
+        {
+            Terminal term = Terminal();
+            SnapshotRenderData renderData{ term };
+            term.Create({ 120, 30 }, 9000, renderData);
+            IRenderData& paintFrom = fromSnapshot ? static_cast<IRenderData&>(renderData) : static_cast<IRenderData&>(term);
+
+            std::atomic<bool> writing{ true };
+            std::chrono::microseconds writeTime{ 0 };
+            std::thread writer([&]() {
+                const auto start = std::chrono::steady_clock::now();
+                for (int i = 0; i < 20; ++i)
+                {
+                    term.Write(burst);
+                }
+                writeTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+                writing = false;
+            });
+
+            size_t frames = 0;
+            size_t cells = 0;
+            std::chrono::microseconds frameTime{ 0 };
+            std::chrono::microseconds slowest{ 0 };
+            while (writing)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                paintFrom.LockConsole();
+                const auto viewport = paintFrom.GetViewport();
+                for (auto it = paintFrom.GetTextBuffer().GetCellDataAt(viewport.Origin(), viewport); it; ++it)
+                {
+                    ++cells;
+                }
+                paintFrom.UnlockConsole();
+                const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+                frameTime += elapsed;
+                slowest = std::max(slowest, elapsed);
+                ++frames;
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(16));
+            }
+            writer.join();
+
+            const auto written = 20 * burst.size();
+            Log::Comment(NoThrowString().Format(L"%s: %zu chars in %lld us (%lld chars/ms), %zu frames: %lld us average, %lld us slowest (%zu cells)",
+                                                fromSnapshot ? L"snapshot" : L"locked",
+                                                written,
+                                                writeTime.count(),
+                                                static_cast<long long>(written) * 1000 / std::max<long long>(writeTime.count(), 1),
+                                                frames,
+                                                frameTime.count() / static_cast<long long>(std::max<size_t>(frames, 1)),
+                                                slowest.count(),
+                                                cells));
+        }
+    }
+}
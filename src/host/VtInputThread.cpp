@@ -27,6 +27,8 @@ VtInputThread::VtInputThread(_In_ wil::unique_hfile hPipe,
                              const bool inheritCursor) :
     _hFile{ std::move(hPipe) },
     _hThread{},
+    _readBuffer{ std::make_unique<byte[]>(s_cbReadBuffer) },
+    _pInputEngine{ nullptr },
     _utf8Parser{ CP_UTF8 },
     _dwThreadId{ 0 },
     _exitRequested{ false },
@@ -42,6 +44,10 @@ VtInputThread::VtInputThread(_In_ wil::unique_hfile hPipe,
     auto engine = std::make_unique<InputStateMachineEngine>(new InteractDispatch(pGetSet.release()), inheritCursor);
     THROW_IF_NULL_ALLOC(engine.get());
 
+    // Commit all the input from a single read to the input buffer at once.
+    engine->SetBatchInput(true);
+    _pInputEngine = engine.get();
+
     _pInputStateMachine = std::make_unique<StateMachine>(engine.release());
     THROW_IF_NULL_ALLOC(_pInputStateMachine.get());
 }
@@ -78,6 +84,7 @@ HRESULT VtInputThread::_HandleRunInput(_In_reads_(cch) const byte* const charBuf
             return S_FALSE;
         }
         _pInputStateMachine->ProcessString(pwsSequence.get(), cchSequence);
+        RETURN_HR_IF(E_FAIL, !_pInputEngine->FlushBatchedInput());
     }
     CATCH_RETURN();
 
@@ -106,9 +113,8 @@ DWORD VtInputThread::StaticVtInputThreadProc(_In_ LPVOID lpParameter)
 // - <none>
 void VtInputThread::DoReadInput(const bool throwOnFail)
 {
-    byte buffer[256];
     DWORD dwRead = 0;
-    bool fSuccess = !!ReadFile(_hFile.get(), buffer, ARRAYSIZE(buffer), &dwRead, nullptr);
+    bool fSuccess = !!ReadFile(_hFile.get(), _readBuffer.get(), gsl::narrow_cast<DWORD>(s_cbReadBuffer), &dwRead, nullptr);
 
     // If we failed to read because the terminal broke our pipe (usually due
     //      to dying itself), close gracefully with ERROR_BROKEN_PIPE.
@@ -121,7 +127,7 @@ void VtInputThread::DoReadInput(const bool throwOnFail)
         return;
     }
 
-    HRESULT hr = _HandleRunInput(buffer, dwRead);
+    HRESULT hr = _HandleRunInput(_readBuffer.get(), dwRead);
     if (FAILED(hr))
     {
         if (throwOnFail)
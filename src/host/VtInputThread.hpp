@@ -15,6 +15,7 @@ Author(s):
 #pragma once
 
 #include "..\terminal\parser\StateMachine.hpp"
+#include "..\terminal\parser\InputStateMachineEngine.hpp"
 #include "utf8ToWideCharParser.hpp"
 
 namespace Microsoft::Console
@@ -41,7 +42,13 @@ namespace Microsoft::Console
         bool _exitRequested;
         HRESULT _exitResult;
 
+        // Large enough that a paste arrives in a handful of reads rather
+        // than thousands.
+        static constexpr size_t s_cbReadBuffer = 16 * 1024;
+        std::unique_ptr<byte[]> _readBuffer;
+
         std::unique_ptr<StateMachine> _pInputStateMachine;
+        Microsoft::Console::VirtualTerminal::InputStateMachineEngine* _pInputEngine; // owned by _pInputStateMachine
         Utf8ToWideCharParser _utf8Parser;
     };
 }
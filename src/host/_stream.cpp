@@ -19,6 +19,7 @@
 #include "../types/inc/convert.hpp"
 #include "../types/inc/GlyphWidth.hpp"
 #include "../types/inc/Viewport.hpp"
+#include "../types/inc/utils.hpp"
 
 #include "..\interactivity\inc\ServiceLocator.hpp"
 
@@ -250,6 +251,10 @@ NTSTATUS AdjustCursorPosition(SCREEN_INFORMATION& screenInfo,
             COORD WindowOrigin;
             WindowOrigin.X = 0;
             WindowOrigin.Y = coordCursor.Y - screenInfo.GetViewport().BottomInclusive();
+            // Checked before moving the viewport, so a flood that starts
+            // fast-forwarding here doesn't move the window for every row.
+            screenInfo.CountScrolledRows(WindowOrigin.Y);
+            screenInfo.ShouldFastForward();
             Status = screenInfo.SetViewportOrigin(false, WindowOrigin, true);
         }
     }
@@ -401,6 +406,30 @@ NTSTATUS WriteCharsLegacy(SCREEN_INFORMATION& screenInfo,
         XPosition = cursor.GetPosition().X;
         size_t i = 0;
         wchar_t* LocalBufPtr = LocalBuffer;
+
+        // Most output is plain text. A run of it goes into the row straight from
+        // the caller's string, all the way to the right edge, instead of being
+        // copied over and measured one character at a time.
+        const wchar_t* pwchRun = nullptr;
+        if (XPosition < coordScreenBufferSize.X)
+        {
+            const size_t cchRun = Microsoft::Console::Utils::MeasurePrintableAsciiRun({ lpString,
+                                                                                        std::min((BufferSize - *pcb) / sizeof(wchar_t),
+                                                                                                 static_cast<size_t>(coordScreenBufferSize.X - XPosition)) });
+            if (cchRun != 0)
+            {
+                pwchRun = lpString;
+                i = cchRun;
+                XPosition = gsl::narrow_cast<SHORT>(XPosition + cchRun);
+
+                lpString += cchRun;
+                pwchRealUnicode += cchRun;
+                pwchBuffer += cchRun;
+                *pcb += cchRun * sizeof(wchar_t);
+                goto EndWhile;
+            }
+        }
+
         while (*pcb < BufferSize && i < LOCAL_BUFFER_SIZE && XPosition < coordScreenBufferSize.X)
         {
 #pragma prefast(suppress:26019, "Buffer is taken in multiples of 2. Validation is ok.")
@@ -558,16 +587,32 @@ NTSTATUS WriteCharsLegacy(SCREEN_INFORMATION& screenInfo,
             }
 
             // line was wrapped if we're writing up to the end of the current row
-            OutputCellIterator it(std::wstring_view(LocalBuffer, i), Attributes);
-            const auto itEnd = screenInfo.Write(it);
-
-            // Notify accessibility
-            screenInfo.NotifyAccessibilityEventing(CursorPosition.X, CursorPosition.Y,
-                                                   CursorPosition.X + gsl::narrow<SHORT>(i - 1), CursorPosition.Y);
-
             // The number of "spaces" or "cells" we have consumed needs to be reported and stored for later
             // when/if we need to erase the command line.
-            TempNumSpaces += itEnd.GetCellDistance(it);
+            // While fast-forwarding, plain text goes into the row without telling
+            // the renderer; the whole screen is redrawn once the write is over.
+            const bool fastForward = screenInfo.ShouldFastForward();
+            if (pwchRun && fastForward)
+            {
+                TempNumSpaces += textBuffer.GetRowByOffset(CursorPosition.Y).WriteNarrowText(std::wstring_view(pwchRun, i), CursorPosition.X, Attributes, true);
+            }
+            else if (pwchRun)
+            {
+                TempNumSpaces += textBuffer.WriteNarrowLine(std::wstring_view(pwchRun, i), Attributes, CursorPosition, true);
+            }
+            else
+            {
+                OutputCellIterator it(std::wstring_view(LocalBuffer, i), Attributes);
+                const auto itEnd = screenInfo.Write(it);
+                TempNumSpaces += itEnd.GetCellDistance(it);
+            }
+
+            // Notify accessibility
+            if (!fastForward)
+            {
+                screenInfo.NotifyAccessibilityEventing(CursorPosition.X, CursorPosition.Y,
+                                                       CursorPosition.X + gsl::narrow<SHORT>(i - 1), CursorPosition.Y);
+            }
             CursorPosition.X = XPosition;
 
             // enforce a delayed newline if we're about to pass the end and the WC_DELAY_EOL_WRAP flag is set.
@@ -946,6 +991,10 @@ NTSTATUS WriteChars(SCREEN_INFORMATION& screenInfo,
                     const DWORD dwFlags,
                     _Inout_opt_ PSHORT const psScrollY)
 {
+    // Floods of output are fast-forwarded through, and caught up on when the write is over.
+    screenInfo.BeginWrite();
+    auto endWrite = wil::scope_exit([&]() { screenInfo.EndWrite(); });
+
     if (!WI_IsFlagSet(screenInfo.OutputMode, ENABLE_VIRTUAL_TERMINAL_PROCESSING) ||
         !WI_IsFlagSet(screenInfo.OutputMode, ENABLE_PROCESSED_OUTPUT))
     {
@@ -22,32 +22,16 @@
 
 #pragma hdrstop
 
-struct case_insensitive_hash
-{
-    std::size_t operator()(const std::wstring& key) const
-    {
-        std::wstring lower(key);
-        std::transform(lower.begin(), lower.end(), lower.begin(), ::towlower);
-        std::hash<std::wstring> hash;
-        return hash(lower);
-    }
-};
+// Both levels are keyed by names folded to lower case when they're stored, so
+// a lookup folds the name it's given once and then hashes and compares it
+// as-is rather than folding both sides on every probe.
+std::unordered_map<std::wstring,
+    std::unordered_map<std::wstring, Alias::Template>> g_aliasData;
 
-struct case_insensitive_equality
+static void FoldCase(std::wstring& str)
 {
-    bool operator()(const std::wstring& lhs, const std::wstring& rhs) const
-    {
-        return 0 == _wcsicmp(lhs.data(), rhs.data());
-    }
-};
-
-std::unordered_map<std::wstring,
-    std::unordered_map<std::wstring,
-    std::wstring,
-    case_insensitive_hash,
-    case_insensitive_equality>,
-    case_insensitive_hash,
-    case_insensitive_equality> g_aliasData;
+    std::transform(str.begin(), str.end(), str.begin(), ::towlower);
+}
 
 // Routine Description:
 // - Adds a command line alias to the global set.
@@ -101,8 +85,8 @@ HRESULT ApiRoutines::AddConsoleAliasWImpl(const std::wstring_view source,
         std::wstring sourceString(source);
         std::wstring targetString(target);
 
-        std::transform(exeNameString.begin(), exeNameString.end(), exeNameString.begin(), towlower);
-        std::transform(sourceString.begin(), sourceString.end(), sourceString.begin(), towlower);
+        FoldCase(exeNameString);
+        FoldCase(sourceString);
 
         if (targetString.size() == 0)
         {
@@ -110,13 +94,13 @@ HRESULT ApiRoutines::AddConsoleAliasWImpl(const std::wstring_view source,
             auto exeData = g_aliasData.find(exeNameString);
             if (exeData != g_aliasData.end())
             {
-                g_aliasData[exeNameString].erase(sourceString);
+                exeData->second.erase(sourceString);
             }
         }
         else
         {
-            // Map will auto-create each level as necessary
-            g_aliasData[exeNameString][sourceString] = targetString;
+            // Map will auto-create the exe level as necessary
+            g_aliasData[exeNameString].insert_or_assign(sourceString, Alias::Template{ targetString });
         }
     }
     CATCH_RETURN();
@@ -154,15 +138,17 @@ HRESULT GetConsoleAliasWImplHelper(const std::wstring_view source,
 
     std::wstring exeNameString(exeName);
     std::wstring sourceString(source);
+    FoldCase(exeNameString);
+    FoldCase(sourceString);
 
     // For compatibility, return ERROR_GEN_FAILURE for any result where the alias can't be found.
     // We use .find for the iterators then dereference to search without creating entries.
     const auto exeIter = g_aliasData.find(exeNameString);
     RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_GEN_FAILURE), exeIter == g_aliasData.end());
-    const auto exeData = exeIter->second;
+    const auto& exeData = exeIter->second;
     const auto sourceIter = exeData.find(sourceString);
     RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_GEN_FAILURE), sourceIter == exeData.end());
-    const auto targetString = sourceIter->second;
+    const auto& targetString = sourceIter->second.GetTarget();
     RETURN_HR_IF(HRESULT_FROM_WIN32(ERROR_GEN_FAILURE), targetString.size() == 0);
 
     // TargetLength is a byte count, convert to characters.
@@ -321,7 +307,8 @@ HRESULT GetConsoleAliasesLengthWImplHelper(const std::wstring_view exeName,
     
     try
     {
-        const std::wstring exeNameString(exeName);
+        std::wstring exeNameString(exeName);
+        FoldCase(exeNameString);
 
         size_t cchNeeded = 0;
 
@@ -339,18 +326,20 @@ HRESULT GetConsoleAliasesLengthWImplHelper(const std::wstring_view exeName,
         auto exeIter = g_aliasData.find(exeNameString);
         if (exeIter != g_aliasData.end())
         {
-            auto list = exeIter->second;
+            const auto& list = exeIter->second;
             for (auto& pair : list)
             {
+                const auto& target = pair.second.GetTarget();
+
                 // Alias stores lengths in bytes.
                 size_t cchSource = pair.first.size();
-                size_t cchTarget = pair.second.size();
+                size_t cchTarget = target.size();
 
                 // If we're counting how much multibyte space will be needed, trial convert the source and target strings before we add.
                 if (!countInUnicode)
                 {
                     cchSource = GetALengthFromW(codepage, pair.first);
-                    cchTarget = GetALengthFromW(codepage, pair.second);
+                    cchTarget = GetALengthFromW(codepage, target);
                 }
 
                 // Accumulate all sizes to the final string count.
@@ -461,6 +450,7 @@ HRESULT GetConsoleAliasesWImplHelper(const std::wstring_view exeName,
     }
 
     std::wstring exeNameString(exeName);
+    FoldCase(exeNameString);
 
     LPWSTR AliasesBufferPtrW = aliasBuffer.has_value() ? aliasBuffer.value().data() : nullptr;
     size_t cchTotalLength = 0; // accumulate the characters we need/have copied as we walk the list
@@ -473,12 +463,14 @@ HRESULT GetConsoleAliasesWImplHelper(const std::wstring_view exeName,
     auto exeIter = g_aliasData.find(exeNameString);
     if (exeIter != g_aliasData.end())
     {
-        auto list = exeIter->second;
+        const auto& list = exeIter->second;
         for (auto& pair : list)
         {
+            const auto& target = pair.second.GetTarget();
+
             // Alias stores lengths in bytes.
             size_t const cchSource = pair.first.size();
-            size_t const cchTarget = pair.second.size();
+            size_t const cchTarget = target.size();
 
             // Add up how many characters we will need for the full alias data.
             size_t cchNeeded = 0;
@@ -508,7 +500,7 @@ HRESULT GetConsoleAliasesWImplHelper(const std::wstring_view exeName,
                 RETURN_IF_FAILED(SizeTSub(cchAliasBufferRemaining, aliasesSeparator.size(), &cchAliasBufferRemaining));
                 AliasesBufferPtrW += aliasesSeparator.size();
 
-                RETURN_IF_FAILED(StringCchCopyNW(AliasesBufferPtrW, cchAliasBufferRemaining, pair.second.data(), cchTarget));
+                RETURN_IF_FAILED(StringCchCopyNW(AliasesBufferPtrW, cchAliasBufferRemaining, target.data(), cchTarget));
                 RETURN_IF_FAILED(SizeTSub(cchAliasBufferRemaining, cchTarget, &cchAliasBufferRemaining));
                 AliasesBufferPtrW += cchTarget;
 
@@ -862,22 +854,24 @@ void Alias::s_TrimTrailingCrLf(std::wstring& str)
 }
 
 // Routine Description:
-// - Tokenizes a string into a collection using space as a separator
+// - Tokenizes a string using space as a separator. Only the alias name and
+//   the first nine arguments can be referred to by a macro, so that's as
+//   far as it goes.
 // Arguments:
 // - str - String to tokenize
+// - tokens - Receives views into str. Unused ones are left empty.
 // Return Value:
-// - Collection of tokenized strings
-std::deque<std::wstring> Alias::s_Tokenize(const std::wstring& str)
+// - The number of tokens found, at most the size of tokens
+size_t Alias::s_Tokenize(const std::wstring_view str, Tokens& tokens) noexcept
 {
-    std::deque<std::wstring> result;
+    tokens.fill({});
 
+    size_t count = 0;
     size_t prevIndex = 0;
     auto spaceIndex = str.find(L' ');
-    while (std::wstring::npos != spaceIndex)
+    while (std::wstring_view::npos != spaceIndex && count < tokens.size())
     {
-        const auto length = spaceIndex - prevIndex;
-
-        result.emplace_back(str.substr(prevIndex, length));
+        tokens[count++] = str.substr(prevIndex, spaceIndex - prevIndex);
 
         spaceIndex++;
         prevIndex = spaceIndex;
@@ -886,9 +880,12 @@ std::deque<std::wstring> Alias::s_Tokenize(const std::wstring& str)
     }
 
     // Place the final one into the set.
-    result.emplace_back(str.substr(prevIndex));
+    if (count < tokens.size())
+    {
+        tokens[count++] = str.substr(prevIndex);
+    }
 
-    return result;
+    return count;
 }
 
 // Routine Description:
@@ -898,74 +895,15 @@ std::deque<std::wstring> Alias::s_Tokenize(const std::wstring& str)
 // - str - String to split into just args
 // Return Value:
 // - Only the arguments part of the string or empty if there are no arguments.
-std::wstring Alias::s_GetArgString(const std::wstring& str)
-{
-    std::wstring result;
-    auto firstSpace = str.find_first_of(L' ');
-    if (std::wstring::npos != firstSpace)
-    {
-        firstSpace++;
-        if (firstSpace < str.size())
-        {
-            result = str.substr(firstSpace);
-        }
-    }
-
-    return result;
-}
-
-// Routine Description:
-// - Checks the given character to see if it is a numbered arg replacement macro
-//   and replaces it with the counted argument if there is a match
-// Arguments:
-// - ch - Character to test as a macro
-// - appendToStr - Append the macro result here if it matched
-// - tokens - Tokens of the original command string. 0 is alias. 1-N are arguments.
-// Return Value:
-// - True if we found the macro and appended to the string.
-// - False if the given character doesn't match this macro.
-bool Alias::s_TryReplaceNumberedArgMacro(const wchar_t ch,
-                                         std::wstring& appendToStr,
-                                         const std::deque<std::wstring>& tokens)
+std::wstring_view Alias::s_GetArgString(const std::wstring_view str) noexcept
 {
-    if (ch >= L'1' && ch <= L'9')
+    const auto firstSpace = str.find_first_of(L' ');
+    if (std::wstring_view::npos != firstSpace)
     {
-        // Numerical macros substitute that numbered argument
-        const size_t index = ch - L'0';
-
-        if (index < tokens.size() && index > 0)
-        {
-            appendToStr.append(tokens[index]);
-        }
-
-        return true;
+        return str.substr(firstSpace + 1);
     }
 
-    return false;
-}
-
-// Routine Description:
-// - Checks the given character to see if it is a wildcard arg replacement macro
-//   and replaces it with the entire argument string if there is a match
-// Arguments:
-// - ch - Character to test as a macro
-// - appendToStr - Append the macro result here if it matched
-// - fullArgString - All of the arguments as one big string.
-// Return Value:
-// - True if we found the macro and appended to the string.
-// - False if the given character doesn't match this macro.
-bool Alias::s_TryReplaceWildcardArgMacro(const wchar_t ch,
-                                         std::wstring& appendToStr,
-                                         const std::wstring fullArgString)
-{
-    if (L'*' == ch)
-    {
-        // Wildcard substitutes all arguments
-        appendToStr.append(fullArgString);
-        return true;
-    }
-
-    return false;
+    return {};
 }
 
 // Routine Description:
@@ -1068,83 +1006,172 @@ void Alias::s_AppendCrLf(std::wstring& appendToStr,
 }
 
 // Routine Description:
-// - Searches through the given string for macros and replaces them
-//   with the matching action
+// - Compiles an alias target. The target text may contain substitution
+//   macros indicated by $. Those that only depend on the arguments become
+//   argument pieces; the rest are replaced with what they stand for now.
 // Arguments:
-// - str - On input, the string to search. On output, the string is replaced.
-// - tokens - The tokenized command line input. 0 is the alias, 1-N are arguments.
-// - fullArgString - Shorthand to 1-N argument string in case of wildcard match.
-// Return Value:
-// - The number of commands in the final string (line feeds, CRLFs)
-size_t Alias::s_ReplaceMacros(std::wstring& str,
-                              const std::deque<std::wstring>& tokens,
-                              const std::wstring& fullArgString)
+// - target - The destination/expansion text the alias was registered with
+Alias::Template::Template(const std::wstring_view target) :
+    _target{ target },
+    _lineCount{ 0 }
 {
-    size_t lineCount = 0;
-    std::wstring finalText;
+    _literals.reserve(target.size() + 2);
+
+    size_t literalStart = 0;
+    const auto endLiteral = [&](const size_t argument) {
+        _pieces.push_back({ _literals.size() - literalStart, argument });
+        literalStart = _literals.size();
+    };
 
-    // The target text may contain substitution macros indicated by $.
-    // Walk through and substitute them as appropriate.
-    for (auto ch = str.cbegin(); ch < str.cend(); ch++)
+    for (auto ch = target.cbegin(); ch < target.cend(); ch++)
     {
-        if (L'$' == *ch)
+        if (L'$' != *ch)
         {
-            // Attempt to read ahead by one character.
-            const auto chNext = ch + 1;
+            // If it didn't match the macro specifier $, push the character.
+            _literals.push_back(*ch);
+            continue;
+        }
 
-            if (chNext < str.cend())
-            {
-                auto isProcessed = s_TryReplaceNumberedArgMacro(*chNext, finalText, tokens);
-                if (!isProcessed)
-                {
-                    isProcessed = s_TryReplaceWildcardArgMacro(*chNext, finalText, fullArgString);
-                }
-                if (!isProcessed)
-                {
-                    isProcessed = s_TryReplaceInputRedirMacro(*chNext, finalText);
-                }
-                if (!isProcessed)
-                {
-                    isProcessed = s_TryReplaceOutputRedirMacro(*chNext, finalText);
-                }
-                if (!isProcessed)
-                {
-                    isProcessed = s_TryReplacePipeRedirMacro(*chNext, finalText);
-                }
-                if (!isProcessed)
-                {
-                    isProcessed = s_TryReplaceNextCommandMacro(*chNext, finalText, lineCount);
-                }
-                if (!isProcessed)
-                {
-                    // If nothing matches, just push these two characters in.
-                    finalText.push_back(*ch);
-                    finalText.push_back(*chNext);
-                }
+        // Attempt to read ahead by one character.
+        const auto chNext = ch + 1;
+        if (chNext == target.cend())
+        {
+            // If no read-ahead, just push this character and be done.
+            _literals.push_back(*ch);
+            continue;
+        }
 
-                // Since we read ahead and used that character,
-                // advance the iterator one extra to compensate.
-                ch++;
-            }
-            else
-            {
-                // If no read-ahead, just push this character and be done.
-                finalText.push_back(*ch);
-            }
+        if (*chNext >= L'1' && *chNext <= L'9')
+        {
+            // Numerical macros substitute that numbered argument
+            endLiteral(*chNext - L'0');
         }
-        else
+        else if (L'*' == *chNext)
         {
-            // If it didn't match the macro specifier $, push the character.
-            finalText.push_back(*ch);
+            // Wildcard substitutes all arguments
+            endLiteral(s_allArguments);
+        }
+        else if (!s_TryReplaceInputRedirMacro(*chNext, _literals) &&
+                 !s_TryReplaceOutputRedirMacro(*chNext, _literals) &&
+                 !s_TryReplacePipeRedirMacro(*chNext, _literals) &&
+                 !s_TryReplaceNextCommandMacro(*chNext, _literals, _lineCount))
+        {
+            // If nothing matches, just push these two characters in.
+            _literals.push_back(*ch);
+            _literals.push_back(*chNext);
         }
+
+        // Since we read ahead and used that character,
+        // advance the iterator one extra to compensate.
+        ch++;
     }
 
     // We always terminate with a CRLF to symbolize end of command.
-    s_AppendCrLf(finalText, lineCount);
+    s_AppendCrLf(_literals, _lineCount);
+    endLiteral(s_noArgument);
+}
+
+// Routine Description:
+// - Gets the target text as it was registered.
+const std::wstring& Alias::Template::GetTarget() const noexcept
+{
+    return _target;
+}
+
+// Routine Description:
+// - Gets the number of commands (CRLFs) every expansion of this alias contains.
+size_t Alias::Template::GetLineCount() const noexcept
+{
+    return _lineCount;
+}
+
+// Routine Description:
+// - Measures how many characters expanding this alias with the given arguments will take.
+// Arguments:
+// - tokens - The tokenized command line input. 0 is the alias, 1-9 are arguments.
+// - allArguments - Shorthand to 1-N argument string in case of wildcard match.
+// Return Value:
+// - Length in characters of the expansion.
+size_t Alias::Template::GetExpandedSize(const Tokens& tokens, const std::wstring_view allArguments) const noexcept
+{
+    auto size = _literals.size();
+    for (const auto& piece : _pieces)
+    {
+        size += _Argument(piece.argument, tokens, allArguments).size();
+    }
+    return size;
+}
+
+// Routine Description:
+// - Writes this alias out with the given arguments substituted in.
+// Arguments:
+// - tokens - The tokenized command line input. 0 is the alias, 1-9 are arguments.
+// - allArguments - Shorthand to 1-N argument string in case of wildcard match.
+// - out - Where to write the expansion. Must have room for GetExpandedSize() characters
+//         and must not overlap the arguments.
+// Return Value:
+// - The position just past the last character written.
+wchar_t* Alias::Template::Expand(const Tokens& tokens, const std::wstring_view allArguments, wchar_t* const out) const noexcept
+{
+    auto literal = _literals.cbegin();
+    auto next = out;
+    for (const auto& piece : _pieces)
+    {
+        next = std::copy_n(literal, piece.literalLength, next);
+        literal += piece.literalLength;
+
+        const auto argument = _Argument(piece.argument, tokens, allArguments);
+        next = std::copy(argument.cbegin(), argument.cend(), next);
+    }
+    return next;
+}
+
+std::wstring_view Alias::Template::_Argument(const size_t argument, const Tokens& tokens, const std::wstring_view allArguments) const noexcept
+{
+    if (argument == s_allArguments)
+    {
+        return allArguments;
+    }
+    return argument == s_noArgument ? std::wstring_view{} : tokens[argument];
+}
 
-    // Give back the final text and count.
-    str.swap(finalText);
-    return lineCount;
+// Routine Description:
+// - Finds the alias the source text starts with in exe name's list.
+// Arguments:
+// - sourceText - The trimmed line to search for an alias
+// - exeName - The name of the EXE that has aliases associated
+// - tokens - Receives the alias name and arguments, as views into sourceText
+// - allArguments - Receives everything after the alias name, as a view into sourceText
+// Return Value:
+// - The alias to expand, or nullptr if there isn't one.
+const Alias::Template* Alias::s_Find(const std::wstring_view sourceText,
+                                     const std::wstring_view exeName,
+                                     Tokens& tokens,
+                                     std::wstring_view& allArguments)
+{
+    // Check if we have an EXE in the list that matches the request first.
+    std::wstring exeNameString(exeName);
+    FoldCase(exeNameString);
+    const auto exeIter = g_aliasData.find(exeNameString);
+    if (exeIter == g_aliasData.end() || exeIter->second.empty())
+    {
+        return nullptr;
+    }
+
+    // Tokenize the text by spaces. The first token is the alias name.
+    s_Tokenize(sourceText, tokens);
+
+    std::wstring alias(tokens.front());
+    FoldCase(alias);
+    const auto aliasIter = exeIter->second.find(alias);
+    if (aliasIter == exeIter->second.end())
+    {
+        return nullptr;
+    }
+
+    // Get the string of all parameters as a shorthand for $* later.
+    allArguments = s_GetArgString(sourceText);
+    return &aliasIter->second;
 }
 
 // Routine Description:
@@ -1170,51 +1197,18 @@ std::wstring Alias::s_MatchAndCopyAlias(const std::wstring& sourceText,
     // Trim leading spaces off of sourceCopy if it has any.
     s_TrimLeadingSpaces(sourceCopy);
 
-    // Check if we have an EXE in the list that matches the request first.
-    auto exeIter = g_aliasData.find(exeName);
-    if (exeIter == g_aliasData.end())
+    Tokens tokens;
+    std::wstring_view allArguments;
+    const auto alias = s_Find(sourceCopy, exeName, tokens, allArguments);
+    if (!alias)
     {
-        // We found no data for this exe. Give back an empty string.
         return std::wstring();
     }
 
-    auto exeList = exeIter->second;
-    if (exeList.size() == 0)
-    {
-        // If there's no match, give back an empty string.
-        return std::wstring();
-    }
-
-    // Tokenize the text by spaces
-    const auto tokens = s_Tokenize(sourceCopy);
-
-    // If there are no tokens, return an empty string
-    if (tokens.size() == 0)
-    {
-        return std::wstring();
-    }
-
-    // Find alias. If there isn't one, return an empty string
-    const auto alias = tokens.front();
-    const auto aliasIter = exeList.find(alias);
-    if (aliasIter == exeList.end())
-    {
-        // We found no alias pair with this name. Give back an empty string.
-        return std::wstring();
-    }
-
-    const auto target = aliasIter->second;
-    if (target.size() == 0)
-    {
-        return std::wstring();
-    }
-
-    // Get the string of all parameters as a shorthand for $* later.
-    const auto allParams = s_GetArgString(sourceCopy);
-
     // The final text will be the target but with macros replaced.
-    std::wstring finalText(target);
-    lineCount = s_ReplaceMacros(finalText, tokens, allParams);
+    std::wstring finalText(alias->GetExpandedSize(tokens, allArguments), UNICODE_NULL);
+    alias->Expand(tokens, allArguments, finalText.data());
+    lineCount = alias->GetLineCount();
 
     return finalText;
 }
@@ -1242,27 +1236,30 @@ void Alias::s_MatchAndCopyAliasLegacy(_In_reads_bytes_(cbSource) PWCHAR pwchSour
 {
     try
     {
+        // The source and target are usually the same buffer, so the line is
+        // copied aside before the expansion can write over its arguments.
         std::wstring sourceText(pwchSource, cbSource / sizeof(WCHAR));
-        size_t lineCount = lines;
+        s_TrimTrailingCrLf(sourceText);
+        s_TrimLeadingSpaces(sourceText);
 
-        const auto targetText = s_MatchAndCopyAlias(sourceText, exeName, lineCount);
+        Tokens tokens;
+        std::wstring_view allArguments;
+        const auto alias = s_Find(sourceText, exeName, tokens, allArguments);
 
-        // Only return data if the reply was non-empty (we had a match).
-        if (!targetText.empty())
+        // Only return data if we had a match and it will fit in the result buffer.
+        if (alias)
         {
-            const auto cchTargetSize = cbTargetSize / sizeof(wchar_t);
-
-            // If the target text will fit in the result buffer, fill out the results.
-            if (targetText.size() <= cchTargetSize)
+            const auto cchTarget = alias->GetExpandedSize(tokens, allArguments);
+            if (cchTarget <= cbTargetSize / sizeof(wchar_t))
             {
-                // Non-null terminated copy into memory space
-                std::copy_n(targetText.data(), targetText.size(), pwchTarget);
+                // Non-null terminated expansion straight into memory space
+                alias->Expand(tokens, allArguments, pwchTarget);
 
                 // Return bytes copied.
-                cbTargetWritten = gsl::narrow<ULONG>(targetText.size() * sizeof(wchar_t));
+                cbTargetWritten = gsl::narrow<ULONG>(cchTarget * sizeof(wchar_t));
 
                 // Return lines info.
-                lines = gsl::narrow<DWORD>(lineCount);
+                lines = gsl::narrow<DWORD>(alias->GetLineCount());
             }
         }
     }
@@ -1277,7 +1274,11 @@ void Alias::s_TestAddAlias(std::wstring& exe,
                            std::wstring& alias,
                            std::wstring& target)
 {
-    g_aliasData[exe][alias] = target;
+    std::wstring exeFolded(exe);
+    std::wstring aliasFolded(alias);
+    FoldCase(exeFolded);
+    FoldCase(aliasFolded);
+    g_aliasData[exeFolded].insert_or_assign(aliasFolded, Template{ target });
 }
 
 void Alias::s_TestClearAliases()
@@ -8,15 +8,51 @@ Module Name:
 Abstract:
 - Encapsulates the cmdline functions and structures specifically related to
         command alias functionality.
+- Alias targets are compiled when they're registered, so expanding one for a
+  submitted line is a single copy of literal text and arguments straight into
+  the read buffer.
 --*/
 #pragma once
 
-
-
-
 class Alias
 {
 public:
+    // The alias name as typed, followed by its first nine arguments.
+    using Tokens = std::array<std::wstring_view, 10>;
+
+    // An alias target broken up into the text that's always emitted and the
+    // places where the typed arguments go. The redirection ($L $G $B) and
+    // command separator ($T) macros don't depend on the arguments, so they're
+    // folded into the literal text up front.
+    class Template final
+    {
+    public:
+        Template(const std::wstring_view target);
+
+        const std::wstring& GetTarget() const noexcept;
+        size_t GetLineCount() const noexcept;
+
+        size_t GetExpandedSize(const Tokens& tokens, const std::wstring_view allArguments) const noexcept;
+        wchar_t* Expand(const Tokens& tokens, const std::wstring_view allArguments, wchar_t* const out) const noexcept;
+
+    private:
+        static constexpr size_t s_noArgument = 0;
+        static constexpr size_t s_allArguments = 10;
+
+        struct _Piece
+        {
+            size_t literalLength; // characters of _literals before the argument
+            size_t argument; // 1-9 for a numbered argument, or one of the constants above
+        };
+
+        std::wstring _target;
+        std::wstring _literals;
+        std::vector<_Piece> _pieces;
+        size_t _lineCount;
+
+        std::wstring_view _Argument(const size_t argument, const Tokens& tokens, const std::wstring_view allArguments) const noexcept;
+    };
+
     static void s_ClearCmdExeAliases();
 
     static void s_MatchAndCopyAliasLegacy(_In_reads_bytes_(cbSource) PWCHAR pwchSource,
@@ -35,18 +71,13 @@ public:
 private:
     static void s_TrimLeadingSpaces(std::wstring& str);
     static void s_TrimTrailingCrLf(std::wstring& str);
-    static std::deque<std::wstring> s_Tokenize(const std::wstring& str);
-    static std::wstring s_GetArgString(const std::wstring& str);
-    static size_t s_ReplaceMacros(std::wstring& str,
-                                  const std::deque<std::wstring>& tokens,
-                                  const std::wstring& fullArgString);
+    static size_t s_Tokenize(const std::wstring_view str, Tokens& tokens) noexcept;
+    static std::wstring_view s_GetArgString(const std::wstring_view str) noexcept;
 
-    static bool s_TryReplaceNumberedArgMacro(const wchar_t ch,
-                                             std::wstring& appendToStr,
-                                             const std::deque<std::wstring>& tokens);
-    static bool s_TryReplaceWildcardArgMacro(const wchar_t ch,
-                                             std::wstring& appendToStr,
-                                             const std::wstring fullArgString);
+    static const Template* s_Find(const std::wstring_view sourceText,
+                                  const std::wstring_view exeName,
+                                  Tokens& tokens,
+                                  std::wstring_view& allArguments);
 
     static bool s_TryReplaceInputRedirMacro(const wchar_t ch,
                                             std::wstring& appendToStr);
@@ -806,6 +806,43 @@ static std::vector<CHAR_INFO> _ConvertCellsToMungedW(gsl::span<CHAR_INFO> buffer
     return result;
 }
 
+// Routine Description:
+// - Reads part of a row as legacy cells. Colors are converted once for each
+//   run of them instead of once per cell.
+// Arguments:
+// - gci - The console, to map colors to the legacy color table
+// - row - The row to read
+// - column - The first column to read
+// - target - Receives one cell per column, starting at column
+static void _ReadRowAsCharInfos(const CONSOLE_INFORMATION& gci,
+                                const ROW& row,
+                                const size_t column,
+                                const gsl::span<CHAR_INFO> target)
+{
+    const auto& charRow = row.GetCharRow();
+    const auto& attrRow = row.GetAttrRow();
+
+    auto targetIter = target.begin();
+    auto currentColumn = column;
+    while (targetIter < target.end())
+    {
+        size_t applies = 0;
+        const auto legacyAttr = gci.GenerateLegacyAttributes(attrRow.GetAttrByColumn(currentColumn, &applies));
+        const auto runEnd = currentColumn + std::min<size_t>(applies, target.end() - targetIter);
+
+        for (; currentColumn < runEnd; ++currentColumn, ++targetIter)
+        {
+            const auto& dbcsAttr = charRow.DbcsAttrAt(currentColumn);
+
+            // Only glyphs that don't fit in a single wchar_t are kept aside and need looking up.
+            targetIter->Char.UnicodeChar = dbcsAttr.IsGlyphStored() ?
+                                               Utf16ToUcs2(charRow.GlyphAt(currentColumn)) :
+                                               (charRow.cbegin() + currentColumn)->Char();
+            targetIter->Attributes = legacyAttr | dbcsAttr.GeneratePublicApiAttributeFormat();
+        }
+    }
+}
+
 [[nodiscard]]
 static HRESULT _ReadConsoleOutputWImplHelper(const SCREEN_INFORMATION& context,
                                              gsl::span<CHAR_INFO> targetBuffer,
@@ -854,40 +891,25 @@ static HRESULT _ReadConsoleOutputWImplHelper(const SCREEN_INFORMATION& context,
         // We will start reading the buffer at the point of the top left corner (origin) of the (potentially adjusted) request
         const auto sourcePoint = clippedRequestRectangle.Origin();
 
-        // Get an iterator to the beginning of the return buffer
-        // We might have to seek this forward or skip around if we clipped the request.
-        auto targetIter = targetBuffer.begin();
-        COORD targetPos = { 0 };
-        const auto targetLimit = Viewport::FromDimensions(targetPoint, clippedRequestRectangle.Dimensions());
-
-        // Get an iterator to the beginning of the request inside the screen buffer
-        // This should walk exactly along every cell of the clipped request.
-        auto sourceIter = storageBuffer.GetCellDataAt(sourcePoint, clippedRequestRectangle);
-
-        // Walk through every cell of the target, advancing the buffer.
-        // Validate that we always still have a valid iterator to the backgin store,
-        // that we always are writing inside the user's buffer (before the end)
-        // and we're always targeting the user's buffer inside its original bounds.
-        while (sourceIter && targetIter < targetBuffer.end())
+        // Copy each row of the request straight out of the screen buffer into its place in the
+        // user's buffer. Cells of the user's buffer outside the clipped request are left alone.
+        if (clip.Left < clip.Right && clip.Top < clip.Bottom)
         {
-            // If the point we're trying to write is inside the limited buffer write zone...
-            if (targetLimit.IsInBounds(targetPos))
+            const auto& textBuffer = storageBuffer.GetTextBuffer();
+            const ptrdiff_t sourceWidth = clip.Right - clip.Left;
+
+            for (auto sourceY = sourcePoint.Y; sourceY < clip.Bottom; sourceY++)
             {
-                // Copy the data into position...
-                *targetIter = gci.AsCharInfo(*sourceIter);
-                // ... and advance the read iterator.
-                sourceIter++;
-            }
+                // The user's buffer may stop short of the end of the request.
+                const ptrdiff_t targetOffset = (targetPoint.Y + sourceY - sourcePoint.Y) * targetSize.X + targetPoint.X;
+                if (targetOffset >= targetBuffer.size())
+                {
+                    break;
+                }
 
-            // Always advance the write iterator, we might have skipped it due to clipping.
-            targetIter++;
+                const auto targetRow = targetBuffer.subspan(targetOffset, std::min<ptrdiff_t>(sourceWidth, targetBuffer.size() - targetOffset));
 
-            // Increment the target
-            targetPos.X++;
-            if (targetPos.X >= targetSize.X)
-            {
-                targetPos.X = 0;
-                targetPos.Y++;
+                _ReadRowAsCharInfos(gci, textBuffer.GetRowByOffset(sourceY), sourcePoint.X, targetRow);
             }
         }
 
@@ -956,6 +978,7 @@ static HRESULT _WriteConsoleOutputWImplHelper(SCREEN_INFORMATION& context,
     try
     {
         auto& storageBuffer = context.GetActiveBuffer();
+        auto& textBuffer = storageBuffer.GetTextBuffer();
         const auto storageRectangle = storageBuffer.GetBufferSize();
         const auto storageSize = storageRectangle.Dimensions();
 
@@ -1038,12 +1061,19 @@ static HRESULT _WriteConsoleOutputWImplHelper(SCREEN_INFORMATION& context,
             // Now we make a subspan starting from that offset for as much of the original request as would fit
             const auto subspan = buffer.subspan(totalOffset, writeRectangle.Width());
 
-            // Convert to a CHAR_INFO view to fit into the iterator
+            // Convert to a CHAR_INFO view to hand to the row
             const auto charInfos = std::basic_string_view<CHAR_INFO>(subspan.data(), subspan.size());
 
-            // Make the iterator and write to the target position.
-            OutputCellIterator it(charInfos);
-            storageBuffer.Write(it, target);
+            // Write straight into the row at the target position.
+            const auto consumed = textBuffer.WriteCharInfoLine(charInfos, target, true);
+
+            // A leading byte in the last column of the buffer gets padded out and is left over,
+            // and writes have always carried what's left over onto the start of the next row.
+            if (consumed < charInfos.size())
+            {
+                OutputCellIterator it(charInfos.substr(consumed));
+                storageBuffer.Write(it, { 0, target.Y + 1 });
+            }
         }
 
         // Since we've managed to write part of the request, return the clamped part that we actually used.
@@ -889,88 +889,48 @@ HRESULT ApiRoutines::SetConsoleTextAttributeImpl(SCREEN_INFORMATION& context,
     CATCH_RETURN();
 }
 
-void DoSrvPrivateSetLegacyAttributes(SCREEN_INFORMATION& screenInfo,
-                                     const WORD Attribute,
-                                     const bool fForeground,
-                                     const bool fBackground,
-                                     const bool fMeta)
-{
-    auto& buffer = screenInfo.GetActiveBuffer();
-    const TextAttribute OldAttributes = buffer.GetAttributes();
-    TextAttribute NewAttributes = OldAttributes;
-
-    NewAttributes.SetLegacyAttributes(Attribute, fForeground, fBackground, fMeta);
-
-    buffer.SetAttributes(NewAttributes);
-}
-
-void DoSrvPrivateSetDefaultAttributes(SCREEN_INFORMATION& screenInfo,
-                                      const bool fForeground,
-                                      const bool fBackground)
+// Routine Description:
+// - A private API call to get the full current attributes of the screen buffer,
+//   including any RGB colors that a legacy attribute word can't express.
+// Parameters:
+// - screenInfo - The screen buffer to retrieve the attributes from
+// - attributes - Receives the current attributes
+// Return Value:
+// - <none>
+void DoSrvPrivateGetTextAttributes(const SCREEN_INFORMATION& screenInfo, TextAttribute& attributes)
 {
-    auto& buffer = screenInfo.GetActiveBuffer();
-    TextAttribute NewAttributes = buffer.GetAttributes();
-    if (fForeground)
-    {
-        NewAttributes.SetDefaultForeground();
-    }
-    if (fBackground)
-    {
-        NewAttributes.SetDefaultBackground();
-    }
-    buffer.SetAttributes(NewAttributes);
+    attributes = screenInfo.GetActiveBuffer().GetAttributes();
 }
 
-void DoSrvPrivateSetConsoleXtermTextAttribute(SCREEN_INFORMATION& screenInfo,
-                                              const int iXtermTableEntry,
-                                              const bool fIsForeground)
+// Routine Description:
+// - A private API call to replace the current attributes of the screen buffer
+//   in one go. The VT adapter folds a whole SGR sequence into an attribute and
+//   commits it with this.
+// - The buffer only holds indices into the 16 color table, so colors set to an
+//   entry of the 256 color xterm table past that are resolved to RGB here.
+// Parameters:
+// - screenInfo - The screen buffer to set the attributes of
+// - attributes - The new attributes
+// Return Value:
+// - <none>
+void DoSrvPrivateSetTextAttributes(SCREEN_INFORMATION& screenInfo, const TextAttribute& attributes)
 {
     const CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
-    auto& buffer = screenInfo.GetActiveBuffer();
-    TextAttribute NewAttributes = buffer.GetAttributes();
-
-    COLORREF rgbColor;
-    if (iXtermTableEntry < COLOR_TABLE_SIZE)
-    {
-        //Convert the xterm index to the win index
-        WORD iWinEntry = ::XtermToWindowsIndex(iXtermTableEntry);
+    TextAttribute NewAttributes = attributes;
 
-        rgbColor = gci.GetColorTableEntry(iWinEntry);
-    }
-    else
+    const TextColor foreground = attributes.GetForeground();
+    if (foreground.IsLegacy() && foreground.GetIndex() >= COLOR_TABLE_SIZE)
     {
-        rgbColor = gci.GetColorTableEntry(iXtermTableEntry);
+        NewAttributes.SetForeground(gci.GetColorTableEntry(foreground.GetIndex()));
     }
 
-    NewAttributes.SetColor(rgbColor, fIsForeground);
-
-    buffer.SetAttributes(NewAttributes);
-}
-
-void DoSrvPrivateSetConsoleRGBTextAttribute(SCREEN_INFORMATION& screenInfo,
-                                            const COLORREF rgbColor,
-                                            const bool fIsForeground)
-{
-    auto& buffer = screenInfo.GetActiveBuffer();
-
-    TextAttribute NewAttributes = buffer.GetAttributes();
-    NewAttributes.SetColor(rgbColor, fIsForeground);
-    buffer.SetAttributes(NewAttributes);
-}
-
-void DoSrvPrivateBoldText(SCREEN_INFORMATION& screenInfo, const bool bolded)
-{
-    auto& buffer = screenInfo.GetActiveBuffer();
-    auto attrs = buffer.GetAttributes();
-    if (bolded)
-    {
-        attrs.Embolden();
-    }
-    else
+    const TextColor background = attributes.GetBackground();
+    if (background.IsLegacy() && background.GetIndex() >= COLOR_TABLE_SIZE)
     {
-        attrs.Debolden();
+        NewAttributes.SetBackground(gci.GetColorTableEntry(background.GetIndex()));
     }
-    buffer.SetAttributes(attrs);
+
+    screenInfo.GetActiveBuffer().SetAttributes(NewAttributes);
 }
 
 // Routine Description:
@@ -1638,6 +1598,24 @@ void DoSrvPrivateEnableAlternateScroll(const bool fEnable)
     gci.terminalMouseInput.EnableAlternateScroll(fEnable);
 }
 
+// Routine Description:
+// - A private API call for enabling bracketed paste mode
+// Parameters:
+// - fEnable - true to surround pasted text with ESC[200~/ESC[201~, false to disable.
+// Return value:
+// - True if handled successfully. False otherwise.
+[[nodiscard]]
+NTSTATUS DoSrvPrivateEnableBracketedPasteMode(const bool fEnable)
+{
+    CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    if (gci.pInputBuffer == nullptr)
+    {
+        return STATUS_UNSUCCESSFUL;
+    }
+    gci.pInputBuffer->GetTerminalInput().ChangeBracketedPasteMode(fEnable);
+    return STATUS_SUCCESS;
+}
+
 // Routine Description:
 // - A private API call for performing a VT-style erase all operation on the buffer.
 //      See SCREEN_INFORMATION::VtEraseAll's description for details.
@@ -1663,34 +1641,6 @@ void DoSrvSetCursorColor(SCREEN_INFORMATION& screenInfo,
     screenInfo.GetActiveBuffer().GetTextBuffer().GetCursor().SetColor(cursorColor);
 }
 
-// Routine Description:
-// - A private API call to get only the default color attributes of the screen buffer.
-// - This is used as a performance optimization by the VT adapter in SGR (Set Graphics Rendition) instead
-//   of calling for this information through the public API GetConsoleScreenBufferInfoEx which returns a lot
-//   of extra unnecessary data and takes a lot of extra processing time.
-// Parameters
-// - screenInfo - The screen buffer to retrieve default color attributes information from
-// - pwAttributes - Pointer to space that will receive color attributes data
-// Return Value:
-// - STATUS_SUCCESS if we succeeded or STATUS_INVALID_PARAMETER for bad params (nullptr).
-[[nodiscard]]
-NTSTATUS DoSrvPrivateGetConsoleScreenBufferAttributes(_In_ const SCREEN_INFORMATION& screenInfo, _Out_ WORD* const pwAttributes)
-{
-    NTSTATUS Status = STATUS_SUCCESS;
-
-    if (pwAttributes == nullptr)
-    {
-        Status = STATUS_INVALID_PARAMETER;
-    }
-
-    if (NT_SUCCESS(Status))
-    {
-        *pwAttributes = screenInfo.GetActiveBuffer().GetAttributes().GetLegacyAttributes();
-    }
-
-    return Status;
-}
-
 // Routine Description:
 // - A private API call for forcing the renderer to repaint the screen. If the
 //      input screen buffer is not the active one, then just do nothing. We only
@@ -17,15 +17,10 @@ Revision History:
 #pragma once
 #include "../inc/conattrs.hpp"
 class SCREEN_INFORMATION;
+class TextAttribute;
 
-
-void DoSrvPrivateSetLegacyAttributes(SCREEN_INFORMATION& screenInfo,
-                                     const WORD Attribute,
-                                     const bool fForeground,
-                                     const bool fBackground,
-                                     const bool fMeta);
-
-void DoSrvPrivateSetDefaultAttributes(SCREEN_INFORMATION& screenInfo, const bool fForeground, const bool fBackground);
+void DoSrvPrivateGetTextAttributes(const SCREEN_INFORMATION& screenInfo, TextAttribute& attributes);
+void DoSrvPrivateSetTextAttributes(SCREEN_INFORMATION& screenInfo, const TextAttribute& attributes);
 
 [[nodiscard]]
 NTSTATUS DoSrvPrivateSetCursorKeysMode(_In_ bool fApplicationMode);
@@ -60,15 +55,8 @@ void DoSrvPrivateEnableSGRExtendedMouseMode(const bool fEnable);
 void DoSrvPrivateEnableButtonEventMouseMode(const bool fEnable);
 void DoSrvPrivateEnableAnyEventMouseMode(const bool fEnable);
 void DoSrvPrivateEnableAlternateScroll(const bool fEnable);
-
-void DoSrvPrivateSetConsoleXtermTextAttribute(SCREEN_INFORMATION& screenInfo,
-                                              const int iXtermTableEntry,
-                                              const bool fIsForeground);
-void DoSrvPrivateSetConsoleRGBTextAttribute(SCREEN_INFORMATION& screenInfo,
-                                            const COLORREF rgbColor,
-                                            const bool fIsForeground);
-
-void DoSrvPrivateBoldText(SCREEN_INFORMATION& screenInfo, const bool bolded);
+[[nodiscard]]
+NTSTATUS DoSrvPrivateEnableBracketedPasteMode(const bool fEnable);
 
 [[nodiscard]]
 NTSTATUS DoSrvPrivateEraseAll(SCREEN_INFORMATION& screenInfo);
@@ -78,10 +66,6 @@ void DoSrvSetCursorStyle(SCREEN_INFORMATION& screenInfo,
 void DoSrvSetCursorColor(SCREEN_INFORMATION& screenInfo,
                          const COLORREF cursorColor);
 
-[[nodiscard]]
-NTSTATUS DoSrvPrivateGetConsoleScreenBufferAttributes(const SCREEN_INFORMATION& screenInfo,
-                                                      _Out_ WORD* const pwAttributes);
-
 void DoSrvPrivateRefreshWindow(const SCREEN_INFORMATION& screenInfo);
 
 void DoSrvGetConsoleOutputCodePage(_Out_ unsigned int* const pCodePage);
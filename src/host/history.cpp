@@ -88,6 +88,84 @@ void CommandHistory::_Reset()
     WI_SetFlag(Flags, CLE_RESET);
 }
 
+void CommandHistory::_Clear() noexcept
+{
+    _commands.clear();
+    _index.Clear();
+}
+
+CommandHistory::_Entry& CommandHistory::_EntryAt(const SHORT index)
+{
+    THROW_HR_IF(E_BOUNDS, index < 0 || gsl::narrow_cast<size_t>(index) >= _commands.size());
+    return _commands[index];
+}
+
+const CommandHistory::_Entry& CommandHistory::_EntryAt(const SHORT index) const
+{
+    THROW_HR_IF(E_BOUNDS, index < 0 || gsl::narrow_cast<size_t>(index) >= _commands.size());
+    return _commands[index];
+}
+
+const std::wstring& CommandHistory::_At(const SHORT index) const
+{
+    return _EntryAt(index).command;
+}
+
+// Routine Description:
+// - Finds the position of the command with the given id. Ids only ever grow
+//   from the oldest command to the newest, so this is a binary search.
+// Return Value:
+// - The position of the command, or -1 if there isn't one with that id.
+SHORT CommandHistory::_IndexOf(const uint64_t id) const noexcept
+{
+    size_t low = 0;
+    size_t high = _commands.size();
+    while (low < high)
+    {
+        const auto mid = low + (high - low) / 2;
+        if (_commands[mid].id < id)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    if (low < _commands.size() && _commands[low].id == id)
+    {
+        return gsl::narrow_cast<SHORT>(low);
+    }
+    return -1;
+}
+
+void CommandHistory::_PushBack(std::wstring command)
+{
+    const auto id = _nextId++;
+    _index.Insert(command, id);
+    _commands.push_back({ std::move(command), id });
+}
+
+void CommandHistory::_PopFront()
+{
+    _index.Erase(_commands.front().command, _commands.front().id);
+    _commands.pop_front();
+}
+
+void CommandHistory::_PopBack()
+{
+    _index.Erase(_commands.back().command, _commands.back().id);
+    _commands.pop_back();
+}
+
+void CommandHistory::_Erase(const SHORT index)
+{
+    const auto& entry = _commands[index];
+    _index.Erase(entry.command, entry.id);
+    _commands.erase(index);
+}
+
 [[nodiscard]]
 HRESULT CommandHistory::Add(const std::wstring_view newCommand,
                             const bool suppressDuplicates)
@@ -102,10 +180,7 @@ HRESULT CommandHistory::Add(const std::wstring_view newCommand,
 
     try
     {
-        if (_commands.size() == 0 ||
-            _commands.back().size() != newCommand.size() ||
-            !std::equal(_commands.back().cbegin(), _commands.back().cbegin() + newCommand.size(),
-                        newCommand.cbegin(), newCommand.cend()))
+        if (_commands.size() == 0 || _commands.back().command != newCommand)
         {
             std::wstring reuse{};
 
@@ -121,7 +196,7 @@ HRESULT CommandHistory::Add(const std::wstring_view newCommand,
             // find free record.  if all records are used, free the lru one.
             if ((SHORT)_commands.size() == _maxCommands)
             {
-                _commands.erase(_commands.cbegin());
+                _PopFront();
                 // move LastDisplayed back one in order to stay synced with the
                 // command it referred to before erasing the lru one
                 --LastDisplayed;
@@ -130,20 +205,27 @@ HRESULT CommandHistory::Add(const std::wstring_view newCommand,
             // add newCommand to array
             if (!reuse.empty())
             {
-                _commands.emplace_back(reuse);
+                _PushBack(std::move(reuse));
             }
             else
             {
-                _commands.emplace_back(newCommand);
+                _PushBack(std::wstring{ newCommand });
             }
 
-            if (LastDisplayed == -1 ||
-                _commands.at(LastDisplayed).size() != newCommand.size() ||
-                !std::equal(_commands.at(LastDisplayed).cbegin(), _commands.at(LastDisplayed).cbegin() + newCommand.size(),
-                            newCommand.cbegin(), newCommand.cend()))
+            if (LastDisplayed == -1 || _At(LastDisplayed) != newCommand)
             {
                 _Reset();
             }
+
+            if (_file)
+            {
+                // Losing the on-disk copy isn't worth failing the command over.
+                try
+                {
+                    _file->Append(newCommand);
+                }
+                CATCH_LOG();
+            }
         }
     }
     CATCH_RETURN();
@@ -156,7 +238,7 @@ std::wstring_view CommandHistory::GetNth(const SHORT index) const
 {
     try
     {
-        return _commands.at(index);
+        return _At(index);
     }
     CATCH_LOG();
 
@@ -172,7 +254,7 @@ HRESULT CommandHistory::RetrieveNth(const SHORT index,
 
     try
     {
-        const auto& cmd = _commands.at(index);
+        const auto& cmd = _At(index);
         if (cmd.size() > (size_t)buffer.size())
         {
             commandSize = buffer.size(); // room for CRLF?
@@ -235,7 +317,7 @@ std::wstring_view CommandHistory::GetLastCommand() const
     {
         try
         {
-            return _commands.at(LastDisplayed);
+            return _At(LastDisplayed);
         }
         CATCH_LOG();
     }
@@ -245,9 +327,18 @@ std::wstring_view CommandHistory::GetLastCommand() const
 
 void CommandHistory::Empty()
 {
-    _commands.clear();
+    _Clear();
     LastDisplayed = -1;
     Flags = CLE_RESET;
+
+    if (_file)
+    {
+        try
+        {
+            _file->Clear();
+        }
+        CATCH_LOG();
+    }
 }
 
 bool CommandHistory::AtFirstCommand() const
@@ -279,13 +370,10 @@ void CommandHistory::Realloc(const size_t commands)
         return;
     }
 
-    const auto oldCommands = _commands;
-    const auto newNumberOfCommands = gsl::narrow<SHORT>(std::min(_commands.size(), commands));
-
-    _commands.clear();
-    for (SHORT i = 0; i < newNumberOfCommands; i++)
+    // The oldest commands are the ones kept.
+    while (_commands.size() > commands)
     {
-        _commands.emplace_back(oldCommands[i]);
+        _PopBack();
     }
 
     WI_SetFlag(Flags, CLE_RESET);
@@ -389,9 +477,11 @@ CommandHistory* CommandHistory::s_Allocate(const std::wstring_view appName, cons
     {
         if (!SameApp)
         {
-            BestCandidate->_commands.clear();
+            BestCandidate->_Clear();
             BestCandidate->LastDisplayed = -1;
             BestCandidate->_appName = appName;
+            BestCandidate->_file.reset();
+            BestCandidate->_persistedLoaded = false;
         }
 
         BestCandidate->_processHandle = processHandle;
@@ -468,11 +558,11 @@ std::wstring CommandHistory::Remove(const SHORT iDel)
 
     try
     {
-        const auto str = _commands.at(iDel);
+        auto str = _At(iDel);
 
         if (iDel < iLast)
         {
-            _commands.erase(_commands.cbegin() + iDel);
+            _Erase(iDel);
             if ((iDisp > iDel) && (iDisp <= iLast))
             {
                 _Dec(iDisp);
@@ -481,7 +571,7 @@ std::wstring CommandHistory::Remove(const SHORT iDel)
         }
         else if (iFirst <= iDel)
         {
-            _commands.erase(_commands.cbegin() + iDel);
+            _Erase(iDel);
             if ((iDisp >= iFirst) && (iDisp < iDel))
             {
                 _Inc(iDisp);
@@ -490,6 +580,17 @@ std::wstring CommandHistory::Remove(const SHORT iDel)
         }
 
         LastDisplayed = iDisp;
+
+        if (_file)
+        {
+            // Losing the on-disk copy isn't worth failing the command over.
+            try
+            {
+                _file->Remove(str);
+            }
+            CATCH_LOG();
+        }
+
         return str;
     }
     CATCH_LOG();
@@ -500,6 +601,7 @@ std::wstring CommandHistory::Remove(const SHORT iDel)
 
 // Routine Description:
 // - this routine finds the most recent command that starts with the letters already in the current command.  it returns the array index (no mod needed).
+// - the search walks backwards from the starting index, wrapping around to the newest command, but is answered by the prefix index rather than by comparing every command on the way.
 [[nodiscard]]
 bool CommandHistory::FindMatchingCommand(const std::wstring_view givenCommand,
                                          const SHORT startingIndex,
@@ -529,20 +631,26 @@ bool CommandHistory::FindMatchingCommand(const std::wstring_view givenCommand,
 
     try
     {
-        for (size_t i = 0; i < _commands.size(); i++)
-        {
-            const auto& storedCommand = _commands.at(indexFound);
-            if ((WI_IsFlagClear(options, MatchOptions::ExactMatch) && (givenCommand.size() <= storedCommand.size())) || (givenCommand.size() == storedCommand.size()))
+        // The index narrows the search down to the commands sharing a prefix
+        // with the given one. Each candidate is still compared in full since
+        // the index only looks at the first few characters.
+        const auto exactMatch = WI_IsFlagSet(options, MatchOptions::ExactMatch);
+        const auto isMatch = [&](const uint64_t id) {
+            const auto& storedCommand = _commands[_IndexOf(id)].command;
+            if ((!exactMatch && (givenCommand.size() <= storedCommand.size())) || (givenCommand.size() == storedCommand.size()))
             {
-                if (std::equal(storedCommand.begin(), storedCommand.begin() + givenCommand.size(),
-                               givenCommand.begin(), givenCommand.end(),
-                               CaseInsensitiveEquality))
-                {
-                    return true;
-                }
+                return std::equal(storedCommand.begin(), storedCommand.begin() + givenCommand.size(),
+                                  givenCommand.begin(), givenCommand.end(),
+                                  CaseInsensitiveEquality);
             }
+            return false;
+        };
 
-            _Prev(indexFound);
+        const auto found = _index.FindLast(givenCommand, _EntryAt(indexFound).id, isMatch);
+        if (found.has_value())
+        {
+            indexFound = _IndexOf(found.value());
+            return true;
         }
     }
     CATCH_LOG();
@@ -564,7 +672,70 @@ void CommandHistory::s_ClearHistoryListStorage()
 // - indexB - index of one history item to swap
 void CommandHistory::Swap(const short indexA, const short indexB)
 {
-    std::swap(_commands.at(indexA), _commands.at(indexB));
+    auto& a = _EntryAt(indexA);
+    auto& b = _EntryAt(indexB);
+    if (indexA == indexB)
+    {
+        return;
+    }
+
+    // The ids stay where they are so they keep ascending; only the text moves.
+    _index.Erase(a.command, a.id);
+    _index.Erase(b.command, b.id);
+    std::swap(a.command, b.command);
+    _index.Insert(a.command, a.id);
+    _index.Insert(b.command, b.id);
+
+    if (_file)
+    {
+        try
+        {
+            _file->Swap(a.command, b.command);
+        }
+        CATCH_LOG();
+    }
+}
+
+// Routine Description:
+// - Loads the commands saved by earlier sessions of the same application, if
+//   the user has asked for history to be kept. Only the first call does any
+//   work; it is made when the client first reads a line, so applications
+//   that never use the command line don't pay for opening the file.
+// - Saved commands go in front of anything already in the history.
+void CommandHistory::LoadPersistedCommands() noexcept
+{
+    if (_persistedLoaded)
+    {
+        return;
+    }
+    _persistedLoaded = true;
+
+    const CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    if (!gci.GetPersistHistory() || _maxCommands == 0)
+    {
+        return;
+    }
+
+    try
+    {
+        _file = CommandHistoryFile::s_Open(_appName);
+        auto commands = _file->Load(_maxCommands);
+
+        for (size_t i = 0; i < _commands.size(); ++i)
+        {
+            commands.emplace_back(std::move(_commands[i].command));
+        }
+        _Clear();
+
+        const auto skip = commands.size() > gsl::narrow_cast<size_t>(_maxCommands) ? commands.size() - _maxCommands : 0;
+        for (auto it = commands.begin() + skip; it != commands.end(); ++it)
+        {
+            _PushBack(std::move(*it));
+        }
+
+        _Reset();
+    }
+    CATCH_LOG();
 }
 
 // Routine Description:
@@ -8,10 +8,17 @@ Module Name:
 Abstract:
 - Encapsulates the cmdline functions and structures specifically related to
         command history functionality.
+- Commands are kept oldest first in a ring, so the least recently used one
+  can be dropped without moving the others, and are indexed by prefix for
+  F8-style searches.
 --*/
 
 #pragma once
 
+#include "ringBuffer.hpp"
+#include "historyIndex.hpp"
+#include "historyFile.hpp"
+
 // CommandHistory Flags
 #define CLE_ALLOCATED 0x00000001
 #define CLE_RESET     0x00000002
@@ -75,8 +82,26 @@ public:
 
     void Swap(const short indexA, const short indexB);
 
+    void LoadPersistedCommands() noexcept;
+
 private:
+    struct _Entry
+    {
+        std::wstring command;
+        uint64_t id = 0; // ascending from oldest to newest
+    };
+
     void _Reset();
+    void _Clear() noexcept;
+
+    _Entry& _EntryAt(const SHORT index);
+    const _Entry& _EntryAt(const SHORT index) const;
+    const std::wstring& _At(const SHORT index) const;
+    SHORT _IndexOf(const uint64_t id) const noexcept;
+    void _PushBack(std::wstring command);
+    void _PopFront();
+    void _PopBack();
+    void _Erase(const SHORT index);
 
     // _Next and _Prev go to the next and prev command
     // _Inc  and _Dec go to the next and prev slots
@@ -87,9 +112,15 @@ private:
     void _Inc(SHORT& ind) const;
 
 
-    std::vector<std::wstring> _commands;
+    RingBuffer<_Entry> _commands;
+    CommandHistoryIndex _index;
+    uint64_t _nextId = 0;
     SHORT _maxCommands;
 
+    // The on-disk history is only opened once the client first reads a line.
+    std::shared_ptr<CommandHistoryFile> _file;
+    bool _persistedLoaded = false;
+
     std::wstring _appName;
     HANDLE _processHandle;
 
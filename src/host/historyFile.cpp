@@ -0,0 +1,289 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "historyFile.hpp"
+
+#pragma hdrstop
+
+// Routine Description:
+// - Opens (creating if necessary) the history file shared by every console
+//   session of the given executable.
+// Arguments:
+// - appName - name of the client executable the history belongs to
+// Return Value:
+// - The opened file. Throws if it can't be opened or mapped.
+std::shared_ptr<CommandHistoryFile> CommandHistoryFile::s_Open(const std::wstring_view appName)
+{
+    // The name ends up in both a file name and a kernel object name.
+    THROW_HR_IF(E_INVALIDARG, appName.empty() || appName.find_first_of(L"\\/:*?\"<>|") != std::wstring_view::npos);
+
+    std::wstring name{ appName };
+    std::transform(name.begin(), name.end(), name.begin(), ::towlower);
+
+    static constexpr auto directoryTemplate = L"%LOCALAPPDATA%\\Microsoft\\Console";
+    const auto cchDirectory = ExpandEnvironmentStringsW(directoryTemplate, nullptr, 0);
+    THROW_LAST_ERROR_IF(0 == cchDirectory);
+
+    std::wstring directory(cchDirectory, UNICODE_NULL);
+    THROW_LAST_ERROR_IF(0 == ExpandEnvironmentStringsW(directoryTemplate, directory.data(), cchDirectory));
+    directory.resize(cchDirectory - 1);
+
+    if (!CreateDirectoryW(directory.c_str(), nullptr))
+    {
+        THROW_LAST_ERROR_IF(GetLastError() != ERROR_ALREADY_EXISTS);
+    }
+
+    return std::make_shared<CommandHistoryFile>(directory + L"\\" + name + L".history",
+                                                L"Local\\ConsoleHistory-" + name);
+}
+
+CommandHistoryFile::CommandHistoryFile(const std::wstring& path, const std::wstring& lockName)
+{
+    _lock.reset(CreateMutexW(nullptr, FALSE, lockName.c_str()));
+    THROW_LAST_ERROR_IF(!_lock);
+
+    _file.reset(CreateFileW(path.c_str(),
+                            GENERIC_READ | GENERIC_WRITE,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                            nullptr,
+                            OPEN_ALWAYS,
+                            FILE_ATTRIBUTE_NORMAL,
+                            nullptr));
+    THROW_LAST_ERROR_IF(!_file);
+
+    // Mapping a new, empty file at this size grows it to the full size, zero filled.
+    _mapping.reset(CreateFileMappingW(_file.get(), nullptr, PAGE_READWRITE, 0, s_fileSize, nullptr));
+    THROW_LAST_ERROR_IF(!_mapping);
+
+    _view.reset(static_cast<BYTE*>(MapViewOfFile(_mapping.get(), FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, s_fileSize)));
+    THROW_LAST_ERROR_IF(!_view);
+
+    const auto lock = _Acquire();
+    _Validate();
+}
+
+// Routine Description:
+// - Reads the most recent commands from the file.
+// Arguments:
+// - maxCommands - the most commands to return
+// Return Value:
+// - The commands, oldest first.
+std::vector<std::wstring> CommandHistoryFile::Load(const size_t maxCommands) const
+{
+    const auto lock = _Acquire();
+    _Validate();
+
+    auto commands = _ReadAll();
+    if (commands.size() > maxCommands)
+    {
+        commands.erase(commands.begin(), commands.end() - maxCommands);
+    }
+
+    return commands;
+}
+
+// Routine Description:
+// - Appends a command to the file. If there isn't room for it, the oldest
+//   commands are dropped until the file is at most half full first.
+// Arguments:
+// - command - the command to append. Commands too large to ever fit in half
+//             of the file aren't kept.
+void CommandHistoryFile::Append(const std::wstring_view command)
+{
+    if (command.empty() || command.size() > s_capacity / 2 / sizeof(wchar_t))
+    {
+        return;
+    }
+
+    const auto size = _RecordSize(command.size());
+
+    const auto lock = _Acquire();
+    _Validate();
+
+    auto& header = _GetHeader();
+    const auto records = _GetRecords();
+
+    if (size > s_capacity - header.used)
+    {
+        auto keepFrom = header.used;
+        for (const auto offset : _RecordOffsets())
+        {
+            if (header.used - offset <= s_capacity / 2)
+            {
+                keepFrom = offset;
+                break;
+            }
+        }
+
+        memmove(records, records + keepFrom, header.used - keepFrom);
+        header.used -= keepFrom;
+    }
+
+    // The record is written in full before it's counted, so a writer that
+    // dies halfway leaves the file as it was.
+    const auto cch = gsl::narrow<DWORD>(command.size());
+    memcpy(records + header.used, &cch, sizeof(cch));
+    memcpy(records + header.used + sizeof(cch), command.data(), command.size() * sizeof(wchar_t));
+    header.used += size;
+}
+
+// Routine Description:
+// - Drops the newest record of a command from the file.
+// Arguments:
+// - command - the command's text. Nothing happens if no record has it.
+void CommandHistoryFile::Remove(const std::wstring_view command)
+{
+    const auto lock = _Acquire();
+    _Validate();
+
+    auto commands = _ReadAll();
+    const auto found = std::find(commands.rbegin(), commands.rend(), command);
+    if (found != commands.rend())
+    {
+        commands.erase(std::next(found).base());
+        _Rewrite(commands);
+    }
+}
+
+// Routine Description:
+// - Swaps the newest records of two commands in the file.
+// Arguments:
+// - commandA, commandB - the commands' text. Nothing happens unless records
+//   of both are found.
+void CommandHistoryFile::Swap(const std::wstring_view commandA, const std::wstring_view commandB)
+{
+    const auto lock = _Acquire();
+    _Validate();
+
+    auto commands = _ReadAll();
+    const auto a = std::find(commands.rbegin(), commands.rend(), commandA);
+    const auto b = std::find(commands.rbegin(), commands.rend(), commandB);
+    if (a != commands.rend() && b != commands.rend() && a != b)
+    {
+        std::iter_swap(a, b);
+        _Rewrite(commands);
+    }
+}
+
+void CommandHistoryFile::Clear()
+{
+    const auto lock = _Acquire();
+    _Validate();
+    _GetHeader().used = 0;
+}
+
+wil::mutex_release_scope_exit CommandHistoryFile::_Acquire() const
+{
+    // Another process holding on to the lock mustn't hang the command line.
+    auto lock = _lock.acquire(nullptr, s_lockTimeoutMs);
+    THROW_HR_IF(HRESULT_FROM_WIN32(ERROR_TIMEOUT), !lock);
+    return lock;
+}
+
+CommandHistoryFile::_Header& CommandHistoryFile::_GetHeader() const noexcept
+{
+    return *reinterpret_cast<_Header*>(_view.get());
+}
+
+BYTE* CommandHistoryFile::_GetRecords() const noexcept
+{
+    return _view.get() + sizeof(_Header);
+}
+
+// Routine Description:
+// - Starts the file over if it's new, from another version, or damaged.
+//   Must be called with the lock held.
+void CommandHistoryFile::_Validate() const noexcept
+{
+    auto& header = _GetHeader();
+    if (header.signature != s_signature ||
+        header.version != s_version ||
+        header.used > s_capacity)
+    {
+        header.signature = s_signature;
+        header.version = s_version;
+        header.used = 0;
+        header.reserved = 0;
+    }
+}
+
+// Routine Description:
+// - Finds where each complete record starts. A record running past the end
+//   of the used space ends the walk. Must be called with the lock held.
+std::vector<DWORD> CommandHistoryFile::_RecordOffsets() const
+{
+    const auto used = _GetHeader().used;
+    const auto records = _GetRecords();
+
+    std::vector<DWORD> offsets;
+    DWORD offset = 0;
+    while (used - offset >= sizeof(DWORD))
+    {
+        DWORD cch;
+        memcpy(&cch, records + offset, sizeof(cch));
+        if (cch > s_capacity / sizeof(wchar_t) || _RecordSize(cch) > used - offset)
+        {
+            break;
+        }
+
+        offsets.push_back(offset);
+        offset += _RecordSize(cch);
+    }
+
+    return offsets;
+}
+
+// Routine Description:
+// - Reads every complete record, oldest first. Must be called with the lock held.
+std::vector<std::wstring> CommandHistoryFile::_ReadAll() const
+{
+    const auto offsets = _RecordOffsets();
+
+    std::vector<std::wstring> commands;
+    commands.reserve(offsets.size());
+    for (const auto offset : offsets)
+    {
+        const auto record = _GetRecords() + offset;
+
+        DWORD cch;
+        memcpy(&cch, record, sizeof(cch));
+        commands.emplace_back(reinterpret_cast<const wchar_t*>(record + sizeof(cch)), cch);
+    }
+
+    return commands;
+}
+
+// Routine Description:
+// - Replaces every record with the given commands. They always fit, since
+//   they came out of the file. Must be called with the lock held.
+// - Nothing is counted until all of them are written, so a writer that dies
+//   halfway leaves the file empty rather than damaged.
+// Arguments:
+// - commands - the commands, oldest first
+void CommandHistoryFile::_Rewrite(const std::vector<std::wstring>& commands)
+{
+    auto& header = _GetHeader();
+    const auto records = _GetRecords();
+    header.used = 0;
+
+    DWORD used = 0;
+    for (const auto& command : commands)
+    {
+        const auto cch = gsl::narrow<DWORD>(command.size());
+        memcpy(records + used, &cch, sizeof(cch));
+        memcpy(records + used + sizeof(cch), command.data(), command.size() * sizeof(wchar_t));
+        used += _RecordSize(command.size());
+    }
+
+    header.used = used;
+}
+
+// Routine Description:
+// - The size of a record holding a command of the given length: the length
+//   itself followed by the text, padded out to keep the next record aligned.
+DWORD CommandHistoryFile::_RecordSize(const size_t cch) noexcept
+{
+    return gsl::narrow_cast<DWORD>(sizeof(DWORD) + ((cch * sizeof(wchar_t) + 3) & ~size_t{ 3 }));
+}
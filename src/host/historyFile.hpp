@@ -0,0 +1,64 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- historyFile.hpp
+
+Abstract:
+- A command history kept on disk, one file per client executable, so commands
+  typed in one console session can be recalled in the next.
+- The file is mapped into memory and shared by every console that has the
+  same executable attached. Writers append length-prefixed records under a
+  named mutex; when the file fills up, the oldest half of it is dropped.
+- Removing and reordering commands rewrite the records. They work on the
+  newest record with the command's text, since other consoles may have
+  appended since the history was loaded.
+--*/
+
+#pragma once
+
+class CommandHistoryFile final
+{
+public:
+    static std::shared_ptr<CommandHistoryFile> s_Open(const std::wstring_view appName);
+
+    CommandHistoryFile(const std::wstring& path, const std::wstring& lockName);
+
+    std::vector<std::wstring> Load(const size_t maxCommands) const;
+    void Append(const std::wstring_view command);
+    void Remove(const std::wstring_view command);
+    void Swap(const std::wstring_view commandA, const std::wstring_view commandB);
+    void Clear();
+
+private:
+    struct _Header
+    {
+        DWORD signature;
+        DWORD version;
+        DWORD used; // bytes of records following the header
+        DWORD reserved;
+    };
+
+    static constexpr DWORD s_signature = 'HNOC';
+    static constexpr DWORD s_version = 1;
+    static constexpr DWORD s_fileSize = 1024 * 1024;
+    static constexpr DWORD s_capacity = s_fileSize - sizeof(_Header);
+    static constexpr DWORD s_lockTimeoutMs = 1000;
+
+    wil::unique_hfile _file;
+    wil::unique_handle _mapping;
+    wil::unique_mapview_ptr<BYTE> _view;
+    wil::unique_mutex _lock;
+
+    wil::mutex_release_scope_exit _Acquire() const;
+    _Header& _GetHeader() const noexcept;
+    BYTE* _GetRecords() const noexcept;
+
+    void _Validate() const noexcept;
+    std::vector<DWORD> _RecordOffsets() const;
+    std::vector<std::wstring> _ReadAll() const;
+    void _Rewrite(const std::vector<std::wstring>& commands);
+
+    static DWORD _RecordSize(const size_t cch) noexcept;
+};
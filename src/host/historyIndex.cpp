@@ -0,0 +1,193 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "historyIndex.hpp"
+
+#pragma hdrstop
+
+CommandHistoryIndex::CommandHistoryIndex() :
+    _nodes(1)
+{
+}
+
+// Routine Description:
+// - Adds a command to the index.
+// Arguments:
+// - command - the text of the command
+// - id - the id the command will be found under. Must not already be in use.
+void CommandHistoryIndex::Insert(const std::wstring_view command, const uint64_t id)
+{
+    auto node = s_root;
+    const auto depth = std::min(command.size(), s_maxDepth);
+    for (size_t i = 0; i < depth; ++i)
+    {
+        const auto ch = _Fold(command[i]);
+        const auto child = _Child(node, ch);
+        node = child.has_value() ? child.value() : _AddChild(node, ch);
+        _AddId(_nodes[node], id);
+    }
+}
+
+// Routine Description:
+// - Removes a command from the index. Nodes that no longer lead anywhere are
+//   recycled.
+// Arguments:
+// - command - the text the command was inserted with
+// - id - the id the command was inserted with
+void CommandHistoryIndex::Erase(const std::wstring_view command, const uint64_t id)
+{
+    std::array<size_t, s_maxDepth + 1> path{};
+    path[0] = s_root;
+
+    size_t depth = 0;
+    const auto maxDepth = std::min(command.size(), s_maxDepth);
+    while (depth < maxDepth)
+    {
+        const auto child = _Child(path[depth], _Fold(command[depth]));
+        if (!child.has_value())
+        {
+            break;
+        }
+        ++depth;
+        path[depth] = child.value();
+        _EraseId(_nodes[path[depth]], id);
+    }
+
+    // Anything below a node is also in the node itself, so an empty node
+    // has nothing but empty nodes below it. Going bottom-up unhooks those
+    // before their parents.
+    for (; depth > 0; --depth)
+    {
+        auto& node = _nodes[path[depth]];
+        if (node.first < node.ids.size())
+        {
+            break;
+        }
+
+        node.children.clear();
+        node.ids.clear();
+        node.first = 0;
+        _RemoveChild(path[depth - 1], command[depth - 1]);
+        _freeNodes.push_back(path[depth]);
+    }
+}
+
+void CommandHistoryIndex::Clear() noexcept
+{
+    _nodes.resize(1);
+    _nodes[s_root].children.clear();
+    _freeNodes.clear();
+}
+
+std::optional<size_t> CommandHistoryIndex::_Find(const std::wstring_view prefix) const
+{
+    std::optional<size_t> node = s_root;
+    const auto depth = std::min(prefix.size(), s_maxDepth);
+    for (size_t i = 0; i < depth && node.has_value(); ++i)
+    {
+        node = _Child(node.value(), _Fold(prefix[i]));
+    }
+    return node;
+}
+
+std::optional<size_t> CommandHistoryIndex::_Child(const size_t node, const wchar_t ch) const noexcept
+{
+    const auto& children = _nodes[node].children;
+    const auto it = std::lower_bound(children.cbegin(), children.cend(), ch, [](const auto& child, const wchar_t value) {
+        return child.first < value;
+    });
+
+    if (it != children.cend() && it->first == ch)
+    {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+size_t CommandHistoryIndex::_AddChild(const size_t node, const wchar_t ch)
+{
+    size_t child;
+    if (_freeNodes.empty())
+    {
+        child = _nodes.size();
+        _nodes.emplace_back();
+    }
+    else
+    {
+        child = _freeNodes.back();
+        _freeNodes.pop_back();
+    }
+
+    auto& children = _nodes[node].children;
+    const auto it = std::lower_bound(children.cbegin(), children.cend(), ch, [](const auto& entry, const wchar_t value) {
+        return entry.first < value;
+    });
+    children.emplace(it, ch, child);
+    return child;
+}
+
+void CommandHistoryIndex::_RemoveChild(const size_t node, const wchar_t ch) noexcept
+{
+    auto& children = _nodes[node].children;
+    const auto folded = _Fold(ch);
+    const auto it = std::lower_bound(children.begin(), children.end(), folded, [](const auto& entry, const wchar_t value) {
+        return entry.first < value;
+    });
+
+    if (it != children.end() && it->first == folded)
+    {
+        children.erase(it);
+    }
+}
+
+// Routine Description:
+// - Records that a command with the given id passes through the node. Ids are
+//   normally handed out in increasing order, which makes this an append.
+void CommandHistoryIndex::_AddId(_Node& node, const uint64_t id)
+{
+    if (node.first == node.ids.size() || node.ids.back() < id)
+    {
+        node.ids.push_back(id);
+        return;
+    }
+
+    const auto it = std::lower_bound(node.ids.cbegin() + node.first, node.ids.cend(), id);
+    node.ids.insert(it, id);
+}
+
+// Routine Description:
+// - Forgets an id at a node. The oldest command is the one evicted in the
+//   common case, so its id is only skipped over and the skipped space is
+//   given back once it makes up half of the list.
+void CommandHistoryIndex::_EraseId(_Node& node, const uint64_t id)
+{
+    const auto begin = node.ids.begin() + node.first;
+    if (begin != node.ids.end() && *begin == id)
+    {
+        ++node.first;
+        if (node.first == node.ids.size())
+        {
+            node.ids.clear();
+            node.first = 0;
+        }
+        else if (node.first * 2 > node.ids.size())
+        {
+            node.ids.erase(node.ids.begin(), node.ids.begin() + node.first);
+            node.first = 0;
+        }
+        return;
+    }
+
+    const auto it = std::lower_bound(begin, node.ids.end(), id);
+    if (it != node.ids.end() && *it == id)
+    {
+        node.ids.erase(it);
+    }
+}
+
+wchar_t CommandHistoryIndex::_Fold(const wchar_t ch) noexcept
+{
+    return static_cast<wchar_t>(::towlower(ch));
+}
@@ -0,0 +1,101 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- historyIndex.hpp
+
+Abstract:
+- A case-insensitive prefix index over the commands of a command history.
+- Commands are folded to lower case and threaded through a trie that is cut
+  off after the first s_maxDepth characters. Every node keeps the sorted ids
+  of the commands passing through it, so "the most recent command before X
+  starting with P" is a walk down |P| nodes followed by a binary search.
+- Prefixes longer than the trie is deep still land on the right node, but its
+  candidates have to be confirmed by the caller one at a time.
+- Ids are handed out by the owner. They only need to be unique; the index
+  keeps them ordered itself.
+--*/
+
+#pragma once
+
+class CommandHistoryIndex final
+{
+public:
+    CommandHistoryIndex();
+
+    void Insert(const std::wstring_view command, const uint64_t id);
+    void Erase(const std::wstring_view command, const uint64_t id);
+    void Clear() noexcept;
+
+    // Routine Description:
+    // - Finds the command with the highest id not above the given one whose
+    //   text starts with the prefix, wrapping around to the highest id overall
+    //   if there is none. This mirrors walking a history backwards from a
+    //   position until a command matches.
+    // Arguments:
+    // - prefix - text the command has to start with, compared case-insensitively
+    // - atOrBefore - the id to start looking from
+    // - confirm - called with the id of each candidate, in search order. Returns
+    //             true if the command is really a match.
+    // Return Value:
+    // - The id of the first confirmed candidate, if any.
+    template<typename Predicate>
+    std::optional<uint64_t> FindLast(const std::wstring_view prefix,
+                                     const uint64_t atOrBefore,
+                                     Predicate confirm) const
+    {
+        const auto node = _Find(prefix);
+        if (!node.has_value())
+        {
+            return std::nullopt;
+        }
+
+        const auto& ids = _nodes[node.value()].ids;
+        const auto begin = ids.cbegin() + _nodes[node.value()].first;
+        const auto start = std::upper_bound(begin, ids.cend(), atOrBefore);
+
+        for (auto it = start; it != begin; --it)
+        {
+            if (confirm(*(it - 1)))
+            {
+                return *(it - 1);
+            }
+        }
+
+        for (auto it = ids.cend(); it != start; --it)
+        {
+            if (confirm(*(it - 1)))
+            {
+                return *(it - 1);
+            }
+        }
+
+        return std::nullopt;
+    }
+
+private:
+    static constexpr size_t s_maxDepth = 16;
+    static constexpr size_t s_root = 0;
+
+    struct _Node
+    {
+        // sorted by character
+        std::vector<std::pair<wchar_t, size_t>> children;
+        // ascending; the first `first` entries have been erased already
+        std::vector<uint64_t> ids;
+        size_t first = 0;
+    };
+
+    std::vector<_Node> _nodes;
+    std::vector<size_t> _freeNodes;
+
+    std::optional<size_t> _Find(const std::wstring_view prefix) const;
+    std::optional<size_t> _Child(const size_t node, const wchar_t ch) const noexcept;
+    size_t _AddChild(const size_t node, const wchar_t ch);
+    void _RemoveChild(const size_t node, const wchar_t ch) noexcept;
+
+    static void _AddId(_Node& node, const uint64_t id);
+    static void _EraseId(_Node& node, const uint64_t id);
+    static wchar_t _Fold(const wchar_t ch) noexcept;
+};
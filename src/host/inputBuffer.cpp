@@ -5,6 +5,7 @@
 #include "inputBuffer.hpp"
 #include "dbcs.h"
 #include "stream.h"
+#include "../types/inc/convert.hpp"
 #include "../types/inc/GlyphWidth.hpp"
 
 #include <functional>
@@ -22,7 +23,8 @@
 InputBuffer::InputBuffer() :
     InputMode{ INPUT_BUFFER_DEFAULT_INPUT_MODE },
     WaitQueue{},
-    _termInput(std::bind(&InputBuffer::_HandleTerminalInputCallback, this, std::placeholders::_1))
+    _termInput(std::bind(&InputBuffer::_HandleTerminalInputCallback, this, std::placeholders::_1),
+               std::bind(&InputBuffer::_HandleTerminalInputText, this, std::placeholders::_1))
 {
     // The _termInput's constructor takes a reference to this object's _HandleTerminalInputCallback.
     // We need to use std::bind to create a reference to that function without a reference to this InputBuffer
@@ -148,6 +150,7 @@ void InputBuffer::ReinitializeInputBuffer()
     ServiceLocator::LocateGlobals().hInputEvent.ResetEvent();
     InputMode = INPUT_BUFFER_DEFAULT_INPUT_MODE;
     _storage.clear();
+    _pastedText.clear();
 }
 
 // Routine Description:
@@ -180,9 +183,17 @@ void InputBuffer::TerminateRead(_In_ WaitTerminationReason Flag)
 // - The number of events currently in the input buffer.
 // Note:
 // - The console lock must be held when calling this routine.
+// - Pasted text that hasn't been expanded yet is counted as two events
+//   (key down and up) per character. Characters that need modifier or
+//   numpad events expand to more than that, so this is a lower bound.
 size_t InputBuffer::GetNumberOfReadyEvents() const noexcept
 {
-    return _storage.size();
+    size_t readyEvents = _storage.size() - _pastedText.size();
+    for (const auto& paste : _pastedText)
+    {
+        readyEvents += 2 * (paste.text.size() - paste.offset);
+    }
+    return readyEvents;
 }
 
 // Routine Description:
@@ -196,6 +207,7 @@ size_t InputBuffer::GetNumberOfReadyEvents() const noexcept
 void InputBuffer::Flush()
 {
     _storage.clear();
+    _pastedText.clear();
     ServiceLocator::LocateGlobals().hInputEvent.ResetEvent();
 }
 
@@ -209,11 +221,11 @@ void InputBuffer::Flush()
 // - The console lock must be held when calling this routine.
 void InputBuffer::FlushAllButKeys()
 {
-    auto newEnd = std::remove_if(_storage.begin(), _storage.end(), [](const std::unique_ptr<IInputEvent>& event)
+    // pasted text only ever expands to key events, so it stays
+    _storage.remove_if([](const INPUT_RECORD& record)
     {
-        return event->EventType() != InputEventType::KeyEvent;
+        return record.EventType != KEY_EVENT && record.EventType != s_pastedTextEventType;
     });
-    _storage.erase(newEnd, _storage.end());
 }
 
 // Routine Description:
@@ -356,94 +368,88 @@ void InputBuffer::_ReadBuffer(_Out_ std::deque<std::unique_ptr<IInputEvent>>& ou
     FAIL_FAST_IF(streamRead && readCount != 1);
 
     resetWaitEvent = false;
+    eventsRead = 0;
 
-    std::deque<std::unique_ptr<IInputEvent>> readEvents;
     // we need another var to keep track of how many we've read
     // because dbcs records count for two when we aren't doing a
     // unicode read but the eventsRead count should return the number
     // of events actually put into outRecords.
     size_t virtualReadCount = 0;
 
-    while (!_storage.empty() && virtualReadCount < readCount)
-    {
-        bool performNormalRead = true;
-        // for stream reads we need to split any key events that have been coalesced
-        if (streamRead)
-        {
-            if (_storage.front()->EventType() == InputEventType::KeyEvent)
-            {
-                KeyEvent* const pKeyEvent = static_cast<KeyEvent* const>(_storage.front().get());
-                if (pKeyEvent->GetRepeatCount() > 1)
-                {
-                    // split the key event
-                    std::unique_ptr<KeyEvent> streamKeyEvent = std::make_unique<KeyEvent>(*pKeyEvent);
-                    streamKeyEvent->SetRepeatCount(1);
-                    readEvents.push_back(std::move(streamKeyEvent));
-                    pKeyEvent->SetRepeatCount(pKeyEvent->GetRepeatCount() - 1);
-                    performNormalRead = false;
-                }
-            }
-        }
-
-        if (performNormalRead)
-        {
-            readEvents.push_back(std::move(_storage.front()));
-            _storage.pop_front();
-        }
-
+    const auto takeRecord = [&](const INPUT_RECORD& record) {
         ++virtualReadCount;
         if (!unicode)
         {
-            if (readEvents.back()->EventType() == InputEventType::KeyEvent)
+            if (record.EventType == KEY_EVENT &&
+                IsGlyphFullWidth(record.Event.KeyEvent.uChar.UnicodeChar))
             {
-                const KeyEvent* const pKeyEvent = static_cast<const KeyEvent* const>(readEvents.back().get());
-                if (IsGlyphFullWidth(pKeyEvent->GetCharData()))
-                {
-                    ++virtualReadCount;
-                }
+                ++virtualReadCount;
             }
         }
-    }
 
-    // the amount of events that were actually read
-    eventsRead = readEvents.size();
+        outEvents.push_back(IInputEvent::Create(record));
+        ++eventsRead;
+    };
 
-    // copy the events back if we were supposed to peek
-    if (peek)
+    // when peeking we walk the storage without removing anything from it.
+    size_t peekIndex = 0;
+    size_t pasteIndex = 0;
+
+    while (virtualReadCount < readCount &&
+           (peek ? peekIndex < _storage.size() : !_storage.empty()))
     {
-        if (streamRead)
+        INPUT_RECORD& stored = peek ? _storage[peekIndex] : _storage.front();
+
+        if (stored.EventType == s_pastedTextEventType)
         {
-            // we need to check and see if the event was split from a coalesced key event
-            // or if it was unrelated to the current front event in storage
-            if (!readEvents.empty() &&
-                !_storage.empty() &&
-                readEvents.back()->EventType() == InputEventType::KeyEvent &&
-                _storage.front()->EventType() == InputEventType::KeyEvent &&
-                _CanCoalesce(static_cast<const KeyEvent&>(*readEvents.back()),
-                                static_cast<const KeyEvent&>(*_storage.front())))
+            if (peek)
             {
-                KeyEvent& keyEvent = static_cast<KeyEvent&>(*_storage.front());
-                keyEvent.SetRepeatCount(keyEvent.GetRepeatCount() + 1);
+                // expand a copy of just as much of the text as the caller
+                // wants to see, leaving the stored text untouched.
+                const _PastedText& paste = _pastedText.at(pasteIndex);
+                size_t offset = paste.offset;
+                std::vector<INPUT_RECORD> records;
+                _ExpandPastedText(paste, offset, readCount - virtualReadCount, records);
+                for (const auto& record : records)
+                {
+                    if (virtualReadCount >= readCount)
+                    {
+                        break;
+                    }
+                    takeRecord(record);
+                }
+                ++pasteIndex;
+                ++peekIndex;
             }
             else
             {
-                _storage.push_front(IInputEvent::Create(readEvents.back()->ToInputRecord()));
+                // turn enough of the text into events to satisfy this read
+                // and go around again to read them like any others.
+                _ExpandFrontPastedText(readCount - virtualReadCount);
             }
+            continue;
         }
-        else
+
+        INPUT_RECORD record = stored;
+
+        // for stream reads we need to split any key events that have been coalesced
+        if (streamRead &&
+            record.EventType == KEY_EVENT &&
+            record.Event.KeyEvent.wRepeatCount > 1)
         {
-            for (auto it = readEvents.crbegin(); it != readEvents.crend(); ++it)
+            record.Event.KeyEvent.wRepeatCount = 1;
+            if (!peek)
             {
-                _storage.push_front(IInputEvent::Create((*it)->ToInputRecord()));
+                --stored.Event.KeyEvent.wRepeatCount;
             }
         }
-    }
+        else if (!peek)
+        {
+            _storage.pop_front();
+        }
+        ++peekIndex;
 
-    // move events read to proper deque
-    while (!readEvents.empty())
-    {
-        outEvents.push_back(std::move(readEvents.front()));
-        readEvents.pop_front();
+        takeRecord(record);
     }
 
     // signal if we emptied the buffer
@@ -471,29 +477,30 @@ size_t InputBuffer::Prepend(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& in
         {
             return STATUS_SUCCESS;
         }
-        // read all of the records out of the buffer, then write the
-        // prepend ones, then write the original set. We need to do it
-        // this way to handle any coalescing that might occur.
+        // move all of the records out of the buffer, then write the
+        // prepend ones, then put the original set back behind them.
 
         // get all of the existing records, "emptying" the buffer
-        std::deque<std::unique_ptr<IInputEvent>> existingStorage;
-        existingStorage.swap(_storage);
+        RingBuffer<INPUT_RECORD> existingStorage;
+        std::swap(existingStorage, _storage);
+        const bool initiallyEmptyQueue = existingStorage.empty();
 
         // We will need this variable to pass to _WriteBuffer so it can attempt to determine wait status.
-        // However, because we swapped the storage out from under it with an empty deque, it will always
-        // return true after the first one (as it is filling the newly emptied backing deque.)
-        // Then after the second one, because we've inserted some input, it will always say false.
+        // Because we swapped the storage out from under it, it can't tell us anything useful.
         bool unusedWaitStatus = false;
 
         // write the prepend records
         size_t prependEventsWritten;
         _WriteBuffer(inEvents, prependEventsWritten, unusedWaitStatus);
-        FAIL_FAST_IF(!(unusedWaitStatus));
 
-        // write all previously existing records
-        size_t existingEventsWritten;
-        _WriteBuffer(existingStorage, existingEventsWritten, unusedWaitStatus);
-        FAIL_FAST_IF(!(!unusedWaitStatus));
+        // Put back all previously existing records. They were already
+        // coalesced and translated when they were first written, so they're
+        // carried over as they are. This also keeps the placeholders for
+        // any pasted text that hasn't been expanded yet in their place.
+        for (size_t i = 0; i < existingStorage.size(); ++i)
+        {
+            _storage.push_back(existingStorage[i]);
+        }
 
         // We need to set the wait event if there were 0 events in the
         // input queue when we started.
@@ -502,7 +509,7 @@ size_t InputBuffer::Prepend(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& in
         // and instead need to set the event if the original backing
         // buffer (the one we swapped out at the top) was empty
         // when this whole thing started.
-        if (existingStorage.empty())
+        if (initiallyEmptyQueue && !_storage.empty())
         {
             ServiceLocator::LocateGlobals().hInputEvent.SetEvent();
         }
@@ -583,6 +590,63 @@ size_t InputBuffer::Write(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEv
     }
 }
 
+// Routine Description:
+// - Writes pasted text to the input buffer. Wakes up any readers that are
+// waiting for additional input events.
+// - In VT input mode the text is handed to the terminal input module in one
+// piece (which brackets it if the client asked for that). Otherwise it's
+// stored as-is and expanded into key events as it's read, so a large paste
+// doesn't have to be turned into millions of events up front.
+// Arguments:
+// - text - the text to paste. Filtering of the text must already be done.
+// - codepage - the codepage used to synthesize events for characters that
+// aren't on the keyboard layout.
+// Return Value:
+// - <none>
+// Note:
+// - The console lock must be held when calling this routine.
+void InputBuffer::WritePastedText(const std::wstring_view text, const UINT codepage)
+{
+    try
+    {
+        if (text.empty())
+        {
+            return;
+        }
+
+        // Like any other key press, a paste resumes a suspended console.
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        if (WI_IsFlagSet(gci.Flags, CONSOLE_SUSPENDED))
+        {
+            UnblockWriteConsole(CONSOLE_OUTPUT_SUSPENDED);
+        }
+
+        const bool initiallyEmptyQueue = _storage.empty();
+        if (IsInVirtualTerminalInputMode())
+        {
+            _termInput.HandlePaste(text);
+        }
+        else
+        {
+            _pastedText.push_back({ std::wstring{ text }, 0, codepage });
+
+            INPUT_RECORD placeholder{ 0 };
+            placeholder.EventType = s_pastedTextEventType;
+            _storage.push_back(placeholder);
+        }
+
+        if (initiallyEmptyQueue && !_storage.empty())
+        {
+            ServiceLocator::LocateGlobals().hInputEvent.SetEvent();
+        }
+        WakeUpReadersWaitingForData();
+    }
+    catch (...)
+    {
+        LOG_HR(wil::ResultFromCaughtException());
+    }
+}
+
 // Routine Description:
 // - Coalesces input events and transfers them to storage queue.
 // Arguments:
@@ -624,46 +688,25 @@ void InputBuffer::_WriteBuffer(_Inout_ std::deque<std::unique_ptr<IInputEvent>>&
             }
         }
 
+        const INPUT_RECORD record = inEvent->ToInputRecord();
+
         // we only check for possible coalescing when storing one
         // record at a time because this is the original behavior of
         // the input buffer. Changing this behavior may break stuff
         // that was depending on it.
         if (initialInEventsSize == 1 && !_storage.empty())
         {
-            // coalescing requires a deque of events, so push it back onto the front.
-            inEvents.push_front(std::move(inEvent));
-
-            bool coalesced = false;
             // this looks kinda weird but we don't want to coalesce a
             // mouse event and then try to coalesce a key event right after.
-            //
-            // we also pass the whole deque to the coalescing methods
-            // even though they only want one event because it should
-            // be their responsibility to maintain the correct state
-            // of the deque if they process any records in it.
-            if (_CoalesceMouseMovedEvents(inEvents))
-            {
-                coalesced = true;
-            }
-            else if (_CoalesceRepeatedKeyPressEvents(inEvents))
-            {
-                coalesced = true;
-            }
-            if (coalesced)
+            if (_CoalesceMouseMovedEvents(record) ||
+                _CoalesceRepeatedKeyPressEvents(record))
             {
                 eventsWritten = 1;
                 return;
             }
-            else
-            {
-                // We didn't coalesce the event. pull it from the queue again,
-                //  to keep the state consistent with the start of this block.
-                inEvent = std::move(inEvents.front());
-                inEvents.pop_front();
-            }
         }
         // At this point, the event was neither coalesced, nor processed by VT.
-        _storage.push_back(std::move(inEvent));
+        _storage.push_back(record);
         ++eventsWritten;
     }
     if (initiallyEmptyQueue && !_storage.empty())
@@ -673,44 +716,30 @@ void InputBuffer::_WriteBuffer(_Inout_ std::deque<std::unique_ptr<IInputEvent>>&
 }
 
 // Routine Description:
-// - Checks if the last saved event and the first event of inRecords are
-// both MOUSE_MOVED events. If they are, the last saved event is
-// updated with the new mouse position and the first event of inRecords is
-// dropped.
+// - Checks if the last saved event and inRecord are both MOUSE_MOVED
+// events. If they are, the last saved event is updated with the new mouse
+// position and inRecord doesn't need to be stored.
 // Arguments:
-// - inRecords - The incoming records to process.
+// - inRecord - The incoming record to process.
 // Return Value:
 // true if events were coalesced, false if they were not.
 // Note:
-// - The size of inRecords must be 1.
 // - Coalescing here means updating a record that already exists in
 // the buffer with updated values from an incoming event, instead of
 // storing the incoming event (which would make the original one
 // redundant/out of date with the most current state).
-bool InputBuffer::_CoalesceMouseMovedEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
+bool InputBuffer::_CoalesceMouseMovedEvents(const INPUT_RECORD& inRecord) noexcept
 {
-    FAIL_FAST_IF(!(inEvents.size() == 1));
     FAIL_FAST_IF(_storage.empty());
-    const IInputEvent* const pFirstInEvent = inEvents.front().get();
-    const IInputEvent* const pLastStoredEvent = _storage.back().get();
-    if (pFirstInEvent->EventType() == InputEventType::MouseEvent &&
-        pLastStoredEvent->EventType() == InputEventType::MouseEvent)
+    INPUT_RECORD& lastRecord = _storage.back();
+    if (inRecord.EventType == MOUSE_EVENT &&
+        lastRecord.EventType == MOUSE_EVENT &&
+        inRecord.Event.MouseEvent.dwEventFlags == MOUSE_MOVED &&
+        lastRecord.Event.MouseEvent.dwEventFlags == MOUSE_MOVED)
     {
-        const MouseEvent* const pInMouseEvent = static_cast<const MouseEvent* const>(pFirstInEvent);
-        const MouseEvent* const pLastMouseEvent = static_cast<const MouseEvent* const>(pLastStoredEvent);
-
-        if (pInMouseEvent->IsMouseMoveEvent() &&
-            pLastMouseEvent->IsMouseMoveEvent())
-        {
-            // update mouse moved position
-            MouseEvent* const pMouseEvent = static_cast<MouseEvent* const>(_storage.back().release());
-            pMouseEvent->SetPosition(pInMouseEvent->GetPosition());
-            std::unique_ptr<IInputEvent> tempPtr(pMouseEvent);
-            tempPtr.swap(_storage.back());
-
-            inEvents.pop_front();
-            return true;
-        }
+        // update mouse moved position
+        lastRecord.Event.MouseEvent.dwMousePosition = inRecord.Event.MouseEvent.dwMousePosition;
+        return true;
     }
     return false;
 }
@@ -722,18 +751,18 @@ bool InputBuffer::_CoalesceMouseMovedEvents(_Inout_ std::deque<std::unique_ptr<I
 // - b - the other KeyEvent
 // Return Value:
 // - true if the events could be coalesced, false otherwise
-bool InputBuffer::_CanCoalesce(const KeyEvent& a, const KeyEvent& b) const noexcept
+bool InputBuffer::_CanCoalesce(const KEY_EVENT_RECORD& a, const KEY_EVENT_RECORD& b) const noexcept
 {
-    if (WI_IsFlagSet(a.GetActiveModifierKeys(), NLS_IME_CONVERSION) &&
-        a.GetCharData() == b.GetCharData() &&
-        a.GetActiveModifierKeys() == b.GetActiveModifierKeys())
+    if (WI_IsFlagSet(a.dwControlKeyState, NLS_IME_CONVERSION) &&
+        a.uChar.UnicodeChar == b.uChar.UnicodeChar &&
+        a.dwControlKeyState == b.dwControlKeyState)
     {
         return true;
     }
     // other key events check
-    else if (a.GetVirtualScanCode() == b.GetVirtualScanCode() &&
-                a.GetCharData() == b.GetCharData() &&
-                a.GetActiveModifierKeys() == b.GetActiveModifierKeys())
+    else if (a.wVirtualScanCode == b.wVirtualScanCode &&
+                a.uChar.UnicodeChar == b.uChar.UnicodeChar &&
+                a.dwControlKeyState == b.dwControlKeyState)
     {
         return true;
     }
@@ -741,50 +770,101 @@ bool InputBuffer::_CanCoalesce(const KeyEvent& a, const KeyEvent& b) const noexc
 }
 
 // Routine Description::
-// - If the last input event saved and the first input event in inRecords
-// are both a keypress down event for the same key, update the repeat
-// count of the saved event and drop the first from inRecords.
+// - If the last input event saved and inRecord are both a keypress down
+// event for the same key, update the repeat count of the saved event so
+// that inRecord doesn't need to be stored.
 // Arguments:
-// - inRecords - The incoming records to process.
+// - inRecord - The incoming record to process.
 // Return Value:
 // true if events were coalesced, false if they were not.
 // Note:
-// - The size of inRecords must be 1.
 // - Coalescing here means updating a record that already exists in
 // the buffer with updated values from an incoming event, instead of
 // storing the incoming event (which would make the original one
 // redundant/out of date with the most current state).
-bool InputBuffer::_CoalesceRepeatedKeyPressEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents)
+bool InputBuffer::_CoalesceRepeatedKeyPressEvents(const INPUT_RECORD& inRecord)
 {
-    FAIL_FAST_IF(!(inEvents.size() == 1));
     FAIL_FAST_IF(_storage.empty());
-    const IInputEvent* const pFirstInEvent = inEvents.front().get();
-    const IInputEvent* const pLastStoredEvent = _storage.back().get();
-    if (pFirstInEvent->EventType() == InputEventType::KeyEvent &&
-        pLastStoredEvent->EventType() == InputEventType::KeyEvent)
-    {
-        const KeyEvent* const pInKeyEvent = static_cast<const KeyEvent* const>(pFirstInEvent);
-        const KeyEvent* const pLastKeyEvent = static_cast<const KeyEvent* const>(pLastStoredEvent);
-
-        if (pInKeyEvent->IsKeyDown() &&
-            pLastKeyEvent->IsKeyDown() &&
-            !IsGlyphFullWidth(pInKeyEvent->GetCharData()) &&
-            _CanCoalesce(*pInKeyEvent, *pLastKeyEvent))
+    INPUT_RECORD& lastRecord = _storage.back();
+    if (inRecord.EventType == KEY_EVENT &&
+        lastRecord.EventType == KEY_EVENT)
+    {
+        const KEY_EVENT_RECORD& inKey = inRecord.Event.KeyEvent;
+        KEY_EVENT_RECORD& lastKey = lastRecord.Event.KeyEvent;
+
+        if (inKey.bKeyDown &&
+            lastKey.bKeyDown &&
+            !IsGlyphFullWidth(inKey.uChar.UnicodeChar) &&
+            _CanCoalesce(inKey, lastKey))
         {
             // increment repeat count
-            KeyEvent* const pKeyEvent = static_cast<KeyEvent* const>(_storage.back().release());
-            WORD repeatCount = pKeyEvent->GetRepeatCount() + pInKeyEvent->GetRepeatCount();
-            pKeyEvent->SetRepeatCount(repeatCount);
-            std::unique_ptr<IInputEvent> tempPtr(pKeyEvent);
-            tempPtr.swap(_storage.back());
-
-            inEvents.pop_front();
+            lastKey.wRepeatCount += inKey.wRepeatCount;
             return true;
         }
     }
     return false;
 }
 
+// Routine Description:
+// - Turns pasted text into key events, a character at a time, until at
+// least minEvents events have been made or the text runs out.
+// Arguments:
+// - paste - the pasted text to expand
+// - offset - on entry, the first character to expand. On exit, the first
+// character that wasn't.
+// - minEvents - how many events the caller would like
+// - records - receives the events
+// Return Value:
+// - <none>
+// Note:
+// - will throw on failure
+void InputBuffer::_ExpandPastedText(const _PastedText& paste,
+                                    size_t& offset,
+                                    const size_t minEvents,
+                                    std::vector<INPUT_RECORD>& records)
+{
+    while (records.size() < minEvents && offset < paste.text.size())
+    {
+        const std::deque<std::unique_ptr<KeyEvent>> keyEvents = CharToKeyEvents(paste.text[offset], paste.codepage);
+        ++offset;
+        for (const auto& keyEvent : keyEvents)
+        {
+            records.push_back(keyEvent->ToInputRecord());
+        }
+    }
+}
+
+// Routine Description:
+// - Expands the start of the pasted text at the front of the buffer into
+// key events, placing them in front of its placeholder. The placeholder is
+// removed once all of its text has been expanded.
+// Arguments:
+// - minEvents - how many events the caller would like to be available
+// Return Value:
+// - <none>
+// Note:
+// - The front of the buffer must be a pasted text placeholder.
+// - will throw on failure
+void InputBuffer::_ExpandFrontPastedText(const size_t minEvents)
+{
+    FAIL_FAST_IF(_storage.empty() || _storage.front().EventType != s_pastedTextEventType);
+
+    _PastedText& paste = _pastedText.front();
+    std::vector<INPUT_RECORD> records;
+    _ExpandPastedText(paste, paste.offset, minEvents, records);
+
+    if (paste.offset >= paste.text.size())
+    {
+        _storage.pop_front();
+        _pastedText.pop_front();
+    }
+
+    for (auto it = records.crbegin(); it != records.crend(); ++it)
+    {
+        _storage.push_front(*it);
+    }
+}
+
 // Routine Description:
 // - Handles records that suspend/resume the console.
 // Arguments:
@@ -852,9 +932,36 @@ void InputBuffer::_HandleTerminalInputCallback(std::deque<std::unique_ptr<IInput
         // add all input events to the storage queue
         while (!inEvents.empty())
         {
-            std::unique_ptr<IInputEvent> inEvent = std::move(inEvents.front());
+            _storage.push_back(inEvents.front()->ToInputRecord());
             inEvents.pop_front();
-            _storage.push_back(std::move(inEvent));
+        }
+    }
+    catch (...)
+    {
+        LOG_HR(wil::ResultFromCaughtException());
+    }
+}
+
+// Routine Description:
+// - Handler for text the terminal emulation layer wants to send as it is,
+//   such as a paste. Each character becomes one key down record, the same
+//   as TerminalInput would otherwise have made events for.
+// Arguments:
+// - text - the characters to insert into the buffer
+// Return Value:
+// - <none>
+void InputBuffer::_HandleTerminalInputText(const std::wstring_view text)
+{
+    try
+    {
+        INPUT_RECORD record{ 0 };
+        record.EventType = KEY_EVENT;
+        record.Event.KeyEvent.bKeyDown = TRUE;
+        record.Event.KeyEvent.wRepeatCount = 1;
+        for (const auto wch : text)
+        {
+            record.Event.KeyEvent.uChar.UnicodeChar = wch;
+            _storage.push_back(record);
         }
     }
     catch (...)
@@ -20,6 +20,7 @@ Revision History:
 
 #include "inputReadHandleData.h"
 #include "readData.hpp"
+#include "ringBuffer.hpp"
 #include "../types/inc/IInputEvent.hpp"
 
 #include "../server/ObjectHandle.h"
@@ -76,11 +77,30 @@ public:
     size_t Write(_Inout_ std::unique_ptr<IInputEvent> inEvent);
     size_t Write(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
 
+    void WritePastedText(const std::wstring_view text, const UINT codepage);
+
     bool IsInVirtualTerminalInputMode() const;
     Microsoft::Console::VirtualTerminal::TerminalInput& GetTerminalInput();
 
 private:
-    std::deque<std::unique_ptr<IInputEvent>> _storage;
+    // Events are stored by value. INPUT_RECORD is already a compact tagged
+    // union of every event type we hold, so there's no need for a heap
+    // allocated IInputEvent per event. Conversion to and from IInputEvent
+    // only happens as events cross the Read/Write/Prepend boundary.
+    RingBuffer<INPUT_RECORD> _storage;
+
+    // Text pasted for a client that doesn't read VT input is held as a
+    // string and only turned into key events as it's read. Each entry has a
+    // placeholder record in _storage that marks its place in the queue.
+    struct _PastedText
+    {
+        std::wstring text;
+        size_t offset;
+        UINT codepage;
+    };
+    static constexpr WORD s_pastedTextEventType = 0x8000;
+    std::deque<_PastedText> _pastedText;
+
     std::unique_ptr<IInputEvent> _readPartialByteSequence;
     std::unique_ptr<IInputEvent> _writePartialByteSequence;
     Microsoft::Console::VirtualTerminal::TerminalInput _termInput;
@@ -97,12 +117,19 @@ private:
                       _Out_ size_t& eventsWritten,
                       _Out_ bool& setWaitEvent);
 
-    bool _CanCoalesce(const KeyEvent& a, const KeyEvent& b) const noexcept;
-    bool _CoalesceMouseMovedEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
-    bool _CoalesceRepeatedKeyPressEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
+    bool _CanCoalesce(const KEY_EVENT_RECORD& a, const KEY_EVENT_RECORD& b) const noexcept;
+    bool _CoalesceMouseMovedEvents(const INPUT_RECORD& inRecord) noexcept;
+    bool _CoalesceRepeatedKeyPressEvents(const INPUT_RECORD& inRecord);
     void _HandleConsoleSuspensionEvents(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
 
+    static void _ExpandPastedText(const _PastedText& paste,
+                                  size_t& offset,
+                                  const size_t minEvents,
+                                  std::vector<INPUT_RECORD>& records);
+    void _ExpandFrontPastedText(const size_t minEvents);
+
     void _HandleTerminalInputCallback(_In_ std::deque<std::unique_ptr<IInputEvent>>& inEvents);
+    void _HandleTerminalInputText(const std::wstring_view text);
 
 #ifdef UNIT_TESTING
     friend class InputBufferTests;
@@ -298,8 +298,11 @@ bool StreamScrollRegion(SCREEN_INFORMATION& screenInfo)
     bool fSuccess = screenInfo.GetTextBuffer().IncrementCircularBuffer();
     if (fSuccess)
     {
-        // Trigger a graphical update if we're active.
-        if (screenInfo.IsActiveScreenBuffer())
+        screenInfo.CountScrolledRows(1);
+
+        // Trigger a graphical update if we're active. While fast-forwarding,
+        // the screen is redrawn once the write is over instead.
+        if (screenInfo.IsActiveScreenBuffer() && !screenInfo.ShouldFastForward())
         {
             COORD coordDelta = { 0 };
             coordDelta.Y = -1;
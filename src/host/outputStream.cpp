@@ -205,70 +205,32 @@ BOOL ConhostInternalGetSet::SetConsoleTextAttribute(const WORD wAttr)
 }
 
 // Routine Description:
-// - Connects the PrivateSetDefaultAttributes API call directly into our Driver Message servicing call inside Conhost.exe
-//     Sets the FG and/or BG to the Default attributes values.
+// - Retrieves the current attributes of the active screen buffer.
 // Arguments:
-// - fForeground - Set the foreground to the default attributes
-// - fBackground - Set the background to the default attributes
+// - pAttributes - Receives the current attributes
 // Return Value:
-// - TRUE if successful (see DoSrvPrivateSetDefaultAttributes). FALSE otherwise.
-BOOL ConhostInternalGetSet::PrivateSetDefaultAttributes(const bool fForeground,
-                                                        const bool fBackground)
+// - TRUE if successful. FALSE otherwise.
+BOOL ConhostInternalGetSet::PrivateGetTextAttributes(_Out_ TextAttribute* const pAttributes) const
 {
-    DoSrvPrivateSetDefaultAttributes(_io.GetActiveOutputBuffer(), fForeground, fBackground);
-    return TRUE;
-}
+    if (pAttributes == nullptr)
+    {
+        return FALSE;
+    }
 
-// Routine Description:
-// - Connects the PrivateSetLegacyAttributes API call directly into our Driver Message servicing call inside Conhost.exe
-//     Sets only the components of the attributes requested with the fForeground, fBackground, and fMeta flags.
-// Arguments:
-// - wAttr - new color/graphical attributes to apply as default within the console text buffer
-// - fForeground - The new attributes contain an update to the foreground attributes
-// - fBackground - The new attributes contain an update to the background attributes
-// - fMeta - The new attributes contain an update to the meta attributes
-// Return Value:
-// - TRUE if successful (see DoSrvVtSetLegacyAttributes). FALSE otherwise.
-BOOL ConhostInternalGetSet::PrivateSetLegacyAttributes(const WORD wAttr,
-                                                       const bool fForeground,
-                                                       const bool fBackground,
-                                                       const bool fMeta)
-{
-    DoSrvPrivateSetLegacyAttributes(_io.GetActiveOutputBuffer(), wAttr, fForeground, fBackground, fMeta);
+    DoSrvPrivateGetTextAttributes(_io.GetActiveOutputBuffer(), *pAttributes);
     return TRUE;
 }
 
 // Routine Description:
-// - Sets the current attributes of the screen buffer to use the color table entry specified by
-//     the iXtermTableEntry. Sets either the FG or the BG component of the attributes.
+// - Replaces the current attributes of the active screen buffer.
 // Arguments:
-// - iXtermTableEntry - The entry of the xterm table to use.
-// - fIsForeground - Whether or not the color applies to the foreground.
+// - attributes - The new attributes. Colors indexed at 16 or above are taken
+//      from the 256 color xterm table.
 // Return Value:
-// - TRUE if successful (see DoSrvPrivateSetConsoleXtermTextAttribute). FALSE otherwise.
-BOOL ConhostInternalGetSet::SetConsoleXtermTextAttribute(const int iXtermTableEntry, const bool fIsForeground)
+// - TRUE if successful (see DoSrvPrivateSetTextAttributes). FALSE otherwise.
+BOOL ConhostInternalGetSet::PrivateSetTextAttributes(const TextAttribute& attributes)
 {
-    DoSrvPrivateSetConsoleXtermTextAttribute(_io.GetActiveOutputBuffer(), iXtermTableEntry, fIsForeground);
-    return TRUE;
-}
-
-// Routine Description:
-// - Sets the current attributes of the screen buffer to use the given rgb color.
-//     Sets either the FG or the BG component of the attributes.
-// Arguments:
-// - rgbColor - The rgb color to use.
-// - fIsForeground - Whether or not the color applies to the foreground.
-// Return Value:
-// - TRUE if successful (see DoSrvPrivateSetConsoleRGBTextAttribute). FALSE otherwise.
-BOOL ConhostInternalGetSet::SetConsoleRGBTextAttribute(const COLORREF rgbColor, const bool fIsForeground)
-{
-    DoSrvPrivateSetConsoleRGBTextAttribute(_io.GetActiveOutputBuffer(), rgbColor, fIsForeground);
-    return TRUE;
-}
-
-BOOL ConhostInternalGetSet::PrivateBoldText(const bool bolded)
-{
-    DoSrvPrivateBoldText(_io.GetActiveOutputBuffer(), bolded);
+    DoSrvPrivateSetTextAttributes(_io.GetActiveOutputBuffer(), attributes);
     return TRUE;
 }
 
@@ -594,6 +556,19 @@ BOOL ConhostInternalGetSet::PrivateEnableAlternateScroll(const bool fEnabled)
     return TRUE;
 }
 
+// Routine Description:
+// - Connects the PrivateEnableBracketedPasteMode call directly into our Driver Message servicing call inside Conhost.exe
+//   PrivateEnableBracketedPasteMode is an internal-only "API" call that the vt commands can execute,
+//     but it is not represented as a function call on out public API surface.
+// Arguments:
+// - fEnabled - set to true to enable bracketed paste mode, false to disable
+// Return Value:
+// - TRUE if successful (see DoSrvPrivateEnableBracketedPasteMode). FALSE otherwise.
+BOOL ConhostInternalGetSet::PrivateEnableBracketedPasteMode(const bool fEnabled)
+{
+    return NT_SUCCESS(DoSrvPrivateEnableBracketedPasteMode(fEnabled));
+}
+
 // Routine Description:
 // - Connects the PrivateEraseAll call directly into our Driver Message servicing call inside Conhost.exe
 //   PrivateEraseAll is an internal-only "API" call that the vt commands can execute,
@@ -621,18 +596,6 @@ BOOL ConhostInternalGetSet::SetCursorStyle(const CursorType cursorType)
     return TRUE;
 }
 
-// Routine Description:
-// - Retrieves the default color attributes information for the active screen buffer.
-// - This function is used to optimize SGR calls in lieu of calling GetConsoleScreenBufferInfoEx.
-// Arguments:
-// - pwAttributes - Pointer to space to receive color attributes data
-// Return Value:
-// - TRUE if successful. FALSE otherwise.
-BOOL ConhostInternalGetSet::PrivateGetConsoleScreenBufferAttributes(_Out_ WORD* const pwAttributes)
-{
-    return NT_SUCCESS(DoSrvPrivateGetConsoleScreenBufferAttributes(_io.GetActiveOutputBuffer(), pwAttributes));
-}
-
 // Routine Description:
 // - Connects the PrivatePrependConsoleInput API call directly into our Driver Message servicing call inside Conhost.exe
 // Arguments:
@@ -316,9 +316,17 @@ const COLORREF RenderData::GetBackgroundColor(const TextAttribute& attr) const n
 //      operation.
 //   Callers should make sure to also call RenderData::UnlockConsole once
 //      they're done with any querying they need to do.
+// - The renderer calls this at the start of every frame, which is what ends a
+//      flood of output as far as fast-forwarding is concerned.
 void RenderData::LockConsole() noexcept
 {
     ::LockConsole();
+
+    CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    if (gci.HasActiveOutputBuffer())
+    {
+        gci.GetActiveOutputBuffer().NotifyFrameStarted();
+    }
 }
 
 // Method Description:
@@ -0,0 +1,190 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- ringBuffer.hpp
+
+Abstract:
+- A growable circular queue of plain values.
+- Elements live contiguously in a single power-of-two sized allocation that is
+  reused as items are pushed and popped from either end, so steady-state
+  traffic through the queue performs no allocations at all.
+- Intended for records that are produced and consumed at a high rate, such as
+  INPUT_RECORDs or the entries of a command history. Elements are moved, not
+  copied, whenever the storage is rearranged.
+--*/
+
+#pragma once
+
+#include <vector>
+
+template<typename T>
+class RingBuffer final
+{
+public:
+    RingBuffer() noexcept :
+        _head{ 0 },
+        _size{ 0 }
+    {
+    }
+
+    bool empty() const noexcept
+    {
+        return _size == 0;
+    }
+
+    size_t size() const noexcept
+    {
+        return _size;
+    }
+
+    size_t capacity() const noexcept
+    {
+        return _buffer.size();
+    }
+
+    T& operator[](const size_t index) noexcept
+    {
+        return _buffer[_Physical(index)];
+    }
+
+    const T& operator[](const size_t index) const noexcept
+    {
+        return _buffer[_Physical(index)];
+    }
+
+    T& front() noexcept
+    {
+        return _buffer[_head];
+    }
+
+    const T& front() const noexcept
+    {
+        return _buffer[_head];
+    }
+
+    T& back() noexcept
+    {
+        return _buffer[_Physical(_size - 1)];
+    }
+
+    const T& back() const noexcept
+    {
+        return _buffer[_Physical(_size - 1)];
+    }
+
+    void push_back(const T& value)
+    {
+        _EnsureSpare();
+        _buffer[_Physical(_size)] = value;
+        ++_size;
+    }
+
+    void push_back(T&& value)
+    {
+        _EnsureSpare();
+        _buffer[_Physical(_size)] = std::move(value);
+        ++_size;
+    }
+
+    void push_front(const T& value)
+    {
+        _EnsureSpare();
+        _head = (_head + _buffer.size() - 1) & _Mask();
+        _buffer[_head] = value;
+        ++_size;
+    }
+
+    void pop_front() noexcept
+    {
+        _head = (_head + 1) & _Mask();
+        --_size;
+    }
+
+    void pop_back() noexcept
+    {
+        --_size;
+    }
+
+    void clear() noexcept
+    {
+        _head = 0;
+        _size = 0;
+    }
+
+    // Routine Description:
+    // - Removes the element at the given position, shifting the ones after it
+    //   down by one to close the gap.
+    // Arguments:
+    // - index - position of the element to remove. Must be less than size().
+    void erase(const size_t index)
+    {
+        for (size_t i = index + 1; i < _size; ++i)
+        {
+            (*this)[i - 1] = std::move((*this)[i]);
+        }
+        pop_back();
+    }
+
+    // Routine Description:
+    // - Removes every element matching the predicate, preserving the order of
+    //   the remaining ones. Works in place in a single pass.
+    // Arguments:
+    // - pred - returns true for elements that should be removed
+    template<typename Predicate>
+    void remove_if(Predicate pred)
+    {
+        size_t kept = 0;
+        for (size_t i = 0; i < _size; ++i)
+        {
+            T& value = (*this)[i];
+            if (!pred(value))
+            {
+                if (kept != i)
+                {
+                    (*this)[kept] = std::move(value);
+                }
+                ++kept;
+            }
+        }
+        _size = kept;
+    }
+
+private:
+    static constexpr size_t s_initialCapacity = 16;
+
+    std::vector<T> _buffer;
+    size_t _head;
+    size_t _size;
+
+    size_t _Mask() const noexcept
+    {
+        return _buffer.size() - 1;
+    }
+
+    size_t _Physical(const size_t index) const noexcept
+    {
+        return (_head + index) & _Mask();
+    }
+
+    // Routine Description:
+    // - Makes sure there's room for at least one more element, doubling the
+    //   allocation if necessary. The elements are unwrapped to the start of
+    //   the new allocation as they're moved over.
+    void _EnsureSpare()
+    {
+        if (_size < _buffer.size())
+        {
+            return;
+        }
+
+        std::vector<T> grown(_buffer.empty() ? s_initialCapacity : _buffer.size() * 2);
+        for (size_t i = 0; i < _size; ++i)
+        {
+            grown[i] = std::move((*this)[i]);
+        }
+        _buffer.swap(grown);
+        _head = 0;
+    }
+};
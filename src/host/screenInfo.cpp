@@ -57,7 +57,10 @@ SCREEN_INFORMATION::SCREEN_INFORMATION(
     _virtualBottom{ 0 },
     _renderTarget{ *this },
     _currentFont{ fontInfo },
-    _desiredFont{ fontInfo }
+    _desiredFont{ fontInfo },
+    _rowsScrolledSinceFrame{ 0 },
+    _writeDepth{ 0 },
+    _fastForwarding{ false }
 {
     LineChar[0] = UNICODE_BOX_DRAW_LIGHT_DOWN_AND_RIGHT;
     LineChar[1] = UNICODE_BOX_DRAW_LIGHT_DOWN_AND_LEFT;
@@ -796,14 +799,15 @@ NTSTATUS SCREEN_INFORMATION::SetViewportOrigin(const bool fAbsolute,
         return STATUS_INVALID_PARAMETER;
     }
 
-    if (IsActiveScreenBuffer() && ServiceLocator::LocateConsoleWindow() != nullptr)
+    if (IsActiveScreenBuffer() && ServiceLocator::LocateConsoleWindow() != nullptr && !_fastForwarding)
     {
         // Tell the window that it needs to set itself to the new origin if we're the active buffer.
         ServiceLocator::LocateConsoleWindow()->ChangeViewport(NewWindow);
     }
     else
     {
-        // Otherwise, just store the new position and go on.
+        // Otherwise, just store the new position and go on. While
+        // fast-forwarding, the window is told once the write is over.
         _viewport = Viewport::FromInclusive(NewWindow);
         Tracing::s_TraceWindowViewport(_viewport);
     }
@@ -819,6 +823,80 @@ NTSTATUS SCREEN_INFORMATION::SetViewportOrigin(const bool fAbsolute,
     return STATUS_SUCCESS;
 }
 
+// Routine Description:
+// - Marks the start of a write to the buffer. Writes can nest; the outermost
+//   one ends fast-forwarding when it's over.
+void SCREEN_INFORMATION::BeginWrite() noexcept
+{
+    ++_writeDepth;
+}
+
+// Routine Description:
+// - Marks the end of a write to the buffer. If the outermost write fast-forwarded,
+//   catches everyone up: the cursor is redrawn, the window moves to where
+//   the viewport ended up and updates its scroll bars, accessibility hears
+//   about the whole viewport once, and the screen is redrawn.
+void SCREEN_INFORMATION::EndWrite() noexcept
+{
+    --_writeDepth;
+    if (_writeDepth != 0 || !_fastForwarding)
+    {
+        return;
+    }
+
+    _fastForwarding = false;
+    try
+    {
+        _textBuffer->GetCursor().EndDeferDrawing();
+
+        if (IsActiveScreenBuffer())
+        {
+            if (ServiceLocator::LocateConsoleWindow() != nullptr)
+            {
+                ServiceLocator::LocateConsoleWindow()->ChangeViewport(_viewport.ToInclusive());
+            }
+            NotifyAccessibilityEventing(_viewport.Left(), _viewport.Top(), _viewport.RightInclusive(), _viewport.BottomInclusive());
+        }
+        _renderTarget.TriggerRedrawAll();
+    }
+    CATCH_LOG();
+}
+
+// Routine Description:
+// - Checks whether output has scrolled so far since the renderer last drew a
+//   frame that what's being written now will likely scroll out of view before
+//   the next one. If so, starts fast-forwarding: cursor redraws are put off,
+//   and the write path stops notifying about rows and scrolling until the
+//   write is over. The buffer's contents are the same either way.
+// Return Value:
+// - true while fast-forwarding.
+bool SCREEN_INFORMATION::ShouldFastForward()
+{
+    if (!_fastForwarding &&
+        _writeDepth != 0 &&
+        _rowsScrolledSinceFrame > s_fastForwardScreens * _viewport.Height())
+    {
+        _fastForwarding = true;
+        _textBuffer->GetCursor().StartDeferDrawing();
+    }
+    return _fastForwarding;
+}
+
+// Routine Description:
+// - Counts rows that output scrolled the buffer or the viewport by.
+void SCREEN_INFORMATION::CountScrolledRows(const size_t rows) noexcept
+{
+    _rowsScrolledSinceFrame += rows;
+}
+
+// Routine Description:
+// - Called by the renderer at the start of every frame, which is what ends a
+//   flood of output as far as fast-forwarding is concerned.
+void SCREEN_INFORMATION::NotifyFrameStarted() noexcept
+{
+    _rowsScrolledSinceFrame = 0;
+}
+
 bool SCREEN_INFORMATION::SendNotifyBeep() const
 {
     if (IsActiveScreenBuffer())
@@ -1392,6 +1470,8 @@ bool SCREEN_INFORMATION::IsMaximizedY() const
 // Routine Description:
 // - This is a screen resize algorithm which will reflow the ends of lines based on the
 //   line wrap state used for clipboard line-based copy.
+// - The text buffer is rewrapped in place, reusing its rows, rather than copied
+//   into a second buffer. See TextBuffer::ResizeWithReflow.
 // Arguments:
 // - <in> Coordinates of the new screen size
 // Return Value:
@@ -1405,241 +1485,29 @@ NTSTATUS SCREEN_INFORMATION::ResizeWithReflow(const COORD coordNewScreenSize)
         return STATUS_INVALID_PARAMETER;
     }
 
-    // First allocate a new text buffer to take the place of the current one.
-    std::unique_ptr<TextBuffer> newTextBuffer;
-    try
-    {
-        newTextBuffer = std::make_unique<TextBuffer>(coordNewScreenSize,
-                                                     GetAttributes(),
-                                                     0,
-                                                     _renderTarget); // temporarily set size to 0 so it won't render.
-    }
-    catch (...)
-    {
-        return NTSTATUS_FROM_HRESULT(wil::ResultFromCaughtException());
-    }
+    Cursor& cursor = _textBuffer->GetCursor();
 
     // Save cursor's relative height versus the viewport
-    SHORT const sCursorHeightInViewportBefore = _textBuffer->GetCursor().GetPosition().Y - _viewport.Top();
-
-    Cursor& oldCursor = _textBuffer->GetCursor();
-    Cursor& newCursor = newTextBuffer->GetCursor();
-    // skip any drawing updates that might occur as we manipulate the new buffer
-    oldCursor.StartDeferDrawing();
-    newCursor.StartDeferDrawing();
-
-    // We need to save the old cursor position so that we can
-    // place the new cursor back on the equivalent character in
-    // the new buffer.
-    COORD cOldCursorPos = oldCursor.GetPosition();
-    COORD cOldLastChar = _textBuffer->GetLastNonSpaceCharacter();
+    SHORT const sCursorHeightInViewportBefore = cursor.GetPosition().Y - _viewport.Top();
 
-    short const cOldRowsTotal = cOldLastChar.Y + 1;
-    short const cOldColsTotal = GetBufferSize().Width();
-
-    COORD cNewCursorPos = { 0 };
-    bool fFoundCursorPos = false;
-
-    NTSTATUS status = STATUS_SUCCESS;
-    // Loop through all the rows of the old buffer and reprint them into the new buffer
-    for (short iOldRow = 0; iOldRow < cOldRowsTotal; iOldRow++)
-    {
-        // Fetch the row and its "right" which is the last printable character.
-        const ROW& Row = _textBuffer->GetRowByOffset(iOldRow);
-        const CharRow& charRow = Row.GetCharRow();
-        short iRight = static_cast<short>(charRow.MeasureRight());
-
-        // There is a special case here. If the row has a "wrap"
-        // flag on it, but the right isn't equal to the width (one
-        // index past the final valid index in the row) then there
-        // were a bunch trailing of spaces in the row.
-        // (But the measuring functions for each row Left/Right do
-        // not count spaces as "displayable" so they're not
-        // included.)
-        // As such, adjust the "right" to be the width of the row
-        // to capture all these spaces
-        if (charRow.WasWrapForced())
-        {
-            iRight = cOldColsTotal;
-
-            // And a combined special case.
-            // If we wrapped off the end of the row by adding a
-            // piece of padding because of a double byte LEADING
-            // character, then remove one from the "right" to
-            // leave this padding out of the copy process.
-            if (charRow.WasDoubleBytePadded())
-            {
-                iRight--;
-            }
-        }
+    // skip any drawing updates that might occur as we manipulate the buffer
+    cursor.StartDeferDrawing();
+    auto endDefer = wil::scope_exit([&] { cursor.EndDeferDrawing(); });
 
-        // Loop through every character in the current row (up to
-        // the "right" boundary, which is one past the final valid
-        // character)
-        for (short iOldCol = 0; iOldCol < iRight; iOldCol++)
-        {
-            if (iOldCol == cOldCursorPos.X && iOldRow == cOldCursorPos.Y)
-            {
-                cNewCursorPos = newCursor.GetPosition();
-                fFoundCursorPos = true;
-            }
-
-            try
-            {
-                // TODO: MSFT: 19446208 - this should just use an iterator and the inserter...
-                const auto glyph = Row.GetCharRow().GlyphAt(iOldCol);
-                const auto dbcsAttr = Row.GetCharRow().DbcsAttrAt(iOldCol);
-                const auto textAttr = Row.GetAttrRow().GetAttrByColumn(iOldCol);
-
-                if (!newTextBuffer->InsertCharacter(glyph, dbcsAttr, textAttr))
-                {
-                    status = STATUS_NO_MEMORY;
-                    break;
-                }
-            }
-            catch (...)
-            {
-                return NTSTATUS_FROM_HRESULT(wil::ResultFromCaughtException());
-            }
-        }
-        if (NT_SUCCESS(status))
-        {
-            // If we didn't have a full row to copy, insert a new
-            // line into the new buffer.
-            // Only do so if we were not forced to wrap. If we did
-            // force a word wrap, then the existing line break was
-            // only because we ran out of space.
-            if (iRight < cOldColsTotal && !charRow.WasWrapForced())
-            {
-                if (iRight == cOldCursorPos.X && iOldRow == cOldCursorPos.Y)
-                {
-                    cNewCursorPos = newCursor.GetPosition();
-                    fFoundCursorPos = true;
-                }
-                // Only do this if it's not the final line in the buffer.
-                // On the final line, we want the cursor to sit
-                // where it is done printing for the cursor
-                // adjustment to follow.
-                if (iOldRow < cOldRowsTotal - 1)
-                {
-                    status = newTextBuffer->NewlineCursor() ? status : STATUS_NO_MEMORY;
-                }
-                else
-                {
-                    // If we are on the final line of the buffer, we have one more check.
-                    // We got into this code path because we are at the right most column of a row in the old buffer
-                    // that had a hard return (no wrap was forced).
-                    // However, as we're inserting, the old row might have just barely fit into the new buffer and
-                    // caused a new soft return (wrap was forced) putting the cursor at x=0 on the line just below.
-                    // We need to preserve the memory of the hard return at this point by inserting one additional
-                    // hard newline, otherwise we've lost that information.
-                    // We only do this when the cursor has just barely poured over onto the next line so the hard return
-                    // isn't covered by the soft one.
-                    // e.g.
-                    // The old line was:
-                    // |aaaaaaaaaaaaaaaaaaa | with no wrap which means there was a newline after that final a.
-                    // The cursor was here ^
-                    // And the new line will be:
-                    // |aaaaaaaaaaaaaaaaaaa| and show a wrap at the end
-                    // |                   |
-                    //  ^ and the cursor is now there.
-                    // If we leave it like this, we've lost the newline information.
-                    // So we insert one more newline so a continued reflow of this buffer by resizing larger will
-                    // continue to look as the original output intended with the newline data.
-                    // After this fix, it looks like this:
-                    // |aaaaaaaaaaaaaaaaaaa| no wrap at the end (preserved hard newline)
-                    // |                   |
-                    //  ^ and the cursor is now here.
-                    const COORD coordNewCursor = newCursor.GetPosition();
-                    if (coordNewCursor.X == 0 && coordNewCursor.Y > 0)
-                    {
-                        if (newTextBuffer->GetRowByOffset(coordNewCursor.Y - 1).GetCharRow().WasWrapForced())
-                        {
-                            status = newTextBuffer->NewlineCursor() ? status : STATUS_NO_MEMORY;
-                        }
-                    }
-                }
-            }
-        }
-    }
-    if (NT_SUCCESS(status))
+    // If this fails, the buffer is left at its old size and the viewport still fits it.
+    const NTSTATUS status = NTSTATUS_FROM_HRESULT(_textBuffer->ResizeWithReflow(coordNewScreenSize));
+    if (!NT_SUCCESS(status))
     {
-        // Finish copying remaining parameters from the old text buffer to the new one
-        newTextBuffer->CopyProperties(*_textBuffer);
-
-        // If we found where to put the cursor while placing characters into the buffer,
-        //   just put the cursor there. Otherwise we have to advance manually.
-        if (fFoundCursorPos)
-        {
-            newCursor.SetPosition(cNewCursorPos);
-        }
-        else
-        {
-            // Advance the cursor to the same offset as before
-            // get the number of newlines and spaces between the old end of text and the old cursor,
-            //   then advance that many newlines and chars
-            int iNewlines = cOldCursorPos.Y - cOldLastChar.Y;
-            int iIncrements = cOldCursorPos.X - cOldLastChar.X;
-            const COORD cNewLastChar = newTextBuffer->GetLastNonSpaceCharacter();
-
-            // If the last row of the new buffer wrapped, there's going to be one less newline needed,
-            //   because the cursor is already on the next line
-            if (newTextBuffer->GetRowByOffset(cNewLastChar.Y).GetCharRow().WasWrapForced())
-            {
-                iNewlines = std::max(iNewlines - 1, 0);
-            }
-            else
-            {
-                // if this buffer didn't wrap, but the old one DID, then the d(columns) of the
-                //   old buffer will be one more than in this buffer, so new need one LESS.
-                if (_textBuffer->GetRowByOffset(cOldLastChar.Y).GetCharRow().WasWrapForced())
-                {
-                    iNewlines = std::max(iNewlines - 1, 0);
-                }
-            }
-
-            for (int r = 0; r < iNewlines; r++)
-            {
-                if (!newTextBuffer->NewlineCursor())
-                {
-                    status = STATUS_NO_MEMORY;
-                    break;
-                }
-            }
-            if (NT_SUCCESS(status))
-            {
-                for (int c = 0; c < iIncrements - 1; c++)
-                {
-                    if (!newTextBuffer->IncrementCursor())
-                    {
-                        status = STATUS_NO_MEMORY;
-                        break;
-                    }
-                }
-            }
-        }
+        return status;
     }
 
-    if (NT_SUCCESS(status))
-    {
-        // Adjust the viewport so the cursor doesn't wildly fly off up or down.
-        SHORT const sCursorHeightInViewportAfter = newCursor.GetPosition().Y - _viewport.Top();
-        COORD coordCursorHeightDiff = { 0 };
-        coordCursorHeightDiff.Y = sCursorHeightInViewportAfter - sCursorHeightInViewportBefore;
-        LOG_IF_FAILED(SetViewportOrigin(false, coordCursorHeightDiff, true));
+    // Adjust the viewport so the cursor doesn't wildly fly off up or down.
+    SHORT const sCursorHeightInViewportAfter = cursor.GetPosition().Y - _viewport.Top();
+    COORD coordCursorHeightDiff = { 0 };
+    coordCursorHeightDiff.Y = sCursorHeightInViewportAfter - sCursorHeightInViewportBefore;
+    LOG_IF_FAILED(SetViewportOrigin(false, coordCursorHeightDiff, true));
 
-        // Save old cursor size before we delete it
-        ULONG const ulSize = oldCursor.GetSize();
-
-        _textBuffer.swap(newTextBuffer);
-
-        // Set size back to real size as it will be taking over the rendering duties.
-        newCursor.SetSize(ulSize);
-        newCursor.EndDeferDrawing();
-    }
-    oldCursor.EndDeferDrawing();
-
-    return status;
+    return STATUS_SUCCESS;
 }
 
 //
@@ -118,6 +118,12 @@ public:
     [[nodiscard]]
     NTSTATUS SetViewportOrigin(const bool fAbsolute, const COORD coordWindowOrigin, const bool updateBottom);
 
+    void BeginWrite() noexcept;
+    void EndWrite() noexcept;
+    bool ShouldFastForward();
+    void CountScrolledRows(const size_t rows) noexcept;
+    void NotifyFrameStarted() noexcept;
+
     bool SendNotifyBeep() const;
     bool PostUpdateWindowSize() const;
 
@@ -323,6 +329,16 @@ private:
 
     ScreenBufferRenderTarget _renderTarget;
 
+    // Fast-forward: once output scrolls more than this many screens between
+    // two frames, rows are written without telling the renderer, the window
+    // or accessibility about each one. They're caught up at the end of the
+    // write. See ShouldFastForward.
+    static constexpr size_t s_fastForwardScreens = 3;
+    size_t _rowsScrolledSinceFrame;
+    // the number of writes in progress. Fast-forwarding only happens in one.
+    size_t _writeDepth;
+    bool _fastForwarding;
+
 #ifdef UNIT_TESTING
     friend class TextBufferIteratorTests;
     friend class ScreenBufferTests;
@@ -6,9 +6,6 @@
 #include "search.h"
 
 #include "dbcs.h"
-#include "../buffer/out/CharRow.hpp"
-#include "../types/inc/Utf16Parser.hpp"
-#include "../types/inc/GlyphWidth.hpp"
 
 // Routine Description:
 // - Constructs a Search object.
@@ -26,7 +23,7 @@ Search::Search(const SCREEN_INFORMATION& screenInfo,
     _direction(direction),
     _sensitivity(sensitivity),
     _screenInfo(screenInfo),
-    _needle(s_CreateNeedleFromString(str)),
+    _searcher(screenInfo.GetTextBuffer(), str, sensitivity == Sensitivity::CaseInsensitive),
     _coordAnchor(s_GetInitialAnchor(screenInfo, direction))
 {
     _coordNext = _coordAnchor;
@@ -50,7 +47,7 @@ Search::Search(const SCREEN_INFORMATION& screenInfo,
     _direction(direction),
     _sensitivity(sensitivity),
     _screenInfo(screenInfo),
-    _needle(s_CreateNeedleFromString(str)),
+    _searcher(screenInfo.GetTextBuffer(), str, sensitivity == Sensitivity::CaseInsensitive),
     _coordAnchor(anchor)
 {
     _coordNext = _coordAnchor;
@@ -71,21 +68,22 @@ bool Search::FindNext()
         return false;
     }
 
-    do
+    const auto remaining = _PositionsRemaining();
+    const auto found = _direction == Direction::Forward ?
+                       _searcher.FindForward(_coordNext, remaining) :
+                       _searcher.FindBackward(_coordNext, remaining);
+    if (found)
     {
-        if (_FindNeedleInHaystackAt(_coordNext, _coordSelStart, _coordSelEnd))
-        {
-            _UpdateNextPosition();
-            _reachedEnd = _coordNext == _coordAnchor;
-            return true;
-        }
-        else
-        {
-            _UpdateNextPosition();
-        }
-
-    } while (_coordNext != _coordAnchor);
+        _coordSelStart = found->first;
+        _coordSelEnd = found->second;
+        _coordNext = _coordSelStart;
+        _UpdateNextPosition();
+        _reachedEnd = _coordNext == _coordAnchor;
+        return true;
+    }
 
+    // Everything up to the anchor has been tried.
+    _coordNext = _coordAnchor;
     return false;
 }
 
@@ -164,91 +162,23 @@ COORD Search::s_GetInitialAnchor(const SCREEN_INFORMATION& screenInfo, const Dir
 }
 
 // Routine Description:
-// - Attempts to compare the search term (the needle) to the screen buffer (the haystack)
-//   at the given coordinate position of the screen buffer.
-// - Performs one comparison. Call again with new positions to check other spots.
-// Arguments:
-// - pos - The position in the haystack (screen buffer) to compare
-// - start - If we found it, this is filled with the coordinate of the first character of the needle.
-// - end - If we found it, this is filled with the coordinate of the last character of the needle.
-// Return Value:
-// - True if we found it. False if not.
-bool Search::_FindNeedleInHaystackAt(const COORD pos, COORD& start, COORD& end) const
-{
-    start = { 0 };
-    end = { 0 };
-
-    COORD bufferPos = pos;
-
-    for (const auto& needleCell : _needle)
-    {
-        // Haystack is the buffer. Needle is the string we were given.
-        const auto hayIter = _screenInfo.GetTextDataAt(bufferPos);
-        const auto hayChars = *hayIter;
-        const auto needleChars = std::wstring_view(needleCell.data(), needleCell.size());
-
-        // If we didn't match at any point of the needle, return false.
-        if (!_CompareChars(hayChars, needleChars))
-        {
-            return false;
-        }
-
-        _IncrementCoord(bufferPos);
-    }
-
-    _DecrementCoord(bufferPos);
-
-    // If we made it the whole way through the needle, then it was in the haystack.
-    // Fill out the span that we found the result at and return true.
-    start = pos;
-    end = bufferPos;
-
-    return true;
-}
-
-// Routine Description:
-// - Provides an abstraction for comparing two spans of text.
-// - Internally handles case sensitivity based on object construction.
-// Arguments:
-// - one - String view representing the first string of text
-// - two - String view representing the second string of text
-// Return Value:
-// - True if they are the same. False otherwise.
-bool Search::_CompareChars(const std::wstring_view one, const std::wstring_view two) const
-{
-    if (one.size() != two.size())
-    {
-        return false;
-    }
-
-    for (size_t i = 0; i < one.size(); i++)
-    {
-        if (_ApplySensitivity(one[i]) != _ApplySensitivity(two[i]))
-        {
-            return false;
-        }
-    }
-
-    return true;
-}
-
-// Routine Description:
-// - Provides an abstraction for conditionally applying case sensitivity
-//   based on object construction
-// Arguments:
-// - wch - Character to adjust if necessary
+// - Counts the positions a match could still start at: everything from
+//   _coordNext up to, but not including, the anchor in the direction of the
+//   search. When they're the same place, that's the whole buffer.
 // Return Value:
-// - Adjusted value (or not).
-wchar_t Search::_ApplySensitivity(const wchar_t wch) const
+// - The number of positions left to try.
+size_t Search::_PositionsRemaining() const
 {
-    if (_sensitivity == Sensitivity::CaseInsensitive)
-    {
-        return ::towlower(wch);
-    }
-    else
-    {
-        return wch;
-    }
+    const auto bufferSize = _screenInfo.GetBufferSize();
+    const size_t width = bufferSize.Width();
+    const size_t total = width * bufferSize.Height();
+    const size_t next = _coordNext.Y * width + _coordNext.X;
+    const size_t anchor = _coordAnchor.Y * width + _coordAnchor.X;
+
+    const auto remaining = _direction == Direction::Forward ?
+                           (anchor + total - next) % total :
+                           (next + total - anchor) % total;
+    return remaining == 0 ? total : remaining;
 }
 
 // Routine Description:
@@ -288,25 +218,3 @@ void Search::_UpdateNextPosition()
         THROW_HR(E_NOTIMPL);
     }
 }
-
-// Routine Description:
-// - Creates a "needle" of the correct format for comparison to the screen buffer text data
-//   that we can use for our search
-// Arguments:
-// - wstr - String that will be our search term
-// Return Value:
-// - Structured text data for comparison to screen buffer text data.
-std::vector<std::vector<wchar_t>> Search::s_CreateNeedleFromString(const std::wstring& wstr)
-{
-    const auto charData = Utf16Parser::Parse(wstr);
-    std::vector<std::vector<wchar_t>> cells;
-    for (const auto chars : charData)
-    {
-        if (IsGlyphFullWidth(std::wstring_view{ chars.data(), chars.size() }))
-        {
-            cells.emplace_back(chars);
-        }
-        cells.emplace_back(chars);
-    }
-    return cells;
-}
@@ -17,6 +17,8 @@ Revision History:
 
 #pragma once
 
+#include "../buffer/out/textBufferSearch.hpp"
+
 // This used to be in find.h.
 #define SEARCH_STRING_LENGTH    (80)
 
@@ -54,16 +56,13 @@ public:
 
 private:
 
-    wchar_t _ApplySensitivity(const wchar_t wch) const;
-    bool Search::_FindNeedleInHaystackAt(const COORD pos, COORD& start, COORD& end) const;
-    bool _CompareChars(const std::wstring_view one, const std::wstring_view two) const;
+    size_t _PositionsRemaining() const;
     void _UpdateNextPosition();
 
     void _IncrementCoord(COORD& coord) const;
     void _DecrementCoord(COORD& coord) const;
 
     static COORD s_GetInitialAnchor(const SCREEN_INFORMATION& screenInfo, const Direction dir);
-    static std::vector<std::vector<wchar_t>> s_CreateNeedleFromString(const std::wstring& wstr);
 
     bool _reachedEnd = false;
     COORD _coordNext = { 0 };
@@ -71,10 +70,10 @@ private:
     COORD _coordSelEnd = { 0 };
 
     const COORD _coordAnchor;
-    const std::vector<std::vector<wchar_t>> _needle;
     const Direction _direction;
     const Sensitivity _sensitivity;
     const SCREEN_INFORMATION& _screenInfo;
+    const TextBufferSearch _searcher;
 
 #ifdef UNIT_TESTING
     friend class SearchTests;
@@ -55,7 +55,8 @@ Settings::Settings() :
     _DefaultForeground(INVALID_COLOR),
     _DefaultBackground(INVALID_COLOR),
     _fUseDx(false),
-    _fCopyColor(false)
+    _fCopyColor(false),
+    _fPersistHistory(false)
 {
     _dwScreenBufferSize.X = 80;
     _dwScreenBufferSize.Y = 25;
@@ -691,6 +692,15 @@ void Settings::SetHistoryNoDup(const bool bHistoryNoDup)
     _bHistoryNoDup = bHistoryNoDup;
 }
 
+bool Settings::GetPersistHistory() const noexcept
+{
+    return _fPersistHistory;
+}
+void Settings::SetPersistHistory(const bool persistHistory) noexcept
+{
+    _fPersistHistory = persistHistory;
+}
+
 const COLORREF* const Settings::GetColorTable() const
 {
     return _ColorTable;
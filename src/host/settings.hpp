@@ -156,6 +156,9 @@ public:
     bool GetHistoryNoDup() const;
     void SetHistoryNoDup(const bool fHistoryNoDup);
 
+    bool GetPersistHistory() const noexcept;
+    void SetPersistHistory(const bool persistHistory) noexcept;
+
     const COLORREF* const GetColorTable() const;
     const size_t GetColorTableSize() const;
     void SetColorTable(_In_reads_(cSize) const COLORREF* const pColorTable, const size_t cSize);
@@ -233,6 +236,7 @@ private:
     bool _fRenderGridWorldwide;
     bool _fUseDx;
     bool _fCopyColor;
+    bool _fPersistHistory; // keep command history on disk between sessions
 
     COLORREF _XtermColorTable[XTERM_COLOR_TABLE_SIZE];
 
@@ -473,6 +473,10 @@ static HRESULT _ReadLineInput(InputBuffer& inputBuffer,
 
     SCREEN_INFORMATION& screenInfo = gci.GetActiveOutputBuffer();
     CommandHistory* const pCommandHistory = CommandHistory::s_Find(processData);
+    if (pCommandHistory)
+    {
+        pCommandHistory->LoadPersistedCommands();
+    }
 
     try
     {
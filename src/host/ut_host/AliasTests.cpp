@@ -7,6 +7,8 @@
 
 #include "alias.h"
 
+#include <chrono>
+
 using namespace WEX::Common;
 using namespace WEX::Logging;
 using namespace WEX::TestExecution;
@@ -45,6 +47,19 @@ class AliasTests
         return linesExpected;
     }
 
+    // Expands a template and takes the CRLF every expansion ends with back off.
+    static std::wstring _ExpandTemplate(const Alias::Template& aliasTemplate,
+                                        const Alias::Tokens& tokens,
+                                        const std::wstring_view allArguments)
+    {
+        std::wstring actual(aliasTemplate.GetExpandedSize(tokens, allArguments), UNICODE_NULL);
+        const auto end = aliasTemplate.Expand(tokens, allArguments, actual.data());
+        VERIFY_ARE_EQUAL(actual.size(), gsl::narrow<size_t>(end - actual.data()));
+
+        Alias::s_TrimTrailingCrLf(actual);
+        return actual;
+    }
+
     void _RetrieveTargetExpectedPair(std::wstring& target,
                                      std::wstring& expected)
     {
@@ -401,13 +416,19 @@ class AliasTests
         tokensExpected.emplace_back(L"two");
         tokensExpected.emplace_back(L"three");
 
-        auto tokensActual = Alias::s_Tokenize(tokenStr);
+        Alias::Tokens tokensActual;
+        const auto countActual = Alias::s_Tokenize(tokenStr, tokensActual);
 
-        VERIFY_ARE_EQUAL(tokensExpected.size(), tokensActual.size());
+        VERIFY_ARE_EQUAL(tokensExpected.size(), countActual);
 
         for (size_t i = 0; i < tokensExpected.size(); i++)
         {
-            VERIFY_ARE_EQUAL(String(tokensExpected[i].data()), String(tokensActual[i].data()));
+            VERIFY_ARE_EQUAL(String(tokensExpected[i].data()), String(std::wstring(tokensActual[i]).data()));
+        }
+
+        for (size_t i = countActual; i < tokensActual.size(); i++)
+        {
+            VERIFY_IS_TRUE(tokensActual[i].empty());
         }
     }
 
@@ -417,16 +438,29 @@ class AliasTests
         std::deque<std::wstring> tokensExpected;
         tokensExpected.emplace_back(tokenStr);
 
-        auto tokensActual = Alias::s_Tokenize(tokenStr);
+        Alias::Tokens tokensActual;
+        const auto countActual = Alias::s_Tokenize(tokenStr, tokensActual);
 
-        VERIFY_ARE_EQUAL(tokensExpected.size(), tokensActual.size());
+        VERIFY_ARE_EQUAL(tokensExpected.size(), countActual);
 
         for (size_t i = 0; i < tokensExpected.size(); i++)
         {
-            VERIFY_ARE_EQUAL(String(tokensExpected[i].data()), String(tokensActual[i].data()));
+            VERIFY_ARE_EQUAL(String(tokensExpected[i].data()), String(std::wstring(tokensActual[i]).data()));
         }
     }
 
+    TEST_METHOD(TokenizeStopsAfterNineArguments)
+    {
+        std::wstring tokenStr(L"alias one two three four five six seven eight nine ten eleven");
+
+        Alias::Tokens tokensActual;
+        const auto countActual = Alias::s_Tokenize(tokenStr, tokensActual);
+
+        VERIFY_ARE_EQUAL(tokensActual.size(), countActual);
+        VERIFY_ARE_EQUAL(String(L"alias"), String(std::wstring(tokensActual.front()).data()));
+        VERIFY_ARE_EQUAL(String(L"nine"), String(std::wstring(tokensActual.back()).data()));
+    }
+
     TEST_METHOD(GetArgString)
     {
         BEGIN_TEST_METHOD_PROPERTIES()
@@ -440,7 +474,7 @@ class AliasTests
         std::wstring expected;
         _RetrieveTargetExpectedPair(target, expected);
 
-        std::wstring actual = Alias::s_GetArgString(target);
+        std::wstring actual{ Alias::s_GetArgString(target) };
 
         VERIFY_ARE_EQUAL(String(expected.data()), String(actual.data()));
     }
@@ -458,8 +492,8 @@ class AliasTests
                                  L"7=seven,"
                                  L"8=eight,"
                                  L"9=nine,"
-                                 L"A=,"
-                                 L"0=,"
+                                 L"A=$A," // not an argument macro, so it's copied through
+                                 L"0=$0,"
                                  L"}")
         END_TEST_METHOD_PROPERTIES()
 
@@ -467,26 +501,12 @@ class AliasTests
         std::wstring expected;
         _RetrieveTargetExpectedPair(target, expected);
 
-        std::deque<std::wstring> tokens;
-        tokens.emplace_back(L"alias");
-        tokens.emplace_back(L"one");
-        tokens.emplace_back(L"two");
-        tokens.emplace_back(L"three");
-        tokens.emplace_back(L"four");
-        tokens.emplace_back(L"five");
-        tokens.emplace_back(L"six");
-        tokens.emplace_back(L"seven");
-        tokens.emplace_back(L"eight");
-        tokens.emplace_back(L"nine");
-        tokens.emplace_back(L"ten");
+        std::wstring line(L"alias one two three four five six seven eight nine ten");
+        Alias::Tokens tokens;
+        Alias::s_Tokenize(line, tokens);
 
-        // if we expect non-empty results, then we should get a bool back saying it was processed
-        const bool returnExpected = !expected.empty();
-
-        std::wstring actual;
-        const bool returnActual = Alias::s_TryReplaceNumberedArgMacro(target[0], actual, tokens);
+        const auto actual = _ExpandTemplate(Alias::Template{ L"$" + target }, tokens, Alias::s_GetArgString(line));
 
-        VERIFY_ARE_EQUAL(returnExpected, returnActual);
         VERIFY_ARE_EQUAL(String(expected.data()), String(actual.data()));
     }
 
@@ -495,8 +515,8 @@ class AliasTests
         BEGIN_TEST_METHOD_PROPERTIES()
             TEST_METHOD_PROPERTY(L"Data:targetExpectedPair", L"{"
                                  L"*=one two three,"
-                                 L"A=,"
-                                 L"0=,"
+                                 L"A=$A,"
+                                 L"0=$0,"
                                  L"}")
         END_TEST_METHOD_PROPERTIES()
 
@@ -504,18 +524,96 @@ class AliasTests
         std::wstring expected;
         _RetrieveTargetExpectedPair(target, expected);
 
-        std::wstring fullArgString(L"one two three");
+        std::wstring line(L"alias one two three");
+        Alias::Tokens tokens;
+        Alias::s_Tokenize(line, tokens);
 
-        // if we expect non-empty results, then we should get a bool back saying it was processed
-        const bool returnExpected = !expected.empty();
-
-        std::wstring actual;
-        const bool returnActual = Alias::s_TryReplaceWildcardArgMacro(target[0], actual, fullArgString);
+        const auto actual = _ExpandTemplate(Alias::Template{ L"$" + target }, tokens, Alias::s_GetArgString(line));
 
-        VERIFY_ARE_EQUAL(returnExpected, returnActual);
         VERIFY_ARE_EQUAL(String(expected.data()), String(actual.data()));
     }
 
+    TEST_METHOD(TemplateCountsLines)
+    {
+        const Alias::Template aliasTemplate(L"one$ttwo$Tthree $1");
+
+        Alias::Tokens tokens;
+        tokens.fill({});
+
+        VERIFY_ARE_EQUAL(3u, aliasTemplate.GetLineCount());
+        VERIFY_ARE_EQUAL(String(L"one$ttwo$Tthree $1"), String(aliasTemplate.GetTarget().data()));
+        VERIFY_ARE_EQUAL(String(L"one\r\ntwo\r\nthree "), String(_ExpandTemplate(aliasTemplate, tokens, {}).data()));
+    }
+
+    TEST_METHOD(TestMatchAndCopyIgnoresCase)
+    {
+        std::wstring exe(L"Test.EXE");
+        std::wstring alias(L"FoO");
+        std::wstring target(L"bar $1");
+
+        Alias::s_TestAddAlias(exe, alias, target);
+
+        size_t linesActual = 0;
+        const auto actual = Alias::s_MatchAndCopyAlias(L"fOo One", L"tEST.exe", linesActual);
+
+        VERIFY_ARE_EQUAL(String(L"bar One\r\n"), String(actual.data()));
+        VERIFY_ARE_EQUAL(1u, linesActual);
+    }
+
+    TEST_METHOD(ExpandWithManyAliasesPerf)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD_PROPERTIES()
+
+        // Shells commonly carry a few hundred doskey macros.
+        constexpr size_t aliasCount = 500;
+        constexpr size_t lineCount = 100000;
+
+        std::wstring exe(L"cmd.exe");
+        for (size_t i = 0; i < aliasCount; ++i)
+        {
+            std::wstring alias(L"Macro" + std::to_wstring(i));
+            std::wstring target(L"git log --oneline $1 $2$gout" + std::to_wstring(i) + L".txt$tcd $*");
+            Alias::s_TestAddAlias(exe, alias, target);
+        }
+
+        std::vector<std::wstring> lines;
+        for (size_t i = 0; i < aliasCount; ++i)
+        {
+            lines.emplace_back(L"macro" + std::to_wstring(i) + L" -n 20 origin/main\r\n");
+        }
+
+        wchar_t buffer[512];
+        size_t expanded = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < lineCount; ++i)
+        {
+            const auto& line = lines[i % lines.size()];
+            wcscpy_s(buffer, line.c_str());
+
+            size_t cbWritten = 0;
+            DWORD linesWritten = 0;
+            Alias::s_MatchAndCopyAliasLegacy(buffer,
+                                             line.size() * sizeof(wchar_t),
+                                             buffer,
+                                             sizeof(buffer),
+                                             cbWritten,
+                                             exe,
+                                             linesWritten);
+            expanded += linesWritten == 2 ? 1 : 0;
+        }
+        const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start);
+
+        VERIFY_ARE_EQUAL(lineCount, expanded);
+
+        Log::Comment(NoThrowString().Format(L"%zu lines against %zu aliases: %.3f us per line",
+                                            lineCount,
+                                            aliasCount,
+                                            elapsed.count() / lineCount));
+    }
+
     TEST_METHOD(InputRedirMacro)
     {
         BEGIN_TEST_METHOD_PROPERTIES()
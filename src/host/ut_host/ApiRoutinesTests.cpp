@@ -14,6 +14,8 @@
 
 #include "..\interactivity\inc\ServiceLocator.hpp"
 
+#include <chrono>
+
 using namespace Microsoft::Console::Types;
 using namespace WEX::Logging;
 using namespace WEX::TestExecution;
@@ -471,6 +473,184 @@ class ApiRoutinesTests
         }
     }
 
+    TEST_METHOD(ApiWriteConsoleWWrapsPlainText)
+    {
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        SCREEN_INFORMATION& si = gci.GetActiveOutputBuffer();
+        auto& textBuffer = si.GetTextBuffer();
+
+        gci.LockConsole();
+        auto Unlock = wil::scope_exit([&] { gci.UnlockConsole(); });
+
+        VERIFY_SUCCEEDED(si.ResizeScreenBuffer({ 10, 5 }, false));
+        textBuffer.GetCursor().SetPosition({ 0, 0 });
+
+        // A run of plain text that's longer than a row, one that isn't, a wide
+        // character in the middle of a run, and a tab in between runs.
+        const std::wstring testText(L"0123456789abcde\r\nxy\x3042z\r\nab\tc");
+
+        size_t cchRead = 0;
+        std::unique_ptr<IWaitRoutine> waiter;
+        VERIFY_SUCCEEDED(_pApiRoutines->WriteConsoleWImpl(si, testText, cchRead, waiter));
+        VERIFY_ARE_EQUAL(testText.size(), cchRead);
+
+        VERIFY_ARE_EQUAL(String(L"0123456789"), String(textBuffer.GetRowByOffset(0).GetText().c_str()));
+        VERIFY_IS_TRUE(textBuffer.GetRowByOffset(0).GetCharRow().WasWrapForced());
+        VERIFY_ARE_EQUAL(String(L"abcde     "), String(textBuffer.GetRowByOffset(1).GetText().c_str()));
+        VERIFY_IS_FALSE(textBuffer.GetRowByOffset(1).GetCharRow().WasWrapForced());
+        VERIFY_ARE_EQUAL(String(L"xy\x3042z     "), String(textBuffer.GetRowByOffset(2).GetText().c_str()));
+        VERIFY_ARE_EQUAL(String(L"ab      c "), String(textBuffer.GetRowByOffset(3).GetText().c_str()));
+
+        const COORD cursorExpected{ 9, 3 };
+        VERIFY_ARE_EQUAL(cursorExpected, textBuffer.GetCursor().GetPosition());
+    }
+
+    TEST_METHOD(ApiWriteConsoleWPerf)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD_PROPERTIES()
+
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        SCREEN_INFORMATION& si = gci.GetActiveOutputBuffer();
+
+        gci.LockConsole();
+        auto Unlock = wil::scope_exit([&] { gci.UnlockConsole(); });
+
+        // About 4M characters per case, handed over the way a C runtime flushes its buffer.
+        const size_t totalChars = 4 * 1024 * 1024;
+        const size_t chunkChars = 4096;
+
+        for (const SHORT width : { 80, 120, 240 })
+        {
+            VERIFY_SUCCEEDED(si.ResizeScreenBuffer({ width, 9001 }, false));
+
+            for (const size_t lineLength : { 10, 80, 200, 1000 })
+            {
+                std::wstring line;
+                for (size_t i = 0; i < lineLength; ++i)
+                {
+                    line.push_back(static_cast<wchar_t>(L'!' + i % 94));
+                }
+                line += L"\r\n";
+
+                std::wstring text;
+                while (text.size() < totalChars)
+                {
+                    text += line;
+                }
+
+                const auto before = std::chrono::steady_clock::now();
+                for (size_t offset = 0; offset < text.size(); offset += chunkChars)
+                {
+                    const auto chunk = std::wstring_view(text).substr(offset, chunkChars);
+
+                    size_t cchRead = 0;
+                    std::unique_ptr<IWaitRoutine> waiter;
+                    VERIFY_SUCCEEDED(_pApiRoutines->WriteConsoleWImpl(si, chunk, cchRead, waiter));
+                }
+                const auto delta = std::chrono::duration<double>(std::chrono::steady_clock::now() - before).count();
+
+                Log::Comment(NoThrowString().Format(L"width %d, lines of %zu: %.1f M chars/s",
+                                                    width,
+                                                    lineLength,
+                                                    text.size() / delta / 1000000));
+            }
+        }
+    }
+
+    TEST_METHOD(ApiWriteReadConsoleOutputWClipped)
+    {
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        SCREEN_INFORMATION& si = gci.GetActiveOutputBuffer();
+
+        VERIFY_SUCCEEDED(si.ResizeScreenBuffer({ 20, 10 }, false));
+
+        // Four cells of one color, then four of another, and so on.
+        const COORD size{ 10, 3 };
+        std::vector<CHAR_INFO> source(size.X * size.Y);
+        for (size_t i = 0; i < source.size(); ++i)
+        {
+            source[i].Char.UnicodeChar = static_cast<wchar_t>(L'a' + i % 26);
+            source[i].Attributes = (i / 4) % 2 ? FOREGROUND_RED | BACKGROUND_BLUE : FOREGROUND_GREEN;
+        }
+
+        // Hangs off the right and bottom of the buffer.
+        const auto request = Viewport::FromDimensions({ 15, 8 }, size);
+        const SMALL_RECT clipped{ 15, 8, 19, 9 };
+
+        Viewport written;
+        VERIFY_SUCCEEDED(_pApiRoutines->WriteConsoleOutputWImpl(si, source, request, written));
+        VERIFY_ARE_EQUAL(clipped, written.ToInclusive());
+
+        CHAR_INFO untouched;
+        untouched.Char.UnicodeChar = L'#';
+        untouched.Attributes = BACKGROUND_INTENSITY;
+        std::vector<CHAR_INFO> target(source.size(), untouched);
+
+        Viewport read;
+        VERIFY_SUCCEEDED(_pApiRoutines->ReadConsoleOutputWImpl(si, target, request, read));
+        VERIFY_ARE_EQUAL(clipped, read.ToInclusive());
+
+        for (SHORT y = 0; y < size.Y; ++y)
+        {
+            for (SHORT x = 0; x < size.X; ++x)
+            {
+                const auto i = y * size.X + x;
+                VERIFY_ARE_EQUAL(x < 5 && y < 2 ? source[i] : untouched, target[i]);
+            }
+        }
+    }
+
+    TEST_METHOD(ApiWriteReadConsoleOutputWPerf)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD_PROPERTIES()
+
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        SCREEN_INFORMATION& si = gci.GetActiveOutputBuffer();
+
+        const size_t frames = 1000;
+
+        for (const COORD size : { COORD{ 80, 25 }, COORD{ 120, 30 }, COORD{ 240, 80 } })
+        {
+            VERIFY_SUCCEEDED(si.ResizeScreenBuffer(size, false));
+
+            // A frame the way a full-screen UI draws it: text in a handful of colors.
+            std::vector<CHAR_INFO> frame(size.X * size.Y);
+            for (size_t i = 0; i < frame.size(); ++i)
+            {
+                frame[i].Char.UnicodeChar = static_cast<wchar_t>(L'!' + i % 94);
+                frame[i].Attributes = static_cast<WORD>(((i / 7) % 15) + 1) | BACKGROUND_BLUE;
+            }
+            std::vector<CHAR_INFO> readBack(frame.size());
+
+            const auto screen = Viewport::FromDimensions({ 0, 0 }, size);
+            Viewport rect;
+
+            const auto beforeWrite = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < frames; ++i)
+            {
+                VERIFY_SUCCEEDED(_pApiRoutines->WriteConsoleOutputWImpl(si, frame, screen, rect));
+            }
+            const auto writeDelta = std::chrono::duration<double>(std::chrono::steady_clock::now() - beforeWrite).count();
+
+            const auto beforeRead = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < frames; ++i)
+            {
+                VERIFY_SUCCEEDED(_pApiRoutines->ReadConsoleOutputWImpl(si, readBack, screen, rect));
+            }
+            const auto readDelta = std::chrono::duration<double>(std::chrono::steady_clock::now() - beforeRead).count();
+
+            Log::Comment(NoThrowString().Format(L"%dx%d: %.0f writes/s, %.0f reads/s",
+                                                size.X,
+                                                size.Y,
+                                                frames / writeDelta,
+                                                frames / readDelta));
+        }
+    }
+
     void ValidateScreen(SCREEN_INFORMATION& si,
                         const CHAR_INFO background,
                         const CHAR_INFO fill,
@@ -12,6 +12,8 @@
 
 #include "input.h"
 
+#include <chrono>
+
 using namespace WEX::Common;
 using namespace WEX::Logging;
 using namespace WEX::TestExecution;
@@ -62,6 +64,7 @@ namespace WEX {
 
 class AttrRowTests
 {
+    TextAttributeTable _attributes;
     ATTR_ROW* pSingle;
     ATTR_ROW* pChain;
 
@@ -79,9 +82,24 @@ class AttrRowTests
 
     TEST_CLASS(AttrRowTests);
 
+    // Routine Description:
+    // - Expands the interned runs of a row back into attribute runs.
+    std::vector<TextAttributeRun> Runs(const ATTR_ROW& row)
+    {
+        std::vector<TextAttributeRun> runs;
+        size_t start = 0;
+        for (const auto& run : row._list)
+        {
+            runs.emplace_back(run.end - start, row._attributes->Get(run.id));
+            start = run.end;
+        }
+        return runs;
+    }
+
     TEST_METHOD_SETUP(MethodSetup)
     {
-        pSingle = new ATTR_ROW(_sDefaultLength, _DefaultAttr);
+        _attributes = TextAttributeTable{};
+        pSingle = new ATTR_ROW(_sDefaultLength, _DefaultAttr, _attributes);
 
         // Segment length is the expected length divided by the row length
         // E.g. row of 80, 4 segments, 20 segment length each
@@ -101,13 +119,14 @@ class AttrRowTests
         }
 
         // Create the chain
-        pChain = new ATTR_ROW(_sDefaultLength, _DefaultAttr);
-        pChain->_list.resize(sChainSegmentsNeeded);
+        pChain = new ATTR_ROW(_sDefaultLength, _DefaultAttr, _attributes);
+        std::vector<TextAttributeRun> chain;
+        chain.resize(sChainSegmentsNeeded);
 
         // Attach all chain segments that are even multiples of the row length
         for (short iChain = 0; iChain < _sDefaultChainLength; iChain++)
         {
-            TextAttributeRun* pRun = &pChain->_list[iChain];
+            TextAttributeRun* pRun = &chain[iChain];
 
             pRun->SetAttributesFromLegacy(iChain); // Just use the chain position as the value
             pRun->SetLength(sChainSegLength);
@@ -117,12 +136,14 @@ class AttrRowTests
         {
             // If we had a leftover, then this chain is one longer than we expected (the default length)
             // So use it as the index (because indicies start at 0)
-            TextAttributeRun* pRun = &pChain->_list[_sDefaultChainLength];
+            TextAttributeRun* pRun = &chain[_sDefaultChainLength];
 
             pRun->SetAttributes(_DefaultChainAttr);
             pRun->SetLength(sChainLeftover);
         }
 
+        VERIFY_SUCCEEDED(pChain->InsertAttrRuns({ chain.data(), chain.size() }, 0, _sDefaultLength - 1, _sDefaultLength));
+
         return true;
     }
 
@@ -149,10 +170,11 @@ class AttrRowTests
             ATTR_ROW* pUnderTest = pTestItems[iIndex];
 
             pUnderTest->Reset(attr);
+            const auto runs = Runs(*pUnderTest);
 
-            VERIFY_ARE_EQUAL(pUnderTest->_list.size(), 1u);
-            VERIFY_ARE_EQUAL(pUnderTest->_list[0].GetAttributes(), attr);
-            VERIFY_ARE_EQUAL(pUnderTest->_list[0].GetLength(), (unsigned int)_sDefaultLength);
+            VERIFY_ARE_EQUAL(runs.size(), 1u);
+            VERIFY_ARE_EQUAL(runs[0].GetAttributes(), attr);
+            VERIFY_ARE_EQUAL(runs[0].GetLength(), (unsigned int)_sDefaultLength);
         }
     }
 
@@ -265,16 +287,17 @@ class AttrRowTests
 
         // Set up our "original row" that we are going to try to insert into.
         // This will represent a 10 column run of R3->B5->G2 that we will use for all tests.
-        ATTR_ROW originalRow{ static_cast<UINT>(_sDefaultLength), _DefaultAttr };
-        originalRow._list.resize(3);
-        originalRow._cchRowWidth = 10;
-        originalRow._list[0].SetAttributesFromLegacy('R');
-        originalRow._list[0].SetLength(3);
-        originalRow._list[1].SetAttributesFromLegacy('B');
-        originalRow._list[1].SetLength(5);
-        originalRow._list[2].SetAttributesFromLegacy('G');
-        originalRow._list[2].SetLength(2);
-        LogChain(L"Original: ", originalRow._list);
+        ATTR_ROW originalRow{ 10, _DefaultAttr, _attributes };
+        std::vector<TextAttributeRun> originalRuns;
+        originalRuns.resize(3);
+        originalRuns[0].SetAttributesFromLegacy('R');
+        originalRuns[0].SetLength(3);
+        originalRuns[1].SetAttributesFromLegacy('B');
+        originalRuns[1].SetLength(5);
+        originalRuns[2].SetAttributesFromLegacy('G');
+        originalRuns[2].SetLength(2);
+        VERIFY_SUCCEEDED(originalRow.InsertAttrRuns({ originalRuns.data(), originalRuns.size() }, 0, 9, 10));
+        LogChain(L"Original: ", originalRuns);
 
         // Set up our "insertion run"
         size_t cInsertRow = 1;
@@ -347,17 +370,18 @@ class AttrRowTests
         VERIFY_SUCCEEDED(originalRow.InsertAttrRuns({ insertRow.data(), insertRow.size() }, uiStartPos, uiEndPos, (UINT)originalRow._cchRowWidth));
 
         // Compare and ensure that the expected and actual match.
-        VERIFY_ARE_EQUAL(cPackedRun, originalRow._list.size(), L"Ensure that number of array elements required for RLE are the same.");
+        auto actualRuns = Runs(originalRow);
+        VERIFY_ARE_EQUAL(cPackedRun, actualRuns.size(), L"Ensure that number of array elements required for RLE are the same.");
 
         std::vector<TextAttributeRun> packedRunExpected;
         std::copy_n(packedRun.get(), cPackedRun, std::back_inserter(packedRunExpected));
 
         LogChain(L"Expected: ", packedRunExpected);
-        LogChain(L"Actual: ", originalRow._list);
+        LogChain(L"Actual: ", actualRuns);
 
         for (size_t testIndex = 0; testIndex < cPackedRun; testIndex++)
         {
-            VERIFY_ARE_EQUAL(packedRun[testIndex], originalRow._list[testIndex]);
+            VERIFY_ARE_EQUAL(packedRun[testIndex], actualRuns[testIndex]);
         }
     }
 
@@ -510,37 +534,39 @@ class AttrRowTests
 
         Log::Comment(L"SetAttrToEnd for single color applied to whole string.");
         pSingle->SetAttrToEnd(iTestIndex, TestAttr);
+        const auto singleRuns = Runs(*pSingle);
 
         // Was 1 (single), should now have 2 segments
-        VERIFY_ARE_EQUAL(pSingle->_list.size(), 2u);
+        VERIFY_ARE_EQUAL(singleRuns.size(), 2u);
 
-        VERIFY_ARE_EQUAL(pSingle->_list[0].GetAttributes(), _DefaultAttr);
-        VERIFY_ARE_EQUAL(pSingle->_list[0].GetLength(), (unsigned int)(_sDefaultLength - (_sDefaultLength - iTestIndex)));
+        VERIFY_ARE_EQUAL(singleRuns[0].GetAttributes(), _DefaultAttr);
+        VERIFY_ARE_EQUAL(singleRuns[0].GetLength(), (unsigned int)(_sDefaultLength - (_sDefaultLength - iTestIndex)));
 
-        VERIFY_ARE_EQUAL(pSingle->_list[1].GetAttributes(), TestAttr);
-        VERIFY_ARE_EQUAL(pSingle->_list[1].GetLength(), (unsigned int)(_sDefaultLength - iTestIndex));
+        VERIFY_ARE_EQUAL(singleRuns[1].GetAttributes(), TestAttr);
+        VERIFY_ARE_EQUAL(singleRuns[1].GetLength(), (unsigned int)(_sDefaultLength - iTestIndex));
 
         Log::Comment(L"SetAttrToEnd for existing chain of multiple colors.");
         pChain->SetAttrToEnd(iTestIndex, TestAttr);
+        const auto chainRuns = Runs(*pChain);
 
         // From 7 segments down to 5.
-        VERIFY_ARE_EQUAL(pChain->_list.size(), 5u);
+        VERIFY_ARE_EQUAL(chainRuns.size(), 5u);
 
         // Verify chain colors and lengths
-        VERIFY_ARE_EQUAL(TextAttribute(0), pChain->_list[0].GetAttributes());
-        VERIFY_ARE_EQUAL(pChain->_list[0].GetLength(), (unsigned int)13);
+        VERIFY_ARE_EQUAL(TextAttribute(0), chainRuns[0].GetAttributes());
+        VERIFY_ARE_EQUAL(chainRuns[0].GetLength(), (unsigned int)13);
 
-        VERIFY_ARE_EQUAL(TextAttribute(1), pChain->_list[1].GetAttributes());
-        VERIFY_ARE_EQUAL(pChain->_list[1].GetLength(), (unsigned int)13);
+        VERIFY_ARE_EQUAL(TextAttribute(1), chainRuns[1].GetAttributes());
+        VERIFY_ARE_EQUAL(chainRuns[1].GetLength(), (unsigned int)13);
 
-        VERIFY_ARE_EQUAL(TextAttribute(2), pChain->_list[2].GetAttributes());
-        VERIFY_ARE_EQUAL(pChain->_list[2].GetLength(), (unsigned int)13);
+        VERIFY_ARE_EQUAL(TextAttribute(2), chainRuns[2].GetAttributes());
+        VERIFY_ARE_EQUAL(chainRuns[2].GetLength(), (unsigned int)13);
 
-        VERIFY_ARE_EQUAL(TextAttribute(3), pChain->_list[3].GetAttributes());
-        VERIFY_ARE_EQUAL(pChain->_list[3].GetLength(), (unsigned int)11);
+        VERIFY_ARE_EQUAL(TextAttribute(3), chainRuns[3].GetAttributes());
+        VERIFY_ARE_EQUAL(chainRuns[3].GetLength(), (unsigned int)11);
 
-        VERIFY_ARE_EQUAL(TestAttr, pChain->_list[4].GetAttributes());
-        VERIFY_ARE_EQUAL(pChain->_list[4].GetLength(), (unsigned int)30);
+        VERIFY_ARE_EQUAL(TestAttr, chainRuns[4].GetAttributes());
+        VERIFY_ARE_EQUAL(chainRuns[4].GetLength(), (unsigned int)30);
 
         Log::Comment(L"SECOND: Set index to 0 to test replacing anything with a single");
 
@@ -551,15 +577,16 @@ class AttrRowTests
             ATTR_ROW* pUnderTest = pTestItems[iIndex];
 
             pUnderTest->SetAttrToEnd(0, TestAttr);
+            const auto runs = Runs(*pUnderTest);
 
             // should be down to 1 attribute set from beginning to end of string
-            VERIFY_ARE_EQUAL(pUnderTest->_list.size(), 1u);
+            VERIFY_ARE_EQUAL(runs.size(), 1u);
 
             // singular pair should contain the color
-            VERIFY_ARE_EQUAL(pUnderTest->_list[0].GetAttributes(), TestAttr);
+            VERIFY_ARE_EQUAL(runs[0].GetAttributes(), TestAttr);
 
             // and its length should be the length of the whole string
-            VERIFY_ARE_EQUAL(pUnderTest->_list[0].GetLength(), (unsigned int)_sDefaultLength);
+            VERIFY_ARE_EQUAL(runs[0].GetLength(), (unsigned int)_sDefaultLength);
         }
     }
 
@@ -604,4 +631,325 @@ class AttrRowTests
         state.CleanupGlobalScreenBuffer();
         state.CleanupGlobalFont();
     }
+
+    TEST_METHOD(TestRowsShareInternedAttributes)
+    {
+        Log::Comment(L"The same attribute gets the same id in every row of a table.");
+        const TextAttribute attr{ RGB(12, 34, 56), RGB(65, 43, 21) };
+        pSingle->SetAttrToEnd(10, attr);
+        pChain->SetAttrToEnd(20, attr);
+
+        VERIFY_ARE_EQUAL(pSingle->_list.back().id, pChain->_list.back().id);
+        VERIFY_ARE_EQUAL(attr, pSingle->GetAttrByColumn(_sDefaultLength - 1));
+        VERIFY_ARE_EQUAL(attr, pChain->GetAttrByColumn(_sDefaultLength - 1));
+
+        Log::Comment(L"Different attributes get different ids.");
+        VERIFY_ARE_NOT_EQUAL(pSingle->_list.front().id, pSingle->_list.back().id);
+    }
+
+    TEST_METHOD(TestReplaceAttributes)
+    {
+        const TextAttribute red{ FOREGROUND_RED };
+        const TextAttribute green{ FOREGROUND_GREEN };
+
+        pSingle->SetAttrToEnd(40, red);
+        pChain->SetAttrToEnd(60, red);
+
+        Log::Comment(L"Replacing in the table recolors every row that uses the attribute.");
+        _attributes.Replace(red, green);
+
+        VERIFY_ARE_EQUAL(_DefaultAttr, pSingle->GetAttrByColumn(39));
+        VERIFY_ARE_EQUAL(green, pSingle->GetAttrByColumn(40));
+        VERIFY_ARE_EQUAL(green, pChain->GetAttrByColumn(60));
+
+        Log::Comment(L"Replacing with an attribute that's already interned works too.");
+        _attributes.Replace(green, _DefaultAttr);
+
+        const std::vector<TextAttribute> attrs{ pSingle->cbegin(), pSingle->cend() };
+        for (const auto& attr : attrs)
+        {
+            VERIFY_ARE_EQUAL(_DefaultAttr, attr);
+        }
+
+        Log::Comment(L"New writes of the replaced attribute don't pick up the replacement.");
+        pSingle->SetAttrToEnd(70, red);
+        VERIFY_ARE_EQUAL(red, pSingle->GetAttrByColumn(70));
+        VERIFY_ARE_EQUAL(_DefaultAttr, pSingle->GetAttrByColumn(69));
+    }
+
+    TEST_METHOD(TestCollectUnusedAttributes)
+    {
+        TextAttributeTable table;
+        std::deque<ATTR_ROW> rows;
+        table.SetCollector([&](std::vector<bool>& live) {
+            for (const auto& row : rows)
+            {
+                row.MarkLiveAttributes(live);
+            }
+        });
+
+        for (short i = 0; i < 4; i++)
+        {
+            rows.emplace_back(_sDefaultLength, _DefaultAttr, table);
+        }
+
+        Log::Comment(L"Write more distinct attributes than there are ids. The ones that were overwritten get reused.");
+        const size_t writes = TextAttributeTable::s_initialCollectAt * 3;
+        HRESULT hr = S_OK;
+        for (size_t i = 0; i < writes && SUCCEEDED(hr); i++)
+        {
+            const TextAttributeRun runs[]{
+                { 1, TextAttribute{ RGB(i & 0xff, (i >> 8) & 0xff, (i >> 16) & 0xff), RGB(0, 0, 0) } },
+                { 1, TextAttribute{ RGB(0, 0, 0), RGB(i & 0xff, (i >> 8) & 0xff, (i >> 16) & 0xff) } }
+            };
+            const size_t column = (i * 2) % _sDefaultLength;
+            hr = rows[i % rows.size()].InsertAttrRuns({ runs, ARRAYSIZE(runs) }, column, column + 1, _sDefaultLength);
+        }
+        VERIFY_SUCCEEDED(hr, L"Interning never runs out of ids.");
+
+        Log::Comment(L"Everything the rows still show is intact.");
+        for (size_t i = writes - rows.size() * _sDefaultLength / 2; i < writes; i++)
+        {
+            const size_t column = (i * 2) % _sDefaultLength;
+            const auto& row = rows[i % rows.size()];
+            VERIFY_ARE_EQUAL((TextAttribute{ RGB(i & 0xff, (i >> 8) & 0xff, (i >> 16) & 0xff), RGB(0, 0, 0) }), row.GetAttrByColumn(column));
+            VERIFY_ARE_EQUAL((TextAttribute{ RGB(0, 0, 0), RGB(i & 0xff, (i >> 8) & 0xff, (i >> 16) & 0xff) }), row.GetAttrByColumn(column + 1));
+        }
+        VERIFY_IS_LESS_THAN(table.Size(), TextAttributeTable::s_initialCollectAt);
+        VERIFY_ARE_EQUAL(TextAttributeTable::s_initialCollectAt, table.CollectsAt(), L"Collections that free most ids don't grow the table.");
+    }
+
+    TEST_METHOD(TestTableInUseGrowsAndKeepsColors)
+    {
+        TextAttributeTable table;
+        size_t collections = 0;
+        table.SetCollector([&](std::vector<bool>& live) {
+            ++collections;
+            live.assign(live.size(), true);
+        });
+
+        Log::Comment(L"Intern more distinct attributes than the table first collects at, all still in use, like a true-color gradient.");
+        const auto colorOf = [](const size_t i) { return RGB(i & 0xff, (i >> 8) & 0xff, (i >> 16) & 0xff); };
+        const size_t count = TextAttributeTable::s_initialCollectAt * 3;
+        std::vector<TextAttributeTable::Id> ids;
+        for (size_t i = 0; i < count; i++)
+        {
+            table.Reserve(1);
+            ids.push_back(table.Intern(TextAttribute{ colorOf(i), colorOf(count - i) }));
+        }
+        VERIFY_ARE_EQUAL(count, table.Size());
+
+        Log::Comment(L"Every attribute keeps its exact colors.");
+        for (size_t i = 0; i < count; i++)
+        {
+            VERIFY_ARE_EQUAL((TextAttribute{ colorOf(i), colorOf(count - i) }), table.Get(ids[i]));
+        }
+
+        Log::Comment(L"Collections that free nothing push the next one further out instead of running on every write.");
+        VERIFY_ARE_EQUAL(1u, collections);
+        VERIFY_ARE_EQUAL(TextAttributeTable::s_initialCollectAt * 4, table.CollectsAt());
+
+        Log::Comment(L"A row written with yet another attribute gets it exactly.");
+        ATTR_ROW row{ _sDefaultLength, TextAttribute{ RGB(1, 0, 0), RGB(0, 0, 0) }, table };
+        const TextAttributeRun run{ 5, TextAttribute{ RGB(5, 6, 0), RGB(7, 8, 9) } };
+        VERIFY_SUCCEEDED(row.InsertAttrRuns({ &run, 1 }, 10, 14, _sDefaultLength));
+        VERIFY_ARE_EQUAL((TextAttribute{ RGB(5, 6, 0), RGB(7, 8, 9) }), row.GetAttrByColumn(12));
+    }
+
+    TEST_METHOD(TestIteratorSeeks)
+    {
+        const size_t length = _sDefaultLength;
+        const std::vector<TextAttribute> expected{ pChain->cbegin(), pChain->cend() };
+        VERIFY_ARE_EQUAL(length, expected.size());
+
+        Log::Comment(L"Jumps of any size, both ways, land on the same attribute as a column lookup.");
+        for (const size_t stride : { 1u, 5u, 13u, 27u, 79u })
+        {
+            auto it = pChain->cbegin();
+            size_t column = 0;
+            while (column + stride < length)
+            {
+                it += static_cast<ptrdiff_t>(stride);
+                column += stride;
+                VERIFY_ARE_EQUAL(expected[column], *it);
+                VERIFY_ARE_EQUAL(pChain->GetAttrByColumn(column), *it);
+            }
+            while (column >= stride)
+            {
+                it -= static_cast<ptrdiff_t>(stride);
+                column -= stride;
+                VERIFY_ARE_EQUAL(expected[column], *it);
+            }
+        }
+
+        Log::Comment(L"Walking off the end lands on end().");
+        auto it = pChain->cbegin();
+        it += _sDefaultLength;
+        VERIFY_IS_TRUE(it == pChain->cend());
+        VERIFY_IS_FALSE(it);
+        --it;
+        VERIFY_ARE_EQUAL(expected.back(), *it);
+
+        Log::Comment(L"FindAttrIndex reports how far the run goes on.");
+        size_t applies = 0;
+        VERIFY_ARE_EQUAL(1u, pChain->FindAttrIndex(sChainSegLength + 2, &applies));
+        VERIFY_ARE_EQUAL(static_cast<size_t>(sChainSegLength - 2), applies);
+    }
+
+    TEST_METHOD(TestInsertAttrRunsRejectsMismatchedRuns)
+    {
+        const TextAttributeRun runs[]{ { 2, TextAttribute{ FOREGROUND_RED } }, { 3, TextAttribute{ FOREGROUND_GREEN } } };
+        const auto before = Runs(*pChain);
+
+        VERIFY_ARE_EQUAL(E_INVALIDARG, pChain->InsertAttrRuns({ runs, ARRAYSIZE(runs) }, 10, 13, _sDefaultLength), L"Runs longer than the columns.");
+        VERIFY_ARE_EQUAL(E_INVALIDARG, pChain->InsertAttrRuns({ runs, ARRAYSIZE(runs) }, 10, 15, _sDefaultLength), L"Runs shorter than the columns.");
+        VERIFY_ARE_EQUAL(E_INVALIDARG, pChain->InsertAttrRuns({ runs, ARRAYSIZE(runs) }, 76, 80, _sDefaultLength), L"Columns past the end of the row.");
+        VERIFY_ARE_EQUAL(E_INVALIDARG, pChain->InsertAttrRuns({ runs, 0 }, 10, 10, _sDefaultLength), L"No runs.");
+
+        const auto after = Runs(*pChain);
+        VERIFY_ARE_EQUAL(before.size(), after.size(), L"The row is left alone.");
+        for (size_t i = 0; i < before.size(); i++)
+        {
+            VERIFY_ARE_EQUAL(before[i], after[i]);
+        }
+    }
+
+    BEGIN_TEST_METHOD(RowMemoryAndColoredWritePerf)
+        TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+    END_TEST_METHOD()
+
+    BEGIN_TEST_METHOD(RunEditAndLookupPerf)
+        TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+    END_TEST_METHOD()
 };
+
+void AttrRowTests::RowMemoryAndColoredWritePerf()
+{
+    // Every cell gets its own color from a small palette, like the output of
+    // a syntax highlighter. That's the worst case for run storage.
+    const size_t width = 120;
+    const size_t height = 1000;
+    const TextAttribute palette[]{
+        TextAttribute{ FOREGROUND_RED },
+        TextAttribute{ FOREGROUND_GREEN | FOREGROUND_INTENSITY },
+        TextAttribute{ RGB(200, 120, 40), RGB(0, 0, 0) },
+        TextAttribute{ RGB(90, 160, 230), RGB(30, 30, 30) },
+        TextAttribute{ FOREGROUND_BLUE | BACKGROUND_RED },
+    };
+
+    TextAttributeTable table;
+    std::deque<ATTR_ROW> rows;
+    for (size_t y = 0; y < height; y++)
+    {
+        rows.emplace_back(gsl::narrow<UINT>(width), _DefaultAttr, table);
+    }
+
+    HRESULT hr = S_OK;
+    const auto before = std::chrono::steady_clock::now();
+    for (size_t y = 0; y < height && SUCCEEDED(hr); y++)
+    {
+        for (size_t x = 0; x < width && SUCCEEDED(hr); x++)
+        {
+            const TextAttributeRun run{ 1, palette[(x * 7 + y) % ARRAYSIZE(palette)] };
+            hr = rows[y].InsertAttrRuns({ &run, 1 }, x, x, width);
+        }
+    }
+    const auto delta = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before).count();
+
+    size_t runs = 0;
+    size_t bytes = 0;
+    for (const auto& row : rows)
+    {
+        runs += row._list.size();
+        bytes += row._list.capacity() * sizeof(row._list[0]);
+    }
+
+    VERIFY_SUCCEEDED(hr);
+    Log::Comment(NoThrowString().Format(L"%zu colored cell writes: %lld us", width * height, delta));
+    Log::Comment(NoThrowString().Format(L"%zu runs, %zu bytes per row (%zu bytes per row as TextAttributeRuns)",
+                                        runs,
+                                        bytes / height,
+                                        runs * sizeof(TextAttributeRun) / height));
+    Log::Comment(NoThrowString().Format(L"%zu attributes in the table", table.Size()));
+
+    VERIFY_ARE_EQUAL(ARRAYSIZE(palette), table.Size() - 1);
+}
+
+void AttrRowTests::RunEditAndLookupPerf()
+{
+    // A row of a side-by-side diff with syntax highlighting can easily have
+    // a hundred runs or more. Time the things the renderer and the output
+    // path do to such rows as the number of runs goes up.
+    const size_t width = 300;
+    const size_t iterations = 200;
+    const TextAttribute palette[]{
+        TextAttribute{ FOREGROUND_RED },
+        TextAttribute{ FOREGROUND_GREEN },
+        TextAttribute{ RGB(200, 120, 40), RGB(0, 0, 0) },
+    };
+
+    for (const size_t runCount : { 1u, 10u, 100u, 300u })
+    {
+        TextAttributeTable table;
+        ATTR_ROW row{ gsl::narrow<UINT>(width), _DefaultAttr, table };
+
+        std::vector<TextAttributeRun> runs;
+        for (size_t i = 0; i < runCount; i++)
+        {
+            const auto start = i * width / runCount;
+            const auto end = (i + 1) * width / runCount;
+            runs.emplace_back(end - start, palette[i % ARRAYSIZE(palette)]);
+        }
+        VERIFY_SUCCEEDED(row.InsertAttrRuns({ runs.data(), runs.size() }, 0, width - 1, width));
+        VERIFY_ARE_EQUAL(runCount, row.GetNumberOfRuns());
+
+        // Every column gets rewritten with the color it already has, one cell at a time,
+        // like a line of output being redrawn. The row ends up as it started.
+        HRESULT hr = S_OK;
+        auto before = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations && SUCCEEDED(hr); i++)
+        {
+            for (size_t column = 0; column < width && SUCCEEDED(hr); column++)
+            {
+                const TextAttributeRun run{ 1, runs[column * runCount / width].GetAttributes() };
+                hr = row.InsertAttrRuns({ &run, 1 }, column, column, width);
+            }
+        }
+        const auto writes = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before).count();
+        VERIFY_SUCCEEDED(hr);
+        VERIFY_ARE_EQUAL(runCount, row.GetNumberOfRuns());
+
+        size_t matches = 0;
+        before = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++)
+        {
+            for (size_t column = 0; column < width; column++)
+            {
+                matches += row.GetAttrByColumn(column) == _DefaultAttr ? 0 : 1;
+            }
+        }
+        const auto lookups = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before).count();
+        VERIFY_ARE_EQUAL(iterations * width, matches);
+
+        matches = 0;
+        before = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; i++)
+        {
+            for (auto it = row.cbegin(); it; ++it)
+            {
+                matches += *it == _DefaultAttr ? 0 : 1;
+            }
+        }
+        const auto walks = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before).count();
+        VERIFY_ARE_EQUAL(iterations * width, matches);
+
+        Log::Comment(NoThrowString().Format(L"%zu runs: %zu cell writes %lld us, %zu column lookups %lld us, %zu iterator steps %lld us",
+                                            runCount,
+                                            iterations * width,
+                                            writes,
+                                            iterations * width,
+                                            lookups,
+                                            iterations * width,
+                                            walks));
+    }
+}
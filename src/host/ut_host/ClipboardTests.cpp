@@ -14,6 +14,7 @@
 #include "dbcs.h"
 
 #include <cctype>
+#include <chrono>
 
 #ifdef BUILD_ONECORE_INTERACTIVITY
 #include "..\..\interactivity\inc\VtApiRedirection.hpp"
@@ -70,7 +71,7 @@ class ClipboardTests
 
     const UINT cRectsSelected = 4;
 
-    std::vector<std::wstring> SetupRetrieveFromBuffers(bool fLineSelection, std::vector<SMALL_RECT>& selection)
+    TextBufferExport SetupRetrieveFromBuffers(bool fLineSelection, std::vector<SMALL_RECT>& selection)
     {
         const auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
         // NOTE: This test requires innate knowledge of how the common buffer text is emitted in order to test all cases
@@ -87,75 +88,81 @@ class ClipboardTests
 
         return Clipboard::Instance().RetrieveTextFromBuffer(screenInfo,
                                                             fLineSelection,
-                                                            selection).text;
+                                                            selection);
     }
 
-#pragma prefast(push)
-#pragma prefast(disable:26006, "Specifically trying to check unterminated strings in this test.")
     TEST_METHOD(TestRetrieveFromBuffer)
     {
         // NOTE: This test requires innate knowledge of how the common buffer text is emitted in order to test all cases
         // Please see CommonState.hpp for information on the buffer state per row, the row contents, etc.
 
         std::vector<SMALL_RECT> selection;
-        const auto text = SetupRetrieveFromBuffers(false, selection);
-
-        // verify trailing bytes were trimmed
-        // there are 2 double-byte characters in our sample string (see CommonState.hpp for sample)
-        // the width is right - left
-        VERIFY_ARE_EQUAL((short)wcslen(text[0].data()), selection[0].Right - selection[0].Left + 1);
-
-        // since we're not in line selection, the line should be \r\n terminated
-        PCWCHAR tempPtr = text[0].data();
-        tempPtr += text[0].size();
-        tempPtr -= 2;
-        VERIFY_ARE_EQUAL(String(tempPtr), String(L"\r\n"));
-
-        // since we're not in line selection, spaces should be trimmed from the end
-        tempPtr = text[0].data();
-        tempPtr += selection[0].Right - selection[0].Left - 2;
-        tempPtr++;
-        VERIFY_IS_NULL(wcsrchr(tempPtr, L' '));
-
-        // final line of selection should not contain CR/LF
-        tempPtr = text[3].data();
-        tempPtr += text[3].size();
-        tempPtr -= 2;
-        VERIFY_ARE_NOT_EQUAL(String(tempPtr), String(L"\r\n"));
+        const auto text = SetupRetrieveFromBuffers(false, selection).Text();
+
+        // Each row is "AB" か "C" き "DE" followed by spaces.
+        // The trailing halves of the double-byte characters aren't repeated,
+        // the spaces are trimmed from the end of every row, every row but the
+        // last one is \r\n terminated since we're not in line selection.
+        const std::wstring row = L"AB\x304b" L"C\x304d" L"DE";
+        VERIFY_ARE_EQUAL(row + L"\r\n" + row + L"\r\n" + row + L"\r\n" + row, text);
     }
-#pragma prefast(pop)
 
     TEST_METHOD(TestRetrieveLineSelectionFromBuffer)
     {
         // NOTE: This test requires innate knowledge of how the common buffer text is emitted in order to test all cases
         // Please see CommonState.hpp for information on the buffer state per row, the row contents, etc.
 
+        std::vector<SMALL_RECT> selection;
+        const auto text = SetupRetrieveFromBuffers(true, selection).Text();
+
+        // Odd rows are wrapped. A wrapped row keeps the spaces at its end and
+        // runs straight on into the next row without a \r\n.
+        const std::wstring row = L"AB\x304b" L"C\x304d" L"DE";
+        VERIFY_ARE_EQUAL(row + L"\r\n" + row + L"      " + row + L"\r\n" + row, text);
+    }
+
+    TEST_METHOD(TestGenHtmlFromBuffer)
+    {
+        std::vector<SMALL_RECT> selection;
+        const auto html = Clipboard::Instance().GenHTML(SetupRetrieveFromBuffers(false, selection));
+        VERIFY_IS_FALSE(html.empty());
+
+        const auto offsetOf = [&](const std::string& field) {
+            const auto position = html.find(field + ":");
+            VERIFY_ARE_NOT_EQUAL(std::string::npos, position);
+            return static_cast<size_t>(std::stoul(html.substr(position + field.size() + 1, 10)));
+        };
+
+        Log::Comment(L"The offsets in the CF_HTML header must point at the fragment markers.");
+        const std::string fragmentStart = "<!--StartFragment -->";
+        const std::string fragmentEnd = "<!--EndFragment -->";
+        VERIFY_ARE_EQUAL(0, html.compare(offsetOf("StartFragment"), fragmentStart.size(), fragmentStart));
+        VERIFY_ARE_EQUAL(0, html.compare(offsetOf("EndFragment") - fragmentEnd.size(), fragmentEnd.size(), fragmentEnd));
+        VERIFY_ARE_EQUAL(html.size(), offsetOf("EndHTML"));
+
+        Log::Comment(L"Every row has four differently colored runs, one span for each.");
+        size_t spans = 0;
+        for (auto position = html.find("<SPAN STYLE=\"color:"); position != std::string::npos; position = html.find("<SPAN STYLE=\"color:", position + 1))
+        {
+            ++spans;
+        }
+        VERIFY_ARE_EQUAL(16u, spans);
+
+        // か encoded as UTF-8
+        VERIFY_ARE_NOT_EQUAL(std::string::npos, html.find("\xE3\x81\x8B"));
+    }
 
+    TEST_METHOD(TestGenRtfFromBuffer)
+    {
         std::vector<SMALL_RECT> selection;
-        const auto text = SetupRetrieveFromBuffers(true, selection);
-
-        // row 2, no wrap
-        // no wrap row before the end should have CR/LF
-        PCWCHAR tempPtr = text[2].data();
-        tempPtr += text[2].size();
-        tempPtr -= 2;
-        VERIFY_ARE_EQUAL(String(tempPtr), String(L"\r\n"));
-
-        // no wrap row should trim spaces at the end
-        tempPtr = text[2].data();
-        VERIFY_IS_NULL(wcsrchr(tempPtr, L' '));
-
-        // row 1, wrap
-        // wrap row before the end should *not* have CR/LF
-        tempPtr = text[1].data();
-        tempPtr += text[1].size();
-        tempPtr -= 2;
-        VERIFY_ARE_NOT_EQUAL(String(tempPtr), String(L"\r\n"));
-
-        // wrap row should have spaces at the end
-        tempPtr = text[1].data();
-        const wchar_t* ptr = wcsrchr(tempPtr, L' ');
-        VERIFY_IS_NOT_NULL(ptr);
+        const auto rtf = Clipboard::Instance().GenRTF(SetupRetrieveFromBuffers(false, selection));
+
+        VERIFY_ARE_EQUAL(0u, rtf.find("{\\rtf1"));
+        VERIFY_ARE_EQUAL('}', rtf.back());
+
+        // Rows end in \line and double-byte characters are written as \u control words.
+        VERIFY_ARE_NOT_EQUAL(std::string::npos, rtf.find("\\line "));
+        VERIFY_ARE_NOT_EQUAL(std::string::npos, rtf.find("\\u12363?"));
     }
 
     TEST_METHOD(CanConvertTextToInputEvents)
@@ -329,4 +336,62 @@ class ClipboardTests
             VERIFY_ARE_EQUAL(expectedEvents[i], currentKeyEvent, NoThrowString().Format(L"i == %d", i));
         }
     }
+
+    TEST_METHOD(PasteLatency)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD_PROPERTIES()
+
+        CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        InputBuffer* const pInputBuffer = gci.pInputBuffer;
+        const DWORD originalInputMode = pInputBuffer->InputMode;
+        auto restoreInputMode = wil::scope_exit([&] {
+            pInputBuffer->InputMode = originalInputMode;
+            pInputBuffer->Flush();
+        });
+
+        for (const size_t cchPaste : { 1024u, 1024u * 1024u, 10u * 1024u * 1024u })
+        {
+            std::wstring paste;
+            paste.reserve(cchPaste);
+            while (paste.size() < cchPaste)
+            {
+                paste.append(L"The quick brown fox jumps over the lazy dog 0123456789\r\n");
+            }
+            paste.resize(cchPaste);
+
+            for (const bool vtInput : { false, true })
+            {
+                WI_UpdateFlag(pInputBuffer->InputMode, ENABLE_VIRTUAL_TERMINAL_INPUT, vtInput);
+                pInputBuffer->Flush();
+
+                // The old path: one heap allocated event per key transition,
+                // all created before the paste returns. It takes minutes at
+                // 10MB, so it's only measured for the smaller payloads.
+                if (cchPaste <= 1024 * 1024)
+                {
+                    const auto before = std::chrono::steady_clock::now();
+                    std::deque<std::unique_ptr<IInputEvent>> inEvents = Clipboard::Instance().TextToKeyEvents(paste.data(), paste.size());
+                    pInputBuffer->Write(inEvents);
+                    const auto delta = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before).count();
+                    Log::Comment(NoThrowString().Format(L"%s, %zu chars, per-key events: %lld us",
+                                                        vtInput ? L"VT input" : L"Legacy input",
+                                                        paste.size(),
+                                                        delta));
+                    pInputBuffer->Flush();
+                }
+
+                const auto before = std::chrono::steady_clock::now();
+                Clipboard::Instance().StringPaste(paste.data(), paste.size());
+                const auto delta = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before).count();
+                Log::Comment(NoThrowString().Format(L"%s, %zu chars, StringPaste: %lld us (%zu events ready)",
+                                                    vtInput ? L"VT input" : L"Legacy input",
+                                                    paste.size(),
+                                                    delta,
+                                                    pInputBuffer->GetNumberOfReadyEvents()));
+                VERIFY_IS_GREATER_THAN(pInputBuffer->GetNumberOfReadyEvents(), 0u);
+            }
+        }
+    }
     };
@@ -9,6 +9,8 @@
 
 #include "search.h"
 
+#include <chrono>
+
 using namespace WEX::Common;
 using namespace WEX::Logging;
 using namespace WEX::TestExecution;
@@ -241,6 +243,251 @@ class HistoryTests
         VERIFY_ARE_EQUAL(2ul, history->GetNumberOfCommands());
     }
 
+    TEST_METHOD(FindMatchingCommandByPrefix)
+    {
+        auto history = CommandHistory::s_Allocate(_manyApps[0], _MakeHandle(0));
+        VERIFY_IS_NOT_NULL(history);
+
+        for (const auto command : { L"dir", L"cd ..", L"DIR /w", L"ping 127.0.0.1", L"dir /p" })
+        {
+            VERIFY_SUCCEEDED(history->Add(command, false));
+        }
+
+        const auto lookingFor = CommandHistory::MatchOptions::JustLooking;
+        SHORT index;
+
+        Log::Comment(L"Search backwards from the newest command, ignoring case.");
+        VERIFY_IS_TRUE(history->FindMatchingCommand(L"di", 4, index, lookingFor));
+        VERIFY_ARE_EQUAL(2, index);
+        VERIFY_IS_TRUE(history->FindMatchingCommand(L"di", index, index, lookingFor));
+        VERIFY_ARE_EQUAL(0, index);
+
+        Log::Comment(L"Going past the oldest command wraps around to the newest.");
+        VERIFY_IS_TRUE(history->FindMatchingCommand(L"di", index, index, lookingFor));
+        VERIFY_ARE_EQUAL(4, index);
+
+        Log::Comment(L"An exact match skips over longer commands with the same prefix.");
+        VERIFY_IS_TRUE(history->FindMatchingCommand(L"dir", 4, index, lookingFor | CommandHistory::MatchOptions::ExactMatch));
+        VERIFY_ARE_EQUAL(0, index);
+
+        VERIFY_IS_FALSE(history->FindMatchingCommand(L"xcopy", 4, index, lookingFor));
+    }
+
+    TEST_METHOD(FindMatchingCommandWithLongPrefix)
+    {
+        auto history = CommandHistory::s_Allocate(_manyApps[0], _MakeHandle(0));
+        VERIFY_IS_NOT_NULL(history);
+
+        // These share more characters than the prefix index looks at.
+        VERIFY_SUCCEEDED(history->Add(L"echo 0123456789abcdef-one", false));
+        VERIFY_SUCCEEDED(history->Add(L"echo 0123456789abcdef-two", false));
+        VERIFY_SUCCEEDED(history->Add(L"cls", false));
+
+        const auto lookingFor = CommandHistory::MatchOptions::JustLooking;
+        SHORT index;
+        VERIFY_IS_TRUE(history->FindMatchingCommand(L"ECHO 0123456789ABCDEF-ONE", 2, index, lookingFor));
+        VERIFY_ARE_EQUAL(0, index);
+        VERIFY_IS_TRUE(history->FindMatchingCommand(L"echo 0123456789abcdef-t", 2, index, lookingFor));
+        VERIFY_ARE_EQUAL(1, index);
+        VERIFY_IS_FALSE(history->FindMatchingCommand(L"echo 0123456789abcdef-three", 2, index, lookingFor));
+    }
+
+    TEST_METHOD(FindMatchingCommandFollowsEdits)
+    {
+        auto history = CommandHistory::s_Allocate(_manyApps[0], _MakeHandle(0));
+        VERIFY_IS_NOT_NULL(history);
+        for (const auto& command : _manyHistoryItems)
+        {
+            VERIFY_SUCCEEDED(history->Add(command, false));
+        }
+
+        const auto exactly = CommandHistory::MatchOptions::JustLooking | CommandHistory::MatchOptions::ExactMatch;
+        const auto newest = gsl::narrow<SHORT>(history->GetNumberOfCommands() - 1);
+        SHORT index;
+
+        Log::Comment(L"The two oldest commands were pushed out to make room and can't be found.");
+        VERIFY_IS_FALSE(history->FindMatchingCommand(L"dir", newest, index, exactly));
+        VERIFY_IS_FALSE(history->FindMatchingCommand(L"dir /w", newest, index, exactly));
+        VERIFY_IS_TRUE(history->FindMatchingCommand(L"dir", newest, index, CommandHistory::MatchOptions::JustLooking));
+        VERIFY_ARE_EQUAL(0, index);
+
+        Log::Comment(L"Swapped commands are found in their new places.");
+        history->Swap(0, newest);
+        VERIFY_IS_TRUE(history->FindMatchingCommand(L"dir /p /w", newest, index, exactly));
+        VERIFY_ARE_EQUAL(newest, index);
+        VERIFY_IS_TRUE(history->FindMatchingCommand(L"git push", newest, index, exactly));
+        VERIFY_ARE_EQUAL(0, index);
+
+        Log::Comment(L"Removed commands are gone and the ones after them move down.");
+        history->Remove(0);
+        const auto newestAfterRemove = gsl::narrow<SHORT>(newest - 1);
+        VERIFY_IS_FALSE(history->FindMatchingCommand(L"git push", newestAfterRemove, index, exactly));
+        VERIFY_IS_TRUE(history->FindMatchingCommand(L"dir /p /w", newestAfterRemove, index, exactly));
+        VERIFY_ARE_EQUAL(newestAfterRemove, index);
+    }
+
+    TEST_METHOD(HistoryFileIsSharedAndBounded)
+    {
+        wchar_t tempPath[MAX_PATH];
+        VERIFY_ARE_NOT_EQUAL(0u, GetTempPathW(ARRAYSIZE(tempPath), tempPath));
+        const std::wstring path = std::wstring{ tempPath } + L"HistoryTests.history";
+        const std::wstring lockName = L"Local\\HistoryTests";
+        DeleteFileW(path.c_str());
+        auto removeFile = wil::scope_exit([&] { DeleteFileW(path.c_str()); });
+
+        {
+            CommandHistoryFile first{ path, lockName };
+            CommandHistoryFile second{ path, lockName };
+
+            Log::Comment(L"Commands written through one view show up in the other.");
+            first.Append(L"dir");
+            second.Append(L"cd ..");
+            first.Append(L"ping 127.0.0.1");
+
+            const auto loaded = second.Load(2);
+            VERIFY_ARE_EQUAL(2u, loaded.size());
+            VERIFY_ARE_EQUAL(String(L"cd .."), String(loaded[0].c_str()));
+            VERIFY_ARE_EQUAL(String(L"ping 127.0.0.1"), String(loaded[1].c_str()));
+            VERIFY_ARE_EQUAL(3u, first.Load(10).size());
+
+            Log::Comment(L"Filling the file drops the oldest commands, never the newest.");
+            const std::wstring big(64 * 1024, L'x');
+            for (size_t i = 0; i < 32; ++i)
+            {
+                first.Append(big + std::to_wstring(i));
+            }
+            const auto afterWrap = second.Load(SIZE_MAX);
+            VERIFY_IS_LESS_THAN(afterWrap.size(), 32u);
+            VERIFY_ARE_EQUAL(String((big + L"31").c_str()), String(afterWrap.back().c_str()));
+
+            second.Clear();
+            VERIFY_ARE_EQUAL(0u, first.Load(10).size());
+        }
+
+        Log::Comment(L"The file outlives the views onto it.");
+        {
+            CommandHistoryFile writer{ path, lockName };
+            writer.Append(L"exit");
+        }
+        CommandHistoryFile reader{ path, lockName };
+        const auto reloaded = reader.Load(10);
+        VERIFY_ARE_EQUAL(1u, reloaded.size());
+        VERIFY_ARE_EQUAL(String(L"exit"), String(reloaded[0].c_str()));
+    }
+
+    TEST_METHOD(HistoryFileKeepsRemovesAndSwaps)
+    {
+        wchar_t tempPath[MAX_PATH];
+        VERIFY_ARE_NOT_EQUAL(0u, GetTempPathW(ARRAYSIZE(tempPath), tempPath));
+        const std::wstring path = std::wstring{ tempPath } + L"HistoryTests.history";
+        const std::wstring lockName = L"Local\\HistoryTests";
+        DeleteFileW(path.c_str());
+        auto removeFile = wil::scope_exit([&] { DeleteFileW(path.c_str()); });
+
+        {
+            CommandHistoryFile file{ path, lockName };
+            for (const auto command : { L"dir", L"cd ..", L"dir", L"ping 127.0.0.1", L"exit" })
+            {
+                file.Append(command);
+            }
+
+            Log::Comment(L"Removing a command drops its newest record.");
+            file.Remove(L"dir");
+            file.Remove(L"not in the file");
+
+            Log::Comment(L"Swapping two commands swaps their newest records.");
+            file.Swap(L"ping 127.0.0.1", L"cd ..");
+        }
+
+        Log::Comment(L"The next session sees the history as it was left.");
+        CommandHistoryFile reader{ path, lockName };
+        const auto reloaded = reader.Load(10);
+        const std::vector<std::wstring> expected{ L"dir", L"ping 127.0.0.1", L"cd ..", L"exit" };
+        VERIFY_ARE_EQUAL(expected.size(), reloaded.size());
+        for (size_t i = 0; i < expected.size(); ++i)
+        {
+            VERIFY_ARE_EQUAL(String(expected[i].c_str()), String(reloaded[i].c_str()));
+        }
+    }
+
+    TEST_METHOD(AddAndPrefixSearchPerf)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD_PROPERTIES()
+
+        // A history can't hold more than SHORT_MAX commands.
+        for (const size_t size : { 10000, 20000, SHORT_MAX })
+        {
+            CommandHistory::s_ClearHistoryListStorage();
+            auto history = CommandHistory::s_Allocate(_manyApps[0], _MakeHandle(0));
+            VERIFY_IS_NOT_NULL(history);
+            history->Realloc(size);
+
+            // Twice as many commands as fit, so every other add evicts one.
+            const size_t adds = size * 2;
+            auto before = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < adds; ++i)
+            {
+                VERIFY_SUCCEEDED(history->Add(_manyHistoryItems[i % _manyHistoryItems.size()] + L" " + std::to_wstring(i), false));
+            }
+            auto delta = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before).count();
+            Log::Comment(NoThrowString().Format(L"%zu commands: %lld us per 1000 adds", size, delta * 1000 / adds));
+
+            const size_t searches = 1000;
+            const auto newest = gsl::narrow<SHORT>(history->GetNumberOfCommands() - 1);
+            SHORT index = newest;
+            before = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < searches; ++i)
+            {
+                // Each search picks up where the last one left off, like pressing F8 over and over.
+                VERIFY_IS_TRUE(history->FindMatchingCommand(L"telnet", index, index, CommandHistory::MatchOptions::JustLooking));
+            }
+            delta = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before).count();
+            Log::Comment(NoThrowString().Format(L"%zu commands: %lld us per 1000 prefix searches", size, delta * 1000 / searches));
+        }
+    }
+
+    TEST_METHOD(PrefixIndexPerf)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD_PROPERTIES()
+
+        // The index itself isn't bound by SHORT indices, so it's measured
+        // past what a single history can hold.
+        for (const uint64_t size : { 10000, 30000, 100000 })
+        {
+            CommandHistoryIndex index;
+            std::deque<std::wstring> commands;
+
+            const uint64_t adds = size * 2;
+            auto before = std::chrono::steady_clock::now();
+            for (uint64_t id = 0; id < adds; ++id)
+            {
+                if (commands.size() == size)
+                {
+                    index.Erase(commands.front(), id - size);
+                    commands.pop_front();
+                }
+                commands.emplace_back(_manyHistoryItems[id % _manyHistoryItems.size()] + L" " + std::to_wstring(id));
+                index.Insert(commands.back(), id);
+            }
+            auto delta = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before).count();
+            Log::Comment(NoThrowString().Format(L"%llu commands: %lld us per 1000 adds", size, delta * 1000 / adds));
+
+            const uint64_t searches = 1000;
+            const auto confirm = [](const uint64_t) { return true; };
+            before = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < searches; ++i)
+            {
+                VERIFY_IS_TRUE(index.FindLast(L"telnet", adds - 1 - i * (size / searches), confirm).has_value());
+            }
+            delta = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before).count();
+            Log::Comment(NoThrowString().Format(L"%llu commands: %lld us per 1000 prefix searches", size, delta * 1000 / searches));
+        }
+    }
+
 private:
 
     const std::array<std::wstring, 5> _manyApps =
@@ -77,7 +77,7 @@ class InputBufferTests
             INPUT_RECORD record;
             record.EventType = MENU_EVENT;
             VERIFY_IS_GREATER_THAN(inputBuffer.Write(IInputEvent::Create(record)), 0u);
-            VERIFY_ARE_EQUAL(record, inputBuffer._storage.back()->ToInputRecord());
+            VERIFY_ARE_EQUAL(record, inputBuffer._storage.back());
         }
         VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), RECORD_INSERT_COUNT);
     }
@@ -97,7 +97,7 @@ class InputBufferTests
         // verify that the events are the same in storage
         for (size_t i = 0; i < RECORD_INSERT_COUNT; ++i)
         {
-            VERIFY_ARE_EQUAL(inputBuffer._storage[i]->ToInputRecord(), record);
+            VERIFY_ARE_EQUAL(inputBuffer._storage[i], record);
         }
     }
 
@@ -120,10 +120,9 @@ class InputBufferTests
         // check that they coalesced
         VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), 1u);
         // check that the mouse position is being updated correctly
-        const IInputEvent* const pOutEvent = inputBuffer._storage.front().get();
-        const MouseEvent* const pMouseEvent = static_cast<const MouseEvent* const>(pOutEvent);
-        VERIFY_ARE_EQUAL(pMouseEvent->GetPosition().X, static_cast<SHORT>(RECORD_INSERT_COUNT));
-        VERIFY_ARE_EQUAL(pMouseEvent->GetPosition().Y, static_cast<SHORT>(RECORD_INSERT_COUNT * 2));
+        const MOUSE_EVENT_RECORD& outMouseRecord = inputBuffer._storage.front().Event.MouseEvent;
+        VERIFY_ARE_EQUAL(outMouseRecord.dwMousePosition.X, static_cast<SHORT>(RECORD_INSERT_COUNT));
+        VERIFY_ARE_EQUAL(outMouseRecord.dwMousePosition.Y, static_cast<SHORT>(RECORD_INSERT_COUNT * 2));
 
         // add a key event and another mouse event to make sure that
         // an event between two mouse events stopped the coalescing.
@@ -161,10 +160,10 @@ class InputBufferTests
         // no events should have been coalesced
         VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), RECORD_INSERT_COUNT + 1);
         // check that the events stored match those inserted
-        VERIFY_ARE_EQUAL(inputBuffer._storage.front()->ToInputRecord(), mouseRecords[0]);
+        VERIFY_ARE_EQUAL(inputBuffer._storage.front(), mouseRecords[0]);
         for (size_t i = 0; i < RECORD_INSERT_COUNT; ++i)
         {
-            VERIFY_ARE_EQUAL(inputBuffer._storage[i + 1]->ToInputRecord(), mouseRecords[i]);
+            VERIFY_ARE_EQUAL(inputBuffer._storage[i + 1], mouseRecords[i]);
         }
     }
 
@@ -220,10 +219,10 @@ class InputBufferTests
         // no events should have been coalesced
         VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), RECORD_INSERT_COUNT + 1);
         // check that the events stored match those inserted
-        VERIFY_ARE_EQUAL(inputBuffer._storage.front()->ToInputRecord(), keyRecords[0]);
+        VERIFY_ARE_EQUAL(inputBuffer._storage.front(), keyRecords[0]);
         for (size_t i = 0; i < RECORD_INSERT_COUNT; ++i)
         {
-            VERIFY_ARE_EQUAL(inputBuffer._storage[i + 1]->ToInputRecord(), keyRecords[i]);
+            VERIFY_ARE_EQUAL(inputBuffer._storage[i + 1], keyRecords[i]);
         }
     }
 
@@ -238,7 +237,7 @@ class InputBufferTests
         for (size_t i = 0; i < RECORD_INSERT_COUNT; ++i)
         {
             VERIFY_IS_GREATER_THAN(inputBuffer.Write(IInputEvent::Create(record)), 0u);
-            VERIFY_ARE_EQUAL(inputBuffer._storage.back()->ToInputRecord(), record);
+            VERIFY_ARE_EQUAL(inputBuffer._storage.back(), record);
         }
 
         // The events shouldn't be coalesced
@@ -624,7 +623,7 @@ class InputBufferTests
                                                  true));
         VERIFY_ARE_EQUAL(outEvents.size(), 1u);
         VERIFY_ARE_EQUAL(inputBuffer._storage.size(), 1u);
-        VERIFY_ARE_EQUAL(static_cast<const KeyEvent&>(*inputBuffer._storage.front()).GetRepeatCount(), repeatCount - 1);
+        VERIFY_ARE_EQUAL(inputBuffer._storage.front().Event.KeyEvent.wRepeatCount, repeatCount - 1);
         VERIFY_ARE_EQUAL(static_cast<const KeyEvent&>(*outEvents.front()).GetRepeatCount(), 1u);
     }
 
@@ -644,8 +643,161 @@ class InputBufferTests
                                                  true));
         VERIFY_ARE_EQUAL(outEvents.size(), 1u);
         VERIFY_ARE_EQUAL(inputBuffer._storage.size(), 1u);
-        VERIFY_ARE_EQUAL(static_cast<const KeyEvent&>(*inputBuffer._storage.front()).GetRepeatCount(), repeatCount);
+        VERIFY_ARE_EQUAL(inputBuffer._storage.front().Event.KeyEvent.wRepeatCount, repeatCount);
         VERIFY_ARE_EQUAL(static_cast<const KeyEvent&>(*outEvents.front()).GetRepeatCount(), 1u);
     }
 
+    std::wstring ReadKeyDownChars(InputBuffer& inputBuffer)
+    {
+        std::deque<std::unique_ptr<IInputEvent>> outEvents;
+        VERIFY_SUCCESS_NTSTATUS(inputBuffer.Read(outEvents,
+                                                 inputBuffer.GetNumberOfReadyEvents(),
+                                                 false,
+                                                 false,
+                                                 true,
+                                                 false));
+        std::wstring chars;
+        for (const auto& outEvent : outEvents)
+        {
+            VERIFY_ARE_EQUAL(InputEventType::KeyEvent, outEvent->EventType());
+            const KeyEvent& keyEvent = static_cast<const KeyEvent&>(*outEvent);
+            if (keyEvent.IsKeyDown())
+            {
+                chars.push_back(keyEvent.GetCharData());
+            }
+        }
+        return chars;
+    }
+
+    TEST_METHOD(PastedTextIsExpandedAsItIsRead)
+    {
+        InputBuffer inputBuffer;
+        std::deque<std::unique_ptr<IInputEvent>> outEvents;
+
+        inputBuffer.WritePastedText(L"ab", CP_USA);
+        Log::Comment(L"The paste is held as a single placeholder until it's read.");
+        VERIFY_ARE_EQUAL(inputBuffer._storage.size(), 1u);
+        VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), 4u);
+
+        VERIFY_SUCCESS_NTSTATUS(inputBuffer.Read(outEvents,
+                                                 1,
+                                                 false,
+                                                 false,
+                                                 true,
+                                                 false));
+        VERIFY_ARE_EQUAL(outEvents.size(), 1u);
+        const KeyEvent& firstEvent = static_cast<const KeyEvent&>(*outEvents.front());
+        VERIFY_IS_TRUE(firstEvent.IsKeyDown());
+        VERIFY_ARE_EQUAL(firstEvent.GetCharData(), L'a');
+
+        Log::Comment(L"Only the first character should have been expanded.");
+        VERIFY_ARE_EQUAL(inputBuffer._storage.size(), 2u);
+        VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), 3u);
+
+        outEvents.clear();
+        VERIFY_SUCCESS_NTSTATUS(inputBuffer.Read(outEvents,
+                                                 10,
+                                                 false,
+                                                 false,
+                                                 true,
+                                                 false));
+        VERIFY_ARE_EQUAL(outEvents.size(), 3u);
+        VERIFY_IS_FALSE(static_cast<const KeyEvent&>(*outEvents[0]).IsKeyDown());
+        VERIFY_ARE_EQUAL(static_cast<const KeyEvent&>(*outEvents[1]).GetCharData(), L'b');
+        VERIFY_IS_TRUE(static_cast<const KeyEvent&>(*outEvents[1]).IsKeyDown());
+        VERIFY_IS_FALSE(static_cast<const KeyEvent&>(*outEvents[2]).IsKeyDown());
+        VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), 0u);
+        VERIFY_IS_TRUE(inputBuffer._pastedText.empty());
+    }
+
+    TEST_METHOD(PeekingPastedTextLeavesItInPlace)
+    {
+        InputBuffer inputBuffer;
+
+        VERIFY_ARE_EQUAL(inputBuffer.Write(IInputEvent::Create(MakeKeyEvent(true, 1, L'x', 0, L'x', 0))), 1u);
+        inputBuffer.WritePastedText(L"ab", CP_USA);
+        VERIFY_ARE_EQUAL(inputBuffer.Write(IInputEvent::Create(MakeKeyEvent(true, 1, L'y', 0, L'y', 0))), 1u);
+        VERIFY_ARE_EQUAL(inputBuffer._storage.size(), 3u);
+
+        std::deque<std::unique_ptr<IInputEvent>> peekedEvents;
+        VERIFY_SUCCESS_NTSTATUS(inputBuffer.Read(peekedEvents,
+                                                 10,
+                                                 true,
+                                                 false,
+                                                 true,
+                                                 false));
+        VERIFY_ARE_EQUAL(peekedEvents.size(), 6u);
+        Log::Comment(L"Peeking must not expand or consume anything.");
+        VERIFY_ARE_EQUAL(inputBuffer._storage.size(), 3u);
+
+        std::deque<std::unique_ptr<IInputEvent>> readEvents;
+        VERIFY_SUCCESS_NTSTATUS(inputBuffer.Read(readEvents,
+                                                 10,
+                                                 false,
+                                                 false,
+                                                 true,
+                                                 false));
+        VERIFY_ARE_EQUAL(readEvents.size(), peekedEvents.size());
+        for (size_t i = 0; i < readEvents.size(); ++i)
+        {
+            VERIFY_ARE_EQUAL(peekedEvents[i]->ToInputRecord(), readEvents[i]->ToInputRecord());
+        }
+        VERIFY_ARE_EQUAL(static_cast<const KeyEvent&>(*readEvents.front()).GetCharData(), L'x');
+        VERIFY_ARE_EQUAL(static_cast<const KeyEvent&>(*readEvents.back()).GetCharData(), L'y');
+    }
+
+    TEST_METHOD(PastingInVtInputModeUsesBracketedPaste)
+    {
+        InputBuffer inputBuffer;
+        WI_SetFlag(inputBuffer.InputMode, ENABLE_VIRTUAL_TERMINAL_INPUT);
+
+        inputBuffer.WritePastedText(L"ab", CP_USA);
+        VERIFY_ARE_EQUAL(std::wstring{ L"ab" }, ReadKeyDownChars(inputBuffer));
+
+        inputBuffer.GetTerminalInput().ChangeBracketedPasteMode(true);
+        inputBuffer.WritePastedText(L"ab", CP_USA);
+        VERIFY_ARE_EQUAL(std::wstring{ L"\x1b[200~ab\x1b[201~" }, ReadKeyDownChars(inputBuffer));
+    }
+
+    TEST_METHOD(StorageKeepsOrderWhileWrappingAndGrowing)
+    {
+        InputBuffer inputBuffer;
+        std::deque<std::unique_ptr<IInputEvent>> outEvents;
+        WCHAR nextWritten = L'a';
+        WCHAR nextRead = L'a';
+
+        Log::Comment(L"Interleave writes and reads so the storage wraps around its end before it has to grow.");
+        for (size_t round = 0; round < 8; ++round)
+        {
+            std::deque<std::unique_ptr<IInputEvent>> inEvents;
+            for (size_t i = 0; i < RECORD_INSERT_COUNT; ++i)
+            {
+                inEvents.push_back(IInputEvent::Create(MakeKeyEvent(true, 1, nextWritten, 0, nextWritten, 0)));
+                nextWritten = nextWritten == L'z' ? L'a' : static_cast<WCHAR>(nextWritten + 1);
+            }
+            VERIFY_ARE_EQUAL(inputBuffer.Write(inEvents), RECORD_INSERT_COUNT);
+
+            outEvents.clear();
+            VERIFY_SUCCESS_NTSTATUS(inputBuffer.Read(outEvents,
+                                                     RECORD_INSERT_COUNT / 2,
+                                                     false,
+                                                     false,
+                                                     true,
+                                                     false));
+            for (const auto& outEvent : outEvents)
+            {
+                VERIFY_ARE_EQUAL(static_cast<const KeyEvent&>(*outEvent).GetCharData(), nextRead);
+                nextRead = nextRead == L'z' ? L'a' : static_cast<WCHAR>(nextRead + 1);
+            }
+        }
+
+        const size_t expectedRemaining = 8 * (RECORD_INSERT_COUNT - RECORD_INSERT_COUNT / 2);
+        VERIFY_ARE_EQUAL(inputBuffer.GetNumberOfReadyEvents(), expectedRemaining);
+        for (size_t i = 0; i < expectedRemaining; ++i)
+        {
+            VERIFY_ARE_EQUAL(inputBuffer._storage[i].Event.KeyEvent.uChar.UnicodeChar, nextRead);
+            nextRead = nextRead == L'z' ? L'a' : static_cast<WCHAR>(nextRead + 1);
+        }
+    }
+
 };
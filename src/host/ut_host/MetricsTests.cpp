@@ -0,0 +1,137 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "../../inc/consoletaeftemplates.hpp"
+
+#include "../../types/inc/Metrics.hpp"
+
+#include <thread>
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+using namespace Microsoft::Console::Types;
+
+class MetricsTests
+{
+    TEST_CLASS(MetricsTests);
+
+    TEST_METHOD_CLEANUP(MethodCleanup)
+    {
+        Metrics::SetEnabled(true);
+        return true;
+    }
+
+    TEST_METHOD(CountersAddUpAcrossThreads)
+    {
+        const auto before = Metrics::TakeSnapshot();
+
+        Log::Comment(L"Threads that already exited still count.");
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i)
+        {
+            threads.emplace_back([]() {
+                for (int j = 0; j < 1000; ++j)
+                {
+                    Metrics::Add(Metrics::Counter::CellsWritten, 3);
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        Metrics::Add(Metrics::Counter::CellsWritten);
+        Metrics::Add(Metrics::Counter::RowsScrolled, 2);
+
+        const auto delta = Metrics::TakeSnapshot().Since(before);
+        VERIFY_ARE_EQUAL(4u * 1000u * 3u + 1u, delta.Get(Metrics::Counter::CellsWritten));
+        VERIFY_ARE_EQUAL(2u, delta.Get(Metrics::Counter::RowsScrolled));
+    }
+
+    TEST_METHOD(HistogramsCountValuesByPowerOfTwo)
+    {
+        const auto before = Metrics::TakeSnapshot();
+        for (const uint64_t value : { 0u, 1u, 2u, 3u, 4u, 1000u })
+        {
+            Metrics::Record(Metrics::Histogram::PaintMicroseconds, value);
+        }
+        Metrics::Record(Metrics::Histogram::PaintMicroseconds, uint64_t{ 1 } << 40);
+
+        const auto histogram = Metrics::TakeSnapshot().Since(before).Get(Metrics::Histogram::PaintMicroseconds);
+        VERIFY_ARE_EQUAL(7u, histogram.count);
+        VERIFY_ARE_EQUAL(1010u + (uint64_t{ 1 } << 40), histogram.sum);
+        VERIFY_ARE_EQUAL(2u, histogram.buckets[0]); // 0 and 1
+        VERIFY_ARE_EQUAL(1u, histogram.buckets[1]); // 2
+        VERIFY_ARE_EQUAL(2u, histogram.buckets[2]); // 3 and 4
+        VERIFY_ARE_EQUAL(1u, histogram.buckets[10]); // 1000
+        VERIFY_ARE_EQUAL(1u, histogram.buckets[Metrics::s_bucketCount - 1]);
+
+        VERIFY_ARE_EQUAL(4u, histogram.Percentile(0.5));
+        VERIFY_ARE_EQUAL(1024u, histogram.Percentile(0.8));
+        VERIFY_ARE_EQUAL(uint64_t{ 1 } << (Metrics::s_bucketCount - 2), histogram.Percentile(1));
+        VERIFY_ARE_EQUAL(0u, Metrics::HistogramSnapshot{}.Percentile(0.5));
+    }
+
+    TEST_METHOD(BatchesRecordWhenPublished)
+    {
+        const auto before = Metrics::TakeSnapshot();
+
+        Metrics::CounterBatch batch;
+        batch.Add(Metrics::Counter::CsiDispatched);
+        batch.Add(Metrics::Counter::CsiDispatched, 4);
+        batch.Add(Metrics::Counter::CharactersParsed, 100);
+        VERIFY_ARE_EQUAL(0u, Metrics::TakeSnapshot().Since(before).Get(Metrics::Counter::CsiDispatched));
+
+        batch.Publish();
+        batch.Publish();
+        const auto delta = Metrics::TakeSnapshot().Since(before);
+        VERIFY_ARE_EQUAL(5u, delta.Get(Metrics::Counter::CsiDispatched));
+        VERIFY_ARE_EQUAL(100u, delta.Get(Metrics::Counter::CharactersParsed));
+    }
+
+    TEST_METHOD(DisabledRecordsNothing)
+    {
+        const auto before = Metrics::TakeSnapshot();
+
+        Metrics::SetEnabled(false);
+        Metrics::Add(Metrics::Counter::FramesPainted);
+        Metrics::Record(Metrics::Histogram::PaintMicroseconds, 10);
+        {
+            Metrics::ScopedLatency latency{ Metrics::Histogram::PaintMicroseconds };
+        }
+        Metrics::SetEnabled(true);
+
+        const auto delta = Metrics::TakeSnapshot().Since(before);
+        VERIFY_ARE_EQUAL(0u, delta.Get(Metrics::Counter::FramesPainted));
+        VERIFY_ARE_EQUAL(0u, delta.Get(Metrics::Histogram::PaintMicroseconds).count);
+
+        Log::Comment(L"Once enabled again, a scoped latency records when it goes out of scope.");
+        {
+            Metrics::ScopedLatency latency{ Metrics::Histogram::PaintMicroseconds };
+        }
+        VERIFY_ARE_EQUAL(1u, Metrics::TakeSnapshot().Since(before).Get(Metrics::Histogram::PaintMicroseconds).count);
+    }
+
+    TEST_METHOD(ToStringListsEveryValue)
+    {
+        Metrics::Snapshot snapshot{};
+        snapshot.counters[static_cast<size_t>(Metrics::Counter::CsiDispatched)] = 1024;
+        auto& histogram = snapshot.histograms[static_cast<size_t>(Metrics::Histogram::PaintMicroseconds)];
+        histogram.buckets[12] = 3;
+        histogram.count = 3;
+        histogram.sum = 9500;
+
+        const auto text = snapshot.ToString();
+        Log::Comment(text.c_str());
+        VERIFY_ARE_NOT_EQUAL(std::wstring::npos, text.find(L"characters_parsed 0\n"));
+        VERIFY_ARE_NOT_EQUAL(std::wstring::npos, text.find(L"csi_dispatched 1024\n"));
+        VERIFY_ARE_NOT_EQUAL(std::wstring::npos, text.find(L"frames_painted 0\n"));
+        VERIFY_ARE_NOT_EQUAL(std::wstring::npos, text.find(L"paint_us count=3 sum=9500 p50=4096 p90=4096 p99=4096\n"));
+        VERIFY_ARE_NOT_EQUAL(std::wstring::npos, text.find(L"paint_us{le=4096} 3\n"));
+        VERIFY_ARE_EQUAL(std::wstring::npos, text.find(L"paint_us{le=1}"));
+    }
+};
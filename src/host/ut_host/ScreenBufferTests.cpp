@@ -19,6 +19,7 @@
 #include "..\..\types\inc\Viewport.hpp"
 
 #include <sstream>
+#include <chrono>
 
 using namespace WEX::Common;
 using namespace WEX::Logging;
@@ -158,6 +159,10 @@ class ScreenBufferTests
     TEST_METHOD(ScrollUpInMargins);
     TEST_METHOD(ScrollDownInMargins);
 
+    TEST_METHOD(SgrDenseOutputPerf);
+
+    TEST_METHOD(FloodFastForwardsAndCatchesUp);
+
 };
 
 void ScreenBufferTests::SingleAlternateBufferCreationTest()
@@ -3015,3 +3020,98 @@ void ScreenBufferTests::ScrollDownInMargins()
         VERIFY_ARE_EQUAL(L"B" , iter5->Chars());
     }
 }
+
+void ScreenBufferTests::SgrDenseOutputPerf()
+{
+    BEGIN_TEST_METHOD_PROPERTIES()
+        TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+    END_TEST_METHOD_PROPERTIES()
+
+    CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    gci.LockConsole(); // Lock must be taken to manipulate buffer.
+    auto unlock = wil::scope_exit([&] { gci.UnlockConsole(); });
+
+    SCREEN_INFORMATION& si = gci.GetActiveOutputBuffer();
+    WI_SetFlag(si.OutputMode, ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+    StateMachine& stateMachine = si.GetStateMachine();
+    Cursor& cursor = si.GetTextBuffer().GetCursor();
+
+    // Every character gets its own rendition, with several options in each,
+    // like the output of a syntax highlighter or a colored diff.
+    const short width = si.GetTextBuffer().GetSize().Width();
+    std::wstringstream ss;
+    for (short x = 0; x < width - 1; ++x)
+    {
+        ss << L"\x1b[0;1;4;38;2;" << x << L";" << 255 - x << L";128;48;5;" << 16 + (x % 200) << L"m" << wchar_t(L'A' + (x % 26));
+    }
+    ss << L"\x1b[m\r\n";
+    const std::wstring line = ss.str();
+
+    const size_t lines = 2000;
+    const auto before = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lines; ++i)
+    {
+        stateMachine.ProcessString(line);
+    }
+    const auto delta = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - before).count();
+    Log::Comment(NoThrowString().Format(L"%zu lines of %zu renditions each: %lld ms",
+                                        lines,
+                                        static_cast<size_t>(width - 1),
+                                        delta));
+
+    Log::Comment(L"The last rendition of the last line ends up on its character.");
+    const short last = width - 2;
+    TextAttribute expected{};
+    expected.Embolden();
+    expected.SetMetaAttributes(COMMON_LVB_UNDERSCORE);
+    expected.SetForeground(RGB(last, 255 - last, 128));
+    expected.SetBackground(gci.GetColorTableEntry(16 + (last % 200)));
+
+    const ROW& row = si.GetTextBuffer().GetRowByOffset(cursor.GetPosition().Y - 1);
+    const std::vector<TextAttribute> attrs{ row.GetAttrRow().begin(), row.GetAttrRow().end() };
+    VERIFY_ARE_EQUAL(expected, attrs[last]);
+}
+
+void ScreenBufferTests::FloodFastForwardsAndCatchesUp()
+{
+    CONSOLE_INFORMATION& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+    gci.LockConsole(); // Lock must be taken to manipulate buffer.
+    auto unlock = wil::scope_exit([&] { gci.UnlockConsole(); });
+
+    SCREEN_INFORMATION& si = gci.GetActiveOutputBuffer();
+    const TextBuffer& tbi = si.GetTextBuffer();
+    Cursor& cursor = si.GetTextBuffer().GetCursor();
+    si.NotifyFrameStarted();
+
+    Log::Comment(L"Write many more screens of output in one go than fast-forwarding needs.");
+    const size_t lines = 1000;
+    std::wstringstream ss;
+    for (size_t i = 0; i < lines; ++i)
+    {
+        ss << L"line " << i << L"\r\n";
+    }
+    const std::wstring text = ss.str();
+    size_t cb = text.size() * sizeof(wchar_t);
+    VERIFY_SUCCESS_NTSTATUS(WriteChars(si, text.data(), text.data(), text.data(), &cb, nullptr, cursor.GetPosition().X, 0, nullptr));
+
+    VERIFY_IS_GREATER_THAN(si._rowsScrolledSinceFrame, SCREEN_INFORMATION::s_fastForwardScreens * si.GetViewport().Height());
+
+    Log::Comment(L"Once the write is over, nothing is left fast-forwarding.");
+    VERIFY_ARE_EQUAL(0u, si._writeDepth);
+    VERIFY_IS_FALSE(si._fastForwarding);
+
+    Log::Comment(L"The output and the cursor are where they'd be without fast-forwarding.");
+    VERIFY_ARE_EQUAL(0, cursor.GetPosition().X);
+    VERIFY_IS_TRUE(si.GetViewport().IsInBounds(cursor.GetPosition()));
+    for (size_t i = 1; i <= 3; ++i)
+    {
+        const auto expected = L"line " + std::to_wstring(lines - i);
+        auto iter = tbi.GetTextDataAt({ 0, gsl::narrow<SHORT>(cursor.GetPosition().Y - i) });
+        std::wstring actual;
+        for (size_t x = 0; x < expected.size(); ++x, ++iter)
+        {
+            actual += *iter;
+        }
+        VERIFY_ARE_EQUAL(expected, actual);
+    }
+}
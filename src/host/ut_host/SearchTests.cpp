@@ -8,6 +8,10 @@
 #include "CommonState.hpp"
 
 #include "search.h"
+#include "..\..\buffer\out\textBufferMatchIndex.hpp"
+#include "..\..\buffer\out\textBufferRegexSearch.hpp"
+
+#include <chrono>
 
 using namespace WEX::Common;
 using namespace WEX::Logging;
@@ -163,4 +167,342 @@ class SearchTests
         Search s(outputBuffer, L"\x304b", Search::Direction::Backward, Search::Sensitivity::CaseInsensitive);
         DoFoundChecks(s, coordStartExpected, -1);
     }
+
+    TEST_METHOD(ForwardAcrossRows)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        auto& outputBuffer = gci.GetActiveOutputBuffer();
+        auto& textBuffer = outputBuffer.GetTextBuffer();
+        const auto column = static_cast<SHORT>(textBuffer.GetSize().Width() - 2);
+
+        Log::Comment(L"A match may continue from the end of one row onto the next.");
+        textBuffer.WriteLine(OutputCellIterator(L"fo"), { column, 10 });
+        textBuffer.WriteLine(OutputCellIterator(L"x"), { 0, 11 });
+
+        Search s(outputBuffer, L"fox", Search::Direction::Forward, Search::Sensitivity::CaseSensitive);
+        VERIFY_IS_TRUE(s.FindNext());
+        VERIFY_ARE_EQUAL((COORD{ column, 10 }), s._coordSelStart);
+        VERIFY_ARE_EQUAL((COORD{ 0, 11 }), s._coordSelEnd);
+        VERIFY_IS_FALSE(s.FindNext());
+    }
+
+    TEST_METHOD(BackwardFromAnchorWrapsAround)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        auto& outputBuffer = gci.GetActiveOutputBuffer();
+
+        Log::Comment(L"Searching up from the second row should find row 0, then wrap around to the last match.");
+        Search s(outputBuffer, L"AB", Search::Direction::Backward, Search::Sensitivity::CaseSensitive, { 0, 1 });
+        VERIFY_IS_TRUE(s.FindNext());
+        VERIFY_ARE_EQUAL((COORD{ 0, 1 }), s._coordSelStart);
+        VERIFY_IS_TRUE(s.FindNext());
+        VERIFY_ARE_EQUAL((COORD{ 0, 0 }), s._coordSelStart);
+        VERIFY_IS_TRUE(s.FindNext());
+        VERIFY_ARE_EQUAL((COORD{ 0, 3 }), s._coordSelStart);
+    }
+
+    TEST_METHOD(MatchIndexFindsAll)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        const auto& textBuffer = gci.GetActiveOutputBuffer().GetTextBuffer();
+
+        TextBufferMatchIndex index(textBuffer, true);
+        index.SetQuery(L"b\x304b");
+        VERIFY_ARE_EQUAL(4u, index.Count());
+        VERIFY_ARE_EQUAL(3u, index.NeedleCells());
+
+        const auto matches = index.GetMatches();
+        VERIFY_ARE_EQUAL(4u, matches.size());
+        for (SHORT y = 0; y < 4; ++y)
+        {
+            VERIFY_ARE_EQUAL((COORD{ 1, y }), matches.at(y).first);
+            VERIFY_ARE_EQUAL((COORD{ 3, y }), matches.at(y).second);
+            VERIFY_ARE_EQUAL(1u, index.MatchesInRow(y).size());
+        }
+        VERIFY_IS_TRUE(index.MatchesInRow(4).empty());
+
+        index.SetQuery(L"");
+        VERIFY_ARE_EQUAL(0u, index.Count());
+    }
+
+    TEST_METHOD(MatchIndexNarrowsAsQueryGrows)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        auto& textBuffer = gci.GetActiveOutputBuffer().GetTextBuffer();
+        textBuffer.WriteLine(OutputCellIterator(L"ABC AB A"), { 20, 2 });
+
+        Log::Comment(L"Typing a character at a time must give the same matches as searching from scratch.");
+        TextBufferMatchIndex typed(textBuffer, false);
+        const std::wstring query = L"ABC";
+        for (const auto length : { 1u, 2u, 3u, 2u, 3u })
+        {
+            const auto prefix = query.substr(0, length);
+            typed.SetQuery(prefix);
+
+            TextBufferMatchIndex fresh(textBuffer, false);
+            fresh.SetQuery(prefix);
+
+            VERIFY_ARE_EQUAL(fresh.Count(), typed.Count());
+            VERIFY_IS_TRUE(fresh.GetMatches() == typed.GetMatches());
+        }
+        VERIFY_ARE_EQUAL(1u, typed.Count());
+        VERIFY_ARE_EQUAL((COORD{ 20, 2 }), typed.GetMatches().at(0).first);
+    }
+
+    TEST_METHOD(MatchIndexRefreshesInvalidatedRows)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        auto& textBuffer = gci.GetActiveOutputBuffer().GetTextBuffer();
+        const auto column = static_cast<SHORT>(textBuffer.GetSize().Width() - 1);
+
+        TextBufferMatchIndex index(textBuffer, false);
+        index.SetQuery(L"DE");
+        VERIFY_ARE_EQUAL(4u, index.Count());
+
+        Log::Comment(L"New matches only show up once their rows are invalidated and refreshed.");
+        textBuffer.WriteLine(OutputCellIterator(L"DE"), { 30, 10 });
+        textBuffer.WriteLine(OutputCellIterator(L"D"), { column, 20 });
+        textBuffer.WriteLine(OutputCellIterator(L"E"), { 0, 21 });
+        VERIFY_ARE_EQUAL(4u, index.Count());
+
+        index.InvalidateRows(10, 10);
+        index.InvalidateRows(21, 21);
+        index.Refresh();
+        VERIFY_ARE_EQUAL(6u, index.Count());
+        VERIFY_ARE_EQUAL(1u, index.MatchesInRow(10).size());
+        VERIFY_ARE_EQUAL(static_cast<SHORT>(30), index.MatchesInRow(10).at(0));
+        VERIFY_ARE_EQUAL(1u, index.MatchesInRow(20).size());
+        VERIFY_ARE_EQUAL(column, index.MatchesInRow(20).at(0));
+
+        Log::Comment(L"Matches disappear from rows that are overwritten.");
+        textBuffer.WriteLine(OutputCellIterator(L"  "), { 11, 0 });
+        index.InvalidateRows(0, 0);
+        index.Refresh();
+        VERIFY_ARE_EQUAL(5u, index.Count());
+        VERIFY_IS_TRUE(index.MatchesInRow(0).empty());
+    }
+
+    static std::vector<std::pair<COORD, COORD>> FindAllRegex(const TextBufferRegexSearch& search, const size_t workers)
+    {
+        std::vector<std::pair<COORD, COORD>> matches;
+        const auto collect = [&](const COORD start, const COORD end) {
+            matches.emplace_back(start, end);
+            return true;
+        };
+        search.FindAll(collect, workers);
+        return matches;
+    }
+
+    TEST_METHOD(RegexFindsWideGlyphs)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        const auto& textBuffer = gci.GetActiveOutputBuffer().GetTextBuffer();
+
+        TextBufferRegexSearch search(textBuffer, L"b\x304b+C", true);
+        const auto matches = FindAllRegex(search, 1);
+
+        VERIFY_ARE_EQUAL(4u, matches.size());
+        for (SHORT y = 0; y < 4; ++y)
+        {
+            VERIFY_ARE_EQUAL((COORD{ 1, y }), matches.at(y).first);
+            VERIFY_ARE_EQUAL((COORD{ 6, y }), matches.at(y).second);
+        }
+    }
+
+    TEST_METHOD(RegexFindsAcrossWrappedRows)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        auto& textBuffer = gci.GetActiveOutputBuffer().GetTextBuffer();
+        const auto column = static_cast<SHORT>(textBuffer.GetSize().Width() - 4);
+
+        textBuffer.WriteLine(OutputCellIterator(L"ERR-"), { column, 10 });
+        textBuffer.WriteLine(OutputCellIterator(L"1234"), { 0, 11 });
+
+        TextBufferRegexSearch search(textBuffer, L"ERR-\\d{4}$", false);
+
+        Log::Comment(L"Rows that didn't wrap are separate lines.");
+        VERIFY_IS_TRUE(FindAllRegex(search, 1).empty());
+
+        Log::Comment(L"Once the row has wrapped the match runs onto the next one.");
+        textBuffer.GetRowByOffset(10).GetCharRow().SetWrapForced(true);
+        const auto matches = FindAllRegex(search, 1);
+        VERIFY_ARE_EQUAL(1u, matches.size());
+        VERIFY_ARE_EQUAL((COORD{ column, 10 }), matches.at(0).first);
+        VERIFY_ARE_EQUAL((COORD{ 3, 11 }), matches.at(0).second);
+    }
+
+    TEST_METHOD(RegexWorkersDeliverInOrder)
+    {
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        auto& textBuffer = gci.GetActiveOutputBuffer().GetTextBuffer();
+        const auto height = textBuffer.GetSize().Height();
+
+        for (SHORT y = 0; y < height; y += 3)
+        {
+            textBuffer.WriteLine(OutputCellIterator(L"id=" + std::to_wstring(y * 7)), { 5, y });
+        }
+        // Wrap a few rows across the boundary between two chunks.
+        for (auto y = TextBufferRegexSearch::s_chunkRows - 2; y < TextBufferRegexSearch::s_chunkRows + 2; ++y)
+        {
+            textBuffer.GetRowByOffset(y).GetCharRow().SetWrapForced(true);
+        }
+
+        TextBufferRegexSearch search(textBuffer, L"id=\\d*[05]", false);
+        const auto expected = FindAllRegex(search, 1);
+        VERIFY_IS_FALSE(expected.empty());
+
+        for (const size_t workers : { 2u, 3u, 8u })
+        {
+            VERIFY_IS_TRUE(expected == FindAllRegex(search, workers), NoThrowString().Format(L"%zu workers", workers));
+        }
+
+        Log::Comment(L"Returning false stops the search.");
+        size_t delivered = 0;
+        search.FindAll([&](const COORD, const COORD) { return ++delivered < 3; }, 4);
+        VERIFY_ARE_EQUAL(3u, delivered);
+    }
+
+    TEST_METHOD(SearchFullScrollbackPerf)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD_PROPERTIES()
+
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        auto& outputBuffer = gci.GetActiveOutputBuffer();
+
+        const COORD size{ 120, 9999 };
+        TextBuffer textBuffer(size, TextAttribute{}, 12, outputBuffer.GetRenderTarget());
+        const std::wstring line = L"The quick brown fox jumps over the lazy dog. 0123456789 \x304b\x304d ";
+        for (SHORT y = 0; y < size.Y; ++y)
+        {
+            textBuffer.WriteLine(OutputCellIterator(line), { 0, y });
+        }
+        textBuffer.WriteLine(OutputCellIterator(L"needle"), { 100, static_cast<SHORT>(size.Y - 1) });
+
+        const size_t cells = static_cast<size_t>(size.X) * size.Y;
+        const size_t iterations = 10;
+        for (const auto needle : { L"needle", L"haystack" })
+        {
+            for (const bool caseInsensitive : { false, true })
+            {
+                bool found = false;
+                const auto before = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < iterations; ++i)
+                {
+                    TextBufferSearch search(textBuffer, needle, caseInsensitive);
+                    found = search.FindForward({ 0, 0 }, cells).has_value();
+                }
+                const auto delta = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before).count();
+
+                Log::Comment(NoThrowString().Format(L"%s %s (%s): %lld us per search of %zu cells",
+                                                    found ? L"Hit" : L"Miss",
+                                                    needle,
+                                                    caseInsensitive ? L"case insensitive" : L"case sensitive",
+                                                    delta / iterations,
+                                                    cells));
+            }
+        }
+    }
+
+    TEST_METHOD(MatchIndexTypingPerf)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD_PROPERTIES()
+
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        auto& outputBuffer = gci.GetActiveOutputBuffer();
+
+        const COORD size{ 120, 30000 };
+        TextBuffer textBuffer(size, TextAttribute{}, 12, outputBuffer.GetRenderTarget());
+        const std::wstring line = L"The quick brown fox jumps over the lazy dog. 0123456789 \x304b\x304d ";
+        for (SHORT y = 0; y < size.Y; ++y)
+        {
+            textBuffer.WriteLine(OutputCellIterator(line), { 0, y });
+        }
+
+        Log::Comment(L"Typing the query one character at a time. Only the first keystroke searches the whole buffer.");
+        TextBufferMatchIndex index(textBuffer, true);
+        const std::wstring query = L"quick brown fox";
+        for (size_t length = 1; length <= query.size(); ++length)
+        {
+            const auto prefix = query.substr(0, length);
+            const auto before = std::chrono::steady_clock::now();
+            index.SetQuery(prefix);
+            const auto delta = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before).count();
+
+            Log::Comment(NoThrowString().Format(L"\"%s\": %zu matches in %lld us", prefix.c_str(), index.Count(), delta));
+        }
+
+        Log::Comment(L"Output that changes a single row only rescans that row.");
+        const size_t iterations = 1000;
+        const auto before = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            const auto row = static_cast<SHORT>(i * 29 % size.Y);
+            textBuffer.WriteLine(OutputCellIterator(line), { 0, row });
+            index.InvalidateRows(row, row);
+            index.Refresh();
+        }
+        const auto delta = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before).count();
+
+        Log::Comment(NoThrowString().Format(L"%lld us per row refresh", delta / iterations));
+    }
+
+    TEST_METHOD(RegexSearchScalingPerf)
+    {
+        BEGIN_TEST_METHOD_PROPERTIES()
+            TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+        END_TEST_METHOD_PROPERTIES()
+
+        auto& gci = ServiceLocator::LocateGlobals().getConsoleInformation();
+        auto& outputBuffer = gci.GetActiveOutputBuffer();
+
+        // A buffer can't be taller than a SHORT, so the full buffer is
+        // searched several times over to cover a million lines.
+        const COORD size{ 120, 32000 };
+        const size_t passes = 32;
+        TextBuffer textBuffer(size, TextAttribute{}, 12, outputBuffer.GetRenderTarget());
+        for (SHORT y = 0; y < size.Y; ++y)
+        {
+            auto line = L"12:00:00.000 INFO request req-" + std::to_wstring(1000000 + y * 37) + L" handled in 12ms";
+            if (y % 1000 == 0)
+            {
+                line += L" ERR-" + std::to_wstring(4000 + y / 1000);
+            }
+            textBuffer.WriteLine(OutputCellIterator(line), { 0, y });
+        }
+
+        TextBufferRegexSearch search(textBuffer, L"ERR-\\d{4}|req-10000\\d\\d\\b", false);
+        const auto processors = std::max(1u, std::thread::hardware_concurrency());
+
+        long long baseline = 0;
+        for (size_t workers = 1; workers <= processors; workers *= 2)
+        {
+            size_t found = 0;
+            const auto count = [&](const COORD, const COORD) {
+                ++found;
+                return true;
+            };
+
+            const auto before = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < passes; ++i)
+            {
+                search.FindAll(count, workers);
+            }
+            const auto delta = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before).count();
+            if (workers == 1)
+            {
+                baseline = delta;
+            }
+
+            Log::Comment(NoThrowString().Format(L"%zu workers: %zu matches in %zu lines, %lld ms, %.2fx",
+                                                workers,
+                                                found / passes,
+                                                passes * size.Y,
+                                                delta / 1000,
+                                                static_cast<double>(baseline) / std::max(1ll, delta)));
+        }
+    }
 };
@@ -10,6 +10,10 @@
 #include "globals.h"
 #include "../buffer/out/textBuffer.hpp"
 #include "../buffer/out/CharRow.hpp"
+#include "../buffer/out/textBufferExport.hpp"
+#include "../buffer/out/textBufferReflow.hpp"
+#include "../buffer/out/textBufferSnapshot.hpp"
+#include "../buffer/out/textBufferSpill.hpp"
 
 #include "input.h"
 #include "_stream.h"
@@ -17,6 +21,10 @@
 #include "../interactivity/inc/ServiceLocator.hpp"
 #include "../renderer/inc/DummyRenderTarget.hpp"
 
+#include <chrono>
+#include <fstream>
+#include <thread>
+
 using namespace Microsoft::Console::Types;
 using namespace WEX::Common;
 using namespace WEX::Logging;
@@ -142,6 +150,55 @@ class TextBufferTests
 
     TEST_METHOD(TestBurrito);
 
+    TEST_METHOD(ReflowRewrapsLines);
+    TEST_METHOD(ReflowMovesWideAndHighUnicodeGlyphs);
+    TEST_METHOD(ReflowThatFailsLeavesTheBufferAsItWas);
+    TEST_METHOD(ReflowPerf);
+
+    TEST_METHOD(ExportResolvesColorsPerRun);
+    TEST_METHOD(ExportEscapesMarkup);
+    TEST_METHOD(ExportPerf);
+
+    TEST_METHOD(WriteCharInfoLineMatchesWriteLine);
+
+    TEST_METHOD(ReplaceAttributesRecolorsEveryRow);
+
+    TEST_METHOD(RowsChangedSinceGeneration);
+    TEST_METHOD(RowHashFollowsContents);
+    TEST_METHOD(GenerationWritePerf);
+
+    TEST_METHOD(SnapshotRoundTrips);
+    TEST_METHOD(SnapshotKeepsRowsThatScrolledOut);
+    TEST_METHOD(SnapshotKeepsRowsCutOffByResizing);
+    TEST_METHOD(SnapshotRejectsIncompleteFile);
+    TEST_METHOD(SnapshotSurvivesInterruptedCommit);
+    TEST_METHOD(SnapshotRewritesFileOfReplacedRows);
+    TEST_METHOD(SnapshotRestoresOlderRowsToTheSpill);
+    TEST_METHOD(SnapshotPerf);
+
+    TEST_METHOD(SpilledRowsReadBack);
+    TEST_METHOD(SpilledRowsFollowBufferWidth);
+    TEST_METHOD(SpilledRowsIncludeRowsCutOffByResizing);
+    TEST_METHOD(SpilledRowsReadFromManyThreads);
+    TEST_METHOD(SpilledRowsAreAboveRowZero);
+    TEST_METHOD(PinnedSpilledRowsStayCached);
+    TEST_METHOD(SpilledRowsReflowWithTheBuffer);
+    TEST_METHOD(SpillAppendPerf);
+    TEST_METHOD(SpillScrollUpPerf);
+
+    // A file in the temp directory for a test to write. The test deletes it.
+    static std::wstring _TempPath(const wchar_t* const name)
+    {
+        return (std::filesystem::temp_directory_path() / name).wstring();
+    }
+
+    static std::wstring _SpilledText(const TextBuffer& buffer, const size_t index)
+    {
+        std::wstring text;
+        buffer.ReadSpilledRow(index, [&](const ROW& row) { text = row.GetText(); });
+        return text;
+    }
+
 };
 
 void TextBufferTests::TestBufferCreate()
@@ -1964,3 +2021,1380 @@ void TextBufferTests::TestBurrito()
     _buffer->IncrementCursor();
     VERIFY_IS_FALSE(afterBurritoIter);
 }
+
+void TextBufferTests::ReflowRewrapsLines()
+{
+    const COORD bufferSize{ 20, 10 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    const auto rowText = [&](const size_t row) {
+        auto text = _buffer->GetRowByOffset(row).GetText();
+        text.erase(text.find_last_not_of(L' ') + 1);
+        return text;
+    };
+
+    // One line of 30 characters that wrapped, then a short line with the cursor after it.
+    const std::wstring digits = L"012345678901234567890123456789";
+    _buffer->WriteLine(OutputCellIterator(digits.substr(0, 20)), { 0, 0 });
+    _buffer->GetRowByOffset(0).GetCharRow().SetWrapForced(true);
+    _buffer->WriteLine(OutputCellIterator(digits.substr(20)), { 0, 1 });
+    _buffer->WriteLine(OutputCellIterator(L"xyz"), { 0, 2 });
+    _buffer->GetCursor().SetPosition({ 3, 2 });
+
+    Log::Comment(L"Narrower: the long line takes three rows.");
+    TextBufferReflow{ *_buffer, { 12, 10 } }.Run();
+    VERIFY_ARE_EQUAL(12, _buffer->GetSize().Width());
+    VERIFY_ARE_EQUAL(10, _buffer->GetSize().Height());
+    VERIFY_ARE_EQUAL(std::wstring{ L"012345678901" }, rowText(0));
+    VERIFY_ARE_EQUAL(std::wstring{ L"234567890123" }, rowText(1));
+    VERIFY_ARE_EQUAL(std::wstring{ L"456789" }, rowText(2));
+    VERIFY_ARE_EQUAL(std::wstring{ L"xyz" }, rowText(3));
+    VERIFY_IS_TRUE(_buffer->GetRowByOffset(0).GetCharRow().WasWrapForced());
+    VERIFY_IS_TRUE(_buffer->GetRowByOffset(1).GetCharRow().WasWrapForced());
+    VERIFY_IS_FALSE(_buffer->GetRowByOffset(2).GetCharRow().WasWrapForced());
+    VERIFY_ARE_EQUAL(COORD({ 3, 3 }), _buffer->GetCursor().GetPosition());
+
+    Log::Comment(L"Wider: the long line fits on one row again.");
+    TextBufferReflow{ *_buffer, { 40, 10 } }.Run();
+    VERIFY_ARE_EQUAL(digits, rowText(0));
+    VERIFY_ARE_EQUAL(std::wstring{ L"xyz" }, rowText(1));
+    VERIFY_IS_FALSE(_buffer->GetRowByOffset(0).GetCharRow().WasWrapForced());
+    VERIFY_ARE_EQUAL(COORD({ 3, 1 }), _buffer->GetCursor().GetPosition());
+
+    Log::Comment(L"Too short: the rows that don't fit fall off the top.");
+    TextBufferReflow{ *_buffer, { 5, 4 } }.Run();
+    VERIFY_ARE_EQUAL(std::wstring{ L"56789" }, rowText(0));
+    VERIFY_ARE_EQUAL(std::wstring{ L"01234" }, rowText(1));
+    VERIFY_ARE_EQUAL(std::wstring{ L"56789" }, rowText(2));
+    VERIFY_ARE_EQUAL(std::wstring{ L"xyz" }, rowText(3));
+    VERIFY_IS_TRUE(_buffer->GetRowByOffset(0).GetCharRow().WasWrapForced());
+    VERIFY_ARE_EQUAL(COORD({ 3, 3 }), _buffer->GetCursor().GetPosition());
+}
+
+void TextBufferTests::ReflowMovesWideAndHighUnicodeGlyphs()
+{
+    const COORD bufferSize{ 30, 10 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    // This is the peach emoji: 🍑
+    const auto emoji = L"\xD83C\xDF51";
+
+    // Fourteen narrow cells, a wide glyph, the emoji (stored outside the row) and one more cell.
+    _buffer->WriteLine(OutputCellIterator(L"abcdefghijklmn\x304b"), { 0, 0 });
+    _buffer->GetRowByOffset(0).GetCharRow().GlyphAt(16) = emoji;
+    _buffer->WriteLine(OutputCellIterator(L"z"), { 17, 0 });
+    _buffer->GetCursor().SetPosition({ 18, 0 });
+
+    Log::Comment(L"At 15 columns the wide glyph no longer fits at the end of the first row.");
+    TextBufferReflow{ *_buffer, { 15, 10 } }.Run();
+
+    const auto& firstRow = _buffer->GetRowByOffset(0).GetCharRow();
+    VERIFY_IS_TRUE(firstRow.WasWrapForced());
+    VERIFY_IS_TRUE(firstRow.WasDoubleBytePadded());
+
+    const auto& secondRow = _buffer->GetRowByOffset(1).GetCharRow();
+    VERIFY_IS_TRUE(secondRow.DbcsAttrAt(0).IsLeading());
+    VERIFY_IS_TRUE(secondRow.DbcsAttrAt(1).IsTrailing());
+
+    const auto readBack = *_buffer->GetTextDataAt({ 2, 1 });
+    VERIFY_ARE_EQUAL(String(emoji), String(readBack.data(), gsl::narrow<int>(readBack.size())));
+    VERIFY_ARE_EQUAL(1u, _buffer->GetUnicodeStorage()._map.size());
+    VERIFY_ARE_EQUAL(L'z', std::wstring_view(secondRow.GlyphAt(3)).front());
+    VERIFY_ARE_EQUAL(COORD({ 4, 1 }), _buffer->GetCursor().GetPosition());
+}
+
+void TextBufferTests::ReflowThatFailsLeavesTheBufferAsItWas()
+{
+    const COORD bufferSize{ 20, 10 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    const TextAttribute red{ 0x4c };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    const auto rowText = [&](const size_t row) {
+        auto text = _buffer->GetRowByOffset(row).GetText();
+        text.erase(text.find_last_not_of(L' ') + 1);
+        return text;
+    };
+
+    // This is the peach emoji: 🍑
+    const auto emoji = L"\xD83C\xDF51";
+
+    // Start the buffer partway around its storage.
+    for (int i = 0; i < 3; ++i)
+    {
+        VERIFY_IS_TRUE(_buffer->IncrementCircularBuffer());
+    }
+
+    // A short line, a line of 30 characters that wrapped, and a red line with
+    // a glyph stored outside its row.
+    const std::wstring digits = L"012345678901234567890123456789";
+    _buffer->WriteLine(OutputCellIterator(L"top"), { 0, 0 });
+    _buffer->WriteLine(OutputCellIterator(digits.substr(0, 20)), { 0, 1 });
+    _buffer->GetRowByOffset(1).GetCharRow().SetWrapForced(true);
+    _buffer->WriteLine(OutputCellIterator(digits.substr(20)), { 0, 2 });
+    _buffer->WriteLine(OutputCellIterator(L"xyz", red), { 0, 3 });
+    _buffer->GetRowByOffset(3).GetCharRow().GlyphAt(3) = emoji;
+    _buffer->GetCursor().SetPosition({ 4, 3 });
+
+    // The top row claims a glyph that was never stored, so copying it out
+    // fails after the lines below it were laid out in their reused rows.
+    _buffer->GetRowByOffset(0).GetCharRow().DbcsAttrAt(1).SetGlyphStored(true);
+
+    VERIFY_FAILED(_buffer->ResizeWithReflow({ 12, 10 }));
+
+    VERIFY_ARE_EQUAL(20, _buffer->GetSize().Width());
+    VERIFY_ARE_EQUAL(10, _buffer->GetSize().Height());
+    VERIFY_ARE_EQUAL(3, _buffer->GetFirstRowIndex());
+    VERIFY_IS_TRUE(_buffer->GetRowByOffset(0).GetCharRow().DbcsAttrAt(1).IsGlyphStored());
+    VERIFY_ARE_EQUAL(digits.substr(0, 20), rowText(1));
+    VERIFY_ARE_EQUAL(digits.substr(20), rowText(2));
+    VERIFY_IS_TRUE(_buffer->GetRowByOffset(1).GetCharRow().WasWrapForced());
+    VERIFY_IS_FALSE(_buffer->GetRowByOffset(2).GetCharRow().WasWrapForced());
+
+    const auto readBack = *_buffer->GetTextDataAt({ 3, 3 });
+    VERIFY_ARE_EQUAL(String(emoji), String(readBack.data(), gsl::narrow<int>(readBack.size())));
+    VERIFY_ARE_EQUAL(red, _buffer->GetRowByOffset(3).GetAttrRow().GetAttrByColumn(0));
+    VERIFY_ARE_EQUAL(attr, _buffer->GetRowByOffset(3).GetAttrRow().GetAttrByColumn(10));
+    VERIFY_ARE_EQUAL(std::wstring{}, rowText(9));
+    VERIFY_ARE_EQUAL(COORD({ 4, 3 }), _buffer->GetCursor().GetPosition());
+
+    Log::Comment(L"The rows that were put back together reflow like any others.");
+    _buffer->GetRowByOffset(0).GetCharRow().DbcsAttrAt(1).SetGlyphStored(false);
+    VERIFY_SUCCEEDED(_buffer->ResizeWithReflow({ 12, 10 }));
+    VERIFY_ARE_EQUAL(std::wstring{ L"top" }, rowText(0));
+    VERIFY_ARE_EQUAL(std::wstring{ L"012345678901" }, rowText(1));
+    VERIFY_ARE_EQUAL(std::wstring{ L"456789" }, rowText(3));
+    VERIFY_ARE_EQUAL(COORD({ 4, 4 }), _buffer->GetCursor().GetPosition());
+}
+
+void TextBufferTests::ReflowPerf()
+{
+    BEGIN_TEST_METHOD_PROPERTIES()
+        TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+    END_TEST_METHOD_PROPERTIES()
+
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    const std::wstring line(120, L'x');
+    const size_t resizes = 10;
+
+    // Drag the window edge back and forth over buffers with more and more scrollback.
+    for (const SHORT height : { 1000, 3000, 9001, 30000 })
+    {
+        auto _buffer = std::make_unique<TextBuffer>(COORD{ 120, height }, attr, cursorSize, _renderTarget);
+        for (SHORT y = 0; y < height; ++y)
+        {
+            _buffer->WriteLine(OutputCellIterator(line), { 0, y });
+            // Pair rows up into lines that wrapped.
+            _buffer->GetRowByOffset(y).GetCharRow().SetWrapForced(y % 2 == 0);
+        }
+        _buffer->GetCursor().SetPosition({ 0, static_cast<SHORT>(height - 1) });
+
+        const auto before = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < resizes; ++i)
+        {
+            const SHORT width = i % 2 == 0 ? 110 : 120;
+            TextBufferReflow{ *_buffer, { width, height } }.Run();
+        }
+        const auto delta = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before).count();
+
+        Log::Comment(NoThrowString().Format(L"%d rows: %lld us per resize", height, delta / resizes));
+    }
+}
+
+void TextBufferTests::ExportResolvesColorsPerRun()
+{
+    const COORD bufferSize{ 20, 10 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    std::vector<SMALL_RECT> selection;
+    for (SHORT y = 0; y < 10; ++y)
+    {
+        _buffer->WriteLine(OutputCellIterator(L"0123456789"), { 0, y });
+        selection.push_back({ 0, y, 19, y });
+    }
+    // One differently colored run in the middle of the fifth row.
+    _buffer->GetRowByOffset(4).GetAttrRow().SetAttrToEnd(3, TextAttribute{ 0x1f });
+    _buffer->GetRowByOffset(4).GetAttrRow().SetAttrToEnd(6, attr);
+
+    size_t lookups = 0;
+    const TextBufferExport::ColorFn getForegroundColor = [&](TextAttribute& runAttr) {
+        ++lookups;
+        return runAttr.GetLegacyAttributes() == 0x1f ? RGB(0xff, 0xff, 0xff) : RGB(0xc0, 0xc0, 0xc0);
+    };
+    const TextBufferExport::ColorFn getBackgroundColor = [](TextAttribute& runAttr) {
+        return runAttr.GetLegacyAttributes() == 0x1f ? RGB(0x00, 0x00, 0x80) : RGB(0x00, 0x00, 0x00);
+    };
+
+    const TextBufferExport exporter{ *_buffer, selection, false, true };
+
+    const auto html = exporter.Html(getForegroundColor, getBackgroundColor, 12, L"Consolas");
+    Log::Comment(L"Colors are only looked up again where the attributes change.");
+    VERIFY_ARE_EQUAL(3u, lookups);
+    VERIFY_ARE_NOT_EQUAL(std::string::npos, html.find("color:#ffffff;background-color:#000080"));
+
+    lookups = 0;
+    const auto rtf = exporter.Rtf(getForegroundColor, getBackgroundColor, 12, L"Consolas");
+    VERIFY_ARE_EQUAL(3u, lookups);
+    VERIFY_ARE_NOT_EQUAL(std::string::npos, rtf.find("{\\colortbl ;\\red192\\green192\\blue192;\\red0\\green0\\blue0;\\red255\\green255\\blue255;\\red0\\green0\\blue128;}"));
+}
+
+void TextBufferTests::ExportEscapesMarkup()
+{
+    const COORD bufferSize{ 20, 10 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    _buffer->WriteLine(OutputCellIterator(L"<a & b>"), { 0, 0 });
+    _buffer->WriteLine(OutputCellIterator(L"{c:\\}"), { 0, 1 });
+
+    const TextBufferExport::ColorFn getColor = [](TextAttribute&) { return RGB(0, 0, 0); };
+    const TextBufferExport exporter{ *_buffer, { { 0, 0, 19, 0 }, { 0, 1, 19, 1 } }, false, true };
+
+    VERIFY_ARE_EQUAL(std::wstring{ L"<a & b>\r\n{c:\\}" }, exporter.Text());
+
+    const auto html = exporter.Html(getColor, getColor, 12, L"Consolas");
+    VERIFY_ARE_NOT_EQUAL(std::string::npos, html.find("&lt;a &amp; b&gt;\r\n{c:\\}"));
+
+    const auto rtf = exporter.Rtf(getColor, getColor, 12, L"Consolas");
+    VERIFY_ARE_NOT_EQUAL(std::string::npos, rtf.find("<a & b>\\line \\{c:\\\\\\}"));
+}
+
+void TextBufferTests::ExportPerf()
+{
+    BEGIN_TEST_METHOD_PROPERTIES()
+        TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+    END_TEST_METHOD_PROPERTIES()
+
+    // The tallest buffer there is. Copying it all stands in for a very large selection.
+    const SHORT height = SHRT_MAX;
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto _buffer = std::make_unique<TextBuffer>(COORD{ 120, height }, attr, cursorSize, _renderTarget);
+
+    // Every row gets 100 characters in four colors, like a colored log.
+    const std::wstring line = L"2019-05-06 12:34:56.789 [info] component: a line of log output that goes on for a while ......";
+    std::vector<SMALL_RECT> selection;
+    selection.reserve(height);
+    for (SHORT y = 0; y < height; ++y)
+    {
+        _buffer->WriteLine(OutputCellIterator(line), { 0, y });
+        auto& attrRow = _buffer->GetRowByOffset(y).GetAttrRow();
+        attrRow.SetAttrToEnd(24, TextAttribute{ 0x0a });
+        attrRow.SetAttrToEnd(30, TextAttribute{ 0x0e });
+        attrRow.SetAttrToEnd(41, attr);
+        selection.push_back({ 0, y, 119, y });
+    }
+
+    const TextBufferExport::ColorFn getForegroundColor = [](TextAttribute& runAttr) { return static_cast<COLORREF>(runAttr.GetLegacyAttributes() & 0x0f); };
+    const TextBufferExport::ColorFn getBackgroundColor = [](TextAttribute& runAttr) { return static_cast<COLORREF>(runAttr.GetLegacyAttributes() >> 4); };
+
+    const TextBufferExport exporter{ *_buffer, selection, false, true };
+
+    const auto measure = [](const wchar_t* const format, const auto& produce) {
+        const auto before = std::chrono::steady_clock::now();
+        const auto result = produce();
+        const auto delta = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - before).count();
+        const auto bytes = result.size() * sizeof(result[0]);
+        Log::Comment(NoThrowString().Format(format, delta, bytes / 1024));
+        return bytes;
+    };
+
+    const auto textBytes = measure(L"Text: %lld ms, %zu KB", [&]() { return exporter.Text(); });
+    measure(L"HTML: %lld ms, %zu KB", [&]() { return exporter.Html(getForegroundColor, getBackgroundColor, 12, L"Consolas"); });
+    measure(L"RTF: %lld ms, %zu KB", [&]() { return exporter.Rtf(getForegroundColor, getBackgroundColor, 12, L"Consolas"); });
+
+    // For comparison: a string per row plus two COLORREFs per character, before any HTML was built.
+    const size_t perCellBytes = textBytes + (textBytes / sizeof(wchar_t)) * 2 * sizeof(COLORREF) + height * 3 * sizeof(std::vector<COLORREF>);
+    Log::Comment(NoThrowString().Format(L"Per-cell colors would have needed %zu KB", perCellBytes / 1024));
+}
+
+void TextBufferTests::WriteCharInfoLineMatchesWriteLine()
+{
+    const COORD bufferSize{ 10, 4 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x7f };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    const auto cell = [](const wchar_t wch, const WORD attributes) {
+        CHAR_INFO ci;
+        ci.Char.UnicodeChar = wch;
+        ci.Attributes = attributes;
+        return ci;
+    };
+
+    // Starts with a stray trailing byte, has a wide character in the middle
+    // and ends on a leading byte that only fits if the first one is dropped.
+    const std::vector<CHAR_INFO> first{ cell(L'x', 0x07 | COMMON_LVB_TRAILING_BYTE),
+                                        cell(L'a', 0x07),
+                                        cell(L'b', 0x1e),
+                                        cell(0x3042, 0x1e | COMMON_LVB_LEADING_BYTE),
+                                        cell(0x3042, 0x1e | COMMON_LVB_TRAILING_BYTE),
+                                        cell(L'c', 0x1e),
+                                        cell(L'd', 0x2f),
+                                        cell(L'e', 0x2f),
+                                        cell(L'f', 0x07),
+                                        cell(0x3044, 0x07 | COMMON_LVB_LEADING_BYTE) };
+
+    // Ends on a leading byte in the last column.
+    const std::vector<CHAR_INFO> second{ cell(L'g', 0x4f),
+                                         cell(L'h', 0x4f),
+                                         cell(0x3046, 0x5f | COMMON_LVB_LEADING_BYTE),
+                                         cell(0x3046, 0x5f | COMMON_LVB_TRAILING_BYTE) };
+
+    for (const auto& [cells, column] : { std::pair{ first, 0 }, std::pair{ second, 7 } })
+    {
+        const std::basic_string_view<CHAR_INFO> view{ cells.data(), cells.size() };
+
+        const OutputCellIterator it{ view };
+        const auto expected = _buffer->WriteLine(it, { gsl::narrow<SHORT>(column), 0 }, true);
+        const auto consumed = _buffer->WriteCharInfoLine(view, { gsl::narrow<SHORT>(column), 1 }, true);
+
+        VERIFY_ARE_EQUAL(expected.GetInputDistance(it), gsl::narrow<ptrdiff_t>(consumed));
+
+        const auto& expectedRow = _buffer->GetRowByOffset(0);
+        const auto& actualRow = _buffer->GetRowByOffset(1);
+        VERIFY_ARE_EQUAL(expectedRow.GetText(), actualRow.GetText());
+        VERIFY_IS_TRUE(expectedRow.GetCharRow() == actualRow.GetCharRow());
+
+        // ATTR_ROW's operator== only tells whether two rows share storage.
+        const std::vector<TextAttribute> expectedAttrs{ expectedRow.GetAttrRow().cbegin(), expectedRow.GetAttrRow().cend() };
+        const std::vector<TextAttribute> actualAttrs{ actualRow.GetAttrRow().cbegin(), actualRow.GetAttrRow().cend() };
+        VERIFY_IS_TRUE(expectedAttrs == actualAttrs);
+    }
+}
+
+void TextBufferTests::ReplaceAttributesRecolorsEveryRow()
+{
+    const COORD bufferSize{ 10, 3 };
+    const UINT cursorSize = 12;
+    const TextAttribute fill{ 0x07 };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, fill, cursorSize, _renderTarget);
+
+    const TextAttribute red{ FOREGROUND_RED };
+    const TextAttribute blue{ RGB(0, 0, 255), RGB(0, 0, 0) };
+    _buffer->WriteNarrowLine(L"abc", red, { 2, 0 });
+    _buffer->WriteNarrowLine(L"de", red, { 0, 2 });
+    _buffer->WriteNarrowLine(L"f", blue, { 2, 2 });
+
+    Log::Comment(L"Every cell in red turns blue; nothing else changes.");
+    _buffer->ReplaceAttributes(red, blue);
+
+    const auto attrsOf = [&](const short row) {
+        const auto& attrRow = _buffer->GetRowByOffset(row).GetAttrRow();
+        return std::vector<TextAttribute>{ attrRow.cbegin(), attrRow.cend() };
+    };
+
+    const std::vector<TextAttribute> row0{ fill, fill, blue, blue, blue, fill, fill, fill, fill, fill };
+    const std::vector<TextAttribute> row1(10, fill);
+    const std::vector<TextAttribute> row2{ blue, blue, blue, fill, fill, fill, fill, fill, fill, fill };
+    VERIFY_IS_TRUE(row0 == attrsOf(0));
+    VERIFY_IS_TRUE(row1 == attrsOf(1));
+    VERIFY_IS_TRUE(row2 == attrsOf(2));
+
+    Log::Comment(L"Cells written afterwards still get the color they ask for.");
+    _buffer->WriteNarrowLine(L"g", red, { 9, 1 });
+    VERIFY_ARE_EQUAL(red, _buffer->GetRowByOffset(1).GetAttrRow().GetAttrByColumn(9));
+    VERIFY_ARE_EQUAL(blue, _buffer->GetRowByOffset(0).GetAttrRow().GetAttrByColumn(2));
+}
+
+void TextBufferTests::RowsChangedSinceGeneration()
+{
+    const COORD bufferSize{ 10, 5 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    auto seen = _buffer->GetGeneration();
+    VERIFY_ARE_EQUAL(0u, _buffer->GetRowsChangedSince(seen).size());
+
+    Log::Comment(L"Writing text and changing colors both count as changes to a row.");
+    _buffer->WriteNarrowLine(L"abc", attr, { 0, 1 });
+    _buffer->GetRowByOffset(3).GetAttrRow().SetAttrToEnd(4, TextAttribute{ 0x1f });
+    VERIFY_IS_TRUE((std::vector<size_t>{ 1, 3 }) == _buffer->GetRowsChangedSince(seen));
+    VERIFY_IS_GREATER_THAN(_buffer->GetRowByOffset(1).GetGeneration(), seen);
+    VERIFY_ARE_EQUAL(_buffer->GetRowByOffset(3).GetGeneration(), _buffer->GetGeneration());
+
+    seen = _buffer->GetGeneration();
+    _buffer->GetRowByOffset(4).ClearColumn(0);
+    VERIFY_IS_TRUE((std::vector<size_t>{ 4 }) == _buffer->GetRowsChangedSince(seen));
+
+    Log::Comment(L"Reading a row doesn't change it.");
+    seen = _buffer->GetGeneration();
+    const auto& constBuffer = *_buffer;
+    VERIFY_ARE_EQUAL(L'a', std::wstring_view(constBuffer.GetRowByOffset(1).GetCharRow().GlyphAt(0)).front());
+    _buffer->GetRowByOffset(2).GetCharRow();
+    _buffer->GetRowByOffset(2).GetAttrRow();
+    VERIFY_ARE_EQUAL(0u, _buffer->GetRowsChangedSince(seen).size());
+
+    Log::Comment(L"Scrolling only changes the row coming in at the bottom. The others keep their generation.");
+    const auto scrolled = _buffer->GetScrolledRowCount();
+    const auto textGeneration = _buffer->GetRowByOffset(1).GetGeneration();
+    VERIFY_IS_TRUE(_buffer->IncrementCircularBuffer());
+    VERIFY_IS_TRUE((std::vector<size_t>{ 4 }) == _buffer->GetRowsChangedSince(seen));
+    VERIFY_ARE_EQUAL(scrolled + 1, _buffer->GetScrolledRowCount());
+    VERIFY_ARE_EQUAL(L'a', std::wstring_view(constBuffer.GetRowByOffset(0).GetCharRow().GlyphAt(0)).front());
+    VERIFY_ARE_EQUAL(textGeneration, _buffer->GetRowByOffset(0).GetGeneration());
+
+    Log::Comment(L"Rows that move within the buffer change where they were and where they went.");
+    seen = _buffer->GetGeneration();
+    _buffer->ScrollRows(2, 2, 1);
+    VERIFY_IS_TRUE((std::vector<size_t>{ 2, 3, 4 }) == _buffer->GetRowsChangedSince(seen));
+    VERIFY_ARE_EQUAL(scrolled + 1, _buffer->GetScrolledRowCount());
+
+    Log::Comment(L"Recoloring and resizing change them all.");
+
+    seen = _buffer->GetGeneration();
+    _buffer->ReplaceAttributes(TextAttribute{ 0x1f }, TextAttribute{ 0x2f });
+    VERIFY_ARE_EQUAL(5u, _buffer->GetRowsChangedSince(seen).size());
+
+    seen = _buffer->GetGeneration();
+    VERIFY_SUCCEEDED(_buffer->ResizeTraditional({ 12, 5 }));
+    VERIFY_ARE_EQUAL(5u, _buffer->GetRowsChangedSince(seen).size());
+}
+
+void TextBufferTests::RowHashFollowsContents()
+{
+    const COORD bufferSize{ 10, 4 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    const auto hashOf = [&](const short row) { return _buffer->GetRowByOffset(row).GetHash(); };
+
+    Log::Comment(L"Rows that look the same hash the same.");
+    VERIFY_ARE_EQUAL(hashOf(0), hashOf(1));
+    _buffer->WriteNarrowLine(L"abc", attr, { 0, 0 });
+    _buffer->WriteNarrowLine(L"abc", attr, { 0, 1 });
+    VERIFY_ARE_EQUAL(hashOf(0), hashOf(1));
+
+    Log::Comment(L"Rewriting a row as it was changes its generation, but not its hash.");
+    const auto generation = _buffer->GetRowByOffset(0).GetGeneration();
+    const auto hash = hashOf(0);
+    _buffer->WriteNarrowLine(L"abc", attr, { 0, 0 });
+    VERIFY_IS_GREATER_THAN(_buffer->GetRowByOffset(0).GetGeneration(), generation);
+    VERIFY_ARE_EQUAL(hash, hashOf(0));
+
+    Log::Comment(L"Text, colors and wrapping all count.");
+    _buffer->WriteNarrowLine(L"abd", attr, { 0, 2 });
+    VERIFY_ARE_NOT_EQUAL(hash, hashOf(2));
+
+    _buffer->WriteNarrowLine(L"abc", TextAttribute{ 0x1f }, { 0, 3 });
+    VERIFY_ARE_NOT_EQUAL(hash, hashOf(3));
+
+    _buffer->GetRowByOffset(1).GetCharRow().SetWrapForced(true);
+    VERIFY_ARE_NOT_EQUAL(hash, hashOf(1));
+}
+
+void TextBufferTests::GenerationWritePerf()
+{
+    BEGIN_TEST_METHOD_PROPERTIES()
+        TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+    END_TEST_METHOD_PROPERTIES()
+
+    // What every write pays to keep generations, compared with what it costs
+    // to find the changed rows and hash them afterwards.
+    const SHORT height = 9001;
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto _buffer = std::make_unique<TextBuffer>(COORD{ 120, height }, attr, cursorSize, _renderTarget);
+    const std::wstring line = L"2019-05-06 12:34:56.789 [info] component: a line of log output that goes on for a while ......";
+
+    const auto measure = [](const wchar_t* const format, const size_t count, const auto& run) {
+        const auto before = std::chrono::steady_clock::now();
+        run();
+        const auto delta = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - before).count();
+        Log::Comment(NoThrowString().Format(format, delta / static_cast<long long>(count)));
+    };
+
+    const auto seen = _buffer->GetGeneration();
+    const size_t rounds = 10;
+    measure(L"Writing a line: %lld ns", rounds * height, [&]() {
+        for (size_t round = 0; round < rounds; ++round)
+        {
+            for (SHORT y = 0; y < height; ++y)
+            {
+                _buffer->WriteNarrowLine(line, attr, { 0, y });
+            }
+        }
+    });
+
+    measure(L"Marking a row changed: %lld ns", rounds * height, [&]() {
+        for (size_t round = 0; round < rounds; ++round)
+        {
+            for (SHORT y = 0; y < height; ++y)
+            {
+                _buffer->GetRowByOffset(y).GetCharRow().SetWrapForced(false);
+            }
+        }
+    });
+
+    std::vector<size_t> changed;
+    measure(L"Finding changed rows: %lld ns per row", height, [&]() { changed = _buffer->GetRowsChangedSince(seen); });
+    VERIFY_ARE_EQUAL(static_cast<size_t>(height), changed.size());
+
+    size_t hashes = 0;
+    measure(L"Hashing a row: %lld ns", height, [&]() {
+        for (SHORT y = 0; y < height; ++y)
+        {
+            hashes ^= _buffer->GetRowByOffset(y).GetHash();
+        }
+    });
+    Log::Comment(NoThrowString().Format(L"(%zx)", hashes));
+}
+
+void TextBufferTests::SnapshotRoundTrips()
+{
+    const COORD bufferSize{ 12, 6 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    TextAttribute rgb{ RGB(0x12, 0x34, 0x56), RGB(0xfe, 0xdc, 0xba) };
+    rgb.Embolden();
+    TextAttribute underlined{ 0x1e };
+    underlined.SetMetaAttributes(COMMON_LVB_UNDERSCORE);
+
+    _buffer->WriteLine(OutputCellIterator(L"hello"), { 0, 0 });
+    _buffer->WriteLine(OutputCellIterator(L"a\x3042z", underlined), { 2, 1 });
+    _buffer->WriteLine(OutputCellIterator(L"\xD83D\xDE00!", rgb), { 0, 2 });
+    _buffer->WriteLine(OutputCellIterator(L"wrapped text"), { 0, 3 }, true);
+    _buffer->GetCursor().SetPosition({ 3, 4 });
+
+    const auto path = _TempPath(L"SnapshotRoundTrips.snapshot");
+    auto cleanup = wil::scope_exit([&]() { std::filesystem::remove(path); });
+    TextBufferSnapshotWriter{ path }.Commit(*_buffer);
+
+    const TextBufferSnapshot snapshot{ path };
+    VERIFY_ARE_EQUAL(5u, snapshot.RowCount());
+    VERIFY_ARE_EQUAL(12u, snapshot.RowWidth(0));
+
+    auto restored = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    restored->WriteLine(OutputCellIterator(L"overwritten"), { 0, 5 });
+    snapshot.Restore(*restored);
+
+    VERIFY_ARE_EQUAL(COORD({ 3, 4 }), restored->GetCursor().GetPosition());
+    for (SHORT y = 0; y < bufferSize.Y; ++y)
+    {
+        const auto& expected = _buffer->GetRowByOffset(y);
+        const auto& actual = restored->GetRowByOffset(y);
+        VERIFY_ARE_EQUAL(String(expected.GetText().c_str()), String(actual.GetText().c_str()));
+        VERIFY_IS_TRUE(expected.GetCharRow() == actual.GetCharRow());
+
+        const std::vector<TextAttribute> expectedAttrs{ expected.GetAttrRow().cbegin(), expected.GetAttrRow().cend() };
+        const std::vector<TextAttribute> actualAttrs{ actual.GetAttrRow().cbegin(), actual.GetAttrRow().cend() };
+        VERIFY_IS_TRUE(expectedAttrs == actualAttrs);
+    }
+
+    Log::Comment(L"Glyphs too big for a cell come back through the buffer's storage.");
+    VERIFY_ARE_EQUAL(String(L"\xD83D\xDE00"), String(std::wstring(restored->GetRowByOffset(2).GetCharRow().GlyphAt(0)).c_str()));
+    VERIFY_IS_TRUE(restored->GetRowByOffset(3).GetCharRow().WasWrapForced());
+}
+
+void TextBufferTests::SnapshotKeepsRowsThatScrolledOut()
+{
+    const COORD bufferSize{ 10, 4 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    const auto path = _TempPath(L"SnapshotKeepsRowsThatScrolledOut.snapshot");
+    auto cleanup = wil::scope_exit([&]() { std::filesystem::remove(path); });
+
+    {
+        TextBufferSnapshotWriter writer{ path };
+        _buffer->SetScrollbackWriter(&writer);
+
+        // Every line past the fourth scrolls the oldest one out of the buffer.
+        // Committing halfway through only writes the rows in the buffer again.
+        for (int i = 0; i < 10; ++i)
+        {
+            const SHORT y = std::min(i, 3);
+            if (i > 3)
+            {
+                VERIFY_IS_TRUE(_buffer->IncrementCircularBuffer());
+            }
+            _buffer->WriteNarrowLine(L"line " + std::to_wstring(i), attr, { 0, y });
+            _buffer->GetCursor().SetPosition({ 6, y });
+
+            if (i == 5)
+            {
+                writer.Commit(*_buffer);
+            }
+        }
+        writer.Commit(*_buffer);
+        _buffer->SetScrollbackWriter(nullptr);
+    }
+
+    const TextBufferSnapshot snapshot{ path };
+    VERIFY_ARE_EQUAL(10u, snapshot.RowCount());
+    VERIFY_ARE_EQUAL(9u, snapshot.CursorRow());
+
+    auto scratch = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    for (size_t i = 0; i < snapshot.RowCount(); ++i)
+    {
+        snapshot.ReadRow(i, scratch->GetRowByOffset(0));
+        const auto expected = L"line " + std::to_wstring(i) + L"    ";
+        VERIFY_ARE_EQUAL(String(expected.c_str()), String(scratch->GetRowByOffset(0).GetText().c_str()));
+    }
+
+    Log::Comment(L"A smaller buffer gets the newest rows.");
+    auto restored = std::make_unique<TextBuffer>(COORD{ 10, 3 }, attr, cursorSize, _renderTarget);
+    snapshot.Restore(*restored);
+    VERIFY_ARE_EQUAL(String(L"line 7    "), String(restored->GetRowByOffset(0).GetText().c_str()));
+    VERIFY_ARE_EQUAL(String(L"line 9    "), String(restored->GetRowByOffset(2).GetText().c_str()));
+    VERIFY_ARE_EQUAL(COORD({ 6, 2 }), restored->GetCursor().GetPosition());
+}
+
+void TextBufferTests::SnapshotKeepsRowsCutOffByResizing()
+{
+    const COORD bufferSize{ 10, 4 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    const auto path = _TempPath(L"SnapshotKeepsRowsCutOffByResizing.snapshot");
+    auto cleanup = wil::scope_exit([&]() { std::filesystem::remove(path); });
+
+    {
+        TextBufferSnapshotWriter writer{ path };
+        _buffer->SetScrollbackWriter(&writer);
+
+        for (SHORT y = 0; y < 4; ++y)
+        {
+            _buffer->WriteNarrowLine(L"line " + std::to_wstring(y), attr, { 0, y });
+        }
+
+        Log::Comment(L"Making the buffer shorter cuts off the rows above the cursor's.");
+        _buffer->GetCursor().SetPosition({ 6, 3 });
+        VERIFY_SUCCEEDED(_buffer->ResizeTraditional({ 10, 2 }));
+        VERIFY_ARE_EQUAL(String(L"line 2    "), String(_buffer->GetRowByOffset(0).GetText().c_str()));
+
+        Log::Comment(L"Reflowing drops the line above the cursor's, and the half of the cursor's line that doesn't fit.");
+        _buffer->GetCursor().SetPosition({ 6, 1 });
+        VERIFY_SUCCEEDED(_buffer->ResizeWithReflow({ 5, 1 }));
+        VERIFY_ARE_EQUAL(String(L"3    "), String(_buffer->GetRowByOffset(0).GetText().c_str()));
+
+        writer.Commit(*_buffer);
+        _buffer->SetScrollbackWriter(nullptr);
+    }
+
+    const TextBufferSnapshot snapshot{ path };
+    VERIFY_ARE_EQUAL(5u, snapshot.RowCount());
+
+    auto scratch = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    for (size_t i = 0; i < 4; ++i)
+    {
+        snapshot.ReadRow(i, scratch->GetRowByOffset(0));
+        const auto expected = L"line " + std::to_wstring(i) + L"    ";
+        VERIFY_ARE_EQUAL(String(expected.c_str()), String(scratch->GetRowByOffset(0).GetText().c_str()));
+    }
+}
+
+void TextBufferTests::SnapshotRejectsIncompleteFile()
+{
+    const COORD bufferSize{ 10, 4 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    _buffer->WriteNarrowLine(L"text", attr, { 0, 0 });
+
+    const auto path = _TempPath(L"SnapshotRejectsIncompleteFile.snapshot");
+    auto cleanup = wil::scope_exit([&]() { std::filesystem::remove(path); });
+
+    const auto corrupt = [](wil::ResultException& e) { return e.GetErrorCode() == HRESULT_FROM_WIN32(ERROR_FILE_CORRUPT); };
+
+    Log::Comment(L"A writer that never committed doesn't touch the snapshot that's there.");
+    TextBufferSnapshotWriter{ path }.Commit(*_buffer);
+    {
+        TextBufferSnapshotWriter writer{ path };
+    }
+    VERIFY_ARE_EQUAL(1u, TextBufferSnapshot{ path }.RowCount());
+
+    Log::Comment(L"A file that was cut short isn't a snapshot.");
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+    VERIFY_THROWS_SPECIFIC(TextBufferSnapshot{ path }, wil::ResultException, corrupt);
+
+    Log::Comment(L"Neither is one whose first commit never finished.");
+    std::filesystem::resize_file(path, 16);
+    VERIFY_THROWS_SPECIFIC(TextBufferSnapshot{ path }, wil::ResultException, corrupt);
+}
+
+void TextBufferTests::SnapshotSurvivesInterruptedCommit()
+{
+    const COORD bufferSize{ 10, 4 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    const auto path = _TempPath(L"SnapshotSurvivesInterruptedCommit.snapshot");
+    auto cleanup = wil::scope_exit([&]() { std::filesystem::remove(path); });
+
+    // The header's pointer to the footer of the last commit is at offset 8.
+    const auto footerOffset = [&]() {
+        uint64_t offset = 0;
+        std::ifstream file{ path, std::ios::binary };
+        file.seekg(8);
+        file.read(reinterpret_cast<char*>(&offset), sizeof(offset));
+        return offset;
+    };
+
+    uint64_t firstCommit = 0;
+    {
+        TextBufferSnapshotWriter writer{ path };
+        _buffer->SetScrollbackWriter(&writer);
+
+        for (int i = 0; i < 8; ++i)
+        {
+            const SHORT y = std::min(i, 3);
+            if (i > 3)
+            {
+                VERIFY_IS_TRUE(_buffer->IncrementCircularBuffer());
+            }
+            _buffer->WriteNarrowLine(L"line " + std::to_wstring(i), attr, { 0, y });
+            _buffer->GetCursor().SetPosition({ 6, y });
+
+            if (i == 5)
+            {
+                writer.Commit(*_buffer);
+                firstCommit = footerOffset();
+            }
+        }
+
+        const auto sizeBefore = std::filesystem::file_size(path);
+        writer.Commit(*_buffer);
+        _buffer->SetScrollbackWriter(nullptr);
+
+        Log::Comment(L"The second commit went after the first one instead of over it.");
+        VERIFY_IS_GREATER_THAN(std::filesystem::file_size(path), sizeBefore);
+        VERIFY_IS_GREATER_THAN_OR_EQUAL(footerOffset(), sizeBefore);
+    }
+
+    Log::Comment(L"Put the header back the way it was before the second commit finished.");
+    {
+        std::fstream file{ path, std::ios::binary | std::ios::in | std::ios::out };
+        file.seekp(8);
+        file.write(reinterpret_cast<const char*>(&firstCommit), sizeof(firstCommit));
+    }
+
+    const TextBufferSnapshot snapshot{ path };
+    VERIFY_ARE_EQUAL(6u, snapshot.RowCount());
+    VERIFY_ARE_EQUAL(5u, snapshot.CursorRow());
+
+    auto scratch = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    for (size_t i = 0; i < snapshot.RowCount(); ++i)
+    {
+        snapshot.ReadRow(i, scratch->GetRowByOffset(0));
+        const auto expected = L"line " + std::to_wstring(i) + L"    ";
+        VERIFY_ARE_EQUAL(String(expected.c_str()), String(scratch->GetRowByOffset(0).GetText().c_str()));
+    }
+}
+
+void TextBufferTests::SnapshotRewritesFileOfReplacedRows()
+{
+    const COORD bufferSize{ 10, 4 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    const auto path = _TempPath(L"SnapshotRewritesFileOfReplacedRows.snapshot");
+    auto cleanup = wil::scope_exit([&]() { std::filesystem::remove(path); });
+
+    // Committing after every line leaves the rows of the buffer behind each
+    // time. A writer that doesn't wait for a minimum of them rewrites the
+    // file as soon as they take more room than the rows that scrolled out.
+    {
+        TextBufferSnapshotWriter writer{ path, 0 };
+        _buffer->SetScrollbackWriter(&writer);
+
+        for (int i = 0; i < 200; ++i)
+        {
+            const SHORT y = std::min(i, 3);
+            if (i > 3)
+            {
+                VERIFY_IS_TRUE(_buffer->IncrementCircularBuffer());
+            }
+            _buffer->WriteNarrowLine(L"line " + std::to_wstring(i), attr, { 0, y });
+            _buffer->GetCursor().SetPosition({ 6, y });
+            writer.Commit(*_buffer);
+        }
+        _buffer->SetScrollbackWriter(nullptr);
+
+        // Appending alone would have kept the index of every commit, 16 bytes
+        // for each of its rows: more than 300K.
+        Log::Comment(L"The file holds little more than the last commit, and no temporary file was left behind.");
+        VERIFY_IS_LESS_THAN(std::filesystem::file_size(path), 200u * 200u);
+        VERIFY_IS_FALSE(std::filesystem::exists(path + L".tmp"));
+    }
+
+    const TextBufferSnapshot snapshot{ path };
+    VERIFY_ARE_EQUAL(200u, snapshot.RowCount());
+
+    auto scratch = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    for (size_t i = 0; i < snapshot.RowCount(); ++i)
+    {
+        snapshot.ReadRow(i, scratch->GetRowByOffset(0));
+        const auto expected = L"line " + std::to_wstring(i);
+        VERIFY_ARE_EQUAL(String(expected.c_str()), String(scratch->GetRowByOffset(0).GetText().substr(0, expected.size()).c_str()));
+    }
+}
+
+void TextBufferTests::SnapshotRestoresOlderRowsToTheSpill()
+{
+    const COORD bufferSize{ 10, 4 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+
+    const auto path = _TempPath(L"SnapshotRestoresOlderRowsToTheSpill.snapshot");
+    auto cleanup = wil::scope_exit([&]() { std::filesystem::remove(path); });
+
+    // Every line has a color of its own, so the rows' attributes only come
+    // back right if the spill translates them to its own dictionary.
+    const auto attrOf = [](const int i) { return TextAttribute{ RGB(i, 0x80, 0x40), RGB(0, 0, i) }; };
+    const auto writeLine = [&](TextBuffer& buffer, const int i) {
+        auto y = buffer.GetCursor().GetPosition().Y;
+        buffer.WriteNarrowLine(L"line " + std::to_wstring(i), attrOf(i), { 0, y });
+        if (y == bufferSize.Y - 1)
+        {
+            VERIFY_IS_TRUE(buffer.IncrementCircularBuffer());
+        }
+        else
+        {
+            ++y;
+        }
+        buffer.GetCursor().SetPosition({ 0, y });
+    };
+
+    {
+        auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+        TextBufferSnapshotWriter writer{ path };
+        _buffer->SetScrollbackWriter(&writer);
+        for (int i = 0; i < 10; ++i)
+        {
+            writeLine(*_buffer, i);
+        }
+        writer.Commit(*_buffer);
+        _buffer->SetScrollbackWriter(nullptr);
+    }
+
+    {
+        auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+        _buffer->SpillTo(_TempPath(L"SnapshotRestoresOlderRowsToTheSpill.spill"));
+
+        const TextBufferSnapshot snapshot{ path };
+        VERIFY_ARE_EQUAL(11u, snapshot.RowCount());
+        const auto scrolledOut = snapshot.Restore(*_buffer);
+
+        Log::Comment(L"The rows that don't fit in the buffer are in the spill.");
+        VERIFY_ARE_EQUAL(7u, scrolledOut);
+        VERIFY_ARE_EQUAL(7u, _buffer->GetSpilledRowCount());
+        for (int i = 0; i < 7; ++i)
+        {
+            _buffer->ReadSpilledRow(i, [&](const ROW& row) {
+                const auto expected = L"line " + std::to_wstring(i) + L"    ";
+                VERIFY_ARE_EQUAL(String(expected.c_str()), String(row.GetText().c_str()));
+                VERIFY_ARE_EQUAL(attrOf(i), row.GetAttrRow().GetAttrByColumn(0));
+            });
+        }
+        VERIFY_ARE_EQUAL(String(L"line 7    "), String(_buffer->GetRowByOffset(0).GetText().c_str()));
+        VERIFY_ARE_EQUAL(COORD({ 0, 3 }), _buffer->GetCursor().GetPosition());
+
+        Log::Comment(L"A writer carries on the file while the snapshot is still open.");
+        TextBufferSnapshotWriter writer{ path, snapshot, scrolledOut };
+        _buffer->SetScrollbackWriter(&writer);
+        writeLine(*_buffer, 10);
+        writeLine(*_buffer, 11);
+        writer.Commit(*_buffer);
+        _buffer->SetScrollbackWriter(nullptr);
+    }
+
+    Log::Comment(L"The file has the rows of both sessions.");
+    const TextBufferSnapshot snapshot{ path };
+    VERIFY_ARE_EQUAL(13u, snapshot.RowCount());
+    VERIFY_ARE_EQUAL(12u, snapshot.CursorRow());
+
+    auto scratch = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    for (int i = 0; i < 12; ++i)
+    {
+        auto& row = scratch->GetRowByOffset(0);
+        snapshot.ReadRow(i, row);
+        const auto expected = L"line " + std::to_wstring(i);
+        VERIFY_ARE_EQUAL(String(expected.c_str()), String(row.GetText().substr(0, expected.size()).c_str()));
+        VERIFY_ARE_EQUAL(attrOf(i), row.GetAttrRow().GetAttrByColumn(0));
+    }
+}
+
+void TextBufferTests::SnapshotPerf()
+{
+    BEGIN_TEST_METHOD_PROPERTIES()
+        TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+    END_TEST_METHOD_PROPERTIES()
+
+    // A long colored log: 100k lines scroll through a buffer with the usual
+    // amount of scrollback, and are saved as they go.
+    const SHORT height = 9001;
+    const size_t lines = 100000;
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto _buffer = std::make_unique<TextBuffer>(COORD{ 120, height }, attr, cursorSize, _renderTarget);
+    const std::wstring prefix = L"2019-05-06 12:34:56.789 [info] component: a line of log output number ";
+
+    const auto path = _TempPath(L"SnapshotPerf.snapshot");
+    auto cleanup = wil::scope_exit([&]() { std::filesystem::remove(path); });
+
+    const auto measure = [](const wchar_t* const what, const auto& run) {
+        const auto before = std::chrono::steady_clock::now();
+        run();
+        const auto delta = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before).count();
+        Log::Comment(NoThrowString().Format(L"%s: %lld us", what, delta));
+    };
+
+    {
+        TextBufferSnapshotWriter writer{ path };
+        _buffer->SetScrollbackWriter(&writer);
+        measure(L"Writing 100k lines, saving the ones that scroll out", [&]() {
+            for (size_t i = 0; i < lines; ++i)
+            {
+                const SHORT y = static_cast<SHORT>(std::min<size_t>(i, height - 1));
+                if (i >= static_cast<size_t>(height))
+                {
+                    _buffer->IncrementCircularBuffer();
+                }
+                _buffer->WriteNarrowLine(prefix + std::to_wstring(i), attr, { 0, y });
+                auto& attrRow = _buffer->GetRowByOffset(y).GetAttrRow();
+                attrRow.SetAttrToEnd(24, TextAttribute{ 0x0a });
+                attrRow.SetAttrToEnd(30, TextAttribute{ 0x0e });
+                attrRow.SetAttrToEnd(41, attr);
+            }
+            _buffer->GetCursor().SetPosition({ 0, height - 1 });
+        });
+        measure(L"Committing", [&]() { writer.Commit(*_buffer); });
+        _buffer->SetScrollbackWriter(nullptr);
+    }
+
+    const auto bytes = std::filesystem::file_size(path);
+    Log::Comment(NoThrowString().Format(L"%llu bytes on disk, %llu per line", static_cast<unsigned long long>(bytes), static_cast<unsigned long long>(bytes / lines)));
+
+    std::unique_ptr<TextBufferSnapshot> snapshot;
+    measure(L"Opening", [&]() { snapshot = std::make_unique<TextBufferSnapshot>(path); });
+    VERIFY_ARE_EQUAL(lines, snapshot->RowCount());
+
+    auto restored = std::make_unique<TextBuffer>(COORD{ 120, height }, attr, cursorSize, _renderTarget);
+    measure(L"Restoring a buffer", [&]() { snapshot->Restore(*restored); });
+    VERIFY_ARE_EQUAL(String(_buffer->GetRowByOffset(height - 1).GetText().c_str()), String(restored->GetRowByOffset(height - 1).GetText().c_str()));
+
+    auto spilling = std::make_unique<TextBuffer>(COORD{ 120, height }, attr, cursorSize, _renderTarget);
+    spilling->SpillTo(_TempPath(L"SnapshotPerf.spill"));
+    measure(L"Restoring a buffer that spills, with the 91k rows that didn't fit handed to the spill undecoded", [&]() { snapshot->Restore(*spilling); });
+    VERIFY_ARE_EQUAL(lines - height, spilling->GetSpilledRowCount());
+
+    measure(L"Reading the 91k rows that didn't fit, one by one", [&]() {
+        auto& row = restored->GetRowByOffset(0);
+        for (size_t i = 0; i < lines - height; ++i)
+        {
+            snapshot->ReadRow(i, row);
+        }
+    });
+}
+
+void TextBufferTests::SpilledRowsReadBack()
+{
+    const COORD bufferSize{ 12, 4 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+
+    // Small segments, so the rows take a few of them.
+    const auto path = _TempPath(L"SpilledRowsReadBack.spill");
+    _buffer->_spill = std::make_unique<TextBufferSpill>(*_buffer, path, 64 * 1024);
+    VERIFY_ARE_EQUAL(0u, _buffer->GetSpilledRowCount());
+
+    const auto textOf = [](const size_t i) { return L"line " + std::to_wstring(i); };
+    const auto attrOf = [](const size_t i) { return TextAttribute{ RGB(i % 256, 0x80, 0x40), RGB(0, 0, i % 256) }; };
+
+    const size_t lines = 5000;
+    for (size_t i = 0; i < lines; ++i)
+    {
+        const SHORT y = static_cast<SHORT>(std::min<size_t>(i, 3));
+        if (i > 3)
+        {
+            VERIFY_IS_TRUE(_buffer->IncrementCircularBuffer());
+        }
+        _buffer->WriteLine(OutputCellIterator(textOf(i), attrOf(i)), { 0, y });
+        if (i % 10 == 0)
+        {
+            _buffer->WriteLine(OutputCellIterator(L"\xD83D\xDE00"), { 10, y });
+        }
+    }
+
+    Log::Comment(L"Every row but the four still in the buffer spilled.");
+    VERIFY_ARE_EQUAL(lines - 4, _buffer->GetSpilledRowCount());
+    VERIFY_IS_GREATER_THAN(_buffer->_spill->_file.segments.size(), 1u);
+
+    const auto verifyRow = [&](const size_t i) {
+        _buffer->ReadSpilledRow(i, [&](const ROW& row) {
+            const auto text = row.GetText();
+            VERIFY_ARE_EQUAL(String(textOf(i).c_str()), String(text.substr(0, textOf(i).size()).c_str()));
+            VERIFY_ARE_EQUAL(attrOf(i), row.GetAttrRow().GetAttrByColumn(0));
+            if (i % 10 == 0)
+            {
+                VERIFY_ARE_EQUAL(String(L"\xD83D\xDE00"), String(std::wstring(row.GetCharRow().GlyphAt(10)).c_str()));
+            }
+        });
+    };
+
+    Log::Comment(L"Scroll up through all of them, then read some again out of order.");
+    for (size_t i = lines - 4; i > 0; --i)
+    {
+        verifyRow(i - 1);
+    }
+    for (const size_t i : { 17u, 4000u, 18u, 17u, 2u, 4995u })
+    {
+        verifyRow(i);
+    }
+
+    VERIFY_THROWS_SPECIFIC(_SpilledText(*_buffer, lines - 4), wil::ResultException, [](wil::ResultException& e) { return e.GetErrorCode() == E_INVALIDARG; });
+}
+
+void TextBufferTests::SpilledRowsFollowBufferWidth()
+{
+    const COORD bufferSize{ 10, 2 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    _buffer->SpillTo(_TempPath(L"SpilledRowsFollowBufferWidth.spill"));
+
+    _buffer->WriteNarrowLine(L"0123456789", attr, { 0, 0 });
+    _buffer->WriteNarrowLine(L"abcdefghij", TextAttribute{ 0x1f }, { 0, 1 });
+    VERIFY_IS_TRUE(_buffer->IncrementCircularBuffer());
+    VERIFY_IS_TRUE(_buffer->IncrementCircularBuffer());
+    VERIFY_ARE_EQUAL(2u, _buffer->GetSpilledRowCount());
+    VERIFY_ARE_EQUAL(String(L"abcdefghij"), String(_SpilledText(*_buffer, 1).c_str()));
+
+    Log::Comment(L"A narrower buffer cuts the rows off.");
+    VERIFY_SUCCEEDED(_buffer->ResizeTraditional({ 6, 2 }));
+    VERIFY_ARE_EQUAL(String(L"012345"), String(_SpilledText(*_buffer, 0).c_str()));
+
+    Log::Comment(L"A wider one pads them with the color at their end.");
+    VERIFY_SUCCEEDED(_buffer->ResizeTraditional({ 14, 2 }));
+    _buffer->ReadSpilledRow(1, [](const ROW& row) {
+        VERIFY_ARE_EQUAL(String(L"abcdefghij    "), String(row.GetText().c_str()));
+        VERIFY_ARE_EQUAL(TextAttribute{ 0x1f }, row.GetAttrRow().GetAttrByColumn(13));
+    });
+}
+
+void TextBufferTests::SpilledRowsIncludeRowsCutOffByResizing()
+{
+    const COORD bufferSize{ 10, 4 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    _buffer->SpillTo(_TempPath(L"SpilledRowsIncludeRowsCutOffByResizing.spill"));
+
+    for (SHORT y = 0; y < 4; ++y)
+    {
+        _buffer->WriteNarrowLine(L"line " + std::to_wstring(y), attr, { 0, y });
+    }
+
+    Log::Comment(L"Making the buffer shorter spills the rows above the cursor's.");
+    _buffer->GetCursor().SetPosition({ 6, 3 });
+    VERIFY_SUCCEEDED(_buffer->ResizeTraditional({ 10, 2 }));
+    VERIFY_ARE_EQUAL(2u, _buffer->GetSpilledRowCount());
+
+    Log::Comment(L"So does reflowing, for the rows with text that no longer fits.");
+    _buffer->GetCursor().SetPosition({ 6, 1 });
+    VERIFY_SUCCEEDED(_buffer->ResizeWithReflow({ 10, 1 }));
+    VERIFY_ARE_EQUAL(3u, _buffer->GetSpilledRowCount());
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const auto expected = L"line " + std::to_wstring(i) + L"    ";
+        VERIFY_ARE_EQUAL(String(expected.c_str()), String(_SpilledText(*_buffer, i).c_str()));
+    }
+}
+
+void TextBufferTests::SpilledRowsReadFromManyThreads()
+{
+    const COORD bufferSize{ 12, 4 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    _buffer->SpillTo(_TempPath(L"SpilledRowsReadFromManyThreads.spill"));
+
+    const size_t lines = 1000;
+    for (size_t i = 0; i < lines + 4; ++i)
+    {
+        const SHORT y = static_cast<SHORT>(std::min<size_t>(i, 3));
+        if (i > 3)
+        {
+            VERIFY_IS_TRUE(_buffer->IncrementCircularBuffer());
+        }
+        _buffer->WriteNarrowLine(std::to_wstring(i), attr, { 0, y });
+    }
+    VERIFY_ARE_EQUAL(lines, _buffer->GetSpilledRowCount());
+
+    Log::Comment(L"Readers that share the buffer each get the row they asked for, even as they push each other's out of the cache.");
+    const TextBuffer& shared = *_buffer;
+    std::atomic<size_t> mismatches{ 0 };
+    std::vector<std::thread> readers;
+    for (size_t reader = 0; reader < 4; ++reader)
+    {
+        readers.emplace_back([&, reader]() {
+            for (size_t i = reader; i < lines * 4; i += 7)
+            {
+                const auto index = (i * 31) % lines;
+                const auto expected = std::to_wstring(index) + L' ';
+                shared.ReadSpilledRow(index, [&](const ROW& row) {
+                    if (row.GetText().compare(0, expected.size(), expected) != 0)
+                    {
+                        ++mismatches;
+                    }
+                });
+            }
+        });
+    }
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+    VERIFY_ARE_EQUAL(0u, mismatches.load());
+}
+
+void TextBufferTests::SpilledRowsAreAboveRowZero()
+{
+    const COORD bufferSize{ 10, 2 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    _buffer->SpillTo(_TempPath(L"SpilledRowsAreAboveRowZero.spill"));
+
+    for (size_t i = 0; i < 5; ++i)
+    {
+        if (i >= 2)
+        {
+            VERIFY_IS_TRUE(_buffer->IncrementCircularBuffer());
+        }
+        _buffer->WriteNarrowLine(L"line " + std::to_wstring(i), attr, { 0, static_cast<SHORT>(std::min<size_t>(i, 1)) });
+    }
+    VERIFY_ARE_EQUAL(3u, _buffer->GetSpilledRowCount());
+
+    const auto textAt = [&](const SHORT y) {
+        auto text = _buffer->PinRowByOffset(y)->GetText();
+        text.erase(text.find_last_not_of(L' ') + 1);
+        return text;
+    };
+
+    Log::Comment(L"The rows that spilled last are right above row 0.");
+    VERIFY_ARE_EQUAL(-3, _buffer->GetSizeWithSpill().Top());
+    VERIFY_ARE_EQUAL(String(L"line 2"), String(textAt(-1).c_str()));
+    VERIFY_ARE_EQUAL(String(L"line 0"), String(textAt(-3).c_str()));
+    VERIFY_ARE_EQUAL(String(L"line 3"), String(textAt(0).c_str()));
+    VERIFY_THROWS_SPECIFIC(_buffer->PinRowByOffset(-4), wil::ResultException, [](wil::ResultException& e) { return e.GetErrorCode() == E_INVALIDARG; });
+
+    Log::Comment(L"Cell iterators walk up into them.");
+    const auto size = _buffer->GetSizeWithSpill();
+    auto it = _buffer->GetTextDataAt({ 0, -3 }, size);
+    VERIFY_ARE_EQUAL(String(L"l"), String(std::wstring(*it).c_str()));
+    it += 10;
+    VERIFY_ARE_EQUAL(String(L"l"), String(std::wstring(*it).c_str()));
+    it += 5;
+    VERIFY_ARE_EQUAL(String(L"1"), String(std::wstring(*it).c_str()));
+
+    Log::Comment(L"Moving the base moves which spilled rows are there.");
+    _buffer->SetSpillBase(1);
+    VERIFY_ARE_EQUAL(-1, _buffer->GetSizeWithSpill().Top());
+    VERIFY_ARE_EQUAL(String(L"line 0"), String(textAt(-1).c_str()));
+    VERIFY_ARE_EQUAL(String(L"line 3"), String(textAt(0).c_str()));
+    VERIFY_THROWS_SPECIFIC(_buffer->PinRowByOffset(-2), wil::ResultException, [](wil::ResultException& e) { return e.GetErrorCode() == E_INVALIDARG; });
+
+    _buffer->SetSpillBase(std::nullopt);
+    VERIFY_ARE_EQUAL(String(L"line 2"), String(textAt(-1).c_str()));
+}
+
+void TextBufferTests::PinnedSpilledRowsStayCached()
+{
+    const COORD bufferSize{ 12, 2 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    _buffer->SpillTo(_TempPath(L"PinnedSpilledRowsStayCached.spill"));
+
+    const size_t lines = TextBufferSpill::s_cachedRows * 4;
+    for (size_t i = 0; i < lines + 2; ++i)
+    {
+        if (i >= 2)
+        {
+            VERIFY_IS_TRUE(_buffer->IncrementCircularBuffer());
+        }
+        _buffer->WriteNarrowLine(std::to_wstring(i), attr, { 0, static_cast<SHORT>(std::min<size_t>(i, 1)) });
+    }
+    VERIFY_ARE_EQUAL(lines, _buffer->GetSpilledRowCount());
+
+    Log::Comment(L"A pinned row isn't pushed out of the cache by reading others.");
+    const auto pinned = _buffer->PinRowByOffset(static_cast<SHORT>(-static_cast<ptrdiff_t>(lines)));
+    for (size_t i = 1; i < lines; ++i)
+    {
+        _SpilledText(*_buffer, i);
+    }
+    VERIFY_ARE_EQUAL(String(L"0           "), String(pinned->GetText().c_str()));
+
+    Log::Comment(L"Neither is it changed by the buffer changing width; the cache is made again around it.");
+    VERIFY_SUCCEEDED(_buffer->ResizeTraditional({ 6, 2 }));
+    VERIFY_ARE_EQUAL(String(L"1     "), String(_SpilledText(*_buffer, 1).c_str()));
+    VERIFY_ARE_EQUAL(String(L"0           "), String(pinned->GetText().c_str()));
+
+    Log::Comment(L"Only as many rows as the cache holds can be pinned at once.");
+    std::vector<std::shared_ptr<const ROW>> pins;
+    for (SHORT i = 1; i <= TextBufferSpill::s_cachedRows; ++i)
+    {
+        pins.push_back(_buffer->PinRowByOffset(static_cast<SHORT>(-i)));
+    }
+    VERIFY_THROWS_SPECIFIC(_buffer->PinRowByOffset(static_cast<SHORT>(-TextBufferSpill::s_cachedRows - 1)), wil::ResultException, [](wil::ResultException& e) { return e.GetErrorCode() == E_NOT_SUFFICIENT_BUFFER; });
+    pins.pop_back();
+    VERIFY_ARE_EQUAL(String(L"0     "), String(_SpilledText(*_buffer, 0).c_str()));
+}
+
+void TextBufferTests::SpilledRowsReflowWithTheBuffer()
+{
+    const COORD bufferSize{ 10, 2 };
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto _buffer = std::make_unique<TextBuffer>(bufferSize, attr, cursorSize, _renderTarget);
+    _buffer->SpillTo(_TempPath(L"SpilledRowsReflowWithTheBuffer.spill"));
+
+    // One line that wrapped onto a second row, and a short one.
+    _buffer->WriteNarrowLine(L"abcdefghij", attr, { 0, 0 }, true);
+    _buffer->WriteNarrowLine(L"klm", TextAttribute{ 0x1f }, { 0, 1 });
+    VERIFY_IS_TRUE(_buffer->IncrementCircularBuffer());
+    _buffer->WriteNarrowLine(L"nop", attr, { 0, 1 });
+    VERIFY_IS_TRUE(_buffer->IncrementCircularBuffer());
+    VERIFY_IS_TRUE(_buffer->IncrementCircularBuffer());
+    _buffer->GetCursor().SetPosition({ 0, 0 });
+    VERIFY_ARE_EQUAL(3u, _buffer->GetSpilledRowCount());
+
+    Log::Comment(L"Wider: the wrapped line is whole again, and keeps its colors.");
+    VERIFY_SUCCEEDED(_buffer->ResizeWithReflow({ 20, 2 }));
+    VERIFY_ARE_EQUAL(2u, _buffer->GetSpilledRowCount());
+    _buffer->ReadSpilledRow(0, [&](const ROW& row) {
+        VERIFY_ARE_EQUAL(String(L"abcdefghijklm       "), String(row.GetText().c_str()));
+        VERIFY_IS_FALSE(row.GetCharRow().WasWrapForced());
+        VERIFY_ARE_EQUAL(attr, row.GetAttrRow().GetAttrByColumn(9));
+        VERIFY_ARE_EQUAL(TextAttribute{ 0x1f }, row.GetAttrRow().GetAttrByColumn(10));
+    });
+    VERIFY_ARE_EQUAL(String(L"nop                 "), String(_SpilledText(*_buffer, 1).c_str()));
+
+    Log::Comment(L"Narrower: it wraps again at the new width.");
+    VERIFY_SUCCEEDED(_buffer->ResizeWithReflow({ 4, 2 }));
+    VERIFY_ARE_EQUAL(5u, _buffer->GetSpilledRowCount());
+    const std::vector<std::wstring> expected{ L"abcd", L"efgh", L"ijkl", L"m   ", L"nop " };
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        _buffer->ReadSpilledRow(i, [&](const ROW& row) {
+            VERIFY_ARE_EQUAL(String(expected[i].c_str()), String(row.GetText().c_str()));
+            VERIFY_ARE_EQUAL(i < 3, row.GetCharRow().WasWrapForced());
+        });
+    }
+
+    Log::Comment(L"Resizing without reflowing leaves them as they are.");
+    VERIFY_SUCCEEDED(_buffer->ResizeTraditional({ 3, 2 }));
+    VERIFY_ARE_EQUAL(5u, _buffer->GetSpilledRowCount());
+}
+
+void TextBufferTests::SpillAppendPerf()
+{
+    BEGIN_TEST_METHOD_PROPERTIES()
+        TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+    END_TEST_METHOD_PROPERTIES()
+
+    // 1M colored log lines scrolling through a full buffer, with and without
+    // the rows that scroll out spilling to disk.
+    const SHORT height = 9001;
+    const size_t lines = 1000000;
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    const std::wstring prefix = L"2019-05-06 12:34:56.789 [info] component: a line of log output number ";
+
+    for (const bool spilling : { false, true })
+    {
+        auto _buffer = std::make_unique<TextBuffer>(COORD{ 120, height }, attr, cursorSize, _renderTarget);
+        if (spilling)
+        {
+            _buffer->SpillTo(_TempPath(L"SpillAppendPerf.spill"));
+        }
+
+        const auto before = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < lines; ++i)
+        {
+            const SHORT y = static_cast<SHORT>(std::min<size_t>(i, height - 1));
+            if (i >= static_cast<size_t>(height))
+            {
+                _buffer->IncrementCircularBuffer();
+            }
+            _buffer->WriteNarrowLine(prefix + std::to_wstring(i), attr, { 0, y });
+            auto& attrRow = _buffer->GetRowByOffset(y).GetAttrRow();
+            attrRow.SetAttrToEnd(24, TextAttribute{ 0x0a });
+            attrRow.SetAttrToEnd(30, TextAttribute{ 0x0e });
+            attrRow.SetAttrToEnd(41, attr);
+        }
+        const auto delta = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before).count();
+
+        Log::Comment(NoThrowString().Format(L"spilling %s: %zu lines in %lld us (%.0f lines/s), %zu spilled",
+                                            spilling ? L"on" : L"off",
+                                            lines,
+                                            delta,
+                                            lines * 1e6 / std::max<long long>(delta, 1),
+                                            _buffer->GetSpilledRowCount()));
+    }
+}
+
+void TextBufferTests::SpillScrollUpPerf()
+{
+    BEGIN_TEST_METHOD_PROPERTIES()
+        TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+    END_TEST_METHOD_PROPERTIES()
+
+    // Spills 10M short lines, then reads them back the way the viewport does
+    // while scrolling up a line at a time: every row in view, every step.
+    const SHORT height = 30;
+    const size_t lines = 10000000;
+    const UINT cursorSize = 12;
+    const TextAttribute attr{ 0x07 };
+    auto _buffer = std::make_unique<TextBuffer>(COORD{ 120, height }, attr, cursorSize, _renderTarget);
+    _buffer->SpillTo(_TempPath(L"SpillScrollUpPerf.spill"));
+
+    for (size_t i = 0; i < lines + height; ++i)
+    {
+        const SHORT y = static_cast<SHORT>(std::min<size_t>(i, height - 1));
+        if (i >= static_cast<size_t>(height))
+        {
+            _buffer->IncrementCircularBuffer();
+        }
+        _buffer->WriteNarrowLine(std::to_wstring(i), attr, { 0, y });
+    }
+    VERIFY_ARE_EQUAL(lines, _buffer->GetSpilledRowCount());
+
+    size_t cells = 0;
+    const auto before = std::chrono::steady_clock::now();
+    for (size_t top = lines - height + 1; top > 0; --top)
+    {
+        for (size_t y = top - 1; y < top - 1 + height; ++y)
+        {
+            _buffer->ReadSpilledRow(y, [&](const ROW& row) { cells += row.GetCharRow().MeasureRight(); });
+        }
+    }
+    const auto delta = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - before).count();
+
+    VERIFY_IS_GREATER_THAN(cells, 0u);
+    Log::Comment(NoThrowString().Format(L"Scrolled up through %zu spilled lines in %lld us (%.1f ns per line)",
+                                        lines,
+                                        delta,
+                                        delta * 1000.0 / lines));
+}
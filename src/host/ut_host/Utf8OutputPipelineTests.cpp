@@ -0,0 +1,287 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "WexTestClass.h"
+#include "../../inc/consoletaeftemplates.hpp"
+
+#include "../../types/inc/Utf8OutputPipeline.hpp"
+
+#include <chrono>
+#include <thread>
+
+using namespace WEX::Common;
+using namespace WEX::Logging;
+using namespace WEX::TestExecution;
+using namespace Microsoft::Console::Types;
+
+// "a", e-acute, euro sign, smiling face with sunglasses emoji, " z"
+static const std::string MixedUtf8 = "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x8E z";
+static const std::wstring MixedUtf16 = L"a\x00E9\x20AC\xD83D\xDE0E z";
+
+class Utf8OutputPipelineTests
+{
+    TEST_CLASS(Utf8OutputPipelineTests);
+
+    // Hands out the given bytes at most chunkSize at a time, like a pipe that
+    // is being written by someone else in small pieces.
+    static Utf8OutputPipeline::ReadFn _MakeSource(const std::string& bytes, const size_t chunkSize, size_t& position)
+    {
+        return [&bytes, chunkSize, &position](char* const buffer, const size_t capacity, size_t& read) {
+            if (position >= bytes.size())
+            {
+                return false;
+            }
+            read = std::min({ capacity, chunkSize, bytes.size() - position });
+            std::copy_n(bytes.data() + position, read, buffer);
+            position += read;
+            return true;
+        };
+    }
+
+    TEST_METHOD(DecodesAsciiInOneBatch)
+    {
+        const std::string input = "hello world";
+        size_t position = 0;
+        std::vector<std::wstring> batches;
+
+        Utf8OutputPipeline pipeline{ _MakeSource(input, input.size(), position),
+                                     [&](const std::wstring_view text) { batches.emplace_back(text); } };
+        pipeline.Run();
+
+        VERIFY_ARE_EQUAL(1u, batches.size());
+        VERIFY_ARE_EQUAL(std::wstring{ L"hello world" }, batches.at(0));
+        VERIFY_ARE_EQUAL(input.size(), pipeline.BytesRead());
+    }
+
+    TEST_METHOD(CarriesPartialSequencesAcrossReads)
+    {
+        Log::Comment(L"Every split point of every multi-byte sequence must decode the same as the whole.");
+        for (size_t chunkSize = 1; chunkSize <= MixedUtf8.size(); ++chunkSize)
+        {
+            size_t position = 0;
+            std::wstring result;
+
+            Utf8OutputPipeline pipeline{ _MakeSource(MixedUtf8, chunkSize, position),
+                                         [&](const std::wstring_view text) { result.append(text); } };
+            pipeline.Run();
+
+            VERIFY_ARE_EQUAL(MixedUtf16, result, NoThrowString().Format(L"chunk size %zu", chunkSize));
+        }
+    }
+
+    TEST_METHOD(LimitsReadsToBufferSize)
+    {
+        const std::string input(1000, 'x');
+        size_t position = 0;
+        size_t delivered = 0;
+
+        Utf8OutputPipeline pipeline{ _MakeSource(input, SIZE_MAX, position),
+                                     [&](const std::wstring_view text) { delivered += text.size(); },
+                                     256 };
+        pipeline.Run();
+
+        VERIFY_ARE_EQUAL(input.size(), delivered);
+        VERIFY_ARE_EQUAL(4u, pipeline.BatchesDelivered());
+    }
+
+    TEST_METHOD(SkipsEmptyBatches)
+    {
+        Log::Comment(L"A read holding only the lead byte of a sequence shouldn't produce a batch.");
+        const std::string input = "\xE2\x82\xAC";
+        size_t position = 0;
+        std::vector<std::wstring> batches;
+
+        Utf8OutputPipeline pipeline{ _MakeSource(input, 1, position),
+                                     [&](const std::wstring_view text) { batches.emplace_back(text); } };
+        pipeline.Run();
+
+        VERIFY_ARE_EQUAL(1u, batches.size());
+        VERIFY_ARE_EQUAL(std::wstring{ L"\x20AC" }, batches.at(0));
+    }
+
+    TEST_METHOD(ReplacesInvalidSequences)
+    {
+        Utf8StreamDecoder decoder;
+        std::wstring result;
+
+        Log::Comment(L"Truncated sequence, stray continuation byte, overlong lead byte, encoded surrogate.");
+        decoder.Decode("\xE2\x82" "a" "\x80" "\xC0" "\xED\xA0\x80", result);
+        decoder.Flush(result);
+
+        VERIFY_ARE_EQUAL(std::wstring{ L"\xFFFD" L"a\xFFFD\xFFFD\xFFFD\xFFFD\xFFFD" }, result);
+    }
+
+    TEST_METHOD(FlushesDanglingSequence)
+    {
+        const std::string input = "ok\xF0\x9F";
+        size_t position = 0;
+        std::wstring result;
+
+        Utf8OutputPipeline pipeline{ _MakeSource(input, input.size(), position),
+                                     [&](const std::wstring_view text) { result.append(text); } };
+        pipeline.Run();
+
+        VERIFY_ARE_EQUAL(std::wstring{ L"ok\xFFFD" }, result);
+    }
+
+    TEST_METHOD(ParallelPipelineDeliversInOrder)
+    {
+        std::string input;
+        std::wstring expected;
+        for (int i = 0; i < 2000; ++i)
+        {
+            input += MixedUtf8;
+            expected += MixedUtf16;
+        }
+
+        for (const size_t bufferCount : { 1u, 2u, 8u })
+        {
+            for (const size_t chunkSize : { 1u, 7u, 64u, 4096u })
+            {
+                size_t position = 0;
+                std::wstring result;
+
+                ParallelUtf8OutputPipeline pipeline{ _MakeSource(input, chunkSize, position),
+                                                     [&](const std::wstring_view text) { result.append(text); },
+                                                     32,
+                                                     bufferCount };
+                pipeline.Run();
+
+                VERIFY_ARE_EQUAL(expected, result, NoThrowString().Format(L"%zu buffers, chunk size %zu", bufferCount, chunkSize));
+                VERIFY_ARE_EQUAL(input.size(), pipeline.GetMetrics().bytesRead);
+            }
+        }
+    }
+
+    TEST_METHOD(ParallelPipelineReportsBackpressure)
+    {
+        const std::string input(64, 'x');
+
+        Log::Comment(L"A slow sink makes the reader wait for buffers.");
+        {
+            size_t position = 0;
+            ParallelUtf8OutputPipeline pipeline{ _MakeSource(input, 1, position),
+                                                 [](const std::wstring_view) { std::this_thread::sleep_for(std::chrono::milliseconds(1)); },
+                                                 16,
+                                                 2 };
+            pipeline.Run();
+
+            const auto metrics = pipeline.GetMetrics();
+            VERIFY_ARE_EQUAL(64u, metrics.batchesDelivered);
+            VERIFY_IS_GREATER_THAN(metrics.readerWaits, 0u);
+            VERIFY_ARE_EQUAL(2u, metrics.maxQueued);
+        }
+
+        Log::Comment(L"A slow source makes the sink wait for batches.");
+        {
+            size_t position = 0;
+            auto source = _MakeSource(input, 8, position);
+            ParallelUtf8OutputPipeline pipeline{ [&](char* const buffer, const size_t capacity, size_t& read) {
+                                                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                                                    return source(buffer, capacity, read);
+                                                },
+                                                 [](const std::wstring_view) {},
+                                                 16,
+                                                 2 };
+            pipeline.Run();
+
+            const auto metrics = pipeline.GetMetrics();
+            VERIFY_ARE_EQUAL(8u, metrics.batchesDelivered);
+            VERIFY_IS_GREATER_THAN(metrics.sinkWaits, 0u);
+            VERIFY_ARE_EQUAL(0u, metrics.readerWaits);
+        }
+    }
+
+    TEST_METHOD(ParallelPipelineRethrowsSinkFailure)
+    {
+        const std::string input(1000, 'x');
+        size_t position = 0;
+        size_t batches = 0;
+
+        ParallelUtf8OutputPipeline pipeline{ _MakeSource(input, 10, position),
+                                             [&](const std::wstring_view) {
+                                                 if (++batches == 3)
+                                                 {
+                                                     THROW_HR(E_ABORT);
+                                                 }
+                                             },
+                                             16,
+                                             2 };
+        VERIFY_THROWS_SPECIFIC(pipeline.Run(),
+                               wil::ResultException,
+                               [](wil::ResultException& e) { return e.GetErrorCode() == E_ABORT; });
+
+        Log::Comment(L"The source was still drained, but nothing after the failure was delivered.");
+        VERIFY_ARE_EQUAL(input.size(), position);
+        VERIFY_ARE_EQUAL(3u, batches);
+    }
+
+    BEGIN_TEST_METHOD(ParallelPipelineOverlapPerf)
+        TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+    END_TEST_METHOD()
+};
+
+// Stands in for a pipe and a parser that both take time per byte, and
+// compares reading and parsing on one thread against doing it on two.
+void Utf8OutputPipelineTests::ParallelPipelineOverlapPerf()
+{
+    std::string input;
+    for (int i = 0; i < 4000; ++i)
+    {
+        input += "\x1b[32m" + MixedUtf8 + std::string(200, static_cast<char>('a' + i % 26)) + "\r\n";
+    }
+
+    // Busy work that the optimizer can't drop.
+    volatile uint32_t hash = 0;
+    const auto work = [&](const uint32_t value, const int rounds) {
+        for (int i = 0; i < rounds; ++i)
+        {
+            hash = hash * 31 + value;
+        }
+    };
+
+    for (const bool parallel : { false, true })
+    {
+        size_t position = 0;
+        auto pipe = _MakeSource(input, 4096, position);
+        const auto read = [&](char* const buffer, const size_t capacity, size_t& count) {
+            const bool more = pipe(buffer, capacity, count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                work(static_cast<uint8_t>(buffer[i]), 4);
+            }
+            return more;
+        };
+        const auto parse = [&](const std::wstring_view text) {
+            for (const auto wch : text)
+            {
+                work(wch, 8);
+            }
+        };
+
+        const auto start = std::chrono::steady_clock::now();
+        ParallelUtf8OutputPipeline::Metrics metrics{};
+        if (parallel)
+        {
+            ParallelUtf8OutputPipeline pipeline{ read, parse, 4096 };
+            pipeline.Run();
+            metrics = pipeline.GetMetrics();
+        }
+        else
+        {
+            Utf8OutputPipeline pipeline{ read, parse, 4096 };
+            pipeline.Run();
+        }
+        const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+
+        Log::Comment(NoThrowString().Format(L"%s: %zu bytes in %lld us (%lld bytes/ms). reader waits %zu, sink waits %zu, most queued %zu",
+                                            parallel ? L"parallel" : L"serial",
+                                            input.size(),
+                                            elapsed.count(),
+                                            static_cast<long long>(input.size()) * 1000 / std::max<long long>(elapsed.count(), 1),
+                                            metrics.readerWaits,
+                                            metrics.sinkWaits,
+                                            metrics.maxQueued));
+    }
+}
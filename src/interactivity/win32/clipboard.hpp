@@ -21,6 +21,7 @@ Revision History:
 #include "precomp.h"
 
 #include "..\..\host\screenInfo.hpp"
+#include "..\..\buffer\out\textBufferExport.hpp"
 
 namespace Microsoft::Console::Interactivity::Win32
 {
@@ -37,16 +38,19 @@ namespace Microsoft::Console::Interactivity::Win32
     private:
         std::deque<std::unique_ptr<IInputEvent>> TextToKeyEvents(_In_reads_(cchData) const wchar_t* const pData,
                                                                  const size_t cchData);
+        std::wstring FilterTextForPaste(_In_reads_(cchData) const wchar_t* const pData,
+                                        const size_t cchData);
 
         void StoreSelectionToClipboard(_In_ bool const fAlsoCopyHtml);
 
-        TextBuffer::TextAndColor RetrieveTextFromBuffer(const SCREEN_INFORMATION& screenInfo,
-                                                         const bool lineSelection,
-                                                         const std::vector<SMALL_RECT>& selectionRects);
+        TextBufferExport RetrieveTextFromBuffer(const SCREEN_INFORMATION& screenInfo,
+                                                const bool lineSelection,
+                                                const std::vector<SMALL_RECT>& selectionRects);
 
-        void CopyHTMLToClipboard(const TextBuffer::TextAndColor& rows);
-        std::string GenHTML(const TextBuffer::TextAndColor & rows);
-        void CopyTextToSystemClipboard(const TextBuffer::TextAndColor& rows, _In_ bool const fAlsoCopyHtml);
+        std::string GenHTML(const TextBufferExport& selection);
+        std::string GenRTF(const TextBufferExport& selection);
+        void CopyTextToSystemClipboard(const TextBufferExport& selection, _In_ bool const fAlsoCopyHtml);
+        void CopyToSystemClipboard(const std::string& stringToCopy, LPCWSTR lpszFormat);
 
         bool FilterCharacterOnPaste(_Inout_ WCHAR * const pwch);
 
@@ -5,6 +5,7 @@
 #include "precomp.h"
 
 #include "renderer.hpp"
+#include "../../types/inc/Metrics.hpp"
 
 #pragma hdrstop
 
@@ -98,6 +99,10 @@ HRESULT Renderer::_PaintFrameForEngine(_In_ IRenderEngine* const pEngine)
         return S_OK;
     }
 
+    // Time the frame from here through presenting it, however this returns.
+    Metrics::Add(Metrics::Counter::FramesPainted);
+    Metrics::ScopedLatency paintLatency{ Metrics::Histogram::PaintMicroseconds };
+
     auto endPaint = wil::scope_exit([&]()
     {
         LOG_IF_FAILED(pEngine->EndPaint());
@@ -598,8 +603,10 @@ void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
         std::vector<Cluster> clusters;
         size_t cols = 0;
 
-        // Retrieve the first color.
+        // Retrieve the first color. Runs are split by the color's id in the
+        // buffer's attribute table, which is the same as comparing colors.
         auto color = it->TextAttr();
+        auto colorId = it.GetAttrId();
 
         // And hold the point where we should start drawing.
         auto screenPoint = target;
@@ -627,9 +634,10 @@ void Renderer::_PaintBufferOutputHelper(_In_ IRenderEngine* const pEngine,
             // When the color changes, it will save the new color off and break.
             do
             {
-                if (color != it->TextAttr())
+                if (colorId != it.GetAttrId())
                 {
                     color = it->TextAttr();
+                    colorId = it.GetAttrId();
                     break;
                 }
 
@@ -0,0 +1,195 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+
+#include "GraphicsRendition.hpp"
+
+using namespace Microsoft::Console::VirtualTerminal;
+using namespace Microsoft::Console::VirtualTerminal::DispatchTypes;
+
+// Routine Description:
+// - Applies the options of an SGR sequence, in order, to the given attributes.
+//   Nothing is written anywhere; committing the result is up to the caller.
+// Arguments:
+// - rgOptions - The options to apply.
+// - cOptions - The count of options.
+// - order - The order of the color table the attributes will be drawn with.
+//      The 8/16 color options and xterm indices below 16 are stored as indices
+//      into that table. Indices from 16 up are stored as they are.
+// - attributes - The attributes to modify.
+// Return Value:
+// - False if the last option was an extended color that couldn't be parsed.
+//      Everything before it has still been applied.
+bool GraphicsRendition::s_Apply(_In_reads_(cOptions) const GraphicsOptions* const rgOptions,
+                                const size_t cOptions,
+                                const ColorOrder order,
+                                TextAttribute& attributes)
+{
+    bool fSuccess = true;
+    for (size_t i = 0; i < cOptions; i++)
+    {
+        const GraphicsOptions opt = rgOptions[i];
+        fSuccess = true;
+
+        switch (opt)
+        {
+        case GraphicsOptions::Off:
+            attributes.SetDefaultForeground();
+            attributes.SetDefaultBackground();
+            attributes.SetMetaAttributes(0);
+            attributes.Debolden();
+            break;
+        case GraphicsOptions::BoldBright:
+            attributes.Embolden();
+            break;
+        case GraphicsOptions::UnBold:
+            attributes.Debolden();
+            break;
+        case GraphicsOptions::Negative:
+            s_SetMetaFlag(COMMON_LVB_REVERSE_VIDEO, true, attributes);
+            break;
+        case GraphicsOptions::Positive:
+            s_SetMetaFlag(COMMON_LVB_REVERSE_VIDEO, false, attributes);
+            break;
+        case GraphicsOptions::Underline:
+            s_SetMetaFlag(COMMON_LVB_UNDERSCORE, true, attributes);
+            break;
+        case GraphicsOptions::NoUnderline:
+            s_SetMetaFlag(COMMON_LVB_UNDERSCORE, false, attributes);
+            break;
+        case GraphicsOptions::ForegroundDefault:
+            attributes.SetDefaultForeground();
+            break;
+        case GraphicsOptions::BackgroundDefault:
+            attributes.SetDefaultBackground();
+            break;
+        case GraphicsOptions::ForegroundExtended:
+        case GraphicsOptions::BackgroundExtended:
+        {
+            size_t cOptionsConsumed = 0;
+            fSuccess = s_ApplyExtendedColor(&rgOptions[i], cOptions - i, order, attributes, &cOptionsConsumed);
+            i += (cOptionsConsumed - 1); // cOptionsConsumed includes the opt we're currently on.
+            break;
+        }
+        default:
+            if (opt >= GraphicsOptions::ForegroundBlack && opt <= GraphicsOptions::ForegroundWhite)
+            {
+                s_SetIndexedColor(opt - GraphicsOptions::ForegroundBlack, true, order, attributes);
+            }
+            else if (opt >= GraphicsOptions::BackgroundBlack && opt <= GraphicsOptions::BackgroundWhite)
+            {
+                s_SetIndexedColor(opt - GraphicsOptions::BackgroundBlack, false, order, attributes);
+            }
+            else if (opt >= GraphicsOptions::BrightForegroundBlack && opt <= GraphicsOptions::BrightForegroundWhite)
+            {
+                s_SetIndexedColor((opt - GraphicsOptions::BrightForegroundBlack) | XTERM_BRIGHT_ATTR, true, order, attributes);
+            }
+            else if (opt >= GraphicsOptions::BrightBackgroundBlack && opt <= GraphicsOptions::BrightBackgroundWhite)
+            {
+                s_SetIndexedColor((opt - GraphicsOptions::BrightBackgroundBlack) | XTERM_BRIGHT_ATTR, false, order, attributes);
+            }
+            // Anything else is unsupported and left alone.
+            break;
+        }
+    }
+    return fSuccess;
+}
+
+// Routine Description:
+// - Helper to parse extended graphics options, which start with 38 (FG) or 48 (BG)
+//     These options are followed by either a 2 (RGB) or 5 (xterm index)
+//      RGB sequences then take 3 MORE params to designate the R, G, B parts of the color
+//      Xterm index will use the param that follows to use a color from the preset 256 color xterm color table.
+// Arguments:
+// - rgOptions - An array of options starting with the 38 or 48
+// - cOptions - The count of options
+// - order - The order of the color table the attributes will be drawn with.
+// - attributes - The attributes to modify.
+// - pcOptionsConsumed - a pointer to place the number of options we consumed parsing this option.
+// Return Value:
+// Returns true if we successfully parsed an extended color option from the options array.
+// - This corresponds to the following number of options consumed (pcOptionsConsumed):
+//     1 - false, not enough options to parse.
+//     2 - false, not enough options to parse.
+//     3 - true, parsed an xterm index to a color
+//     5 - true, parsed an RGB color.
+bool GraphicsRendition::s_ApplyExtendedColor(_In_reads_(cOptions) const GraphicsOptions* const rgOptions,
+                                             const size_t cOptions,
+                                             const ColorOrder order,
+                                             TextAttribute& attributes,
+                                             _Out_ size_t* const pcOptionsConsumed)
+{
+    bool fSuccess = false;
+    *pcOptionsConsumed = 1;
+    if (cOptions >= 2)
+    {
+        *pcOptionsConsumed = 2;
+        const bool isForeground = rgOptions[0] == GraphicsOptions::ForegroundExtended;
+        const GraphicsOptions typeOpt = rgOptions[1];
+
+        if (typeOpt == GraphicsOptions::RGBColor && cOptions >= 5)
+        {
+            *pcOptionsConsumed = 5;
+            // ensure that each value fits in a byte
+            const unsigned int red = std::min<unsigned int>(rgOptions[2], 255);
+            const unsigned int green = std::min<unsigned int>(rgOptions[3], 255);
+            const unsigned int blue = std::min<unsigned int>(rgOptions[4], 255);
+
+            attributes.SetColor(RGB(red, green, blue), isForeground);
+            fSuccess = true;
+        }
+        else if (typeOpt == GraphicsOptions::Xterm256Index && cOptions >= 3)
+        {
+            *pcOptionsConsumed = 3;
+            if (rgOptions[2] <= 255) // ensure that the provided index is on the table
+            {
+                s_SetIndexedColor(rgOptions[2], isForeground, order, attributes);
+                fSuccess = true;
+            }
+        }
+    }
+    return fSuccess;
+}
+
+// Routine Description:
+// - Sets the foreground or background to an entry of the xterm color table,
+//   translating the first 16 entries to the given table order.
+// Arguments:
+// - xtermIndex - The index into the xterm table, in [0, 255].
+// - isForeground - Whether to set the foreground or the background.
+// - order - The order of the color table the attributes will be drawn with.
+// - attributes - The attributes to modify.
+// Return Value:
+// - <none>
+void GraphicsRendition::s_SetIndexedColor(const size_t xtermIndex,
+                                          const bool isForeground,
+                                          const ColorOrder order,
+                                          TextAttribute& attributes) noexcept
+{
+    BYTE index = gsl::narrow_cast<BYTE>(xtermIndex);
+    if (order == ColorOrder::Windows && xtermIndex < COLOR_TABLE_SIZE)
+    {
+        index = gsl::narrow_cast<BYTE>((xtermIndex & (XTERM_GREEN_ATTR | XTERM_BRIGHT_ATTR)) |
+                                       (WI_IsFlagSet(xtermIndex, XTERM_RED_ATTR) ? WINDOWS_RED_ATTR : 0) |
+                                       (WI_IsFlagSet(xtermIndex, XTERM_BLUE_ATTR) ? WINDOWS_BLUE_ATTR : 0));
+    }
+
+    if (isForeground)
+    {
+        attributes.SetIndexedAttributes(index, std::nullopt);
+    }
+    else
+    {
+        attributes.SetIndexedAttributes(std::nullopt, index);
+    }
+}
+
+void GraphicsRendition::s_SetMetaFlag(const WORD flag,
+                                      const bool isSet,
+                                      TextAttribute& attributes) noexcept
+{
+    WORD meta = attributes.GetMetaAttributes();
+    WI_UpdateFlag(meta, flag, isSet);
+    attributes.SetMetaAttributes(meta);
+}
@@ -0,0 +1,53 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- GraphicsRendition.hpp
+
+Abstract:
+- Folds the options of an SGR (Set Graphics Rendition) sequence into a text
+    attribute. This is shared by every dispatcher that handles SGR, so that
+    they only differ in how the finished attribute is read and committed.
+--*/
+
+#pragma once
+
+#include "DispatchTypes.hpp"
+#include "../../buffer/out/TextAttribute.hpp"
+
+namespace Microsoft::Console::VirtualTerminal
+{
+    class GraphicsRendition final
+    {
+    public:
+        // The order of the first 16 entries of the color table the attribute
+        //      indexes into. The two only differ in where red and blue are.
+        enum class ColorOrder
+        {
+            Windows,
+            Xterm
+        };
+
+        static bool s_Apply(_In_reads_(cOptions) const DispatchTypes::GraphicsOptions* const rgOptions,
+                            const size_t cOptions,
+                            const ColorOrder order,
+                            TextAttribute& attributes);
+
+    private:
+        static bool s_ApplyExtendedColor(_In_reads_(cOptions) const DispatchTypes::GraphicsOptions* const rgOptions,
+                                         const size_t cOptions,
+                                         const ColorOrder order,
+                                         TextAttribute& attributes,
+                                         _Out_ size_t* const pcOptionsConsumed);
+
+        static void s_SetIndexedColor(const size_t xtermIndex,
+                                      const bool isForeground,
+                                      const ColorOrder order,
+                                      TextAttribute& attributes) noexcept;
+
+        static void s_SetMetaFlag(const WORD flag,
+                                  const bool isSet,
+                                  TextAttribute& attributes) noexcept;
+    };
+}
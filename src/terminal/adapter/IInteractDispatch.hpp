@@ -31,6 +31,10 @@ namespace Microsoft::Console::VirtualTerminal
 
         virtual bool WriteString(_In_reads_(cch) const wchar_t* const pws, const size_t cch) = 0;
 
+        virtual bool ConvertString(_In_reads_(cch) const wchar_t* const pws,
+                                   const size_t cch,
+                                   _Inout_ std::deque<std::unique_ptr<IInputEvent>>& inputEvents) = 0;
+
         virtual bool WindowManipulation(const DispatchTypes::WindowManipulationType uiFunction,
                                         _In_reads_(cParams) const unsigned short* const rgusParams,
                                         const size_t cParams) = 0;
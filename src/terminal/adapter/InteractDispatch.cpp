@@ -66,22 +66,42 @@ bool InteractDispatch::WriteString(_In_reads_(cch) const wchar_t* const pws,
         return true;
     }
 
+    std::deque<std::unique_ptr<IInputEvent>> keyEvents;
+    bool fSuccess = ConvertString(pws, cch, keyEvents);
+    if (fSuccess)
+    {
+        fSuccess = WriteInput(keyEvents);
+    }
+    return fSuccess;
+}
+
+// Method Description:
+// - Converts a string of input into the keystrokes that will faithfully
+//      represent it (see CharToKeyEvents), without writing them to the host.
+//      This lets a caller accumulate the keystrokes from many strings and
+//      write them all at once.
+// Arguments:
+// - pws: a string to convert.
+// - cch: the number of chars in pws.
+// - inputEvents: the collection to append the keystrokes to.
+// Return Value:
+// True if handled successfully. False otherwise.
+bool InteractDispatch::ConvertString(_In_reads_(cch) const wchar_t* const pws,
+                                     const size_t cch,
+                                     _Inout_ std::deque<std::unique_ptr<IInputEvent>>& inputEvents)
+{
     unsigned int codepage = 0;
     bool fSuccess = !!_pConApi->GetConsoleOutputCP(&codepage);
     if (fSuccess)
     {
-        std::deque<std::unique_ptr<IInputEvent>> keyEvents;
-
         for (size_t i = 0; i < cch; ++i)
         {
             std::deque<std::unique_ptr<KeyEvent>> convertedEvents = CharToKeyEvents(pws[i], codepage);
 
             std::move(convertedEvents.begin(),
                       convertedEvents.end(),
-                      std::back_inserter(keyEvents));
+                      std::back_inserter(inputEvents));
         }
-
-        fSuccess = WriteInput(keyEvents);
     }
     return fSuccess;
 }
@@ -31,6 +31,9 @@ namespace Microsoft::Console::VirtualTerminal
         virtual bool WriteInput(_In_ std::deque<std::unique_ptr<IInputEvent>>& inputEvents) override;
         virtual bool WriteCtrlC() override;
         virtual bool WriteString(_In_reads_(cch) const wchar_t* const pws, const size_t cch) override;
+        virtual bool ConvertString(_In_reads_(cch) const wchar_t* const pws,
+                                   const size_t cch,
+                                   _Inout_ std::deque<std::unique_ptr<IInputEvent>>& inputEvents) override;
         virtual bool WindowManipulation(const DispatchTypes::WindowManipulationType uiFunction,
                                         _In_reads_(cParams) const unsigned short* const rgusParams,
                                         const size_t cParams) override; // DTTERM_WindowManipulation
@@ -28,9 +28,6 @@ AdaptDispatch::AdaptDispatch(ConGetSet* const pConApi,
                              AdaptDefaults* const pDefaults)
     : _conApi{ THROW_IF_NULL_ALLOC(pConApi) },
       _pDefaults{ THROW_IF_NULL_ALLOC(pDefaults) },
-      _fChangedBackground(false),
-      _fChangedForeground(false),
-      _fChangedMetaAttrs(false),
       _TermOutput()
 {
     // The top-left corner in VT-speak is 1,1. Our internal array uses 0 indexes, but VT uses 1,1 for top left corner.
@@ -1135,6 +1132,9 @@ bool AdaptDispatch::_PrivateModeParamsHelper(_In_ DispatchTypes::PrivateModePara
     case DispatchTypes::PrivateModeParams::ASB_AlternateScreenBuffer:
         fSuccess = fEnable? UseAlternateScreenBuffer() : UseMainScreenBuffer();
         break;
+    case DispatchTypes::PrivateModeParams::BRACKETED_PASTE_MODE:
+        fSuccess = EnableBracketedPasteMode(fEnable);
+        break;
     default:
         // If no functions to call, overall dispatch was a failure.
         fSuccess = false;
@@ -1743,6 +1743,18 @@ bool AdaptDispatch::EnableAlternateScroll(const bool fEnabled)
     return !!_conApi->PrivateEnableAlternateScroll(fEnabled);
 }
 
+//Routine Description:
+// Enable Bracketed Paste Mode - Pasted text is surrounded with ESC[200~ and
+//      ESC[201~ so the client can tell it apart from typed input.
+//Arguments:
+// - fEnabled - true to enable, false to disable.
+// Return value:
+// True if handled successfully. False othewise.
+bool AdaptDispatch::EnableBracketedPasteMode(const bool fEnabled)
+{
+    return !!_conApi->PrivateEnableBracketedPasteMode(fEnabled);
+}
+
 //Routine Description:
 // Set Cursor Style - Changes the cursor's style to match the given Dispatch
 //      cursor style. Unix styles are a combination of the shape and the blinking state.
@@ -93,6 +93,7 @@ namespace Microsoft::Console::VirtualTerminal
         virtual bool EnableButtonEventMouseMode(const bool fEnabled); // ?1002
         virtual bool EnableAnyEventMouseMode(const bool fEnabled); // ?1003
         virtual bool EnableAlternateScroll(const bool fEnabled); // ?1007
+        virtual bool EnableBracketedPasteMode(const bool fEnabled); // ?2004
         virtual bool SetCursorStyle(const DispatchTypes::CursorStyle cursorStyle); // DECSCUSR
         virtual bool SetCursorColor(const COLORREF cursorColor);
 
@@ -122,16 +123,12 @@ namespace Microsoft::Console::VirtualTerminal
         bool _CursorMovement(const CursorDirection dir, _In_ unsigned int const uiDistance) const;
         bool _CursorMovePosition(_In_opt_ const unsigned int* const puiRow, _In_opt_ const unsigned int* const puiCol) const;
         bool _EraseSingleLineHelper(const CONSOLE_SCREEN_BUFFER_INFOEX* const pcsbiex, const DispatchTypes::EraseType eraseType, const SHORT sLineId, const WORD wFillColor) const;
-        void _SetGraphicsOptionHelper(const DispatchTypes::GraphicsOptions opt, _Inout_ WORD* const pAttr);
         bool _EraseAreaHelper(const COORD coordStartPosition, const COORD coordLastPosition, const WORD wFillColor);
         bool _EraseSingleLineDistanceHelper(const COORD coordStartPosition, const DWORD dwLength, const WORD wFillColor) const;
         bool _EraseScrollback();
         bool _EraseAll();
-        void _SetGraphicsOptionHelper(const DispatchTypes::GraphicsOptions opt, _Inout_ WORD* const pAttr) const;
         bool _InsertDeleteHelper(_In_ unsigned int const uiCount, const bool fIsInsert) const;
         bool _ScrollMovement(const ScrollDirection dir, _In_ unsigned int const uiDistance) const;
-        static void s_DisableAllColors(_Inout_ WORD* const pAttr, const bool fIsForeground);
-        static void s_ApplyColors(_Inout_ WORD* const pAttr, const WORD wApplyThis, const bool fIsForeground);
 
         bool _DoSetTopBottomScrollingMargins(const SHORT sTopMargin,
                                              const SHORT sBottomMargin);
@@ -150,23 +147,5 @@ namespace Microsoft::Console::VirtualTerminal
         SMALL_RECT _srScrollMargins;
 
         bool _fIsSetColumnsEnabled;
-
-        bool _fChangedForeground;
-        bool _fChangedBackground;
-        bool _fChangedMetaAttrs;
-
-        bool _SetRgbColorsHelper(_In_reads_(cOptions) const DispatchTypes::GraphicsOptions* const rgOptions,
-                                 const size_t cOptions,
-                                 _Out_ COLORREF* const prgbColor,
-                                 _Out_ bool* const pfIsForeground,
-                                 _Out_ size_t* const pcOptionsConsumed);
-
-        bool _SetBoldColorHelper(const DispatchTypes::GraphicsOptions option);
-        bool _SetDefaultColorHelper(const DispatchTypes::GraphicsOptions option);
-
-        static bool s_IsXtermColorOption(const DispatchTypes::GraphicsOptions opt);
-        static bool s_IsRgbColorOption(const DispatchTypes::GraphicsOptions opt);
-        static bool s_IsBoldColorOption(const DispatchTypes::GraphicsOptions opt) noexcept;
-        static bool s_IsDefaultColorOption(const DispatchTypes::GraphicsOptions opt) noexcept;
     };
 }
@@ -61,6 +61,7 @@ public:
     virtual bool EnableButtonEventMouseMode(const bool /*fEnabled*/) { return false; } // ?1002
     virtual bool EnableAnyEventMouseMode(const bool /*fEnabled*/) { return false; } // ?1003
     virtual bool EnableAlternateScroll(const bool /*fEnabled*/) { return false; } // ?1007
+    virtual bool EnableBracketedPasteMode(const bool /*fEnabled*/) { return false; } // ?2004
     virtual bool SetColorTableEntry(const size_t /*tableIndex*/, const DWORD /*dwColor*/) { return false; } // OSCColorTable
 
     virtual bool EraseInDisplay(const DispatchTypes::EraseType /* eraseType*/) { return false; } // ED
@@ -5,7 +5,7 @@
 #include <windows.h>
 #include "terminalInput.hpp"
 
-#include "strsafe.h"
+#include <array>
 
 #define WIL_SUPPORT_BITOPERATION_PASCAL_NAMES
 #include <wil\Common.h>
@@ -20,9 +20,17 @@ using namespace Microsoft::Console::VirtualTerminal;
 
 DWORD const dwAltGrFlags = LEFT_CTRL_PRESSED | RIGHT_ALT_PRESSED;
 
-TerminalInput::TerminalInput(_In_ std::function<void(std::deque<std::unique_ptr<IInputEvent>>&)> pfn)
+// Routine Description:
+// - Creates a new TerminalInput.
+// Arguments:
+// - pfn - receives the key events that keys are translated into.
+// - pfnWriteText - optional. If provided, pasted text is handed to it as one
+//      string instead of being turned into one key event per character.
+TerminalInput::TerminalInput(_In_ std::function<void(std::deque<std::unique_ptr<IInputEvent>>&)> pfn,
+                             _In_ std::function<void(const std::wstring_view)> pfnWriteText)
 {
     _pfnWriteEvents = pfn;
+    _pfnWriteText = pfnWriteText;
 }
 
 TerminalInput::~TerminalInput()
@@ -30,358 +38,382 @@ TerminalInput::~TerminalInput()
 
 }
 
-// See http://invisible-island.net/xterm/ctlseqs/ctlseqs.html#h2-PC-Style-Function-Keys
-//    For the source for these tables.
-// Also refer to the values in terminfo for kcub1, kcud1, kcuf1, kcuu1, kend, khome.
-//   the 'xterm' setting lists the application mode versions of these sequences.
-const TerminalInput::_TermKeyMap TerminalInput::s_rgCursorKeysNormalMapping[]
-{
-    { VK_UP, L"\x1b[A" },
-    { VK_DOWN, L"\x1b[B" },
-    { VK_RIGHT, L"\x1b[C" },
-    { VK_LEFT, L"\x1b[D" },
-    { VK_HOME, L"\x1b[H" },
-    { VK_END, L"\x1b[F" },
-};
-
-const TerminalInput::_TermKeyMap TerminalInput::s_rgCursorKeysApplicationMapping[]
-{
-    { VK_UP, L"\x1bOA" },
-    { VK_DOWN, L"\x1bOB" },
-    { VK_RIGHT, L"\x1bOC" },
-    { VK_LEFT, L"\x1bOD" },
-    { VK_HOME, L"\x1bOH" },
-    { VK_END, L"\x1bOF" },
-};
-
-const TerminalInput::_TermKeyMap TerminalInput::s_rgKeypadNumericMapping[]
-{
-    // HEY YOU. UPDATE THE MAX LENGTH DEF WHEN YOU MAKE CHANGES HERE.
-    { VK_TAB, L"\x09"},
-    { VK_BACK, L"\x7f"},
-    { VK_PAUSE, L"\x1a" },
-    { VK_ESCAPE, L"\x1b" },
-    { VK_INSERT, L"\x1b[2~" },
-    { VK_DELETE, L"\x1b[3~" },
-    { VK_PRIOR, L"\x1b[5~" },
-    { VK_NEXT, L"\x1b[6~" },
-    { VK_F1, L"\x1bOP" }, // also \x1b[11~, PuTTY uses \x1b\x1b[A
-    { VK_F2, L"\x1bOQ" }, // also \x1b[12~, PuTTY uses \x1b\x1b[B
-    { VK_F3, L"\x1bOR" }, // also \x1b[13~, PuTTY uses \x1b\x1b[C
-    { VK_F4, L"\x1bOS" }, // also \x1b[14~, PuTTY uses \x1b\x1b[D
-    { VK_F5, L"\x1b[15~" },
-    { VK_F6, L"\x1b[17~" },
-    { VK_F7, L"\x1b[18~" },
-    { VK_F8, L"\x1b[19~" },
-    { VK_F9, L"\x1b[20~" },
-    { VK_F10, L"\x1b[21~" },
-    { VK_F11, L"\x1b[23~" },
-    { VK_F12, L"\x1b[24~" },
-};
-
-//Application mode - Some terminals support both a "Numeric" input mode, and an "Application" mode
-//  The standards vary on what each key translates to in the various modes, so I tried to make it as close
-//  to the VT220 standard as possible.
-//  The notable difference is in the arrow keys, which in application mode translate to "^[0A" (etc) as opposed to "^[[A" in numeric
-//Some very unclear documentation at http://invisible-island.net/xterm/ctlseqs/ctlseqs.html also suggests alternate encodings for F1-4
-//  which I have left in the comments on those entries as something to possibly add in the future, if need be.
-//It seems to me as though this was used for early numpad implementations, where presently numlock would enable
-//  "numeric" mode, outputting the numbers on the keys, while "application" mode does things like pgup/down, arrow keys, etc.
-//These keys aren't translated at all in numeric mode, so I figured I'd leave them out of the numeric table.
-const TerminalInput::_TermKeyMap TerminalInput::s_rgKeypadApplicationMapping[]
+namespace
 {
-    // HEY YOU. UPDATE THE MAX LENGTH DEF WHEN YOU MAKE CHANGES HERE.
-    { VK_TAB, L"\x09" },
-    { VK_BACK, L"\x7f" },
-    { VK_PAUSE, L"\x1a" },
-    { VK_ESCAPE, L"\x1b" },
-    { VK_INSERT, L"\x1b[2~" },
-    { VK_DELETE, L"\x1b[3~" },
-    { VK_PRIOR, L"\x1b[5~" },
-    { VK_NEXT, L"\x1b[6~" },
-    { VK_F1, L"\x1bOP" }, // also \x1b[11~, PuTTY uses \x1b\x1b[A
-    { VK_F2, L"\x1bOQ" }, // also \x1b[12~, PuTTY uses \x1b\x1b[B
-    { VK_F3, L"\x1bOR" }, // also \x1b[13~, PuTTY uses \x1b\x1b[C
-    { VK_F4, L"\x1bOS" }, // also \x1b[14~, PuTTY uses \x1b\x1b[D
-    { VK_F5, L"\x1b[15~" },
-    { VK_F6, L"\x1b[17~" },
-    { VK_F7, L"\x1b[18~" },
-    { VK_F8, L"\x1b[19~" },
-    { VK_F9, L"\x1b[20~" },
-    { VK_F10, L"\x1b[21~" },
-    { VK_F11, L"\x1b[23~" },
-    { VK_F12, L"\x1b[24~" },
-    // The numpad has a variety of mappings, none of which seem standard or really configurable by the OS.
+    // One entry of the human readable key tables below. A mapping without
+    //      modifiers matches regardless of the modifier state; one with
+    //      modifiers only matches that exact combination of shift/alt/ctrl.
+    struct TermKeyMap
+    {
+        WORD vkey;
+        std::wstring_view sequence;
+        DWORD modifiers = 0;
+    };
+
     // See http://invisible-island.net/xterm/ctlseqs/ctlseqs.html#h2-PC-Style-Function-Keys
-    //   to see just how convoluted this all is.
-    // PuTTY uses a set of mappings that don't work in ViM without reamapping them back to the numpad
-    // (see http://vim.wikia.com/wiki/PuTTY_numeric_keypad_mappings#Comments)
-    // I think the best solution is to just not do any for the time being.
-    // Putty also provides configuration for choosing which of the 5 mappings it has through the settings, which is more work than we can manage now.
-    // { VK_MULTIPLY, L"\x1bOj" },     // PuTTY: \x1bOR (I believe putty is treating the top row of the numpad as PF1-PF4)
-    // { VK_ADD, L"\x1bOk" },          // PuTTY: \x1bOl, \x1bOm (with shift)
-    // { VK_SEPARATOR, L"\x1bOl" },    // ? I'm not sure which key this is...
-    // { VK_SUBTRACT, L"\x1bOm" },     // \x1bOS
-    // { VK_DECIMAL, L"\x1bOn" },      // \x1bOn
-    // { VK_DIVIDE, L"\x1bOo" },       // \x1bOQ
-    // { VK_NUMPAD0, L"\x1bOp" },
-    // { VK_NUMPAD1, L"\x1bOq" },
-    // { VK_NUMPAD2, L"\x1bOr" },
-    // { VK_NUMPAD3, L"\x1bOs" },
-    // { VK_NUMPAD4, L"\x1bOt" },
-    // { VK_NUMPAD5, L"\x1bOu" }, // \x1b0E
-    // { VK_NUMPAD5, L"\x1bOE" }, // PuTTY \x1b[G
-    // { VK_NUMPAD6, L"\x1bOv" },
-    // { VK_NUMPAD7, L"\x1bOw" },
-    // { VK_NUMPAD8, L"\x1bOx" },
-    // { VK_NUMPAD9, L"\x1bOy" },
-    // { '=', L"\x1bOX" },      // I've also seen these codes mentioned in some documentation,
-    // { VK_SPACE, L"\x1bO " }, //  but I wasn't really sure if they should be included or not...
-    // { VK_TAB, L"\x1bOI" },   // So I left them here as a reference just in case.
-};
-
-// Sequences to send when a modifier is pressed with any of these keys
-// Basically, the 'm' will be replaced with a character indicating which
-//      modifier keys are pressed.
-const TerminalInput::_TermKeyMap TerminalInput::s_rgModifierKeyMapping[]
-{
-    // HEY YOU. UPDATE THE MAX LENGTH DEF WHEN YOU MAKE CHANGES HERE.
-    { VK_UP, L"\x1b[1;mA" },
-    { VK_DOWN, L"\x1b[1;mB" },
-    { VK_RIGHT, L"\x1b[1;mC" },
-    { VK_LEFT, L"\x1b[1;mD" },
-    { VK_HOME, L"\x1b[1;mH" },
-    { VK_END, L"\x1b[1;mF" },
-    { VK_F1, L"\x1b[1;mP" },
-    { VK_F2, L"\x1b[1;mQ" },
-    { VK_F3, L"\x1b[1;mR" },
-    { VK_F4, L"\x1b[1;mS" },
-    { VK_INSERT, L"\x1b[2;m~" },
-    { VK_DELETE, L"\x1b[3;m~" },
-    { VK_PRIOR, L"\x1b[5;m~" },
-    { VK_NEXT, L"\x1b[6;m~" },
-    { VK_F5, L"\x1b[15;m~" },
-    { VK_F6, L"\x1b[17;m~" },
-    { VK_F7, L"\x1b[18;m~" },
-    { VK_F8, L"\x1b[19;m~" },
-    { VK_F9, L"\x1b[20;m~" },
-    { VK_F10, L"\x1b[21;m~" },
-    { VK_F11, L"\x1b[23;m~" },
-    { VK_F12, L"\x1b[24;m~" },
-    // Ubuntu's inputrc also defines \x1b[5C, \x1b\x1bC (and D) as 'forward/backward-word' mappings
-    // I believe '\x1b\x1bC' is listed because the C1 ESC (x9B) gets encoded as
-    //  \xC2\x9B, but then translated to \x1b\x1b if the C1 codepoint isn't supported by the current encoding
-};
-
-// Sequences to send when a modifier is pressed with any of these keys
-// These sequences are not later updated to encode the modifier state in the
-//      sequence itself, they are just weird exceptional cases to the general
-//      rules above.
-const TerminalInput::_TermKeyMap TerminalInput::s_rgSimpleModifedKeyMapping[]
-{
-    // HEY YOU. UPDATE THE MAX LENGTH DEF WHEN YOU MAKE CHANGES HERE.
-    { VK_BACK, CTRL_PRESSED, L"\x8"},
-    { VK_BACK, ALT_PRESSED, L"\x1b\x7f"},
-    { VK_BACK, CTRL_PRESSED | ALT_PRESSED, L"\x1b\x8"},
-    { VK_TAB, CTRL_PRESSED, L"\t"},
-    { VK_TAB, SHIFT_PRESSED, L"\x1b[Z"},
-    { VK_DIVIDE, CTRL_PRESSED, L"\x1F"},
-    // These two are not implemented here, because they are system keys.
-    // { VK_TAB, ALT_PRESSED, L""}, This is the Windows system shortcut for switching windows.
-    // { VK_ESCAPE, ALT_PRESSED, L""}, This is another Windows system shortcut for switching windows.
-};
-
-const wchar_t* const CTRL_SLASH_SEQUENCE = L"\x1f";
-
-// Do NOT include the null terminator in the count.
-const size_t TerminalInput::_TermKeyMap::s_cchMaxSequenceLength = 7; // UPDATE THIS DEF WHEN THE LONGEST MAPPED STRING CHANGES
-
-const size_t TerminalInput::s_cCursorKeysNormalMapping      = ARRAYSIZE(s_rgCursorKeysNormalMapping);
-const size_t TerminalInput::s_cCursorKeysApplicationMapping = ARRAYSIZE(s_rgCursorKeysApplicationMapping);
-const size_t TerminalInput::s_cKeypadNumericMapping         = ARRAYSIZE(s_rgKeypadNumericMapping);
-const size_t TerminalInput::s_cKeypadApplicationMapping     = ARRAYSIZE(s_rgKeypadApplicationMapping);
-const size_t TerminalInput::s_cModifierKeyMapping           = ARRAYSIZE(s_rgModifierKeyMapping);
-const size_t TerminalInput::s_cSimpleModifedKeyMapping      = ARRAYSIZE(s_rgSimpleModifedKeyMapping);
+    //    For the source for these tables.
+    // Also refer to the values in terminfo for kcub1, kcud1, kcuf1, kcuu1, kend, khome.
+    //   the 'xterm' setting lists the application mode versions of these sequences.
+    constexpr TermKeyMap s_rgCursorKeysNormalMapping[]
+    {
+        { VK_UP, L"\x1b[A" },
+        { VK_DOWN, L"\x1b[B" },
+        { VK_RIGHT, L"\x1b[C" },
+        { VK_LEFT, L"\x1b[D" },
+        { VK_HOME, L"\x1b[H" },
+        { VK_END, L"\x1b[F" },
+    };
+
+    constexpr TermKeyMap s_rgCursorKeysApplicationMapping[]
+    {
+        { VK_UP, L"\x1bOA" },
+        { VK_DOWN, L"\x1bOB" },
+        { VK_RIGHT, L"\x1bOC" },
+        { VK_LEFT, L"\x1bOD" },
+        { VK_HOME, L"\x1bOH" },
+        { VK_END, L"\x1bOF" },
+    };
+
+    constexpr TermKeyMap s_rgKeypadNumericMapping[]
+    {
+        { VK_TAB, L"\x09" },
+        { VK_BACK, L"\x7f" },
+        { VK_PAUSE, L"\x1a" },
+        { VK_ESCAPE, L"\x1b" },
+        { VK_INSERT, L"\x1b[2~" },
+        { VK_DELETE, L"\x1b[3~" },
+        { VK_PRIOR, L"\x1b[5~" },
+        { VK_NEXT, L"\x1b[6~" },
+        { VK_F1, L"\x1bOP" }, // also \x1b[11~, PuTTY uses \x1b\x1b[A
+        { VK_F2, L"\x1bOQ" }, // also \x1b[12~, PuTTY uses \x1b\x1b[B
+        { VK_F3, L"\x1bOR" }, // also \x1b[13~, PuTTY uses \x1b\x1b[C
+        { VK_F4, L"\x1bOS" }, // also \x1b[14~, PuTTY uses \x1b\x1b[D
+        { VK_F5, L"\x1b[15~" },
+        { VK_F6, L"\x1b[17~" },
+        { VK_F7, L"\x1b[18~" },
+        { VK_F8, L"\x1b[19~" },
+        { VK_F9, L"\x1b[20~" },
+        { VK_F10, L"\x1b[21~" },
+        { VK_F11, L"\x1b[23~" },
+        { VK_F12, L"\x1b[24~" },
+    };
+
+    //Application mode - Some terminals support both a "Numeric" input mode, and an "Application" mode
+    //  The standards vary on what each key translates to in the various modes, so I tried to make it as close
+    //  to the VT220 standard as possible.
+    //  The notable difference is in the arrow keys, which in application mode translate to "^[0A" (etc) as opposed to "^[[A" in numeric
+    //Some very unclear documentation at http://invisible-island.net/xterm/ctlseqs/ctlseqs.html also suggests alternate encodings for F1-4
+    //  which I have left in the comments on those entries as something to possibly add in the future, if need be.
+    //It seems to me as though this was used for early numpad implementations, where presently numlock would enable
+    //  "numeric" mode, outputting the numbers on the keys, while "application" mode does things like pgup/down, arrow keys, etc.
+    //These keys aren't translated at all in numeric mode, so I figured I'd leave them out of the numeric table.
+    constexpr TermKeyMap s_rgKeypadApplicationMapping[]
+    {
+        { VK_TAB, L"\x09" },
+        { VK_BACK, L"\x7f" },
+        { VK_PAUSE, L"\x1a" },
+        { VK_ESCAPE, L"\x1b" },
+        { VK_INSERT, L"\x1b[2~" },
+        { VK_DELETE, L"\x1b[3~" },
+        { VK_PRIOR, L"\x1b[5~" },
+        { VK_NEXT, L"\x1b[6~" },
+        { VK_F1, L"\x1bOP" }, // also \x1b[11~, PuTTY uses \x1b\x1b[A
+        { VK_F2, L"\x1bOQ" }, // also \x1b[12~, PuTTY uses \x1b\x1b[B
+        { VK_F3, L"\x1bOR" }, // also \x1b[13~, PuTTY uses \x1b\x1b[C
+        { VK_F4, L"\x1bOS" }, // also \x1b[14~, PuTTY uses \x1b\x1b[D
+        { VK_F5, L"\x1b[15~" },
+        { VK_F6, L"\x1b[17~" },
+        { VK_F7, L"\x1b[18~" },
+        { VK_F8, L"\x1b[19~" },
+        { VK_F9, L"\x1b[20~" },
+        { VK_F10, L"\x1b[21~" },
+        { VK_F11, L"\x1b[23~" },
+        { VK_F12, L"\x1b[24~" },
+        // The numpad has a variety of mappings, none of which seem standard or really configurable by the OS.
+        // See http://invisible-island.net/xterm/ctlseqs/ctlseqs.html#h2-PC-Style-Function-Keys
+        //   to see just how convoluted this all is.
+        // PuTTY uses a set of mappings that don't work in ViM without reamapping them back to the numpad
+        // (see http://vim.wikia.com/wiki/PuTTY_numeric_keypad_mappings#Comments)
+        // I think the best solution is to just not do any for the time being.
+        // Putty also provides configuration for choosing which of the 5 mappings it has through the settings, which is more work than we can manage now.
+        // { VK_MULTIPLY, L"\x1bOj" },     // PuTTY: \x1bOR (I believe putty is treating the top row of the numpad as PF1-PF4)
+        // { VK_ADD, L"\x1bOk" },          // PuTTY: \x1bOl, \x1bOm (with shift)
+        // { VK_SEPARATOR, L"\x1bOl" },    // ? I'm not sure which key this is...
+        // { VK_SUBTRACT, L"\x1bOm" },     // \x1bOS
+        // { VK_DECIMAL, L"\x1bOn" },      // \x1bOn
+        // { VK_DIVIDE, L"\x1bOo" },       // \x1bOQ
+        // { VK_NUMPAD0, L"\x1bOp" },
+        // { VK_NUMPAD1, L"\x1bOq" },
+        // { VK_NUMPAD2, L"\x1bOr" },
+        // { VK_NUMPAD3, L"\x1bOs" },
+        // { VK_NUMPAD4, L"\x1bOt" },
+        // { VK_NUMPAD5, L"\x1bOu" }, // \x1b0E
+        // { VK_NUMPAD5, L"\x1bOE" }, // PuTTY \x1b[G
+        // { VK_NUMPAD6, L"\x1bOv" },
+        // { VK_NUMPAD7, L"\x1bOw" },
+        // { VK_NUMPAD8, L"\x1bOx" },
+        // { VK_NUMPAD9, L"\x1bOy" },
+        // { '=', L"\x1bOX" },      // I've also seen these codes mentioned in some documentation,
+        // { VK_SPACE, L"\x1bO " }, //  but I wasn't really sure if they should be included or not...
+        // { VK_TAB, L"\x1bOI" },   // So I left them here as a reference just in case.
+    };
+
+    // Sequences to send when a modifier is pressed with any of these keys
+    // Basically, the 'm' will be replaced with a character indicating which
+    //      modifier keys are pressed.
+    constexpr TermKeyMap s_rgModifierKeyMapping[]
+    {
+        { VK_UP, L"\x1b[1;mA" },
+        { VK_DOWN, L"\x1b[1;mB" },
+        { VK_RIGHT, L"\x1b[1;mC" },
+        { VK_LEFT, L"\x1b[1;mD" },
+        { VK_HOME, L"\x1b[1;mH" },
+        { VK_END, L"\x1b[1;mF" },
+        { VK_F1, L"\x1b[1;mP" },
+        { VK_F2, L"\x1b[1;mQ" },
+        { VK_F3, L"\x1b[1;mR" },
+        { VK_F4, L"\x1b[1;mS" },
+        { VK_INSERT, L"\x1b[2;m~" },
+        { VK_DELETE, L"\x1b[3;m~" },
+        { VK_PRIOR, L"\x1b[5;m~" },
+        { VK_NEXT, L"\x1b[6;m~" },
+        { VK_F5, L"\x1b[15;m~" },
+        { VK_F6, L"\x1b[17;m~" },
+        { VK_F7, L"\x1b[18;m~" },
+        { VK_F8, L"\x1b[19;m~" },
+        { VK_F9, L"\x1b[20;m~" },
+        { VK_F10, L"\x1b[21;m~" },
+        { VK_F11, L"\x1b[23;m~" },
+        { VK_F12, L"\x1b[24;m~" },
+        // Ubuntu's inputrc also defines \x1b[5C, \x1b\x1bC (and D) as 'forward/backward-word' mappings
+        // I believe '\x1b\x1bC' is listed because the C1 ESC (x9B) gets encoded as
+        //  \xC2\x9B, but then translated to \x1b\x1b if the C1 codepoint isn't supported by the current encoding
+    };
+
+    // Sequences to send when a modifier is pressed with any of these keys
+    // These sequences are not later updated to encode the modifier state in the
+    //      sequence itself, they are just weird exceptional cases to the general
+    //      rules above.
+    constexpr TermKeyMap s_rgSimpleModifedKeyMapping[]
+    {
+        { VK_BACK, L"\x8", CTRL_PRESSED },
+        { VK_BACK, L"\x1b\x7f", ALT_PRESSED },
+        { VK_BACK, L"\x1b\x8", CTRL_PRESSED | ALT_PRESSED },
+        { VK_TAB, L"\t", CTRL_PRESSED },
+        { VK_TAB, L"\x1b[Z", SHIFT_PRESSED },
+        { VK_DIVIDE, L"\x1F", CTRL_PRESSED },
+        // These two are not implemented here, because they are system keys.
+        // { VK_TAB, ALT_PRESSED, L""}, This is the Windows system shortcut for switching windows.
+        // { VK_ESCAPE, ALT_PRESSED, L""}, This is another Windows system shortcut for switching windows.
+    };
+
+    constexpr std::wstring_view CTRL_SLASH_SEQUENCE = L"\x1f";
+
+    // The tables above are written for people. HandleKey doesn't search them;
+    //      they are compiled into the tables below, which are indexed directly
+    //      by the virtual key (and the modifier state) and hold every sequence
+    //      fully rendered, length included.
+    constexpr size_t VkeyCount = 256;
+    constexpr size_t ModifierCombinations = 8; // every combination of shift, alt and ctrl
+    constexpr size_t MaxSequenceLength = 8;
+
+    struct KeySequence
+    {
+        wchar_t chars[MaxSequenceLength]{};
+        size_t length = 0;
 
-void TerminalInput::ChangeKeypadMode(const bool fApplicationMode)
-{
-    _fKeypadApplicationMode = fApplicationMode;
-}
+        constexpr std::wstring_view View() const noexcept
+        {
+            return { chars, length };
+        }
+    };
 
-void TerminalInput::ChangeCursorKeysMode(const bool fApplicationMode)
-{
-    _fCursorApplicationMode = fApplicationMode;
-}
+    using VkeyTable = std::array<std::wstring_view, VkeyCount>;
 
-const size_t TerminalInput::GetKeyMappingLength(const KeyEvent& keyEvent) const
-{
-    size_t length = 0;
-    if (keyEvent.IsCursorKey())
+    // Each key with modified forms owns a row of sequences, one per modifier
+    //      combination. Row 0 is left empty for keys without any.
+    template<size_t N>
+    struct ModifiedKeyTable
     {
-        length = (_fCursorApplicationMode) ? s_cCursorKeysApplicationMapping : s_cCursorKeysNormalMapping;
-    }
-    else
+        std::array<uint8_t, VkeyCount> rows{};
+        std::array<std::array<KeySequence, ModifierCombinations>, N + 1> sequences{};
+
+        constexpr std::wstring_view Lookup(const WORD vkey, const size_t modifiers) const noexcept
+        {
+            return vkey < VkeyCount ? sequences[rows[vkey]][modifiers].View() : std::wstring_view{};
+        }
+    };
+
+    constexpr size_t ModifierIndex(const bool shift, const bool alt, const bool ctrl) noexcept
     {
-        length = (_fKeypadApplicationMode) ? s_cKeypadApplicationMapping : s_cKeypadNumericMapping;
+        return (shift ? 1 : 0) + (alt ? 2 : 0) + (ctrl ? 4 : 0);
     }
-    return length;
-}
-
-const TerminalInput::_TermKeyMap* TerminalInput::GetKeyMapping(const KeyEvent& keyEvent) const
-{
-    const TerminalInput::_TermKeyMap* mapping = nullptr;
 
-    if (keyEvent.IsCursorKey())
+    constexpr size_t ModifierIndex(const DWORD modifiers) noexcept
     {
-        mapping = (_fCursorApplicationMode) ? s_rgCursorKeysApplicationMapping : s_rgCursorKeysNormalMapping;
+        return ModifierIndex(WI_IsFlagSet(modifiers, SHIFT_PRESSED),
+                             WI_IsAnyFlagSet(modifiers, ALT_PRESSED),
+                             WI_IsAnyFlagSet(modifiers, CTRL_PRESSED));
     }
-    else
+
+    // A sequence longer than MaxSequenceLength fails to compile here.
+    constexpr KeySequence RenderSequence(const std::wstring_view sequence) noexcept
     {
-        mapping = (_fKeypadApplicationMode) ? s_rgKeypadApplicationMapping : s_rgKeypadNumericMapping;
+        KeySequence rendered{};
+        for (size_t i = 0; i < sequence.size(); ++i)
+        {
+            rendered.chars[i] = sequence[i];
+        }
+        rendered.length = sequence.size();
+        return rendered;
     }
-    return mapping;
-}
 
-// Routine Description:
-// - Searches the s_ModifierKeyMapping for a entry corresponding to this key event.
-//      Changes the second to last byte to correspond to the currently pressed modifier keys
-//      before sending to the input.
-// Arguments:
-// - keyEvent - Key event to translate
-// Return Value:
-// - True if there was a match to a key translation, and we successfully modified and sent it to the input
-bool TerminalInput::_SearchWithModifier(const KeyEvent& keyEvent) const
-{
+    template<size_t N>
+    constexpr VkeyTable MakeVkeyTable(const TermKeyMap (&mappings)[N]) noexcept
+    {
+        VkeyTable table{};
+        for (const auto& mapping : mappings)
+        {
+            table[mapping.vkey] = mapping.sequence;
+        }
+        return table;
+    }
 
-    const TerminalInput::_TermKeyMap* pMatchingMapping;
-    bool fSuccess = _SearchKeyMapping(keyEvent,
-                                      s_rgModifierKeyMapping,
-                                      s_cModifierKeyMapping,
-                                      &pMatchingMapping);
-    if (fSuccess)
+    // Renders the 'm' of every sequence as the xterm modifier parameter
+    //      ('1' + 1 for shift, + 2 for alt, + 4 for ctrl) of each combination.
+    template<size_t N>
+    constexpr ModifiedKeyTable<N> MakeModifierKeyTable(const TermKeyMap (&mappings)[N]) noexcept
     {
-        size_t cch = 0;
-        if (SUCCEEDED(StringCchLengthW(pMatchingMapping->pwszSequence, _TermKeyMap::s_cchMaxSequenceLength + 1, &cch)) &&
-            cch > 0)
+        ModifiedKeyTable<N> table{};
+        for (size_t i = 0; i < N; ++i)
         {
-            wchar_t* rwchModifiedSequence = new(std::nothrow) wchar_t[cch + 1];
-            if (rwchModifiedSequence != nullptr)
+            table.rows[mappings[i].vkey] = static_cast<uint8_t>(i + 1);
+            for (size_t modifiers = 0; modifiers < ModifierCombinations; ++modifiers)
             {
-                memcpy(rwchModifiedSequence, pMatchingMapping->pwszSequence, cch * sizeof(wchar_t));
-                const bool fShift = keyEvent.IsShiftPressed();
-                const bool fAlt = keyEvent.IsAltPressed();
-                const bool fCtrl = keyEvent.IsCtrlPressed();
-                rwchModifiedSequence[cch - 2] = L'1' + (fShift ? 1 : 0) + (fAlt ? 2 : 0) + (fCtrl ? 4 : 0);
-                rwchModifiedSequence[cch] = 0;
-                _SendInputSequence(rwchModifiedSequence);
-                fSuccess = true;
-                delete [] rwchModifiedSequence;
+                auto& rendered = table.sequences[i + 1][modifiers];
+                rendered = RenderSequence(mappings[i].sequence);
+                rendered.chars[rendered.length - 2] = static_cast<wchar_t>(L'1' + modifiers);
             }
         }
+        return table;
     }
-    else
+
+    // Places every sequence at exactly the modifier combination it asks for.
+    template<size_t N>
+    constexpr ModifiedKeyTable<N> MakeSimpleModifiedKeyTable(const TermKeyMap (&mappings)[N]) noexcept
     {
-        // We didn't find the key in the map of modified keys that need editing,
-        //      maybe it's in the other map of modified keys with sequences that
-        //      don't need editing before sending.
-        fSuccess = _SearchKeyMapping(keyEvent,
-                                     s_rgSimpleModifedKeyMapping,
-                                     s_cSimpleModifedKeyMapping,
-                                     &pMatchingMapping);
-        if (fSuccess)
-        {
-            // This mapping doesn't need to be changed at all.
-            _SendInputSequence(pMatchingMapping->pwszSequence);
-            fSuccess = true;
-        }
-        else
+        ModifiedKeyTable<N> table{};
+        uint8_t rowsUsed = 0;
+        for (const auto& mapping : mappings)
         {
-            // One last check: C-/ is supposed to be C-_
-            // But '/' is not the same VKEY on all keyboards. So we have to
-            //      figure out the vkey at runtime.
-            const BYTE slashVkey = LOBYTE(VkKeyScan(L'/'));
-            if (keyEvent.GetVirtualKeyCode() == slashVkey && keyEvent.IsCtrlPressed())
+            auto& row = table.rows[mapping.vkey];
+            if (row == 0)
             {
-                // This mapping doesn't need to be changed at all.
-                _SendInputSequence(CTRL_SLASH_SEQUENCE);
-                fSuccess = true;
-
+                row = ++rowsUsed;
             }
+            table.sequences[row][ModifierIndex(mapping.modifiers)] = RenderSequence(mapping.sequence);
         }
+        return table;
+    }
+
+    constexpr VkeyTable s_cursorKeysNormalTable = MakeVkeyTable(s_rgCursorKeysNormalMapping);
+    constexpr VkeyTable s_cursorKeysApplicationTable = MakeVkeyTable(s_rgCursorKeysApplicationMapping);
+    constexpr VkeyTable s_keypadNumericTable = MakeVkeyTable(s_rgKeypadNumericMapping);
+    constexpr VkeyTable s_keypadApplicationTable = MakeVkeyTable(s_rgKeypadApplicationMapping);
+    constexpr auto s_modifierKeyTable = MakeModifierKeyTable(s_rgModifierKeyMapping);
+    constexpr auto s_simpleModifiedKeyTable = MakeSimpleModifiedKeyTable(s_rgSimpleModifedKeyMapping);
+
+    size_t ModifierIndex(const KeyEvent& keyEvent) noexcept
+    {
+        return ModifierIndex(keyEvent.IsShiftPressed(), keyEvent.IsAltPressed(), keyEvent.IsCtrlPressed());
     }
+}
+
+void TerminalInput::ChangeKeypadMode(const bool fApplicationMode)
+{
+    _fKeypadApplicationMode = fApplicationMode;
+}
 
-    return fSuccess;
+void TerminalInput::ChangeCursorKeysMode(const bool fApplicationMode)
+{
+    _fCursorApplicationMode = fApplicationMode;
+}
+
+void TerminalInput::ChangeBracketedPasteMode(const bool fEnabled)
+{
+    _fBracketedPasteMode = fEnabled;
 }
 
 // Routine Description:
-// - Searches the keyMapping for a entry corresponding to this key event, and returns it.
+// - Looks up the sequence for this key with its modifiers encoded in it, or
+//      failing that one of the exceptional sequences for a particular modifier
+//      combination, and sends it to the input.
 // Arguments:
 // - keyEvent - Key event to translate
-// - keyMapping - Array of key mappings to search
-// - cKeyMapping - number of entries in keyMapping
-// - pMatchingMapping - Where to put the pointer to the found match
 // Return Value:
-// - True if there was a match to a key translation
-bool TerminalInput::_SearchKeyMapping(const KeyEvent& keyEvent,
-                                      _In_reads_(cKeyMapping) const TerminalInput::_TermKeyMap* keyMapping,
-                                      const size_t cKeyMapping,
-                                      _Out_ const TerminalInput::_TermKeyMap** pMatchingMapping) const
+// - True if there was a match to a key translation, and we sent it to the input
+bool TerminalInput::_SearchWithModifier(const KeyEvent& keyEvent) const
 {
-    bool fKeyTranslated = false;
-    for (size_t i = 0; i < cKeyMapping; i++)
+    const auto vkey = keyEvent.GetVirtualKeyCode();
+    const auto modifiers = ModifierIndex(keyEvent);
+
+    auto sequence = s_modifierKeyTable.Lookup(vkey, modifiers);
+    if (sequence.empty())
     {
-        const _TermKeyMap* const pMap = &(keyMapping[i]);
+        // We didn't find the key in the map of modified keys that need editing,
+        //      maybe it's in the other map of modified keys with sequences that
+        //      don't need editing before sending.
+        sequence = s_simpleModifiedKeyTable.Lookup(vkey, modifiers);
+    }
 
-        if (pMap->wVirtualKey == keyEvent.GetVirtualKeyCode())
+    if (sequence.empty())
+    {
+        // One last check: C-/ is supposed to be C-_
+        // But '/' is not the same VKEY on all keyboards. So we have to
+        //      figure out the vkey at runtime.
+        const BYTE slashVkey = LOBYTE(VkKeyScan(L'/'));
+        if (vkey == slashVkey && keyEvent.IsCtrlPressed())
         {
-            // If the mapping has no modifiers set, then it doesn't really care
-            //      what the modifiers are on the key. The caller will likely do
-            //      something with them.
-            // However, if there are modifiers set, then we only want to match
-            //      if the key's modifiers are the same as the modifiers in the
-            //      mapping.
-            bool modifiersMatch = WI_AreAllFlagsClear(pMap->dwModifiers, MOD_PRESSED);
-            if (!modifiersMatch)
-            {
-                // The modifier mapping expects certain modifier keys to be
-                //      pressed. Check those as well.
-                modifiersMatch =
-                    (WI_IsFlagSet(pMap->dwModifiers, SHIFT_PRESSED) == keyEvent.IsShiftPressed()) &&
-                    (WI_IsAnyFlagSet(pMap->dwModifiers, ALT_PRESSED) == keyEvent.IsAltPressed()) &&
-                    (WI_IsAnyFlagSet(pMap->dwModifiers, CTRL_PRESSED) == keyEvent.IsCtrlPressed());
-            }
-
-            if (modifiersMatch)
-            {
-                fKeyTranslated = true;
-                *pMatchingMapping = pMap;
-                break;
-            }
+            sequence = CTRL_SLASH_SEQUENCE;
         }
     }
-    return fKeyTranslated;
+
+    if (sequence.empty())
+    {
+        return false;
+    }
+
+    _SendInputSequence(sequence);
+    return true;
 }
 
 // Routine Description:
-// - Searches the input array of mappings, and sends it to the input if a match was found.
+// - Looks up the unmodified sequence for this key in the table for the current
+//      cursor keys or keypad mode, and sends it to the input if there is one.
 // Arguments:
 // - keyEvent - Key event to translate
-// - keyMapping - Array of key mappings to search
-// - cKeyMapping - number of entries in keyMapping
 // Return Value:
-// - True if there was a match to a key translation, and we successfully sent it to the input
-bool TerminalInput::_TranslateDefaultMapping(const KeyEvent& keyEvent,
-                                             _In_reads_(cKeyMapping) const TerminalInput::_TermKeyMap* keyMapping,
-                                             const size_t cKeyMapping) const
+// - True if there was a match to a key translation, and we sent it to the input
+bool TerminalInput::_TranslateDefaultMapping(const KeyEvent& keyEvent) const
 {
-    const TerminalInput::_TermKeyMap* pMatchingMapping;
-    bool fSuccess = _SearchKeyMapping(keyEvent, keyMapping, cKeyMapping, &pMatchingMapping);
-    if (fSuccess)
+    const auto vkey = keyEvent.GetVirtualKeyCode();
+    if (vkey >= VkeyCount)
+    {
+        return false;
+    }
+
+    const VkeyTable& table = keyEvent.IsCursorKey() ?
+        (_fCursorApplicationMode ? s_cursorKeysApplicationTable : s_cursorKeysNormalTable) :
+        (_fKeypadApplicationMode ? s_keypadApplicationTable : s_keypadNumericTable);
+
+    const auto sequence = table[vkey];
+    if (sequence.empty())
     {
-        _SendInputSequence(pMatchingMapping->pwszSequence);
-        fSuccess = true;
+        return false;
     }
-    return fSuccess;
+
+    _SendInputSequence(sequence);
+    return true;
 }
 
 bool TerminalInput::HandleKey(const IInputEvent* const pInEvent) const
@@ -466,20 +498,19 @@ bool TerminalInput::HandleKey(const IInputEvent* const pInEvent) const
 
             if (!fKeyHandled)
             {
-                // For perf optimization, filter out any typically printable Virtual Keys (e.g. A-Z)
-                // This is in lieu of an O(1) sparse table or other such less-maintanable methods.
+                // Typically printable Virtual Keys (e.g. A-Z) never have a mapping,
+                // so they go straight through with their character.
                 // VK_CANCEL is an exception and we want to send the associated uChar as is.
                 if ((keyEvent.GetVirtualKeyCode() < '0' || keyEvent.GetVirtualKeyCode() > 'Z') &&
                     keyEvent.GetVirtualKeyCode() != VK_CANCEL)
                 {
-                    fKeyHandled = _TranslateDefaultMapping(keyEvent, GetKeyMapping(keyEvent), GetKeyMappingLength(keyEvent));
+                    fKeyHandled = _TranslateDefaultMapping(keyEvent);
                 }
                 else
                 {
-                    WCHAR rgwchSequence[2];
-                    rgwchSequence[0] = keyEvent.GetCharData();
-                    rgwchSequence[1] = UNICODE_NULL;
-                    _SendInputSequence(rgwchSequence);
+                    // A NUL character is swallowed, same as an empty sequence.
+                    const wchar_t wch = keyEvent.GetCharData();
+                    _SendInputSequence({ &wch, wch == UNICODE_NULL ? 0u : 1u });
                     fKeyHandled = true;
                 }
             }
@@ -530,18 +561,76 @@ void TerminalInput::_SendNullInputSequence(const DWORD dwControlKeyState) const
     }
 }
 
-void TerminalInput::_SendInputSequence(_In_ PCWSTR const pwszSequence) const
+// Routine Description:
+// - Sends pasted text to the client in one piece. If the client asked for
+//   bracketed paste mode (DECSET 2004) the text is surrounded with the
+//   ESC[200~ and ESC[201~ markers so it can tell typing and pasting apart.
+// Arguments:
+// - text - the text to paste
+// Return Value:
+// - true if any input was sent.
+bool TerminalInput::HandlePaste(const std::wstring_view text) const
+{
+    if (text.empty())
+    {
+        return false;
+    }
+
+    if (_fBracketedPasteMode)
+    {
+        _SendText(L"\x1b[200~");
+        _SendText(text);
+        _SendText(L"\x1b[201~");
+    }
+    else
+    {
+        _SendText(text);
+    }
+    return true;
+}
+
+// Routine Description:
+// - Writes text through the text callback if we have one. Otherwise it falls
+//   back to one key down event per character, like _SendInputSequence.
+// Arguments:
+// - text - the characters to send.
+// Return Value:
+// - <none>
+void TerminalInput::_SendText(const std::wstring_view text) const
+{
+    try
+    {
+        if (_pfnWriteText)
+        {
+            _pfnWriteText(text);
+        }
+        else
+        {
+            _SendInputSequence(text);
+        }
+    }
+    catch (...)
+    {
+        LOG_HR(wil::ResultFromCaughtException());
+    }
+}
+
+// Routine Description:
+// - Sends each character of the sequence to the input as a key down event.
+// Arguments:
+// - sequence - the characters to send. Nothing is sent if it's empty.
+// Return Value:
+// - <none>
+void TerminalInput::_SendInputSequence(const std::wstring_view sequence) const
 {
-    size_t cch = 0;
-    // + 1 to max sequence length for null terminator count which is required by StringCchLengthW
-    if (SUCCEEDED(StringCchLengthW(pwszSequence, _TermKeyMap::s_cchMaxSequenceLength + 1, &cch)) && cch > 0)
+    if (!sequence.empty())
     {
         try
         {
             std::deque<std::unique_ptr<IInputEvent>> inputEvents;
-            for (size_t i = 0; i < cch; i++)
+            for (const auto wch : sequence)
             {
-                inputEvents.push_back(std::make_unique<KeyEvent>(true, 1ui16, 0ui16, 0ui16, pwszSequence[i], 0));
+                inputEvents.push_back(std::make_unique<KeyEvent>(true, 1ui16, 0ui16, 0ui16, wch, 0));
             }
             _pfnWriteEvents(inputEvents);
         }
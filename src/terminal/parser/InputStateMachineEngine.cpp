@@ -38,7 +38,29 @@ const size_t WRAPPED_SEQUENCE_MAX_LENGTH = 8;
 // CAPSLOCK_ON         0x0080
 // ENHANCED_KEY        0x0100
 
-const InputStateMachineEngine::CSI_TO_VKEY InputStateMachineEngine::s_rgCsiMap[]
+namespace
+{
+    struct KEY_TO_VKEY
+    {
+        unsigned short key;
+        short vkey;
+    };
+
+    // The initializers below are all constant expressions, so the tables are
+    //      filled in by the compiler rather than at startup.
+    template<size_t Size>
+    constexpr std::array<short, Size> MakeVkeyTable(const std::initializer_list<KEY_TO_VKEY> mappings) noexcept
+    {
+        std::array<short, Size> table{};
+        for (const auto& mapping : mappings)
+        {
+            table[mapping.key] = mapping.vkey;
+        }
+        return table;
+    }
+}
+
+const std::array<short, InputStateMachineEngine::s_cFinalCharVkeys> InputStateMachineEngine::s_rgCsiVkeys = MakeVkeyTable<s_cFinalCharVkeys>(
 {
     { CsiActionCodes::ArrowUp, VK_UP },
     { CsiActionCodes::ArrowDown, VK_DOWN },
@@ -50,9 +72,9 @@ const InputStateMachineEngine::CSI_TO_VKEY InputStateMachineEngine::s_rgCsiMap[]
     { CsiActionCodes::CSI_F2, VK_F2 },
     { CsiActionCodes::CSI_F3, VK_F3 },
     { CsiActionCodes::CSI_F4, VK_F4 },
-};
+});
 
-const InputStateMachineEngine::GENERIC_TO_VKEY InputStateMachineEngine::s_rgGenericMap[]
+const std::array<short, InputStateMachineEngine::s_cGenericVkeys> InputStateMachineEngine::s_rgGenericVkeys = MakeVkeyTable<s_cGenericVkeys>(
 {
     { GenericKeyIdentifiers::GenericHome, VK_HOME },
     { GenericKeyIdentifiers::Insert, VK_INSERT },
@@ -68,15 +90,15 @@ const InputStateMachineEngine::GENERIC_TO_VKEY InputStateMachineEngine::s_rgGene
     { GenericKeyIdentifiers::F10, VK_F10 },
     { GenericKeyIdentifiers::F11, VK_F11 },
     { GenericKeyIdentifiers::F12, VK_F12 },
-};
+});
 
-const InputStateMachineEngine::SS3_TO_VKEY InputStateMachineEngine::s_rgSs3Map[]
+const std::array<short, InputStateMachineEngine::s_cFinalCharVkeys> InputStateMachineEngine::s_rgSs3Vkeys = MakeVkeyTable<s_cFinalCharVkeys>(
 {
     { Ss3ActionCodes::SS3_F1, VK_F1 },
     { Ss3ActionCodes::SS3_F2, VK_F2 },
     { Ss3ActionCodes::SS3_F3, VK_F3 },
     { Ss3ActionCodes::SS3_F4, VK_F4 },
-};
+});
 
 InputStateMachineEngine::InputStateMachineEngine(IInteractDispatch* const pDispatch) :
     InputStateMachineEngine(pDispatch, false)
@@ -84,8 +106,70 @@ InputStateMachineEngine::InputStateMachineEngine(IInteractDispatch* const pDispa
 
 InputStateMachineEngine::InputStateMachineEngine(IInteractDispatch* const pDispatch, const bool lookingForDSR) :
     _pDispatch(THROW_IF_NULL_ALLOC(pDispatch)),
-    _lookingForDSR(lookingForDSR)
+    _lookingForDSR(lookingForDSR),
+    _batchInput(false)
+{
+}
+
+// Method Description:
+// - Enables or disables input batching. While batching, the keypresses
+//      generated from the sequences we parse are accumulated instead of being
+//      written to the dispatch one at a time. They're written all at once
+//      by FlushBatchedInput, so a large paste wakes up any waiting readers
+//      once instead of once per character.
+//   Actions that aren't keypresses (Ctrl+C, cursor position reports,
+//      window manipulation) flush the batch first, so ordering is preserved.
+// Arguments:
+// - batchInput - true to accumulate input until FlushBatchedInput is called.
+// Return Value:
+// - <none>
+void InputStateMachineEngine::SetBatchInput(const bool batchInput)
+{
+    if (!batchInput)
+    {
+        LOG_HR_IF(E_FAIL, !FlushBatchedInput());
+    }
+    _batchInput = batchInput;
+}
+
+// Method Description:
+// - Writes all of the input accumulated while batching to the dispatch in a
+//      single call.
+// Arguments:
+// - <none>
+// Return Value:
+// - true iff we successfully wrote the input (or there was nothing to write).
+bool InputStateMachineEngine::FlushBatchedInput()
+{
+    if (_batchedEvents.empty())
+    {
+        return true;
+    }
+
+    const bool fSuccess = _pDispatch->WriteInput(_batchedEvents);
+    _batchedEvents.clear();
+    return fSuccess;
+}
+
+// Method Description:
+// - Either writes the input to the dispatch, or holds onto it until the next
+//      FlushBatchedInput if we're batching.
+// Arguments:
+// - inputEvents - the events to write. Emptied if they're added to the batch.
+// Return Value:
+// - true iff we successfully handled the input.
+bool InputStateMachineEngine::_WriteInput(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inputEvents)
 {
+    if (!_batchInput)
+    {
+        return _pDispatch->WriteInput(inputEvents);
+    }
+
+    std::move(inputEvents.begin(),
+              inputEvents.end(),
+              std::back_inserter(_batchedEvents));
+    inputEvents.clear();
+    return true;
 }
 
 // Method Description:
@@ -106,7 +190,7 @@ bool InputStateMachineEngine::_DoControlCharacter(const wchar_t wch, const bool
     if (wch == UNICODE_ETX && !writeAlt)
     {
         // This is Ctrl+C, which is handled specially by the host.
-        fSuccess = _pDispatch->WriteCtrlC();
+        fSuccess = FlushBatchedInput() && _pDispatch->WriteCtrlC();
     }
     else if (wch >= '\x0' && wch < '\x20')
     {
@@ -227,6 +311,10 @@ bool InputStateMachineEngine::ActionPrintString(const wchar_t* const rgwch,
     {
         return true;
     }
+    if (_batchInput)
+    {
+        return _pDispatch->ConvertString(rgwch, cch, _batchedEvents);
+    }
     return _pDispatch->WriteString(rgwch, cch);
 }
 
@@ -367,7 +455,7 @@ bool InputStateMachineEngine::ActionCsiDispatch(const wchar_t wch,
             // Else, fall though to the _GetCursorKeysModifierState handler.
                 if (_lookingForDSR)
                 {
-                    fSuccess = _pDispatch->MoveCursor(row, col);
+                    fSuccess = FlushBatchedInput() && _pDispatch->MoveCursor(row, col);
                     // Right now we're only looking for on initial cursor
                     //      position response. After that, only look for F3.
                     _lookingForDSR = false;
@@ -388,7 +476,8 @@ bool InputStateMachineEngine::ActionCsiDispatch(const wchar_t wch,
                 fSuccess = _WriteSingleKey(vkey, dwModifierState);
                 break;
             case CsiActionCodes::DTTERM_WindowManipulation:
-                fSuccess = _pDispatch->WindowManipulation(static_cast<DispatchTypes::WindowManipulationType>(uiFunction),
+                fSuccess = FlushBatchedInput() &&
+                           _pDispatch->WindowManipulation(static_cast<DispatchTypes::WindowManipulationType>(uiFunction),
                                                           rgusRemainingArgs,
                                                           cRemainingArgs);
                 break;
@@ -664,7 +753,7 @@ bool InputStateMachineEngine::_WriteSingleKey(const wchar_t wch, const short vke
 
     std::deque<std::unique_ptr<IInputEvent>> inputEvents = IInputEvent::Create(gsl::make_span(rgInput, cInput));
 
-    return _pDispatch->WriteInput(inputEvents);
+    return _WriteInput(inputEvents);
 }
 
 // Method Description:
@@ -764,16 +853,11 @@ bool InputStateMachineEngine::_GetGenericVkey(_In_reads_(cParams) const unsigned
     }
 
     const unsigned short identifier = rgusParams[0];
-    for(int i = 0; i < ARRAYSIZE(s_rgGenericMap); i++)
+    if (identifier < s_rgGenericVkeys.size())
     {
-        GENERIC_TO_VKEY mapping = s_rgGenericMap[i];
-        if (mapping.Identifier == identifier)
-        {
-            *pVkey = mapping.vkey;
-            return true;
-        }
+        *pVkey = s_rgGenericVkeys[identifier];
     }
-    return false;
+    return *pVkey != 0;
 }
 
 // Method Description:
@@ -786,17 +870,11 @@ bool InputStateMachineEngine::_GetGenericVkey(_In_reads_(cParams) const unsigned
 bool InputStateMachineEngine::_GetCursorKeysVkey(const wchar_t wch, _Out_ short* const pVkey) const
 {
     *pVkey = 0;
-    for(int i = 0; i < ARRAYSIZE(s_rgCsiMap); i++)
+    if (wch < s_rgCsiVkeys.size())
     {
-        CSI_TO_VKEY mapping = s_rgCsiMap[i];
-        if (mapping.Action == wch)
-        {
-            *pVkey = mapping.vkey;
-            return true;
-        }
+        *pVkey = s_rgCsiVkeys[wch];
     }
-
-    return false;
+    return *pVkey != 0;
 }
 
 // Method Description:
@@ -809,17 +887,11 @@ bool InputStateMachineEngine::_GetCursorKeysVkey(const wchar_t wch, _Out_ short*
 bool InputStateMachineEngine::_GetSs3KeysVkey(const wchar_t wch, _Out_ short* const pVkey) const
 {
     *pVkey = 0;
-    for(int i = 0; i < ARRAYSIZE(s_rgSs3Map); i++)
+    if (wch < s_rgSs3Vkeys.size())
     {
-        SS3_TO_VKEY mapping = s_rgSs3Map[i];
-        if (mapping.Action == wch)
-        {
-            *pVkey = mapping.vkey;
-            return true;
-        }
+        *pVkey = s_rgSs3Vkeys[wch];
     }
-
-    return false;
+    return *pVkey != 0;
 }
 
 // Method Description:
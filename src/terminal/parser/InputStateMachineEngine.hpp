@@ -17,6 +17,7 @@ Author(s):
 
 #include "telemetry.hpp"
 #include "IStateMachineEngine.hpp"
+#include <array>
 #include <functional>
 #include "../../types/inc/IInputEvent.hpp"
 #include "../adapter/IInteractDispatch.hpp"
@@ -67,11 +68,19 @@ namespace Microsoft::Console::VirtualTerminal
         bool FlushAtEndOfString() const override;
         bool DispatchControlCharsFromEscape() const override;
 
+        void SetBatchInput(const bool batchInput);
+        bool FlushBatchedInput();
+
     private:
 
         const std::unique_ptr<IInteractDispatch> _pDispatch;
         bool _lookingForDSR;
 
+        bool _batchInput;
+        std::deque<std::unique_ptr<IInputEvent>> _batchedEvents;
+
+        bool _WriteInput(_Inout_ std::deque<std::unique_ptr<IInputEvent>>& inputEvents);
+
         enum CsiActionCodes : wchar_t
         {
             ArrowUp = L'A',
@@ -125,24 +134,14 @@ namespace Microsoft::Console::VirtualTerminal
             F12 = 24,
         };
 
-        struct CSI_TO_VKEY {
-            CsiActionCodes Action;
-            short vkey;
-        };
-
-        struct GENERIC_TO_VKEY {
-            GenericKeyIdentifiers Identifier;
-            short vkey;
-        };
-
-        struct SS3_TO_VKEY {
-            Ss3ActionCodes Action;
-            short vkey;
-        };
+        // These are indexed directly by the final character or identifier of a
+        //      sequence. An entry of 0 means that it isn't a key we know.
+        static constexpr size_t s_cFinalCharVkeys = 0x80;
+        static constexpr size_t s_cGenericVkeys = GenericKeyIdentifiers::F12 + 1;
 
-        static const CSI_TO_VKEY s_rgCsiMap[];
-        static const GENERIC_TO_VKEY s_rgGenericMap[];
-        static const SS3_TO_VKEY s_rgSs3Map[];
+        static const std::array<short, s_cFinalCharVkeys> s_rgCsiVkeys;
+        static const std::array<short, s_cGenericVkeys> s_rgGenericVkeys;
+        static const std::array<short, s_cFinalCharVkeys> s_rgSs3Vkeys;
 
 
         DWORD _GetCursorKeysModifierState(_In_reads_(cParams) const unsigned short* const rgusParams,
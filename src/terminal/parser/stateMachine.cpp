@@ -8,12 +8,14 @@
 #include "ascii.hpp"
 
 using namespace Microsoft::Console::VirtualTerminal;
+using namespace Microsoft::Console::Types;
 
 //Takes ownership of the pEngine.
 StateMachine::StateMachine(IStateMachineEngine* const pEngine) :
     _pEngine(THROW_IF_NULL_ALLOC(pEngine)),
     _state(VTStates::Ground),
     _trace(Microsoft::Console::VirtualTerminal::ParserTracing()),
+    _metrics(),
     _cParams(0),
     _pusActiveParam(nullptr),
     _cIntermediate(0),
@@ -298,6 +300,7 @@ bool StateMachine::s_IsNumber(const wchar_t wch)
 void StateMachine::_ActionExecute(const wchar_t wch)
 {
     _trace.TraceOnExecute(wch);
+    _metrics.Add(Metrics::Counter::ControlsExecuted);
     _pEngine->ActionExecute(wch);
 
 }
@@ -313,6 +316,7 @@ void StateMachine::_ActionExecute(const wchar_t wch)
 void StateMachine::_ActionExecuteFromEscape(const wchar_t wch)
 {
     _trace.TraceOnExecuteFromEscape(wch);
+    _metrics.Add(Metrics::Counter::ControlsExecuted);
     _pEngine->ActionExecuteFromEscape(wch);
 
 }
@@ -326,6 +330,7 @@ void StateMachine::_ActionExecuteFromEscape(const wchar_t wch)
 void StateMachine::_ActionPrint(const wchar_t wch)
 {
     _trace.TraceOnAction(L"Print");
+    _metrics.Add(Metrics::Counter::PrintRuns);
     _pEngine->ActionPrint(wch);
 }
 
@@ -340,6 +345,7 @@ void StateMachine::_ActionPrint(const wchar_t wch)
 void StateMachine::_ActionEscDispatch(const wchar_t wch)
 {
     _trace.TraceOnAction(L"EscDispatch");
+    _metrics.Add(Metrics::Counter::EscDispatched);
 
     bool fSuccess = _pEngine->ActionEscDispatch(wch, _cIntermediate, _wchIntermediate);
 
@@ -363,6 +369,7 @@ void StateMachine::_ActionEscDispatch(const wchar_t wch)
 void StateMachine::_ActionCsiDispatch(const wchar_t wch)
 {
     _trace.TraceOnAction(L"CsiDispatch");
+    _metrics.Add(Metrics::Counter::CsiDispatched);
 
     bool fSuccess = _pEngine->ActionCsiDispatch(wch, _cIntermediate, _wchIntermediate, _rgusParams, _cParams);
 
@@ -577,6 +584,7 @@ void StateMachine::_ActionOscPut(const wchar_t wch)
 void StateMachine::_ActionOscDispatch(const wchar_t wch)
 {
     _trace.TraceOnAction(L"OscDispatch");
+    _metrics.Add(Metrics::Counter::OscDispatched);
 
     bool fSuccess = _pEngine->ActionOscDispatch(wch, _sOscParam, _pwchOscStringBuffer, _sOscNextChar);
 
@@ -600,6 +608,7 @@ void StateMachine::_ActionOscDispatch(const wchar_t wch)
 void StateMachine::_ActionSs3Dispatch(const wchar_t wch)
 {
     _trace.TraceOnAction(L"Ss3Dispatch");
+    _metrics.Add(Metrics::Counter::Ss3Dispatched);
 
     bool fSuccess = _pEngine->ActionSs3Dispatch(wch, _rgusParams, _cParams);
 
@@ -1334,6 +1343,11 @@ void StateMachine::ProcessString(const wchar_t* const rgwch, const size_t cch)
     _pwchSequenceStart = rgwch;
     _currRunLength = 0;
 
+    // Counting goes to the batch while the string is parsed, and is recorded
+    // once it's done, however this returns.
+    _metrics.Add(Metrics::Counter::CharactersParsed, cch);
+    auto publish = wil::scope_exit([&]() noexcept { _metrics.Publish(); });
+
     // This should be static, because if one string starts a sequence, and the next finishes it,
     //   we want the partial sequence state to persist.
     static bool s_fProcessIndividually = false;
@@ -1358,6 +1372,7 @@ void StateMachine::ProcessString(const wchar_t* const rgwch, const size_t cch)
             {
                 FAIL_FAST_IF(!(_pwchSequenceStart + _currRunLength <= rgwch + cch));
                 _pEngine->ActionPrintString(_pwchSequenceStart, _currRunLength); // ... print all the chars leading up to it as part of the run...
+                _metrics.Add(Metrics::Counter::PrintRuns, _currRunLength > 0 ? 1 : 0);
                 _trace.DispatchPrintRunTrace(_pwchSequenceStart, _currRunLength);
                 s_fProcessIndividually = true; // begin processing future characters individually...
                 _currRunLength = 0;
@@ -1383,6 +1398,7 @@ void StateMachine::ProcessString(const wchar_t* const rgwch, const size_t cch)
     {
         // print the rest of the characters in the string
         _pEngine->ActionPrintString(_pwchSequenceStart, _currRunLength);
+        _metrics.Add(Metrics::Counter::PrintRuns);
         _trace.DispatchPrintRunTrace(_pwchSequenceStart, _currRunLength);
 
     }
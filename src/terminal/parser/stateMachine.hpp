@@ -17,6 +17,7 @@ Abstract:
 #include "IStateMachineEngine.hpp"
 #include "telemetry.hpp"
 #include "tracing.hpp"
+#include "../../types/inc/Metrics.hpp"
 #include <memory>
 
 namespace Microsoft::Console::VirtualTerminal
@@ -128,6 +129,9 @@ namespace Microsoft::Console::VirtualTerminal
 
         Microsoft::Console::VirtualTerminal::ParserTracing _trace;
 
+        // what was parsed and dispatched since the end of the last ProcessString
+        Microsoft::Console::Types::Metrics::CounterBatch _metrics;
+
         std::unique_ptr<IStateMachineEngine> _pEngine;
 
         VTStates _state;
@@ -111,6 +111,13 @@ void ParserTracing::ClearSequenceTrace()
 // NOTE: I'm expecting this to not be null terminated
 void ParserTracing::DispatchPrintRunTrace(const wchar_t* const pwsString, const size_t cchString) const
 {
+    // This is called for every run the parser prints. Don't copy the run into
+    // events nobody is listening for.
+    if (!TraceLoggingProviderEnabled(g_hConsoleVirtTermParserEventTraceProvider, WINEVENT_LEVEL_VERBOSE, 0))
+    {
+        return;
+    }
+
     size_t charsRemaining = cchString;
     wchar_t str[BYTE_MAX + 4 + sizeof(wchar_t) + sizeof('\0')];
 
@@ -16,6 +16,7 @@
 #include <sstream>
 #include <string>
 #include <algorithm>
+#include <chrono>
 
 #ifdef BUILD_ONECORE_INTERACTIVITY
 #include "../../../interactivity/inc/VtApiRedirection.hpp"
@@ -239,6 +240,9 @@ class Microsoft::Console::VirtualTerminal::InputEngineTest
     TEST_METHOD(CSICursorBackTabTest);
     TEST_METHOD(AltBackspaceTest);
     TEST_METHOD(AltCtrlDTest);
+    TEST_METHOD(BatchedInputTest);
+    TEST_METHOD(BatchedPasteThroughput);
+    TEST_METHOD(KeyTranslationThroughput);
 
     friend class TestInteractDispatch;
 };
@@ -256,6 +260,9 @@ public:
                                     const size_t cParams) override; // DTTERM_WindowManipulation
     virtual bool WriteString(_In_reads_(cch) const wchar_t* const pws,
                              const size_t cch) override;
+    virtual bool ConvertString(_In_reads_(cch) const wchar_t* const pws,
+                               const size_t cch,
+                               _Inout_ std::deque<std::unique_ptr<IInputEvent>>& inputEvents) override;
 
     virtual bool MoveCursor(const unsigned int row,
                             const unsigned int col) override;
@@ -306,7 +313,14 @@ bool TestInteractDispatch::WriteString(_In_reads_(cch) const wchar_t* const pws,
                                        const size_t cch)
 {
     std::deque<std::unique_ptr<IInputEvent>> keyEvents;
+    ConvertString(pws, cch, keyEvents);
+    return WriteInput(keyEvents);
+}
 
+bool TestInteractDispatch::ConvertString(_In_reads_(cch) const wchar_t* const pws,
+                                         const size_t cch,
+                                         _Inout_ std::deque<std::unique_ptr<IInputEvent>>& inputEvents)
+{
     for (size_t i = 0; i < cch; ++i)
     {
         const wchar_t wch = pws[i];
@@ -315,10 +329,9 @@ bool TestInteractDispatch::WriteString(_In_reads_(cch) const wchar_t* const pws,
         std::deque<std::unique_ptr<KeyEvent>> convertedEvents = CharToKeyEvents(wch, CP_USA);
         std::move(convertedEvents.begin(),
                   convertedEvents.end(),
-                  std::back_inserter(keyEvents));
+                  std::back_inserter(inputEvents));
     }
-
-    return WriteInput(keyEvents);
+    return true;
 }
 
 bool TestInteractDispatch::MoveCursor(const unsigned int row,
@@ -788,3 +801,173 @@ void InputEngineTest::AltCtrlDTest()
     Log::Comment(NoThrowString().Format(L"Processing \"\\x1b\\x04\""));
     _stateMachine->ProcessString(seq);
 }
+
+void InputEngineTest::BatchedInputTest()
+{
+    TestState testState;
+    size_t writes = 0;
+    std::wstring received;
+    auto pfn = [&](std::deque<std::unique_ptr<IInputEvent>>& inEvents) {
+        ++writes;
+        for (const auto& inRec : IInputEvent::ToInputRecords(inEvents))
+        {
+            if (inRec.EventType == KEY_EVENT &&
+                inRec.Event.KeyEvent.bKeyDown &&
+                inRec.Event.KeyEvent.uChar.UnicodeChar != 0)
+            {
+                received.push_back(inRec.Event.KeyEvent.uChar.UnicodeChar);
+            }
+        }
+    };
+
+    auto inputEngine = std::make_unique<InputStateMachineEngine>(new TestInteractDispatch(pfn, &testState));
+    auto engine = inputEngine.get();
+    engine->SetBatchInput(true);
+    auto _stateMachine = std::make_unique<StateMachine>(inputEngine.release());
+    VERIFY_IS_NOT_NULL(_stateMachine);
+    testState._stateMachine = _stateMachine.get();
+
+    Log::Comment(L"Text, control characters and key sequences should all be held until the flush.");
+    const std::wstring seq = L"abc\rdef\x1b[Aghi\t";
+    _stateMachine->ProcessString(seq);
+    VERIFY_ARE_EQUAL(0u, writes);
+
+    VERIFY_IS_TRUE(engine->FlushBatchedInput());
+    VERIFY_ARE_EQUAL(1u, writes);
+    // The up arrow doesn't have a character.
+    VERIFY_ARE_EQUAL(std::wstring(L"abc\rdefghi\t"), received);
+
+    Log::Comment(L"Flushing an empty batch shouldn't write anything.");
+    VERIFY_IS_TRUE(engine->FlushBatchedInput());
+    VERIFY_ARE_EQUAL(1u, writes);
+
+    Log::Comment(L"Ctrl+C must not jump ahead of the input that preceded it.");
+    received.clear();
+    testState._expectSendCtrlC = true;
+    _stateMachine->ProcessString(std::wstring(L"xy\x03"));
+    VERIFY_ARE_EQUAL(3u, writes);
+    VERIFY_ARE_EQUAL(std::wstring(L"xy\x03"), received);
+
+    Log::Comment(L"Turning batching off should flush anything pending.");
+    testState._expectSendCtrlC = false;
+    received.clear();
+    _stateMachine->ProcessString(std::wstring(L"z"));
+    engine->SetBatchInput(false);
+    VERIFY_ARE_EQUAL(4u, writes);
+    VERIFY_ARE_EQUAL(std::wstring(L"z"), received);
+}
+
+void InputEngineTest::BatchedPasteThroughput()
+{
+    BEGIN_TEST_METHOD_PROPERTIES()
+        TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+    END_TEST_METHOD_PROPERTIES()
+
+    // 10MB of pasted text, arriving the way VtInputThread reads it.
+    const size_t cchPaste = 10 * 1024 * 1024;
+    const size_t cchRead = 16 * 1024;
+    std::wstring paste;
+    paste.reserve(cchPaste);
+    while (paste.size() < cchPaste)
+    {
+        paste.append(L"The quick brown fox jumps over the lazy dog 0123456789\r");
+    }
+    paste.resize(cchPaste);
+
+    for (const bool batch : { false, true })
+    {
+        TestState testState;
+        size_t writes = 0;
+        size_t events = 0;
+        auto pfn = [&](std::deque<std::unique_ptr<IInputEvent>>& inEvents) {
+            ++writes;
+            events += inEvents.size();
+        };
+
+        auto inputEngine = std::make_unique<InputStateMachineEngine>(new TestInteractDispatch(pfn, &testState));
+        auto engine = inputEngine.get();
+        engine->SetBatchInput(batch);
+        auto stateMachine = std::make_unique<StateMachine>(inputEngine.release());
+
+        const auto now = std::chrono::steady_clock::now();
+
+        for (size_t pos = 0; pos < paste.size(); pos += cchRead)
+        {
+            stateMachine->ProcessString(paste.data() + pos, std::min(cchRead, paste.size() - pos));
+            engine->FlushBatchedInput();
+        }
+
+        const auto delta = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - now).count();
+        Log::Comment(NoThrowString().Format(L"%s: %zu chars took %lld ms, %zu writes of %zu events",
+                                            batch ? L"Batched" : L"Unbatched",
+                                            paste.size(),
+                                            delta,
+                                            writes,
+                                            events));
+    }
+}
+
+void InputEngineTest::KeyTranslationThroughput()
+{
+    BEGIN_TEST_METHOD_PROPERTIES()
+        TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+    END_TEST_METHOD_PROPERTIES()
+
+    // Every key that has a VT sequence, under every combination of shift, alt and ctrl.
+    const WORD vkeys[] = { VK_UP, VK_DOWN, VK_RIGHT, VK_LEFT, VK_HOME, VK_END,
+                           VK_INSERT, VK_DELETE, VK_PRIOR, VK_NEXT, VK_BACK, VK_TAB, VK_ESCAPE,
+                           VK_F1, VK_F2, VK_F3, VK_F4, VK_F5, VK_F6, VK_F7, VK_F8, VK_F9, VK_F10, VK_F11, VK_F12 };
+    const DWORD modifiers[] = { 0, SHIFT_PRESSED, LEFT_ALT_PRESSED, SHIFT_PRESSED | LEFT_ALT_PRESSED,
+                                LEFT_CTRL_PRESSED, SHIFT_PRESSED | LEFT_CTRL_PRESSED,
+                                LEFT_ALT_PRESSED | RIGHT_CTRL_PRESSED, SHIFT_PRESSED | LEFT_ALT_PRESSED | RIGHT_CTRL_PRESSED };
+    std::vector<KeyEvent> keys;
+    for (const auto modifier : modifiers)
+    {
+        for (const auto vkey : vkeys)
+        {
+            keys.emplace_back(true, 1ui16, vkey, 0ui16, UNICODE_NULL, modifier);
+        }
+    }
+
+    const size_t iterations = 20000;
+    std::wstring sequences;
+    TerminalInput terminalInput{ [&](std::deque<std::unique_ptr<IInputEvent>>& inEvents) {
+        for (const auto& inEvent : inEvents)
+        {
+            sequences.push_back(static_cast<const KeyEvent* const>(inEvent.get())->GetCharData());
+        }
+    } };
+
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        sequences.clear();
+        for (const auto& key : keys)
+        {
+            terminalInput.HandleKey(&key);
+        }
+    }
+    auto delta = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - now).count();
+    Log::Comment(NoThrowString().Format(L"TerminalInput: %zu keys took %lld ms",
+                                        keys.size() * iterations,
+                                        delta));
+
+    TestState testState;
+    size_t events = 0;
+    auto pfn = [&](std::deque<std::unique_ptr<IInputEvent>>& inEvents) {
+        events += inEvents.size();
+    };
+    auto inputEngine = std::make_unique<InputStateMachineEngine>(new TestInteractDispatch(pfn, &testState));
+    auto stateMachine = std::make_unique<StateMachine>(inputEngine.release());
+
+    now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        stateMachine->ProcessString(sequences.data(), sequences.size());
+    }
+    delta = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - now).count();
+    Log::Comment(NoThrowString().Format(L"InputStateMachineEngine: %zu chars of sequences took %lld ms, %zu events",
+                                        sequences.size() * iterations,
+                                        delta,
+                                        events));
+}
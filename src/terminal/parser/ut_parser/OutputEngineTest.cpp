@@ -10,7 +10,10 @@
 
 #include "ascii.hpp"
 
+#include <chrono>
+
 using namespace Microsoft::Console::VirtualTerminal;
+using namespace Microsoft::Console::Types;
 
 using namespace WEX::Common;
 using namespace WEX::Logging;
@@ -544,8 +547,72 @@ class Microsoft::Console::VirtualTerminal::OutputEngineTest final
         mach.ProcessCharacter(L'J');
         VERIFY_ARE_EQUAL(mach._state, StateMachine::VTStates::Ground);
     }
+
+    TEST_METHOD(TestMetrics)
+    {
+        StateMachine mach(new OutputStateMachineEngine(new DummyDispatch));
+        const std::wstring output = L"hello\x1b[31mworld\r\n\x1b]0;title\x07\x1b" L"7";
+
+        const auto before = Metrics::TakeSnapshot();
+        mach.ProcessString(output);
+        const auto delta = Metrics::TakeSnapshot().Since(before);
+
+        VERIFY_ARE_EQUAL(output.size(), delta.Get(Metrics::Counter::CharactersParsed));
+        VERIFY_ARE_EQUAL(2u, delta.Get(Metrics::Counter::PrintRuns));
+        VERIFY_ARE_EQUAL(2u, delta.Get(Metrics::Counter::ControlsExecuted));
+        VERIFY_ARE_EQUAL(1u, delta.Get(Metrics::Counter::CsiDispatched));
+        VERIFY_ARE_EQUAL(1u, delta.Get(Metrics::Counter::OscDispatched));
+        VERIFY_ARE_EQUAL(1u, delta.Get(Metrics::Counter::EscDispatched));
+        VERIFY_ARE_EQUAL(0u, delta.Get(Metrics::Counter::Ss3Dispatched));
+    }
+
+    BEGIN_TEST_METHOD(ParserThroughputMetricsPerf)
+        TEST_METHOD_PROPERTY(L"IsPerfTest", L"true")
+    END_TEST_METHOD()
 };
 
+// Parses colored build-log style output with metrics recording off and on.
+// Recording has to cost less than 1% of the parser's throughput.
+void OutputEngineTest::ParserThroughputMetricsPerf()
+{
+    std::wstring output;
+    for (int i = 0; output.size() < 16 * 1024 * 1024; ++i)
+    {
+        output += L"\x1b[32m[build]\x1b[m compiling src/file" + std::to_wstring(i) + L".cpp\x1b[1;33m warning\x1b[m: unused variable\r\n";
+    }
+
+    StateMachine mach(new OutputStateMachineEngine(new DummyDispatch));
+    const auto measure = [&]() {
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t offset = 0; offset < output.size(); offset += 64 * 1024)
+        {
+            const auto chunk = std::min<size_t>(64 * 1024, output.size() - offset);
+            mach.ProcessString(output.data() + offset, chunk);
+        }
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    // The fastest of several runs each, alternating, so both see the same machine.
+    long long off = std::numeric_limits<long long>::max();
+    long long on = std::numeric_limits<long long>::max();
+    for (int run = 0; run < 7; ++run)
+    {
+        Metrics::SetEnabled(false);
+        off = std::min(off, measure());
+        Metrics::SetEnabled(true);
+        on = std::min(on, measure());
+    }
+
+    const auto overhead = 100.0 * (on - off) / std::max<long long>(off, 1);
+    Log::Comment(NoThrowString().Format(L"%zu chars: %lld us with metrics off, %lld us on (%.2f%% overhead, %.1f MB/s)",
+                                        output.size(),
+                                        off,
+                                        on,
+                                        overhead,
+                                        static_cast<double>(output.size() * sizeof(wchar_t)) / std::max<long long>(on, 1)));
+    VERIFY_IS_LESS_THAN(overhead, 1.0);
+}
+
 class StatefulDispatch final : public TermDispatch
 {
 public:
@@ -0,0 +1,304 @@
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT license.
+
+#include "precomp.h"
+#include "inc/Metrics.hpp"
+
+using namespace Microsoft::Console::Types;
+using namespace Microsoft::Console::Types::Metrics;
+
+std::atomic<bool> Details::g_enabled{ true };
+
+namespace
+{
+    constexpr std::array<const wchar_t*, s_counterCount> s_counterNames{
+        L"characters_parsed",
+        L"print_runs",
+        L"controls_executed",
+        L"esc_dispatched",
+        L"csi_dispatched",
+        L"osc_dispatched",
+        L"ss3_dispatched",
+        L"cells_written",
+        L"rows_scrolled",
+        L"frames_painted",
+    };
+
+    constexpr std::array<const wchar_t*, s_histogramCount> s_histogramNames{
+        L"paint_us",
+    };
+
+    constexpr uint64_t BucketBound(const size_t bucket) noexcept
+    {
+        return uint64_t{ 1 } << bucket;
+    }
+
+    // Adds the totals of one thread's block to a snapshot.
+    void AddTo(Snapshot& snapshot, const Details::ThreadBlock& block) noexcept
+    {
+        for (size_t i = 0; i < s_counterCount; ++i)
+        {
+            snapshot.counters[i] += block.counters[i].load(std::memory_order_relaxed);
+        }
+
+        for (size_t i = 0; i < s_histogramCount; ++i)
+        {
+            auto& histogram = snapshot.histograms[i];
+            for (size_t bucket = 0; bucket < s_bucketCount; ++bucket)
+            {
+                const auto count = block.buckets[i][bucket].load(std::memory_order_relaxed);
+                histogram.buckets[bucket] += count;
+                histogram.count += count;
+            }
+            histogram.sum += block.sums[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    // Keeps track of the blocks of all threads. The blocks of threads that
+    // exited are added up into one, so their counts aren't lost.
+    class Registry final
+    {
+    public:
+        Registry() noexcept :
+            _retired{}
+        {
+        }
+
+        void Attach(Details::ThreadBlock* const block)
+        {
+            std::lock_guard<std::mutex> lock{ _lock };
+            _blocks.push_back(block);
+        }
+
+        void Detach(Details::ThreadBlock* const block) noexcept
+        {
+            std::lock_guard<std::mutex> lock{ _lock };
+            const auto found = std::find(_blocks.begin(), _blocks.end(), block);
+            if (found != _blocks.end())
+            {
+                _blocks.erase(found);
+
+                for (size_t i = 0; i < s_counterCount; ++i)
+                {
+                    Details::Increase(_retired.counters[i], block->counters[i].load(std::memory_order_relaxed));
+                }
+                for (size_t i = 0; i < s_histogramCount; ++i)
+                {
+                    for (size_t bucket = 0; bucket < s_bucketCount; ++bucket)
+                    {
+                        Details::Increase(_retired.buckets[i][bucket], block->buckets[i][bucket].load(std::memory_order_relaxed));
+                    }
+                    Details::Increase(_retired.sums[i], block->sums[i].load(std::memory_order_relaxed));
+                }
+            }
+        }
+
+        Snapshot TakeSnapshot()
+        {
+            Snapshot snapshot{};
+            std::lock_guard<std::mutex> lock{ _lock };
+            AddTo(snapshot, _retired);
+            for (const auto block : _blocks)
+            {
+                AddTo(snapshot, *block);
+            }
+            return snapshot;
+        }
+
+    private:
+        std::mutex _lock;
+        std::vector<Details::ThreadBlock*> _blocks;
+        Details::ThreadBlock _retired;
+    };
+
+    // Threads can exit after static objects were destroyed, so the registry
+    // never is.
+    Registry& GetRegistry() noexcept
+    {
+        static Registry* const registry = new Registry();
+        return *registry;
+    }
+
+    // A thread's block, which is added to the registry when the thread first
+    // records something and taken out of it when the thread exits.
+    class ThreadRegistration final
+    {
+    public:
+        ThreadRegistration() noexcept :
+            block{},
+            _attached{ false }
+        {
+            try
+            {
+                GetRegistry().Attach(&block);
+                _attached = true;
+            }
+            catch (...)
+            {
+                // The thread still records, but nothing will see it.
+                LOG_CAUGHT_EXCEPTION();
+            }
+        }
+
+        ~ThreadRegistration()
+        {
+            if (_attached)
+            {
+                GetRegistry().Detach(&block);
+            }
+        }
+
+        ThreadRegistration(const ThreadRegistration&) = delete;
+        ThreadRegistration& operator=(const ThreadRegistration&) = delete;
+
+        Details::ThreadBlock block;
+
+    private:
+        bool _attached;
+    };
+}
+
+Details::ThreadBlock& Details::CurrentThread() noexcept
+{
+    thread_local ThreadRegistration registration;
+    return registration.block;
+}
+
+// Routine Description:
+// - Finds the histogram bucket a value goes in.
+size_t Details::BucketOf(const uint64_t value) noexcept
+{
+    size_t bucket = 0;
+    while (bucket < s_bucketCount - 1 && value > BucketBound(bucket))
+    {
+        ++bucket;
+    }
+    return bucket;
+}
+
+// Routine Description:
+// - Starts or stops recording. Recording is on unless it's turned off, and
+//   turning it off keeps what was recorded so far.
+void Metrics::SetEnabled(const bool enabled) noexcept
+{
+    Details::g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+// Routine Description:
+// - Adds up what every thread recorded so far.
+// Return Value:
+// - The totals. Recording goes on while they're added up, so counts that
+//   change together might be off from one another by what was recorded in
+//   the meantime.
+Snapshot Metrics::TakeSnapshot()
+{
+    return GetRegistry().TakeSnapshot();
+}
+
+// Routine Description:
+// - Estimates a percentile of the values in a histogram.
+// Arguments:
+// - fraction - the percentile, from 0 to 1
+// Return Value:
+// - The upper bound of the bucket the percentile falls in, or 0 if the
+//   histogram is empty. The percentile is at most that, and more than half
+//   of it. Values in the last bucket are reported as the bound before it.
+uint64_t HistogramSnapshot::Percentile(const double fraction) const noexcept
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    const auto rank = static_cast<uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * count));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < s_bucketCount; ++bucket)
+    {
+        seen += buckets[bucket];
+        if (seen >= std::max<uint64_t>(rank, 1))
+        {
+            return BucketBound(std::min(bucket, s_bucketCount - 2));
+        }
+    }
+    return BucketBound(s_bucketCount - 2);
+}
+
+uint64_t Snapshot::Get(const Counter counter) const noexcept
+{
+    return counters[static_cast<size_t>(counter)];
+}
+
+const HistogramSnapshot& Snapshot::Get(const Histogram histogram) const noexcept
+{
+    return histograms[static_cast<size_t>(histogram)];
+}
+
+// Routine Description:
+// - Finds what was recorded between an earlier snapshot and this one.
+Snapshot Snapshot::Since(const Snapshot& earlier) const noexcept
+{
+    Snapshot delta{};
+    for (size_t i = 0; i < s_counterCount; ++i)
+    {
+        delta.counters[i] = counters[i] - earlier.counters[i];
+    }
+    for (size_t i = 0; i < s_histogramCount; ++i)
+    {
+        for (size_t bucket = 0; bucket < s_bucketCount; ++bucket)
+        {
+            delta.histograms[i].buckets[bucket] = histograms[i].buckets[bucket] - earlier.histograms[i].buckets[bucket];
+        }
+        delta.histograms[i].count = histograms[i].count - earlier.histograms[i].count;
+        delta.histograms[i].sum = histograms[i].sum - earlier.histograms[i].sum;
+    }
+    return delta;
+}
+
+// Routine Description:
+// - Writes the snapshot out as text, one value per line: every counter by
+//   name, then for every histogram its count, sum and percentiles, and how
+//   many values fell in each bucket that isn't empty, by the bucket's bound.
+//   For example:
+//       csi_dispatched 1024
+//       paint_us count=3 sum=9500 p50=4096 p90=4096 p99=4096
+//       paint_us{le=4096} 3
+// Return Value:
+// - The text
+std::wstring Snapshot::ToString() const
+{
+    std::wstringstream out;
+    for (size_t i = 0; i < s_counterCount; ++i)
+    {
+        out << s_counterNames[i] << L' ' << counters[i] << L'\n';
+    }
+
+    for (size_t i = 0; i < s_histogramCount; ++i)
+    {
+        const auto& histogram = histograms[i];
+        out << s_histogramNames[i]
+            << L" count=" << histogram.count
+            << L" sum=" << histogram.sum
+            << L" p50=" << histogram.Percentile(0.5)
+            << L" p90=" << histogram.Percentile(0.9)
+            << L" p99=" << histogram.Percentile(0.99) << L'\n';
+
+        for (size_t bucket = 0; bucket < s_bucketCount; ++bucket)
+        {
+            if (histogram.buckets[bucket] != 0)
+            {
+                out << s_histogramNames[i] << L"{le=";
+                if (bucket == s_bucketCount - 1)
+                {
+                    out << L"inf";
+                }
+                else
+                {
+                    out << BucketBound(bucket);
+                }
+                out << L"} " << histogram.buckets[bucket] << L'\n';
+            }
+        }
+    }
+
+    return out.str();
+}
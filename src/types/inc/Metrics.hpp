@@ -0,0 +1,193 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- Metrics.hpp
+
+Abstract:
+- Counters and latency histograms for the hot paths of the parser, the text
+  buffer and the renderer, for profiling a session on any platform. Unlike
+  ETW tracing, recording doesn't produce an event; it adds to a total.
+- Every thread records into a block of its own, so recording never contends
+  with another thread: it's a load and a store to memory only that thread
+  writes. Taking a snapshot adds up the blocks of all threads, including the
+  ones that have exited since they were recorded into.
+- Code that records many times in a row, like the parser does for every
+  sequence, can add to a CounterBatch instead and publish it once.
+--*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace Microsoft::Console::Types::Metrics
+{
+    enum class Counter : size_t
+    {
+        CharactersParsed,
+        PrintRuns,
+        ControlsExecuted,
+        EscDispatched,
+        CsiDispatched,
+        OscDispatched,
+        Ss3Dispatched,
+        CellsWritten,
+        RowsScrolled,
+        FramesPainted,
+        Count
+    };
+
+    enum class Histogram : size_t
+    {
+        PaintMicroseconds,
+        Count
+    };
+
+    constexpr size_t s_counterCount = static_cast<size_t>(Counter::Count);
+    constexpr size_t s_histogramCount = static_cast<size_t>(Histogram::Count);
+
+    // Bucket i of a histogram counts the values up to 2^i, except for the
+    // last bucket, which counts every value larger than the bound before it.
+    constexpr size_t s_bucketCount = 24;
+
+    struct HistogramSnapshot
+    {
+        std::array<uint64_t, s_bucketCount> buckets;
+        uint64_t count;
+        uint64_t sum;
+
+        uint64_t Percentile(const double fraction) const noexcept;
+    };
+
+    struct Snapshot
+    {
+        std::array<uint64_t, s_counterCount> counters;
+        std::array<HistogramSnapshot, s_histogramCount> histograms;
+
+        uint64_t Get(const Counter counter) const noexcept;
+        const HistogramSnapshot& Get(const Histogram histogram) const noexcept;
+
+        Snapshot Since(const Snapshot& earlier) const noexcept;
+        std::wstring ToString() const;
+    };
+
+    namespace Details
+    {
+        struct ThreadBlock
+        {
+            std::array<std::atomic<uint64_t>, s_counterCount> counters;
+            std::array<std::array<std::atomic<uint64_t>, s_bucketCount>, s_histogramCount> buckets;
+            std::array<std::atomic<uint64_t>, s_histogramCount> sums;
+        };
+
+        extern std::atomic<bool> g_enabled;
+
+        ThreadBlock& CurrentThread() noexcept;
+        size_t BucketOf(const uint64_t value) noexcept;
+
+        // Only the thread that owns a block writes to it, so this doesn't need
+        // an interlocked add; the atomic keeps snapshots from tearing.
+        inline void Increase(std::atomic<uint64_t>& total, const uint64_t value) noexcept
+        {
+            total.store(total.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+    }
+
+    void SetEnabled(const bool enabled) noexcept;
+
+    inline bool IsEnabled() noexcept
+    {
+        return Details::g_enabled.load(std::memory_order_relaxed);
+    }
+
+    // Routine Description:
+    // - Adds to a counter of the calling thread.
+    inline void Add(const Counter counter, const uint64_t value = 1) noexcept
+    {
+        if (IsEnabled())
+        {
+            Details::Increase(Details::CurrentThread().counters[static_cast<size_t>(counter)], value);
+        }
+    }
+
+    // Routine Description:
+    // - Counts a value in a histogram of the calling thread.
+    inline void Record(const Histogram histogram, const uint64_t value) noexcept
+    {
+        if (IsEnabled())
+        {
+            auto& block = Details::CurrentThread();
+            const auto index = static_cast<size_t>(histogram);
+            Details::Increase(block.buckets[index][Details::BucketOf(value)], 1);
+            Details::Increase(block.sums[index], value);
+        }
+    }
+
+    Snapshot TakeSnapshot();
+
+    // Counts into plain memory, for code that would otherwise add to the same
+    // counters over and over. Nothing is recorded until it's published.
+    class CounterBatch final
+    {
+    public:
+        CounterBatch() noexcept :
+            _counts{}
+        {
+        }
+
+        void Add(const Counter counter, const uint64_t value = 1) noexcept
+        {
+            _counts[static_cast<size_t>(counter)] += value;
+        }
+
+        // Routine Description:
+        // - Adds everything counted since the last time to the calling
+        //   thread's counters, and starts counting from zero again.
+        void Publish() noexcept
+        {
+            for (size_t i = 0; i < s_counterCount; ++i)
+            {
+                if (_counts[i] != 0)
+                {
+                    Metrics::Add(static_cast<Counter>(i), _counts[i]);
+                    _counts[i] = 0;
+                }
+            }
+        }
+
+    private:
+        std::array<uint64_t, s_counterCount> _counts;
+    };
+
+    // Records how many microseconds pass between its construction and its
+    // destruction in a histogram.
+    class ScopedLatency final
+    {
+    public:
+        ScopedLatency(const Histogram histogram) noexcept :
+            _histogram{ histogram },
+            _start{ IsEnabled() ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{} }
+        {
+        }
+
+        ~ScopedLatency()
+        {
+            if (_start != std::chrono::steady_clock::time_point{})
+            {
+                const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _start);
+                Record(_histogram, static_cast<uint64_t>(elapsed.count()));
+            }
+        }
+
+        ScopedLatency(const ScopedLatency&) = delete;
+        ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+    private:
+        const Histogram _histogram;
+        const std::chrono::steady_clock::time_point _start;
+    };
+}
@@ -0,0 +1,195 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- SpscQueue.hpp
+
+Abstract:
+- A bounded queue for handing values from exactly one producer thread to
+  exactly one consumer thread.
+- Pushing and popping are lock-free while the queue is neither full nor
+  empty. Only a side that has to wait for the other one touches the mutex,
+  after spinning briefly, so a busy pipeline never takes a lock.
+--*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Microsoft::Console::Types
+{
+    template<typename T>
+    class SpscQueue final
+    {
+    public:
+        // Routine Description:
+        // - Creates a queue that holds at least the given number of values.
+        //   The capacity is rounded up to a power of two.
+        SpscQueue(const size_t capacity) :
+            _slots(_RoundUp(capacity)),
+            _mask{ _RoundUp(capacity) - 1 },
+            _head{ 0 },
+            _tail{ 0 },
+            _sleepers{ 0 }
+        {
+        }
+
+        SpscQueue(const SpscQueue&) = delete;
+        SpscQueue& operator=(const SpscQueue&) = delete;
+
+        // Routine Description:
+        // - Adds a value to the back of the queue unless it's full. Producer only.
+        // Arguments:
+        // - value - the value to add. It's only moved from if this succeeds.
+        // Return Value:
+        // - true if the value was added.
+        bool TryPush(T& value)
+        {
+            const auto tail = _tail.load(std::memory_order_relaxed);
+            if (tail - _head.load(std::memory_order_acquire) == _slots.size())
+            {
+                return false;
+            }
+
+            _slots[tail & _mask] = std::move(value);
+            _tail.store(tail + 1, std::memory_order_release);
+            _Wake();
+            return true;
+        }
+
+        // Routine Description:
+        // - Removes the value at the front of the queue unless it's empty. Consumer only.
+        // Arguments:
+        // - value - receives the value, if there was one.
+        // Return Value:
+        // - true if a value was removed.
+        bool TryPop(T& value)
+        {
+            const auto head = _head.load(std::memory_order_relaxed);
+            if (head == _tail.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+
+            value = std::move(_slots[head & _mask]);
+            _head.store(head + 1, std::memory_order_release);
+            _Wake();
+            return true;
+        }
+
+        // Routine Description:
+        // - Adds a value to the back of the queue, waiting for the consumer to
+        //   make room if it's full. Producer only.
+        // Return Value:
+        // - true if it had to wait.
+        bool Push(T value)
+        {
+            if (TryPush(value))
+            {
+                return false;
+            }
+
+            do
+            {
+                _Wait([this]() { return Size() < _slots.size(); });
+            } while (!TryPush(value));
+            return true;
+        }
+
+        // Routine Description:
+        // - Removes the value at the front of the queue, waiting for the
+        //   producer to add one if it's empty. Consumer only.
+        // Arguments:
+        // - value - receives the value.
+        // Return Value:
+        // - true if it had to wait.
+        bool Pop(T& value)
+        {
+            if (TryPop(value))
+            {
+                return false;
+            }
+
+            do
+            {
+                _Wait([this]() { return Size() > 0; });
+            } while (!TryPop(value));
+            return true;
+        }
+
+        // Routine Description:
+        // - Returns the number of values in the queue. This is only a snapshot
+        //   when called from a thread that's neither producer nor consumer.
+        size_t Size() const noexcept
+        {
+            return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+        }
+
+        size_t Capacity() const noexcept
+        {
+            return _slots.size();
+        }
+
+    private:
+        static constexpr size_t s_spins = 64;
+
+        std::vector<T> _slots;
+        const size_t _mask;
+
+        // The consumer owns the head and the producer owns the tail. Keep them
+        // apart so that the two threads don't fight over one cache line.
+        alignas(64) std::atomic<size_t> _head;
+        alignas(64) std::atomic<size_t> _tail;
+
+        alignas(64) std::atomic<size_t> _sleepers;
+        std::mutex _mutex;
+        std::condition_variable _condition;
+
+        static size_t _RoundUp(const size_t capacity) noexcept
+        {
+            size_t rounded = 1;
+            while (rounded < capacity)
+            {
+                rounded <<= 1;
+            }
+            return rounded;
+        }
+
+        template<typename Predicate>
+        void _Wait(Predicate ready)
+        {
+            for (size_t i = 0; i < s_spins; ++i)
+            {
+                if (ready())
+                {
+                    return;
+                }
+                std::this_thread::yield();
+            }
+
+            std::unique_lock<std::mutex> lock{ _mutex };
+            _sleepers.fetch_add(1);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            _condition.wait(lock, ready);
+            _sleepers.fetch_sub(1);
+        }
+
+        void _Wake()
+        {
+            // Pairs with the increment in _Wait: either the sleeper sees the
+            // change we just published, or we see the sleeper.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (_sleepers.load(std::memory_order_relaxed) != 0)
+            {
+                std::lock_guard<std::mutex> lock{ _mutex };
+                _condition.notify_all();
+            }
+        }
+    };
+}
@@ -0,0 +1,487 @@
+/*++
+Copyright (c) Microsoft Corporation
+Licensed under the MIT license.
+
+Module Name:
+- Utf8OutputPipeline.hpp
+
+Abstract:
+- Incremental UTF-8 to UTF-16 decoding for byte streams that arrive in
+  arbitrarily sized chunks (such as the output pipe of a pseudoconsole).
+- Utf8StreamDecoder carries partial multi-byte sequences from one chunk to the
+  next, so a codepoint split across two reads is never corrupted.
+- Utf8OutputPipeline pulls bytes from a source into one large reusable buffer,
+  decodes them into one reusable string and hands each batch to a sink.
+- ParallelUtf8OutputPipeline does the same, but reads on the calling thread
+  while decoding and delivering on a thread of its own, so that the source is
+  drained even while the sink is busy. The two pass a fixed set of buffers
+  back and forth through lock-free queues; when the sink falls behind, the
+  reader waits for a buffer to come back, which is counted as backpressure.
+- All of them are deliberately free of any OS dependency so that they can be
+  driven by an in-memory byte source in tests.
+
+--*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "SpscQueue.hpp"
+
+namespace Microsoft::Console::Types
+{
+    class Utf8StreamDecoder final
+    {
+    public:
+        static constexpr wchar_t ReplacementChar = 0xFFFD;
+
+        Utf8StreamDecoder() noexcept :
+            _codepoint{ 0 },
+            _bytesNeeded{ 0 },
+            _bytesSeen{ 0 },
+            _lowerBoundary{ 0x80 },
+            _upperBoundary{ 0xBF }
+        {
+        }
+
+        // Routine Description:
+        // - Decodes the given bytes and appends the UTF-16 result to out.
+        // - A multi-byte sequence that is incomplete at the end of bytes is
+        //   held back and completed by the next call.
+        // - Malformed sequences are replaced with U+FFFD, one per maximal
+        //   invalid subpart (the same policy as MultiByteToWideChar).
+        // Arguments:
+        // - bytes - the next chunk of the UTF-8 stream
+        // - out - receives the decoded text. It is appended to, not cleared.
+        void Decode(const std::string_view bytes, std::wstring& out)
+        {
+            const auto* it = reinterpret_cast<const uint8_t*>(bytes.data());
+            const auto* const end = it + bytes.size();
+
+            while (it < end)
+            {
+                // Fast path: runs of ASCII while no sequence is pending.
+                if (_bytesNeeded == 0)
+                {
+                    const auto* runEnd = it;
+                    while (runEnd < end && *runEnd < 0x80)
+                    {
+                        ++runEnd;
+                    }
+                    out.append(it, runEnd);
+                    it = runEnd;
+                    if (it == end)
+                    {
+                        break;
+                    }
+                }
+
+                const uint8_t byte = *it;
+                if (_bytesNeeded == 0)
+                {
+                    if (byte >= 0xC2 && byte <= 0xDF)
+                    {
+                        _bytesNeeded = 1;
+                        _codepoint = byte & 0x1F;
+                    }
+                    else if (byte >= 0xE0 && byte <= 0xEF)
+                    {
+                        _lowerBoundary = byte == 0xE0 ? 0xA0 : 0x80;
+                        _upperBoundary = byte == 0xED ? 0x9F : 0xBF;
+                        _bytesNeeded = 2;
+                        _codepoint = byte & 0x0F;
+                    }
+                    else if (byte >= 0xF0 && byte <= 0xF4)
+                    {
+                        _lowerBoundary = byte == 0xF0 ? 0x90 : 0x80;
+                        _upperBoundary = byte == 0xF4 ? 0x8F : 0xBF;
+                        _bytesNeeded = 3;
+                        _codepoint = byte & 0x07;
+                    }
+                    else
+                    {
+                        out.push_back(ReplacementChar);
+                    }
+                    ++it;
+                    continue;
+                }
+
+                if (byte < _lowerBoundary || byte > _upperBoundary)
+                {
+                    // The pending sequence is broken. Replace it and
+                    // reprocess this byte as the start of something new.
+                    Reset();
+                    out.push_back(ReplacementChar);
+                    continue;
+                }
+
+                _lowerBoundary = 0x80;
+                _upperBoundary = 0xBF;
+                _codepoint = (_codepoint << 6) | (byte & 0x3F);
+                ++it;
+
+                if (++_bytesSeen == _bytesNeeded)
+                {
+                    _AppendCodepoint(_codepoint, out);
+                    Reset();
+                }
+            }
+        }
+
+        // Routine Description:
+        // - Terminates the stream. A dangling partial sequence is emitted as U+FFFD.
+        // Arguments:
+        // - out - receives the replacement character, if any.
+        void Flush(std::wstring& out)
+        {
+            if (HasPartialSequence())
+            {
+                out.push_back(ReplacementChar);
+            }
+            Reset();
+        }
+
+        bool HasPartialSequence() const noexcept
+        {
+            return _bytesNeeded != 0;
+        }
+
+        void Reset() noexcept
+        {
+            _codepoint = 0;
+            _bytesNeeded = 0;
+            _bytesSeen = 0;
+            _lowerBoundary = 0x80;
+            _upperBoundary = 0xBF;
+        }
+
+    private:
+        char32_t _codepoint;
+        uint8_t _bytesNeeded;
+        uint8_t _bytesSeen;
+        uint8_t _lowerBoundary;
+        uint8_t _upperBoundary;
+
+        static void _AppendCodepoint(const char32_t codepoint, std::wstring& out)
+        {
+            if (codepoint < 0x10000)
+            {
+                out.push_back(static_cast<wchar_t>(codepoint));
+            }
+            else
+            {
+                const char32_t value = codepoint - 0x10000;
+                out.push_back(static_cast<wchar_t>(0xD800 + (value >> 10)));
+                out.push_back(static_cast<wchar_t>(0xDC00 + (value & 0x3FF)));
+            }
+        }
+    };
+
+    class Utf8OutputPipeline final
+    {
+    public:
+        // Reads up to capacity bytes into buffer and stores the count in read.
+        // Returns false once the source is exhausted or broken.
+        using ReadFn = std::function<bool(char* const buffer, const size_t capacity, size_t& read)>;
+
+        // Receives one batch of decoded text. The view is only valid for the
+        // duration of the call.
+        using SinkFn = std::function<void(const std::wstring_view text)>;
+
+        static constexpr size_t DefaultBufferSize = 64 * 1024;
+
+        Utf8OutputPipeline(ReadFn read, SinkFn sink, const size_t bufferSize = DefaultBufferSize) :
+            _read{ std::move(read) },
+            _sink{ std::move(sink) },
+            _bytes(bufferSize == 0 ? DefaultBufferSize : bufferSize),
+            _bytesRead{ 0 },
+            _batchesDelivered{ 0 }
+        {
+            // Every byte decodes to at most one UTF-16 unit (a four byte
+            // sequence becomes a surrogate pair), so this never reallocates.
+            _text.reserve(_bytes.size() + 1);
+        }
+
+        // Routine Description:
+        // - Performs a single read from the source, decodes it and delivers
+        //   the result to the sink as one batch.
+        // Return Value:
+        // - false when the source reported the end of the stream.
+        bool Pump()
+        {
+            size_t read = 0;
+            if (!_read(_bytes.data(), _bytes.size(), read))
+            {
+                return false;
+            }
+
+            if (read > 0)
+            {
+                _bytesRead += read;
+                _text.clear();
+                _decoder.Decode({ _bytes.data(), read }, _text);
+                _Deliver();
+            }
+            return true;
+        }
+
+        // Routine Description:
+        // - Pumps the source until it ends, then flushes any partial sequence.
+        void Run()
+        {
+            while (Pump())
+            {
+            }
+
+            _text.clear();
+            _decoder.Flush(_text);
+            _Deliver();
+        }
+
+        size_t BytesRead() const noexcept
+        {
+            return _bytesRead;
+        }
+
+        size_t BatchesDelivered() const noexcept
+        {
+            return _batchesDelivered;
+        }
+
+    private:
+        ReadFn _read;
+        SinkFn _sink;
+        Utf8StreamDecoder _decoder;
+        std::vector<char> _bytes;
+        std::wstring _text;
+        size_t _bytesRead;
+        size_t _batchesDelivered;
+
+        void _Deliver()
+        {
+            // A read consisting solely of the start of a multi-byte sequence
+            // produces no text; don't bother the sink with an empty batch.
+            if (!_text.empty())
+            {
+                ++_batchesDelivered;
+                _sink(_text);
+            }
+        }
+    };
+
+    class ParallelUtf8OutputPipeline final
+    {
+    public:
+        using ReadFn = Utf8OutputPipeline::ReadFn;
+        using SinkFn = Utf8OutputPipeline::SinkFn;
+
+        static constexpr size_t DefaultBufferCount = 8;
+
+        struct Metrics
+        {
+            size_t bytesRead;
+            size_t batchesDelivered;
+            // Reads that had to wait for the sink to hand a buffer back.
+            // This is how often the sink held up the source.
+            size_t readerWaits;
+            // Batches the sink had to wait for, because it was done with
+            // everything that had been read so far.
+            size_t sinkWaits;
+            // The most batches that were ever read but not yet delivered.
+            size_t maxQueued;
+        };
+
+        ParallelUtf8OutputPipeline(ReadFn read,
+                                   SinkFn sink,
+                                   const size_t bufferSize = Utf8OutputPipeline::DefaultBufferSize,
+                                   const size_t bufferCount = DefaultBufferCount) :
+            _read{ std::move(read) },
+            _sink{ std::move(sink) },
+            _buffers(bufferCount == 0 ? DefaultBufferCount : bufferCount,
+                     std::vector<char>(bufferSize == 0 ? Utf8OutputPipeline::DefaultBufferSize : bufferSize)),
+            _free{ _buffers.size() },
+            _filled{ _buffers.size() + 1 },
+            _bytesRead{ 0 },
+            _batchesDelivered{ 0 },
+            _readerWaits{ 0 },
+            _sinkWaits{ 0 },
+            _maxQueued{ 0 }
+        {
+            for (size_t i = 0; i < _buffers.size(); ++i)
+            {
+                _free.Push(i);
+            }
+            _text.reserve(_buffers.front().size() + 1);
+        }
+
+        // Routine Description:
+        // - Reads from the source on the calling thread until it ends, while
+        //   another thread decodes what was read and delivers it to the sink.
+        //   Batches are delivered in the order they were read, one at a time.
+        // - Returns once everything has been delivered, including the
+        //   replacement for a sequence left dangling at the end of the stream.
+        //   An exception thrown by the source or the sink is rethrown here.
+        void Run()
+        {
+            std::thread sinkThread{ [this]() { _SinkThread(); } };
+
+            std::exception_ptr readFailure;
+            try
+            {
+                _ReadUntilEnd();
+            }
+            catch (...)
+            {
+                readFailure = std::current_exception();
+            }
+
+            _filled.Push({ s_endOfStream, 0 });
+            sinkThread.join();
+
+            if (readFailure)
+            {
+                std::rethrow_exception(readFailure);
+            }
+            if (_sinkFailure)
+            {
+                std::rethrow_exception(_sinkFailure);
+            }
+        }
+
+        // Routine Description:
+        // - Returns how much has gone through the pipeline so far and how
+        //   often either side had to wait for the other. Safe to call from
+        //   any thread while the pipeline is running.
+        Metrics GetMetrics() const noexcept
+        {
+            return { _bytesRead.load(std::memory_order_relaxed),
+                     _batchesDelivered.load(std::memory_order_relaxed),
+                     _readerWaits.load(std::memory_order_relaxed),
+                     _sinkWaits.load(std::memory_order_relaxed),
+                     _maxQueued.load(std::memory_order_relaxed) };
+        }
+
+    private:
+        static constexpr size_t s_endOfStream = SIZE_MAX;
+
+        struct _Batch
+        {
+            size_t buffer;
+            size_t size;
+        };
+
+        ReadFn _read;
+        SinkFn _sink;
+        std::vector<std::vector<char>> _buffers;
+
+        // Buffers travel from the reader to the sink through _filled, and
+        // back through _free once they've been decoded.
+        SpscQueue<size_t> _free;
+        SpscQueue<_Batch> _filled;
+
+        // Only touched by the sink thread.
+        Utf8StreamDecoder _decoder;
+        std::wstring _text;
+        std::exception_ptr _sinkFailure;
+
+        std::atomic<size_t> _bytesRead;
+        std::atomic<size_t> _batchesDelivered;
+        std::atomic<size_t> _readerWaits;
+        std::atomic<size_t> _sinkWaits;
+        std::atomic<size_t> _maxQueued;
+
+        void _ReadUntilEnd()
+        {
+            size_t buffer = 0;
+            bool haveBuffer = false;
+            for (;;)
+            {
+                if (!haveBuffer)
+                {
+                    if (_free.Pop(buffer))
+                    {
+                        _readerWaits.fetch_add(1, std::memory_order_relaxed);
+                    }
+                    haveBuffer = true;
+                }
+
+                auto& bytes = _buffers[buffer];
+                size_t read = 0;
+                if (!_read(bytes.data(), bytes.size(), read))
+                {
+                    return;
+                }
+
+                // An empty read keeps its buffer for the next one.
+                if (read > 0)
+                {
+                    _bytesRead.fetch_add(read, std::memory_order_relaxed);
+                    _filled.Push({ buffer, read });
+                    haveBuffer = false;
+
+                    const auto queued = _filled.Size();
+                    if (queued > _maxQueued.load(std::memory_order_relaxed))
+                    {
+                        _maxQueued.store(queued, std::memory_order_relaxed);
+                    }
+                }
+            }
+        }
+
+        void _SinkThread()
+        {
+            for (;;)
+            {
+                _Batch batch;
+                if (_filled.Pop(batch))
+                {
+                    _sinkWaits.fetch_add(1, std::memory_order_relaxed);
+                }
+                if (batch.buffer == s_endOfStream)
+                {
+                    break;
+                }
+
+                _text.clear();
+                _decoder.Decode({ _buffers[batch.buffer].data(), batch.size }, _text);
+
+                // The text is decoded already, so the reader can refill the
+                // buffer while the sink is busy with it.
+                _free.Push(batch.buffer);
+                _Deliver();
+            }
+
+            _text.clear();
+            _decoder.Flush(_text);
+            _Deliver();
+        }
+
+        void _Deliver() noexcept
+        {
+            // After the sink failed, keep draining so the reader never waits
+            // forever for a buffer, but don't deliver anything else.
+            if (_text.empty() || _sinkFailure)
+            {
+                return;
+            }
+
+            try
+            {
+                _sink(_text);
+                _batchesDelivered.fetch_add(1, std::memory_order_relaxed);
+            }
+            catch (...)
+            {
+                _sinkFailure = std::current_exception();
+            }
+        }
+    };
+}
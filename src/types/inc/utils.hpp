@@ -24,4 +24,6 @@ namespace Microsoft::Console::Utils
     void InitializeCampbellColorTable(gsl::span<COLORREF>& table);
     void Initialize256ColorTable(gsl::span<COLORREF>& table);
     void SetColorTableAlpha(gsl::span<COLORREF>& table, const BYTE newAlpha);
+
+    size_t MeasurePrintableAsciiRun(const std::wstring_view text) noexcept;
 }
@@ -406,3 +406,43 @@ void Utils::SetColorTableAlpha(gsl::span<COLORREF>& table, const BYTE newAlpha)
         WI_UpdateFlagsInMask(color, 0xff000000, shiftedAlpha);
     }
 }
+
+// Routine Description:
+// - Measures the run of printable ASCII (space through tilde) a string starts
+//   with. None of it is processed and all of it is one cell wide, so such a
+//   run can be put into a text buffer as-is.
+// - Four characters are checked at a time, as the lanes of a 64-bit word.
+// Arguments:
+// - text - the string to measure
+// Return Value:
+// - The length of the run.
+size_t Utils::MeasurePrintableAsciiRun(const std::wstring_view text) noexcept
+{
+    static constexpr uint64_t lanes = 0x0001000100010001;
+
+    const auto pwch = text.data();
+    const auto cchMax = text.size();
+
+    size_t cch = 0;
+    for (; cch + 4 <= cchMax; cch += 4)
+    {
+        uint64_t chunk;
+        memcpy(&chunk, pwch + cch, sizeof(chunk));
+
+        // With nothing above 0x7F in any lane, adding 0x60 carries into bit 7
+        // exactly for the lanes >= 0x20 and adding 0x01 exactly for 0x7F.
+        if ((chunk & (0xFF80 * lanes)) != 0 ||
+            ((chunk + 0x60 * lanes) & (0x80 * lanes)) != 0x80 * lanes ||
+            ((chunk + 0x01 * lanes) & (0x80 * lanes)) != 0)
+        {
+            break;
+        }
+    }
+
+    while (cch < cchMax && pwch[cch] >= L' ' && pwch[cch] < 0x7F)
+    {
+        ++cch;
+    }
+
+    return cch;
+}